@@ -90,5 +90,9 @@
 
 #define SO_CNX_ADVICE		53
 
+#define SO_ZEROCOPY		54
+
+#define SO_SPLICE		55
+
 #endif /* _ASM_SOCKET_H */
 
@@ -90,4 +90,8 @@
 
 #define SO_CNX_ADVICE		53
 
+#define SO_ZEROCOPY		54
+
+#define SO_SPLICE		55
+
 #endif /* _ASM_M32R_SOCKET_H */
@@ -108,4 +108,8 @@
 
 #define SO_CNX_ADVICE		53
 
+#define SO_ZEROCOPY		54
+
+#define SO_SPLICE		55
+
 #endif /* _UAPI_ASM_SOCKET_H */
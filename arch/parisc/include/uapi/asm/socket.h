@@ -89,4 +89,8 @@
 
 #define SO_CNX_ADVICE		0x402E
 
+#define SO_ZEROCOPY		0x402F
+
+#define SO_SPLICE		0x4030
+
 #endif /* _UAPI_ASM_SOCKET_H */
@@ -86,6 +86,10 @@
 
 #define SO_CNX_ADVICE		0x0037
 
+#define SO_ZEROCOPY		0x0038
+
+#define SO_SPLICE		0x0039
+
 /* Security levels - as per NRL IPv6 - don't actually do anything */
 #define SO_SECURITY_AUTHENTICATION		0x5001
 #define SO_SECURITY_ENCRYPTION_TRANSPORT	0x5002
@@ -28,6 +28,7 @@
 #include <linux/module.h>
 #include <linux/string.h>
 #include <linux/kernel.h>
+#include <linux/crc32.h>
 #include <crypto/internal/hash.h>
 
 #include <asm/cpufeatures.h>
@@ -254,6 +255,8 @@ MODULE_DEVICE_TABLE(x86cpu, crc32c_cpu_id);
 
 static int __init crc32c_intel_mod_init(void)
 {
+	int err;
+
 	if (!x86_match_cpu(crc32c_cpu_id))
 		return -ENODEV;
 #ifdef CONFIG_X86_64
@@ -264,11 +267,22 @@ static int __init crc32c_intel_mod_init(void)
 		set_pcl_breakeven_point();
 	}
 #endif
-	return crypto_register_shash(&alg);
+	err = crypto_register_shash(&alg);
+	if (err)
+		return err;
+
+	/* Let __crc32c_le() callers use the CRC32 instruction directly;
+	 * unlike the PCLMULQDQ path it needs no FPU state and is safe in
+	 * any context.
+	 */
+	crc32c_register_hw(crc32c_intel_le_hw);
+
+	return 0;
 }
 
 static void __exit crc32c_intel_mod_fini(void)
 {
+	crc32c_unregister_hw(crc32c_intel_le_hw);
 	crypto_unregister_shash(&alg);
 }
 
@@ -201,6 +201,28 @@ For 32-bit we have the following conventions - kernel is built with
 	.byte 0xf1
 	.endm
 
+/*
+ * Fetch this CPU's per-cpu area base (== kernel GS base) without
+ * relying on GS itself, for use in entry paths that cannot trust the
+ * current GS base once user space can write it with WRGSBASE.
+ *
+ * On SMP the CPU number is read from the limit of the vgetcpu GDT
+ * segment, which cpu_init() fills in before FSGSBASE is enabled; on UP
+ * the kernel GS base always points at irq_stack_union.
+ */
+#ifdef CONFIG_SMP
+	.macro GET_PERCPU_BASE reg:req
+	movq	$__PER_CPU_SEG, \reg
+	lsl	\reg, \reg
+	andq	$VGETCPU_CPU_MASK, \reg
+	movq	__per_cpu_offset(, \reg, 8), \reg
+	.endm
+#else
+	.macro GET_PERCPU_BASE reg:req
+	leaq	irq_stack_union(%rip), \reg
+	.endm
+#endif
+
 #endif /* CONFIG_X86_64 */
 
 /*
@@ -43,6 +43,8 @@ void update_vsyscall(struct timekeeper *tk)
 	vdata->mask		= tk->tkr_mono.mask;
 	vdata->mult		= tk->tkr_mono.mult;
 	vdata->shift		= tk->tkr_mono.shift;
+	vdata->raw_mult		= tk->tkr_raw.mult;
+	vdata->raw_shift	= tk->tkr_raw.shift;
 
 	vdata->wall_time_sec		= tk->xtime_sec;
 	vdata->wall_time_snsec		= tk->tkr_mono.xtime_nsec;
@@ -59,6 +61,18 @@ void update_vsyscall(struct timekeeper *tk)
 		vdata->monotonic_time_sec++;
 	}
 
+	/*
+	 * Raw monotonic time shares ->cycle_last and ->mask with the
+	 * monotonic clock; only the conversion factors and base differ.
+	 * tkr_raw.xtime_nsec is always zero, the raw remainder lives in
+	 * raw_time.tv_nsec and is shifted up to match vgetsns_raw().
+	 */
+	vdata->raw_time_sec		= tk->raw_time.tv_sec;
+	vdata->raw_time_snsec		= (u64)tk->raw_time.tv_nsec
+					<< tk->tkr_raw.shift;
+
+	vdata->tai_time_sec		= tk->xtime_sec + tk->tai_offset;
+
 	vdata->wall_time_coarse_sec	= tk->xtime_sec;
 	vdata->wall_time_coarse_nsec	= (long)(tk->tkr_mono.xtime_nsec >>
 						 tk->tkr_mono.shift);
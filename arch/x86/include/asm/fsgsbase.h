@@ -0,0 +1,70 @@
+#ifndef _ASM_X86_FSGSBASE_H
+#define _ASM_X86_FSGSBASE_H 1
+
+#ifndef __ASSEMBLY__
+#ifdef CONFIG_X86_64
+
+#include <asm/processor.h>
+
+/*
+ * Wrappers for the FSGSBASE instructions. Only valid when
+ * X86_FEATURE_FSGSBASE is set and CR4.FSGSBASE is enabled; callers
+ * must check the feature bit themselves.
+ */
+
+static __always_inline unsigned long rdfsbase(void)
+{
+	unsigned long fsbase;
+
+	asm volatile("rdfsbase %0" : "=r" (fsbase) :: "memory");
+
+	return fsbase;
+}
+
+static __always_inline unsigned long rdgsbase(void)
+{
+	unsigned long gsbase;
+
+	asm volatile("rdgsbase %0" : "=r" (gsbase) :: "memory");
+
+	return gsbase;
+}
+
+static __always_inline void wrfsbase(unsigned long fsbase)
+{
+	asm volatile("wrfsbase %0" :: "r" (fsbase) : "memory");
+}
+
+static __always_inline void wrgsbase(unsigned long gsbase)
+{
+	asm volatile("wrgsbase %0" :: "r" (gsbase) : "memory");
+}
+
+/*
+ * Read/write the inactive (user) GS base while in the kernel. The
+ * caller must have interrupts disabled: an NMI inside the SWAPGS
+ * window is handled by paranoid_entry, but an ordinary interrupt
+ * would run with the user GS base active.
+ */
+static inline unsigned long __rdgsbase_inactive(void)
+{
+	unsigned long gsbase;
+
+	native_swapgs();
+	gsbase = rdgsbase();
+	native_swapgs();
+
+	return gsbase;
+}
+
+static inline void __wrgsbase_inactive(unsigned long gsbase)
+{
+	native_swapgs();
+	wrgsbase(gsbase);
+	native_swapgs();
+}
+
+#endif /* CONFIG_X86_64 */
+#endif /* __ASSEMBLY__ */
+
+#endif /* _ASM_X86_FSGSBASE_H */
@@ -207,6 +207,9 @@
 #define __USER_CS			(GDT_ENTRY_DEFAULT_USER_CS*8 + 3)
 #define __PER_CPU_SEG			(GDT_ENTRY_PER_CPU*8 + 3)
 
+/* Bits of the GDT_ENTRY_PER_CPU segment limit holding the CPU number */
+#define VGETCPU_CPU_MASK		0xfff
+
 /* TLS indexes for 64-bit - hardcoded in arch_prctl(): */
 #define FS_TLS				0
 #define GS_TLS				1
@@ -268,6 +268,18 @@ __copy_from_user_inatomic_nocache(void *dst, const void __user *src,
 	return __copy_user_nocache(dst, src, size, 0);
 }
 
+/*
+ * __copy_user_nocache() uses non-temporal stores regardless of which
+ * side is the user pointer, so it serves the to-user direction as well.
+ * No point zeroing the tail of a userspace destination on a fault.
+ */
+static inline int
+__copy_to_user_nocache(void __user *dst, const void *src, unsigned size)
+{
+	might_fault();
+	return __copy_user_nocache((__force void *)dst, src, size, 0);
+}
+
 unsigned long
 copy_user_handle_tail(char *to, char *from, unsigned len);
 
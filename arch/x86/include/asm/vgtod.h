@@ -3,6 +3,7 @@
 
 #include <linux/compiler.h>
 #include <linux/clocksource.h>
+#include <asm/segment.h>
 
 #ifdef BUILD_VDSO32_64
 typedef u64 gtod_long_t;
@@ -21,12 +22,17 @@ struct vsyscall_gtod_data {
 	cycle_t	mask;
 	u32	mult;
 	u32	shift;
+	u32	raw_mult;
+	u32	raw_shift;
 
 	/* open coded 'struct timespec' */
 	u64		wall_time_snsec;
 	gtod_long_t	wall_time_sec;
 	gtod_long_t	monotonic_time_sec;
 	u64		monotonic_time_snsec;
+	gtod_long_t	raw_time_sec;
+	u64		raw_time_snsec;
+	gtod_long_t	tai_time_sec;
 	gtod_long_t	wall_time_coarse_sec;
 	gtod_long_t	wall_time_coarse_nsec;
 	gtod_long_t	monotonic_time_coarse_sec;
@@ -78,7 +84,7 @@ static inline void gtod_write_end(struct vsyscall_gtod_data *s)
 
 #ifdef CONFIG_X86_64
 
-#define VGETCPU_CPU_MASK 0xfff
+/* VGETCPU_CPU_MASK lives in asm/segment.h for use by entry assembly */
 
 static inline unsigned int __getcpu(void)
 {
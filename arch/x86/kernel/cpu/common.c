@@ -303,6 +303,13 @@ static __always_inline void setup_smap(struct cpuinfo_x86 *c)
 	}
 }
 
+static __init int setup_disable_fsgsbase(char *arg)
+{
+	setup_clear_cpu_cap(X86_FEATURE_FSGSBASE);
+	return 1;
+}
+__setup("nofsgsbase", setup_disable_fsgsbase);
+
 /*
  * Protection Keys are not available in 32-bit mode.
  */
@@ -1394,6 +1401,43 @@ static void wait_for_master_cpu(int cpu)
 #endif
 }
 
+#ifdef CONFIG_X86_64
+/*
+ * Fill the GDT_ENTRY_PER_CPU descriptor so that its limit encodes the
+ * CPU and node number. The vdso's vgetcpu reads it with LSL, and the
+ * FSGSBASE-aware paranoid entry path uses it to find the per-cpu area
+ * without trusting the GS base. It therefore has to be valid before
+ * CR4.FSGSBASE is enabled in cpu_init(), which is why it is written
+ * here rather than at vdso setup time.
+ */
+static void setup_getcpu(int cpu)
+{
+	struct desc_struct d = { };
+	unsigned long node = 0;
+
+#ifdef CONFIG_NUMA
+	node = early_cpu_to_node(cpu);
+#endif
+	if (boot_cpu_has(X86_FEATURE_RDTSCP))
+		write_rdtscp_aux((node << 12) | cpu);
+
+	/*
+	 * Store cpu number in limit so that it can be loaded quickly
+	 * in user space in vgetcpu. (12 bits for the CPU and 8 bits
+	 * for the node)
+	 */
+	d.limit0 = cpu | ((node & 0xf) << 12);
+	d.limit = node >> 4;
+	d.type = 5;		/* RO data, expand down, accessed */
+	d.dpl = 3;		/* Visible to user code */
+	d.s = 1;		/* Not a system segment */
+	d.p = 1;		/* Present */
+	d.d = 1;		/* 32-bit */
+
+	write_gdt_entry(get_cpu_gdt_table(cpu), GDT_ENTRY_PER_CPU, &d, DESCTYPE_S);
+}
+#endif
+
 /*
  * cpu_init() initializes state that is per-CPU. Some data is already
  * initialized (naturally) in the bootstrap process, such as the GDT
@@ -1449,6 +1493,10 @@ void cpu_init(void)
 	switch_to_new_gdt(cpu);
 	loadsegment(fs, 0);
 
+	setup_getcpu(cpu);
+	if (boot_cpu_has(X86_FEATURE_FSGSBASE))
+		cr4_set_bits(X86_CR4_FSGSBASE);
+
 	load_current_idt();
 
 	memset(me->thread.tls_array, 0, GDT_ENTRY_TLS_ENTRIES * 8);
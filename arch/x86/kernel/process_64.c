@@ -48,6 +48,7 @@
 #include <asm/syscalls.h>
 #include <asm/debugreg.h>
 #include <asm/switch_to.h>
+#include <asm/fsgsbase.h>
 
 asmlinkage extern void ret_from_fork(void);
 
@@ -168,9 +169,23 @@ int copy_thread_tls(unsigned long clone_flags, unsigned long sp,
 	p->thread.io_bitmap_ptr = NULL;
 
 	savesegment(gs, p->thread.gsindex);
-	p->thread.gs = p->thread.gsindex ? 0 : me->thread.gs;
 	savesegment(fs, p->thread.fsindex);
-	p->thread.fs = p->thread.fsindex ? 0 : me->thread.fs;
+	if (static_cpu_has(X86_FEATURE_FSGSBASE)) {
+		unsigned long flags;
+
+		/*
+		 * The in-register bases are authoritative: user space may
+		 * have changed them with wrfsbase/wrgsbase since the values
+		 * in our thread_struct were last saved.
+		 */
+		p->thread.fs = rdfsbase();
+		local_irq_save(flags);
+		p->thread.gs = __rdgsbase_inactive();
+		local_irq_restore(flags);
+	} else {
+		p->thread.gs = p->thread.gsindex ? 0 : me->thread.gs;
+		p->thread.fs = p->thread.fsindex ? 0 : me->thread.fs;
+	}
 	savesegment(es, p->thread.es);
 	savesegment(ds, p->thread.ds);
 	memset(p->thread.ptrace_bps, 0, sizeof(p->thread.ptrace_bps));
@@ -363,9 +378,36 @@ __switch_to(struct task_struct *prev_p, struct task_struct *next_p)
 	 * base address.
 	 *
 	 * Note: This all depends on arch_prctl being the only way that
-	 * user code can override the segment base.  Once wrfsbase and
-	 * wrgsbase are enabled, most of this code will need to change.
+	 * user code can override the segment base.  With FSGSBASE user
+	 * code writes the bases directly, so the shortcuts below are
+	 * invalid and the live register values have to be saved and
+	 * restored on every switch; that path is taken first.
 	 */
+	if (static_cpu_has(X86_FEATURE_FSGSBASE)) {
+		/*
+		 * Save the in-register bases; thread_struct values may be
+		 * stale if user space used wrfsbase/wrgsbase.
+		 */
+		prev->fs = rdfsbase();
+		prev->gs = __rdgsbase_inactive();
+		prev->fsindex = fsindex;
+		prev->gsindex = gsindex;
+
+		/*
+		 * Writing a selector reloads the base from the descriptor
+		 * table, so the explicit base write must come second.
+		 */
+		if (unlikely(fsindex | next->fsindex))
+			loadsegment(fs, next->fsindex);
+		wrfsbase(next->fs);
+
+		if (unlikely(gsindex | next->gsindex))
+			load_gs_index(next->gsindex);
+		__wrgsbase_inactive(next->gs);
+
+		goto fsgs_done;
+	}
+
 	if (unlikely(fsindex | next->fsindex | prev->fs)) {
 		loadsegment(fs, next->fsindex);
 
@@ -396,6 +438,7 @@ __switch_to(struct task_struct *prev_p, struct task_struct *next_p)
 		wrmsrl(MSR_KERNEL_GS_BASE, next->gs);
 	prev->gsindex = gsindex;
 
+fsgs_done:
 	switch_fpu_finish(next_fpu, fpu_switch);
 
 	/*
@@ -519,7 +562,16 @@ long do_arch_prctl(struct task_struct *task, int code, unsigned long addr)
 			task->thread.gs = addr;
 			if (doit) {
 				load_gs_index(0);
-				ret = wrmsrl_safe(MSR_KERNEL_GS_BASE, addr);
+				if (static_cpu_has(X86_FEATURE_FSGSBASE)) {
+					unsigned long flags;
+
+					local_irq_save(flags);
+					__wrgsbase_inactive(addr);
+					local_irq_restore(flags);
+				} else {
+					ret = wrmsrl_safe(MSR_KERNEL_GS_BASE,
+							  addr);
+				}
 			}
 		}
 		put_cpu();
@@ -547,7 +599,10 @@ long do_arch_prctl(struct task_struct *task, int code, unsigned long addr)
 				/* set the selector to 0 to not confuse
 				   __switch_to */
 				loadsegment(fs, 0);
-				ret = wrmsrl_safe(MSR_FS_BASE, addr);
+				if (static_cpu_has(X86_FEATURE_FSGSBASE))
+					wrfsbase(addr);
+				else
+					ret = wrmsrl_safe(MSR_FS_BASE, addr);
 			}
 		}
 		put_cpu();
@@ -556,6 +611,8 @@ long do_arch_prctl(struct task_struct *task, int code, unsigned long addr)
 		unsigned long base;
 		if (task->thread.fsindex == FS_TLS_SEL)
 			base = read_32bit_tls(task, FS_TLS);
+		else if (doit && static_cpu_has(X86_FEATURE_FSGSBASE))
+			base = rdfsbase();
 		else if (doit)
 			rdmsrl(MSR_FS_BASE, base);
 		else
@@ -568,7 +625,13 @@ long do_arch_prctl(struct task_struct *task, int code, unsigned long addr)
 		unsigned gsindex;
 		if (task->thread.gsindex == GS_TLS_SEL)
 			base = read_32bit_tls(task, GS_TLS);
-		else if (doit) {
+		else if (doit && static_cpu_has(X86_FEATURE_FSGSBASE)) {
+			unsigned long flags;
+
+			local_irq_save(flags);
+			base = __rdgsbase_inactive();
+			local_irq_restore(flags);
+		} else if (doit) {
 			savesegment(gs, gsindex);
 			if (gsindex)
 				rdmsrl(MSR_KERNEL_GS_BASE, base);
@@ -454,6 +454,12 @@ static void __init xen_init_cpuid_mask(void)
 		cpuid_leaf1_ecx_mask &= ~xsave_mask; /* disable XSAVE & OSXSAVE */
 	if (xen_check_mwait())
 		cpuid_leaf1_ecx_set_mask = (1 << (X86_FEATURE_MWAIT % 32));
+
+	/*
+	 * PV guests cannot set CR4.FSGSBASE, so keep the kernel from
+	 * trying to use the instructions.
+	 */
+	setup_clear_cpu_cap(X86_FEATURE_FSGSBASE);
 }
 
 static void xen_set_debugreg(int reg, unsigned long val)
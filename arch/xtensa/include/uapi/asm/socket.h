@@ -101,4 +101,8 @@
 
 #define SO_CNX_ADVICE		53
 
+#define SO_ZEROCOPY		54
+
+#define SO_SPLICE		55
+
 #endif	/* _XTENSA_SOCKET_H */
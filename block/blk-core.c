@@ -710,6 +710,7 @@ struct request_queue *blk_alloc_queue_node(gfp_t gfp_mask, int node_id)
 	q->backing_dev_info.capabilities = BDI_CAP_CGROUP_WRITEBACK;
 	q->backing_dev_info.name = "block";
 	q->node = node_id;
+	q->poll_delay = -1;
 
 	err = bdi_init(&q->backing_dev_info);
 	if (err)
@@ -1704,6 +1705,7 @@ void init_request_from_bio(struct request *req, struct bio *bio)
 	req->errors = 0;
 	req->__sector = bio->bi_iter.bi_sector;
 	req->ioprio = bio_prio(bio);
+	req->write_hint = bio->bi_write_hint;
 	blk_rq_bio_prep(req->q, req, bio);
 }
 
@@ -3069,6 +3071,7 @@ static void __blk_rq_prep_clone(struct request *dst, struct request *src)
 	dst->__data_len = blk_rq_bytes(src);
 	dst->nr_phys_segments = src->nr_phys_segments;
 	dst->ioprio = src->ioprio;
+	dst->write_hint = src->write_hint;
 	dst->extra_len = src->extra_len;
 }
 
@@ -3335,9 +3338,51 @@ void blk_finish_plug(struct blk_plug *plug)
 }
 EXPORT_SYMBOL(blk_finish_plug);
 
+/*
+ * Fold a completion time sample into the queue's running mean.  An EWMA
+ * with 1/8 weight for new samples adapts to the device quickly enough
+ * while smoothing over the odd straggler.
+ */
+static void blk_poll_update_mean(struct request_queue *q, u64 delta)
+{
+	u64 mean = q->poll_mean_ns;
+
+	if (!mean)
+		mean = delta;
+	else
+		mean = mean - (mean >> 3) + (delta >> 3);
+
+	q->poll_mean_ns = mean;
+}
+
+/*
+ * Hybrid polling: instead of spinning for the whole I/O, sleep for half
+ * the mean completion time (or a fixed delay) first and only then start
+ * polling.  Oversleeping is self-correcting, since the samples fed to
+ * blk_poll_update_mean() then shrink towards the sleep time.
+ */
+static void blk_poll_hybrid_sleep(struct request_queue *q)
+{
+	u64 sleep_ns;
+	ktime_t kt;
+
+	if (q->poll_delay > 0)
+		sleep_ns = q->poll_delay * NSEC_PER_USEC;
+	else
+		sleep_ns = q->poll_mean_ns >> 1;
+
+	if (!sleep_ns)
+		return;
+
+	kt = ktime_set(0, sleep_ns);
+	set_current_state(TASK_UNINTERRUPTIBLE);
+	schedule_hrtimeout(&kt, HRTIMER_MODE_REL);
+}
+
 bool blk_poll(struct request_queue *q, blk_qc_t cookie)
 {
 	struct blk_plug *plug;
+	u64 poll_start = 0;
 	long state;
 
 	if (!q->mq_ops || !q->mq_ops->poll || !blk_qc_t_valid(cookie) ||
@@ -3349,6 +3394,16 @@ bool blk_poll(struct request_queue *q, blk_qc_t cookie)
 		blk_flush_plug_list(plug, false);
 
 	state = current->state;
+	if (q->poll_delay >= 0) {
+		poll_start = ktime_get_ns();
+		blk_poll_hybrid_sleep(q);
+		/*
+		 * The sleep left us runnable; go back to the caller's
+		 * state so the loop below spins on as if it never slept.
+		 */
+		set_current_state(state);
+	}
+
 	while (!need_resched()) {
 		unsigned int queue_num = blk_qc_t_to_queue_num(cookie);
 		struct blk_mq_hw_ctx *hctx = q->queue_hw_ctx[queue_num];
@@ -3360,6 +3415,9 @@ bool blk_poll(struct request_queue *q, blk_qc_t cookie)
 		if (ret > 0) {
 			hctx->poll_success++;
 			set_current_state(TASK_RUNNING);
+			if (poll_start)
+				blk_poll_update_mean(q,
+					ktime_get_ns() - poll_start);
 			return true;
 		}
 
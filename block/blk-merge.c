@@ -82,6 +82,54 @@ static inline unsigned get_max_io_size(struct request_queue *q,
 	return sectors;
 }
 
+/*
+ * Longest segment the queue accepts starting at @offset into the
+ * physically contiguous range backed by @page.
+ */
+static inline unsigned get_max_segment_size(struct request_queue *q,
+					    struct page *page,
+					    unsigned offset)
+{
+	unsigned long mask = queue_segment_boundary(q);
+	unsigned long addr = page_to_phys(page) + offset;
+
+	/* default segment boundary mask means no boundary limit */
+	if (mask == BLK_SEG_BOUNDARY_MASK)
+		return queue_max_segment_size(q);
+
+	return min_t(unsigned long, mask - (addr & mask) + 1,
+		     queue_max_segment_size(q));
+}
+
+/*
+ * Account a multi-page bvec as the segments the queue can actually
+ * take.  Returns true if the segment limit was hit before the whole
+ * bvec was consumed, i.e. the bio must be split in the middle of it.
+ */
+static bool bvec_split_segs(struct request_queue *q, struct bio_vec *bv,
+			    unsigned *nsegs, unsigned *sectors,
+			    unsigned max_segs)
+{
+	unsigned len = bv->bv_len;
+	unsigned total_len = 0;
+	unsigned new_nsegs = 0, seg_size = 0;
+
+	while (len && new_nsegs + *nsegs < max_segs) {
+		seg_size = get_max_segment_size(q, bv->bv_page,
+						bv->bv_offset + total_len);
+		seg_size = min(seg_size, len);
+
+		new_nsegs++;
+		total_len += seg_size;
+		len -= seg_size;
+	}
+
+	*nsegs += new_nsegs;
+	*sectors += total_len >> 9;
+
+	return !!len;
+}
+
 static struct bio *blk_bio_segment_split(struct request_queue *q,
 					 struct bio *bio,
 					 struct bio_set *bs,
@@ -91,11 +139,11 @@ static struct bio *blk_bio_segment_split(struct request_queue *q,
 	struct bvec_iter iter;
 	unsigned seg_size = 0, nsegs = 0, sectors = 0;
 	unsigned front_seg_size = bio->bi_seg_front_size;
-	bool do_split = true;
+	bool do_split = true, first;
 	struct bio *new = NULL;
 	const unsigned max_sectors = get_max_io_size(q, bio);
 
-	bio_for_each_segment(bv, bio, iter) {
+	bio_for_each_bvec(bv, bio, iter) {
 		/*
 		 * If the queue doesn't support SG gaps and adding this
 		 * offset would create a gap, disallow it.
@@ -110,8 +158,10 @@ static struct bio *blk_bio_segment_split(struct request_queue *q,
 			 */
 			if (nsegs < queue_max_segments(q) &&
 			    sectors < max_sectors) {
-				nsegs++;
-				sectors = max_sectors;
+				/* split in the middle of the bvec */
+				bv.bv_len = (max_sectors - sectors) << 9;
+				bvec_split_segs(q, &bv, &nsegs, &sectors,
+						queue_max_segments(q));
 			}
 			if (sectors)
 				goto split;
@@ -139,13 +189,25 @@ new_segment:
 		if (nsegs == queue_max_segments(q))
 			goto split;
 
-		nsegs++;
+		first = !nsegs;
 		bvprv = bv;
 		bvprvp = &bvprv;
-		seg_size = bv.bv_len;
-		sectors += bv.bv_len >> 9;
 
-		if (nsegs == 1 && seg_size > front_seg_size)
+		if (bv.bv_offset + bv.bv_len <= PAGE_SIZE) {
+			nsegs++;
+			sectors += bv.bv_len >> 9;
+		} else if (bvec_split_segs(q, &bv, &nsegs, &sectors,
+					   queue_max_segments(q))) {
+			goto split;
+		}
+
+		/*
+		 * For a multi-page bvec this overstates the segment
+		 * size, which only makes request merging more
+		 * conservative, never produces an oversized segment.
+		 */
+		seg_size = bv.bv_len;
+		if (first && seg_size > front_seg_size)
 			front_seg_size = seg_size;
 	}
 
@@ -224,7 +286,7 @@ static unsigned int __blk_recalc_rq_segments(struct request_queue *q,
 	seg_size = 0;
 	nr_phys_segs = 0;
 	for_each_bio(bio) {
-		bio_for_each_segment(bv, bio, iter) {
+		bio_for_each_bvec(bv, bio, iter) {
 			/*
 			 * If SG merging is disabled, each bio vector is
 			 * a segment
@@ -250,7 +312,14 @@ new_segment:
 			    fbio->bi_seg_front_size)
 				fbio->bi_seg_front_size = seg_size;
 
-			nr_phys_segs++;
+			if (bv.bv_offset + bv.bv_len <= PAGE_SIZE) {
+				nr_phys_segs++;
+			} else {
+				unsigned sectors = 0;
+
+				bvec_split_segs(q, &bv, &nr_phys_segs,
+						&sectors, UINT_MAX);
+			}
 			bvprv = bv;
 			prev = 1;
 			seg_size = bv.bv_len;
@@ -331,6 +400,53 @@ static int blk_phys_contig_segment(struct request_queue *q, struct bio *bio,
 	return 0;
 }
 
+static inline struct scatterlist *blk_next_sg(struct scatterlist **sg,
+					      struct scatterlist *sglist)
+{
+	if (!*sg)
+		return sglist;
+
+	/*
+	 * If the driver previously mapped a shorter list, we could see a
+	 * termination bit prematurely unless it fully inits the sg table
+	 * on each mapping. We KNOW that there must be more entries here
+	 * or the driver would be buggy, so force clear the termination
+	 * bit to avoid doing a full sg_init_table() in drivers for each
+	 * command.
+	 */
+	sg_unmark_end(*sg);
+	return sg_next(*sg);
+}
+
+/*
+ * Map a multi-page bvec, honouring the queue's segment size and
+ * boundary limits.  Returns the number of sg entries used.
+ */
+static unsigned blk_bvec_map_sg(struct request_queue *q,
+				struct bio_vec *bvec,
+				struct scatterlist *sglist,
+				struct scatterlist **sg)
+{
+	unsigned nbytes = bvec->bv_len;
+	unsigned nsegs = 0, total = 0;
+
+	while (nbytes > 0) {
+		unsigned offset = bvec->bv_offset + total;
+		unsigned len = min(get_max_segment_size(q, bvec->bv_page,
+							offset), nbytes);
+
+		*sg = blk_next_sg(sg, sglist);
+		sg_set_page(*sg, nth_page(bvec->bv_page, offset / PAGE_SIZE),
+			    len, offset % PAGE_SIZE);
+
+		total += len;
+		nbytes -= len;
+		nsegs++;
+	}
+
+	return nsegs;
+}
+
 static inline void
 __blk_segment_map_sg(struct request_queue *q, struct bio_vec *bvec,
 		     struct scatterlist *sglist, struct bio_vec *bvprv,
@@ -351,25 +467,14 @@ __blk_segment_map_sg(struct request_queue *q, struct bio_vec *bvec,
 		(*sg)->length += nbytes;
 	} else {
 new_segment:
-		if (!*sg)
-			*sg = sglist;
-		else {
-			/*
-			 * If the driver previously mapped a shorter
-			 * list, we could see a termination bit
-			 * prematurely unless it fully inits the sg
-			 * table on each mapping. We KNOW that there
-			 * must be more entries here or the driver
-			 * would be buggy, so force clear the
-			 * termination bit to avoid doing a full
-			 * sg_init_table() in drivers for each command.
-			 */
-			sg_unmark_end(*sg);
-			*sg = sg_next(*sg);
+		if (bvec->bv_offset + bvec->bv_len <= PAGE_SIZE) {
+			*sg = blk_next_sg(sg, sglist);
+			sg_set_page(*sg, bvec->bv_page, nbytes,
+				    bvec->bv_offset);
+			(*nsegs)++;
+		} else {
+			(*nsegs) += blk_bvec_map_sg(q, bvec, sglist, sg);
 		}
-
-		sg_set_page(*sg, bvec->bv_page, nbytes, bvec->bv_offset);
-		(*nsegs)++;
 	}
 	*bvprv = *bvec;
 }
@@ -409,7 +514,7 @@ single_segment:
 	}
 
 	for_each_bio(bio)
-		bio_for_each_segment(bvec, bio, iter)
+		bio_for_each_bvec(bvec, bio, iter)
 			__blk_segment_map_sg(q, &bvec, sglist, &bvprv, sg,
 					     &nsegs, &cluster);
 
@@ -667,6 +772,13 @@ static int attempt_merge(struct request_queue *q, struct request *req,
 	    !blk_write_same_mergeable(req->bio, next->bio))
 		return 0;
 
+	/*
+	 * Don't allow merge of different write hints, or for a hint with
+	 * non-hint IO.
+	 */
+	if (req->write_hint != next->write_hint)
+		return 0;
+
 	/*
 	 * If we are allowed to merge, then append bio list
 	 * from next to rq and release next. merge_requests_fn
@@ -771,6 +883,13 @@ bool blk_rq_merge_ok(struct request *rq, struct bio *bio)
 	    !blk_write_same_mergeable(rq->bio, bio))
 		return false;
 
+	/*
+	 * Don't allow merge of different write hints, or for a hint with
+	 * non-hint IO.
+	 */
+	if (rq->write_hint != bio->bi_write_hint)
+		return false;
+
 	return true;
 }
 
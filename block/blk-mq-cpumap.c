@@ -9,6 +9,7 @@
 #include <linux/mm.h>
 #include <linux/smp.h>
 #include <linux/cpu.h>
+#include <linux/topology.h>
 
 #include <linux/blk-mq.h>
 #include "blk.h"
@@ -31,6 +32,66 @@ static int get_first_sibling(unsigned int cpu)
 	return cpu;
 }
 
+/*
+ * Spread the queues over NUMA nodes proportionally to their online CPU
+ * count, so that every queue is served by CPUs from a single node where
+ * possible.  Combined with interrupt affinity following the resulting
+ * hctx cpumasks, submissions then complete on the submitting socket.
+ */
+static void blk_mq_update_queue_map_numa(unsigned int *map,
+					 unsigned int nr_queues,
+					 const struct cpumask *online_mask,
+					 unsigned int nr_cpus)
+{
+	unsigned int node, cpu, ncpus, nqueues, count;
+	unsigned int queue = 0;
+	unsigned int rem_queues = nr_queues;
+	unsigned int rem_cpus = nr_cpus;
+
+	/* offline CPUs fall back to the first queue, as elsewhere */
+	for_each_possible_cpu(cpu)
+		if (!cpumask_test_cpu(cpu, online_mask))
+			map[cpu] = 0;
+
+	for_each_node(node) {
+		const struct cpumask *node_mask = cpumask_of_node(node);
+
+		ncpus = 0;
+		for_each_cpu(cpu, node_mask)
+			if (cpumask_test_cpu(cpu, online_mask))
+				ncpus++;
+		if (!ncpus)
+			continue;
+
+		/*
+		 * The node's proportional share of what is left, at
+		 * least one queue.  If more nodes than queues remain,
+		 * the last queue is shared by the leftover nodes.
+		 */
+		nqueues = max(1U, rem_queues * ncpus / rem_cpus);
+		nqueues = min(nqueues, rem_queues);
+
+		if (!nqueues) {
+			for_each_cpu(cpu, node_mask)
+				if (cpumask_test_cpu(cpu, online_mask))
+					map[cpu] = nr_queues - 1;
+			continue;
+		}
+
+		count = 0;
+		for_each_cpu(cpu, node_mask) {
+			if (!cpumask_test_cpu(cpu, online_mask))
+				continue;
+			map[cpu] = queue + count * nqueues / ncpus;
+			count++;
+		}
+
+		queue += nqueues;
+		rem_queues -= nqueues;
+		rem_cpus -= ncpus;
+	}
+}
+
 int blk_mq_update_queue_map(unsigned int *map, unsigned int nr_queues,
 			    const struct cpumask *online_mask)
 {
@@ -50,6 +111,19 @@ int blk_mq_update_queue_map(unsigned int *map, unsigned int nr_queues,
 		cpumask_set_cpu(i, cpus);
 	}
 
+	/*
+	 * With fewer queues than CPUs on a multi-node system, the
+	 * index-based spreading below happily assigns one queue CPUs
+	 * from different sockets.  Carve the queues up along node
+	 * boundaries instead.
+	 */
+	if (nr_queues < nr_cpus && nr_online_nodes > 1) {
+		blk_mq_update_queue_map_numa(map, nr_queues, online_mask,
+					     nr_cpus);
+		free_cpumask_var(cpus);
+		return 0;
+	}
+
 	queue = 0;
 	for_each_possible_cpu(i) {
 		if (!cpumask_test_cpu(i, online_mask)) {
@@ -0,0 +1,35 @@
+#ifndef BLK_MQ_SCHED_H
+#define BLK_MQ_SCHED_H
+
+struct blk_mq_hw_ctx;
+struct request;
+struct request_queue;
+
+/*
+ * Per-hardware-queue scheduling hooks for blk-mq.  A scheduler sits
+ * between the per-cpu software queues and the driver: requests pulled
+ * off the software queues are handed to ->insert(), and the dispatch
+ * loop asks ->dispatch() for the next request to issue whenever it has
+ * nothing left from the hctx dispatch list.
+ *
+ * All hooks are invoked from queue-run context with no locks held; a
+ * scheduler must do its own serialization, since a hardware queue can
+ * be run from more than one CPU.
+ */
+struct blk_mq_sched_ops {
+	const char *name;
+	int (*init_hctx)(struct blk_mq_hw_ctx *hctx);
+	void (*exit_hctx)(struct blk_mq_hw_ctx *hctx);
+	void (*insert)(struct blk_mq_hw_ctx *hctx, struct request *rq);
+	struct request *(*dispatch)(struct blk_mq_hw_ctx *hctx);
+	bool (*has_work)(struct blk_mq_hw_ctx *hctx);
+};
+
+#ifdef CONFIG_MQ_IOSCHED_DEADLINE
+extern const struct blk_mq_sched_ops mq_deadline_sched_ops;
+#endif
+
+int blk_mq_sched_switch(struct request_queue *q,
+			const struct blk_mq_sched_ops *ops);
+
+#endif
@@ -229,6 +229,34 @@ static ssize_t blk_mq_hw_sysfs_active_show(struct blk_mq_hw_ctx *hctx, char *pag
 	return sprintf(page, "%u\n", atomic_read(&hctx->nr_active));
 }
 
+static ssize_t blk_mq_hw_sysfs_lat_hist_show(struct blk_mq_hw_ctx *hctx,
+					     char *page)
+{
+	static const char * const cls_name[BLK_MQ_LAT_NR] = {
+		"read", "write", "flush"
+	};
+	char *start_page = page;
+	int cls, bucket;
+
+	/* one line per class, one cumulative count per log2 usec bucket */
+	for (cls = 0; cls < BLK_MQ_LAT_NR; cls++) {
+		page += sprintf(page, "%s:", cls_name[cls]);
+		for (bucket = 0; bucket < BLK_MQ_LAT_BUCKETS; bucket++)
+			page += sprintf(page, " %llu",
+					hctx->lat_hist[cls][bucket]);
+		page += sprintf(page, "\n");
+	}
+
+	return page - start_page;
+}
+
+static ssize_t blk_mq_hw_sysfs_inflight_show(struct blk_mq_hw_ctx *hctx,
+					     char *page)
+{
+	return sprintf(page, "%d %u\n", atomic_read(&hctx->stat_inflight),
+		       hctx->stat_inflight_hwm);
+}
+
 static ssize_t blk_mq_hw_sysfs_cpus_show(struct blk_mq_hw_ctx *hctx, char *page)
 {
 	unsigned int i, first = 1;
@@ -304,6 +332,14 @@ static struct blk_mq_hw_ctx_sysfs_entry blk_mq_hw_sysfs_poll = {
 	.attr = {.name = "io_poll", .mode = S_IRUGO },
 	.show = blk_mq_hw_sysfs_poll_show,
 };
+static struct blk_mq_hw_ctx_sysfs_entry blk_mq_hw_sysfs_lat_hist = {
+	.attr = {.name = "latency_hist", .mode = S_IRUGO },
+	.show = blk_mq_hw_sysfs_lat_hist_show,
+};
+static struct blk_mq_hw_ctx_sysfs_entry blk_mq_hw_sysfs_inflight = {
+	.attr = {.name = "inflight", .mode = S_IRUGO },
+	.show = blk_mq_hw_sysfs_inflight_show,
+};
 
 static struct attribute *default_hw_ctx_attrs[] = {
 	&blk_mq_hw_sysfs_queued.attr,
@@ -314,6 +350,8 @@ static struct attribute *default_hw_ctx_attrs[] = {
 	&blk_mq_hw_sysfs_cpus.attr,
 	&blk_mq_hw_sysfs_active.attr,
 	&blk_mq_hw_sysfs_poll.attr,
+	&blk_mq_hw_sysfs_lat_hist.attr,
+	&blk_mq_hw_sysfs_inflight.attr,
 	NULL,
 };
 
@@ -84,8 +84,9 @@ void blk_mq_tag_wakeup_all(struct blk_mq_tags *tags, bool include_reserve)
 	for (i = 0; i < BT_WAIT_QUEUES; i++) {
 		struct bt_wait_state *bs = &bt->bs[wake_index];
 
+		/* waiters are exclusive, a plain wake_up() rouses just one */
 		if (waitqueue_active(&bs->wait))
-			wake_up(&bs->wait);
+			wake_up_all(&bs->wait);
 
 		wake_index = bt_index_inc(wake_index);
 	}
@@ -93,7 +94,7 @@ void blk_mq_tag_wakeup_all(struct blk_mq_tags *tags, bool include_reserve)
 	if (include_reserve) {
 		bt = &tags->breserved_tags;
 		if (waitqueue_active(&bt->bs[0].wait))
-			wake_up(&bt->bs[0].wait);
+			wake_up_all(&bt->bs[0].wait);
 	}
 }
 
@@ -273,7 +274,12 @@ static int bt_get(struct blk_mq_alloc_data *data,
 
 	bs = bt_wait_ptr(bt, hctx);
 	do {
-		prepare_to_wait(&bs->wait, &wait, TASK_UNINTERRUPTIBLE);
+		/*
+		 * Waits are exclusive so that a batch of freed tags wakes
+		 * exactly as many sleepers, see bt_clear_tag().
+		 */
+		prepare_to_wait_exclusive(&bs->wait, &wait,
+					  TASK_UNINTERRUPTIBLE);
 
 		tag = __bt_get(hctx, bt, last_tag, tags);
 		if (tag != -1)
@@ -397,7 +403,11 @@ static void bt_clear_tag(struct blk_mq_bitmap_tags *bt, unsigned int tag)
 	if (wait_cnt == 0) {
 		atomic_add(bt->wake_cnt, &bs->wait_cnt);
 		bt_index_atomic_inc(&bt->wake_index);
-		wake_up(&bs->wait);
+		/*
+		 * One tag was freed per count, so rouse at most wake_cnt
+		 * of the exclusive waiters instead of the whole queue.
+		 */
+		wake_up_nr(&bs->wait, bt->wake_cnt);
 	}
 }
 
@@ -572,7 +582,8 @@ static int bt_alloc(struct blk_mq_bitmap_tags *bt, unsigned int depth,
 		bt->map_nr = nr;
 	}
 
-	bt->bs = kzalloc(BT_WAIT_QUEUES * sizeof(*bt->bs), GFP_KERNEL);
+	bt->bs = kzalloc_node(BT_WAIT_QUEUES * sizeof(*bt->bs), GFP_KERNEL,
+			      node);
 	if (!bt->bs) {
 		kfree(bt->map);
 		bt->map = NULL;
@@ -21,6 +21,7 @@
 #include <linux/cache.h>
 #include <linux/sched/sysctl.h>
 #include <linux/delay.h>
+#include <linux/ktime.h>
 #include <linux/crash_dump.h>
 
 #include <trace/events/block.h>
@@ -29,6 +30,8 @@
 #include "blk.h"
 #include "blk-mq.h"
 #include "blk-mq-tag.h"
+#include "blk-mq-sched.h"
+#include "blk-wbt.h"
 
 static DEFINE_MUTEX(all_q_mutex);
 static LIST_HEAD(all_q_list);
@@ -40,8 +43,12 @@ static void __blk_mq_run_hw_queue(struct blk_mq_hw_ctx *hctx);
  */
 static bool blk_mq_hctx_has_pending(struct blk_mq_hw_ctx *hctx)
 {
+	const struct blk_mq_sched_ops *sched_ops = hctx->sched_ops;
 	unsigned int i;
 
+	if (sched_ops && sched_ops->has_work(hctx))
+		return true;
+
 	for (i = 0; i < hctx->ctx_map.size; i++)
 		if (hctx->ctx_map.map[i].word)
 			return true;
@@ -176,6 +183,7 @@ static void blk_mq_rq_ctx_init(struct request_queue *q, struct blk_mq_ctx *ctx,
 	rq->rq_disk = NULL;
 	rq->part = NULL;
 	rq->start_time = jiffies;
+	rq->issue_ns = 0;
 #ifdef CONFIG_BLK_CGROUP
 	rq->rl = NULL;
 	set_start_time_ns(rq);
@@ -188,6 +196,7 @@ static void blk_mq_rq_ctx_init(struct request_queue *q, struct blk_mq_ctx *ctx,
 	rq->special = NULL;
 	/* tag was already set */
 	rq->errors = 0;
+	rq->write_hint = 0;
 
 	rq->cmd = rq->__cmd;
 
@@ -272,6 +281,8 @@ static void __blk_mq_free_request(struct blk_mq_hw_ctx *hctx,
 	const int tag = rq->tag;
 	struct request_queue *q = rq->q;
 
+	wbt_done(q, rq);
+
 	if (rq->cmd_flags & REQ_MQ_INFLIGHT)
 		atomic_dec(&hctx->nr_active);
 	rq->cmd_flags = 0;
@@ -301,8 +312,42 @@ void blk_mq_free_request(struct request *rq)
 }
 EXPORT_SYMBOL_GPL(blk_mq_free_request);
 
+/*
+ * Bucket the completion latency and drop the in-flight count.  The
+ * histogram increments are deliberately lockless: a dropped sample now
+ * and then is a fair price for not serializing completions.
+ */
+static void blk_mq_stat_done(struct request *rq)
+{
+	struct request_queue *q = rq->q;
+	struct blk_mq_hw_ctx *hctx;
+	u64 lat;
+	int cls, bucket;
+
+	if (!rq->issue_ns)
+		return;
+
+	hctx = q->mq_ops->map_queue(q, rq->mq_ctx->cpu);
+
+	if (rq->cmd_flags & (REQ_FLUSH | REQ_FUA))
+		cls = BLK_MQ_LAT_FLUSH;
+	else if (rq_data_dir(rq) == WRITE)
+		cls = BLK_MQ_LAT_WRITE;
+	else
+		cls = BLK_MQ_LAT_READ;
+
+	/* approximate usecs with a shift, this path is hot */
+	lat = (ktime_get_ns() - rq->issue_ns) >> 10;
+	bucket = lat ? min_t(int, ilog2(lat), BLK_MQ_LAT_BUCKETS - 1) : 0;
+	hctx->lat_hist[cls][bucket]++;
+
+	if (test_bit(REQ_ATOM_STARTED, &rq->atomic_flags))
+		atomic_dec(&hctx->stat_inflight);
+}
+
 inline void __blk_mq_end_request(struct request *rq, int error)
 {
+	blk_mq_stat_done(rq);
 	blk_account_io_done(rq);
 
 	if (rq->end_io) {
@@ -399,6 +444,8 @@ void blk_mq_start_request(struct request *rq)
 
 	trace_block_rq_issue(q, rq);
 
+	rq->issue_ns = ktime_get_ns();
+
 	rq->resid_len = blk_rq_bytes(rq);
 	if (unlikely(blk_bidi_rq(rq)))
 		rq->next_rq->resid_len = blk_rq_bytes(rq->next_rq);
@@ -417,8 +464,17 @@ void blk_mq_start_request(struct request *rq)
 	 * complete. So be sure to clear complete again when we start
 	 * the request, otherwise we'll ignore the completion event.
 	 */
-	if (!test_bit(REQ_ATOM_STARTED, &rq->atomic_flags))
+	if (!test_bit(REQ_ATOM_STARTED, &rq->atomic_flags)) {
+		struct blk_mq_hw_ctx *hctx;
+		unsigned int depth;
+
+		hctx = q->mq_ops->map_queue(q, rq->mq_ctx->cpu);
+		depth = atomic_inc_return(&hctx->stat_inflight);
+		if (depth > hctx->stat_inflight_hwm)
+			hctx->stat_inflight_hwm = depth;
+
 		set_bit(REQ_ATOM_STARTED, &rq->atomic_flags);
+	}
 	if (test_bit(REQ_ATOM_COMPLETE, &rq->atomic_flags))
 		clear_bit(REQ_ATOM_COMPLETE, &rq->atomic_flags);
 
@@ -440,6 +496,8 @@ static void __blk_mq_requeue_request(struct request *rq)
 	trace_block_rq_requeue(q, rq);
 
 	if (test_and_clear_bit(REQ_ATOM_STARTED, &rq->atomic_flags)) {
+		atomic_dec(&q->mq_ops->map_queue(q,
+				rq->mq_ctx->cpu)->stat_inflight);
 		if (q->dma_drain_size && blk_rq_bytes(rq))
 			rq->nr_phys_segments--;
 	}
@@ -718,6 +776,24 @@ static void flush_busy_ctxs(struct blk_mq_hw_ctx *hctx, struct list_head *list)
 	}
 }
 
+/*
+ * Feed filesystem requests that were pulled off the software queues to
+ * the attached scheduler.  Passthrough requests stay on @list so they
+ * are dispatched in arrival order, ahead of any scheduled request.
+ */
+static void blk_mq_sched_insert_list(struct blk_mq_hw_ctx *hctx,
+				     struct list_head *list)
+{
+	struct request *rq, *next;
+
+	list_for_each_entry_safe(rq, next, list, queuelist) {
+		if (rq->cmd_type != REQ_TYPE_FS)
+			continue;
+		list_del_init(&rq->queuelist);
+		hctx->sched_ops->insert(hctx, rq);
+	}
+}
+
 /*
  * Run this hardware queue, pulling any software queues mapped to it in.
  * Note that this function currently has various problems around ordering
@@ -726,6 +802,7 @@ static void flush_busy_ctxs(struct blk_mq_hw_ctx *hctx, struct list_head *list)
  */
 static void __blk_mq_run_hw_queue(struct blk_mq_hw_ctx *hctx)
 {
+	const struct blk_mq_sched_ops *sched_ops = hctx->sched_ops;
 	struct request_queue *q = hctx->queue;
 	struct request *rq;
 	LIST_HEAD(rq_list);
@@ -745,6 +822,14 @@ static void __blk_mq_run_hw_queue(struct blk_mq_hw_ctx *hctx)
 	 */
 	flush_busy_ctxs(hctx, &rq_list);
 
+	/*
+	 * With a scheduler attached, new requests detour through it so
+	 * it can order them; requests previously handed back by the
+	 * driver stay on the dispatch list and go out first.
+	 */
+	if (sched_ops)
+		blk_mq_sched_insert_list(hctx, &rq_list);
+
 	/*
 	 * If we have previous entries on our dispatch list, grab them
 	 * and stuff them at the front for more fair dispatch.
@@ -766,16 +851,25 @@ static void __blk_mq_run_hw_queue(struct blk_mq_hw_ctx *hctx)
 	 * Now process all the entries, sending them to the driver.
 	 */
 	queued = 0;
-	while (!list_empty(&rq_list)) {
+	while (!list_empty(&rq_list) ||
+	       (sched_ops && sched_ops->has_work(hctx))) {
 		struct blk_mq_queue_data bd;
 		int ret;
 
-		rq = list_first_entry(&rq_list, struct request, queuelist);
-		list_del_init(&rq->queuelist);
+		if (!list_empty(&rq_list)) {
+			rq = list_first_entry(&rq_list, struct request,
+					      queuelist);
+			list_del_init(&rq->queuelist);
+		} else {
+			rq = sched_ops->dispatch(hctx);
+			if (!rq)
+				break;
+		}
 
 		bd.rq = rq;
 		bd.list = dptr;
-		bd.last = list_empty(&rq_list);
+		bd.last = list_empty(&rq_list) &&
+			!(sched_ops && sched_ops->has_work(hctx));
 
 		ret = q->mq_ops->queue_rq(hctx, &bd);
 		switch (ret) {
@@ -946,6 +1040,62 @@ void blk_mq_start_stopped_hw_queues(struct request_queue *q, bool async)
 }
 EXPORT_SYMBOL(blk_mq_start_stopped_hw_queues);
 
+/*
+ * Attach @ops to every hardware queue of @q, or detach the current
+ * scheduler when @ops is NULL.  Freezing the queue drains all requests,
+ * including any parked inside the old scheduler, and stopping the
+ * hardware queues keeps queue runs from looking at scheduler state
+ * while it is being swapped.
+ */
+int blk_mq_sched_switch(struct request_queue *q,
+			const struct blk_mq_sched_ops *ops)
+{
+	struct blk_mq_hw_ctx *hctx;
+	int i, ret = 0;
+
+	if (!q->mq_ops)
+		return -EINVAL;
+	if (q->mq_sched == ops)
+		return 0;
+
+	blk_mq_freeze_queue(q);
+	blk_mq_stop_hw_queues(q);
+
+	queue_for_each_hw_ctx(q, hctx, i) {
+		cancel_delayed_work_sync(&hctx->run_work);
+
+		if (hctx->sched_ops) {
+			hctx->sched_ops->exit_hctx(hctx);
+			hctx->sched_ops = NULL;
+		}
+	}
+	q->mq_sched = NULL;
+
+	if (ops) {
+		queue_for_each_hw_ctx(q, hctx, i) {
+			ret = ops->init_hctx(hctx);
+			if (ret)
+				break;
+			hctx->sched_ops = ops;
+		}
+		if (ret) {
+			/* fall back to no scheduler */
+			queue_for_each_hw_ctx(q, hctx, i) {
+				if (!hctx->sched_ops)
+					continue;
+				hctx->sched_ops->exit_hctx(hctx);
+				hctx->sched_ops = NULL;
+			}
+		} else {
+			q->mq_sched = ops;
+		}
+	}
+
+	blk_mq_start_stopped_hw_queues(q, true);
+	blk_mq_unfreeze_queue(q);
+	return ret;
+}
+
 static void blk_mq_run_work_fn(struct work_struct *work)
 {
 	struct blk_mq_hw_ctx *hctx;
@@ -1250,6 +1400,7 @@ static blk_qc_t blk_mq_make_request(struct request_queue *q, struct bio *bio)
 	struct blk_plug *plug;
 	struct request *same_queue_rq = NULL;
 	blk_qc_t cookie;
+	bool wb_acct;
 
 	blk_queue_bounce(q, &bio);
 
@@ -1267,9 +1418,17 @@ static blk_qc_t blk_mq_make_request(struct request_queue *q, struct bio *bio)
 	} else
 		request_count = blk_plug_queued_count(q);
 
+	wb_acct = wbt_wait(q, bio);
+
 	rq = blk_mq_map_request(q, bio, &data);
-	if (unlikely(!rq))
+	if (unlikely(!rq)) {
+		if (wb_acct)
+			wbt_abort(q);
 		return BLK_QC_T_NONE;
+	}
+
+	if (wb_acct)
+		rq->cmd_flags |= REQ_BG_WB;
 
 	cookie = blk_tag_to_qc_t(rq->tag, data.hctx->queue_num);
 
@@ -1346,6 +1505,7 @@ static blk_qc_t blk_sq_make_request(struct request_queue *q, struct bio *bio)
 	struct blk_map_ctx data;
 	struct request *rq;
 	blk_qc_t cookie;
+	bool wb_acct;
 
 	blk_queue_bounce(q, &bio);
 
@@ -1360,9 +1520,17 @@ static blk_qc_t blk_sq_make_request(struct request_queue *q, struct bio *bio)
 	    blk_attempt_plug_merge(q, bio, &request_count, NULL))
 		return BLK_QC_T_NONE;
 
+	wb_acct = wbt_wait(q, bio);
+
 	rq = blk_mq_map_request(q, bio, &data);
-	if (unlikely(!rq))
+	if (unlikely(!rq)) {
+		if (wb_acct)
+			wbt_abort(q);
 		return BLK_QC_T_NONE;
+	}
+
+	if (wb_acct)
+		rq->cmd_flags |= REQ_BG_WB;
 
 	cookie = blk_tag_to_qc_t(rq->tag, data.hctx->queue_num);
 
@@ -1646,6 +1814,11 @@ static void blk_mq_exit_hctx(struct request_queue *q,
 	if (set->ops->exit_hctx)
 		set->ops->exit_hctx(hctx, hctx_idx);
 
+	if (hctx->sched_ops) {
+		hctx->sched_ops->exit_hctx(hctx);
+		hctx->sched_ops = NULL;
+	}
+
 	blk_mq_unregister_cpu_notifier(&hctx->cpu_notifier);
 	blk_free_flush_queue(hctx->fq);
 	blk_mq_free_bitmap(&hctx->ctx_map);
@@ -2058,6 +2231,8 @@ struct request_queue *blk_mq_init_allocated_queue(struct blk_mq_tag_set *set,
 	 */
 	q->nr_requests = set->queue_depth;
 
+	wbt_init(q);
+
 	if (set->ops->complete)
 		blk_queue_softirq_done(q, set->ops->complete);
 
@@ -8,11 +8,14 @@
 #include <linux/blkdev.h>
 #include <linux/backing-dev.h>
 #include <linux/blktrace_api.h>
+#include <linux/math64.h>
 #include <linux/blk-mq.h>
 #include <linux/blk-cgroup.h>
 
 #include "blk.h"
 #include "blk-mq.h"
+#include "blk-mq-sched.h"
+#include "blk-wbt.h"
 
 struct queue_sysfs_entry {
 	struct attribute attr;
@@ -347,6 +350,64 @@ static ssize_t queue_poll_store(struct request_queue *q, const char *page,
 	return ret;
 }
 
+/* schedulers selectable through the mq_scheduler attribute */
+static const struct blk_mq_sched_ops *blk_mq_scheds[] = {
+#ifdef CONFIG_MQ_IOSCHED_DEADLINE
+	&mq_deadline_sched_ops,
+#endif
+};
+
+static ssize_t queue_mq_sched_show(struct request_queue *q, char *page)
+{
+	ssize_t len = 0;
+	int i;
+
+	if (!q->mq_ops)
+		return sprintf(page, "none\n");
+
+	len += sprintf(page, "%snone%s", q->mq_sched ? "" : "[",
+		       q->mq_sched ? "" : "]");
+	for (i = 0; i < ARRAY_SIZE(blk_mq_scheds); i++) {
+		const struct blk_mq_sched_ops *ops = blk_mq_scheds[i];
+
+		len += sprintf(page + len, q->mq_sched == ops ?
+			       " [%s]" : " %s", ops->name);
+	}
+	len += sprintf(page + len, "\n");
+	return len;
+}
+
+static ssize_t queue_mq_sched_store(struct request_queue *q, const char *page,
+				    size_t count)
+{
+	const struct blk_mq_sched_ops *ops = NULL;
+	char name[16];
+	int i, ret;
+
+	if (!q->mq_ops)
+		return -EINVAL;
+
+	if (sscanf(page, "%15s", name) != 1)
+		return -EINVAL;
+
+	if (strcmp(name, "none")) {
+		for (i = 0; i < ARRAY_SIZE(blk_mq_scheds); i++) {
+			if (!strcmp(name, blk_mq_scheds[i]->name)) {
+				ops = blk_mq_scheds[i];
+				break;
+			}
+		}
+		if (!ops)
+			return -EINVAL;
+	}
+
+	ret = blk_mq_sched_switch(q, ops);
+	if (ret)
+		return ret;
+
+	return count;
+}
+
 static struct queue_sysfs_entry queue_requests_entry = {
 	.attr = {.name = "nr_requests", .mode = S_IRUGO | S_IWUSR },
 	.show = queue_requests_show,
@@ -478,6 +539,74 @@ static struct queue_sysfs_entry queue_poll_entry = {
 	.store = queue_poll_store,
 };
 
+static ssize_t queue_poll_delay_show(struct request_queue *q, char *page)
+{
+	return sprintf(page, "%d\n", q->poll_delay);
+}
+
+static ssize_t queue_poll_delay_store(struct request_queue *q, const char *page,
+				      size_t count)
+{
+	int val, err;
+
+	if (!q->mq_ops || !q->mq_ops->poll)
+		return -EINVAL;
+
+	err = kstrtoint(page, 10, &val);
+	if (err < 0)
+		return err;
+
+	if (val < -1)
+		return -EINVAL;
+
+	q->poll_delay = val;
+	return count;
+}
+
+static ssize_t queue_wb_lat_show(struct request_queue *q, char *page)
+{
+	if (!q->rq_wb)
+		return -EINVAL;
+
+	return sprintf(page, "%llu\n",
+		       div_u64(q->rq_wb->min_lat_nsec, NSEC_PER_USEC));
+}
+
+static ssize_t queue_wb_lat_store(struct request_queue *q, const char *page,
+				  size_t count)
+{
+	unsigned long lat;
+	ssize_t ret;
+
+	if (!q->rq_wb)
+		return -EINVAL;
+
+	ret = queue_var_store(&lat, page, count);
+	if (ret < 0)
+		return ret;
+
+	q->rq_wb->min_lat_nsec = lat * NSEC_PER_USEC;
+	return ret;
+}
+
+static struct queue_sysfs_entry queue_mq_sched_entry = {
+	.attr = {.name = "mq_scheduler", .mode = S_IRUGO | S_IWUSR },
+	.show = queue_mq_sched_show,
+	.store = queue_mq_sched_store,
+};
+
+static struct queue_sysfs_entry queue_poll_delay_entry = {
+	.attr = {.name = "io_poll_delay", .mode = S_IRUGO | S_IWUSR },
+	.show = queue_poll_delay_show,
+	.store = queue_poll_delay_store,
+};
+
+static struct queue_sysfs_entry queue_wb_lat_entry = {
+	.attr = {.name = "wbt_lat_usec", .mode = S_IRUGO | S_IWUSR },
+	.show = queue_wb_lat_show,
+	.store = queue_wb_lat_store,
+};
+
 static struct attribute *default_attrs[] = {
 	&queue_requests_entry.attr,
 	&queue_ra_entry.attr,
@@ -503,6 +632,9 @@ static struct attribute *default_attrs[] = {
 	&queue_iostats_entry.attr,
 	&queue_random_entry.attr,
 	&queue_poll_entry.attr,
+	&queue_poll_delay_entry.attr,
+	&queue_mq_sched_entry.attr,
+	&queue_wb_lat_entry.attr,
 	NULL,
 };
 
@@ -580,6 +712,8 @@ static void blk_release_queue(struct kobject *kobj)
 	bdi_exit(&q->backing_dev_info);
 	blkcg_exit_queue(q);
 
+	wbt_exit(q);
+
 	if (q->elevator) {
 		spin_lock_irq(q->queue_lock);
 		ioc_clear_queue(q);
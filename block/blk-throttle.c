@@ -133,6 +133,13 @@ struct throtl_grp {
 	/* When did we start a new slice */
 	unsigned long slice_start[2];
 	unsigned long slice_end[2];
+
+	/* proportional cost mode; 0 weight == opted out */
+	unsigned int weight;
+	/* cost spent in the current window */
+	u64 cost_disp;
+	/* which window the above accounting belongs to */
+	unsigned long cost_window_seq;
 };
 
 struct throtl_data
@@ -152,6 +159,13 @@ struct throtl_data
 
 	/* Work for dispatching throttled bios */
 	struct work_struct dispatch_work;
+
+	/* proportional cost mode state, all under queue_lock */
+	u64 cost_budget;		/* spendable cost per window */
+	u64 cost_disp;			/* cost spent in current window */
+	unsigned int weight_sum;	/* weights active this window */
+	unsigned long cost_window_seq;
+	unsigned long cost_window_end;
 };
 
 static void throtl_pending_timer_fn(unsigned long arg);
@@ -386,7 +400,8 @@ static void tg_update_has_rules(struct throtl_grp *tg)
 
 	for (rw = READ; rw <= WRITE; rw++)
 		tg->has_rules[rw] = (parent_tg && parent_tg->has_rules[rw]) ||
-				    (tg->bps[rw] != -1 || tg->iops[rw] != -1);
+				    (tg->bps[rw] != -1 || tg->iops[rw] != -1 ||
+				     tg->weight);
 }
 
 static void throtl_pd_online(struct blkg_policy_data *pd)
@@ -665,6 +680,96 @@ static inline void throtl_trim_slice(struct throtl_grp *tg, bool rw)
 		   tg->slice_start[rw], tg->slice_end[rw], jiffies);
 }
 
+/*
+ * Proportional cost mode.  A bio's device cost is a fixed command
+ * component plus one unit per 512b sector, doubled for writes since
+ * flash pays extra for program/erase.  The cost a window may spend is
+ * self-clocked from what the device actually moved: it jumps up
+ * whenever demand exceeds it and decays gently otherwise.  Weighted
+ * shares of the budget are only enforced once the whole budget is
+ * spoken for, so a quiet tenant's share is free for the taking.
+ */
+#define THROTL_COST_BASE	8
+#define THROTL_COST_SEED	(1ULL << 30)	/* effectively unlimited */
+#define THROTL_COST_MIN		(1ULL << 16)
+
+static u64 throtl_bio_cost(struct bio *bio)
+{
+	u64 cost = THROTL_COST_BASE + (bio->bi_iter.bi_size >> 9);
+
+	if (bio_data_dir(bio) == WRITE)
+		cost *= 2;
+	return cost;
+}
+
+static void throtl_cost_window_update(struct throtl_data *td)
+{
+	if (time_before(jiffies, td->cost_window_end))
+		return;
+
+	/*
+	 * Ratchet the budget up to whatever the device just proved it
+	 * can do; otherwise decay it so it tracks slowdowns.
+	 */
+	if (td->cost_disp > td->cost_budget)
+		td->cost_budget = td->cost_disp;
+	else
+		td->cost_budget = max3(td->cost_budget -
+				       (td->cost_budget >> 3),
+				       td->cost_disp, THROTL_COST_MIN);
+
+	td->cost_disp = 0;
+	td->weight_sum = 0;
+	td->cost_window_seq++;
+	td->cost_window_end = jiffies + throtl_slice;
+}
+
+/* lazily reset per-window state when @tg first shows up in a window */
+static void throtl_cost_activate(struct throtl_grp *tg)
+{
+	struct throtl_data *td = tg->td;
+
+	if (tg->cost_window_seq != td->cost_window_seq) {
+		tg->cost_window_seq = td->cost_window_seq;
+		tg->cost_disp = 0;
+		td->weight_sum += tg->weight;
+	}
+}
+
+static bool tg_with_in_cost_budget(struct throtl_grp *tg, struct bio *bio,
+				   unsigned long *wait)
+{
+	struct throtl_data *td = tg->td;
+	u64 cost, share;
+
+	if (!tg->weight) {
+		if (wait)
+			*wait = 0;
+		return true;
+	}
+
+	throtl_cost_window_update(td);
+	throtl_cost_activate(tg);
+
+	cost = throtl_bio_cost(bio);
+	share = div64_u64(td->cost_budget * tg->weight, td->weight_sum);
+
+	/*
+	 * Pass while the device has idle capacity this window, or while
+	 * the group is still within its weighted share of the budget.
+	 */
+	if (td->cost_disp + cost <= td->cost_budget ||
+	    tg->cost_disp + cost <= share) {
+		if (wait)
+			*wait = 0;
+		return true;
+	}
+
+	if (wait)
+		*wait = td->cost_window_end - jiffies + 1;
+	return false;
+}
+
 static bool tg_with_in_iops_limit(struct throtl_grp *tg, struct bio *bio,
 				  unsigned long *wait)
 {
@@ -766,6 +871,7 @@ static bool tg_may_dispatch(struct throtl_grp *tg, struct bio *bio,
 {
 	bool rw = bio_data_dir(bio);
 	unsigned long bps_wait = 0, iops_wait = 0, max_wait = 0;
+	unsigned long cost_wait = 0;
 
 	/*
  	 * Currently whole state machine of group depends on first bio
@@ -776,6 +882,13 @@ static bool tg_may_dispatch(struct throtl_grp *tg, struct bio *bio,
 	BUG_ON(tg->service_queue.nr_queued[rw] &&
 	       bio != throtl_peek_queued(&tg->service_queue.queued[rw]));
 
+	/* the weighted cost budget is independent of the bps/iops slices */
+	if (!tg_with_in_cost_budget(tg, bio, &cost_wait)) {
+		if (wait)
+			*wait = cost_wait;
+		return 0;
+	}
+
 	/* If tg->bps = -1, then BW is unlimited */
 	if (tg->bps[rw] == -1 && tg->iops[rw] == -1) {
 		if (wait)
@@ -821,6 +934,18 @@ static void throtl_charge_bio(struct throtl_grp *tg, struct bio *bio)
 	tg->bytes_disp[rw] += bio->bi_iter.bi_size;
 	tg->io_disp[rw]++;
 
+	/*
+	 * Cost is charged once per bio rather than again at every level
+	 * it climbs; weights arbitrate queue-wide, not per subtree.
+	 */
+	if (tg->weight && !(bio->bi_rw & REQ_THROTTLED)) {
+		u64 cost = throtl_bio_cost(bio);
+
+		throtl_cost_activate(tg);
+		tg->cost_disp += cost;
+		tg->td->cost_disp += cost;
+	}
+
 	/*
 	 * REQ_THROTTLED is used to prevent the same bio to be throttled
 	 * more than once as a throttled bio will go through blk-throtl the
@@ -1227,7 +1352,56 @@ static ssize_t tg_set_conf_uint(struct kernfs_open_file *of,
 	return tg_set_conf(of, buf, nbytes, off, false);
 }
 
+static u64 tg_prfill_weight(struct seq_file *sf, struct blkg_policy_data *pd,
+			    int off)
+{
+	struct throtl_grp *tg = pd_to_tg(pd);
+
+	if (!tg->weight)
+		return 0;
+	return __blkg_prfill_u64(sf, pd, tg->weight);
+}
+
+static int tg_print_weight(struct seq_file *sf, void *v)
+{
+	blkcg_print_blkgs(sf, css_to_blkcg(seq_css(sf)), tg_prfill_weight,
+			  &blkcg_policy_throtl, 0, false);
+	return 0;
+}
+
+static ssize_t tg_set_weight(struct kernfs_open_file *of,
+			     char *buf, size_t nbytes, loff_t off)
+{
+	struct blkcg *blkcg = css_to_blkcg(of_css(of));
+	struct blkg_conf_ctx ctx;
+	struct throtl_grp *tg;
+	unsigned int v;
+	int ret;
+
+	ret = blkg_conf_prep(blkcg, &blkcg_policy_throtl, buf, &ctx);
+	if (ret)
+		return ret;
+
+	/* 0 opts the group out of proportional cost mode */
+	ret = -EINVAL;
+	if (sscanf(ctx.body, "%u", &v) != 1 || v > 1000)
+		goto out_finish;
+
+	tg = blkg_to_tg(ctx.blkg);
+	tg->weight = v;
+	tg_conf_updated(tg);
+	ret = 0;
+out_finish:
+	blkg_conf_finish(&ctx);
+	return ret ?: nbytes;
+}
+
 static struct cftype throtl_legacy_files[] = {
+	{
+		.name = "throttle.weight_device",
+		.seq_show = tg_print_weight,
+		.write = tg_set_weight,
+	},
 	{
 		.name = "throttle.read_bps_device",
 		.private = offsetof(struct throtl_grp, bps[READ]),
@@ -1373,6 +1547,12 @@ static struct cftype throtl_files[] = {
 		.seq_show = tg_print_max,
 		.write = tg_set_max,
 	},
+	{
+		.name = "cost.weight",
+		.flags = CFTYPE_NOT_ON_ROOT,
+		.seq_show = tg_print_weight,
+		.write = tg_set_weight,
+	},
 	{ }	/* terminate */
 };
 
@@ -1567,6 +1747,10 @@ int blk_throtl_init(struct request_queue *q)
 	q->td = td;
 	td->queue = q;
 
+	td->cost_budget = THROTL_COST_SEED;
+	td->cost_window_seq = 1;
+	td->cost_window_end = jiffies + throtl_slice;
+
 	/* activate policy */
 	ret = blkcg_activate_policy(q, &blkcg_policy_throtl);
 	if (ret)
@@ -0,0 +1,159 @@
+/*
+ * Buffered writeback throttling, to keep background writes from
+ * monopolizing the device and wrecking foreground read latency.
+ *
+ * Reads are timestamped when issued to the driver and measured on
+ * completion.  When the observed read latency climbs above a per-queue
+ * target, the number of plain (non-sync) writes allowed in flight is
+ * scaled down; once reads are healthy again it creeps back up.  Reads,
+ * sync writes, flushes and discards are never throttled.
+ *
+ * This only applies to blk-mq queues; the legacy path has CFQ's own
+ * sync-vs-async handling.
+ */
+#include <linux/kernel.h>
+#include <linux/blkdev.h>
+#include <linux/slab.h>
+#include <linux/ktime.h>
+#include <linux/sched.h>
+#include <linux/wait.h>
+
+#include "blk-wbt.h"
+
+/* default read completion latency target, in usecs */
+#define WBT_DEF_LAT_USEC	2000
+
+/* how often the write limit is re-evaluated */
+#define WBT_WINDOW		(HZ / 10)
+
+static bool wbt_should_throttle(struct bio *bio)
+{
+	/*
+	 * Plain writes only; anything a task is waiting on directly
+	 * passes through.
+	 */
+	return (bio->bi_rw & (REQ_WRITE | REQ_SYNC | REQ_DISCARD |
+			      REQ_FLUSH | REQ_FUA)) == REQ_WRITE;
+}
+
+/*
+ * Called before allocating a request for @bio.  Returns true if the
+ * write is subject to throttling, in which case the caller must mark
+ * the request with REQ_BG_WB so completion can drop the count, or call
+ * wbt_abort() if no request materializes.
+ */
+bool wbt_wait(struct request_queue *q, struct bio *bio)
+{
+	struct rq_wb *rwb = q->rq_wb;
+	DEFINE_WAIT(wait);
+
+	if (!rwb || !wbt_should_throttle(bio))
+		return false;
+
+	if (atomic_read(&rwb->inflight) >= rwb->wb_max) {
+		do {
+			prepare_to_wait_exclusive(&rwb->wait, &wait,
+						  TASK_UNINTERRUPTIBLE);
+			if (atomic_read(&rwb->inflight) < rwb->wb_max)
+				break;
+			io_schedule();
+		} while (1);
+		finish_wait(&rwb->wait, &wait);
+	}
+
+	/*
+	 * Not atomic wrt the check above, so several waiters waking at
+	 * once can overshoot wb_max briefly.  The limit is a target,
+	 * not a hard cap, and the next window corrects for it.
+	 */
+	atomic_inc(&rwb->inflight);
+	return true;
+}
+
+void wbt_abort(struct request_queue *q)
+{
+	struct rq_wb *rwb = q->rq_wb;
+
+	atomic_dec(&rwb->inflight);
+	if (waitqueue_active(&rwb->wait))
+		wake_up(&rwb->wait);
+}
+
+static void wbt_scale(struct rq_wb *rwb)
+{
+	unsigned long flags;
+
+	if (!spin_trylock_irqsave(&rwb->lock, flags))
+		return;
+
+	if (time_after(jiffies, rwb->win_end)) {
+		if (rwb->read_lat_nsec > rwb->min_lat_nsec) {
+			rwb->wb_max = max_t(unsigned int, rwb->wb_max / 2, 1);
+		} else if (rwb->read_lat_nsec < rwb->min_lat_nsec / 2 &&
+			   rwb->wb_max < rwb->wb_normal) {
+			rwb->wb_max++;
+			if (waitqueue_active(&rwb->wait))
+				wake_up(&rwb->wait);
+		}
+		rwb->win_end = jiffies + WBT_WINDOW;
+	}
+
+	spin_unlock_irqrestore(&rwb->lock, flags);
+}
+
+void wbt_done(struct request_queue *q, struct request *rq)
+{
+	struct rq_wb *rwb = q->rq_wb;
+
+	if (!rwb)
+		return;
+
+	if (rq->cmd_flags & REQ_BG_WB) {
+		atomic_dec(&rwb->inflight);
+		if (waitqueue_active(&rwb->wait))
+			wake_up(&rwb->wait);
+	} else if (rq_data_dir(rq) == READ && rq->issue_ns) {
+		u64 lat = ktime_get_ns() - rq->issue_ns;
+
+		/*
+		 * Lockless EWMA update; a lost store merely drops one
+		 * sample.
+		 */
+		if (rwb->read_lat_nsec)
+			rwb->read_lat_nsec = rwb->read_lat_nsec -
+				(rwb->read_lat_nsec >> 3) + (lat >> 3);
+		else
+			rwb->read_lat_nsec = lat;
+
+		wbt_scale(rwb);
+	}
+}
+
+void wbt_init(struct request_queue *q)
+{
+	struct rq_wb *rwb;
+
+	/*
+	 * Throttling is best effort; the queue simply runs unthrottled
+	 * if the allocation fails.
+	 */
+	rwb = kzalloc(sizeof(*rwb), GFP_KERNEL);
+	if (!rwb)
+		return;
+
+	rwb->wb_normal = max_t(unsigned int, q->nr_requests / 2, 4);
+	rwb->wb_max = rwb->wb_normal;
+	rwb->min_lat_nsec = WBT_DEF_LAT_USEC * NSEC_PER_USEC;
+	atomic_set(&rwb->inflight, 0);
+	init_waitqueue_head(&rwb->wait);
+	spin_lock_init(&rwb->lock);
+	rwb->win_end = jiffies + WBT_WINDOW;
+
+	q->rq_wb = rwb;
+}
+
+void wbt_exit(struct request_queue *q)
+{
+	kfree(q->rq_wb);
+	q->rq_wb = NULL;
+}
@@ -0,0 +1,36 @@
+#ifndef BLK_WBT_H
+#define BLK_WBT_H
+
+#include <linux/atomic.h>
+#include <linux/wait.h>
+#include <linux/spinlock.h>
+
+struct request_queue;
+struct request;
+struct bio;
+
+/*
+ * Per-queue writeback throttling state, managed by blk-wbt.c.  All
+ * scaling happens under @lock; @read_lat_nsec is updated locklessly
+ * from the completion path.
+ */
+struct rq_wb {
+	unsigned int		wb_max;		/* current background write limit */
+	unsigned int		wb_normal;	/* upper bound for wb_max */
+	atomic_t		inflight;	/* throttled writes in flight */
+	wait_queue_head_t	wait;
+
+	u64			min_lat_nsec;	/* read latency target */
+	u64			read_lat_nsec;	/* read completion latency EWMA */
+
+	spinlock_t		lock;
+	unsigned long		win_end;	/* end of current scaling window */
+};
+
+void wbt_init(struct request_queue *q);
+void wbt_exit(struct request_queue *q);
+bool wbt_wait(struct request_queue *q, struct bio *bio);
+void wbt_abort(struct request_queue *q);
+void wbt_done(struct request_queue *q, struct request *rq);
+
+#endif
@@ -0,0 +1,271 @@
+/*
+ *  MQ Deadline i/o scheduler - adaptation of the legacy deadline scheduler
+ *  for the blk-mq scheduling framework, one instance per hardware queue.
+ *
+ *  Derived from deadline-iosched.c, Copyright (C) 2002 Jens Axboe
+ */
+#include <linux/kernel.h>
+#include <linux/fs.h>
+#include <linux/blkdev.h>
+#include <linux/blk-mq.h>
+#include <linux/elevator.h>
+#include <linux/bio.h>
+#include <linux/module.h>
+#include <linux/slab.h>
+#include <linux/init.h>
+#include <linux/compiler.h>
+#include <linux/rbtree.h>
+
+#include "blk-mq-sched.h"
+
+/*
+ * See Documentation/block/deadline-iosched.txt
+ */
+static const int read_expire = HZ / 2;  /* max time before a read is submitted. */
+static const int write_expire = 5 * HZ; /* ditto for writes, these limits are SOFT! */
+static const int writes_starved = 2;    /* max times reads can starve a write */
+static const int fifo_batch = 16;       /* # of sequential requests treated as one
+				     by the above parameters. For throughput. */
+
+struct dd_data {
+	/*
+	 * requests are present on both sort_list and fifo_list
+	 */
+	struct rb_root sort_list[2];
+	struct list_head fifo_list[2];
+
+	/*
+	 * next in sort order. read, write or both are NULL
+	 */
+	struct request *next_rq[2];
+	unsigned int batching;		/* number of sequential requests made */
+	unsigned int starved;		/* times reads have starved writes */
+
+	/*
+	 * A hardware queue can be run from any CPU it is mapped to, so
+	 * insert and dispatch serialize on this lock.
+	 */
+	spinlock_t lock;
+};
+
+static inline struct rb_root *
+dd_rb_root(struct dd_data *dd, struct request *rq)
+{
+	return &dd->sort_list[rq_data_dir(rq)];
+}
+
+/*
+ * get the request after `rq' in sector-sorted order
+ */
+static inline struct request *
+dd_latter_request(struct request *rq)
+{
+	struct rb_node *node = rb_next(&rq->rb_node);
+
+	if (node)
+		return rb_entry_rq(node);
+
+	return NULL;
+}
+
+static inline void
+dd_del_rq_rb(struct dd_data *dd, struct request *rq)
+{
+	const int data_dir = rq_data_dir(rq);
+
+	if (dd->next_rq[data_dir] == rq)
+		dd->next_rq[data_dir] = dd_latter_request(rq);
+
+	elv_rb_del(dd_rb_root(dd, rq), rq);
+}
+
+/*
+ * remove rq from rbtree and fifo.
+ */
+static void dd_remove_request(struct dd_data *dd, struct request *rq)
+{
+	rq_fifo_clear(rq);
+	dd_del_rq_rb(dd, rq);
+}
+
+/*
+ * add rq to rbtree and fifo
+ */
+static void dd_insert_request(struct blk_mq_hw_ctx *hctx, struct request *rq)
+{
+	struct dd_data *dd = hctx->sched_data;
+	const int data_dir = rq_data_dir(rq);
+
+	spin_lock(&dd->lock);
+	elv_rb_add(dd_rb_root(dd, rq), rq);
+
+	/*
+	 * set expire time and add to fifo list
+	 */
+	rq->fifo_time = jiffies +
+		(data_dir == READ ? read_expire : write_expire);
+	list_add_tail(&rq->queuelist, &dd->fifo_list[data_dir]);
+	spin_unlock(&dd->lock);
+}
+
+/*
+ * dd_check_fifo returns 0 if there are no expired requests on the fifo,
+ * 1 otherwise. Requires !list_empty(&dd->fifo_list[data_dir])
+ */
+static inline int dd_check_fifo(struct dd_data *dd, int ddir)
+{
+	struct request *rq = rq_entry_fifo(dd->fifo_list[ddir].next);
+
+	/*
+	 * rq is expired!
+	 */
+	if (time_after_eq(jiffies, rq->fifo_time))
+		return 1;
+
+	return 0;
+}
+
+/*
+ * dd_dispatch_request selects the best request according to
+ * read/write expire, fifo_batch, etc
+ */
+static struct request *dd_dispatch_request(struct blk_mq_hw_ctx *hctx)
+{
+	struct dd_data *dd = hctx->sched_data;
+	struct request *rq;
+	int data_dir;
+	int reads, writes;
+
+	spin_lock(&dd->lock);
+	reads = !list_empty(&dd->fifo_list[READ]);
+	writes = !list_empty(&dd->fifo_list[WRITE]);
+
+	/*
+	 * batches are currently reads XOR writes
+	 */
+	if (dd->next_rq[WRITE])
+		rq = dd->next_rq[WRITE];
+	else
+		rq = dd->next_rq[READ];
+
+	if (rq && dd->batching < fifo_batch)
+		/* we have a next request are still entitled to batch */
+		goto dispatch_request;
+
+	/*
+	 * at this point we are not running a batch. select the appropriate
+	 * data direction (read / write)
+	 */
+
+	if (reads) {
+		BUG_ON(RB_EMPTY_ROOT(&dd->sort_list[READ]));
+
+		if (writes && (dd->starved++ >= writes_starved))
+			goto dispatch_writes;
+
+		data_dir = READ;
+
+		goto dispatch_find_request;
+	}
+
+	/*
+	 * there are either no reads or writes have been starved
+	 */
+
+	if (writes) {
+dispatch_writes:
+		BUG_ON(RB_EMPTY_ROOT(&dd->sort_list[WRITE]));
+
+		dd->starved = 0;
+
+		data_dir = WRITE;
+
+		goto dispatch_find_request;
+	}
+
+	spin_unlock(&dd->lock);
+	return NULL;
+
+dispatch_find_request:
+	/*
+	 * we are not running a batch, find best request for selected data_dir
+	 */
+	if (dd_check_fifo(dd, data_dir) || !dd->next_rq[data_dir]) {
+		/*
+		 * A deadline has expired, the last request was in the other
+		 * direction, or we have run out of higher-sectored requests.
+		 * Start again from the request with the earliest expiry time.
+		 */
+		rq = rq_entry_fifo(dd->fifo_list[data_dir].next);
+	} else {
+		/*
+		 * The last req was the same dir and we have a next request in
+		 * sort order. No expired requests so continue on from here.
+		 */
+		rq = dd->next_rq[data_dir];
+	}
+
+	dd->batching = 0;
+
+dispatch_request:
+	/*
+	 * rq is the selected appropriate request.
+	 */
+	dd->batching++;
+
+	data_dir = rq_data_dir(rq);
+	dd->next_rq[READ] = NULL;
+	dd->next_rq[WRITE] = NULL;
+	dd->next_rq[data_dir] = dd_latter_request(rq);
+
+	dd_remove_request(dd, rq);
+	spin_unlock(&dd->lock);
+
+	return rq;
+}
+
+static bool dd_has_work(struct blk_mq_hw_ctx *hctx)
+{
+	struct dd_data *dd = hctx->sched_data;
+
+	return !list_empty_careful(&dd->fifo_list[READ]) ||
+		!list_empty_careful(&dd->fifo_list[WRITE]);
+}
+
+static int dd_init_hctx(struct blk_mq_hw_ctx *hctx)
+{
+	struct dd_data *dd;
+
+	dd = kzalloc_node(sizeof(*dd), GFP_KERNEL, hctx->numa_node);
+	if (!dd)
+		return -ENOMEM;
+
+	INIT_LIST_HEAD(&dd->fifo_list[READ]);
+	INIT_LIST_HEAD(&dd->fifo_list[WRITE]);
+	dd->sort_list[READ] = RB_ROOT;
+	dd->sort_list[WRITE] = RB_ROOT;
+	spin_lock_init(&dd->lock);
+
+	hctx->sched_data = dd;
+	return 0;
+}
+
+static void dd_exit_hctx(struct blk_mq_hw_ctx *hctx)
+{
+	struct dd_data *dd = hctx->sched_data;
+
+	WARN_ON(!list_empty(&dd->fifo_list[READ]));
+	WARN_ON(!list_empty(&dd->fifo_list[WRITE]));
+
+	hctx->sched_data = NULL;
+	kfree(dd);
+}
+
+const struct blk_mq_sched_ops mq_deadline_sched_ops = {
+	.name		= "deadline",
+	.init_hctx	= dd_init_hctx,
+	.exit_hctx	= dd_exit_hctx,
+	.insert		= dd_insert_request,
+	.dispatch	= dd_dispatch_request,
+	.has_work	= dd_has_work,
+};
@@ -61,6 +61,16 @@ void mcryptd_arm_flusher(struct mcryptd_alg_cstate *cstate, unsigned long delay)
 		queue_delayed_work_on(smp_processor_id(), kcrypto_wq,
 			&cstate->flush, delay);
 		mutex_unlock(&flist->lock);
+	} else if (time_before(jiffies + delay, cstate->next_flush)) {
+		/*
+		 * A job with a shorter deadline arrived while the flusher
+		 * is armed; pull the timer in so partially filled lanes
+		 * are never held longer than the bound the caller asked
+		 * for.
+		 */
+		cstate->next_flush = jiffies + delay;
+		mod_delayed_work_on(smp_processor_id(), kcrypto_wq,
+				    &cstate->flush, delay);
 	}
 }
 EXPORT_SYMBOL(mcryptd_arm_flusher);
@@ -80,6 +90,7 @@ static int mcryptd_init_queue(struct mcryptd_queue *queue,
 		pr_debug("cpu_queue #%d %p\n", cpu, queue->cpu_queue);
 		crypto_init_queue(&cpu_queue->queue, max_cpu_qlen);
 		INIT_WORK(&cpu_queue->work, mcryptd_queue_worker);
+		spin_lock_init(&cpu_queue->q_lock);
 	}
 	return 0;
 }
@@ -107,7 +118,9 @@ static int mcryptd_enqueue_request(struct mcryptd_queue *queue,
 	cpu_queue = this_cpu_ptr(queue->cpu_queue);
 	rctx->tag.cpu = cpu;
 
+	spin_lock(&cpu_queue->q_lock);
 	err = crypto_enqueue_request(&cpu_queue->queue, request);
+	spin_unlock(&cpu_queue->q_lock);
 	pr_debug("enqueue request: cpu %d cpu_queue %p request %p\n",
 		 cpu, cpu_queue, request);
 	queue_work_on(cpu, kcrypto_wq, &cpu_queue->work);
@@ -161,15 +174,14 @@ static void mcryptd_queue_worker(struct work_struct *work)
 	i = 0;
 	while (i < MCRYPTD_BATCH || single_task_running()) {
 		/*
-		 * preempt_disable/enable is used to prevent
-		 * being preempted by mcryptd_enqueue_request()
+		 * The queue lock, rather than preemption tricks, keeps
+		 * this safe against mcryptd_enqueue_request() running on
+		 * another CPU after a requeue moved the work.
 		 */
-		local_bh_disable();
-		preempt_disable();
+		spin_lock_bh(&cpu_queue->q_lock);
 		backlog = crypto_get_backlog(&cpu_queue->queue);
 		req = crypto_dequeue_request(&cpu_queue->queue);
-		preempt_enable();
-		local_bh_enable();
+		spin_unlock_bh(&cpu_queue->q_lock);
 
 		if (!req) {
 			mcryptd_opportunistic_flush();
@@ -18,6 +18,7 @@
  */
 
 #include <linux/device.h>
+#include <linux/boottime.h>
 #include <linux/delay.h>
 #include <linux/module.h>
 #include <linux/kthread.h>
@@ -438,6 +439,24 @@ done:
 	return ret;
 }
 
+/*
+ * For the boot-time probe analysis requested via initcall_debug: time
+ * every probe individually so the serialized stragglers stand out.
+ */
+static int really_probe_debug(struct device *dev, struct device_driver *drv)
+{
+	ktime_t calltime, delta, rettime;
+	int ret;
+
+	calltime = ktime_get();
+	ret = really_probe(dev, drv);
+	rettime = ktime_get();
+	delta = ktime_sub(rettime, calltime);
+	printk(KERN_DEBUG "probe of %s returned %d after %lld usecs\n",
+	       dev_name(dev), ret, (s64)ktime_to_us(delta));
+	return ret;
+}
+
 /**
  * driver_probe_done
  * Determine if the probe sequence is finished or not.
@@ -484,6 +503,7 @@ EXPORT_SYMBOL_GPL(wait_for_device_probe);
  */
 int driver_probe_device(struct device_driver *drv, struct device *dev)
 {
+	u64 calltime;
 	int ret = 0;
 
 	if (!device_is_registered(dev))
@@ -496,7 +516,12 @@ int driver_probe_device(struct device_driver *drv, struct device *dev)
 		pm_runtime_get_sync(dev->parent);
 
 	pm_runtime_barrier(dev);
-	ret = really_probe(dev, drv);
+	calltime = boottime_stamp();
+	if (initcall_debug)
+		ret = really_probe_debug(dev, drv);
+	else
+		ret = really_probe(dev, drv);
+	boottime_record_probe(drv, dev, calltime, ret);
 	pm_request_idle(dev);
 
 	if (dev->parent)
@@ -698,6 +723,25 @@ void device_initial_probe(struct device *dev)
 	__device_attach(dev, true);
 }
 
+static void __driver_attach_async_helper(void *_dev, async_cookie_t cookie)
+{
+	struct device *dev = _dev;
+	struct device_driver *drv;
+
+	if (dev->parent)	/* Needed for USB */
+		device_lock(dev->parent);
+	device_lock(dev);
+	drv = dev->p->async_driver;
+	if (!dev->driver)
+		driver_probe_device(drv, dev);
+	device_unlock(dev);
+	if (dev->parent)
+		device_unlock(dev->parent);
+
+	dev_dbg(dev, "driver %s async attach completed\n", drv->name);
+	put_device(dev);
+}
+
 static int __driver_attach(struct device *dev, void *data)
 {
 	struct device_driver *drv = data;
@@ -725,6 +769,28 @@ static int __driver_attach(struct device *dev, void *data)
 		return ret;
 	} /* ret > 0 means positive match */
 
+	if (driver_allows_async_probing(drv)) {
+		/*
+		 * Probe matched devices asynchronously instead of one
+		 * after the other.  Devices of the same driver are
+		 * independent of each other; ordering against suppliers
+		 * is handled by probe deferral, so all the parallelism
+		 * the dependencies allow is exploited.
+		 *
+		 * The device lock is only taken to protect ->driver and
+		 * ->async_driver against a concurrent attach.
+		 */
+		dev_dbg(dev, "probing driver %s asynchronously\n", drv->name);
+		device_lock(dev);
+		if (!dev->driver) {
+			get_device(dev);
+			dev->p->async_driver = drv;
+			async_schedule(__driver_attach_async_helper, dev);
+		}
+		device_unlock(dev);
+		return 0;
+	}
+
 	if (dev->parent)	/* Needed for USB */
 		device_lock(dev->parent);
 	device_lock(dev);
@@ -85,6 +85,7 @@ static DEFINE_MUTEX(loop_index_mutex);
 
 static int max_part;
 static int part_shift;
+static int max_queues;
 
 static int transfer_xor(struct loop_device *lo, int cmd,
 			struct page *raw_page, unsigned raw_off,
@@ -845,19 +846,44 @@ static void loop_config_discard(struct loop_device *lo)
 
 static void loop_unprepare_queue(struct loop_device *lo)
 {
-	flush_kthread_worker(&lo->worker);
-	kthread_stop(lo->worker_task);
+	unsigned int i;
+
+	for (i = 0; i < lo->nr_workers; i++) {
+		flush_kthread_worker(&lo->workers[i].worker);
+		kthread_stop(lo->workers[i].task);
+	}
+	kfree(lo->workers);
+	lo->workers = NULL;
+	lo->nr_workers = 0;
 }
 
 static int loop_prepare_queue(struct loop_device *lo)
 {
-	init_kthread_worker(&lo->worker);
-	lo->worker_task = kthread_run(kthread_worker_fn,
-			&lo->worker, "loop%d", lo->lo_number);
-	if (IS_ERR(lo->worker_task))
+	unsigned int i;
+
+	lo->workers = kcalloc(lo->tag_set.nr_hw_queues,
+			      sizeof(*lo->workers), GFP_KERNEL);
+	if (!lo->workers)
 		return -ENOMEM;
-	set_user_nice(lo->worker_task, MIN_NICE);
+
+	for (i = 0; i < lo->tag_set.nr_hw_queues; i++) {
+		struct loop_worker *w = &lo->workers[i];
+
+		init_kthread_worker(&w->worker);
+		w->task = kthread_run(kthread_worker_fn, &w->worker,
+				      "loop%d/%u", lo->lo_number, i);
+		if (IS_ERR(w->task))
+			goto fail;
+		set_user_nice(w->task, MIN_NICE);
+	}
+	lo->nr_workers = lo->tag_set.nr_hw_queues;
 	return 0;
+fail:
+	while (i-- > 0)
+		kthread_stop(lo->workers[i].task);
+	kfree(lo->workers);
+	lo->workers = NULL;
+	return -ENOMEM;
 }
 
 static int loop_set_fd(struct loop_device *lo, fmode_t mode,
@@ -1599,6 +1625,8 @@ static const struct block_device_operations lo_fops = {
 static int max_loop;
 module_param(max_loop, int, S_IRUGO);
 MODULE_PARM_DESC(max_loop, "Maximum number of loop devices");
+module_param(max_queues, int, S_IRUGO);
+MODULE_PARM_DESC(max_queues, "Hardware queues (and workers) per loop device, 0 for one per online CPU");
 module_param(max_part, int, S_IRUGO);
 MODULE_PARM_DESC(max_part, "Maximum number of partitions per loop device");
 MODULE_LICENSE("GPL");
@@ -1659,7 +1687,7 @@ static int loop_queue_rq(struct blk_mq_hw_ctx *hctx,
 	else
 		cmd->use_aio = false;
 
-	queue_kthread_work(&lo->worker, &cmd->work);
+	queue_kthread_work(&lo->workers[hctx->queue_num].worker, &cmd->work);
 
 	return BLK_MQ_RQ_QUEUE_OK;
 }
@@ -1735,7 +1763,7 @@ static int loop_add(struct loop_device **l, int i)
 
 	err = -ENOMEM;
 	lo->tag_set.ops = &loop_mq_ops;
-	lo->tag_set.nr_hw_queues = 1;
+	lo->tag_set.nr_hw_queues = max_queues ?: num_online_cpus();
 	lo->tag_set.queue_depth = 128;
 	lo->tag_set.numa_node = NUMA_NO_NODE;
 	lo->tag_set.cmd_size = sizeof(struct loop_cmd);
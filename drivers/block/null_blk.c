@@ -9,6 +9,8 @@
 #include <linux/blk-mq.h>
 #include <linux/hrtimer.h>
 #include <linux/lightnvm.h>
+#include <linux/random.h>
+#include <linux/math64.h>
 
 struct nullb_cmd {
 	struct list_head list;
@@ -62,6 +64,15 @@ enum {
 	NULL_Q_MQ		= 2,
 };
 
+enum {
+	NULL_LAT_FIXED		= 0,
+	NULL_LAT_NORMAL		= 1,
+	NULL_LAT_BIMODAL	= 2,
+};
+
+/* virtual end of the last service period, for the throughput cap */
+static atomic64_t null_busy_until;
+
 static int submit_queues;
 module_param(submit_queues, int, S_IRUGO);
 MODULE_PARM_DESC(submit_queues, "Number of submission queues");
@@ -136,6 +147,51 @@ static unsigned long completion_nsec = 10000;
 module_param(completion_nsec, ulong, S_IRUGO);
 MODULE_PARM_DESC(completion_nsec, "Time in ns to complete a request in hardware. Default: 10,000ns");
 
+static unsigned long read_nsec;
+module_param(read_nsec, ulong, S_IRUGO);
+MODULE_PARM_DESC(read_nsec, "Completion time for reads, in ns. 0 uses completion_nsec. Default: 0");
+
+static unsigned long write_nsec;
+module_param(write_nsec, ulong, S_IRUGO);
+MODULE_PARM_DESC(write_nsec, "Completion time for writes, in ns. 0 uses completion_nsec. Default: 0");
+
+static int latency_dist = NULL_LAT_FIXED;
+
+static int null_set_latency_dist(const char *str, const struct kernel_param *kp)
+{
+	return null_param_store_val(str, &latency_dist, NULL_LAT_FIXED,
+					NULL_LAT_BIMODAL);
+}
+
+static const struct kernel_param_ops null_latency_dist_param_ops = {
+	.set	= null_set_latency_dist,
+	.get	= param_get_int,
+};
+
+device_param_cb(latency_dist, &null_latency_dist_param_ops, &latency_dist,
+		S_IRUGO);
+MODULE_PARM_DESC(latency_dist, "Completion latency distribution. 0-fixed, 1-normal, 2-bimodal");
+
+static unsigned long latency_sigma_nsec;
+module_param(latency_sigma_nsec, ulong, S_IRUGO);
+MODULE_PARM_DESC(latency_sigma_nsec, "Standard deviation of the normal latency distribution, in ns. Default: 0");
+
+static int bimodal_pct = 1;
+module_param(bimodal_pct, int, S_IRUGO);
+MODULE_PARM_DESC(bimodal_pct, "Percentage of commands taking the slow mode of the bimodal distribution. Default: 1");
+
+static unsigned long bimodal_nsec = 10000000;
+module_param(bimodal_nsec, ulong, S_IRUGO);
+MODULE_PARM_DESC(bimodal_nsec, "Slow-mode completion time of the bimodal distribution, in ns. Default: 10,000,000ns");
+
+static int mbps;
+module_param(mbps, int, S_IRUGO);
+MODULE_PARM_DESC(mbps, "Cap throughput at this many MB/s, across all devices. 0 disables. Default: 0");
+
+static int busy_pct;
+module_param(busy_pct, int, S_IRUGO);
+MODULE_PARM_DESC(busy_pct, "Percentage of blk-mq submissions answered with device-busy, to emulate tag starvation. Default: 0");
+
 static int hw_queue_depth = 64;
 module_param(hw_queue_depth, int, S_IRUGO);
 MODULE_PARM_DESC(hw_queue_depth, "Queue depth for each hardware queue. Default: 64");
@@ -254,11 +310,77 @@ static enum hrtimer_restart null_cmd_timer_expired(struct hrtimer *timer)
 	return HRTIMER_NORESTART;
 }
 
-static void null_cmd_end_timer(struct nullb_cmd *cmd)
+static u64 null_cmd_latency(struct nullb_cmd *cmd)
 {
-	ktime_t kt = ktime_set(0, completion_nsec);
+	unsigned int bytes = 0;
+	bool is_write = false;
+	u64 lat;
 
-	hrtimer_start(&cmd->timer, kt, HRTIMER_MODE_REL);
+	if (cmd->rq) {
+		is_write = rq_data_dir(cmd->rq) == WRITE;
+		bytes = blk_rq_bytes(cmd->rq);
+	} else if (cmd->bio) {
+		is_write = bio_data_dir(cmd->bio) == WRITE;
+		bytes = cmd->bio->bi_iter.bi_size;
+	}
+
+	lat = completion_nsec;
+	if (is_write && write_nsec)
+		lat = write_nsec;
+	else if (!is_write && read_nsec)
+		lat = read_nsec;
+
+	switch (latency_dist) {
+	case NULL_LAT_NORMAL:
+		if (latency_sigma_nsec) {
+			s64 jitter = 0;
+			int i;
+
+			/*
+			 * The sum of three uniform samples is close enough
+			 * to a normal distribution for completion jitter
+			 * (Irwin-Hall); centre it on the base latency.
+			 */
+			for (i = 0; i < 3; i++)
+				jitter += prandom_u32() %
+					(2 * latency_sigma_nsec + 1);
+			jitter = div_s64(jitter, 3) - latency_sigma_nsec;
+			if (jitter < 0 && (u64)-jitter > lat)
+				lat = 0;
+			else
+				lat += jitter;
+		}
+		break;
+	case NULL_LAT_BIMODAL:
+		if (prandom_u32() % 100 < (unsigned int)bimodal_pct)
+			lat = bimodal_nsec;
+		break;
+	}
+
+	if (mbps && bytes) {
+		u64 svc = div_u64((u64)bytes * NSEC_PER_SEC, (u64)mbps << 20);
+		u64 now = ktime_get_ns();
+		u64 old, start;
+
+		/*
+		 * Chain virtual service periods so the aggregate rate
+		 * converges on the cap no matter how many queues feed it.
+		 */
+		do {
+			old = atomic64_read(&null_busy_until);
+			start = max(old, now);
+		} while (atomic64_cmpxchg(&null_busy_until, old,
+					  start + svc) != (s64)old);
+		lat = max(lat, start + svc - now);
+	}
+
+	return lat;
+}
+
+static void null_cmd_end_timer(struct nullb_cmd *cmd)
+{
+	hrtimer_start(&cmd->timer, ns_to_ktime(null_cmd_latency(cmd)),
+		      HRTIMER_MODE_REL);
 }
 
 static void null_softirq_done_fn(struct request *rq)
@@ -356,6 +478,13 @@ static int null_queue_rq(struct blk_mq_hw_ctx *hctx,
 {
 	struct nullb_cmd *cmd = blk_mq_rq_to_pdu(bd->rq);
 
+	/*
+	 * Emulated tag starvation: pretend the device has no free slot
+	 * so the core exercises its requeue/restart machinery.
+	 */
+	if (busy_pct && prandom_u32() % 100 < (unsigned int)busy_pct)
+		return BLK_MQ_RQ_QUEUE_BUSY;
+
 	if (irqmode == NULL_IRQ_TIMER) {
 		hrtimer_init(&cmd->timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
 		cmd->timer.function = null_cmd_timer_expired;
@@ -788,6 +917,14 @@ static int __init null_init(void)
 		queue_mode = NULL_Q_MQ;
 	}
 
+	if (irqmode != NULL_IRQ_TIMER &&
+	    (latency_dist != NULL_LAT_FIXED || read_nsec || write_nsec ||
+	     mbps)) {
+		pr_warn("null_blk: latency emulation needs timer completions\n");
+		pr_warn("null_blk: defaults irqmode to timer\n");
+		irqmode = NULL_IRQ_TIMER;
+	}
+
 	if (queue_mode == NULL_Q_MQ && use_per_node_hctx) {
 		if (submit_queues < nr_online_nodes) {
 			pr_warn("null_blk: submit_queues param is set to %u.",
@@ -157,6 +157,37 @@ static void virtblk_done(struct virtqueue *vq)
 	spin_unlock_irqrestore(&vblk->vqs[qid].lock, flags);
 }
 
+/*
+ * Reap the used ring directly instead of waiting for the host's
+ * completion interrupt to be injected.  The virtqueue callback stays
+ * armed - whoever takes the vq lock first completes the requests, and
+ * completing tags other than the one polled for is fine.
+ */
+static int virtblk_poll(struct blk_mq_hw_ctx *hctx, unsigned int tag)
+{
+	struct virtio_blk *vblk = hctx->queue->queuedata;
+	struct virtio_blk_vq *vbq = &vblk->vqs[hctx->queue_num];
+	struct virtblk_req *vbr;
+	unsigned long flags;
+	unsigned int len;
+	int found = 0;
+
+	spin_lock_irqsave(&vbq->lock, flags);
+
+	while ((vbr = virtqueue_get_buf(vbq->vq, &len)) != NULL) {
+		blk_mq_complete_request(vbr->req, vbr->req->errors);
+		found++;
+	}
+
+	/* In case queue is stopped waiting for more buffers. */
+	if (found)
+		blk_mq_start_stopped_hw_queues(vblk->disk->queue, true);
+
+	spin_unlock_irqrestore(&vbq->lock, flags);
+
+	return found;
+}
+
 static int virtio_queue_rq(struct blk_mq_hw_ctx *hctx,
 			   const struct blk_mq_queue_data *bd)
 {
@@ -562,6 +593,7 @@ static struct blk_mq_ops virtio_mq_ops = {
 	.map_queue	= blk_mq_map_queue,
 	.complete	= virtblk_request_done,
 	.init_request	= virtblk_init_request,
+	.poll		= virtblk_poll,
 };
 
 static unsigned int virtblk_queue_depth;
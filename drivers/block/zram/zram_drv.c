@@ -385,6 +385,247 @@ static ssize_t comp_algorithm_store(struct device *dev,
 	return len;
 }
 
+#ifdef CONFIG_ZRAM_WRITEBACK
+static bool zram_wb_enabled(struct zram *zram)
+{
+	return zram->backing_dev != NULL;
+}
+
+static void reset_bdev(struct zram *zram)
+{
+	struct block_device *bdev;
+
+	if (!zram_wb_enabled(zram))
+		return;
+
+	bdev = zram->bdev;
+	if (zram->old_block_size)
+		set_blocksize(bdev, zram->old_block_size);
+	blkdev_put(bdev, FMODE_READ | FMODE_WRITE | FMODE_EXCL);
+	/* hope filp_close flush all of IO */
+	filp_close(zram->backing_dev, NULL);
+	zram->backing_dev = NULL;
+	zram->old_block_size = 0;
+	zram->bdev = NULL;
+
+	vfree(zram->bitmap);
+	zram->bitmap = NULL;
+}
+
+static ssize_t backing_dev_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	struct zram *zram = dev_to_zram(dev);
+	struct file *file = zram->backing_dev;
+	char *p;
+	ssize_t ret;
+
+	down_read(&zram->init_lock);
+	if (!zram_wb_enabled(zram)) {
+		memcpy(buf, "none\n", 5);
+		up_read(&zram->init_lock);
+		return 5;
+	}
+
+	p = file_path(file, buf, PAGE_SIZE - 1);
+	if (IS_ERR(p)) {
+		ret = PTR_ERR(p);
+		goto out;
+	}
+
+	ret = strlen(p);
+	memmove(buf, p, ret);
+	buf[ret++] = '\n';
+out:
+	up_read(&zram->init_lock);
+	return ret;
+}
+
+static ssize_t backing_dev_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t len)
+{
+	char *file_name;
+	size_t sz;
+	struct file *backing_dev = NULL;
+	struct inode *inode;
+	unsigned int old_block_size = 0;
+	unsigned long nr_pages, *bitmap = NULL;
+	struct block_device *bdev = NULL;
+	int err;
+	struct zram *zram = dev_to_zram(dev);
+
+	file_name = kmalloc(PATH_MAX, GFP_KERNEL);
+	if (!file_name)
+		return -ENOMEM;
+
+	down_write(&zram->init_lock);
+	if (init_done(zram)) {
+		pr_info("Can't setup backing device for initialized device\n");
+		err = -EBUSY;
+		goto out;
+	}
+
+	strlcpy(file_name, buf, PATH_MAX);
+	/* ignore trailing newline */
+	sz = strlen(file_name);
+	if (sz > 0 && file_name[sz - 1] == '\n')
+		file_name[sz - 1] = 0x00;
+
+	backing_dev = filp_open(file_name, O_RDWR | O_LARGEFILE, 0);
+	if (IS_ERR(backing_dev)) {
+		err = PTR_ERR(backing_dev);
+		backing_dev = NULL;
+		goto out;
+	}
+
+	inode = backing_dev->f_mapping->host;
+
+	/* Support only block device in this moment */
+	if (!S_ISBLK(inode->i_mode)) {
+		err = -ENOTBLK;
+		goto out;
+	}
+
+	bdev = bdgrab(I_BDEV(inode));
+	err = blkdev_get(bdev, FMODE_READ | FMODE_WRITE | FMODE_EXCL, zram);
+	if (err < 0) {
+		/* blkdev_get() drops the reference on failure */
+		bdev = NULL;
+		goto out;
+	}
+
+	nr_pages = i_size_read(inode) >> PAGE_SHIFT;
+	bitmap = vzalloc(BITS_TO_LONGS(nr_pages) * sizeof(long));
+	if (!bitmap) {
+		err = -ENOMEM;
+		goto out;
+	}
+	/*
+	 * Reserve block 0 so that a stored block index is never zero and
+	 * cannot be mistaken for an unused table slot.
+	 */
+	set_bit(0, bitmap);
+
+	old_block_size = block_size(bdev);
+	err = set_blocksize(bdev, PAGE_SIZE);
+	if (err)
+		goto out;
+
+	reset_bdev(zram);
+
+	zram->old_block_size = old_block_size;
+	zram->bdev = bdev;
+	zram->backing_dev = backing_dev;
+	zram->bitmap = bitmap;
+	zram->nr_pages = nr_pages;
+	up_write(&zram->init_lock);
+
+	pr_info("setup backing device %s\n", file_name);
+	kfree(file_name);
+
+	return len;
+out:
+	vfree(bitmap);
+
+	if (bdev)
+		blkdev_put(bdev, FMODE_READ | FMODE_WRITE | FMODE_EXCL);
+
+	if (backing_dev)
+		filp_close(backing_dev, NULL);
+
+	up_write(&zram->init_lock);
+
+	kfree(file_name);
+
+	return err;
+}
+
+static unsigned long alloc_block_bdev(struct zram *zram)
+{
+	unsigned long blk_idx;
+retry:
+	/* skip the reserved block 0 */
+	blk_idx = find_next_zero_bit(zram->bitmap, zram->nr_pages, 1);
+	if (blk_idx == zram->nr_pages)
+		return 0;
+
+	if (test_and_set_bit(blk_idx, zram->bitmap))
+		goto retry;
+
+	return blk_idx;
+}
+
+static void free_block_bdev(struct zram *zram, unsigned long blk_idx)
+{
+	clear_bit(blk_idx, zram->bitmap);
+}
+
+static int bdev_rw_page_sync(struct zram *zram, struct bio_vec *bvec,
+			unsigned long blk_idx, int rw)
+{
+	struct bio *bio;
+	int err;
+
+	bio = bio_alloc(GFP_NOIO, 1);
+	if (!bio)
+		return -ENOMEM;
+
+	bio->bi_iter.bi_sector = blk_idx * (PAGE_SIZE >> SECTOR_SHIFT);
+	bio->bi_bdev = zram->bdev;
+	if (!bio_add_page(bio, bvec->bv_page, bvec->bv_len, bvec->bv_offset)) {
+		bio_put(bio);
+		return -EIO;
+	}
+
+	err = submit_bio_wait(rw, bio);
+	bio_put(bio);
+
+	return err;
+}
+
+static int read_from_bdev(struct zram *zram, struct bio_vec *bvec,
+			unsigned long blk_idx)
+{
+	return bdev_rw_page_sync(zram, bvec, blk_idx, READ);
+}
+
+static int write_to_bdev(struct zram *zram, struct bio_vec *bvec,
+			unsigned long *pentry)
+{
+	unsigned long blk_idx;
+	int err;
+
+	blk_idx = alloc_block_bdev(zram);
+	if (!blk_idx)
+		return -ENOSPC;
+
+	err = bdev_rw_page_sync(zram, bvec, blk_idx, WRITE);
+	if (err) {
+		free_block_bdev(zram, blk_idx);
+		return err;
+	}
+
+	*pentry = blk_idx;
+
+	return 0;
+}
+#else
+static bool zram_wb_enabled(struct zram *zram) { return false; }
+static void reset_bdev(struct zram *zram) {}
+static void free_block_bdev(struct zram *zram, unsigned long blk_idx) {}
+static int read_from_bdev(struct zram *zram, struct bio_vec *bvec,
+			unsigned long blk_idx)
+{
+	return -EIO;
+}
+
+static int write_to_bdev(struct zram *zram, struct bio_vec *bvec,
+			unsigned long *pentry)
+{
+	return -EIO;
+}
+#endif
+
 static ssize_t compact_store(struct device *dev,
 		struct device_attribute *attr, const char *buf, size_t len)
 {
@@ -494,6 +735,10 @@ static void zram_meta_free(struct zram_meta *meta, u64 disksize)
 		if (!handle)
 			continue;
 
+		/* slots on the backing device hold a block index, not a handle */
+		if (meta->table[index].value & BIT(ZRAM_WB))
+			continue;
+
 		zs_free(meta->mem_pool, handle);
 	}
 
@@ -541,6 +786,18 @@ static void zram_free_page(struct zram *zram, size_t index)
 	struct zram_meta *meta = zram->meta;
 	unsigned long handle = meta->table[index].handle;
 
+	if (zram_test_flag(meta, index, ZRAM_IDLE))
+		zram_clear_flag(meta, index, ZRAM_IDLE);
+
+	if (zram_test_flag(meta, index, ZRAM_WB)) {
+		/* the handle field holds the backing device block index */
+		zram_clear_flag(meta, index, ZRAM_WB);
+		free_block_bdev(zram, handle);
+		meta->table[index].handle = 0;
+		atomic64_dec(&zram->stats.pages_stored);
+		return;
+	}
+
 	if (unlikely(!handle)) {
 		/*
 		 * No memory is allocated for zero filled pages.
@@ -563,6 +820,15 @@ static void zram_free_page(struct zram *zram, size_t index)
 	zram_set_obj_size(meta, index, 0);
 }
 
+static void zram_clear_idle(struct zram *zram, u32 index)
+{
+	struct zram_meta *meta = zram->meta;
+
+	bit_spin_lock(ZRAM_ACCESS, &meta->table[index].value);
+	zram_clear_flag(meta, index, ZRAM_IDLE);
+	bit_spin_unlock(ZRAM_ACCESS, &meta->table[index].value);
+}
+
 static int zram_decompress_page(struct zram *zram, char *mem, u32 index)
 {
 	int ret = 0;
@@ -572,6 +838,17 @@ static int zram_decompress_page(struct zram *zram, char *mem, u32 index)
 	size_t size;
 
 	bit_spin_lock(ZRAM_ACCESS, &meta->table[index].value);
+	if (zram_test_flag(meta, index, ZRAM_WB)) {
+		/*
+		 * The slot went to the backing device after the caller
+		 * sampled it. We may be decompressing into an atomic
+		 * kmap here, so block I/O is not an option; fail the
+		 * request instead. Callers that can sleep fetch such
+		 * slots through zram_read_page() before coming here.
+		 */
+		bit_spin_unlock(ZRAM_ACCESS, &meta->table[index].value);
+		return -EIO;
+	}
 	handle = meta->table[index].handle;
 	size = zram_get_obj_size(meta, index);
 
@@ -598,6 +875,69 @@ static int zram_decompress_page(struct zram *zram, char *mem, u32 index)
 	return 0;
 }
 
+/*
+ * Read the full page at @index into @mem, fetching it back from the
+ * backing device if the slot was written out. @mem must be suitable
+ * for block I/O (no atomic kmap), and the caller must be able to sleep.
+ */
+static int zram_read_page(struct zram *zram, char *mem, u32 index)
+{
+	struct zram_meta *meta = zram->meta;
+
+	bit_spin_lock(ZRAM_ACCESS, &meta->table[index].value);
+	if (zram_test_flag(meta, index, ZRAM_WB)) {
+		unsigned long blk_idx = meta->table[index].handle;
+		struct bio_vec bv;
+
+		bit_spin_unlock(ZRAM_ACCESS, &meta->table[index].value);
+
+		bv.bv_page = virt_to_page(mem);
+		bv.bv_len = PAGE_SIZE;
+		bv.bv_offset = offset_in_page(mem);
+		return read_from_bdev(zram, &bv, blk_idx);
+	}
+	bit_spin_unlock(ZRAM_ACCESS, &meta->table[index].value);
+
+	return zram_decompress_page(zram, mem, index);
+}
+
+static int zram_bvec_read_from_bdev(struct zram *zram, struct bio_vec *bvec,
+				int offset, unsigned long blk_idx)
+{
+	struct page *page;
+	struct bio_vec bv;
+	void *src, *dst;
+	int ret;
+
+	if (!is_partial_io(bvec)) {
+		ret = read_from_bdev(zram, bvec, blk_idx);
+		if (!ret)
+			flush_dcache_page(bvec->bv_page);
+		return ret;
+	}
+
+	/* Use a temporary page to read in the full backing block */
+	page = alloc_page(GFP_NOIO);
+	if (!page)
+		return -ENOMEM;
+
+	bv.bv_page = page;
+	bv.bv_len = PAGE_SIZE;
+	bv.bv_offset = 0;
+	ret = read_from_bdev(zram, &bv, blk_idx);
+	if (!ret) {
+		src = kmap_atomic(page);
+		dst = kmap_atomic(bvec->bv_page);
+		memcpy(dst + bvec->bv_offset, src + offset, bvec->bv_len);
+		kunmap_atomic(dst);
+		kunmap_atomic(src);
+		flush_dcache_page(bvec->bv_page);
+	}
+	__free_page(page);
+
+	return ret;
+}
+
 static int zram_bvec_read(struct zram *zram, struct bio_vec *bvec,
 			  u32 index, int offset)
 {
@@ -608,6 +948,12 @@ static int zram_bvec_read(struct zram *zram, struct bio_vec *bvec,
 	page = bvec->bv_page;
 
 	bit_spin_lock(ZRAM_ACCESS, &meta->table[index].value);
+	if (zram_test_flag(meta, index, ZRAM_WB)) {
+		unsigned long blk_idx = meta->table[index].handle;
+
+		bit_spin_unlock(ZRAM_ACCESS, &meta->table[index].value);
+		return zram_bvec_read_from_bdev(zram, bvec, offset, blk_idx);
+	}
 	if (unlikely(!meta->table[index].handle) ||
 			zram_test_flag(meta, index, ZRAM_ZERO)) {
 		bit_spin_unlock(ZRAM_ACCESS, &meta->table[index].value);
@@ -671,7 +1017,7 @@ static int zram_bvec_write(struct zram *zram, struct bio_vec *bvec, u32 index,
 			ret = -ENOMEM;
 			goto out;
 		}
-		ret = zram_decompress_page(zram, uncmem, index);
+		ret = zram_read_page(zram, uncmem, index);
 		if (ret)
 			goto out;
 	}
@@ -715,6 +1061,31 @@ static int zram_bvec_write(struct zram *zram, struct bio_vec *bvec, u32 index,
 	}
 	src = zstrm->buffer;
 	if (unlikely(clen > max_zpage_size)) {
+		if (zram_wb_enabled(zram) && !is_partial_io(bvec)) {
+			unsigned long blk_idx;
+
+			zcomp_strm_release(zram->comp, zstrm);
+			zstrm = NULL;
+
+			/*
+			 * The page is incompressible; push it out to the
+			 * backing device rather than spending a full
+			 * PAGE_SIZE of zsmalloc memory on it.
+			 */
+			ret = write_to_bdev(zram, bvec, &blk_idx);
+			if (ret)
+				goto out;
+
+			bit_spin_lock(ZRAM_ACCESS, &meta->table[index].value);
+			zram_free_page(zram, index);
+			zram_set_flag(meta, index, ZRAM_WB);
+			meta->table[index].handle = blk_idx;
+			bit_spin_unlock(ZRAM_ACCESS, &meta->table[index].value);
+
+			atomic64_inc(&zram->stats.pages_stored);
+			goto out;
+		}
+
 		clen = PAGE_SIZE;
 		if (is_partial_io(bvec))
 			src = uncmem;
@@ -773,6 +1144,120 @@ out:
 	return ret;
 }
 
+#ifdef CONFIG_ZRAM_WRITEBACK
+static ssize_t idle_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t len)
+{
+	struct zram *zram = dev_to_zram(dev);
+	struct zram_meta *meta;
+	unsigned long nr_pages, index;
+
+	if (!sysfs_streq(buf, "all"))
+		return -EINVAL;
+
+	down_read(&zram->init_lock);
+	if (!init_done(zram)) {
+		up_read(&zram->init_lock);
+		return -EINVAL;
+	}
+
+	meta = zram->meta;
+	nr_pages = zram->disksize >> PAGE_SHIFT;
+	for (index = 0; index < nr_pages; index++) {
+		bit_spin_lock(ZRAM_ACCESS, &meta->table[index].value);
+		if (meta->table[index].handle &&
+				!zram_test_flag(meta, index, ZRAM_WB))
+			zram_set_flag(meta, index, ZRAM_IDLE);
+		bit_spin_unlock(ZRAM_ACCESS, &meta->table[index].value);
+	}
+	up_read(&zram->init_lock);
+
+	return len;
+}
+
+static ssize_t writeback_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t len)
+{
+	struct zram *zram = dev_to_zram(dev);
+	struct zram_meta *meta;
+	unsigned long nr_pages, index, blk_idx;
+	struct bio_vec bvec;
+	struct page *page;
+	ssize_t ret = len;
+	int err;
+
+	if (!sysfs_streq(buf, "idle"))
+		return -EINVAL;
+
+	down_read(&zram->init_lock);
+	if (!init_done(zram) || !zram_wb_enabled(zram)) {
+		up_read(&zram->init_lock);
+		return -EINVAL;
+	}
+
+	page = alloc_page(GFP_KERNEL);
+	if (!page) {
+		up_read(&zram->init_lock);
+		return -ENOMEM;
+	}
+
+	meta = zram->meta;
+	nr_pages = zram->disksize >> PAGE_SHIFT;
+	for (index = 0; index < nr_pages; index++) {
+		unsigned long handle;
+
+		bit_spin_lock(ZRAM_ACCESS, &meta->table[index].value);
+		handle = meta->table[index].handle;
+		if (!handle || !zram_test_flag(meta, index, ZRAM_IDLE) ||
+				zram_test_flag(meta, index, ZRAM_WB) ||
+				zram_test_flag(meta, index, ZRAM_ZERO)) {
+			bit_spin_unlock(ZRAM_ACCESS,
+					&meta->table[index].value);
+			continue;
+		}
+		bit_spin_unlock(ZRAM_ACCESS, &meta->table[index].value);
+
+		if (zram_decompress_page(zram, page_address(page), index))
+			continue;
+
+		bvec.bv_page = page;
+		bvec.bv_len = PAGE_SIZE;
+		bvec.bv_offset = 0;
+		err = write_to_bdev(zram, &bvec, &blk_idx);
+		if (err) {
+			ret = err;
+			break;
+		}
+
+		/*
+		 * Every path that modifies or frees the slot clears
+		 * ZRAM_IDLE under the slot lock, so if it is still set
+		 * here the copy we just wrote out is current and we can
+		 * repoint the slot at the backing device.
+		 */
+		bit_spin_lock(ZRAM_ACCESS, &meta->table[index].value);
+		if (meta->table[index].handle != handle ||
+				!zram_test_flag(meta, index, ZRAM_IDLE)) {
+			bit_spin_unlock(ZRAM_ACCESS,
+					&meta->table[index].value);
+			free_block_bdev(zram, blk_idx);
+			continue;
+		}
+
+		zram_free_page(zram, index);
+		zram_set_flag(meta, index, ZRAM_WB);
+		meta->table[index].handle = blk_idx;
+		atomic64_inc(&zram->stats.pages_stored);
+		bit_spin_unlock(ZRAM_ACCESS, &meta->table[index].value);
+	}
+
+	__free_page(page);
+	up_read(&zram->init_lock);
+
+	return ret;
+}
+#endif
+
 /*
  * zram_bio_discard - handler on discard request
  * @index: physical block index in PAGE_SIZE units
@@ -818,6 +1303,12 @@ static int zram_bvec_rw(struct zram *zram, struct bio_vec *bvec, u32 index,
 	unsigned long start_time = jiffies;
 	int ret;
 
+	/*
+	 * Any access makes the slot hot again. Do this before touching it
+	 * so an in-flight writeback_store() notices and backs off.
+	 */
+	zram_clear_idle(zram, index);
+
 	generic_start_io_acct(rw, bvec->bv_len >> SECTOR_SHIFT,
 			&zram->disk->part0);
 
@@ -1017,6 +1508,7 @@ static void zram_reset_device(struct zram *zram)
 	set_capacity(zram->disk, 0);
 	part_stat_set_all(&zram->disk->part0, 0);
 
+	reset_bdev(zram);
 	up_write(&zram->init_lock);
 	/* I/O operation under all of CPU are done so let's free */
 	zram_meta_free(meta, disksize);
@@ -1158,6 +1650,11 @@ static DEVICE_ATTR_RW(mem_limit);
 static DEVICE_ATTR_RW(mem_used_max);
 static DEVICE_ATTR_RW(max_comp_streams);
 static DEVICE_ATTR_RW(comp_algorithm);
+#ifdef CONFIG_ZRAM_WRITEBACK
+static DEVICE_ATTR_RW(backing_dev);
+static DEVICE_ATTR_WO(idle);
+static DEVICE_ATTR_WO(writeback);
+#endif
 
 static struct attribute *zram_disk_attrs[] = {
 	&dev_attr_disksize.attr,
@@ -1178,6 +1675,11 @@ static struct attribute *zram_disk_attrs[] = {
 	&dev_attr_mem_used_max.attr,
 	&dev_attr_max_comp_streams.attr,
 	&dev_attr_comp_algorithm.attr,
+#ifdef CONFIG_ZRAM_WRITEBACK
+	&dev_attr_backing_dev.attr,
+	&dev_attr_idle.attr,
+	&dev_attr_writeback.attr,
+#endif
 	&dev_attr_io_stat.attr,
 	&dev_attr_mm_stat.attr,
 	NULL,
@@ -62,6 +62,8 @@ enum zram_pageflags {
 	/* Page consists entirely of zeros */
 	ZRAM_ZERO = ZRAM_FLAG_SHIFT,
 	ZRAM_ACCESS,	/* page is now accessed */
+	ZRAM_WB,	/* page is stored on the backing device */
+	ZRAM_IDLE,	/* not accessed since it was marked idle */
 
 	__NR_ZRAM_PAGEFLAGS,
 };
@@ -118,5 +120,13 @@ struct zram {
 	 * zram is claimed so open request will be failed
 	 */
 	bool claim; /* Protected by bdev->bd_mutex */
+#ifdef CONFIG_ZRAM_WRITEBACK
+	struct file *backing_dev;
+	struct block_device *bdev;
+	unsigned int old_block_size;
+	/* allocation bitmap for backing device blocks, in PAGE_SIZE units */
+	unsigned long *bitmap;
+	unsigned long nr_pages;
+#endif
 };
 #endif
@@ -260,6 +260,7 @@
 #include <linux/irq.h>
 #include <linux/syscalls.h>
 #include <linux/completion.h>
+#include <linux/topology.h>
 
 #include <asm/processor.h>
 #include <asm/uaccess.h>
@@ -475,6 +476,30 @@ static struct entropy_store nonblocking_pool = {
 					push_to_pool),
 };
 
+/*
+ * On NUMA machines every node gets its own nonblocking pool so that
+ * get_random_bytes() and urandom readers on different nodes don't
+ * serialize on one pool lock.  Each pool reseeds itself from the input
+ * pool on demand, exactly as the primary does.  The array is set up by
+ * rand_initialize() before the secondary CPUs are brought online; until
+ * (or unless) it exists, everyone shares the static pool above.
+ */
+#ifdef CONFIG_NUMA
+static struct entropy_store **nonblocking_node_pools __read_mostly;
+
+static inline struct entropy_store *nonblocking_node_pool(void)
+{
+	if (nonblocking_node_pools)
+		return nonblocking_node_pools[numa_node_id()];
+	return &nonblocking_pool;
+}
+#else
+static inline struct entropy_store *nonblocking_node_pool(void)
+{
+	return &nonblocking_pool;
+}
+#endif
+
 static __u32 const twist_table[8] = {
 	0x00000000, 0x3b6e20c8, 0x76dc4190, 0x4db26158,
 	0xedb88320, 0xd6d6a3e8, 0x9b64c2b0, 0xa00ae278 };
@@ -771,6 +796,23 @@ void add_device_randomness(const void *buf, unsigned int size)
 	_mix_pool_bytes(&nonblocking_pool, buf, size);
 	_mix_pool_bytes(&nonblocking_pool, &time, sizeof(time));
 	spin_unlock_irqrestore(&nonblocking_pool.lock, flags);
+
+#ifdef CONFIG_NUMA
+	if (nonblocking_node_pools) {
+		int i;
+
+		for_each_node(i) {
+			struct entropy_store *r = nonblocking_node_pools[i];
+
+			if (r == &nonblocking_pool)
+				continue;
+			spin_lock_irqsave(&r->lock, flags);
+			_mix_pool_bytes(r, buf, size);
+			_mix_pool_bytes(r, &time, sizeof(time));
+			spin_unlock_irqrestore(&r->lock, flags);
+		}
+	}
+#endif
 }
 EXPORT_SYMBOL(add_device_randomness);
 
@@ -1260,7 +1302,7 @@ void get_random_bytes(void *buf, int nbytes)
 		       nonblocking_pool.entropy_total);
 #endif
 	trace_get_random_bytes(nbytes, _RET_IP_);
-	extract_entropy(&nonblocking_pool, buf, nbytes, 0, 0);
+	extract_entropy(nonblocking_node_pool(), buf, nbytes, 0, 0);
 }
 EXPORT_SYMBOL(get_random_bytes);
 
@@ -1350,7 +1392,7 @@ void get_random_bytes_arch(void *buf, int nbytes)
 	}
 
 	if (nbytes)
-		extract_entropy(&nonblocking_pool, p, nbytes, 0, 0);
+		extract_entropy(nonblocking_node_pool(), p, nbytes, 0, 0);
 }
 EXPORT_SYMBOL(get_random_bytes_arch);
 
@@ -1391,11 +1433,66 @@ static void init_std_data(struct entropy_store *r)
  * take care not to overwrite the precious per platform data
  * we were given.
  */
+#ifdef CONFIG_NUMA
+/*
+ * Give every NUMA node its own nonblocking pool.  Node zero keeps the
+ * static pool, which also remains the fallback if the allocations fail.
+ * This runs before the secondary CPUs come up, so nobody can observe a
+ * half-built array.
+ */
+static void rand_initialize_node_pools(void)
+{
+	struct entropy_store **pools;
+	struct entropy_store *r;
+	int i;
+
+	if (nr_node_ids <= 1)
+		return;
+
+	pools = kcalloc(nr_node_ids, sizeof(*pools), GFP_KERNEL);
+	if (!pools)
+		return;
+
+	for_each_node(i)
+		pools[i] = &nonblocking_pool;
+
+	for_each_node(i) {
+		if (i == first_online_node)
+			continue;
+		r = kzalloc(sizeof(*r), GFP_KERNEL);
+		if (!r)
+			continue;
+		r->pool = kzalloc(OUTPUT_POOL_WORDS * sizeof(__u32),
+				  GFP_KERNEL);
+		r->name = kasprintf(GFP_KERNEL, "nonblocking/%d", i);
+		if (!r->pool || !r->name) {
+			kfree(r->pool);
+			kfree(r->name);
+			kfree(r);
+			continue;
+		}
+		r->poolinfo = &poolinfo_table[1];
+		r->pull = &input_pool;
+		spin_lock_init(&r->lock);
+		INIT_WORK(&r->push_work, push_to_pool);
+		init_std_data(r);
+		pools[i] = r;
+	}
+
+	nonblocking_node_pools = pools;
+}
+#else
+static inline void rand_initialize_node_pools(void)
+{
+}
+#endif
+
 static int rand_initialize(void)
 {
 	init_std_data(&input_pool);
 	init_std_data(&blocking_pool);
 	init_std_data(&nonblocking_pool);
+	rand_initialize_node_pools();
 	return 0;
 }
 early_initcall(rand_initialize);
@@ -1465,7 +1562,7 @@ urandom_read(struct file *file, char __user *buf, size_t nbytes, loff_t *ppos)
 			    current->comm, nonblocking_pool.entropy_total);
 
 	nbytes = min_t(size_t, nbytes, INT_MAX >> (ENTROPY_SHIFT + 3));
-	ret = extract_entropy_user(&nonblocking_pool, buf, nbytes);
+	ret = extract_entropy_user(nonblocking_node_pool(), buf, nbytes);
 
 	trace_urandom_read(8 * nbytes, ENTROPY_BITS(&nonblocking_pool),
 			   ENTROPY_BITS(&input_pool));
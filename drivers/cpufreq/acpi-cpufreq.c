@@ -458,6 +458,43 @@ static int acpi_cpufreq_target(struct cpufreq_policy *policy,
 	return result;
 }
 
+static unsigned int acpi_cpufreq_fast_switch(struct cpufreq_policy *policy,
+					     unsigned int target_freq)
+{
+	struct acpi_cpufreq_data *data = policy->driver_data;
+	struct acpi_processor_performance *perf;
+	struct cpufreq_frequency_table *entry;
+	unsigned int next_perf_state = 0, next_freq = 0;
+
+	/*
+	 * Find the lowest frequency at or above target_freq.  The table is
+	 * not guaranteed to be sorted, so scan all of it.
+	 */
+	cpufreq_for_each_valid_entry(entry, data->freq_table) {
+		if (entry->frequency >= target_freq &&
+		    (!next_freq || entry->frequency < next_freq)) {
+			next_freq = entry->frequency;
+			next_perf_state = entry->driver_data;
+		}
+	}
+	if (!next_freq)
+		return 0;
+
+	perf = to_perf_data(data);
+	if (perf->state == next_perf_state) {
+		if (unlikely(data->resume))
+			data->resume = 0;
+		else
+			return next_freq;
+	}
+
+	data->cpu_freq_write(&perf->control_register,
+			     perf->states[next_perf_state].control);
+	perf->state = next_perf_state;
+
+	return next_freq;
+}
+
 static unsigned long
 acpi_cpufreq_guess_freq(struct acpi_cpufreq_data *data, unsigned int cpu)
 {
@@ -692,6 +729,15 @@ static int acpi_cpufreq_cpu_init(struct cpufreq_policy *policy)
 	}
 #endif
 
+	/*
+	 * Switching frequencies without sleeping is only possible if the
+	 * register write on the local CPU covers the whole policy, i.e. the
+	 * policy is per-CPU or any of its CPUs may do the switch.
+	 */
+	policy->fast_switch_possible = !acpi_pstate_strict &&
+		!(policy_is_shared(policy) &&
+		  policy->shared_type != CPUFREQ_SHARED_TYPE_ANY);
+
 	/* capability check */
 	if (perf->state_count <= 1) {
 		pr_debug("No P-States\n");
@@ -874,6 +920,7 @@ static struct freq_attr *acpi_cpufreq_attr[] = {
 static struct cpufreq_driver acpi_cpufreq_driver = {
 	.verify		= cpufreq_generic_frequency_table_verify,
 	.target_index	= acpi_cpufreq_target,
+	.fast_switch	= acpi_cpufreq_fast_switch,
 	.bios_limit	= acpi_processor_get_bios_limit,
 	.init		= acpi_cpufreq_cpu_init,
 	.exit		= acpi_cpufreq_cpu_exit,
@@ -1798,6 +1798,46 @@ static int __target_index(struct cpufreq_policy *policy,
 	return retval;
 }
 
+/**
+ * cpufreq_driver_has_fast_switch - Check "fast switch" support.
+ * @policy: cpufreq policy to check.
+ *
+ * Return 'true' if frequency switches for @policy can be carried out without
+ * sleeping, which requires support from both the driver and the policy.
+ */
+bool cpufreq_driver_has_fast_switch(struct cpufreq_policy *policy)
+{
+	return policy->fast_switch_possible && cpufreq_driver->fast_switch;
+}
+EXPORT_SYMBOL_GPL(cpufreq_driver_has_fast_switch);
+
+/**
+ * cpufreq_driver_fast_switch - Carry out a fast CPU frequency switch.
+ * @policy: cpufreq policy to switch the frequency for.
+ * @target_freq: New frequency to set (may be approximate).
+ *
+ * Carry out a fast frequency switch without sleeping.  The caller must ensure
+ * that no transition notifiers are registered for @policy, as they are
+ * bypassed entirely on this path, and is responsible for checking
+ * cpufreq_driver_has_fast_switch() upfront.
+ *
+ * Returns the frequency actually set for the CPUs covered by @policy or 0 on
+ * failure, in which case the hardware configuration has not been changed.
+ */
+unsigned int cpufreq_driver_fast_switch(struct cpufreq_policy *policy,
+					unsigned int target_freq)
+{
+	unsigned int freq;
+
+	target_freq = clamp_val(target_freq, policy->min, policy->max);
+	freq = cpufreq_driver->fast_switch(policy, target_freq);
+	if (freq)
+		policy->cur = freq;
+
+	return freq;
+}
+EXPORT_SYMBOL_GPL(cpufreq_driver_fast_switch);
+
 int __cpufreq_driver_target(struct cpufreq_policy *policy,
 			    unsigned int target_freq,
 			    unsigned int relation)
@@ -69,6 +69,10 @@ static bool devices_handle_discard_safely = false;
 module_param(devices_handle_discard_safely, bool, 0644);
 MODULE_PARM_DESC(devices_handle_discard_safely,
 		 "Set to Y if all devices in each array reliably return zeroes on reads from discarded regions");
+static int group_thread_cnt;
+module_param(group_thread_cnt, int, 0444);
+MODULE_PARM_DESC(group_thread_cnt,
+		 "Default number of stripe handling threads per NUMA node group, 0 handles stripes in raid5d only");
 static struct workqueue_struct *raid5_wq;
 /*
  * Stripe cache
@@ -6502,8 +6506,9 @@ static struct r5conf *setup_conf(struct mddev *mddev)
 	conf = kzalloc(sizeof(struct r5conf), GFP_KERNEL);
 	if (conf == NULL)
 		goto abort;
-	/* Don't enable multi-threading by default*/
-	if (!alloc_thread_groups(conf, 0, &group_cnt, &worker_cnt_per_group,
+	/* Multi-threaded handling is off unless group_thread_cnt says so */
+	if (!alloc_thread_groups(conf, clamp(group_thread_cnt, 0, 64),
+				 &group_cnt, &worker_cnt_per_group,
 				 &new_group)) {
 		conf->group_cnt = group_cnt;
 		conf->worker_cnt_per_group = worker_cnt_per_group;
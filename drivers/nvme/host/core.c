@@ -913,6 +913,78 @@ static void nvme_set_queue_limits(struct nvme_ctrl *ctrl,
  * register in our nvme_ctrl structure.  This should be called as soon as
  * the admin queue is fully up and running.
  */
+static int nvme_toggle_streams(struct nvme_ctrl *ctrl, bool enable)
+{
+	struct nvme_command c;
+
+	memset(&c, 0, sizeof(c));
+
+	c.directive.opcode = nvme_admin_directive_send;
+	c.directive.nsid = cpu_to_le32(NVME_NSID_ALL);
+	c.directive.doper = NVME_DIR_SND_ID_OP_ENABLE;
+	c.directive.dtype = NVME_DIR_IDENTIFY;
+	c.directive.tdtype = NVME_DIR_STREAMS;
+	c.directive.endir = enable ? NVME_DIR_ENDIR : 0;
+
+	return nvme_submit_sync_cmd(ctrl->admin_q, &c, NULL, 0);
+}
+
+static int nvme_get_stream_params(struct nvme_ctrl *ctrl,
+				  struct nvme_streams_directive_params *s,
+				  u32 nsid)
+{
+	struct nvme_command c;
+
+	memset(&c, 0, sizeof(c));
+	memset(s, 0, sizeof(*s));
+
+	c.directive.opcode = nvme_admin_directive_recv;
+	c.directive.nsid = cpu_to_le32(nsid);
+	c.directive.numd = cpu_to_le32((sizeof(*s) >> 2) - 1);
+	c.directive.doper = NVME_DIR_RCV_ST_OP_PARAM;
+	c.directive.dtype = NVME_DIR_STREAMS;
+
+	return nvme_submit_sync_cmd(ctrl->admin_q, &c, s, sizeof(*s));
+}
+
+/*
+ * Enable NVMe 1.3 streams so that nvme_setup_rw() can translate write
+ * life time hints into stream directives, letting the device separate
+ * data with different expected lifetimes into different media units.
+ */
+static int nvme_configure_directives(struct nvme_ctrl *ctrl)
+{
+	struct nvme_streams_directive_params s;
+	int ret;
+
+	if (!(ctrl->oacs & NVME_CTRL_OACS_DIRECTIVES))
+		return 0;
+
+	ret = nvme_toggle_streams(ctrl, true);
+	if (ret)
+		return ret;
+
+	ret = nvme_get_stream_params(ctrl, &s, NVME_NSID_ALL);
+	if (ret)
+		goto out_disable_stream;
+
+	ctrl->nssa = le16_to_cpu(s.nssa);
+	if (ctrl->nssa < BLK_MAX_WRITE_HINTS - 1) {
+		dev_info(ctrl->device, "too few streams (%u) available\n",
+			 ctrl->nssa);
+		goto out_disable_stream;
+	}
+
+	ctrl->nr_streams = min_t(unsigned, ctrl->nssa,
+				 BLK_MAX_WRITE_HINTS - 1);
+	dev_info(ctrl->device, "Using %u streams\n", ctrl->nr_streams);
+	return 0;
+
+out_disable_stream:
+	nvme_toggle_streams(ctrl, false);
+	return ret;
+}
+
 int nvme_init_identify(struct nvme_ctrl *ctrl)
 {
 	struct nvme_id_ctrl *id;
@@ -942,6 +1014,7 @@ int nvme_init_identify(struct nvme_ctrl *ctrl)
 	}
 
 	ctrl->oncs = le16_to_cpup(&id->oncs);
+	ctrl->oacs = le16_to_cpup(&id->oacs);
 	atomic_set(&ctrl->abort_limit, id->acl + 1);
 	ctrl->vwc = id->vwc;
 	ctrl->cntlid = le16_to_cpup(&id->cntlid);
@@ -966,6 +1039,14 @@ int nvme_init_identify(struct nvme_ctrl *ctrl)
 		}
 	}
 
+	/*
+	 * Stream support is optional; if the directives are unusable we
+	 * simply keep issuing writes without a stream identifier.
+	 */
+	if (nvme_configure_directives(ctrl))
+		dev_warn(ctrl->device,
+			 "could not enable stream directives\n");
+
 	nvme_set_queue_limits(ctrl, ctrl->admin_q);
 
 	kfree(id);
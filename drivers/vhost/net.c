@@ -776,6 +776,12 @@ static int vhost_net_open(struct inode *inode, struct file *f)
 
 	vhost_poll_init(n->poll + VHOST_NET_VQ_TX, handle_tx_net, POLLOUT, dev);
 	vhost_poll_init(n->poll + VHOST_NET_VQ_RX, handle_rx_net, POLLIN, dev);
+	/* Socket wakeups run on the same worker as the matching ring's
+	 * kicks, so tx and rx never contend for one thread. */
+	vhost_poll_attach_vq(n->poll + VHOST_NET_VQ_TX,
+			     &n->vqs[VHOST_NET_VQ_TX].vq);
+	vhost_poll_attach_vq(n->poll + VHOST_NET_VQ_RX,
+			     &n->vqs[VHOST_NET_VQ_RX].vq);
 
 	f->private_data = n;
 
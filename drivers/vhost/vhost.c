@@ -35,6 +35,11 @@ module_param(max_mem_regions, ushort, 0444);
 MODULE_PARM_DESC(max_mem_regions,
 	"Maximum number of memory regions in memory map. (default: 64)");
 
+static bool per_vq_workers = true;
+module_param(per_vq_workers, bool, 0444);
+MODULE_PARM_DESC(per_vq_workers,
+	"Give each virtqueue its own worker thread. (default: Y)");
+
 enum {
 	VHOST_MEMORY_F_LOG = 0x1,
 };
@@ -171,12 +176,28 @@ void vhost_poll_init(struct vhost_poll *poll, vhost_work_fn_t fn,
 	init_poll_funcptr(&poll->table, vhost_poll_func);
 	poll->mask = mask;
 	poll->dev = dev;
+	poll->vq = NULL;
 	poll->wqh = NULL;
 
 	vhost_work_init(&poll->work, fn);
 }
 EXPORT_SYMBOL_GPL(vhost_poll_init);
 
+/* Tie a poll to a virtqueue: when that virtqueue has a worker of its
+ * own, the poll's work runs there instead of on the device worker. */
+void vhost_poll_attach_vq(struct vhost_poll *poll, struct vhost_virtqueue *vq)
+{
+	poll->vq = vq;
+}
+EXPORT_SYMBOL_GPL(vhost_poll_attach_vq);
+
+static struct vhost_worker *vhost_poll_worker(struct vhost_poll *poll)
+{
+	if (poll->vq && poll->vq->worker)
+		return poll->vq->worker;
+	return &poll->dev->worker;
+}
+
 /* Start polling a file. We add ourselves to file's wait queue. The caller must
  * keep a reference to a file until after vhost_poll_stop is called. */
 int vhost_poll_start(struct vhost_poll *poll, struct file *file)
@@ -211,68 +232,90 @@ void vhost_poll_stop(struct vhost_poll *poll)
 }
 EXPORT_SYMBOL_GPL(vhost_poll_stop);
 
-static bool vhost_work_seq_done(struct vhost_dev *dev, struct vhost_work *work,
-				unsigned seq)
+static bool vhost_work_seq_done(struct vhost_worker *worker,
+				struct vhost_work *work, unsigned seq)
 {
 	int left;
 
-	spin_lock_irq(&dev->work_lock);
+	spin_lock_irq(&worker->work_lock);
 	left = seq - work->done_seq;
-	spin_unlock_irq(&dev->work_lock);
+	spin_unlock_irq(&worker->work_lock);
 	return left <= 0;
 }
 
-void vhost_work_flush(struct vhost_dev *dev, struct vhost_work *work)
+static void vhost_work_flush_on(struct vhost_worker *worker,
+				struct vhost_work *work)
 {
 	unsigned seq;
 	int flushing;
 
-	spin_lock_irq(&dev->work_lock);
+	spin_lock_irq(&worker->work_lock);
 	seq = work->queue_seq;
 	work->flushing++;
-	spin_unlock_irq(&dev->work_lock);
-	wait_event(work->done, vhost_work_seq_done(dev, work, seq));
-	spin_lock_irq(&dev->work_lock);
+	spin_unlock_irq(&worker->work_lock);
+	wait_event(work->done, vhost_work_seq_done(worker, work, seq));
+	spin_lock_irq(&worker->work_lock);
 	flushing = --work->flushing;
-	spin_unlock_irq(&dev->work_lock);
+	spin_unlock_irq(&worker->work_lock);
 	BUG_ON(flushing < 0);
 }
+
+void vhost_work_flush(struct vhost_dev *dev, struct vhost_work *work)
+{
+	vhost_work_flush_on(&dev->worker, work);
+}
 EXPORT_SYMBOL_GPL(vhost_work_flush);
 
 /* Flush any work that has been scheduled. When calling this, don't hold any
  * locks that are also used by the callback. */
 void vhost_poll_flush(struct vhost_poll *poll)
 {
-	vhost_work_flush(poll->dev, &poll->work);
+	vhost_work_flush_on(vhost_poll_worker(poll), &poll->work);
 }
 EXPORT_SYMBOL_GPL(vhost_poll_flush);
 
-void vhost_work_queue(struct vhost_dev *dev, struct vhost_work *work)
+static void vhost_work_queue_on(struct vhost_worker *worker,
+				struct vhost_work *work)
 {
 	unsigned long flags;
 
-	spin_lock_irqsave(&dev->work_lock, flags);
+	spin_lock_irqsave(&worker->work_lock, flags);
 	if (list_empty(&work->node)) {
-		list_add_tail(&work->node, &dev->work_list);
+		list_add_tail(&work->node, &worker->work_list);
 		work->queue_seq++;
-		spin_unlock_irqrestore(&dev->work_lock, flags);
-		wake_up_process(dev->worker);
+		spin_unlock_irqrestore(&worker->work_lock, flags);
+		wake_up_process(worker->task);
 	} else {
-		spin_unlock_irqrestore(&dev->work_lock, flags);
+		spin_unlock_irqrestore(&worker->work_lock, flags);
 	}
 }
+
+void vhost_work_queue(struct vhost_dev *dev, struct vhost_work *work)
+{
+	vhost_work_queue_on(&dev->worker, work);
+}
 EXPORT_SYMBOL_GPL(vhost_work_queue);
 
 /* A lockless hint for busy polling code to exit the loop */
 bool vhost_has_work(struct vhost_dev *dev)
 {
-	return !list_empty(&dev->work_list);
+	int i;
+
+	if (!list_empty(&dev->worker.work_list))
+		return true;
+	for (i = 0; i < dev->nvqs; ++i) {
+		struct vhost_worker *worker = dev->vqs[i]->worker;
+
+		if (worker && !list_empty(&worker->work_list))
+			return true;
+	}
+	return false;
 }
 EXPORT_SYMBOL_GPL(vhost_has_work);
 
 void vhost_poll_queue(struct vhost_poll *poll)
 {
-	vhost_work_queue(poll->dev, &poll->work);
+	vhost_work_queue_on(vhost_poll_worker(poll), &poll->work);
 }
 EXPORT_SYMBOL_GPL(vhost_poll_queue);
 
@@ -308,7 +351,8 @@ static void vhost_vq_reset(struct vhost_dev *dev,
 
 static int vhost_worker(void *data)
 {
-	struct vhost_dev *dev = data;
+	struct vhost_worker *worker = data;
+	struct vhost_dev *dev = worker->dev;
 	struct vhost_work *work = NULL;
 	unsigned uninitialized_var(seq);
 	mm_segment_t oldfs = get_fs();
@@ -320,7 +364,7 @@ static int vhost_worker(void *data)
 		/* mb paired w/ kthread_stop */
 		set_current_state(TASK_INTERRUPTIBLE);
 
-		spin_lock_irq(&dev->work_lock);
+		spin_lock_irq(&worker->work_lock);
 		if (work) {
 			work->done_seq = seq;
 			if (work->flushing)
@@ -328,18 +372,18 @@ static int vhost_worker(void *data)
 		}
 
 		if (kthread_should_stop()) {
-			spin_unlock_irq(&dev->work_lock);
+			spin_unlock_irq(&worker->work_lock);
 			__set_current_state(TASK_RUNNING);
 			break;
 		}
-		if (!list_empty(&dev->work_list)) {
-			work = list_first_entry(&dev->work_list,
+		if (!list_empty(&worker->work_list)) {
+			work = list_first_entry(&worker->work_list,
 						struct vhost_work, node);
 			list_del_init(&work->node);
 			seq = work->queue_seq;
 		} else
 			work = NULL;
-		spin_unlock_irq(&dev->work_lock);
+		spin_unlock_irq(&worker->work_lock);
 
 		if (work) {
 			__set_current_state(TASK_RUNNING);
@@ -396,6 +440,15 @@ static void vhost_dev_free_iovecs(struct vhost_dev *dev)
 		vhost_vq_free_iovecs(dev->vqs[i]);
 }
 
+static void vhost_worker_init(struct vhost_worker *worker,
+			      struct vhost_dev *dev)
+{
+	spin_lock_init(&worker->work_lock);
+	INIT_LIST_HEAD(&worker->work_list);
+	worker->task = NULL;
+	worker->dev = dev;
+}
+
 void vhost_dev_init(struct vhost_dev *dev,
 		    struct vhost_virtqueue **vqs, int nvqs)
 {
@@ -409,9 +462,7 @@ void vhost_dev_init(struct vhost_dev *dev,
 	dev->log_file = NULL;
 	dev->memory = NULL;
 	dev->mm = NULL;
-	spin_lock_init(&dev->work_lock);
-	INIT_LIST_HEAD(&dev->work_list);
-	dev->worker = NULL;
+	vhost_worker_init(&dev->worker, dev);
 
 	for (i = 0; i < dev->nvqs; ++i) {
 		vq = dev->vqs[i];
@@ -419,11 +470,14 @@ void vhost_dev_init(struct vhost_dev *dev,
 		vq->indirect = NULL;
 		vq->heads = NULL;
 		vq->dev = dev;
+		vq->worker = NULL;
 		mutex_init(&vq->mutex);
 		vhost_vq_reset(dev, vq);
-		if (vq->handle_kick)
+		if (vq->handle_kick) {
 			vhost_poll_init(&vq->poll, vq->handle_kick,
 					POLLIN, dev);
+			vhost_poll_attach_vq(&vq->poll, vq);
+		}
 	}
 }
 EXPORT_SYMBOL_GPL(vhost_dev_init);
@@ -450,17 +504,79 @@ static void vhost_attach_cgroups_work(struct vhost_work *work)
 	s->ret = cgroup_attach_task_all(s->owner, current);
 }
 
-static int vhost_attach_cgroups(struct vhost_dev *dev)
+static int vhost_attach_cgroups(struct vhost_worker *worker)
 {
 	struct vhost_attach_cgroups_struct attach;
 
 	attach.owner = current;
 	vhost_work_init(&attach.work, vhost_attach_cgroups_work);
-	vhost_work_queue(dev, &attach.work);
-	vhost_work_flush(dev, &attach.work);
+	vhost_work_queue_on(worker, &attach.work);
+	vhost_work_flush_on(worker, &attach.work);
 	return attach.ret;
 }
 
+static void vhost_dev_destroy_vq_workers(struct vhost_dev *dev)
+{
+	int i;
+
+	for (i = 0; i < dev->nvqs; ++i) {
+		struct vhost_worker *worker = dev->vqs[i]->worker;
+
+		if (!worker)
+			continue;
+		WARN_ON(!list_empty(&worker->work_list));
+		kthread_stop(worker->task);
+		kfree(worker);
+		dev->vqs[i]->worker = NULL;
+	}
+}
+
+/* Give every virtqueue a worker thread of its own, so that a busy ring
+ * does not delay kicks for the others behind a single thread.  Each
+ * thread runs under the owner's mm and cgroups like the device worker,
+ * so accounting and cpuset placement are unchanged. */
+static int vhost_dev_create_vq_workers(struct vhost_dev *dev)
+{
+	struct task_struct *task;
+	int err, i;
+
+	for (i = 0; i < dev->nvqs; ++i) {
+		struct vhost_virtqueue *vq = dev->vqs[i];
+		struct vhost_worker *worker;
+
+		if (!vq->handle_kick)
+			continue;
+
+		worker = kmalloc(sizeof(*worker), GFP_KERNEL);
+		if (!worker) {
+			err = -ENOMEM;
+			goto err;
+		}
+		vhost_worker_init(worker, dev);
+		task = kthread_create(vhost_worker, worker, "vhost-%d.%d",
+				      current->pid, i);
+		if (IS_ERR(task)) {
+			err = PTR_ERR(task);
+			kfree(worker);
+			goto err;
+		}
+		worker->task = task;
+		wake_up_process(task);	/* avoid contributing to loadavg */
+
+		err = vhost_attach_cgroups(worker);
+		if (err) {
+			kthread_stop(task);
+			kfree(worker);
+			goto err;
+		}
+		vq->worker = worker;
+	}
+	return 0;
+err:
+	vhost_dev_destroy_vq_workers(dev);
+	return err;
+}
+
 /* Caller should have device mutex */
 bool vhost_dev_has_owner(struct vhost_dev *dev)
 {
@@ -471,7 +587,7 @@ EXPORT_SYMBOL_GPL(vhost_dev_has_owner);
 /* Caller should have device mutex */
 long vhost_dev_set_owner(struct vhost_dev *dev)
 {
-	struct task_struct *worker;
+	struct task_struct *task;
 	int err;
 
 	/* Is there an owner already? */
@@ -482,27 +598,36 @@ long vhost_dev_set_owner(struct vhost_dev *dev)
 
 	/* No owner, become one */
 	dev->mm = get_task_mm(current);
-	worker = kthread_create(vhost_worker, dev, "vhost-%d", current->pid);
-	if (IS_ERR(worker)) {
-		err = PTR_ERR(worker);
+	task = kthread_create(vhost_worker, &dev->worker, "vhost-%d",
+			      current->pid);
+	if (IS_ERR(task)) {
+		err = PTR_ERR(task);
 		goto err_worker;
 	}
 
-	dev->worker = worker;
-	wake_up_process(worker);	/* avoid contributing to loadavg */
+	dev->worker.task = task;
+	wake_up_process(task);	/* avoid contributing to loadavg */
 
-	err = vhost_attach_cgroups(dev);
+	err = vhost_attach_cgroups(&dev->worker);
 	if (err)
 		goto err_cgroup;
 
+	if (per_vq_workers && dev->nvqs > 1) {
+		err = vhost_dev_create_vq_workers(dev);
+		if (err)
+			goto err_cgroup;
+	}
+
 	err = vhost_dev_alloc_iovecs(dev);
 	if (err)
-		goto err_cgroup;
+		goto err_iovecs;
 
 	return 0;
+err_iovecs:
+	vhost_dev_destroy_vq_workers(dev);
 err_cgroup:
-	kthread_stop(worker);
-	dev->worker = NULL;
+	kthread_stop(task);
+	dev->worker.task = NULL;
 err_worker:
 	if (dev->mm)
 		mmput(dev->mm);
@@ -577,10 +702,11 @@ void vhost_dev_cleanup(struct vhost_dev *dev, bool locked)
 	/* No one will access memory at this point */
 	kvfree(dev->memory);
 	dev->memory = NULL;
-	WARN_ON(!list_empty(&dev->work_list));
-	if (dev->worker) {
-		kthread_stop(dev->worker);
-		dev->worker = NULL;
+	vhost_dev_destroy_vq_workers(dev);
+	WARN_ON(!list_empty(&dev->worker.work_list));
+	if (dev->worker.task) {
+		kthread_stop(dev->worker.task);
+		dev->worker.task = NULL;
 	}
 	if (dev->mm)
 		mmput(dev->mm);
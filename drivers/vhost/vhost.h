@@ -13,6 +13,7 @@
 #include <linux/atomic.h>
 
 struct vhost_work;
+struct vhost_virtqueue;
 typedef void (*vhost_work_fn_t)(struct vhost_work *work);
 
 struct vhost_work {
@@ -24,6 +25,17 @@ struct vhost_work {
 	unsigned		  done_seq;
 };
 
+/* A kthread servicing a work list.  Every device has one for works that
+ * are not tied to a particular virtqueue; in addition each virtqueue
+ * may get a worker of its own so that rings do not serialize behind
+ * each other on a single thread. */
+struct vhost_worker {
+	struct list_head	  work_list;
+	spinlock_t		  work_lock;
+	struct task_struct	 *task;
+	struct vhost_dev	 *dev;
+};
+
 /* Poll a file (eventfd or socket) */
 /* Note: there's nothing vhost specific about this structure. */
 struct vhost_poll {
@@ -33,6 +45,8 @@ struct vhost_poll {
 	struct vhost_work	  work;
 	unsigned long		  mask;
 	struct vhost_dev	 *dev;
+	/* Runs the work on this virtqueue's worker when set. */
+	struct vhost_virtqueue	 *vq;
 };
 
 void vhost_work_init(struct vhost_work *work, vhost_work_fn_t fn);
@@ -41,6 +55,7 @@ bool vhost_has_work(struct vhost_dev *dev);
 
 void vhost_poll_init(struct vhost_poll *poll, vhost_work_fn_t fn,
 		     unsigned long mask, struct vhost_dev *dev);
+void vhost_poll_attach_vq(struct vhost_poll *poll, struct vhost_virtqueue *vq);
 int vhost_poll_start(struct vhost_poll *poll, struct file *file);
 void vhost_poll_stop(struct vhost_poll *poll);
 void vhost_poll_flush(struct vhost_poll *poll);
@@ -72,6 +87,9 @@ struct vhost_virtqueue {
 
 	struct vhost_poll poll;
 
+	/* Dedicated worker for this ring, NULL to use the device one. */
+	struct vhost_worker *worker;
+
 	/* The routine to call when the Guest pings us, or timeout. */
 	vhost_work_fn_t handle_kick;
 
@@ -126,9 +144,7 @@ struct vhost_dev {
 	int nvqs;
 	struct file *log_file;
 	struct eventfd_ctx *log_ctx;
-	spinlock_t work_lock;
-	struct list_head work_list;
-	struct task_struct *worker;
+	struct vhost_worker worker;
 };
 
 void vhost_dev_init(struct vhost_dev *, struct vhost_virtqueue **vqs, int nvqs);
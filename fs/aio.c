@@ -44,6 +44,7 @@
 #include <linux/fs_struct.h>
 #include <linux/fsnotify.h>
 #include <linux/namei.h>
+#include <linux/kthread.h>
 #include <../mm/internal.h>
 
 #include <asm/kmap_types.h>
@@ -161,6 +162,9 @@ struct kioctx {
 
 	unsigned		id;
 	struct mm_struct	*mm;
+
+	/* a submission-ring poller is active; at most one per context */
+	unsigned long		sq_ring_busy;
 };
 
 struct aio_kiocb;
@@ -185,6 +189,8 @@ typedef void (*aio_destruct_fn_t)(struct aio_kiocb *iocb);
 #define AIO_THREAD_NEED_FILES	0x0004	/* Need aio_kiocb->ki_files */
 #define AIO_THREAD_NEED_CRED	0x0008	/* Need aio_kiocb->ki_cred */
 #define AIO_THREAD_NEED_MM	0x0010	/* Need the mm context */
+#define AIO_THREAD_SERIALIZE	0x0020	/* Serialize against same file */
+#define AIO_THREAD_DEDICATED	0x0040	/* Own kthread, not a pool slot */
 
 struct aio_kiocb {
 	struct kiocb		common;
@@ -217,7 +223,7 @@ struct aio_kiocb {
 	unsigned long		ki_rlimit_fsize;
 	unsigned		ki_thread_flags;	/* AIO_THREAD_NEED... */
 	aio_thread_work_fn_t	ki_work_fn;
-	struct work_struct	ki_work;
+	struct kthread_pool_work ki_work;
 	struct fs_struct	*ki_fs;
 	struct files_struct	*ki_files;
 	const struct cred	*ki_cred;
@@ -1484,6 +1490,21 @@ static int aio_setup_vectored_rw(int rw, char __user *buf, size_t len,
 }
 
 #if IS_ENABLED(CONFIG_AIO_THREAD)
+/* Worker pool backing threaded aio.  Writes to a given file are queued
+ * with the file as serialization key so they retain submission order;
+ * everything else runs unordered on the submitter's node.
+ */
+static struct kthread_pool *aio_pool;
+
+static int __init aio_thread_setup(void)
+{
+	aio_pool = kthread_pool_create("aio", 4 * num_online_cpus());
+	if (!aio_pool)
+		panic("Failed to create aio thread pool.");
+	return 0;
+}
+__initcall(aio_thread_setup);
+
 /* aio_thread_queue_iocb_cancel_early:
  *	Early stage cancellation helper function for threaded aios.  This
  *	is used prior to the iocb being assigned to a worker thread.
@@ -1513,7 +1534,7 @@ static int aio_thread_queue_iocb_cancel(struct kiocb *kiocb)
  *	Entry point for worker to perform threaded aio.  Handles issues
  *	arising due to cancellation using signals.
  */
-static void aio_thread_fn(struct work_struct *work)
+static void aio_thread_fn(struct kthread_pool_work *work)
 {
 	struct aio_kiocb *iocb = container_of(work, struct aio_kiocb, ki_work);
 	struct files_struct *old_files = current->files;
@@ -1579,6 +1600,14 @@ static void aio_thread_fn(struct work_struct *work)
 	}
 }
 
+static int aio_dedicated_thread_fn(void *data)
+{
+	struct aio_kiocb *iocb = data;
+
+	aio_thread_fn(&iocb->ki_work);
+	return 0;
+}
+
 /* aio_thread_queue_iocb
  *	Queues an aio_kiocb for dispatch to a worker thread.  Prepares the
  *	aio_kiocb for cancellation.  The caller must provide a function to
@@ -1589,9 +1618,24 @@ static ssize_t aio_thread_queue_iocb(struct aio_kiocb *iocb,
 				     aio_thread_work_fn_t work_fn,
 				     unsigned flags)
 {
+	struct task_struct *tsk = NULL;
+
 	if (!aio_may_use_threads())
 		return -EINVAL;
-	INIT_WORK(&iocb->ki_work, aio_thread_fn);
+
+	/* A perpetual operation parked on the pool would pin one of its
+	 * bounded worker slots forever, and enough of them would starve
+	 * every short-lived op in the system out of workers.  Give such
+	 * operations a thread of their own; created first so that failure
+	 * needs no unwinding of the references taken below.
+	 */
+	if (flags & AIO_THREAD_DEDICATED) {
+		tsk = kthread_create(aio_dedicated_thread_fn, iocb,
+				     "aio-sq/%d", task_pid_nr(current));
+		if (IS_ERR(tsk))
+			return PTR_ERR(tsk);
+	}
+
 	iocb->ki_thread_flags = flags;
 	iocb->ki_work_fn = work_fn;
 	if (flags & AIO_THREAD_NEED_TASK) {
@@ -1620,7 +1664,15 @@ static ssize_t aio_thread_queue_iocb(struct aio_kiocb *iocb,
 	 * ki_cancel.
 	 */
 	kiocb_set_cancel_fn(&iocb->common, aio_thread_queue_iocb_cancel_early);
-	queue_work(system_long_wq, &iocb->ki_work);
+	if (tsk)
+		wake_up_process(tsk);
+	else if (flags & AIO_THREAD_SERIALIZE)
+		queue_kthread_pool_work_hashed(aio_pool, &iocb->ki_work,
+					       aio_thread_fn,
+					       iocb->common.ki_filp);
+	else
+		queue_kthread_pool_work(aio_pool, &iocb->ki_work,
+					aio_thread_fn);
 	return -EIOCBQUEUED;
 }
 
@@ -1715,7 +1767,8 @@ ssize_t generic_async_write_iter(struct kiocb *iocb, struct iov_iter *iter)
 	req->ki_rlimit_fsize = rlimit(RLIMIT_FSIZE);
 
 	return aio_thread_queue_iocb(req, aio_thread_op_write_iter,
-				     AIO_THREAD_NEED_TASK | AIO_THREAD_NEED_MM);
+				     AIO_THREAD_NEED_TASK | AIO_THREAD_NEED_MM |
+				     AIO_THREAD_SERIALIZE);
 }
 EXPORT_SYMBOL(generic_async_write_iter);
 
@@ -2080,6 +2133,113 @@ static long aio_rename(struct aio_kiocb *iocb, struct iocb *user_iocb, bool c)
 				     AIO_THREAD_NEED_FILES |
 				     AIO_THREAD_NEED_CRED);
 }
+
+static int io_submit_one(struct kioctx *ctx, struct iocb __user *user_iocb,
+			 struct iocb *iocb, bool compat);
+
+/* Cap on the slot count of a submission ring. */
+#define AIO_SQ_RING_MAX_NR	4096
+
+/* Empty polls of the ring before the worker dozes off for a jiffy. */
+#define AIO_SQ_RING_SPINS	128
+
+static long aio_thread_op_sq_ring(struct aio_kiocb *iocb)
+{
+	struct aio_sq_ring __user *ring = (void __user *)iocb->ki_data;
+	bool compat = iocb->ki_data2;
+	struct iocb __user *iocbs;
+	unsigned int head, tail, nr;
+	unsigned int spins = 0;
+	u32 flags;
+	u64 uptr;
+	long ret;
+
+	if (get_user(nr, &ring->nr) || get_user(uptr, &ring->iocbs) ||
+	    get_user(head, &ring->head))
+		return -EFAULT;
+	if (!nr || nr > AIO_SQ_RING_MAX_NR)
+		return -EINVAL;
+	iocbs = (struct iocb __user *)(unsigned long)uptr;
+
+	for (;;) {
+		if (signal_pending(current))
+			return -EINTR;
+		if (get_user(flags, &ring->flags))
+			return -EFAULT;
+		if (flags & AIO_SQ_RING_STOP)
+			return 0;
+		if (get_user(tail, &ring->tail))
+			return -EFAULT;
+		if (head != tail) {
+			struct iocb __user *user_iocb = iocbs + (head % nr);
+			struct iocb tmp;
+
+			/* The producer fills the slot before bumping tail;
+			 * pair with its write barrier before reading it.
+			 */
+			smp_rmb();
+			if (copy_from_user(&tmp, user_iocb, sizeof(tmp)))
+				return -EFAULT;
+			ret = io_submit_one(iocb->ki_ctx, user_iocb, &tmp,
+					    compat);
+			if (!ret) {
+				head++;
+				if (put_user(head, &ring->head))
+					return -EFAULT;
+				spins = 0;
+				continue;
+			}
+			/* No completion ring space: leave the entry in
+			 * place and retry after a pause.  Anything else
+			 * retires the ring so userspace can inspect the
+			 * offending slot at head.
+			 */
+			if (ret != -EAGAIN)
+				return ret;
+		}
+		if (++spins < AIO_SQ_RING_SPINS) {
+			cond_resched();
+			continue;
+		}
+		__set_current_state(TASK_INTERRUPTIBLE);
+		schedule_timeout(1);
+		spins = 0;
+	}
+}
+
+static void aio_sq_ring_destruct(struct aio_kiocb *iocb)
+{
+	clear_bit(0, &iocb->ki_ctx->sq_ring_busy);
+}
+
+static long aio_sq_ring(struct aio_kiocb *req, struct iocb *uiocb, bool compat)
+{
+	if (uiocb->aio_fildes || uiocb->aio_offset || uiocb->aio_reqprio)
+		return -EINVAL;
+	if (uiocb->aio_nbytes != sizeof(struct aio_sq_ring))
+		return -EINVAL;
+	if (!access_ok(VERIFY_WRITE,
+		       (void __user *)(unsigned long)uiocb->aio_buf,
+		       sizeof(struct aio_sq_ring)))
+		return -EFAULT;
+
+	/* One poller (and thus one dedicated thread) per context; the bit
+	 * is released by kiocb_free() once the ring retires.
+	 */
+	if (test_and_set_bit(0, &req->ki_ctx->sq_ring_busy))
+		return -EBUSY;
+	req->ki_destruct_fn = aio_sq_ring_destruct;
+
+	req->ki_data = (unsigned long)uiocb->aio_buf;
+	req->ki_data2 = compat;
+	return aio_thread_queue_iocb(req, aio_thread_op_sq_ring,
+				     AIO_THREAD_NEED_TASK |
+				     AIO_THREAD_NEED_MM |
+				     AIO_THREAD_NEED_FS |
+				     AIO_THREAD_NEED_FILES |
+				     AIO_THREAD_NEED_CRED |
+				     AIO_THREAD_DEDICATED);
+}
 #endif /* IS_ENABLED(CONFIG_AIO_THREAD) */
 
 long aio_fsync(struct aio_kiocb *req, struct iocb *user_iocb, bool compat)
@@ -2205,6 +2365,7 @@ static const struct submit_info aio_submit_info[] = {
 	[IOCB_CMD_UNLINKAT]	= { aio_unlink,	0 },
 	[IOCB_CMD_READAHEAD]	= { aio_ra,	NEED_FD },
 	[IOCB_CMD_RENAMEAT]	= { aio_rename,	0 },
+	[IOCB_CMD_SQ_RING]	= { aio_sq_ring, 0 },
 #endif
 };
 
@@ -370,6 +370,40 @@ static unsigned long elf_map(struct file *filep, unsigned long addr,
 
 #endif /* !elf_map */
 
+/*
+ * Opt-in exec-time cache warming, fs.elf_exec_readahead. Demand paging
+ * faults executable text in page by page, which on cold caches costs a
+ * major fault plus a small read per page -- tens of milliseconds before
+ * main() for a large binary. When enabled, queue readahead for a whole
+ * PT_LOAD segment as soon as it is mapped, so the file pages stream in
+ * while the loader is still relocating. The page cache itself serves as
+ * the persistent hint: __do_page_cache_readahead() skips pages that are
+ * already resident, so repeat execs of a warm binary only do a cheap
+ * radix-tree walk. The knob itself lives in fs/exec.c because this file
+ * is built a second time for compat binaries.
+ */
+static void elf_readahead_segment(struct file *file, struct elf_phdr *eppnt)
+{
+	struct address_space *mapping;
+	pgoff_t first, last;
+
+	if (!sysctl_elf_exec_readahead)
+		return;
+
+	mapping = file->f_mapping;
+	if (!eppnt->p_filesz || !mapping->a_ops->readpage)
+		return;
+
+	first = eppnt->p_offset >> PAGE_SHIFT;
+	last = (eppnt->p_offset + eppnt->p_filesz - 1) >> PAGE_SHIFT;
+
+	/* Fully cached already -- don't bother walking the segment. */
+	if (mapping->nrpages >= i_size_read(file_inode(file)) >> PAGE_SHIFT)
+		return;
+
+	force_page_cache_readahead(mapping, file, first, last - first + 1);
+}
+
 static unsigned long total_mapping_size(struct elf_phdr *cmds, int nr)
 {
 	int i, first_idx = -1, last_idx = -1;
@@ -574,6 +608,8 @@ static unsigned long load_elf_interp(struct elfhdr *interp_elf_ex,
 			if (BAD_ADDR(map_addr))
 				goto out;
 
+			elf_readahead_segment(interpreter, eppnt);
+
 			if (!load_addr_set &&
 			    interp_elf_ex->e_type == ET_DYN) {
 				load_addr = map_addr - ELF_PAGESTART(vaddr);
@@ -936,6 +972,8 @@ static int load_elf_binary(struct linux_binprm *bprm)
 			goto out_free_dentry;
 		}
 
+		elf_readahead_segment(bprm->file, elf_ppnt);
+
 		if (!load_addr_set) {
 			load_addr_set = 1;
 			load_addr = (elf_ppnt->p_vaddr - elf_ppnt->p_offset);
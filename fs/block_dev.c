@@ -13,6 +13,7 @@
 #include <linux/major.h>
 #include <linux/device_cgroup.h>
 #include <linux/highmem.h>
+#include <linux/mman.h>
 #include <linux/blkdev.h>
 #include <linux/backing-dev.h>
 #include <linux/module.h>
@@ -1776,6 +1777,10 @@ static int blkdev_mmap(struct file *file, struct vm_area_struct *vma)
 {
 	struct inode *bd_inode = bdev_file_inode(file);
 
+	/* Synchronous page faults can only be honored on DAX mappings */
+	if ((vma->vm_flags & VM_SYNC) && !IS_DAX(bd_inode))
+		return -EOPNOTSUPP;
+
 	file_accessed(file);
 	if (IS_DAX(bd_inode)) {
 		vma->vm_ops = &blkdev_dax_vm_ops;
@@ -1797,6 +1802,10 @@ const struct file_operations def_blk_fops = {
 	.read_iter	= blkdev_read_iter,
 	.write_iter	= blkdev_write_iter,
 	.mmap		= blkdev_mmap,
+#ifdef CONFIG_FS_DAX
+	.mmap_supported_flags = MAP_SYNC,
+#endif
+	.get_unmapped_area = dax_get_unmapped_area,
 	.fsync		= blkdev_fsync,
 	.unlocked_ioctl	= block_ioctl,
 #ifdef CONFIG_COMPAT
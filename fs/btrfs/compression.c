@@ -32,6 +32,8 @@
 #include <linux/writeback.h>
 #include <linux/bit_spinlock.h>
 #include <linux/slab.h>
+#include <linux/sort.h>
+#include <linux/log2.h>
 #include "ctree.h"
 #include "disk-io.h"
 #include "transaction.h"
@@ -1090,3 +1092,196 @@ void btrfs_clear_biovec_end(struct bio_vec *bvec, int vcnt,
 		pg_offset = 0;
 	}
 }
+
+/*
+ * Heuristic for deciding whether a range is worth handing to the compression
+ * code at all. Compressing a 128k extent of already compressed data (media
+ * files, encrypted data, ...) burns a full zlib/lzo pass just to find out the
+ * result is barely smaller than the input. Instead we read a sparse sample of
+ * the range and look at the byte value distribution, which is orders of
+ * magnitude cheaper than compressing it.
+ *
+ * The following heuristics are applied to the sample, in order:
+ *
+ * 1. A small set of distinct byte values compresses well no matter how the
+ *    values are distributed - accept.
+ * 2. If a small group of byte values makes up almost all of the sample the
+ *    data is heavily skewed and will encode well - accept. If even the
+ *    90th percentile needs most of the possible byte values, the data looks
+ *    uniform - reject.
+ * 3. Otherwise estimate the Shannon entropy of the sample and reject only
+ *    clearly high entropy data.
+ *
+ * Returns 1 if the range should be compressed, 0 if it is a waste of time.
+ */
+
+/* Read 16 bytes every 256 bytes of the range */
+#define SAMPLING_READ_SIZE	16
+#define SAMPLING_INTERVAL	256
+
+/* One bucket for each possible byte value */
+#define BUCKET_SIZE		256
+
+/*
+ * The compression code processes at most 128k at a time, so sampling more
+ * than that tells us nothing about what the compressor will see. This bounds
+ * the sample buffer at 8k.
+ */
+#define MAX_SAMPLE_SIZE		(128 * 1024 * \
+				 SAMPLING_READ_SIZE / SAMPLING_INTERVAL)
+
+/* Fewer distinct byte values than this always encodes well */
+#define BYTE_SET_THRESHOLD	64
+
+/* Bounds for the number of byte values covering 90% of the sample */
+#define BYTE_CORE_SET_LOW	BYTE_SET_THRESHOLD
+#define BYTE_CORE_SET_HIGH	200
+
+/* Entropy estimate above this (in percent of maximum) is a lost cause */
+#define ENTROPY_LVL_HIGH	80
+
+struct heuristic_bucket {
+	u32 count;
+};
+
+static int heuristic_bucket_cmp(const void *lv, const void *rv)
+{
+	const struct heuristic_bucket *l = lv;
+	const struct heuristic_bucket *r = rv;
+
+	return r->count - l->count;
+}
+
+/*
+ * ilog2() with 4 bits of fixed point precision, good enough to separate
+ * text-like data from random data in the entropy calculation below.
+ */
+static inline u32 ilog2_w(u64 n)
+{
+	return ilog2(n * n * n * n);
+}
+
+/*
+ * Shannon entropy of the sorted bucket counts, scaled to a percentage of the
+ * maximum possible entropy (8 bits per byte).
+ */
+static u32 shannon_entropy(struct heuristic_bucket *bucket, u32 sample_size)
+{
+	const u32 entropy_max = 8 * ilog2_w(2);
+	u32 entropy_sum = 0;
+	u32 p, p_base, sz_base;
+	u32 i;
+
+	sz_base = ilog2_w(sample_size);
+	for (i = 0; i < BUCKET_SIZE && bucket[i].count > 0; i++) {
+		p = bucket[i].count;
+		p_base = ilog2_w(p);
+		entropy_sum += p * (sz_base - p_base);
+	}
+
+	entropy_sum /= sample_size;
+	return entropy_sum * 100 / entropy_max;
+}
+
+static u32 heuristic_collect_sample(struct inode *inode, u64 start, u64 end,
+				    u8 *sample)
+{
+	struct page *page;
+	u64 index, index_end;
+	u32 i, curr_sample_pos;
+	u8 *in_data;
+
+	/*
+	 * Compression handles the input in chunks of 128k, sampling further
+	 * only dilutes the result.
+	 */
+	if (end - start > 128 * 1024)
+		end = start + 128 * 1024;
+
+	index = start >> PAGE_CACHE_SHIFT;
+	index_end = end >> PAGE_CACHE_SHIFT;
+
+	/* Don't miss unaligned end */
+	if (!IS_ALIGNED(end, PAGE_CACHE_SIZE))
+		index_end++;
+
+	curr_sample_pos = 0;
+	while (index < index_end) {
+		page = find_get_page(inode->i_mapping, index);
+		in_data = kmap(page);
+		/* Handle case where the start is not aligned to PAGE_CACHE_SIZE */
+		i = start % PAGE_CACHE_SIZE;
+		while (i < PAGE_CACHE_SIZE - SAMPLING_READ_SIZE) {
+			/* Don't sample any garbage from the last page */
+			if (start > end - SAMPLING_READ_SIZE)
+				break;
+			memcpy(&sample[curr_sample_pos], &in_data[i],
+			       SAMPLING_READ_SIZE);
+			i += SAMPLING_INTERVAL;
+			start += SAMPLING_INTERVAL;
+			curr_sample_pos += SAMPLING_READ_SIZE;
+		}
+		kunmap(page);
+		page_cache_release(page);
+
+		index++;
+	}
+
+	return curr_sample_pos;
+}
+
+int btrfs_compress_heuristic(struct inode *inode, u64 start, u64 end)
+{
+	struct heuristic_bucket *bucket = NULL;
+	u8 *sample = NULL;
+	u32 sample_size, byte_set_size, core_set_size, coverage, entropy;
+	u32 i;
+	int ret = 1;
+
+	/*
+	 * We run from the writeback path, so if the allocations fail just
+	 * assume the range is compressible rather than error out.
+	 */
+	sample = kmalloc(MAX_SAMPLE_SIZE, GFP_NOFS);
+	bucket = kcalloc(BUCKET_SIZE, sizeof(*bucket), GFP_NOFS);
+	if (!sample || !bucket)
+		goto out;
+
+	sample_size = heuristic_collect_sample(inode, start, end, sample);
+	if (sample_size < SAMPLING_READ_SIZE)
+		goto out;
+
+	for (i = 0; i < sample_size; i++)
+		bucket[sample[i]].count++;
+
+	byte_set_size = 0;
+	for (i = 0; i < BUCKET_SIZE; i++) {
+		if (bucket[i].count)
+			byte_set_size++;
+	}
+	if (byte_set_size < BYTE_SET_THRESHOLD)
+		goto out;
+
+	sort(bucket, BUCKET_SIZE, sizeof(*bucket), heuristic_bucket_cmp, NULL);
+
+	coverage = 0;
+	core_set_size = 0;
+	for (i = 0; i < BUCKET_SIZE && coverage < sample_size * 90 / 100; i++) {
+		coverage += bucket[i].count;
+		core_set_size++;
+	}
+	if (core_set_size <= BYTE_CORE_SET_LOW)
+		goto out;
+	if (core_set_size >= BYTE_CORE_SET_HIGH) {
+		ret = 0;
+		goto out;
+	}
+
+	entropy = shannon_entropy(bucket, sample_size);
+	if (entropy > ENTROPY_LVL_HIGH)
+		ret = 0;
+out:
+	kfree(bucket);
+	kfree(sample);
+	return ret;
+}
@@ -598,6 +598,34 @@ static int dax_insert_mapping(struct inode *inode, struct buffer_head *bh,
 	return error;
 }
 
+/**
+ * dax_sync_fault_metadata - make fault metadata durable for VM_SYNC vmas
+ * @vma: the vma the write fault happened in
+ * @pgoff: page offset of the start of the faulted range
+ * @size: length of the faulted range in bytes
+ *
+ * A MAP_SYNC mapping promises that once a write fault has completed, a
+ * CPU cache flush and a store fence are enough to make the written data
+ * durable: no unflushed block allocation or unwritten extent conversion
+ * may stand between the mapped address and the media. Enforce that by
+ * syncing the faulted range before the fault returns. We do this on
+ * every write fault rather than only on allocating ones because the
+ * faulted block may have been allocated by an earlier, not yet synced
+ * write(2).
+ *
+ * Returns 0 on success or when the vma does not need synchronous faults.
+ */
+static int dax_sync_fault_metadata(struct vm_area_struct *vma, pgoff_t pgoff,
+				   size_t size)
+{
+	loff_t start = (loff_t)pgoff << PAGE_SHIFT;
+
+	if (!(vma->vm_flags & VM_SYNC))
+		return 0;
+
+	return vfs_fsync_range(vma->vm_file, start, start + size - 1, 1);
+}
+
 /**
  * __dax_fault - handle a page fault on a DAX file
  * @vma: The virtual memory area where the fault occurred
@@ -736,6 +764,9 @@ int __dax_fault(struct vm_area_struct *vma, struct vm_fault *vmf,
 			WARN_ON_ONCE(!(vmf->flags & FAULT_FLAG_WRITE));
 	}
 
+	if (!error && (vmf->flags & FAULT_FLAG_WRITE))
+		error = dax_sync_fault_metadata(vma, vmf->pgoff, PAGE_SIZE);
+
  out:
 	if (error == -ENOMEM)
 		return VM_FAULT_OOM | major;
@@ -1014,6 +1045,10 @@ int __dax_pmd_fault(struct vm_area_struct *vma, unsigned long address,
 	if (buffer_unwritten(&bh))
 		complete_unwritten(&bh, !(result & VM_FAULT_ERROR));
 
+	if (write && !(result & (VM_FAULT_ERROR | VM_FAULT_FALLBACK)) &&
+	    dax_sync_fault_metadata(vma, pgoff, PMD_SIZE))
+		result = VM_FAULT_SIGBUS;
+
 	return result;
 
  fallback:
@@ -1051,6 +1086,60 @@ int dax_pmd_fault(struct vm_area_struct *vma, unsigned long address,
 	return result;
 }
 EXPORT_SYMBOL_GPL(dax_pmd_fault);
+
+/**
+ * dax_get_unmapped_area - find a PMD-aligned area for a DAX file mapping
+ * @filp: The file being mapped
+ * @addr: Address hint from userspace, 0 if none was given
+ * @len: The length of the mapping
+ * @pgoff: The page offset of the mapping within the file
+ * @flags: The mmap flags
+ *
+ * __dax_pmd_fault() can only install a PMD if the virtual address of the
+ * fault and the file offset have the same alignment within a 2MB region,
+ * which an unhinted mmap() almost never provides. Over-allocate by one
+ * PMD and shift the start so that the mapping's offset colour matches
+ * the file's, letting PMD faults actually happen instead of falling
+ * back to PTEs.
+ *
+ * Filesystems can use this directly as ->get_unmapped_area for files
+ * that may be in DAX mode; non-DAX inodes and requests that cannot
+ * benefit take the regular architecture path.
+ */
+unsigned long dax_get_unmapped_area(struct file *filp, unsigned long addr,
+		unsigned long len, unsigned long pgoff, unsigned long flags)
+{
+	unsigned long off, off_end, off_align, len_align, addr_align;
+
+	if (!IS_ENABLED(CONFIG_FS_DAX_PMD))
+		goto out;
+
+	/* An explicit address hint takes precedence over alignment */
+	if (addr || !IS_DAX(file_inode(filp)))
+		goto out;
+
+	off = pgoff << PAGE_SHIFT;
+	off_end = off + len;
+	off_align = round_up(off, PMD_SIZE);
+
+	/* The mapping must contain at least one full, aligned PMD */
+	if ((off_end <= off_align) || ((off_end - off_align) < PMD_SIZE))
+		goto out;
+
+	len_align = len + PMD_SIZE;
+	if ((off + len_align) < off)
+		goto out;
+
+	addr_align = current->mm->get_unmapped_area(filp, addr, len_align,
+						    pgoff, flags);
+	if (!IS_ERR_VALUE(addr_align)) {
+		addr_align += (off - addr_align) & (PMD_SIZE - 1);
+		return addr_align;
+	}
+out:
+	return current->mm->get_unmapped_area(filp, addr, len, pgoff, flags);
+}
+EXPORT_SYMBOL_GPL(dax_get_unmapped_area);
 #endif /* CONFIG_TRANSPARENT_HUGEPAGE */
 
 /**
@@ -1078,6 +1167,15 @@ int dax_pfn_mkwrite(struct vm_area_struct *vma, struct vm_fault *vmf)
 		return VM_FAULT_OOM;
 	if (error)
 		return VM_FAULT_SIGBUS;
+
+	/*
+	 * The block backing this pte may have been allocated by a write(2)
+	 * whose metadata was never synced, so a VM_SYNC mapping must flush
+	 * it before write access is granted.
+	 */
+	if (dax_sync_fault_metadata(vma, vmf->pgoff, PAGE_SIZE))
+		return VM_FAULT_SIGBUS;
+
 	return VM_FAULT_NOPAGE;
 }
 EXPORT_SYMBOL_GPL(dax_pfn_mkwrite);
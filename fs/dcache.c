@@ -118,6 +118,14 @@ struct dentry_stat_t dentry_stat = {
 
 static DEFINE_PER_CPU(long, nr_dentry);
 static DEFINE_PER_CPU(long, nr_dentry_unused);
+static DEFINE_PER_CPU(long, nr_dentry_negative);
+
+/*
+ * Ceiling on the number of negative dentries a single superblock may
+ * accumulate before dput() starts pruning them from the LRU.  Zero
+ * (the default) means unlimited, which matches the old behaviour.
+ */
+unsigned long sysctl_negative_dentry_limit __read_mostly;
 
 #if defined(CONFIG_SYSCTL) && defined(CONFIG_PROC_FS)
 
@@ -151,11 +159,22 @@ static long get_nr_dentry_unused(void)
 	return sum < 0 ? 0 : sum;
 }
 
+static long get_nr_dentry_negative(void)
+{
+	int i;
+	long sum = 0;
+
+	for_each_possible_cpu(i)
+		sum += per_cpu(nr_dentry_negative, i);
+	return sum < 0 ? 0 : sum;
+}
+
 int proc_nr_dentry(struct ctl_table *table, int write, void __user *buffer,
 		   size_t *lenp, loff_t *ppos)
 {
 	dentry_stat.nr_dentry = get_nr_dentry();
 	dentry_stat.nr_unused = get_nr_dentry_unused();
+	dentry_stat.nr_negative = get_nr_dentry_negative();
 	return proc_doulongvec_minmax(table, write, buffer, lenp, ppos);
 }
 #endif
@@ -269,12 +288,32 @@ static inline int dname_external(const struct dentry *dentry)
 	return dentry->d_name.name != dentry->d_iname;
 }
 
+/*
+ * A dentry counts as negative from __d_alloc() (or from losing its inode
+ * in dentry_unlink_inode()) until it is instantiated or killed, whether
+ * or not it is on an LRU list.  The per-cpu sum feeds
+ * /proc/sys/fs/dentry-state; the per-sb counter drives the
+ * negative-dentry-limit ceiling enforced from dput().
+ */
+static void d_negative_inc(struct dentry *dentry)
+{
+	this_cpu_inc(nr_dentry_negative);
+	percpu_counter_inc(&dentry->d_sb->s_nr_dentry_negative);
+}
+
+static void d_negative_dec(struct dentry *dentry)
+{
+	this_cpu_dec(nr_dentry_negative);
+	percpu_counter_dec(&dentry->d_sb->s_nr_dentry_negative);
+}
+
 static inline void __d_set_inode_and_type(struct dentry *dentry,
 					  struct inode *inode,
 					  unsigned type_flags)
 {
 	unsigned flags;
 
+	d_negative_dec(dentry);
 	dentry->d_inode = inode;
 	flags = READ_ONCE(dentry->d_flags);
 	flags &= ~(DCACHE_ENTRY_TYPE | DCACHE_FALLTHRU);
@@ -358,6 +397,7 @@ static void dentry_unlink_inode(struct dentry * dentry)
 {
 	struct inode *inode = dentry->d_inode;
 
+	d_negative_inc(dentry);
 	raw_write_seqcount_begin(&dentry->d_seq);
 	__d_clear_type_and_inode(dentry);
 	hlist_del_init(&dentry->d_u.d_alias);
@@ -519,6 +559,8 @@ static void __dentry_kill(struct dentry *dentry)
 		if (!(dentry->d_flags & DCACHE_SHRINK_LIST))
 			d_lru_del(dentry);
 	}
+	if (d_really_is_negative(dentry))
+		d_negative_dec(dentry);
 	/* if it was on the hash then remove it */
 	__d_drop(dentry);
 	__list_del_entry(&dentry->d_child);
@@ -737,9 +779,19 @@ static inline bool fast_dput(struct dentry *dentry)
  * Real recursion would eat up our stack space.
  */
 
+static void prune_negative_dentries(struct super_block *sb);
+
+static inline bool negative_dentries_over_limit(struct super_block *sb)
+{
+	unsigned long limit = READ_ONCE(sysctl_negative_dentry_limit);
+
+	return limit && percpu_counter_read_positive(
+				&sb->s_nr_dentry_negative) > limit;
+}
+
 /*
  * dput - release a dentry
- * @dentry: dentry to release 
+ * @dentry: dentry to release
  *
  * Release a dentry. This will drop the usage count and if appropriate
  * call the dentry unlink method as well as removing it from the queues and
@@ -751,6 +803,14 @@ void dput(struct dentry *dentry)
 	if (unlikely(!dentry))
 		return;
 
+	/*
+	 * The caller's reference pins the superblock, so this is the
+	 * one spot where a bounded negative dentry prune can run
+	 * without extra pinning games.
+	 */
+	if (unlikely(negative_dentries_over_limit(dentry->d_sb)))
+		prune_negative_dentries(dentry->d_sb);
+
 repeat:
 	rcu_read_lock();
 	if (likely(fast_dput(dentry))) {
@@ -1066,6 +1126,60 @@ static enum lru_status dentry_lru_isolate(struct list_head *item,
 	return LRU_REMOVED;
 }
 
+static enum lru_status dentry_lru_isolate_negative(struct list_head *item,
+		struct list_lru_one *lru, spinlock_t *lru_lock, void *arg)
+{
+	struct list_head *freeable = arg;
+	struct dentry	*dentry = container_of(item, struct dentry, d_lru);
+
+	/*
+	 * we are inverting the lru lock/dentry->d_lock here,
+	 * so use a trylock. If we fail to get the lock, just skip
+	 * it
+	 */
+	if (!spin_trylock(&dentry->d_lock))
+		return LRU_SKIP;
+
+	/*
+	 * Only unreferenced negative dentries are taken; everything
+	 * else keeps its place in the LRU.  This is what makes the
+	 * walk cheap enough to run from dput().
+	 */
+	if (dentry->d_lockref.count || !d_really_is_negative(dentry)) {
+		spin_unlock(&dentry->d_lock);
+		return LRU_SKIP;
+	}
+
+	d_lru_shrink_move(lru, dentry, freeable);
+	spin_unlock(&dentry->d_lock);
+
+	return LRU_REMOVED;
+}
+
+/* Negative dentries reclaimed from the LRU in one pruning pass. */
+#define NEGATIVE_DENTRY_BATCH	32
+
+/*
+ * Called from dput() when a superblock has more negative dentries than
+ * sysctl_negative_dentry_limit allows.  Reclaims a small batch from the
+ * sb LRU so the cache shrinks continuously instead of waiting for the
+ * shrinker to run under memory pressure.  A single pass at a time is
+ * enough; it also keeps the dputs done by shrink_dentry_list() itself
+ * from recursing back in here.
+ */
+static void prune_negative_dentries(struct super_block *sb)
+{
+	static atomic_t pruning;
+	LIST_HEAD(dispose);
+
+	if (atomic_cmpxchg(&pruning, 0, 1))
+		return;
+	list_lru_walk(&sb->s_dentry_lru, dentry_lru_isolate_negative,
+		      &dispose, NEGATIVE_DENTRY_BATCH);
+	shrink_dentry_list(&dispose);
+	atomic_set(&pruning, 0);
+}
+
 /**
  * prune_dcache_sb - shrink the dcache
  * @sb: superblock
@@ -1601,6 +1715,7 @@ struct dentry *__d_alloc(struct super_block *sb, const struct qstr *name)
 	d_set_d_op(dentry, dentry->d_sb->s_d_op);
 
 	this_cpu_inc(nr_dentry);
+	d_negative_inc(dentry);
 
 	return dentry;
 }
@@ -2721,7 +2836,8 @@ struct dentry *d_ancestor(struct dentry *p1, struct dentry *p2)
 static int __d_unalias(struct inode *inode,
 		struct dentry *dentry, struct dentry *alias)
 {
-	struct mutex *m1 = NULL, *m2 = NULL;
+	struct mutex *m1 = NULL;
+	struct rw_semaphore *m2 = NULL;
 	int ret = -ESTALE;
 
 	/* If alias and dentry share a parent, then no extra locks required */
@@ -2732,15 +2848,15 @@ static int __d_unalias(struct inode *inode,
 	if (!mutex_trylock(&dentry->d_sb->s_vfs_rename_mutex))
 		goto out_err;
 	m1 = &dentry->d_sb->s_vfs_rename_mutex;
-	if (!inode_trylock(alias->d_parent->d_inode))
+	if (!inode_trylock_shared(alias->d_parent->d_inode))
 		goto out_err;
-	m2 = &alias->d_parent->d_inode->i_mutex;
+	m2 = &alias->d_parent->d_inode->i_rwsem;
 out_unalias:
 	__d_move(alias, dentry, false);
 	ret = 0;
 out_err:
 	if (m2)
-		mutex_unlock(m2);
+		up_read(m2);
 	if (m1)
 		mutex_unlock(m1);
 	return ret;
@@ -3445,6 +3561,7 @@ void __init vfs_caches_init(void)
 
 	dcache_init();
 	inode_init();
+	namei_init();
 	files_init();
 	files_maxfiles_init();
 	mnt_init();
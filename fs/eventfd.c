@@ -37,6 +37,23 @@ struct eventfd_ctx {
 	unsigned int flags;
 };
 
+/*
+ * With EFD_COALESCE, only the signal that takes "count" from zero to
+ * non-zero wakes the wait queue.  Any reader that could observe the
+ * later increments is either already runnable from the first wakeup or
+ * will see a non-zero counter before deciding to sleep, since sleeping
+ * requires observing count == 0 under wqh.lock.  The waiters re-arm the
+ * edge by draining the counter back to zero.
+ *
+ * Must be called with wqh.lock held; @n is the amount just added.
+ */
+static inline bool eventfd_do_wakeup(struct eventfd_ctx *ctx, __u64 n)
+{
+	if (!(ctx->flags & EFD_COALESCE))
+		return true;
+	return ctx->count == n;
+}
+
 /**
  * eventfd_signal - Adds @n to the eventfd counter.
  * @ctx: [in] Pointer to the eventfd context.
@@ -59,7 +76,7 @@ __u64 eventfd_signal(struct eventfd_ctx *ctx, __u64 n)
 	if (ULLONG_MAX - ctx->count < n)
 		n = ULLONG_MAX - ctx->count;
 	ctx->count += n;
-	if (waitqueue_active(&ctx->wqh))
+	if (waitqueue_active(&ctx->wqh) && eventfd_do_wakeup(ctx, n))
 		wake_up_locked_poll(&ctx->wqh, POLLIN);
 	spin_unlock_irqrestore(&ctx->wqh.lock, flags);
 
@@ -316,7 +333,7 @@ static ssize_t eventfd_write(struct file *file, const char __user *buf, size_t c
 	}
 	if (likely(res > 0)) {
 		ctx->count += ucnt;
-		if (waitqueue_active(&ctx->wqh))
+		if (waitqueue_active(&ctx->wqh) && eventfd_do_wakeup(ctx, ucnt))
 			wake_up_locked_poll(&ctx->wqh, POLLIN);
 	}
 	spin_unlock_irq(&ctx->wqh.lock);
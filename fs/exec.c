@@ -69,6 +69,9 @@
 
 int suid_dumpable = 0;
 
+/* Warm the page cache for whole PT_LOAD segments at exec time. */
+int sysctl_elf_exec_readahead __read_mostly;
+
 static LIST_HEAD(formats);
 static DEFINE_RWLOCK(binfmt_lock);
 
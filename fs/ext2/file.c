@@ -21,6 +21,7 @@
 #include <linux/time.h>
 #include <linux/pagemap.h>
 #include <linux/dax.h>
+#include <linux/mman.h>
 #include <linux/quotaops.h>
 #include "ext2.h"
 #include "xattr.h"
@@ -113,8 +114,12 @@ static const struct vm_operations_struct ext2_dax_vm_ops = {
 
 static int ext2_file_mmap(struct file *file, struct vm_area_struct *vma)
 {
-	if (!IS_DAX(file_inode(file)))
+	if (!IS_DAX(file_inode(file))) {
+		/* Synchronous page faults need a DAX mapping */
+		if (vma->vm_flags & VM_SYNC)
+			return -EOPNOTSUPP;
 		return generic_file_mmap(file, vma);
+	}
 
 	file_accessed(file);
 	vma->vm_ops = &ext2_dax_vm_ops;
@@ -169,6 +174,10 @@ const struct file_operations ext2_file_operations = {
 	.compat_ioctl	= ext2_compat_ioctl,
 #endif
 	.mmap		= ext2_file_mmap,
+#ifdef CONFIG_FS_DAX
+	.mmap_supported_flags = MAP_SYNC,
+#endif
+	.get_unmapped_area = dax_get_unmapped_area,
 	.open		= dquot_file_open,
 	.release	= ext2_release_file,
 	.fsync		= ext2_fsync,
@@ -29,6 +29,7 @@
 #include <linux/mempool.h>
 #include <linux/module.h>
 #include <linux/mutex.h>
+#include <linux/percpu.h>
 #include <linux/random.h>
 #include <linux/scatterlist.h>
 #include <linux/spinlock_types.h>
@@ -50,8 +51,20 @@ MODULE_PARM_DESC(num_prealloc_crypto_ctxs,
 
 static mempool_t *ext4_bounce_page_pool;
 
-static LIST_HEAD(ext4_free_crypto_ctxs);
-static DEFINE_SPINLOCK(ext4_crypto_ctx_lock);
+/*
+ * Per-CPU pools of free encryption contexts.  A context has no CPU
+ * affinity of its own; keeping the free lists per CPU just takes the
+ * get/release pair off a shared lock on every page of encrypted I/O.
+ * Contexts are released from I/O completion, so interrupts are disabled
+ * around the list accesses instead.
+ */
+struct ext4_crypto_ctx_pool {
+	struct list_head	free_ctxs;
+	unsigned int		nr_free;
+};
+
+static DEFINE_PER_CPU(struct ext4_crypto_ctx_pool, ext4_crypto_ctx_pools);
+static unsigned int ext4_max_ctxs_per_cpu;
 
 static struct kmem_cache *ext4_crypto_ctx_cachep;
 struct kmem_cache *ext4_crypt_info_cachep;
@@ -67,19 +80,24 @@ struct kmem_cache *ext4_crypt_info_cachep;
  */
 void ext4_release_crypto_ctx(struct ext4_crypto_ctx *ctx)
 {
+	struct ext4_crypto_ctx_pool *pool;
 	unsigned long flags;
 
 	if (ctx->flags & EXT4_WRITE_PATH_FL && ctx->w.bounce_page)
 		mempool_free(ctx->w.bounce_page, ext4_bounce_page_pool);
 	ctx->w.bounce_page = NULL;
 	ctx->w.control_page = NULL;
-	if (ctx->flags & EXT4_CTX_REQUIRES_FREE_ENCRYPT_FL) {
-		kmem_cache_free(ext4_crypto_ctx_cachep, ctx);
-	} else {
-		spin_lock_irqsave(&ext4_crypto_ctx_lock, flags);
-		list_add(&ctx->free_list, &ext4_free_crypto_ctxs);
-		spin_unlock_irqrestore(&ext4_crypto_ctx_lock, flags);
+
+	local_irq_save(flags);
+	pool = this_cpu_ptr(&ext4_crypto_ctx_pools);
+	if (pool->nr_free < ext4_max_ctxs_per_cpu) {
+		list_add(&ctx->free_list, &pool->free_ctxs);
+		pool->nr_free++;
+		ctx = NULL;
 	}
+	local_irq_restore(flags);
+	if (ctx)
+		kmem_cache_free(ext4_crypto_ctx_cachep, ctx);
 }
 
 /**
@@ -93,8 +111,8 @@ void ext4_release_crypto_ctx(struct ext4_crypto_ctx *ctx)
  */
 struct ext4_crypto_ctx *ext4_get_crypto_ctx(struct inode *inode)
 {
-	struct ext4_crypto_ctx *ctx = NULL;
-	int res = 0;
+	struct ext4_crypto_ctx_pool *pool;
+	struct ext4_crypto_ctx *ctx;
 	unsigned long flags;
 	struct ext4_crypt_info *ci = EXT4_I(inode)->i_crypt_info;
 
@@ -102,39 +120,28 @@ struct ext4_crypto_ctx *ext4_get_crypto_ctx(struct inode *inode)
 		return ERR_PTR(-ENOKEY);
 
 	/*
-	 * We first try getting the ctx from a free list because in
-	 * the common case the ctx will have an allocated and
-	 * initialized crypto tfm, so it's probably a worthwhile
-	 * optimization. For the bounce page, we first try getting it
-	 * from the kernel allocator because that's just about as fast
-	 * as getting it from a list and because a cache of free pages
-	 * should generally be a "last resort" option for a filesystem
-	 * to be able to do its job.
+	 * We first try this CPU's free list; in the common case it holds
+	 * a context from a recently completed I/O, still cache-warm.
+	 * For the bounce page, we first try getting it from the kernel
+	 * allocator because that's just about as fast as getting it from
+	 * a list and because a cache of free pages should generally be a
+	 * "last resort" option for a filesystem to be able to do its job.
 	 */
-	spin_lock_irqsave(&ext4_crypto_ctx_lock, flags);
-	ctx = list_first_entry_or_null(&ext4_free_crypto_ctxs,
+	local_irq_save(flags);
+	pool = this_cpu_ptr(&ext4_crypto_ctx_pools);
+	ctx = list_first_entry_or_null(&pool->free_ctxs,
 				       struct ext4_crypto_ctx, free_list);
-	if (ctx)
+	if (ctx) {
 		list_del(&ctx->free_list);
-	spin_unlock_irqrestore(&ext4_crypto_ctx_lock, flags);
+		pool->nr_free--;
+	}
+	local_irq_restore(flags);
 	if (!ctx) {
 		ctx = kmem_cache_zalloc(ext4_crypto_ctx_cachep, GFP_NOFS);
-		if (!ctx) {
-			res = -ENOMEM;
-			goto out;
-		}
-		ctx->flags |= EXT4_CTX_REQUIRES_FREE_ENCRYPT_FL;
-	} else {
-		ctx->flags &= ~EXT4_CTX_REQUIRES_FREE_ENCRYPT_FL;
+		if (!ctx)
+			return ERR_PTR(-ENOMEM);
 	}
 	ctx->flags &= ~EXT4_WRITE_PATH_FL;
-
-out:
-	if (res) {
-		if (!IS_ERR_OR_NULL(ctx))
-			ext4_release_crypto_ctx(ctx);
-		ctx = ERR_PTR(res);
-	}
 	return ctx;
 }
 
@@ -147,10 +154,16 @@ static DEFINE_MUTEX(crypto_init);
 void ext4_exit_crypto(void)
 {
 	struct ext4_crypto_ctx *pos, *n;
-
-	list_for_each_entry_safe(pos, n, &ext4_free_crypto_ctxs, free_list)
-		kmem_cache_free(ext4_crypto_ctx_cachep, pos);
-	INIT_LIST_HEAD(&ext4_free_crypto_ctxs);
+	struct ext4_crypto_ctx_pool *pool;
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		pool = per_cpu_ptr(&ext4_crypto_ctx_pools, cpu);
+		list_for_each_entry_safe(pos, n, &pool->free_ctxs, free_list)
+			kmem_cache_free(ext4_crypto_ctx_cachep, pos);
+		INIT_LIST_HEAD(&pool->free_ctxs);
+		pool->nr_free = 0;
+	}
 	if (ext4_bounce_page_pool)
 		mempool_destroy(ext4_bounce_page_pool);
 	ext4_bounce_page_pool = NULL;
@@ -175,7 +188,9 @@ void ext4_exit_crypto(void)
  */
 int ext4_init_crypto(void)
 {
-	int i, res = -ENOMEM;
+	struct ext4_crypto_ctx_pool *pool;
+	unsigned int nr_bounce_pages;
+	int i, cpu, res = -ENOMEM;
 
 	mutex_lock(&crypto_init);
 	if (ext4_read_workqueue)
@@ -194,6 +209,15 @@ int ext4_init_crypto(void)
 	if (!ext4_crypt_info_cachep)
 		goto fail;
 
+	/* Spread the preallocated contexts across the CPU pools. */
+	ext4_max_ctxs_per_cpu = DIV_ROUND_UP(num_prealloc_crypto_ctxs,
+					     num_possible_cpus());
+	for_each_possible_cpu(cpu) {
+		pool = per_cpu_ptr(&ext4_crypto_ctx_pools, cpu);
+		INIT_LIST_HEAD(&pool->free_ctxs);
+		pool->nr_free = 0;
+	}
+	cpu = cpumask_first(cpu_possible_mask);
 	for (i = 0; i < num_prealloc_crypto_ctxs; i++) {
 		struct ext4_crypto_ctx *ctx;
 
@@ -202,11 +226,23 @@ int ext4_init_crypto(void)
 			res = -ENOMEM;
 			goto fail;
 		}
-		list_add(&ctx->free_list, &ext4_free_crypto_ctxs);
+		pool = per_cpu_ptr(&ext4_crypto_ctx_pools, cpu);
+		list_add(&ctx->free_list, &pool->free_ctxs);
+		pool->nr_free++;
+		cpu = cpumask_next(cpu, cpu_possible_mask);
+		if (cpu >= nr_cpu_ids)
+			cpu = cpumask_first(cpu_possible_mask);
 	}
 
+	/*
+	 * The bounce pool bounds write concurrency, so let it grow with
+	 * the machine; the module parameter sets a floor rather than the
+	 * exact size.
+	 */
+	nr_bounce_pages = max_t(unsigned int, num_prealloc_crypto_pages,
+				8 * num_online_cpus());
 	ext4_bounce_page_pool =
-		mempool_create_page_pool(num_prealloc_crypto_pages, 0);
+		mempool_create_page_pool(nr_bounce_pages, 0);
 	if (!ext4_bounce_page_pool) {
 		res = -ENOMEM;
 		goto fail;
@@ -259,20 +295,19 @@ static int ext4_page_crypto(struct inode *inode,
 
 {
 	u8 xts_tweak[EXT4_XTS_TWEAK_SIZE];
-	struct skcipher_request *req = NULL;
 	DECLARE_EXT4_COMPLETION_RESULT(ecr);
 	struct scatterlist dst, src;
 	struct ext4_crypt_info *ci = EXT4_I(inode)->i_crypt_info;
 	struct crypto_skcipher *tfm = ci->ci_ctfm;
 	int res = 0;
+	SKCIPHER_REQUEST_ON_STACK(req, tfm);
 
-	req = skcipher_request_alloc(tfm, GFP_NOFS);
-	if (!req) {
-		printk_ratelimited(KERN_ERR
-				   "%s: crypto_request_alloc() failed\n",
-				   __func__);
-		return -ENOMEM;
-	}
+	/*
+	 * The request lives on the stack; we wait for completion below
+	 * before returning, so this is safe with async implementations
+	 * and saves an allocation per page.
+	 */
+	skcipher_request_set_tfm(req, tfm);
 	skcipher_request_set_callback(
 		req, CRYPTO_TFM_REQ_MAY_BACKLOG | CRYPTO_TFM_REQ_MAY_SLEEP,
 		ext4_crypt_complete, &ecr);
@@ -296,7 +331,7 @@ static int ext4_page_crypto(struct inode *inode,
 		wait_for_completion(&ecr.completion);
 		res = ecr.res;
 	}
-	skcipher_request_free(req);
+	skcipher_request_zero(req);
 	if (res) {
 		printk_ratelimited(
 			KERN_ERR
@@ -309,7 +344,11 @@ static int ext4_page_crypto(struct inode *inode,
 
 static struct page *alloc_bounce_page(struct ext4_crypto_ctx *ctx)
 {
-	ctx->w.bounce_page = mempool_alloc(ext4_bounce_page_pool, GFP_NOWAIT);
+	/*
+	 * GFP_NOFS rather than GFP_NOWAIT: under memory pressure a writer
+	 * throttles on the pool instead of failing the write with ENOMEM.
+	 */
+	ctx->w.bounce_page = mempool_alloc(ext4_bounce_page_pool, GFP_NOFS);
 	if (ctx->w.bounce_page == NULL)
 		return ERR_PTR(-ENOMEM);
 	ctx->flags |= EXT4_WRITE_PATH_FL;
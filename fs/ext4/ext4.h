@@ -31,6 +31,7 @@
 #include <linux/blockgroup_lock.h>
 #include <linux/percpu_counter.h>
 #include <linux/ratelimit.h>
+#include <linux/range_lock.h>
 #include <crypto/hash.h>
 #include <linux/falloc.h>
 #ifdef __KERNEL__
@@ -165,6 +166,17 @@ struct ext4_map_blocks {
 	unsigned int m_flags;
 };
 
+/*
+ * Context passed from ext4_file_write_iter() to the direct I/O path via
+ * iocb->private.  For an overwrite the written block range is held in
+ * ->range so ext4_ext_direct_IO() can release it once the I/O is done.
+ */
+struct ext4_dio_write_data {
+	int overwrite;
+	int range_locked;
+	struct range_lock range;
+};
+
 /*
  * Flags for ext4_io_end->flags
  */
@@ -960,6 +972,12 @@ struct ext4_inode_info {
 	 * by other means, so we have i_data_sem.
 	 */
 	struct rw_semaphore i_data_sem;
+	/*
+	 * i_dio_range_tree serializes overlapping overwrite direct I/O
+	 * writes once i_mutex has been dropped, while letting writes to
+	 * disjoint block ranges proceed in parallel.
+	 */
+	struct range_lock_tree i_dio_range_tree;
 	/*
 	 * i_mmap_sem is for serializing page faults with truncate / punch hole
 	 * operations. We have to make sure that new page cannot be faulted in
@@ -1391,6 +1409,9 @@ struct ext4_sb_info {
 	unsigned short *s_mb_offsets;
 	unsigned int *s_mb_maxs;
 	unsigned int s_group_info_size;
+	/* block groups sorted by order of the largest free extent */
+	struct list_head *s_mb_largest_free_orders;
+	rwlock_t *s_mb_largest_free_orders_locks;
 
 	/* tunables */
 	unsigned long s_stripe;
@@ -1400,6 +1421,7 @@ struct ext4_sb_info {
 	unsigned int s_mb_stats;
 	unsigned int s_mb_order2_reqs;
 	unsigned int s_mb_group_prealloc;
+	unsigned int s_mb_max_linear_groups;
 	unsigned int s_max_dir_size_kb;
 	/* where last allocation was done - for stream allocation */
 	unsigned long s_mb_last_group;
@@ -2908,7 +2930,9 @@ struct ext4_group_info {
 	ext4_grpblk_t	bb_free;	/* total free blocks */
 	ext4_grpblk_t	bb_fragments;	/* nr of freespace fragments */
 	ext4_grpblk_t	bb_largest_free_order;/* order of largest frag in BG */
+	ext4_group_t	bb_group;	/* Group number */
 	struct          list_head bb_prealloc_list;
+	struct          list_head bb_largest_free_order_node;
 #ifdef DOUBLE_CHECK
 	void            *bb_bitmap;
 #endif
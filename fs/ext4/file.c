@@ -23,6 +23,7 @@
 #include <linux/mount.h>
 #include <linux/path.h>
 #include <linux/dax.h>
+#include <linux/mman.h>
 #include <linux/quotaops.h>
 #include <linux/pagevec.h>
 #include <linux/uio.h>
@@ -94,9 +95,9 @@ ext4_file_write_iter(struct kiocb *iocb, struct iov_iter *from)
 	struct file *file = iocb->ki_filp;
 	struct inode *inode = file_inode(iocb->ki_filp);
 	struct blk_plug plug;
+	struct ext4_dio_write_data dio_data = { .overwrite = 0 };
 	int o_direct = iocb->ki_flags & IOCB_DIRECT;
 	int unaligned_aio = 0;
-	int overwrite = 0;
 	ssize_t ret;
 
 	inode_lock(inode);
@@ -130,7 +131,7 @@ ext4_file_write_iter(struct kiocb *iocb, struct iov_iter *from)
 		iov_iter_truncate(from, sbi->s_bitmap_maxbytes - iocb->ki_pos);
 	}
 
-	iocb->private = &overwrite;
+	iocb->private = &dio_data;
 	if (o_direct) {
 		size_t length = iov_iter_count(from);
 		loff_t pos = iocb->ki_pos;
@@ -161,12 +162,36 @@ ext4_file_write_iter(struct kiocb *iocb, struct iov_iter *from)
 			 * non-flags are returned.  So we should check
 			 * these two conditions.
 			 */
-			if (err == len && (map.m_flags & EXT4_MAP_MAPPED))
-				overwrite = 1;
+			if (err == len && (map.m_flags & EXT4_MAP_MAPPED)) {
+				/*
+				 * Once ext4_ext_direct_IO() drops i_mutex
+				 * the range lock is all that keeps another
+				 * overwrite to the same blocks from racing
+				 * with us; disjoint overwrites proceed in
+				 * parallel.  It is released in
+				 * ext4_ext_direct_IO() before i_mutex is
+				 * retaken, so the two are never waited for
+				 * in the opposite order.
+				 */
+				dio_data.overwrite = 1;
+				dio_data.range_locked = 1;
+				range_lock_init(&dio_data.range, map.m_lblk,
+						map.m_lblk + len - 1);
+				range_lock(&EXT4_I(inode)->i_dio_range_tree,
+					   &dio_data.range);
+			}
 		}
 	}
 
 	ret = __generic_file_write_iter(iocb, from);
+	/*
+	 * Normally ext4_ext_direct_IO() has dropped the range lock before
+	 * retaking i_mutex; clean up after error paths that returned
+	 * before ->direct_IO was invoked.
+	 */
+	if (dio_data.range_locked)
+		range_unlock(&EXT4_I(inode)->i_dio_range_tree,
+			     &dio_data.range);
 	inode_unlock(inode);
 
 	if (ret > 0) {
@@ -307,6 +332,10 @@ static int ext4_file_mmap(struct file *file, struct vm_area_struct *vma)
 {
 	struct inode *inode = file->f_mapping->host;
 
+	/* Synchronous page faults can only be honored on DAX files */
+	if ((vma->vm_flags & VM_SYNC) && !IS_DAX(inode))
+		return -EOPNOTSUPP;
+
 	if (ext4_encrypted_inode(inode)) {
 		int err = ext4_get_encryption_info(inode);
 		if (err)
@@ -726,6 +755,8 @@ const struct file_operations ext4_file_operations = {
 	.compat_ioctl	= ext4_compat_ioctl,
 #endif
 	.mmap		= ext4_file_mmap,
+	.mmap_supported_flags = MAP_SYNC,
+	.get_unmapped_area = dax_get_unmapped_area,
 	.open		= ext4_file_open,
 	.release	= ext4_release_file,
 	.fsync		= ext4_sync_file,
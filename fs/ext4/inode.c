@@ -31,6 +31,7 @@
 #include <linux/mpage.h>
 #include <linux/namei.h>
 #include <linux/uio.h>
+#include <linux/iomap.h>
 #include <linux/bio.h>
 #include <linux/workqueue.h>
 #include <linux/kernel.h>
@@ -504,6 +505,11 @@ int ext4_map_blocks(handle_t *handle, struct inode *inode,
 				retval = map->m_len;
 			map->m_len = retval;
 		} else if (ext4_es_is_delayed(&es) || ext4_es_is_hole(&es)) {
+			map->m_pblk = 0;
+			retval = es.es_len - (map->m_lblk - es.es_lblk);
+			if (retval > map->m_len)
+				retval = map->m_len;
+			map->m_len = retval;
 			retval = 0;
 		} else {
 			BUG_ON(1);
@@ -3313,6 +3319,79 @@ static int ext4_end_io_dio(struct kiocb *iocb, loff_t offset,
 	return 0;
 }
 
+/*
+ * Look up the extent covering the start of the range; we never allocate
+ * here.  Direct I/O writes are only sent this way when the whole range is
+ * known to overwrite allocated, written blocks, so holes and unwritten
+ * extents under a write can only be the result of a race and make us punt
+ * back to the legacy path.
+ */
+static int ext4_iomap_begin(struct inode *inode, loff_t offset, loff_t length,
+			    unsigned flags, struct iomap *iomap)
+{
+	unsigned int blkbits = inode->i_blkbits;
+	struct ext4_map_blocks map;
+	int ret;
+
+	if (WARN_ON_ONCE(ext4_has_inline_data(inode)))
+		return -ERANGE;
+
+	map.m_lblk = offset >> blkbits;
+	map.m_len = ((offset + length - 1) >> blkbits) - map.m_lblk + 1;
+
+	ret = ext4_map_blocks(NULL, inode, &map, 0);
+	if (ret < 0)
+		return ret;
+
+	iomap->bdev = inode->i_sb->s_bdev;
+	iomap->offset = (u64)map.m_lblk << blkbits;
+	iomap->length = (u64)map.m_len << blkbits;
+
+	if (ret == 0) {
+		if (flags & IOMAP_WRITE)
+			return -ENOTBLK;
+		iomap->type = IOMAP_HOLE;
+		iomap->blkno = IOMAP_NULL_BLOCK;
+	} else {
+		if (map.m_flags & EXT4_MAP_UNWRITTEN) {
+			if (flags & IOMAP_WRITE)
+				return -ENOTBLK;
+			iomap->type = IOMAP_UNWRITTEN;
+		} else {
+			iomap->type = IOMAP_MAPPED;
+		}
+		iomap->blkno = (sector_t)map.m_pblk << (blkbits - 9);
+	}
+
+	return 0;
+}
+
+static int ext4_iomap_end(struct inode *inode, loff_t offset, loff_t length,
+			  ssize_t written, unsigned flags, struct iomap *iomap)
+{
+	return 0;
+}
+
+static struct iomap_ops ext4_iomap_ops = {
+	.iomap_begin		= ext4_iomap_begin,
+	.iomap_end		= ext4_iomap_end,
+};
+
+/*
+ * The iomap direct I/O engine builds bios over whole extents but leaves
+ * sub-block zeroing to the caller, so only block-aligned I/O qualifies.
+ */
+static bool ext4_iomap_dio_ok(struct inode *inode, struct iov_iter *iter,
+			      loff_t offset)
+{
+	unsigned int blkmask = (1 << inode->i_blkbits) - 1;
+
+	if (IS_DAX(inode))
+		return false;
+	return !((offset | iov_iter_count(iter) | iov_iter_alignment(iter)) &
+		 blkmask);
+}
+
 /*
  * For ext4 extent files, ext4 will do direct-io write to holes,
  * preallocated extents, and those write extend the file, no need to
@@ -3337,6 +3416,7 @@ static ssize_t ext4_ext_direct_IO(struct kiocb *iocb, struct iov_iter *iter,
 {
 	struct file *file = iocb->ki_filp;
 	struct inode *inode = file->f_mapping->host;
+	struct ext4_dio_write_data *dio_data;
 	ssize_t ret;
 	size_t count = iov_iter_count(iter);
 	int overwrite = 0;
@@ -3344,7 +3424,12 @@ static ssize_t ext4_ext_direct_IO(struct kiocb *iocb, struct iov_iter *iter,
 	int dio_flags = 0;
 	loff_t final_size = offset + count;
 
-	/* Use the old path for reads and writes beyond i_size. */
+	/*
+	 * Use the old path for reads and writes beyond i_size.  Reads
+	 * stay there even though they never allocate: the legacy engine
+	 * holds i_mutex across block lookup, which is what keeps a
+	 * concurrent truncate from freeing the blocks under them.
+	 */
 	if (iov_iter_rw(iter) != WRITE || final_size > inode->i_size)
 		return ext4_ind_direct_IO(iocb, iter, offset);
 
@@ -3359,7 +3444,8 @@ static ssize_t ext4_ext_direct_IO(struct kiocb *iocb, struct iov_iter *iter,
 		inode_dio_begin(inode);
 
 	/* If we do a overwrite dio, i_mutex locking can be released */
-	overwrite = *((int *)iocb->private);
+	dio_data = iocb->private;
+	overwrite = dio_data->overwrite;
 
 	if (overwrite)
 		inode_unlock(inode);
@@ -3400,6 +3486,14 @@ static ssize_t ext4_ext_direct_IO(struct kiocb *iocb, struct iov_iter *iter,
 	if (IS_DAX(inode))
 		ret = dax_do_io(iocb, inode, iter, offset, get_block_func,
 				ext4_end_io_dio, dio_flags);
+	else if (overwrite && ext4_iomap_dio_ok(inode, iter, offset))
+		/*
+		 * Overwrites hit only written, allocated blocks: no
+		 * unwritten conversion, size update or orphan handling is
+		 * needed afterwards, which makes them safe for the
+		 * extent-granular engine.
+		 */
+		ret = iomap_dio_rw(iocb, iter, &ext4_iomap_ops, NULL);
 	else
 		ret = __blockdev_direct_IO(iocb, inode,
 					   inode->i_sb->s_bdev, iter, offset,
@@ -3423,8 +3517,17 @@ static ssize_t ext4_ext_direct_IO(struct kiocb *iocb, struct iov_iter *iter,
 	if (iov_iter_rw(iter) == WRITE)
 		inode_dio_end(inode);
 	/* take i_mutex locking again if we do a ovewrite dio */
-	if (overwrite)
+	if (overwrite) {
+		/*
+		 * Drop the block range lock first: another overwrite may
+		 * hold i_mutex and be waiting on our range, so taking
+		 * i_mutex while still holding the range would deadlock.
+		 */
+		range_unlock(&EXT4_I(inode)->i_dio_range_tree,
+			     &dio_data->range);
+		dio_data->range_locked = 0;
 		inode_lock(inode);
+	}
 
 	return ret;
 }
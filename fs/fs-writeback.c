@@ -1060,8 +1060,18 @@ static int move_expired_inodes(struct list_head *delaying_queue,
 	while (!list_empty(delaying_queue)) {
 		inode = wb_inode(delaying_queue->prev);
 		if (older_than_this &&
-		    inode_dirtied_after(inode, *older_than_this))
-			break;
+		    inode_dirtied_after(inode, *older_than_this)) {
+			/*
+			 * Once one timestamp-only inode has expired we are
+			 * going to dirty inode tables anyway, so take the
+			 * rest of the queue with it: the sb sort below
+			 * clusters them and the younger timestamps ride
+			 * along in the same inode-table writes instead of
+			 * costing a separate pass next interval.
+			 */
+			if (!((flags & EXPIRE_DIRTY_ATIME) && moved))
+				break;
+		}
 		list_move(&inode->i_io_list, &tmp);
 		moved++;
 		if (flags & EXPIRE_DIRTY_ATIME)
@@ -1622,6 +1632,109 @@ static long writeback_inodes_wb(struct bdi_writeback *wb, long nr_pages,
 	return nr_pages - work.nr_pages;
 }
 
+/*
+ * Ceiling on nr_flushers.  More workers than this are unlikely to do
+ * anything but fight over wb->list_lock.
+ */
+#define WB_MAX_FLUSHERS		16
+
+/*
+ * Helper flusher worker.  Any number of these can drain the dirty lists of
+ * a single wb alongside wb_workfn(): all list manipulation happens under
+ * wb->list_lock and inodes under writeback are protected by I_SYNC, so
+ * concurrent workers simply pick up different inodes.  This is what lets a
+ * single bdi issue enough IO to saturate devices that one flusher cannot.
+ */
+static void wb_aux_flusher_workfn(struct work_struct *work)
+{
+	struct wb_flusher *flusher = container_of(work, struct wb_flusher,
+						  work);
+	struct bdi_writeback *wb = flusher->wb;
+
+	set_worker_desc("flush-%s", dev_name(wb->bdi->dev));
+	current->flags |= PF_SWAPWRITE;
+
+	while (test_bit(WB_registered, &wb->state) && wb_over_bg_thresh(wb)) {
+		if (!writeback_inodes_wb(wb, 1024, WB_REASON_BACKGROUND))
+			break;
+		cond_resched();
+	}
+
+	current->flags &= ~PF_SWAPWRITE;
+}
+
+/*
+ * Kick the helper flushers if the wb is busy enough for them to be of any
+ * use.  Queueing an already queued work is a no-op, so this is cheap to
+ * call on every wb_workfn() invocation.
+ */
+static void wb_queue_aux_flushers(struct bdi_writeback *wb)
+{
+	struct backing_dev_info *bdi = wb->bdi;
+	int i;
+
+	if (likely(!READ_ONCE(bdi->flushers)) || wb != &bdi->wb)
+		return;
+	if (!wb_over_bg_thresh(wb))
+		return;
+
+	spin_lock_bh(&wb->work_lock);
+	for (i = 0; i < (int)bdi->nr_flushers - 1; i++)
+		queue_work(bdi_wq, &bdi->flushers[i].work);
+	spin_unlock_bh(&wb->work_lock);
+}
+
+/**
+ * bdi_set_nr_flushers - configure the number of flusher workers of a bdi
+ * @bdi: bdi of interest
+ * @nr_flushers: total number of workers, including the wb_workfn() one
+ *
+ * The default of one matches the historic one-flusher-per-bdi behaviour.
+ * Raising it lets up to @nr_flushers workers write back the root wb
+ * concurrently, which is useful for devices that a single CPU cannot
+ * saturate.  Only the root wb is affected; cgroup wbs already spread the
+ * load over one worker per cgroup.
+ */
+int bdi_set_nr_flushers(struct backing_dev_info *bdi,
+			unsigned int nr_flushers)
+{
+	struct wb_flusher *flushers = NULL, *old;
+	unsigned int old_nr, i;
+
+	if (nr_flushers < 1 || nr_flushers > WB_MAX_FLUSHERS)
+		return -EINVAL;
+
+	if (nr_flushers > 1) {
+		flushers = kcalloc(nr_flushers - 1, sizeof(*flushers),
+				   GFP_KERNEL);
+		if (!flushers)
+			return -ENOMEM;
+		for (i = 0; i < nr_flushers - 1; i++) {
+			flushers[i].wb = &bdi->wb;
+			INIT_WORK(&flushers[i].work, wb_aux_flusher_workfn);
+		}
+	}
+
+	spin_lock_bh(&bdi->wb.work_lock);
+	old = bdi->flushers;
+	old_nr = bdi->nr_flushers;
+	bdi->flushers = flushers;
+	bdi->nr_flushers = nr_flushers;
+	spin_unlock_bh(&bdi->wb.work_lock);
+
+	/*
+	 * The old workers can no longer be requeued by
+	 * wb_queue_aux_flushers(), so waiting for the ones in flight is
+	 * enough to be able to free them.
+	 */
+	if (old) {
+		for (i = 0; i < old_nr - 1; i++)
+			cancel_work_sync(&old[i].work);
+		kfree(old);
+	}
+	return 0;
+}
+
 /*
  * Explicit flushing or periodic writeback of "old" data.
  *
@@ -1868,6 +1981,7 @@ void wb_workfn(struct work_struct *work)
 		 * if @wb is shutting down even when we're running off the
 		 * rescuer as work_list needs to be drained.
 		 */
+		wb_queue_aux_flushers(wb);
 		do {
 			pages_written = wb_do_writeback(wb);
 			trace_writeback_pages_written(pages_written);
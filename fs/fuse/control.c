@@ -125,7 +125,12 @@ static ssize_t fuse_conn_max_background_write(struct file *file,
 	if (ret > 0) {
 		struct fuse_conn *fc = fuse_ctl_file_conn_get(file);
 		if (fc) {
+			spin_lock(&fc->bg_lock);
 			fc->max_background = val;
+			fc->blocked = fc->num_background >= fc->max_background;
+			if (!fc->blocked)
+				wake_up(&fc->blocked_waitq);
+			spin_unlock(&fc->bg_lock);
 			fuse_conn_put(fc);
 		}
 	}
@@ -162,7 +167,18 @@ static ssize_t fuse_conn_congestion_threshold_write(struct file *file,
 	if (ret > 0) {
 		struct fuse_conn *fc = fuse_ctl_file_conn_get(file);
 		if (fc) {
+			spin_lock(&fc->bg_lock);
 			fc->congestion_threshold = val;
+			if (fc->bdi_initialized) {
+				if (fc->num_background < fc->congestion_threshold) {
+					clear_bdi_congested(&fc->bdi, BLK_RW_SYNC);
+					clear_bdi_congested(&fc->bdi, BLK_RW_ASYNC);
+				} else {
+					set_bdi_congested(&fc->bdi, BLK_RW_SYNC);
+					set_bdi_congested(&fc->bdi, BLK_RW_ASYNC);
+				}
+			}
+			spin_unlock(&fc->bg_lock);
 			fuse_conn_put(fc);
 		}
 	}
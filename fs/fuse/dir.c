@@ -1715,11 +1715,27 @@ static int fuse_getattr(struct vfsmount *mnt, struct dentry *entry,
 			struct kstat *stat)
 {
 	struct inode *inode = d_inode(entry);
+	struct fuse_inode *fi = get_fuse_inode(inode);
 	struct fuse_conn *fc = get_fuse_conn(inode);
 
 	if (!fuse_allow_current_process(fc))
 		return -EACCES;
 
+	if (stat->query_flags & AT_STATX_DONT_SYNC) {
+		/*
+		 * The caller prefers a possibly stale answer over a
+		 * round-trip to the userspace server, so use the cached
+		 * attributes even if they have timed out.
+		 */
+		generic_fillattr(inode, stat);
+		stat->mode = fi->orig_i_mode;
+		stat->ino = fi->orig_ino;
+		return 0;
+	}
+
+	if (stat->query_flags & AT_STATX_FORCE_SYNC)
+		return fuse_do_getattr(inode, stat, NULL);
+
 	return fuse_update_attributes(inode, stat, NULL, NULL);
 }
 
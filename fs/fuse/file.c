@@ -1468,6 +1468,7 @@ __acquires(fc->lock)
 	struct fuse_inode *fi = get_fuse_inode(req->inode);
 	struct fuse_write_in *inarg = &req->misc.write.in;
 	__u64 data_size = req->num_pages * PAGE_CACHE_SIZE;
+	bool queued;
 
 	if (!fc->connected)
 		goto out_free;
@@ -1483,8 +1484,12 @@ __acquires(fc->lock)
 
 	req->in.args[1].size = inarg->size;
 	fi->writectr++;
-	fuse_request_send_background_locked(fc, req);
-	return;
+	queued = fuse_request_queue_background(fc, req);
+	if (queued)
+		return;
+
+	/* Raced with an abort, clean up as if truncated away */
+	fi->writectr--;
 
  out_free:
 	fuse_writepage_finish(fc, req);
@@ -745,6 +745,180 @@ wait_commit:
 }
 EXPORT_SYMBOL(jbd2_complete_transaction);
 
+/**
+ * jbd2_fc_begin_commit - start a fast commit for the given tid
+ * @journal: journal to fast commit in
+ * @tid: transaction id that the caller wants made durable
+ *
+ * Only one fast commit or full commit may run at a time.  If another
+ * commit is ongoing, wait for it and return -EALREADY so the caller can
+ * re-check whether @tid still needs committing.  Returns 0 with the
+ * journal marked JBD2_FAST_COMMIT_ONGOING on success; the caller must
+ * finish with jbd2_fc_end_commit() or jbd2_fc_end_commit_fallback().
+ */
+int jbd2_fc_begin_commit(journal_t *journal, tid_t tid)
+{
+	if (unlikely(is_journal_aborted(journal)))
+		return -EIO;
+
+	/*
+	 * Fast commits only make sense once at least one full commit has
+	 * established a valid log tail to replay from.
+	 */
+	if (!journal->j_stats.ts_tid)
+		return -EINVAL;
+
+	write_lock(&journal->j_state_lock);
+	if (tid <= journal->j_commit_sequence) {
+		write_unlock(&journal->j_state_lock);
+		return -EALREADY;
+	}
+
+	if (journal->j_flags & (JBD2_FULL_COMMIT_ONGOING |
+				JBD2_FAST_COMMIT_ONGOING)) {
+		DEFINE_WAIT(wait);
+
+		prepare_to_wait(&journal->j_fc_wait, &wait,
+				TASK_UNINTERRUPTIBLE);
+		write_unlock(&journal->j_state_lock);
+		schedule();
+		finish_wait(&journal->j_fc_wait, &wait);
+		return -EALREADY;
+	}
+	journal->j_flags |= JBD2_FAST_COMMIT_ONGOING;
+	write_unlock(&journal->j_state_lock);
+
+	return 0;
+}
+EXPORT_SYMBOL(jbd2_fc_begin_commit);
+
+/*
+ * Stop a fast commit.  If fallback is set, this fast commit could not
+ * cover the pending changes by itself, so make sure the running
+ * transaction gets a regular full commit instead.
+ */
+static int __jbd2_fc_end_commit(journal_t *journal, tid_t tid, bool fallback)
+{
+	if (journal->j_fc_cleanup_callback)
+		journal->j_fc_cleanup_callback(journal, 0);
+	write_lock(&journal->j_state_lock);
+	journal->j_flags &= ~JBD2_FAST_COMMIT_ONGOING;
+	/*
+	 * Hand over to the full commit atomically so that no new fast
+	 * commit can start before the fallback commit has run; the
+	 * commit thread clears the flag once it is done.
+	 */
+	if (fallback)
+		journal->j_flags |= JBD2_FULL_COMMIT_ONGOING;
+	write_unlock(&journal->j_state_lock);
+	wake_up(&journal->j_fc_wait);
+	if (fallback)
+		return jbd2_complete_transaction(journal, tid);
+	return 0;
+}
+
+int jbd2_fc_end_commit(journal_t *journal)
+{
+	return __jbd2_fc_end_commit(journal, 0, false);
+}
+EXPORT_SYMBOL(jbd2_fc_end_commit);
+
+int jbd2_fc_end_commit_fallback(journal_t *journal)
+{
+	tid_t tid;
+
+	read_lock(&journal->j_state_lock);
+	tid = journal->j_running_transaction ?
+		journal->j_running_transaction->t_tid : 0;
+	read_unlock(&journal->j_state_lock);
+	return __jbd2_fc_end_commit(journal, tid, tid ? true : false);
+}
+EXPORT_SYMBOL(jbd2_fc_end_commit_fallback);
+
+/*
+ * Map the next free block of the fast commit area and hand its buffer
+ * head to the caller, who fills it and submits it.  The buffer is
+ * remembered in j_fc_wbuf so jbd2_fc_wait_bufs() and
+ * jbd2_fc_release_bufs() can find it again.
+ */
+int jbd2_fc_get_buf(journal_t *journal, struct buffer_head **bh_out)
+{
+	unsigned long long pblock;
+	unsigned long blocknr;
+	struct buffer_head *bh;
+	int fc_off;
+	int ret;
+
+	*bh_out = NULL;
+
+	if (journal->j_fc_first + journal->j_fc_off > journal->j_fc_last)
+		return -EINVAL;
+
+	fc_off = journal->j_fc_off;
+	blocknr = journal->j_fc_first + fc_off;
+	ret = jbd2_journal_bmap(journal, blocknr, &pblock);
+	if (ret)
+		return ret;
+
+	bh = __getblk(journal->j_dev, pblock, journal->j_blocksize);
+	if (!bh)
+		return -ENOMEM;
+
+	journal->j_fc_wbuf[fc_off] = bh;
+	journal->j_fc_off++;
+
+	*bh_out = bh;
+
+	return 0;
+}
+EXPORT_SYMBOL(jbd2_fc_get_buf);
+
+/*
+ * Wait on the last @num_blks fast commit buffers that were allocated by
+ * jbd2_fc_get_buf() and submitted by the caller.
+ */
+int jbd2_fc_wait_bufs(journal_t *journal, int num_blks)
+{
+	struct buffer_head *bh;
+	int i, j_fc_off;
+
+	j_fc_off = journal->j_fc_off;
+
+	for (i = j_fc_off - 1; i >= j_fc_off - num_blks; i--) {
+		bh = journal->j_fc_wbuf[i];
+		wait_on_buffer(bh);
+		put_bh(bh);
+		journal->j_fc_wbuf[i] = NULL;
+		if (unlikely(!buffer_uptodate(bh)))
+			return -EIO;
+	}
+
+	return 0;
+}
+EXPORT_SYMBOL(jbd2_fc_wait_bufs);
+
+/*
+ * Release any fast commit buffers still held, e.g. after a fallback.
+ */
+int jbd2_fc_release_bufs(journal_t *journal)
+{
+	struct buffer_head *bh;
+	int i, j_fc_off;
+
+	j_fc_off = journal->j_fc_off;
+
+	for (i = j_fc_off - 1; i >= 0; i--) {
+		bh = journal->j_fc_wbuf[i];
+		if (!bh)
+			break;
+		put_bh(bh);
+		journal->j_fc_wbuf[i] = NULL;
+	}
+
+	return 0;
+}
+EXPORT_SYMBOL(jbd2_fc_release_bufs);
+
 /*
  * Log buffer allocation routines:
  */
@@ -1102,6 +1276,7 @@ static journal_t * journal_init_common (void)
 	init_waitqueue_head(&journal->j_wait_commit);
 	init_waitqueue_head(&journal->j_wait_updates);
 	init_waitqueue_head(&journal->j_wait_reserved);
+	init_waitqueue_head(&journal->j_fc_wait);
 	mutex_init(&journal->j_barrier);
 	mutex_init(&journal->j_checkpoint_mutex);
 	spin_lock_init(&journal->j_revoke_lock);
@@ -1303,6 +1478,34 @@ static int journal_reset(journal_t *journal)
 	}
 
 	journal->j_first = first;
+
+	/*
+	 * The fast commit area lives at the tail of the journal; carve it
+	 * off before sizing the transaction space.
+	 */
+	if (jbd2_has_feature_fast_commit(journal)) {
+		journal->j_fc_last = last;
+		last -= jbd2_journal_get_num_fc_blks(sb);
+		journal->j_fc_first = last + 1;
+		journal->j_fc_off = 0;
+		if (first + JBD2_MIN_JOURNAL_BLOCKS > last + 1) {
+			printk(KERN_ERR "JBD2: Journal too short for fast commits (blocks %llu-%llu).\n",
+			       first, last);
+			journal_fail_superblock(journal);
+			return -EINVAL;
+		}
+		if (!journal->j_fc_wbuf) {
+			journal->j_fc_wbufsize =
+				journal->j_fc_last - journal->j_fc_first + 1;
+			journal->j_fc_wbuf = kcalloc(journal->j_fc_wbufsize,
+					sizeof(struct buffer_head *),
+					GFP_KERNEL);
+			if (!journal->j_fc_wbuf) {
+				journal_fail_superblock(journal);
+				return -ENOMEM;
+			}
+		}
+	}
 	journal->j_last = last;
 
 	journal->j_head = first;
@@ -1620,6 +1823,14 @@ static int load_superblock(journal_t *journal)
 	journal->j_last = be32_to_cpu(sb->s_maxlen);
 	journal->j_errno = be32_to_cpu(sb->s_errno);
 
+	/* Keep recovery away from the fast commit area */
+	if (jbd2_has_feature_fast_commit(journal)) {
+		journal->j_fc_last = journal->j_last;
+		journal->j_last -= jbd2_journal_get_num_fc_blks(sb);
+		journal->j_fc_first = journal->j_last + 1;
+		journal->j_fc_off = 0;
+	}
+
 	return 0;
 }
 
@@ -1752,6 +1963,7 @@ int jbd2_journal_destroy(journal_t *journal)
 		jbd2_journal_destroy_revoke(journal);
 	if (journal->j_chksum_driver)
 		crypto_free_shash(journal->j_chksum_driver);
+	kfree(journal->j_fc_wbuf);
 	kfree(journal->j_wbuf);
 	kfree(journal);
 
@@ -1598,13 +1598,30 @@ static int lookup_fast(struct nameidata *nd,
 	return err;
 }
 
-/* Fast lookup failed, do it the slow way */
-static struct dentry *lookup_slow(const struct qstr *name,
-				  struct dentry *dir,
-				  unsigned int flags)
+/*
+ * Hashed locks serializing slow lookups of one name when the parent
+ * directory is only held shared.  Without them, two walkers that both
+ * missed the dcache could each d_alloc() and call ->lookup() for the
+ * same name and hash duplicate dentries.  Collisions between different
+ * names merely cost a bit of parallelism.
+ */
+#define LOOKUP_SLOW_SHIFT	6
+static struct mutex lookup_slow_locks[1 << LOOKUP_SLOW_SHIFT];
+
+void __init namei_init(void)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(lookup_slow_locks); i++)
+		mutex_init(&lookup_slow_locks[i]);
+}
+
+static struct dentry *__lookup_slow(const struct qstr *name,
+				    struct dentry *dir,
+				    unsigned int flags)
 {
 	struct dentry *dentry;
-	inode_lock(dir->d_inode);
+
 	dentry = d_lookup(dir, name);
 	if (unlikely(dentry)) {
 		if ((dentry->d_flags & DCACHE_OP_REVALIDATE) &&
@@ -1617,18 +1634,46 @@ static struct dentry *lookup_slow(const struct qstr *name,
 				dentry = ERR_PTR(error);
 			}
 		}
-		if (dentry) {
-			inode_unlock(dir->d_inode);
+		if (dentry)
 			return dentry;
-		}
 	}
 	dentry = d_alloc(dir, name);
-	if (unlikely(!dentry)) {
-		inode_unlock(dir->d_inode);
+	if (unlikely(!dentry))
 		return ERR_PTR(-ENOMEM);
+
+	return lookup_real(dir->d_inode, dentry, flags);
+}
+
+/* Fast lookup failed, do it the slow way */
+static struct dentry *lookup_slow(const struct qstr *name,
+				  struct dentry *dir,
+				  unsigned int flags)
+{
+	struct inode *inode = dir->d_inode;
+	struct dentry *dentry;
+	struct mutex *lock;
+
+	if (!(dir->d_sb->s_type->fs_flags & FS_DIR_LOCK_SHARED)) {
+		inode_lock(inode);
+		dentry = __lookup_slow(name, dir, flags);
+		inode_unlock(inode);
+		return dentry;
 	}
-	dentry = lookup_real(dir->d_inode, dentry, flags);
-	inode_unlock(dir->d_inode);
+
+	/*
+	 * The filesystem lets lookups run in parallel; i_rwsem held
+	 * shared still excludes directory modification.  Walkers after
+	 * the same name serialize on a hashed lock, so only one of them
+	 * allocates a dentry and calls ->lookup(); the others then find
+	 * the winner's dentry in the dcache inside __lookup_slow().
+	 */
+	inode_lock_shared(inode);
+	lock = &lookup_slow_locks[hash_long((unsigned long)dir ^ name->hash,
+					    LOOKUP_SLOW_SHIFT)];
+	mutex_lock(lock);
+	dentry = __lookup_slow(name, dir, flags);
+	mutex_unlock(lock);
+	inode_unlock_shared(inode);
 	return dentry;
 }
 
@@ -659,6 +659,15 @@ int nfs_getattr(struct vfsmount *mnt, struct dentry *dentry, struct kstat *stat)
 	int err = 0;
 
 	trace_nfs_getattr_enter(inode);
+
+	/*
+	 * The caller asked for a cached-only answer (statx() with
+	 * AT_STATX_DONT_SYNC); don't flush dirty data or go to the
+	 * server, just report whatever attributes we currently hold.
+	 */
+	if (stat->query_flags & AT_STATX_DONT_SYNC)
+		goto out_no_update;
+
 	/* Flush out writes to the server in order to update c/mtime.  */
 	if (S_ISREG(inode->i_mode)) {
 		inode_lock(inode);
@@ -681,13 +690,15 @@ int nfs_getattr(struct vfsmount *mnt, struct dentry *dentry, struct kstat *stat)
  	    ((mnt->mnt_flags & MNT_NODIRATIME) && S_ISDIR(inode->i_mode)))
 		need_atime = 0;
 
-	if (need_atime || nfs_need_revalidate_inode(inode)) {
+	if ((stat->query_flags & AT_STATX_FORCE_SYNC) ||
+	    need_atime || nfs_need_revalidate_inode(inode)) {
 		struct nfs_server *server = NFS_SERVER(inode);
 
 		if (server->caps & NFS_CAP_READDIRPLUS)
 			nfs_request_parent_use_readdirplus(dentry);
 		err = __nfs_revalidate_inode(server, inode);
 	}
+out_no_update:
 	if (!err) {
 		generic_fillattr(inode, stat);
 		stat->ino = nfs_compat_user_ino64(NFS_FILEID(inode));
@@ -64,6 +64,9 @@ struct nfs_clone_mount {
  */
 #define NFS_MAX_READDIR_PAGES 8
 
+/* Maximum number of separate connections to the server (nconnect=) */
+#define NFS_MAX_CONNECTIONS 16
+
 struct nfs_client_initdata {
 	unsigned long init_flags;
 	const char *hostname;
@@ -72,6 +75,7 @@ struct nfs_client_initdata {
 	struct nfs_subversion *nfs_mod;
 	int proto;
 	u32 minorversion;
+	unsigned int nconnect;
 	struct net *net;
 };
 
@@ -111,6 +115,7 @@ struct nfs_parsed_mount_data {
 		char			*export_path;
 		int			port;
 		unsigned short		protocol;
+		unsigned short		nconnect;
 	} nfs_server;
 
 	struct security_mnt_opts lsm_opts;
@@ -643,6 +643,8 @@ static int fanotify_add_vfsmount_mark(struct fsnotify_group *group,
 		}
 	}
 	added = fanotify_mark_add_to_mask(fsn_mark, mask, flags);
+	if (added)
+		added = fsnotify_mark_interest(fsn_mark);
 	mutex_unlock(&group->mark_mutex);
 
 	if (added & ~real_mount(mnt)->mnt_fsnotify_mask)
@@ -681,6 +683,8 @@ static int fanotify_add_inode_mark(struct fsnotify_group *group,
 		}
 	}
 	added = fanotify_mark_add_to_mask(fsn_mark, mask, flags);
+	if (added)
+		added = fsnotify_mark_interest(fsn_mark);
 	mutex_unlock(&group->mark_mutex);
 
 	if (added & ~inode->i_fsnotify_mask)
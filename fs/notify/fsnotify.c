@@ -214,29 +214,25 @@ int fsnotify(struct inode *to_tell, __u32 mask, void *data, int data_is,
 	    (!mnt || hlist_empty(&mnt->mnt_fsnotify_marks)))
 		return 0;
 	/*
-	 * if this is a modify event we may need to clear the ignored masks
-	 * otherwise return if neither the inode nor the vfsmount care about
-	 * this type of event.
+	 * The cached masks include the ignored masks of the marks, plus
+	 * FS_MODIFY for marks whose ignored mask must be cleared on
+	 * modification, so a single test per object tells us whether any
+	 * mark wants to see or un-ignore this event.  Unwatched I/O gets
+	 * no further than this.
 	 */
-	if (!(mask & FS_MODIFY) &&
-	    !(test_mask & to_tell->i_fsnotify_mask) &&
+	if (!(test_mask & to_tell->i_fsnotify_mask) &&
 	    !(mnt && test_mask & mnt->mnt_fsnotify_mask))
 		return 0;
 
 	idx = srcu_read_lock(&fsnotify_mark_srcu);
 
-	if ((mask & FS_MODIFY) ||
-	    (test_mask & to_tell->i_fsnotify_mask))
+	if (test_mask & to_tell->i_fsnotify_mask)
 		inode_node = srcu_dereference(to_tell->i_fsnotify_marks.first,
 					      &fsnotify_mark_srcu);
 
-	if (mnt && ((mask & FS_MODIFY) ||
-		    (test_mask & mnt->mnt_fsnotify_mask))) {
+	if (mnt && (test_mask & mnt->mnt_fsnotify_mask))
 		vfsmount_node = srcu_dereference(mnt->mnt_fsnotify_marks.first,
 						 &fsnotify_mark_srcu);
-		inode_node = srcu_dereference(to_tell->i_fsnotify_marks.first,
-					      &fsnotify_mark_srcu);
-	}
 
 	/*
 	 * We need to merge inode & vfsmount mark lists so that inode mark
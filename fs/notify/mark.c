@@ -121,7 +121,7 @@ u32 fsnotify_recalc_mask(struct hlist_head *head)
 	struct fsnotify_mark *mark;
 
 	hlist_for_each_entry(mark, head, obj_list)
-		new_mask |= mark->mask;
+		new_mask |= fsnotify_mark_interest(mark);
 	return new_mask;
 }
 
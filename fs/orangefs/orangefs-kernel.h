@@ -646,9 +646,9 @@ do {									\
 	sys_attr.mask = ORANGEFS_ATTR_SYS_ALL_SETABLE;			\
 } while (0)
 
-#define orangefs_inode_lock(__i)  mutex_lock(&(__i)->i_mutex)
+#define orangefs_inode_lock(__i)  inode_lock(__i)
 
-#define orangefs_inode_unlock(__i) mutex_unlock(&(__i)->i_mutex)
+#define orangefs_inode_unlock(__i) inode_unlock(__i)
 
 static inline void orangefs_i_size_write(struct inode *inode, loff_t i_size)
 {
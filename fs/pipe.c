@@ -21,6 +21,7 @@
 #include <linux/audit.h>
 #include <linux/syscalls.h>
 #include <linux/fcntl.h>
+#include <linux/vmalloc.h>
 
 #include <asm/uaccess.h>
 #include <asm/ioctls.h>
@@ -237,16 +238,23 @@ pipe_read(struct kiocb *iocb, struct iov_iter *to)
 	size_t total_len = iov_iter_count(to);
 	struct file *filp = iocb->ki_filp;
 	struct pipe_inode_info *pipe = filp->private_data;
-	int do_wakeup;
+	bool was_full;
 	ssize_t ret;
 
 	/* Null read succeeds. */
 	if (unlikely(total_len == 0))
 		return 0;
 
-	do_wakeup = 0;
 	ret = 0;
 	__pipe_lock(pipe);
+
+	/*
+	 * Writers only block when the pipe is full, so there is no point
+	 * in waking them for every buffer we release: one wakeup per read
+	 * of a full pipe is enough.  This batches the scheduler work for
+	 * bulk transfers that drain many buffers per read.
+	 */
+	was_full = pipe->nrbufs == pipe->buffers;
 	for (;;) {
 		int bufs = pipe->nrbufs;
 		if (bufs) {
@@ -289,7 +297,6 @@ pipe_read(struct kiocb *iocb, struct iov_iter *to)
 				curbuf = (curbuf + 1) & (pipe->buffers - 1);
 				pipe->curbuf = curbuf;
 				pipe->nrbufs = --bufs;
-				do_wakeup = 1;
 			}
 			total_len -= chars;
 			if (!total_len)
@@ -317,16 +324,17 @@ pipe_read(struct kiocb *iocb, struct iov_iter *to)
 				ret = -ERESTARTSYS;
 			break;
 		}
-		if (do_wakeup) {
+		if (was_full) {
 			wake_up_interruptible_sync_poll(&pipe->wait, POLLOUT | POLLWRNORM);
  			kill_fasync(&pipe->fasync_writers, SIGIO, POLL_OUT);
 		}
 		pipe_wait(pipe);
+		was_full = pipe->nrbufs == pipe->buffers;
 	}
 	__pipe_unlock(pipe);
 
 	/* Signal writers asynchronously that there is more room. */
-	if (do_wakeup) {
+	if (was_full) {
 		wake_up_interruptible_sync_poll(&pipe->wait, POLLOUT | POLLWRNORM);
 		kill_fasync(&pipe->fasync_writers, SIGIO, POLL_OUT);
 	}
@@ -346,7 +354,6 @@ pipe_write(struct kiocb *iocb, struct iov_iter *from)
 	struct file *filp = iocb->ki_filp;
 	struct pipe_inode_info *pipe = filp->private_data;
 	ssize_t ret = 0;
-	int do_wakeup = 0;
 	size_t total_len = iov_iter_count(from);
 	ssize_t chars;
 
@@ -381,7 +388,6 @@ pipe_write(struct kiocb *iocb, struct iov_iter *from)
 				ret = -EFAULT;
 				goto out;
 			}
-			do_wakeup = 1;
 			buf->len += ret;
 			if (!iov_iter_count(from))
 				goto out;
@@ -412,12 +418,6 @@ pipe_write(struct kiocb *iocb, struct iov_iter *from)
 				}
 				pipe->tmp_page = page;
 			}
-			/* Always wake up, even if the copy fails. Otherwise
-			 * we lock up (O_NONBLOCK-)readers that sleep due to
-			 * syscall merging.
-			 * FIXME! Is this really true?
-			 */
-			do_wakeup = 1;
 			copied = copy_page_from_iter(page, 0, PAGE_SIZE, from);
 			if (unlikely(copied < PAGE_SIZE && iov_iter_count(from))) {
 				if (!ret)
@@ -454,10 +454,13 @@ pipe_write(struct kiocb *iocb, struct iov_iter *from)
 				ret = -ERESTARTSYS;
 			break;
 		}
-		if (do_wakeup) {
+		/*
+		 * We're about to drop the lock and sleep, so make sure a
+		 * reader sees the data we queued so far before we do.
+		 */
+		if (ret > 0) {
 			wake_up_interruptible_sync_poll(&pipe->wait, POLLIN | POLLRDNORM);
 			kill_fasync(&pipe->fasync_readers, SIGIO, POLL_IN);
-			do_wakeup = 0;
 		}
 		pipe->waiting_writers++;
 		pipe_wait(pipe);
@@ -465,7 +468,18 @@ pipe_write(struct kiocb *iocb, struct iov_iter *from)
 	}
 out:
 	__pipe_unlock(pipe);
-	if (do_wakeup) {
+	/*
+	 * The 'sync' wakeup gets the reader running as soon as possible
+	 * rather than leaving the data pending; small control writes (a
+	 * jobserver-style token, say) depend on that latency.
+	 *
+	 * Every write that added data must generate an event, not just
+	 * the one making the pipe non-empty: an edge-triggered poller
+	 * that drained only part of the pipe re-arms and then relies on
+	 * the next write for its wakeup even though the pipe never
+	 * emptied.
+	 */
+	if (ret > 0) {
 		wake_up_interruptible_sync_poll(&pipe->wait, POLLIN | POLLRDNORM);
 		kill_fasync(&pipe->fasync_readers, SIGIO, POLL_IN);
 	}
@@ -607,6 +621,23 @@ static bool too_many_pipe_buffers_hard(struct user_struct *user)
 	       atomic_long_read(&user->pipe_bufs) >= pipe_user_pages_hard;
 }
 
+/*
+ * The buffer array for a large ring is a multi-page, physically
+ * contiguous allocation if done with kmalloc alone, which becomes
+ * unreliable once memory is fragmented.  Fall back to vmalloc so that
+ * F_SETPIPE_SZ keeps working on long-running systems.
+ */
+static struct pipe_buffer *alloc_pipe_bufs(unsigned long nr_pages)
+{
+	struct pipe_buffer *bufs;
+
+	bufs = kcalloc(nr_pages, sizeof(*bufs),
+		       GFP_KERNEL | __GFP_NOWARN | __GFP_NORETRY);
+	if (!bufs)
+		bufs = vzalloc(nr_pages * sizeof(*bufs));
+	return bufs;
+}
+
 struct pipe_inode_info *alloc_pipe_info(void)
 {
 	struct pipe_inode_info *pipe;
@@ -619,7 +650,7 @@ struct pipe_inode_info *alloc_pipe_info(void)
 		if (!too_many_pipe_buffers_hard(user)) {
 			if (too_many_pipe_buffers_soft(user))
 				pipe_bufs = 1;
-			pipe->bufs = kzalloc(sizeof(struct pipe_buffer) * pipe_bufs, GFP_KERNEL);
+			pipe->bufs = alloc_pipe_bufs(pipe_bufs);
 		}
 
 		if (pipe->bufs) {
@@ -651,7 +682,7 @@ void free_pipe_info(struct pipe_inode_info *pipe)
 	}
 	if (pipe->tmp_page)
 		__free_page(pipe->tmp_page);
-	kfree(pipe->bufs);
+	kvfree(pipe->bufs);
 	kfree(pipe);
 }
 
@@ -1010,7 +1041,7 @@ static long pipe_set_size(struct pipe_inode_info *pipe, unsigned long nr_pages)
 	if (nr_pages < pipe->nrbufs)
 		return -EBUSY;
 
-	bufs = kcalloc(nr_pages, sizeof(*bufs), GFP_KERNEL | __GFP_NOWARN);
+	bufs = alloc_pipe_bufs(nr_pages);
 	if (unlikely(!bufs))
 		return -ENOMEM;
 
@@ -1037,7 +1068,7 @@ static long pipe_set_size(struct pipe_inode_info *pipe, unsigned long nr_pages)
 
 	account_pipe_buffers(pipe, pipe->buffers, nr_pages);
 	pipe->curbuf = 0;
-	kfree(pipe->bufs);
+	kvfree(pipe->bufs);
 	pipe->bufs = bufs;
 	pipe->buffers = nr_pages;
 	return nr_pages * PAGE_SIZE;
@@ -387,9 +387,11 @@ void propagate_mount_unlock(struct mount *mnt)
 }
 
 /*
- * Mark all mounts that the MNT_LOCKED logic will allow to be unmounted.
+ * Mark all mounts that the MNT_LOCKED logic will allow to be unmounted,
+ * and collect them on @candidates through their ->mnt_umounting.
  */
-static void mark_umount_candidates(struct mount *mnt)
+static void mark_umount_candidates(struct mount *mnt,
+				   struct list_head *candidates)
 {
 	struct mount *parent = mnt->mnt_parent;
 	struct mount *m;
@@ -402,6 +404,9 @@ static void mark_umount_candidates(struct mount *mnt)
 						mnt->mnt_mountpoint);
 		if (child && (!IS_MNT_LOCKED(child) || IS_MNT_MARKED(m))) {
 			SET_MNT_MARK(child);
+			if (list_empty(&child->mnt_umounting))
+				list_add_tail(&child->mnt_umounting,
+					      candidates);
 		}
 	}
 }
@@ -410,30 +415,19 @@ static void mark_umount_candidates(struct mount *mnt)
  * NOTE: unmounting 'mnt' naturally propagates to all other mounts its
  * parent propagates to.
  */
-static void __propagate_umount(struct mount *mnt)
+static void __propagate_umount(struct mount *child, struct list_head *list)
 {
-	struct mount *parent = mnt->mnt_parent;
-	struct mount *m;
-
-	BUG_ON(parent == mnt);
-
-	for (m = propagation_next(parent, parent); m;
-			m = propagation_next(m, parent)) {
-
-		struct mount *child = __lookup_mnt_last(&m->mnt,
-						mnt->mnt_mountpoint);
-		/*
-		 * umount the child only if the child has no children
-		 * and the child is marked safe to unmount.
-		 */
-		if (!child || !IS_MNT_MARKED(child))
-			continue;
-		CLEAR_MNT_MARK(child);
-		if (list_empty(&child->mnt_mounts)) {
-			list_del_init(&child->mnt_child);
-			child->mnt.mnt_flags |= MNT_UMOUNT;
-			list_move_tail(&child->mnt_list, &mnt->mnt_list);
-		}
+	CLEAR_MNT_MARK(child);
+	/*
+	 * umount the child only if the child has no children left;
+	 * any children it had that are going away themselves have
+	 * been unlinked from ->mnt_mounts already, as they were
+	 * marked deeper in the tree and thus handled before us.
+	 */
+	if (list_empty(&child->mnt_mounts)) {
+		list_del_init(&child->mnt_child);
+		child->mnt.mnt_flags |= MNT_UMOUNT;
+		list_move_tail(&child->mnt_list, list);
 	}
 }
 
@@ -447,11 +441,23 @@ static void __propagate_umount(struct mount *mnt)
 int propagate_umount(struct list_head *list)
 {
 	struct mount *mnt;
+	LIST_HEAD(candidates);
 
 	list_for_each_entry_reverse(mnt, list, mnt_list)
-		mark_umount_candidates(mnt);
+		mark_umount_candidates(mnt, &candidates);
 
-	list_for_each_entry(mnt, list, mnt_list)
-		__propagate_umount(mnt);
+	/*
+	 * Walk the collected candidates instead of rescanning every
+	 * propagation tree a second time.  Take them from the tail so
+	 * that copies propagated from submounts are torn down before
+	 * the copies of their parents are looked at, mirroring the
+	 * child-before-parent order of @list itself.
+	 */
+	while (!list_empty(&candidates)) {
+		struct mount *child = list_last_entry(&candidates,
+					struct mount, mnt_umounting);
+		list_del_init(&child->mnt_umounting);
+		__propagate_umount(child, list);
+	}
 	return 0;
 }
@@ -83,6 +83,7 @@
 #include <linux/tracehook.h>
 #include <linux/string_helpers.h>
 #include <linux/user_namespace.h>
+#include <linux/workqueue.h>
 
 #include <asm/pgtable.h>
 #include <asm/processor.h>
@@ -92,10 +93,13 @@ static inline void task_name(struct seq_file *m, struct task_struct *p)
 {
 	char *buf;
 	size_t size;
-	char tcomm[sizeof(p->comm)];
+	char tcomm[64];
 	int ret;
 
-	get_task_comm(tcomm, p);
+	if (p->flags & PF_WQ_WORKER)
+		wq_worker_comm(tcomm, sizeof(tcomm), p);
+	else
+		get_task_comm(tcomm, p);
 
 	seq_puts(m, "Name:\t");
 
@@ -390,7 +394,7 @@ static int do_task_stat(struct seq_file *m, struct pid_namespace *ns,
 	cputime_t cutime, cstime, utime, stime;
 	cputime_t cgtime, gtime;
 	unsigned long rsslim = 0;
-	char tcomm[sizeof(task->comm)];
+	char tcomm[64];
 	unsigned long flags;
 
 	state = *get_task_state(task);
@@ -405,7 +409,10 @@ static int do_task_stat(struct seq_file *m, struct pid_namespace *ns,
 		}
 	}
 
-	get_task_comm(tcomm, task);
+	if (task->flags & PF_WQ_WORKER)
+		wq_worker_comm(tcomm, sizeof(tcomm), task);
+	else
+		get_task_comm(tcomm, task);
 
 	sigemptyset(&sigign);
 	sigemptyset(&sigcatch);
@@ -87,6 +87,7 @@
 #include <linux/slab.h>
 #include <linux/flex_array.h>
 #include <linux/posix-timers.h>
+#include <linux/workqueue.h>
 #ifdef CONFIG_HARDWALL
 #include <asm/hardwall.h>
 #endif
@@ -1526,9 +1527,16 @@ static int comm_show(struct seq_file *m, void *v)
 	if (!p)
 		return -ESRCH;
 
-	task_lock(p);
-	seq_printf(m, "%s\n", p->comm);
-	task_unlock(p);
+	if (p->flags & PF_WQ_WORKER) {
+		char tcomm[64];
+
+		wq_worker_comm(tcomm, sizeof(tcomm), p);
+		seq_printf(m, "%s\n", tcomm);
+	} else {
+		task_lock(p);
+		seq_printf(m, "%s\n", p->comm);
+		task_unlock(p);
+	}
 
 	put_task_struct(p);
 
@@ -3156,6 +3164,110 @@ int proc_pid_readdir(struct file *file, struct dir_context *ctx)
 	return 0;
 }
 
+/*
+ * /proc/task_summary - one line per thread group:
+ *
+ *	<tgid> <state> <nr_threads> <utime> <stime>
+ *
+ * with times in clock ticks.  This gives monitoring tools a snapshot of
+ * every process in a single sequential read over the pid table, without
+ * instantiating a dentry and inode pair per pid the way walking the
+ * /proc/<pid> directories does.
+ */
+struct task_summary_private {
+	struct pid_namespace *ns;
+	struct tgid_iter iter;
+};
+
+static void *task_summary_start(struct seq_file *m, loff_t *pos)
+{
+	struct task_summary_private *priv = m->private;
+
+	priv->iter.tgid = *pos;
+	priv->iter.task = NULL;
+	priv->iter = next_tgid(priv->ns, priv->iter);
+	if (!priv->iter.task)
+		return NULL;
+	*pos = priv->iter.tgid;
+	return &priv->iter;
+}
+
+static void *task_summary_next(struct seq_file *m, void *v, loff_t *pos)
+{
+	struct task_summary_private *priv = m->private;
+
+	priv->iter.tgid++;
+	priv->iter = next_tgid(priv->ns, priv->iter);
+	if (!priv->iter.task)
+		return NULL;
+	*pos = priv->iter.tgid;
+	return &priv->iter;
+}
+
+static void task_summary_stop(struct seq_file *m, void *v)
+{
+	struct task_summary_private *priv = m->private;
+
+	if (priv->iter.task) {
+		put_task_struct(priv->iter.task);
+		priv->iter.task = NULL;
+	}
+}
+
+static int task_summary_show(struct seq_file *m, void *v)
+{
+	struct tgid_iter *iter = v;
+	struct task_struct *task = iter->task;
+	struct task_summary_private *priv = m->private;
+	cputime_t utime, stime;
+	unsigned int state;
+	/* Single-letter codes matching task_state_array[] in array.c */
+	static const char state_char[] = "RSDTtXZ";
+
+	if (!has_pid_permissions(priv->ns, task, 2))
+		return 0;
+
+	state = (task->state | task->exit_state) & TASK_REPORT;
+	thread_group_cputime_adjusted(task, &utime, &stime);
+	seq_printf(m, "%u %c %d %llu %llu\n",
+		   iter->tgid, state_char[fls(state)], get_nr_threads(task),
+		   (unsigned long long)cputime_to_clock_t(utime),
+		   (unsigned long long)cputime_to_clock_t(stime));
+	return 0;
+}
+
+static const struct seq_operations task_summary_seq_ops = {
+	.start	= task_summary_start,
+	.next	= task_summary_next,
+	.stop	= task_summary_stop,
+	.show	= task_summary_show,
+};
+
+static int task_summary_open(struct inode *inode, struct file *file)
+{
+	struct task_summary_private *priv;
+
+	priv = __seq_open_private(file, &task_summary_seq_ops, sizeof(*priv));
+	if (!priv)
+		return -ENOMEM;
+	priv->ns = inode->i_sb->s_fs_info;
+	return 0;
+}
+
+static const struct file_operations proc_task_summary_operations = {
+	.open		= task_summary_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= seq_release_private,
+};
+
+static int __init proc_task_summary_init(void)
+{
+	proc_create("task_summary", 0, NULL, &proc_task_summary_operations);
+	return 0;
+}
+fs_initcall(proc_task_summary_init);
+
 /*
  * Tasks
  */
@@ -158,7 +158,13 @@ static struct file_system_type proc_fs_type = {
 	.name		= "proc",
 	.mount		= proc_mount,
 	.kill_sb	= proc_kill_sb,
-	.fs_flags	= FS_USERNS_VISIBLE | FS_USERNS_MOUNT,
+	/*
+	 * proc guards its directory contents with proc_subdir_lock and
+	 * RCU tasklist walks, so lookups and readdir are safe under a
+	 * shared i_rwsem.
+	 */
+	.fs_flags	= FS_USERNS_VISIBLE | FS_USERNS_MOUNT |
+			  FS_DIR_LOCK_SHARED,
 };
 
 void __init proc_root_init(void)
@@ -24,6 +24,7 @@
 int iterate_dir(struct file *file, struct dir_context *ctx)
 {
 	struct inode *inode = file_inode(file);
+	bool shared = inode->i_sb->s_type->fs_flags & FS_DIR_LOCK_SHARED;
 	int res = -ENOTDIR;
 	if (!file->f_op->iterate)
 		goto out;
@@ -32,9 +33,19 @@ int iterate_dir(struct file *file, struct dir_context *ctx)
 	if (res)
 		goto out;
 
-	res = mutex_lock_killable(&inode->i_mutex);
-	if (res)
-		goto out;
+	/*
+	 * Readers of the same struct file are already serialized on
+	 * f_pos_lock, so taking i_rwsem shared only admits other open
+	 * instances of the directory, which FS_DIR_LOCK_SHARED
+	 * filesystems have promised to cope with.
+	 */
+	if (shared)
+		inode_lock_shared(inode);
+	else {
+		res = down_write_killable(&inode->i_rwsem);
+		if (res)
+			goto out;
+	}
 
 	res = -ENOENT;
 	if (!IS_DEADDIR(inode)) {
@@ -44,7 +55,10 @@ int iterate_dir(struct file *file, struct dir_context *ctx)
 		fsnotify_access(file);
 		file_accessed(file);
 	}
-	inode_unlock(inode);
+	if (shared)
+		inode_unlock_shared(inode);
+	else
+		inode_unlock(inode);
 out:
 	return res;
 }
@@ -164,10 +164,19 @@ static int timerfd_setup(struct timerfd_ctx *ctx, int flags,
 	enum hrtimer_mode htmode;
 	ktime_t texp;
 	int clockid = ctx->clockid;
+	unsigned long slack = 0;
 
 	htmode = (flags & TFD_TIMER_ABSTIME) ?
 		HRTIMER_MODE_ABS: HRTIMER_MODE_REL;
 
+	/*
+	 * Coarse timers expire anywhere within the task's timer slack
+	 * window so that neighbouring timers coalesce into a single
+	 * hardware event.  The window is tunable via PR_SET_TIMERSLACK.
+	 */
+	if (flags & TFD_TIMER_COARSE)
+		slack = current->timer_slack_ns;
+
 	texp = timespec_to_ktime(ktmr->it_value);
 	ctx->expired = 0;
 	ctx->ticks = 0;
@@ -191,7 +200,8 @@ static int timerfd_setup(struct timerfd_ctx *ctx, int flags,
 			else
 				alarm_start_relative(&ctx->t.alarm, texp);
 		} else {
-			hrtimer_start(&ctx->t.tmr, texp, htmode);
+			hrtimer_start_range_ns(&ctx->t.tmr, texp, slack,
+					       htmode);
 		}
 
 		if (timerfd_canceled(ctx))
@@ -39,6 +39,8 @@
 
 STATIC void __xfs_inode_clear_reclaim_tag(struct xfs_mount *mp,
 				struct xfs_perag *pag, struct xfs_inode *ip);
+STATIC int xfs_reclaim_inodes_ag(struct xfs_mount *mp, int flags,
+				int *nr_to_scan, struct list_head *buffer_list);
 
 /*
  * Allocate and initialise an xfs_inode.
@@ -748,6 +750,12 @@ xfs_reclaim_work_queue(
  * seconds, as well as being kicked by the inode cache shrinker when memory
  * goes low. It scans as quickly as possible avoiding locked inodes or those
  * already being flushed, and once done schedules a future pass.
+ *
+ * Clean inodes are reclaimed immediately; dirty inodes are gathered up on a
+ * delwri buffer list so that their flushes are issued as a single batch of
+ * sorted, asynchronous I/O. The inodes themselves are then reclaimed by a
+ * later pass once the writeback has completed, which keeps the dirty backlog
+ * bounded without the memory reclaim path ever waiting on inode I/O.
  */
 void
 xfs_reclaim_worker(
@@ -755,8 +763,11 @@ xfs_reclaim_worker(
 {
 	struct xfs_mount *mp = container_of(to_delayed_work(work),
 					struct xfs_mount, m_reclaim_work);
+	int			nr_to_scan = INT_MAX;
+	LIST_HEAD(buffer_list);
 
-	xfs_reclaim_inodes(mp, SYNC_TRYLOCK);
+	xfs_reclaim_inodes_ag(mp, SYNC_TRYLOCK, &nr_to_scan, &buffer_list);
+	xfs_buf_delwri_submit_nowait(&buffer_list);
 	xfs_reclaim_work_queue(mp);
 }
 
@@ -919,14 +930,15 @@ xfs_reclaim_inode_grab(
  *	pinned, sync	=> unpin
  *	stale		=> reclaim
  *	clean		=> reclaim
- *	dirty, async	=> requeue
+ *	dirty, async	=> queue for delayed write, requeue
  *	dirty, sync	=> flush, wait and reclaim
  */
 STATIC int
 xfs_reclaim_inode(
 	struct xfs_inode	*ip,
 	struct xfs_perag	*pag,
-	int			sync_mode)
+	int			sync_mode,
+	struct list_head	*buffer_list)
 {
 	struct xfs_buf		*bp = NULL;
 	int			error;
@@ -956,11 +968,34 @@ restart:
 		goto reclaim;
 
 	/*
-	 * Never flush out dirty data during non-blocking reclaim, as it would
-	 * just contend with AIL pushing trying to do the same job.
+	 * Never do synchronous writeout during non-blocking reclaim. If the
+	 * caller supplied a delwri buffer list we start writeback of the
+	 * inode here and leave the actual reclaim to a later pass, once the
+	 * flush has completed and the inode is clean. That keeps all the I/O
+	 * batched and sorted by the delwri list submission. Without a buffer
+	 * list just leave the inode alone - flushing it would only contend
+	 * with AIL pushing trying to do the same job.
 	 */
-	if (!(sync_mode & SYNC_WAIT))
-		goto out_ifunlock;
+	if (!(sync_mode & SYNC_WAIT)) {
+		if (!buffer_list)
+			goto out_ifunlock;
+		/*
+		 * xfs_iflush() drops the flush lock on failure, and buffer
+		 * I/O completion releases it on success, so it is no longer
+		 * ours to unlock in either case.
+		 */
+		error = xfs_iflush(ip, &bp);
+		if (!error) {
+			/*
+			 * The buffer may already sit on the AIL delwri queue;
+			 * in that case someone else writes it for us.
+			 */
+			xfs_buf_delwri_queue(bp, buffer_list);
+			xfs_buf_relse(bp);
+		}
+		error = 0;
+		goto out;
+	}
 
 	/*
 	 * Now we have an inode that needs flushing.
@@ -1051,7 +1086,8 @@ STATIC int
 xfs_reclaim_inodes_ag(
 	struct xfs_mount	*mp,
 	int			flags,
-	int			*nr_to_scan)
+	int			*nr_to_scan,
+	struct list_head	*buffer_list)
 {
 	struct xfs_perag	*pag;
 	int			error = 0;
@@ -1134,7 +1170,8 @@ restart:
 			for (i = 0; i < nr_found; i++) {
 				if (!batch[i])
 					continue;
-				error = xfs_reclaim_inode(batch[i], pag, flags);
+				error = xfs_reclaim_inode(batch[i], pag, flags,
+							  buffer_list);
 				if (error && last_error != -EFSCORRUPTED)
 					last_error = error;
 			}
@@ -1174,17 +1211,17 @@ xfs_reclaim_inodes(
 {
 	int		nr_to_scan = INT_MAX;
 
-	return xfs_reclaim_inodes_ag(mp, mode, &nr_to_scan);
+	return xfs_reclaim_inodes_ag(mp, mode, &nr_to_scan, NULL);
 }
 
 /*
  * Scan a certain number of inodes for reclaim.
  *
  * When called we make sure that there is a background (fast) inode reclaim in
- * progress, while we will throttle the speed of reclaim via doing synchronous
- * reclaim of inodes. That means if we come across dirty inodes, we wait for
- * them to be cleaned, which we hope will not be very long due to the
- * background walker having already kicked the IO off on those dirty inodes.
+ * progress, while we only reclaim inodes that are already clean. Dirty inodes
+ * are skipped here and left to the background worker and AIL pushing to clean
+ * them, so memory reclaim never blocks on inode writeback. Kicking the AIL
+ * here throttles us slightly against the rate at which inodes are cleaned.
  */
 long
 xfs_reclaim_inodes_nr(
@@ -1195,7 +1232,7 @@ xfs_reclaim_inodes_nr(
 	xfs_reclaim_work_queue(mp);
 	xfs_ail_push_all(mp->m_ail);
 
-	return xfs_reclaim_inodes_ag(mp, SYNC_TRYLOCK | SYNC_WAIT, &nr_to_scan);
+	return xfs_reclaim_inodes_ag(mp, SYNC_TRYLOCK, &nr_to_scan, NULL);
 }
 
 /*
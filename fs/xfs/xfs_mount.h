@@ -304,8 +304,8 @@ typedef struct xfs_perag {
 	unsigned long	pag_ici_reclaim_cursor;	/* reclaim restart point */
 
 	/* buffer cache index */
-	spinlock_t	pag_buf_lock;	/* lock for pag_buf_tree */
-	struct rb_root	pag_buf_tree;	/* ordered tree of active buffers */
+	spinlock_t	pag_buf_lock;	/* protects hash insert/remove */
+	struct rhashtable pag_buf_hash;	/* active buffers, RCU lookups */
 
 	/* for rcu-safe freeing */
 	struct rcu_head	rcu_head;
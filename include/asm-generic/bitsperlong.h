@@ -22,4 +22,14 @@
 #define BITS_PER_LONG_LONG 64
 #endif
 
+/*
+ * small_const_nbits(n) is true precisely when it is known at compile-time
+ * that BITMAP_SIZE(n) is 1, i.e. 1 <= n <= BITS_PER_LONG.  This allows
+ * various bit/bitmap APIs to provide a fast inline implementation.  It
+ * lives here rather than in linux/bitmap.h so that the inline bit search
+ * wrappers in asm-generic/bitops/find.h can use it too.
+ */
+#define small_const_nbits(nbits) \
+	(__builtin_constant_p(nbits) && (nbits) <= BITS_PER_LONG && (nbits) > 0)
+
 #endif /* __ASM_GENERIC_BITS_PER_LONG */
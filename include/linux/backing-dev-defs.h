@@ -109,6 +109,15 @@ struct bdi_writeback {
 	unsigned long dirty_ratelimit;
 	unsigned long balanced_dirty_ratelimit;
 
+	/*
+	 * Cached __wb_calc_thresh() result so that throttled tasks don't
+	 * all re-sum the completion fraction's percpu counters; refreshed
+	 * when older than BANDWIDTH_INTERVAL or the domain thresh moved.
+	 */
+	unsigned long wb_thresh_cache;
+	unsigned long wb_thresh_input;	/* domain thresh it was derived from */
+	unsigned long wb_thresh_stamp;	/* jiffies of last refresh */
+
 	struct fprop_local_percpu completions;
 	int dirty_exceeded;
 
@@ -133,6 +142,17 @@ struct bdi_writeback {
 #endif
 };
 
+/*
+ * Each extra flusher worker beyond the one driven by wb_workfn() is
+ * represented by one of these.  They are allocated when
+ * /sys/class/bdi/<dev>/nr_flushers is raised above one and all drain the
+ * dirty lists of the bdi's root wb.
+ */
+struct wb_flusher {
+	struct work_struct work;
+	struct bdi_writeback *wb;
+};
+
 struct backing_dev_info {
 	struct list_head bdi_list;
 	unsigned long ra_pages;	/* max readahead in PAGE_CACHE_SIZE units */
@@ -145,6 +165,14 @@ struct backing_dev_info {
 	unsigned int min_ratio;
 	unsigned int max_ratio, max_prop_frac;
 
+	/*
+	 * Number of workers concurrently writing back the root wb,
+	 * including wb_workfn() itself, and the nr_flushers - 1 helpers.
+	 * Both are protected by wb.work_lock.
+	 */
+	unsigned int nr_flushers;
+	struct wb_flusher *flushers;
+
 	/*
 	 * Sum of avg_write_bw of wbs with dirty inodes.  > 0 if there are
 	 * any dirty wbs, which is depended upon by bdi_has_dirty().
@@ -129,6 +129,7 @@ static inline unsigned long wb_stat_error(struct bdi_writeback *wb)
 
 int bdi_set_min_ratio(struct backing_dev_info *bdi, unsigned int min_ratio);
 int bdi_set_max_ratio(struct backing_dev_info *bdi, unsigned int max_ratio);
+int bdi_set_nr_flushers(struct backing_dev_info *bdi, unsigned int nr_flushers);
 
 /*
  * Flags in backing_dev_info::capability
@@ -185,8 +185,10 @@ extern int bitmap_print_to_pagebuf(bool list, char *buf,
 #define BITMAP_FIRST_WORD_MASK(start) (~0UL << ((start) & (BITS_PER_LONG - 1)))
 #define BITMAP_LAST_WORD_MASK(nbits) (~0UL >> (-(nbits) & (BITS_PER_LONG - 1)))
 
-#define small_const_nbits(nbits) \
-	(__builtin_constant_p(nbits) && (nbits) <= BITS_PER_LONG)
+/*
+ * small_const_nbits(nbits) is defined in asm-generic/bitsperlong.h so
+ * that the inline bit search functions can use it as well.
+ */
 
 static inline void bitmap_zero(unsigned long *dst, unsigned int nbits)
 {
@@ -336,6 +338,34 @@ static inline int bitmap_parse(const char *buf, unsigned int buflen,
 	return __bitmap_parse(buf, buflen, 0, maskp, nmaskbits);
 }
 
+static inline void bitmap_next_set_region(const unsigned long *bitmap,
+					  unsigned int *rs, unsigned int *re,
+					  unsigned int end)
+{
+	*rs = find_next_bit(bitmap, end, *rs);
+	*re = find_next_zero_bit(bitmap, end, *rs + 1);
+}
+
+/**
+ * bitmap_for_each_set_region - iterate over every contiguous region of set
+ *	bits in @bitmap
+ * @bitmap: the bitmap to iterate over
+ * @rs: region start bit, updated on each iteration
+ * @re: region end bit (exclusive), updated on each iteration
+ * @start: first bit to consider
+ * @end: past-the-end bit to consider
+ *
+ * Walking runs of set bits this way visits each word once per region
+ * instead of once per bit, which is what the bit-at-a-time callers of
+ * find_next_bit() end up doing.
+ */
+#define bitmap_for_each_set_region(bitmap, rs, re, start, end)		     \
+	for ((rs) = (start),						     \
+	     bitmap_next_set_region((bitmap), &(rs), &(re), (end));	     \
+	     (rs) < (re);						     \
+	     (rs) = (re) + 1,						     \
+	     bitmap_next_set_region((bitmap), &(rs), &(re), (end)))
+
 #endif /* __ASSEMBLY__ */
 
 #endif /* __LINUX_BITMAP_H */
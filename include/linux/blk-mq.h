@@ -5,6 +5,7 @@
 
 struct blk_mq_tags;
 struct blk_flush_queue;
+struct blk_mq_sched_ops;
 
 struct blk_mq_cpu_notifier {
 	struct list_head list;
@@ -38,6 +39,9 @@ struct blk_mq_hw_ctx {
 
 	void			*driver_data;
 
+	const struct blk_mq_sched_ops	*sched_ops;
+	void			*sched_data;
+
 	struct blk_mq_ctxmap	ctx_map;
 
 	unsigned int		nr_ctx;
@@ -52,6 +56,20 @@ struct blk_mq_hw_ctx {
 #define BLK_MQ_MAX_DISPATCH_ORDER	10
 	unsigned long		dispatched[BLK_MQ_MAX_DISPATCH_ORDER];
 
+	/*
+	 * Always-on completion latency histograms, one counter per log2
+	 * microsecond bucket, and in-flight depth accounting.  Updated
+	 * locklessly, see blk_mq_stat_done().
+	 */
+#define BLK_MQ_LAT_READ		0
+#define BLK_MQ_LAT_WRITE	1
+#define BLK_MQ_LAT_FLUSH	2
+#define BLK_MQ_LAT_NR		3
+#define BLK_MQ_LAT_BUCKETS	32
+	u64			lat_hist[BLK_MQ_LAT_NR][BLK_MQ_LAT_BUCKETS];
+	atomic_t		stat_inflight;
+	unsigned int		stat_inflight_hwm;
+
 	unsigned int		numa_node;
 	unsigned int		queue_num;
 
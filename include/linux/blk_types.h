@@ -66,6 +66,9 @@ struct bio {
 	unsigned int		bi_seg_front_size;
 	unsigned int		bi_seg_back_size;
 
+	/* Write life time hint, from the inode this data belongs to */
+	unsigned short		bi_write_hint;
+
 	atomic_t		__bi_remaining;
 
 	bio_end_io_t		*bi_end_io;
@@ -120,6 +123,11 @@ struct bio {
 #define BIO_QUIET	6	/* Make BIO Quiet */
 #define BIO_CHAIN	7	/* chained bio, ->bi_remaining in effect */
 #define BIO_REFFED	8	/* bio has elevated ->bi_cnt */
+#define BIO_MULTI_PAGE	9	/* bvecs may span page boundaries; only set
+				 * this if nothing walking the bio expects
+				 * one page per bvec (bio_add_page() then
+				 * merges physically contiguous pages)
+				 */
 
 /*
  * Flags starting here get preserved by bio_reset() - this includes
@@ -188,6 +196,7 @@ enum rq_flag_bits {
 	__REQ_PM,		/* runtime pm request */
 	__REQ_HASHED,		/* on IO scheduler merge hash */
 	__REQ_MQ_INFLIGHT,	/* track inflight for MQ */
+	__REQ_BG_WB,		/* background write, counted by blk-wbt */
 	__REQ_NR_BITS,		/* stops here */
 };
 
@@ -241,6 +250,7 @@ enum rq_flag_bits {
 #define REQ_PM			(1ULL << __REQ_PM)
 #define REQ_HASHED		(1ULL << __REQ_HASHED)
 #define REQ_MQ_INFLIGHT		(1ULL << __REQ_MQ_INFLIGHT)
+#define REQ_BG_WB		(1ULL << __REQ_BG_WB)
 
 typedef unsigned int blk_qc_t;
 #define BLK_QC_T_NONE	-1U
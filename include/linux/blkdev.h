@@ -36,7 +36,9 @@ struct sg_io_hdr;
 struct bsg_job;
 struct blkcg_gq;
 struct blk_flush_queue;
+struct blk_mq_sched_ops;
 struct pr_ops;
+struct rq_wb;
 
 #define BLKDEV_MIN_RQ	4
 #define BLKDEV_MAX_RQ	128	/* Default maximum */
@@ -80,6 +82,9 @@ enum rq_cmd_type_bits {
 
 #define BLK_MAX_CDB	16
 
+/* Number of distinct write life time hints a device may act upon */
+#define BLK_MAX_WRITE_HINTS	5
+
 /*
  * Try to put the fields that are referenced together in the same cacheline.
  *
@@ -153,6 +158,7 @@ struct request {
 	struct gendisk *rq_disk;
 	struct hd_struct *part;
 	unsigned long start_time;
+	u64 issue_ns;		/* driver issue time, for blk-wbt and hctx stats */
 #ifdef CONFIG_BLK_CGROUP
 	struct request_list *rl;		/* rl this rq is alloced from */
 	unsigned long long start_time_ns;
@@ -168,6 +174,8 @@ struct request {
 
 	unsigned short ioprio;
 
+	unsigned short write_hint;
+
 	void *special;		/* opaque pointer available for LLD use */
 
 	int tag;
@@ -308,6 +316,7 @@ struct request_queue {
 	lld_busy_fn		*lld_busy_fn;
 
 	struct blk_mq_ops	*mq_ops;
+	const struct blk_mq_sched_ops *mq_sched;
 
 	unsigned int		*mq_map;
 
@@ -319,6 +328,17 @@ struct request_queue {
 	struct blk_mq_hw_ctx	**queue_hw_ctx;
 	unsigned int		nr_hw_queues;
 
+	/*
+	 * Hybrid polling, see blk_poll().  poll_delay is -1 for classic
+	 * spin polling, 0 to sleep for half the observed mean completion
+	 * time first, > 0 for a fixed sleep of that many microseconds.
+	 */
+	int			poll_delay;
+	u64			poll_mean_ns;
+
+	/* background writeback throttling, see blk-wbt.c */
+	struct rq_wb		*rq_wb;
+
 	/*
 	 * Dispatch queue sorting
 	 */
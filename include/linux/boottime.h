@@ -0,0 +1,44 @@
+#ifndef _LINUX_BOOTTIME_H
+#define _LINUX_BOOTTIME_H
+
+#include <linux/init.h>
+#include <linux/types.h>
+
+struct device;
+struct device_driver;
+
+/*
+ * Always-on boot phase accounting.  Unlike initcall_debug this does not
+ * printk in the middle of boot; each timed region is appended to a fixed
+ * table and exported through /proc/boottime once userspace is up.
+ */
+#ifdef CONFIG_BOOT_PHASE_TIMING
+extern u64 boottime_stamp(void);
+extern void boottime_record_initcall(initcall_t fn, u64 start_ns, int ret);
+extern void boottime_record_probe(struct device_driver *drv,
+				  struct device *dev, u64 start_ns, int ret);
+extern void boottime_record_phase(const char *name, u64 start_ns);
+extern void boottime_finish(void);
+#else
+static inline u64 boottime_stamp(void)
+{
+	return 0;
+}
+static inline void boottime_record_initcall(initcall_t fn, u64 start_ns,
+					    int ret)
+{
+}
+static inline void boottime_record_probe(struct device_driver *drv,
+					 struct device *dev, u64 start_ns,
+					 int ret)
+{
+}
+static inline void boottime_record_phase(const char *name, u64 start_ns)
+{
+}
+static inline void boottime_finish(void)
+{
+}
+#endif
+
+#endif /* _LINUX_BOOTTIME_H */
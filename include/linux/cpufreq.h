@@ -108,6 +108,9 @@ struct cpufreq_policy {
 	wait_queue_head_t	transition_wait;
 	struct task_struct	*transition_task; /* Task which is doing the transition */
 
+	/* Set if the driver's ->fast_switch() callback may be used */
+	bool			fast_switch_possible;
+
 	/* cpufreq-stats */
 	struct cpufreq_stats	*stats;
 
@@ -256,6 +259,16 @@ struct cpufreq_driver {
 	int		(*target_intermediate)(struct cpufreq_policy *policy,
 					       unsigned int index);
 
+	/*
+	 * Switch the frequency of the policy's CPUs without sleeping.  May
+	 * be called from scheduler context with interrupts disabled and no
+	 * transition notifiers are run around it.  Returns the frequency
+	 * actually set or 0 on failure, in which case the hardware
+	 * configuration must not have been changed.
+	 */
+	unsigned int	(*fast_switch)(struct cpufreq_policy *policy,
+				       unsigned int target_freq);
+
 	/* should be defined, if possible */
 	unsigned int	(*get)(unsigned int cpu);
 
@@ -450,6 +463,9 @@ struct cpufreq_governor {
 };
 
 /* Pass a target to the cpufreq driver */
+bool cpufreq_driver_has_fast_switch(struct cpufreq_policy *policy);
+unsigned int cpufreq_driver_fast_switch(struct cpufreq_policy *policy,
+					unsigned int target_freq);
 int cpufreq_driver_target(struct cpufreq_policy *policy,
 				 unsigned int target_freq,
 				 unsigned int relation);
@@ -38,6 +38,15 @@ static inline u32 crc32_le_combine(u32 crc1, u32 crc2, size_t len2)
 
 u32 __pure __crc32c_le(u32 crc, unsigned char const *p, size_t len);
 
+/*
+ * Hook for an architecture-accelerated CRC32C implementation; see
+ * crc32c_register_hw() in lib/crc32.c. The function must be safe to
+ * call from any context.
+ */
+typedef u32 (*crc32c_hw_fn_t)(u32 crc, unsigned char const *p, size_t len);
+int crc32c_register_hw(crc32c_hw_fn_t fn);
+void crc32c_unregister_hw(crc32c_hw_fn_t fn);
+
 /**
  * __crc32c_le_combine - Combine two crc32c check values into one. For two
  * 			 sequences of bytes, seq1 and seq2 with lengths len1
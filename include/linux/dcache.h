@@ -61,10 +61,14 @@ struct dentry_stat_t {
 	long nr_unused;
 	long age_limit;          /* age in seconds */
 	long want_pages;         /* pages requested by system */
-	long dummy[2];
+	long nr_negative;        /* # of negative dentries */
+	long dummy;
 };
 extern struct dentry_stat_t dentry_stat;
 
+/* Ceiling on per-sb negative dentries, 0 for no limit */
+extern unsigned long sysctl_negative_dentry_limit;
+
 /* Name hashing routines. Initial hash value */
 /* Hash courtesy of the R5 hash in reiserfs modulo sign bits */
 #define init_name_hash()		0
@@ -241,6 +241,23 @@ struct fsnotify_mark {
 	void (*free_mark)(struct fsnotify_mark *mark); /* called on final put+free */
 };
 
+/*
+ * Events this mark needs to see to maintain its state.  That is everything
+ * in its mask and ignored mask, plus FS_MODIFY if the ignored mask has to
+ * be cleared on modification.  The per-object cached event masks are built
+ * from these, so that events nobody cares about are dropped on a single
+ * mask test without entering the SRCU section.
+ */
+static inline __u32 fsnotify_mark_interest(struct fsnotify_mark *mark)
+{
+	__u32 mask = mark->mask | mark->ignored_mask;
+
+	if (mark->ignored_mask &&
+	    !(mark->flags & FSNOTIFY_MARK_FLAG_IGNORED_SURV_MODIFY))
+		mask |= FS_MODIFY;
+	return mask;
+}
+
 #ifdef CONFIG_FSNOTIFY
 
 /* called from the vfs helpers */
@@ -1,6 +1,7 @@
 #ifndef _LINUX_FUTEX_H
 #define _LINUX_FUTEX_H
 
+#include <linux/errno.h>
 #include <uapi/linux/futex.h>
 
 struct inode;
@@ -55,6 +56,9 @@ union futex_key {
 #ifdef CONFIG_FUTEX
 extern void exit_robust_list(struct task_struct *curr);
 extern void exit_pi_state_list(struct task_struct *curr);
+extern long futex_hash_allocate(unsigned long slots);
+extern long futex_hash_get_slots(void);
+extern void futex_hash_free(struct mm_struct *mm);
 #ifdef CONFIG_HAVE_FUTEX_CMPXCHG
 #define futex_cmpxchg_enabled 1
 #else
@@ -67,5 +71,16 @@ static inline void exit_robust_list(struct task_struct *curr)
 static inline void exit_pi_state_list(struct task_struct *curr)
 {
 }
+static inline long futex_hash_allocate(unsigned long slots)
+{
+	return -EINVAL;
+}
+static inline long futex_hash_get_slots(void)
+{
+	return 0;
+}
+static inline void futex_hash_free(struct mm_struct *mm)
+{
+}
 #endif
 #endif
@@ -168,9 +168,14 @@ struct ida_bitmap {
 struct ida {
 	struct idr		idr;
 	struct ida_bitmap	*free_bitmap;
+	spinlock_t		simple_lock;	/* serializes the simple API */
 };
 
-#define IDA_INIT(name)		{ .idr = IDR_INIT((name).idr), .free_bitmap = NULL, }
+#define IDA_INIT(name)		{					\
+	.idr = IDR_INIT((name).idr),					\
+	.free_bitmap = NULL,						\
+	.simple_lock = __SPIN_LOCK_UNLOCKED((name).simple_lock),	\
+}
 #define DEFINE_IDA(name)	struct ida name = IDA_INIT(name)
 
 int ida_pre_get(struct ida *ida, gfp_t gfp_mask);
@@ -278,6 +278,12 @@ extern int irq_set_affinity_hint(unsigned int irq, const struct cpumask *m);
 extern int
 irq_set_affinity_notifier(unsigned int irq, struct irq_affinity_notify *notify);
 
+struct irq_affinity_spread;
+
+extern struct irq_affinity_spread *
+irq_alloc_managed_spread(const unsigned int *irqs, unsigned int nr_irqs);
+extern void irq_free_managed_spread(struct irq_affinity_spread *spread);
+
 #else /* CONFIG_SMP */
 
 static inline int irq_set_affinity(unsigned int irq, const struct cpumask *m)
@@ -308,6 +314,18 @@ irq_set_affinity_notifier(unsigned int irq, struct irq_affinity_notify *notify)
 {
 	return 0;
 }
+
+struct irq_affinity_spread;
+
+static inline struct irq_affinity_spread *
+irq_alloc_managed_spread(const unsigned int *irqs, unsigned int nr_irqs)
+{
+	return NULL;
+}
+
+static inline void irq_free_managed_spread(struct irq_affinity_spread *spread)
+{
+}
 #endif /* CONFIG_SMP */
 
 /*
@@ -0,0 +1,52 @@
+/*
+ * Task isolation support for NO_HZ_FULL cpus.
+ */
+#ifndef _LINUX_ISOLATION_H
+#define _LINUX_ISOLATION_H
+
+#include <linux/prctl.h>
+#include <linux/sched.h>
+
+#ifdef CONFIG_TASK_ISOLATION
+
+extern int task_isolation_set(unsigned int flags);
+
+static inline int task_isolation_get(void)
+{
+	return current->task_isolation_flags;
+}
+
+extern void _task_isolation_interrupt(struct task_struct *task,
+				      const char *what);
+
+/*
+ * Notify an isolated task that the kernel is about to interrupt it.
+ * Called from interrupt context with the task's rq cpu == this cpu.
+ */
+static inline void task_isolation_interrupt(struct task_struct *task,
+					    const char *what)
+{
+	if (unlikely(task->task_isolation_flags & PR_TASK_ISOLATION_USERSIG))
+		_task_isolation_interrupt(task, what);
+}
+
+#else /* !CONFIG_TASK_ISOLATION */
+
+static inline int task_isolation_set(unsigned int flags)
+{
+	return -EINVAL;
+}
+
+static inline int task_isolation_get(void)
+{
+	return -EINVAL;
+}
+
+static inline void task_isolation_interrupt(struct task_struct *task,
+					    const char *what)
+{
+}
+
+#endif /* CONFIG_TASK_ISOLATION */
+
+#endif /* _LINUX_ISOLATION_H */
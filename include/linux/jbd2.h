@@ -71,6 +71,12 @@ extern void jbd2_free(void *ptr, size_t size);
 
 #define JBD2_MIN_JOURNAL_BLOCKS 1024
 
+/*
+ * Size of the fast commit area carved off the end of the journal when
+ * the superblock does not specify one.
+ */
+#define JBD2_DEFAULT_FAST_COMMIT_BLOCKS 256
+
 #ifdef __KERNEL__
 
 /**
@@ -265,7 +271,9 @@ typedef struct journal_superblock_s
 /* 0x0050 */
 	__u8	s_checksum_type;	/* checksum type */
 	__u8	s_padding2[3];
-	__u32	s_padding[42];
+/* 0x0054 */
+	__be32	s_num_fc_blks;		/* Number of fast commit blocks */
+	__u32	s_padding[41];
 	__be32	s_checksum;		/* crc32c(superblock) */
 
 /* 0x0100 */
@@ -291,6 +299,7 @@ typedef struct journal_superblock_s
 #define JBD2_FEATURE_INCOMPAT_ASYNC_COMMIT	0x00000004
 #define JBD2_FEATURE_INCOMPAT_CSUM_V2		0x00000008
 #define JBD2_FEATURE_INCOMPAT_CSUM_V3		0x00000010
+#define JBD2_FEATURE_INCOMPAT_FAST_COMMIT	0x00000020
 
 /* See "journal feature predicate functions" below */
 
@@ -301,7 +310,8 @@ typedef struct journal_superblock_s
 					JBD2_FEATURE_INCOMPAT_64BIT | \
 					JBD2_FEATURE_INCOMPAT_ASYNC_COMMIT | \
 					JBD2_FEATURE_INCOMPAT_CSUM_V2 | \
-					JBD2_FEATURE_INCOMPAT_CSUM_V3)
+					JBD2_FEATURE_INCOMPAT_CSUM_V3 | \
+					JBD2_FEATURE_INCOMPAT_FAST_COMMIT)
 
 #ifdef __KERNEL__
 
@@ -780,6 +790,13 @@ jbd2_time_diff(unsigned long start, unsigned long end)
  * @j_wbuf: array of buffer_heads for jbd2_journal_commit_transaction
  * @j_wbufsize: maximum number of buffer_heads allowed in j_wbuf, the
  *	number that will fit in j_blocksize
+ * @j_fc_first: block number of the first fast commit block in the journal
+ * @j_fc_off: number of fast commit blocks currently in use
+ * @j_fc_last: block number one beyond the last fast commit block
+ * @j_fc_wbuf: array of buffer_heads used by the current fast commit
+ * @j_fc_wbufsize: maximum number of buffer_heads allowed in j_fc_wbuf
+ * @j_fc_wait: wait queue to wait for an ongoing fast or full commit
+ * @j_fc_cleanup_callback: cleanup hook the client runs after each commit
  * @j_last_sync_writer: most recent pid which did a synchronous write
  * @j_history: Buffer storing the transactions statistics history
  * @j_history_max: Maximum number of transactions in the statistics history
@@ -893,6 +910,15 @@ struct journal_s
 	unsigned long		j_first;
 	unsigned long		j_last;
 
+	/*
+	 * Bounds of the fast commit area at the tail of the journal and
+	 * the number of its blocks currently in use.  Only valid when the
+	 * fast commit feature is enabled. [j_state_lock]
+	 */
+	unsigned long		j_fc_first;
+	unsigned long		j_fc_off;
+	unsigned long		j_fc_last;
+
 	/*
 	 * Device, blocksize and starting block offset for the location where we
 	 * store the journal.
@@ -985,6 +1011,22 @@ struct journal_s
 	struct buffer_head	**j_wbuf;
 	int			j_wbufsize;
 
+	/*
+	 * array of bhs for the current fast commit [j_fc_off of them in use]
+	 */
+	struct buffer_head	**j_fc_wbuf;
+	int			j_fc_wbufsize;
+
+	/* Wait queue for an ongoing fast or full commit to finish */
+	wait_queue_head_t	j_fc_wait;
+
+	/*
+	 * Called after every commit so that the client can release state
+	 * it tracked for a possible fast commit; @full is set when the
+	 * commit that finished was a full transaction commit.
+	 */
+	void (*j_fc_cleanup_callback)(struct journal_s *journal, int full);
+
 	/*
 	 * this is the pid of hte last person to run a synchronous operation
 	 * through the journal
@@ -1094,6 +1136,7 @@ JBD2_FEATURE_INCOMPAT_FUNCS(64bit,		64BIT)
 JBD2_FEATURE_INCOMPAT_FUNCS(async_commit,	ASYNC_COMMIT)
 JBD2_FEATURE_INCOMPAT_FUNCS(csum2,		CSUM_V2)
 JBD2_FEATURE_INCOMPAT_FUNCS(csum3,		CSUM_V3)
+JBD2_FEATURE_INCOMPAT_FUNCS(fast_commit,	FAST_COMMIT)
 
 /*
  * Journal flag definitions
@@ -1108,6 +1151,8 @@ JBD2_FEATURE_INCOMPAT_FUNCS(csum3,		CSUM_V3)
 						 * data write error in ordered
 						 * mode */
 #define JBD2_REC_ERR	0x080	/* The errno in the sb has been recorded */
+#define JBD2_FAST_COMMIT_ONGOING	0x100	/* Fast commit is ongoing */
+#define JBD2_FULL_COMMIT_ONGOING	0x200	/* Full commit is ongoing */
 
 /*
  * Function declarations for the journaling transaction and buffer
@@ -1345,6 +1390,21 @@ int __jbd2_log_start_commit(journal_t *journal, tid_t tid);
 int jbd2_journal_start_commit(journal_t *journal, tid_t *tid);
 int jbd2_log_wait_commit(journal_t *journal, tid_t tid);
 int jbd2_complete_transaction(journal_t *journal, tid_t tid);
+
+/* Fast commit related APIs */
+int jbd2_fc_begin_commit(journal_t *journal, tid_t tid);
+int jbd2_fc_end_commit(journal_t *journal);
+int jbd2_fc_end_commit_fallback(journal_t *journal);
+int jbd2_fc_get_buf(journal_t *journal, struct buffer_head **bh_out);
+int jbd2_fc_wait_bufs(journal_t *journal, int num_blks);
+int jbd2_fc_release_bufs(journal_t *journal);
+
+static inline int jbd2_journal_get_num_fc_blks(journal_superblock_t *jsb)
+{
+	int num_fc_blks = be32_to_cpu(jsb->s_num_fc_blks);
+
+	return num_fc_blks ? num_fc_blks : JBD2_DEFAULT_FAST_COMMIT_BLOCKS;
+}
 int jbd2_log_do_checkpoint(journal_t *journal);
 int jbd2_trans_will_send_data_barrier(journal_t *journal, tid_t tid);
 
@@ -84,6 +84,7 @@ struct keyring_list;
 struct keyring_name;
 
 struct keyring_index_key {
+	unsigned long		hash;		/* Hash of type and description */
 	struct key_type		*type;
 	const char		*description;
 	size_t			desc_len;
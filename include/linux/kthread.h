@@ -129,4 +129,35 @@ bool queue_kthread_work(struct kthread_worker *worker,
 void flush_kthread_work(struct kthread_work *work);
 void flush_kthread_worker(struct kthread_worker *worker);
 
+/*
+ * Bounded-concurrency worker pool for blocking I/O offload.
+ *
+ * A kthread_pool maintains a dynamically sized set of kthreads per NUMA
+ * node, capped by the caller, which execute queued kthread_pool_works.
+ * Works queued with a serialization key never run concurrently with
+ * other works sharing the same key (e.g. writes to the same file);
+ * unkeyed works run on the submitter's node with no ordering.  Workers
+ * are spawned on demand and retire after an idle period.
+ */
+struct kthread_pool;
+struct kthread_pool_work;
+typedef void (*kthread_pool_work_func_t)(struct kthread_pool_work *work);
+
+struct kthread_pool_work {
+	struct list_head	node;
+	kthread_pool_work_func_t func;
+	unsigned int		hash;	/* internal, set when queued */
+};
+
+struct kthread_pool *kthread_pool_create(const char *name,
+					 unsigned int max_workers);
+void kthread_pool_destroy(struct kthread_pool *pool);
+void queue_kthread_pool_work(struct kthread_pool *pool,
+			     struct kthread_pool_work *work,
+			     kthread_pool_work_func_t func);
+void queue_kthread_pool_work_hashed(struct kthread_pool *pool,
+				    struct kthread_pool_work *work,
+				    kthread_pool_work_func_t func,
+				    const void *key);
+
 #endif /* _LINUX_KTHREAD_H */
@@ -1854,14 +1854,8 @@ struct security_hook_list {
 
 extern struct security_hook_heads security_hook_heads;
 
-static inline void security_add_hooks(struct security_hook_list *hooks,
-				      int count)
-{
-	int i;
-
-	for (i = 0; i < count; i++)
-		list_add_tail_rcu(&hooks[i].list, hooks[i].head);
-}
+extern void __init security_add_hooks(struct security_hook_list *hooks,
+				      int count);
 
 #ifdef CONFIG_SECURITY_SELINUX_DISABLE
 /*
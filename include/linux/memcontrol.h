@@ -239,6 +239,24 @@ struct mem_cgroup {
 	 */
 	struct mem_cgroup_stat_cpu __percpu *stat;
 
+	/*
+	 * Hierarchically pre-aggregated counters (this group plus all
+	 * descendants), refreshed periodically and on rate-limited
+	 * demand by memcg_stat_flush(). Reads are O(1) but may lag the
+	 * per-cpu counters by up to one flush interval.
+	 */
+	unsigned long snap_stat[MEMCG_NR_STAT];
+	unsigned long snap_events[MEMCG_NR_EVENTS];
+	unsigned long snap_lru[NR_LRU_LISTS];
+
+	/*
+	 * Allocation stalls charged to the task that suffered them:
+	 * number of page allocator slowpath entries that reached direct
+	 * compaction or reclaim, and the time they spent there.
+	 */
+	atomic64_t		alloc_stall;
+	atomic64_t		alloc_stall_ns;
+
 	unsigned long		socket_pressure;
 
 	/* Legacy tcp memory accounting */
@@ -505,6 +523,8 @@ unsigned long mem_cgroup_soft_limit_reclaim(struct zone *zone, int order,
 						gfp_t gfp_mask,
 						unsigned long *total_scanned);
 
+void mem_cgroup_account_alloc_stall(u64 delta_ns);
+
 static inline void mem_cgroup_count_vm_event(struct mm_struct *mm,
 					     enum vm_event_item idx)
 {
@@ -724,6 +744,10 @@ unsigned long mem_cgroup_soft_limit_reclaim(struct zone *zone, int order,
 	return 0;
 }
 
+static inline void mem_cgroup_account_alloc_stall(u64 delta_ns)
+{
+}
+
 static inline void mem_cgroup_split_huge_fixup(struct page *head)
 {
 }
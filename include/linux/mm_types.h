@@ -387,6 +387,7 @@ struct mm_rss_stat {
 };
 
 struct kioctx_table;
+struct futex_private_hash;
 struct mm_struct {
 	struct vm_area_struct *mmap;		/* list of VMAs */
 	struct rb_root mm_rb;
@@ -470,6 +471,10 @@ struct mm_struct {
 
 	/* store ref to file /proc/<pid>/exe symlink points to */
 	struct file __rcu *exe_file;
+#ifdef CONFIG_FUTEX
+	/* opt-in hash table for this mm's private futexes, set once */
+	struct futex_private_hash *futex_phash;
+#endif
 #ifdef CONFIG_MMU_NOTIFIER
 	struct mmu_notifier_mm *mmu_notifier_mm;
 #endif
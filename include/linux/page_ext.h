@@ -46,6 +46,8 @@ struct page_ext {
 	gfp_t gfp_mask;
 	unsigned int nr_entries;
 	int last_migrate_reason;
+	u64 ts_nsec;		/* allocation time */
+	u64 stall_ns;		/* time spent in the allocator slowpath */
 	unsigned long trace_entries[8];
 #endif
 };
@@ -11,6 +11,8 @@ extern void __reset_page_owner(struct page *page, unsigned int order);
 extern void __set_page_owner(struct page *page,
 			unsigned int order, gfp_t gfp_mask);
 extern gfp_t __get_page_owner_gfp(struct page *page);
+extern u64 __page_owner_stall_start(void);
+extern void __set_page_owner_stall(struct page *page, u64 stall_start);
 extern void __copy_page_owner(struct page *oldpage, struct page *newpage);
 extern void __set_page_owner_migrate_reason(struct page *page, int reason);
 extern void __dump_page_owner(struct page *page);
@@ -35,6 +37,22 @@ static inline gfp_t get_page_owner_gfp(struct page *page)
 	else
 		return 0;
 }
+/*
+ * Returns a timestamp to pass to set_page_owner_stall() when the
+ * allocation completes, or 0 if page_owner is not in use.
+ */
+static inline u64 page_owner_stall_start(void)
+{
+	if (static_branch_unlikely(&page_owner_inited))
+		return __page_owner_stall_start();
+	return 0;
+}
+static inline void set_page_owner_stall(struct page *page, u64 stall_start)
+{
+	if (static_branch_unlikely(&page_owner_inited))
+		if (page && stall_start)
+			__set_page_owner_stall(page, stall_start);
+}
 static inline void copy_page_owner(struct page *oldpage, struct page *newpage)
 {
 	if (static_branch_unlikely(&page_owner_inited))
@@ -62,6 +80,13 @@ static inline gfp_t get_page_owner_gfp(struct page *page)
 {
 	return 0;
 }
+static inline u64 page_owner_stall_start(void)
+{
+	return 0;
+}
+static inline void set_page_owner_stall(struct page *page, u64 stall_start)
+{
+}
 static inline void copy_page_owner(struct page *oldpage, struct page *newpage)
 {
 }
@@ -0,0 +1,44 @@
+/*
+ * Lock-free bounded object pool with per-CPU freelists.
+ *
+ * Free objects are strung on llists through their own (free) memory, so
+ * the backing kmem_cache's objects must be at least pointer sized.  The
+ * fast paths never take a lock: allocation pops the local CPU's list,
+ * freeing pushes it back, and overflow/refill move objects in bulk via
+ * a shared spill list using llist's cmpxchg protocol.
+ *
+ * Unlike a mempool there is no forward-progress reserve; when the pool
+ * runs dry, allocation falls back to the slab on the local node.  Use
+ * this to cut allocator traffic for high-churn objects, not to
+ * guarantee allocations under memory pressure.
+ */
+#ifndef __PERCPU_POOL_H__
+#define __PERCPU_POOL_H__
+
+#include <linux/llist.h>
+#include <linux/types.h>
+
+struct kmem_cache;
+
+struct percpu_pool_cpu {
+	struct llist_head	list;
+	unsigned int		nr;
+};
+
+struct percpu_pool {
+	struct kmem_cache		*cache;
+	unsigned int			cpu_max;   /* per-CPU freelist bound */
+	unsigned int			spill_max; /* shared overflow bound */
+	struct percpu_pool_cpu __percpu	*cpu;
+	struct llist_head		spill;
+	atomic_t			spill_nr;
+};
+
+int percpu_pool_init(struct percpu_pool *pool, struct kmem_cache *cache,
+		     unsigned int cpu_max, unsigned int spill_max);
+void percpu_pool_destroy(struct percpu_pool *pool);
+
+void *percpu_pool_alloc(struct percpu_pool *pool, gfp_t gfp);
+void percpu_pool_free(struct percpu_pool *pool, void *obj);
+
+#endif /* __PERCPU_POOL_H__ */
@@ -412,6 +412,20 @@ typedef void (*perf_overflow_handler_t)(struct perf_event *,
 					struct perf_sample_data *,
 					struct pt_regs *regs);
 
+/*
+ * Kernel side context handed to BPF_PROG_TYPE_PERF_EVENT programs; the
+ * verifier rewrites accesses to the user visible struct
+ * bpf_perf_event_data layout into loads through these pointers.  @regs
+ * must stay first, so that helpers shared with tracepoint programs can
+ * fetch the pt_regs pointer from the start of either context.
+ */
+struct bpf_prog;
+
+struct bpf_perf_event_data_kern {
+	struct pt_regs *regs;
+	struct perf_sample_data *data;
+};
+
 enum perf_group_flag {
 	PERF_GROUP_SOFTWARE		= 0x1,
 };
@@ -570,6 +584,10 @@ struct perf_event {
 	u64				(*clock)(void);
 	perf_overflow_handler_t		overflow_handler;
 	void				*overflow_handler_context;
+#ifdef CONFIG_BPF_SYSCALL
+	perf_overflow_handler_t		orig_overflow_handler;
+	struct bpf_prog			*prog;
+#endif
 
 #ifdef CONFIG_EVENT_TRACING
 	struct trace_event_call		*tp_event;
@@ -0,0 +1,59 @@
+/*
+ * Range locking
+ *
+ * A range lock serializes access to [start, last] spans of a shared
+ * resource.  Lockers of non-overlapping ranges proceed in parallel,
+ * lockers of overlapping ranges serialize in FIFO order.  The intended
+ * use is byte or block ranges of a file, so that disjoint direct I/O
+ * writers need not serialize on an inode-wide lock.
+ *
+ * The lock word itself (struct range_lock) lives on the locker's stack
+ * and must stay alive until the matching range_unlock().
+ */
+#ifndef _LINUX_RANGE_LOCK_H
+#define _LINUX_RANGE_LOCK_H
+
+#include <linux/rbtree.h>
+#include <linux/spinlock.h>
+
+struct task_struct;
+
+struct range_lock_tree {
+	struct rb_root root;
+	spinlock_t lock;
+};
+
+struct range_lock {
+	struct rb_node node;
+	unsigned long start;
+	unsigned long last;
+	unsigned long __subtree_last;
+	struct task_struct *task;
+	/* Number of earlier overlapping ranges we must wait for */
+	unsigned int blocking_ranges;
+};
+
+#define __RANGE_LOCK_TREE_INITIALIZER(name)			\
+	{ .root = RB_ROOT,					\
+	  .lock = __SPIN_LOCK_UNLOCKED(name.lock) }
+
+#define DEFINE_RANGE_LOCK_TREE(name)				\
+	struct range_lock_tree name = __RANGE_LOCK_TREE_INITIALIZER(name)
+
+static inline void range_lock_tree_init(struct range_lock_tree *tree)
+{
+	tree->root = RB_ROOT;
+	spin_lock_init(&tree->lock);
+}
+
+static inline void range_lock_init(struct range_lock *lock,
+				   unsigned long start, unsigned long last)
+{
+	lock->start = start;
+	lock->last = last;
+}
+
+extern void range_lock(struct range_lock_tree *tree, struct range_lock *lock);
+extern void range_unlock(struct range_lock_tree *tree, struct range_lock *lock);
+
+#endif /* _LINUX_RANGE_LOCK_H */
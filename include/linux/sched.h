@@ -64,6 +64,7 @@ struct sched_param {
 #include <asm/processor.h>
 
 #define SCHED_ATTR_SIZE_VER0	48	/* sizeof first published struct */
+#define SCHED_ATTR_SIZE_VER1	56	/* add: sched_latency_nice */
 
 /*
  * Extended scheduling parameters data structure.
@@ -125,6 +126,14 @@ struct sched_attr {
 	u64 sched_runtime;
 	u64 sched_deadline;
 	u64 sched_period;
+
+	/*
+	 * SCHED_NORMAL relative latency sensitivity, same range as the
+	 * nice value.  Negative values make wakeup preemption more
+	 * aggressive for this task, positive values less so.  Only
+	 * honoured when SCHED_FLAG_LATENCY_NICE is set.
+	 */
+	s32 sched_latency_nice;
 };
 
 struct futex_pi_state;
@@ -177,6 +186,9 @@ extern void get_iowait_load(unsigned long *nr_waiters, unsigned long *load);
 
 extern void calc_global_load(unsigned long ticks);
 
+extern void pressure_memstall_enter(void);
+extern void pressure_memstall_leave(void);
+
 #if defined(CONFIG_SMP) && defined(CONFIG_NO_HZ_COMMON)
 extern void update_cpu_load_nohz(int active);
 #else
@@ -1214,10 +1226,25 @@ struct load_weight {
  * the highest weight (=88761) always runnable, we should not overflow
  * 2) for entity, support any load.weight always runnable
  */
+/*
+ * Estimation of a (task or cpu) utilization which, unlike util_avg, does
+ * not decay while the task sleeps.  'enqueued' is the (estimated)
+ * utilization of a task when it is enqueued (snapshot of util_avg at the
+ * end of the previous activation for the per-task copy, sum of the
+ * enqueued tasks' estimates for the cfs_rq copy); 'ewma' is a moving
+ * average of those snapshots across activations.
+ */
+struct util_est {
+	unsigned int		enqueued;
+	unsigned int		ewma;
+#define UTIL_EST_WEIGHT_SHIFT	2
+};
+
 struct sched_avg {
 	u64 last_update_time, load_sum;
 	u32 util_sum, period_contrib;
 	unsigned long load_avg, util_avg;
+	struct util_est util_est;
 };
 
 #ifdef CONFIG_SCHEDSTATS
@@ -1412,6 +1439,7 @@ struct task_struct {
 	int on_rq;
 
 	int prio, static_prio, normal_prio;
+	int latency_nice;
 	unsigned int rt_priority;
 	const struct sched_class *sched_class;
 	struct sched_entity se;
@@ -1482,6 +1510,7 @@ struct task_struct {
 	/* unserialized, strictly 'current' */
 	unsigned in_execve:1; /* bit to tell LSMs we're in execve */
 	unsigned in_iowait:1;
+	unsigned in_memstall:1; /* stalled in direct reclaim */
 #ifdef CONFIG_MEMCG
 	unsigned memcg_may_oom:1;
 #ifndef CONFIG_SLOB
@@ -1552,6 +1581,9 @@ struct task_struct {
 
 #ifdef CONFIG_NO_HZ_FULL
 	unsigned long tick_dep_mask;
+#endif
+#ifdef CONFIG_TASK_ISOLATION
+	unsigned int task_isolation_flags; /* prctl(PR_SET_TASK_ISOLATION) */
 #endif
 	unsigned long nvcsw, nivcsw; /* context switch counts */
 	u64 start_time;		/* monotonic time in nsec */
@@ -1727,6 +1759,7 @@ struct task_struct {
 	int numa_scan_seq;
 	unsigned int numa_scan_period;
 	unsigned int numa_scan_period_max;
+	unsigned int numa_scan_settled;
 	int numa_preferred_nid;
 	unsigned long numa_migrate_retry;
 	u64 node_stamp;			/* migration stamp  */
@@ -98,6 +98,12 @@
 #define SLAB_KASAN		0x00000000UL
 #endif
 
+#ifdef CONFIG_SLUB
+# define SLAB_MAGAZINE		0x10000000UL	/* Per-cpu array front end (SLUB only) */
+#else
+# define SLAB_MAGAZINE		0x00000000UL
+#endif
+
 /* The following flags affect the page allocator grouping pages by mobility */
 #define SLAB_RECLAIM_ACCOUNT	0x00020000UL		/* Objects are reclaimable */
 #define SLAB_TEMPORARY		SLAB_RECLAIM_ACCOUNT	/* Objects are short-lived */
@@ -47,6 +47,19 @@ struct kmem_cache_cpu {
 #endif
 };
 
+/*
+ * Per-cpu array front end for caches created with SLAB_MAGAZINE.
+ * Objects are pushed on free and popped on alloc with irqs disabled,
+ * so a burst of churn costs one cpu_slab transaction per batch rather
+ * than one per object.
+ */
+#define SLUB_MAGAZINE_SIZE	32
+
+struct kmem_cache_magazine {
+	unsigned int count;
+	void *objs[SLUB_MAGAZINE_SIZE];
+};
+
 /*
  * Word size structure that can be atomically updated or read and that
  * contains both the order and the number of objects that a slab of the
@@ -61,6 +74,8 @@ struct kmem_cache_order_objects {
  */
 struct kmem_cache {
 	struct kmem_cache_cpu __percpu *cpu_slab;
+	/* Per-cpu array cache, only for SLAB_MAGAZINE caches */
+	struct kmem_cache_magazine __percpu *magazine;
 	/* Used for retriving partial slabs etc */
 	unsigned long flags;
 	unsigned long min_partial;
@@ -7,4 +7,7 @@ void sort(void *base, size_t num, size_t size,
 	  int (*cmp)(const void *, const void *),
 	  void (*swap)(void *, void *, int));
 
+void sort_u32s(u32 *base, size_t num);
+void sort_u64s(u64 *base, size_t num);
+
 #endif
@@ -19,6 +19,9 @@
 #include <linux/uidgid.h>
 
 struct kstat {
+	u32		result_mask;	/* What fields the user got (STATX_*) */
+	u32		request_mask;	/* What fields the user asked for */
+	unsigned int	query_flags;	/* AT_STATX_SYNC_TYPE requested */
 	u64		ino;
 	dev_t		dev;
 	umode_t		mode;
@@ -30,8 +33,11 @@ struct kstat {
 	struct timespec  atime;
 	struct timespec	mtime;
 	struct timespec	ctime;
+	struct timespec	btime;		/* File creation time */
 	unsigned long	blksize;
 	unsigned long long	blocks;
+	u64		attributes;
+	u64		attributes_mask;
 };
 
 #endif
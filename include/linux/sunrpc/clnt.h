@@ -112,6 +112,7 @@ struct rpc_create_args {
 	int			protocol;
 	struct sockaddr		*address;
 	size_t			addrsize;
+	unsigned int		nconnect;	/* number of transports */
 	struct sockaddr		*saddress;
 	const struct rpc_timeout *timeout;
 	const char		*servername;
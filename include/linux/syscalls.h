@@ -46,6 +46,7 @@ struct shmid_ds;
 struct sockaddr;
 struct stat;
 struct stat64;
+struct statx;
 struct statfs;
 struct statfs64;
 struct __sysctl_args;
@@ -898,4 +899,7 @@ asmlinkage long sys_copy_file_range(int fd_in, loff_t __user *off_in,
 
 asmlinkage long sys_mlock2(unsigned long start, size_t len, int flags);
 
+asmlinkage long sys_statx(int dfd, const char __user *path, unsigned flags,
+			  unsigned mask, struct statx __user *buffer);
+
 #endif
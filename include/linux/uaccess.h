@@ -73,6 +73,12 @@ static inline unsigned long __copy_from_user_nocache(void *to,
 	return __copy_from_user(to, from, n);
 }
 
+static inline unsigned long __copy_to_user_nocache(void __user *to,
+				const void *from, unsigned long n)
+{
+	return __copy_to_user(to, from, n);
+}
+
 #endif		/* ARCH_HAS_NOCACHE_UACCESS */
 
 /*
@@ -101,6 +101,9 @@ struct work_struct {
 	atomic_long_t data;
 	struct list_head entry;
 	work_func_t func;
+#ifdef CONFIG_WQ_STATS
+	u64 queue_stamp;	/* time of last enqueue, for queueing latency */
+#endif
 #ifdef CONFIG_LOCKDEP
 	struct lockdep_map lockdep_map;
 #endif
@@ -455,6 +458,7 @@ extern bool workqueue_congested(int cpu, struct workqueue_struct *wq);
 extern unsigned int work_busy(struct work_struct *work);
 extern __printf(1, 2) void set_worker_desc(const char *fmt, ...);
 extern void print_worker_info(const char *log_lvl, struct task_struct *task);
+extern void wq_worker_comm(char *buf, size_t size, struct task_struct *task);
 extern void show_workqueue_state(void);
 
 /**
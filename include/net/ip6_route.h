@@ -98,6 +98,10 @@ int icmp6_dst_gc(void);
 
 void fib6_force_start_gc(struct net *net);
 
+void rt6_flush_exceptions(struct rt6_info *rt);
+void rt6_age_exceptions(struct rt6_info *rt, struct fib6_gc_args *gc_args,
+			unsigned long now);
+
 struct rt6_info *addrconf_dst_alloc(struct inet6_dev *idev,
 				    const struct in6_addr *addr, bool anycast);
 
@@ -7,6 +7,7 @@
 #include <linux/atomic.h>
 #include <linux/workqueue.h>
 #include <linux/list.h>
+#include <linux/llist.h>
 #include <linux/sysctl.h>
 
 #include <net/flow.h>
@@ -56,7 +57,7 @@ struct net {
 	atomic64_t		cookie_gen;
 
 	struct list_head	list;		/* list of network namespaces */
-	struct list_head	cleanup_list;	/* namespaces on death row */
+	struct llist_node	cleanup_list;	/* namespaces on death row */
 	struct list_head	exit_list;	/* Use only net_mutex */
 
 	struct user_namespace   *user_ns;	/* Owning user namespace */
@@ -235,6 +235,11 @@ extern s32 (*nf_ct_nat_offset)(const struct nf_conn *ct,
 			       enum ip_conntrack_dir dir,
 			       u32 seq);
 
+/* Set by the flow offload table so nf_ct_delete() can invalidate the
+ * entries of an offloaded conntrack, see net/netfilter/nf_flow_table.c.
+ */
+extern void (*nf_flow_table_ct_teardown)(struct nf_conn *ct) __rcu;
+
 /* Fake conntrack entry for untracked connections */
 DECLARE_PER_CPU(struct nf_conn, nf_conntrack_untracked);
 static inline struct nf_conn *nf_ct_untracked_get(void)
@@ -0,0 +1,90 @@
+#ifndef _NF_FLOW_TABLE_H
+#define _NF_FLOW_TABLE_H
+
+#include <linux/in.h>
+#include <linux/rhashtable.h>
+#include <linux/rcupdate.h>
+#include <net/dst.h>
+
+struct nf_conn;
+
+/* Software flow offload: once conntrack has seen a connection through to
+ * the established state and every hook has rendered its verdict, the
+ * datapath installs a pair of 5-tuple entries (one per direction) here.
+ * Subsequent packets matching an entry are forwarded straight from
+ * ingress via the cached route, with any NAT recorded at offload time
+ * applied in place, bypassing the hook chains entirely.
+ */
+struct nf_flowtable {
+	struct rhashtable		rhashtable;
+	struct net			*net;
+	struct list_head		list;
+	struct delayed_work		gc_work;
+};
+
+enum flow_offload_tuple_dir {
+	FLOW_OFFLOAD_DIR_ORIGINAL,
+	FLOW_OFFLOAD_DIR_REPLY,
+	FLOW_OFFLOAD_DIR_MAX,
+};
+
+struct flow_offload_tuple {
+	/* Everything up to @dir is the lookup key, hashed and compared as
+	 * one flat region; keep it free of padding.
+	 */
+	__be32				src_addr;
+	__be32				dst_addr;
+	__be16				src_port;
+	__be16				dst_port;
+	u8				l4proto;
+
+	u8				dir;
+	u16				mtu;
+	struct dst_entry		*dst_cache;
+};
+
+struct flow_offload_tuple_rhash {
+	struct rhash_head		node;
+	struct flow_offload_tuple	tuple;
+};
+
+#define FLOW_OFFLOAD_SNAT	0x1
+#define FLOW_OFFLOAD_DNAT	0x2
+#define FLOW_OFFLOAD_TEARDOWN	0x4
+
+struct flow_offload {
+	struct flow_offload_tuple_rhash	tuplehash[FLOW_OFFLOAD_DIR_MAX];
+	struct nf_conn			*ct;
+	u32				flags;
+	unsigned long			timeout;
+	struct rcu_head			rcu_head;
+};
+
+#define NF_FLOW_TIMEOUT		(30 * HZ)
+
+struct nf_flow_route {
+	struct {
+		struct dst_entry	*dst;
+	} tuple[FLOW_OFFLOAD_DIR_MAX];
+};
+
+struct flow_offload *flow_offload_alloc(struct nf_conn *ct,
+					struct nf_flow_route *route);
+void flow_offload_free(struct flow_offload *flow);
+
+int flow_offload_add(struct nf_flowtable *flow_table,
+		     struct flow_offload *flow);
+struct flow_offload_tuple_rhash *
+flow_offload_lookup(struct nf_flowtable *flow_table,
+		    const struct flow_offload_tuple *tuple);
+
+/* Stop using the entry on the packet path; the next gc run frees it. */
+static inline void flow_offload_teardown(struct flow_offload *flow)
+{
+	flow->flags |= FLOW_OFFLOAD_TEARDOWN;
+}
+
+int nf_flow_table_init(struct net *net, struct nf_flowtable *flow_table);
+void nf_flow_table_free(struct nf_flowtable *flow_table);
+
+#endif /* _NF_FLOW_TABLE_H */
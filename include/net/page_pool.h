@@ -0,0 +1,113 @@
+/*
+ * page_pool.h
+ *	Recycling page allocator for driver RX rings.
+ *
+ * The page_pool keeps a per-queue cache of pages so that drivers do
+ * not go back to the page allocator (and, with PP_FLAG_DMA_MAP, to
+ * dma_map_page()) for every received packet.  The fast-path cache is
+ * lock free and may only be used from the queue's NAPI context; pages
+ * returned from other contexts (typically skb free) land in a locked
+ * ring that the fast path refills from.
+ *
+ * Pages handed out by a pool carry the owning pool in the (otherwise
+ * unused) page->lru words, which lets the skb free path return them
+ * without any driver involvement: a driver marks its RX skbs with
+ * skb_mark_for_recycle() and the pages flow back on kfree_skb().
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version
+ * 2 of the License, or (at your option) any later version.
+ */
+#ifndef _NET_PAGE_POOL_H
+#define _NET_PAGE_POOL_H
+
+#include <linux/mm.h>
+#include <linux/spinlock.h>
+#include <linux/dma-mapping.h>
+
+#define PP_FLAG_DMA_MAP	BIT(0)	/* pool DMA-maps pages for the driver and
+				 * keeps the mapping across recycles
+				 */
+#define PP_FLAG_ALL	PP_FLAG_DMA_MAP
+
+/* Stamped into page->lru.next while a page is outside the pool, so that
+ * the skb free path can recognise pool pages.  Pages are never on an LRU
+ * list while owned by a driver or an skb, and the low bits make the
+ * value an invalid list pointer.
+ */
+#define PP_SIGNATURE	(0x40 + POISON_POINTER_DELTA)
+
+struct page_pool_params {
+	unsigned int	flags;		/* PP_FLAG_* */
+	unsigned int	order;		/* page allocation order */
+	unsigned int	pool_size;	/* capacity of the recycle ring */
+	int		nid;		/* preferred NUMA node, or NUMA_NO_NODE */
+	struct device	*dev;		/* device, for PP_FLAG_DMA_MAP */
+	enum dma_data_direction dma_dir; /* mapping direction */
+};
+
+/* Fast-path cache; only touched from the RX/NAPI context of the queue
+ * that owns the pool.
+ */
+#define PP_ALLOC_CACHE_SIZE	128
+#define PP_ALLOC_CACHE_REFILL	64
+
+struct page_pool {
+	struct page_pool_params p;
+
+	u32 alloc_count;
+	struct page *alloc_cache[PP_ALLOC_CACHE_SIZE];
+
+	/* Slow path: pages coming back from foreign contexts.  Cached
+	 * pages are chained through page->lru.
+	 */
+	spinlock_t ring_lock;
+	struct list_head ring;
+	unsigned int ring_count;
+	bool destroyed;
+
+	/* One reference for the creator plus one per page currently
+	 * outside the pool; the struct is freed when it drops to zero.
+	 */
+	atomic_t ref;
+};
+
+struct page_pool *page_pool_create(const struct page_pool_params *params);
+void page_pool_destroy(struct page_pool *pool);
+
+struct page *page_pool_alloc_pages(struct page_pool *pool, gfp_t gfp);
+
+static inline struct page *page_pool_dev_alloc_pages(struct page_pool *pool)
+{
+	return page_pool_alloc_pages(pool, GFP_ATOMIC | __GFP_NOWARN);
+}
+
+/* @allow_direct must only be true when called from the pool's own NAPI
+ * context.
+ */
+void page_pool_put_page(struct page_pool *pool, struct page *page,
+			bool allow_direct);
+
+static inline void page_pool_recycle_direct(struct page_pool *pool,
+					    struct page *page)
+{
+	page_pool_put_page(pool, page, true);
+}
+
+/* Valid while the page is outside the pool, if PP_FLAG_DMA_MAP is set. */
+static inline dma_addr_t page_pool_get_dma_addr(struct page *page)
+{
+	return (dma_addr_t)page_private(page);
+}
+
+#ifdef CONFIG_PAGE_POOL
+bool page_pool_return_skb_page(struct page *page);
+#else
+static inline bool page_pool_return_skb_page(struct page *page)
+{
+	return false;
+}
+#endif
+
+#endif /* _NET_PAGE_POOL_H */
@@ -87,6 +87,7 @@ struct Qdisc {
 
 	struct Qdisc		*next_sched;
 	struct sk_buff		*gso_skb;
+	struct sk_buff		*skb_bad_txq;
 	/*
 	 * For performance sake on SMP, we put highly modified fields at the end
 	 */
@@ -159,6 +159,36 @@ DEFINE_EVENT(softirq, softirq_raise,
 	TP_ARGS(vec_nr)
 );
 
+/**
+ * softirq_long_exec - called when a softirq handler exceeded its budget
+ * @vec_nr:  softirq vector number
+ * @nsecs:   handler runtime in nanoseconds
+ *
+ * Fires only when CONFIG_SOFTIRQ_STATS is enabled and the handler ran
+ * longer than the budget configured in debugfs softirq_lat/budget_ns.
+ * Attach a stacktrace trigger to capture the offending callchain.
+ */
+TRACE_EVENT(softirq_long_exec,
+
+	TP_PROTO(unsigned int vec_nr, u64 nsecs),
+
+	TP_ARGS(vec_nr, nsecs),
+
+	TP_STRUCT__entry(
+		__field(	unsigned int,	vec	)
+		__field(	u64,		nsecs	)
+	),
+
+	TP_fast_assign(
+		__entry->vec = vec_nr;
+		__entry->nsecs = nsecs;
+	),
+
+	TP_printk("vec=%u [action=%s] nsecs=%llu", __entry->vec,
+		  show_softirq_name(__entry->vec),
+		  (unsigned long long)__entry->nsecs)
+);
+
 #endif /*  _TRACE_IRQ_H */
 
 /* This part must be outside protection */
@@ -220,6 +220,77 @@ TRACE_EVENT(mm_page_alloc,
 		show_gfp_flags(__entry->gfp_flags))
 );
 
+/*
+ * Allocation stall events carry the elapsed time as a payload so that
+ * latency distributions can be built from the events alone, without
+ * pairing begin/end records in userspace.
+ */
+DECLARE_EVENT_CLASS(mm_page_alloc_stall_template,
+
+	TP_PROTO(unsigned int order, gfp_t gfp_flags, u64 latency_ns),
+
+	TP_ARGS(order, gfp_flags, latency_ns),
+
+	TP_STRUCT__entry(
+		__field(	unsigned int,	order		)
+		__field(	gfp_t,		gfp_flags	)
+		__field(	u64,		latency_ns	)
+	),
+
+	TP_fast_assign(
+		__entry->order		= order;
+		__entry->gfp_flags	= gfp_flags;
+		__entry->latency_ns	= latency_ns;
+	),
+
+	TP_printk("order=%u gfp_flags=%s latency_ns=%llu",
+		__entry->order,
+		show_gfp_flags(__entry->gfp_flags),
+		(unsigned long long)__entry->latency_ns)
+);
+
+DEFINE_EVENT(mm_page_alloc_stall_template, mm_page_alloc_stall_compact,
+
+	TP_PROTO(unsigned int order, gfp_t gfp_flags, u64 latency_ns),
+
+	TP_ARGS(order, gfp_flags, latency_ns)
+);
+
+DEFINE_EVENT(mm_page_alloc_stall_template, mm_page_alloc_stall_reclaim,
+
+	TP_PROTO(unsigned int order, gfp_t gfp_flags, u64 latency_ns),
+
+	TP_ARGS(order, gfp_flags, latency_ns)
+);
+
+TRACE_EVENT(mm_page_alloc_stall,
+
+	TP_PROTO(unsigned int order, gfp_t gfp_flags, u64 latency_ns,
+			int retries),
+
+	TP_ARGS(order, gfp_flags, latency_ns, retries),
+
+	TP_STRUCT__entry(
+		__field(	unsigned int,	order		)
+		__field(	gfp_t,		gfp_flags	)
+		__field(	u64,		latency_ns	)
+		__field(	int,		retries		)
+	),
+
+	TP_fast_assign(
+		__entry->order		= order;
+		__entry->gfp_flags	= gfp_flags;
+		__entry->latency_ns	= latency_ns;
+		__entry->retries	= retries;
+	),
+
+	TP_printk("order=%u gfp_flags=%s latency_ns=%llu retries=%d",
+		__entry->order,
+		show_gfp_flags(__entry->gfp_flags),
+		(unsigned long long)__entry->latency_ns,
+		__entry->retries)
+);
+
 DECLARE_EVENT_CLASS(mm_page,
 
 	TP_PROTO(struct page *page, unsigned int order, int migratetype),
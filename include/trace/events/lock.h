@@ -7,6 +7,50 @@
 #include <linux/lockdep.h>
 #include <linux/tracepoint.h>
 
+/* flags for lock:lock_contention */
+#define LCB_F_SPIN	(1U << 0)
+#define LCB_F_READ	(1U << 1)
+#define LCB_F_WRITE	(1U << 2)
+#define LCB_F_MUTEX	(1U << 3)
+
+/*
+ * Emitted once per contended acquisition, from the lock slowpaths
+ * only, so it costs nothing on uncontended locks and a single
+ * patched-out branch on contended ones while the event is disabled.
+ * Unlike the lockdep-based events above this does not depend on
+ * CONFIG_LOCKDEP and is usable on production kernels.
+ */
+TRACE_EVENT(lock_contention,
+
+	TP_PROTO(void *lock, unsigned long ip, u64 wait_ns,
+		 unsigned int flags),
+
+	TP_ARGS(lock, ip, wait_ns, flags),
+
+	TP_STRUCT__entry(
+		__field(	void *,		lock	)
+		__field(	unsigned long,	ip	)
+		__field(	u64,		wait_ns	)
+		__field(	unsigned int,	flags	)
+	),
+
+	TP_fast_assign(
+		__entry->lock		= lock;
+		__entry->ip		= ip;
+		__entry->wait_ns	= wait_ns;
+		__entry->flags		= flags;
+	),
+
+	TP_printk("%p %pS (%s) wait_ns=%llu",
+		  __entry->lock, (void *)__entry->ip,
+		  __print_flags(__entry->flags, "|",
+				{ LCB_F_SPIN,	"SPIN"	},
+				{ LCB_F_READ,	"READ"	},
+				{ LCB_F_WRITE,	"WRITE"	},
+				{ LCB_F_MUTEX,	"MUTEX"	}),
+		  __entry->wait_ns)
+);
+
 #ifdef CONFIG_LOCKDEP
 
 TRACE_EVENT(lock_acquire,
@@ -92,4 +92,8 @@
 
 #define SO_CNX_ADVICE		53
 
+#define SO_ZEROCOPY		54
+
+#define SO_SPLICE		55
+
 #endif /* __ASM_GENERIC_SOCKET_H */
@@ -49,6 +49,7 @@ enum {
 	IOCB_CMD_UNLINKAT = 10,
 	IOCB_CMD_READAHEAD = 12,
 	IOCB_CMD_RENAMEAT = 13,
+	IOCB_CMD_SQ_RING = 14,
 };
 
 /*
@@ -109,6 +110,25 @@ struct iocb {
 	__u32	aio_resfd;
 }; /* 64 bytes */
 
+/*
+ * Submission ring for IOCB_CMD_SQ_RING.  The iocb's aio_buf points at
+ * this structure and aio_nbytes must be its size.  Userspace fills
+ * slots in the array at "iocbs" and advances "tail"; the kernel
+ * consumes entries and advances "head".  Both indices increment freely
+ * and are reduced modulo "nr" to find a slot.  Setting AIO_SQ_RING_STOP
+ * in "flags" retires the ring; it also completes when the context is
+ * destroyed or the submitting task exits.
+ */
+struct aio_sq_ring {
+	__u32	head;		/* written by the kernel */
+	__u32	tail;		/* written by userspace */
+	__u32	nr;		/* number of iocb slots */
+	__u32	flags;
+	__u64	iocbs;		/* pointer to array of struct iocb */
+};
+
+#define AIO_SQ_RING_STOP	(1 << 0)
+
 struct renameat_info {
 	__s64	olddirfd;
 	__u64	oldpath;
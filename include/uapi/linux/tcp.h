@@ -115,6 +115,8 @@ enum {
 #define TCP_CC_INFO		26	/* Get Congestion Control (optional) info */
 #define TCP_SAVE_SYN		27	/* Record SYN headers for new connections */
 #define TCP_SAVED_SYN		28	/* Get SYN headers recorded for connection */
+#define TCP_ULP			29	/* Attach a ULP to a TCP connection */
+#define TCP_ZEROCOPY_RECEIVE	30	/* Map in-order payload into a vma */
 
 struct tcp_repair_opt {
 	__u32	opt_code;
@@ -157,6 +159,7 @@ struct tcp_info {
 	__u8	tcpi_backoff;
 	__u8	tcpi_options;
 	__u8	tcpi_snd_wscale : 4, tcpi_rcv_wscale : 4;
+	__u8	tcpi_delivery_rate_app_limited:1;
 
 	__u32	tcpi_rto;
 	__u32	tcpi_ato;
@@ -201,6 +204,13 @@ struct tcp_info {
 	__u32	tcpi_min_rtt;
 	__u32	tcpi_data_segs_in;	/* RFC4898 tcpEStatsDataSegsIn */
 	__u32	tcpi_data_segs_out;	/* RFC4898 tcpEStatsDataSegsOut */
+
+	__u64   tcpi_delivery_rate;	/* Last good goodput sample, B/s */
+
+	__u64	tcpi_busy_time;		/* Time (usec) busy sending data */
+	__u64	tcpi_rwnd_limited;	/* Time (usec) limited by receive window */
+	__u64	tcpi_sndbuf_limited;	/* Time (usec) limited by send buffer */
+	__u64	tcpi_cwnd_limited;	/* Time (usec) limited by cwnd */
 };
 
 /* for TCP_MD5SIG socket option */
@@ -214,4 +224,13 @@ struct tcp_md5sig {
 	__u8	tcpm_key[TCP_MD5SIG_MAXKEYLEN];		/* key (binary) */
 };
 
+/* for TCP_ZEROCOPY_RECEIVE; the vma at "address" must come from an
+ * mmap() of the socket
+ */
+struct tcp_zerocopy_receive {
+	__u64	address;	/* in: page aligned address to map at */
+	__u32	length;		/* in/out: bytes to map / bytes mapped */
+	__u32	recv_skip_hint;	/* out: unmappable bytes, recvmsg() them */
+};
+
 #endif /* _UAPI_LINUX_TCP_H */
@@ -0,0 +1,37 @@
+#ifndef _UAPI_TRACE_MMAP_H_
+#define _UAPI_TRACE_MMAP_H_
+
+#include <linux/types.h>
+#include <linux/ioctl.h>
+
+/*
+ * Layout of the first page of a memory mapped trace_pipe_raw file.
+ * The data pages of the per-CPU ring buffer follow it in the mapping,
+ * one page per slot; the slot holding the current reader page is
+ * published in @reader_id.
+ *
+ * The consumer loop is:
+ *
+ *	ioctl(fd, TRACE_MMAP_IOCTL_GET_READER);
+ *	process bytes [reader_read, reader_commit) of the data area of
+ *	    the page in slot reader_id;
+ *	repeat - the next ioctl consumes the published window and moves
+ *	    the reader on.
+ *
+ * @reader_read and @reader_commit are offsets into the data area of the
+ * page, i.e. they do not include the buffer page header.
+ */
+struct trace_buffer_meta {
+	__u32	meta_page_size;	/* size of this meta page */
+	__u32	nr_data_pages;	/* data page slots in the mapping */
+	__u32	reader_id;	/* slot of the current reader page */
+	__u32	reader_read;	/* start of the published window */
+	__u32	reader_commit;	/* end of the published window */
+	__u32	__reserved;
+	__u64	entries;	/* entries written to this CPU buffer */
+	__u64	overrun;	/* entries lost to overwrite */
+};
+
+#define TRACE_MMAP_IOCTL_GET_READER	_IO('T', 0x1)
+
+#endif /* _UAPI_TRACE_MMAP_H_ */
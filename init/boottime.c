@@ -0,0 +1,193 @@
+/*
+ * Always-on boot phase timing.
+ *
+ * initcall_debug answers "where did boot time go?" but costs enough
+ * console traffic to distort the answer, so it cannot stay enabled on
+ * production machines.  This keeps a silent fixed-size table instead:
+ * every initcall, every driver probe (including the asynchronous ones)
+ * and the initramfs unpack get one record, and the whole table is read
+ * back post-boot in a single pass over /proc/boottime.
+ *
+ * Recording stops when init is about to be executed, so the table only
+ * ever describes boot and later hotplug probes cannot overwrite it.
+ */
+
+#include <linux/boottime.h>
+#include <linux/atomic.h>
+#include <linux/device.h>
+#include <linux/kernel.h>
+#include <linux/proc_fs.h>
+#include <linux/sched.h>
+#include <linux/seq_file.h>
+
+#define BOOTTIME_MAX_RECORDS	2048
+#define BOOTTIME_NAME_LEN	40
+
+enum boottime_type {
+	BOOTTIME_INITCALL,
+	BOOTTIME_PROBE,
+	BOOTTIME_PHASE,
+};
+
+struct boottime_rec {
+	u64			start_ns;
+	u64			duration_ns;
+	initcall_t		fn;		/* BOOTTIME_INITCALL only */
+	char			name[BOOTTIME_NAME_LEN];
+	int			ret;
+	enum boottime_type	type;
+};
+
+static struct boottime_rec boottime_recs[BOOTTIME_MAX_RECORDS];
+static atomic_t boottime_next;
+static atomic_t boottime_lost;
+static bool boottime_done;
+
+/*
+ * local_clock() rather than ktime_get(): it is usable from the early
+ * initcalls onwards and two reads per record is all the runtime cost
+ * this feature has.
+ */
+u64 boottime_stamp(void)
+{
+	return local_clock();
+}
+
+static struct boottime_rec *boottime_grab_rec(u64 start_ns)
+{
+	struct boottime_rec *rec;
+	int idx;
+
+	if (boottime_done)
+		return NULL;
+
+	idx = atomic_inc_return(&boottime_next) - 1;
+	if (idx >= BOOTTIME_MAX_RECORDS) {
+		atomic_inc(&boottime_lost);
+		return NULL;
+	}
+
+	rec = &boottime_recs[idx];
+	rec->start_ns = start_ns;
+	rec->duration_ns = boottime_stamp() - start_ns;
+	return rec;
+}
+
+void boottime_record_initcall(initcall_t fn, u64 start_ns, int ret)
+{
+	struct boottime_rec *rec = boottime_grab_rec(start_ns);
+
+	if (!rec)
+		return;
+	rec->type = BOOTTIME_INITCALL;
+	rec->fn = fn;
+	rec->ret = ret;
+}
+
+void boottime_record_probe(struct device_driver *drv, struct device *dev,
+			   u64 start_ns, int ret)
+{
+	struct boottime_rec *rec = boottime_grab_rec(start_ns);
+
+	if (!rec)
+		return;
+	rec->type = BOOTTIME_PROBE;
+	snprintf(rec->name, sizeof(rec->name), "%s:%s", drv->name,
+		 dev_name(dev));
+	rec->ret = ret;
+}
+
+void boottime_record_phase(const char *name, u64 start_ns)
+{
+	struct boottime_rec *rec = boottime_grab_rec(start_ns);
+
+	if (!rec)
+		return;
+	rec->type = BOOTTIME_PHASE;
+	strlcpy(rec->name, name, sizeof(rec->name));
+	rec->ret = 0;
+}
+
+void boottime_finish(void)
+{
+	boottime_done = true;
+}
+
+static void *boottime_seq_start(struct seq_file *m, loff_t *pos)
+{
+	int nr = min_t(int, atomic_read(&boottime_next),
+		       BOOTTIME_MAX_RECORDS);
+
+	if (*pos >= nr)
+		return NULL;
+	return &boottime_recs[*pos];
+}
+
+static void *boottime_seq_next(struct seq_file *m, void *v, loff_t *pos)
+{
+	(*pos)++;
+	return boottime_seq_start(m, pos);
+}
+
+static void boottime_seq_stop(struct seq_file *m, void *v)
+{
+}
+
+static int boottime_seq_show(struct seq_file *m, void *v)
+{
+	struct boottime_rec *rec = v;
+
+	if (rec == boottime_recs) {
+		seq_printf(m, "# lost %d records\n",
+			   atomic_read(&boottime_lost));
+		seq_puts(m, "# type start_us duration_us status entry\n");
+	}
+
+	switch (rec->type) {
+	case BOOTTIME_INITCALL:
+		seq_printf(m, "initcall %llu %llu %d %pf\n",
+			   rec->start_ns / NSEC_PER_USEC,
+			   rec->duration_ns / NSEC_PER_USEC,
+			   rec->ret, rec->fn);
+		break;
+	case BOOTTIME_PROBE:
+		seq_printf(m, "probe %llu %llu %d %s\n",
+			   rec->start_ns / NSEC_PER_USEC,
+			   rec->duration_ns / NSEC_PER_USEC,
+			   rec->ret, rec->name);
+		break;
+	case BOOTTIME_PHASE:
+		seq_printf(m, "phase %llu %llu %d %s\n",
+			   rec->start_ns / NSEC_PER_USEC,
+			   rec->duration_ns / NSEC_PER_USEC,
+			   rec->ret, rec->name);
+		break;
+	}
+	return 0;
+}
+
+static const struct seq_operations boottime_seq_ops = {
+	.start	= boottime_seq_start,
+	.next	= boottime_seq_next,
+	.stop	= boottime_seq_stop,
+	.show	= boottime_seq_show,
+};
+
+static int boottime_open(struct inode *inode, struct file *file)
+{
+	return seq_open(file, &boottime_seq_ops);
+}
+
+static const struct file_operations boottime_proc_fops = {
+	.open		= boottime_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= seq_release,
+};
+
+static int __init boottime_proc_init(void)
+{
+	proc_create("boottime", 0, NULL, &boottime_proc_fops);
+	return 0;
+}
+late_initcall(boottime_proc_init);
@@ -9,6 +9,7 @@
 #endif
 
 #include <linux/init.h>
+#include <linux/boottime.h>
 #include <linux/fs.h>
 #include <linux/slab.h>
 #include <linux/types.h>
@@ -605,16 +606,29 @@ static void __init clean_rootfs(void)
 }
 #endif
 
+/*
+ * The unpack is regularly the single largest chunk of boot that is
+ * neither an initcall nor a probe; give each image its own record.
+ */
+static char * __init unpack_to_rootfs_timed(char *buf, unsigned long len)
+{
+	u64 start = boottime_stamp();
+	char *err = unpack_to_rootfs(buf, len);
+
+	boottime_record_phase("initramfs unpack", start);
+	return err;
+}
+
 static int __init populate_rootfs(void)
 {
-	char *err = unpack_to_rootfs(__initramfs_start, __initramfs_size);
+	char *err = unpack_to_rootfs_timed(__initramfs_start, __initramfs_size);
 	if (err)
 		panic("%s", err); /* Failed to decompress INTERNAL initramfs */
 	if (initrd_start) {
 #ifdef CONFIG_BLK_DEV_RAM
 		int fd;
 		printk(KERN_INFO "Trying to unpack rootfs image as initramfs...\n");
-		err = unpack_to_rootfs((char *)initrd_start,
+		err = unpack_to_rootfs_timed((char *)initrd_start,
 			initrd_end - initrd_start);
 		if (!err) {
 			free_initrd();
@@ -641,7 +655,7 @@ static int __init populate_rootfs(void)
 	done:
 #else
 		printk(KERN_INFO "Unpacking initramfs...\n");
-		err = unpack_to_rootfs((char *)initrd_start,
+		err = unpack_to_rootfs_timed((char *)initrd_start,
 			initrd_end - initrd_start);
 		if (err)
 			printk(KERN_EMERG "Initramfs unpacking failed: %s\n", err);
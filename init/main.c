@@ -13,6 +13,7 @@
 
 #include <linux/types.h>
 #include <linux/module.h>
+#include <linux/boottime.h>
 #include <linux/proc_fs.h>
 #include <linux/kernel.h>
 #include <linux/syscalls.h>
@@ -759,16 +760,19 @@ static int __init_or_module do_one_initcall_debug(initcall_t fn)
 int __init_or_module do_one_initcall(initcall_t fn)
 {
 	int count = preempt_count();
+	u64 calltime;
 	int ret;
 	char msgbuf[64];
 
 	if (initcall_blacklisted(fn))
 		return -EPERM;
 
+	calltime = boottime_stamp();
 	if (initcall_debug)
 		ret = do_one_initcall_debug(fn);
 	else
 		ret = fn();
+	boottime_record_initcall(fn, calltime, ret);
 
 	msgbuf[0] = 0;
 
@@ -935,6 +939,7 @@ static int __ref kernel_init(void *unused)
 	kernel_init_freeable();
 	/* need to finish all async __init code before freeing the memory */
 	async_synchronize_full();
+	boottime_finish();
 	free_initmem();
 	mark_readonly();
 	system_state = SYSTEM_RUNNING;
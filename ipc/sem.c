@@ -704,6 +704,79 @@ undo:
 	return result;
 }
 
+/* Upper bound on the busy-wait iterations in sem_optimistic_spin() */
+#define SEM_OPT_SPIN_MAX	128
+
+/**
+ * sem_may_spin - check whether optimistic spinning could succeed
+ * @sma: semaphore array
+ * @sops: operations that would block
+ * @nsops: number of operations
+ *
+ * Spinning only makes sense for simple operations: complex operations
+ * interact with merge_queues() and are too difficult to analyse, just
+ * like in check_restart(). If alter operations are already queued, then
+ * a release will be handed to those sleepers by update_queue() and the
+ * spinner would merely burn cycles.
+ */
+static bool sem_may_spin(struct sem_array *sma, struct sembuf *sops, int nsops)
+{
+	struct sem *curr;
+
+	if (num_online_cpus() == 1)
+		return false;
+
+	if (nsops != 1)
+		return false;
+
+	curr = &sma->sem_base[sops->sem_num];
+
+	return list_empty(&curr->pending_alter) &&
+	       list_empty(&sma->pending_alter);
+}
+
+/**
+ * sem_optimistic_spin - briefly wait for a semaphore value change
+ * @sma: semaphore array
+ * @q: struct sem_queue that describes the blocked operation
+ * @locknum: in/out - the lock mode returned by sem_lock()
+ *
+ * A semaphore holder that releases within a few hundred cycles makes a
+ * full sleep/wakeup round-trip much more expensive than the operation
+ * itself. Busy-wait for a bounded number of iterations for the value to
+ * change before falling back to sleeping. The sem_lock is dropped while
+ * spinning so that the releaser can acquire it; the caller's rcu read
+ * lock keeps @sma alive.
+ *
+ * Called with sem_lock held, returns with sem_lock reacquired.
+ * The return convention is that of perform_atomic_semop(), with
+ * -EIDRM reported if the array was removed while spinning.
+ */
+static int sem_optimistic_spin(struct sem_array *sma, struct sem_queue *q,
+			       int *locknum)
+{
+	struct sem *curr = &sma->sem_base[q->sops->sem_num];
+	int spins = SEM_OPT_SPIN_MAX;
+	int seen = curr->semval;
+
+	sem_unlock(sma, *locknum);
+
+	while (READ_ONCE(curr->semval) == seen && --spins > 0 &&
+	       !need_resched() && !signal_pending(current))
+		cpu_relax();
+
+	*locknum = sem_lock(sma, q->sops, q->nsops);
+
+	if (!ipc_valid_object(&sma->sem_perm))
+		return -EIDRM;
+
+	/* same RMID race as in SYSCALL_DEFINE4(semtimedop): recheck undo */
+	if (q->undo && q->undo->semid == -1)
+		return -EIDRM;
+
+	return perform_atomic_semop(sma, q);
+}
+
 /** wake_up_sem_queue_prepare(q, error): Prepare wake-up
  * @q: queue entry that must be signaled
  * @error: Error value for the signal
@@ -1928,6 +2001,8 @@ SYSCALL_DEFINE4(semtimedop, int, semid, struct sembuf __user *, tsops,
 	queue.alter = alter;
 
 	error = perform_atomic_semop(sma, &queue);
+	if (error > 0 && sem_may_spin(sma, sops, nsops))
+		error = sem_optimistic_spin(sma, &queue, &locknum);
 	if (error == 0) {
 		/* If the operation was successful, then do
 		 * the required updates.
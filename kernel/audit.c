@@ -53,6 +53,8 @@
 #include <linux/err.h>
 #include <linux/kthread.h>
 #include <linux/kernel.h>
+#include <linux/llist.h>
+#include <linux/percpu.h>
 #include <linux/syscalls.h>
 
 #include <linux/audit.h>
@@ -139,7 +141,13 @@ static DEFINE_SPINLOCK(audit_freelist_lock);
 static int	   audit_freelist_count;
 static LIST_HEAD(audit_freelist);
 
-static struct sk_buff_head audit_skb_queue;
+/* Per-cpu queues of records waiting to be sent to auditd.  Producers
+ * push with a lockless llist_add() so record generation never takes a
+ * shared queue lock; kauditd drains all cpus in one batch per pass.
+ * The llist_node lives in skb->cb while the skb is queued. */
+static DEFINE_PER_CPU(struct llist_head, audit_queue);
+/* number of records queued across all cpus, for the backlog limit */
+static atomic_t audit_backlog = ATOMIC_INIT(0);
 /* queue of skbs to send to auditd when/if it comes back */
 static struct sk_buff_head audit_skb_hold_queue;
 static struct task_struct *kauditd_task;
@@ -511,28 +519,63 @@ static void flush_hold_queue(void)
 	consume_skb(skb);
 }
 
-static int kauditd_thread(void *dummy)
+static struct sk_buff *audit_skb_from_node(struct llist_node *node)
 {
-	set_freezable();
-	while (!kthread_should_stop()) {
-		struct sk_buff *skb;
-
-		flush_hold_queue();
+	return (struct sk_buff *)((char *)node - offsetof(struct sk_buff, cb));
+}
 
-		skb = skb_dequeue(&audit_skb_queue);
+/*
+ * Grab every queued record from the per-cpu queues in a single pass and
+ * push the whole batch out, so each pass touches the shared cachelines
+ * once instead of once per record.  llist_del_all() hands the entries
+ * back newest first; reverse each cpu's batch to preserve the order the
+ * records were logged in on that cpu.  Records from different cpus are
+ * ordered by their serial numbers in userspace anyway.
+ *
+ * Returns the number of records handled.
+ */
+static int kauditd_drain_queues(void)
+{
+	struct llist_node *batch, *next;
+	struct sk_buff *skb;
+	int cpu, count = 0;
 
-		if (skb) {
-			if (!audit_backlog_limit ||
-			    (skb_queue_len(&audit_skb_queue) <= audit_backlog_limit))
-				wake_up(&audit_backlog_wait);
+	for_each_possible_cpu(cpu) {
+		batch = llist_del_all(per_cpu_ptr(&audit_queue, cpu));
+		if (!batch)
+			continue;
+		batch = llist_reverse_order(batch);
+		while (batch) {
+			/* sending frees the skb, and the node with it */
+			next = batch->next;
+			skb = audit_skb_from_node(batch);
+			batch = next;
+			atomic_dec(&audit_backlog);
 			if (audit_pid)
 				kauditd_send_skb(skb);
 			else
 				audit_printk_skb(skb);
-			continue;
+			count++;
 		}
+	}
+
+	if (count && (!audit_backlog_limit ||
+		      atomic_read(&audit_backlog) <= audit_backlog_limit))
+		wake_up(&audit_backlog_wait);
+
+	return count;
+}
+
+static int kauditd_thread(void *dummy)
+{
+	set_freezable();
+	while (!kthread_should_stop()) {
+		flush_hold_queue();
+
+		if (kauditd_drain_queues())
+			continue;
 
-		wait_event_freezable(kauditd_wait, skb_queue_len(&audit_skb_queue));
+		wait_event_freezable(kauditd_wait, atomic_read(&audit_backlog));
 	}
 	return 0;
 }
@@ -857,7 +900,7 @@ static int audit_receive_msg(struct sk_buff *skb, struct nlmsghdr *nlh)
 		s.rate_limit		= audit_rate_limit;
 		s.backlog_limit		= audit_backlog_limit;
 		s.lost			= atomic_read(&audit_lost);
-		s.backlog		= skb_queue_len(&audit_skb_queue);
+		s.backlog		= atomic_read(&audit_backlog);
 		s.feature_bitmap	= AUDIT_FEATURE_BITMAP_ALL;
 		s.backlog_wait_time	= audit_backlog_wait_time_master;
 		audit_send_reply(skb, seq, AUDIT_GET, 0, 0, &s, sizeof(s));
@@ -1192,7 +1235,6 @@ static int __init audit_init(void)
 		audit_default ? "enabled" : "disabled");
 	register_pernet_subsys(&audit_net_ops);
 
-	skb_queue_head_init(&audit_skb_queue);
 	skb_queue_head_init(&audit_skb_hold_queue);
 	audit_initialized = AUDIT_INITIALIZED;
 	audit_enabled = audit_default;
@@ -1345,7 +1387,7 @@ static long wait_for_auditd(long sleep_time)
 	add_wait_queue_exclusive(&audit_backlog_wait, &wait);
 
 	if (audit_backlog_limit &&
-	    skb_queue_len(&audit_skb_queue) > audit_backlog_limit)
+	    atomic_read(&audit_backlog) > audit_backlog_limit)
 		sleep_time = schedule_timeout(sleep_time);
 
 	__set_current_state(TASK_RUNNING);
@@ -1393,7 +1435,7 @@ struct audit_buffer *audit_log_start(struct audit_context *ctx, gfp_t gfp_mask,
 	}
 
 	while (audit_backlog_limit
-	       && skb_queue_len(&audit_skb_queue) > audit_backlog_limit + reserve) {
+	       && atomic_read(&audit_backlog) > audit_backlog_limit + reserve) {
 		if (gfp_mask & __GFP_DIRECT_RECLAIM && audit_backlog_wait_time) {
 			long sleep_time;
 
@@ -1406,7 +1448,7 @@ struct audit_buffer *audit_log_start(struct audit_context *ctx, gfp_t gfp_mask,
 		}
 		if (audit_rate_check() && printk_ratelimit())
 			pr_warn("audit_backlog=%d > audit_backlog_limit=%d\n",
-				skb_queue_len(&audit_skb_queue),
+				atomic_read(&audit_backlog),
 				audit_backlog_limit);
 		audit_log_lost("backlog limit exceeded");
 		audit_backlog_wait_time = 0;
@@ -1995,7 +2037,15 @@ void audit_log_end(struct audit_buffer *ab)
 		nlh->nlmsg_len -= NLMSG_HDRLEN;
 
 		if (audit_pid) {
-			skb_queue_tail(&audit_skb_queue, ab->skb);
+			struct llist_node *node = (void *)ab->skb->cb;
+
+			/*
+			 * llist_add() is atomic, so a migration between
+			 * picking the queue and the add is harmless; use
+			 * raw_cpu_ptr() since we may be preemptible here.
+			 */
+			atomic_inc(&audit_backlog);
+			llist_add(node, raw_cpu_ptr(&audit_queue));
 			wake_up_interruptible(&kauditd_wait);
 		} else {
 			audit_printk_skb(ab->skb);
@@ -26,6 +26,7 @@ struct bpf_htab {
 	struct bucket *buckets;
 	void *elems;
 	struct pcpu_freelist freelist;
+	u32 __percpu *evict_cursor; /* per-cpu bucket cursor for LRU maps */
 	atomic_t count;	/* number of elements in this hashtable */
 	u32 n_buckets;	/* number of hash buckets */
 	u32 elem_size;	/* size of each element in bytes */
@@ -40,9 +41,15 @@ struct htab_elem {
 	};
 	struct rcu_head rcu;
 	u32 hash;
+	u32 lru_ref;	/* reference bit for LRU maps, fills the pad */
 	char key[0] __aligned(8);
 };
 
+static bool htab_is_lru(const struct bpf_htab *htab)
+{
+	return htab->map.map_type == BPF_MAP_TYPE_LRU_HASH;
+}
+
 static inline void htab_elem_set_ptr(struct htab_elem *l, u32 key_size,
 				     void __percpu *pptr)
 {
@@ -117,6 +124,7 @@ free_elems:
 static struct bpf_map *htab_map_alloc(union bpf_attr *attr)
 {
 	bool percpu = attr->map_type == BPF_MAP_TYPE_PERCPU_HASH;
+	bool lru = attr->map_type == BPF_MAP_TYPE_LRU_HASH;
 	struct bpf_htab *htab;
 	int err, i;
 	u64 cost;
@@ -125,6 +133,10 @@ static struct bpf_map *htab_map_alloc(union bpf_attr *attr)
 		/* reserved bits should not be used */
 		return ERR_PTR(-EINVAL);
 
+	if (lru && (attr->map_flags & BPF_F_NO_PREALLOC))
+		/* eviction recycles preallocated elements via the freelist */
+		return ERR_PTR(-EINVAL);
+
 	htab = kzalloc(sizeof(*htab), GFP_USER);
 	if (!htab)
 		return ERR_PTR(-ENOMEM);
@@ -212,6 +224,12 @@ static struct bpf_map *htab_map_alloc(union bpf_attr *attr)
 		raw_spin_lock_init(&htab->buckets[i].lock);
 	}
 
+	if (lru) {
+		htab->evict_cursor = alloc_percpu(u32);
+		if (!htab->evict_cursor)
+			goto free_buckets;
+	}
+
 	if (!(attr->map_flags & BPF_F_NO_PREALLOC)) {
 		err = prealloc_elems_and_freelist(htab);
 		if (err)
@@ -221,6 +239,7 @@ static struct bpf_map *htab_map_alloc(union bpf_attr *attr)
 	return &htab->map;
 
 free_buckets:
+	free_percpu(htab->evict_cursor);
 	kvfree(htab->buckets);
 free_htab:
 	kfree(htab);
@@ -379,6 +398,47 @@ static void free_htab_elem(struct bpf_htab *htab, struct htab_elem *l)
 	}
 }
 
+/* Recycle one aged-out element of an LRU map into the freelist.
+ *
+ * Second-chance rotation: each CPU sweeps the buckets from its own
+ * cursor, clearing the reference bit of recently used elements and
+ * evicting the first element found without it.  There is no global
+ * eviction state, so concurrent updaters work on different regions of
+ * the table and only contend on the usual bucket locks.
+ *
+ * Like any element replacement in a preallocated map, the victim may
+ * still be visible to concurrent lookups until they drop rcu_read_lock;
+ * such lookups can observe the element being recycled.
+ */
+static bool htab_lru_evict(struct bpf_htab *htab)
+{
+	u32 *cursor = this_cpu_ptr(htab->evict_cursor);
+	u32 nr = htab->n_buckets;
+	struct hlist_node *n;
+	struct htab_elem *l;
+	unsigned long flags;
+	u32 i;
+
+	/* first sweep may only strip reference bits, hence up to 2 * nr */
+	for (i = 0; i < 2 * nr; i++) {
+		struct bucket *b = &htab->buckets[(*cursor)++ & (nr - 1)];
+
+		raw_spin_lock_irqsave(&b->lock, flags);
+		hlist_for_each_entry_safe(l, n, &b->head, hash_node) {
+			if (READ_ONCE(l->lru_ref)) {
+				WRITE_ONCE(l->lru_ref, 0);
+				continue;
+			}
+			hlist_del_rcu(&l->hash_node);
+			raw_spin_unlock_irqrestore(&b->lock, flags);
+			pcpu_freelist_push(&htab->freelist, &l->fnode);
+			return true;
+		}
+		raw_spin_unlock_irqrestore(&b->lock, flags);
+	}
+	return false;
+}
+
 static struct htab_elem *alloc_htab_elem(struct bpf_htab *htab, void *key,
 					 void *value, u32 key_size, u32 hash,
 					 bool percpu, bool onallcpus)
@@ -390,6 +450,9 @@ static struct htab_elem *alloc_htab_elem(struct bpf_htab *htab, void *key,
 
 	if (prealloc) {
 		l_new = (struct htab_elem *)pcpu_freelist_pop(&htab->freelist);
+		while (!l_new && htab_is_lru(htab) && htab_lru_evict(htab))
+			l_new = (struct htab_elem *)
+				pcpu_freelist_pop(&htab->freelist);
 		if (!l_new)
 			return ERR_PTR(-E2BIG);
 	} else {
@@ -510,6 +573,64 @@ err:
 	return ret;
 }
 
+/* Called from syscall or from eBPF program */
+static int htab_lru_map_update_elem(struct bpf_map *map, void *key, void *value,
+				    u64 map_flags)
+{
+	struct bpf_htab *htab = container_of(map, struct bpf_htab, map);
+	struct htab_elem *l_new, *l_old;
+	struct hlist_head *head;
+	unsigned long flags;
+	struct bucket *b;
+	u32 key_size, hash;
+	int ret;
+
+	if (unlikely(map_flags > BPF_EXIST))
+		/* unknown flags */
+		return -EINVAL;
+
+	WARN_ON_ONCE(!rcu_read_lock_held());
+
+	key_size = map->key_size;
+
+	hash = htab_map_hash(key, key_size);
+
+	b = __select_bucket(htab, hash);
+	head = &b->head;
+
+	/* The element must be allocated before taking the bucket lock:
+	 * eviction walks the other buckets and takes their locks.
+	 */
+	l_new = alloc_htab_elem(htab, key, value, key_size, hash,
+				false, false);
+	if (IS_ERR(l_new))
+		return PTR_ERR(l_new);
+
+	/* a fresh element counts as recently used */
+	l_new->lru_ref = 1;
+
+	/* bpf_map_update_elem() can be called in_irq() */
+	raw_spin_lock_irqsave(&b->lock, flags);
+
+	l_old = lookup_elem_raw(head, hash, key, key_size);
+
+	ret = check_flags(htab, l_old, map_flags);
+	if (ret)
+		goto err;
+
+	hlist_add_head_rcu(&l_new->hash_node, head);
+	if (l_old) {
+		hlist_del_rcu(&l_old->hash_node);
+		free_htab_elem(htab, l_old);
+	}
+	raw_spin_unlock_irqrestore(&b->lock, flags);
+	return 0;
+err:
+	raw_spin_unlock_irqrestore(&b->lock, flags);
+	pcpu_freelist_push(&htab->freelist, &l_new->fnode);
+	return ret;
+}
+
 static int __htab_percpu_map_update_elem(struct bpf_map *map, void *key,
 					 void *value, u64 map_flags,
 					 bool onallcpus)
@@ -652,6 +773,7 @@ static void htab_map_free(struct bpf_map *map)
 		htab_free_elems(htab);
 		pcpu_freelist_destroy(&htab->freelist);
 	}
+	free_percpu(htab->evict_cursor);
 	kvfree(htab->buckets);
 	kfree(htab);
 }
@@ -670,6 +792,37 @@ static struct bpf_map_type_list htab_type __read_mostly = {
 	.type = BPF_MAP_TYPE_HASH,
 };
 
+/* Called from syscall or from eBPF program */
+static void *htab_lru_map_lookup_elem(struct bpf_map *map, void *key)
+{
+	struct htab_elem *l = __htab_map_lookup_elem(map, key);
+
+	if (l) {
+		/* lockless reference bit keeps the element off the
+		 * eviction sweep's next pass
+		 */
+		if (!READ_ONCE(l->lru_ref))
+			WRITE_ONCE(l->lru_ref, 1);
+		return l->key + round_up(map->key_size, 8);
+	}
+
+	return NULL;
+}
+
+static const struct bpf_map_ops htab_lru_ops = {
+	.map_alloc = htab_map_alloc,
+	.map_free = htab_map_free,
+	.map_get_next_key = htab_map_get_next_key,
+	.map_lookup_elem = htab_lru_map_lookup_elem,
+	.map_update_elem = htab_lru_map_update_elem,
+	.map_delete_elem = htab_map_delete_elem,
+};
+
+static struct bpf_map_type_list htab_lru_type __read_mostly = {
+	.ops = &htab_lru_ops,
+	.type = BPF_MAP_TYPE_LRU_HASH,
+};
+
 /* Called from eBPF program */
 static void *htab_percpu_map_lookup_elem(struct bpf_map *map, void *key)
 {
@@ -739,6 +892,7 @@ static struct bpf_map_type_list htab_percpu_type __read_mostly = {
 static int __init register_htab_map(void)
 {
 	bpf_register_map_type(&htab_type);
+	bpf_register_map_type(&htab_lru_type);
 	bpf_register_map_type(&htab_percpu_type);
 	return 0;
 }
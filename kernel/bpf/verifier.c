@@ -25,9 +25,13 @@
  * The first pass is depth-first-search to check that the program is a DAG.
  * It rejects the following programs:
  * - larger than BPF_MAXINSNS insns
- * - if loop is present (detected via back-edge)
  * - unreachable insns exist (shouldn't be a forest. program = one function)
  * - out of bounds or malformed jumps
+ * Back-edges (loops) are accepted; the second pass must then prove the
+ * iteration count bounded by simulating the loop to completion on tracked
+ * constants.  A loop whose exit cannot be decided that way re-reaches an
+ * equivalent state that is still on the path being explored and is
+ * rejected.
  * The second pass is all possible path descent from the 1st insn.
  * Since it's analyzing all pathes through the program, the length of the
  * analysis is limited to 32k insn, which may be hit even if total number of
@@ -172,6 +176,12 @@ struct verifier_state {
 struct verifier_state_list {
 	struct verifier_state state;
 	struct verifier_state_list *next;
+	/* set while the state is an ancestor of the path being explored;
+	 * reaching an equivalent state then means a loop made no progress,
+	 * whereas matching a completed (off-path) state is a safe prune
+	 */
+	bool in_path;
+	struct verifier_state_list *path_next;
 };
 
 /* verifier_state + insn_idx are pushed to stack when branch is encountered */
@@ -184,6 +194,10 @@ struct verifier_stack_elem {
 	int insn_idx;
 	int prev_insn_idx;
 	struct verifier_stack_elem *next;
+	/* head of the in-path state list at push time, so that popping the
+	 * branch can mark the states stored since then as completed
+	 */
+	struct verifier_state_list *path_head;
 };
 
 #define MAX_USED_MAPS 64 /* max number of maps accessed by one eBPF program */
@@ -197,6 +211,7 @@ struct verifier_env {
 	int stack_size;			/* number of states to be processed */
 	struct verifier_state cur_state; /* current verifier state */
 	struct verifier_state_list **explored_states; /* search pruning optimization */
+	struct verifier_state_list *path_head; /* states stored along the current path */
 	struct bpf_map *used_maps[MAX_USED_MAPS]; /* array of map's used by eBPF program */
 	u32 used_map_cnt;		/* number of used maps */
 	bool allow_ptr_leaks;
@@ -428,6 +443,16 @@ static int pop_stack(struct verifier_env *env, int *prev_insn_idx)
 	if (env->head == NULL)
 		return -1;
 
+	/* every state stored since this branch was pushed is now fully
+	 * explored (the stack is LIFO, so all younger branches are gone):
+	 * take it off the path so future revisits prune instead of being
+	 * treated as loops
+	 */
+	while (env->path_head != env->head->path_head) {
+		env->path_head->in_path = false;
+		env->path_head = env->path_head->path_next;
+	}
+
 	memcpy(&env->cur_state, &env->head->st, sizeof(env->cur_state));
 	insn_idx = env->head->insn_idx;
 	if (prev_insn_idx)
@@ -451,6 +476,7 @@ static struct verifier_state *push_stack(struct verifier_env *env, int insn_idx,
 	memcpy(&elem->st, &env->cur_state, sizeof(env->cur_state));
 	elem->insn_idx = insn_idx;
 	elem->prev_insn_idx = prev_insn_idx;
+	elem->path_head = env->path_head;
 	elem->next = env->head;
 	env->head = elem;
 	env->stack_size++;
@@ -652,8 +678,15 @@ static int check_ctx_access(struct verifier_env *env, int off, int size,
 			    enum bpf_access_type t)
 {
 	if (env->prog->aux->ops->is_valid_access &&
-	    env->prog->aux->ops->is_valid_access(off, size, t))
+	    env->prog->aux->ops->is_valid_access(off, size, t)) {
+		/* remember the offset of the largest ctx access, so that
+		 * program types backed by variable sized contexts (like
+		 * tracepoint records) can check it at attach time
+		 */
+		if (off + size > env->prog->aux->max_ctx_offset)
+			env->prog->aux->max_ctx_offset = off + size;
 		return 0;
+	}
 
 	verbose("invalid bpf_context access off=%d size=%d\n", off, size);
 	return -EACCES;
@@ -1106,10 +1139,20 @@ static int check_alu_op(struct verifier_env *env, struct bpf_insn *insn)
 			}
 		} else {
 			/* case: R = imm
-			 * remember the value we stored into this reg
+			 * remember the value we stored into this reg.
+			 * The interpreter zero-extends a 32-bit mov (see
+			 * ALU_MOV_K in core.c), so a negative imm loaded
+			 * with BPF_ALU runs with value 2^32 + imm, which
+			 * the s32 tracked here cannot represent; leave the
+			 * register unknown then, so that the constant
+			 * branch and alu folding never reason from a value
+			 * that differs from the run-time one.
 			 */
-			regs[insn->dst_reg].type = CONST_IMM;
-			regs[insn->dst_reg].imm = insn->imm;
+			if (BPF_CLASS(insn->code) == BPF_ALU64 ||
+			    insn->imm >= 0) {
+				regs[insn->dst_reg].type = CONST_IMM;
+				regs[insn->dst_reg].imm = insn->imm;
+			}
 		}
 
 	} else if (opcode > BPF_END) {
@@ -1119,6 +1162,8 @@ static int check_alu_op(struct verifier_env *env, struct bpf_insn *insn)
 	} else {	/* all other ALU ops: and, sub, xor, add, ... */
 
 		bool stack_relative = false;
+		bool const_fold = false;
+		s64 fold_imm = 0;
 
 		if (BPF_SRC(insn->code) == BPF_X) {
 			if (insn->imm != 0 || insn->off != 0) {
@@ -1157,6 +1202,33 @@ static int check_alu_op(struct verifier_env *env, struct bpf_insn *insn)
 			}
 		}
 
+		/* fold 64-bit add/sub of known constants, so that induction
+		 * variables of bounded loops stay tracked as CONST_IMM and
+		 * the loop exit test eventually resolves during simulation
+		 */
+		if (BPF_CLASS(insn->code) == BPF_ALU64 &&
+		    (opcode == BPF_ADD || opcode == BPF_SUB) &&
+		    regs[insn->dst_reg].type == CONST_IMM) {
+			if (BPF_SRC(insn->code) == BPF_K) {
+				fold_imm = insn->imm;
+				const_fold = true;
+			} else if (regs[insn->src_reg].type == CONST_IMM) {
+				fold_imm = regs[insn->src_reg].imm;
+				const_fold = true;
+			}
+			if (const_fold) {
+				if (opcode == BPF_ADD)
+					fold_imm = regs[insn->dst_reg].imm +
+						   fold_imm;
+				else
+					fold_imm = regs[insn->dst_reg].imm -
+						   fold_imm;
+				/* fall back to unknown on s32 overflow */
+				if (fold_imm != (s64)(s32)fold_imm)
+					const_fold = false;
+			}
+		}
+
 		/* pattern match 'bpf_add Rx, imm' instruction */
 		if (opcode == BPF_ADD && BPF_CLASS(insn->code) == BPF_ALU64 &&
 		    regs[insn->dst_reg].type == FRAME_PTR &&
@@ -1181,6 +1253,9 @@ static int check_alu_op(struct verifier_env *env, struct bpf_insn *insn)
 		if (stack_relative) {
 			regs[insn->dst_reg].type = PTR_TO_STACK;
 			regs[insn->dst_reg].imm = insn->imm;
+		} else if (const_fold) {
+			regs[insn->dst_reg].type = CONST_IMM;
+			regs[insn->dst_reg].imm = fold_imm;
 		}
 	}
 
@@ -1228,26 +1303,56 @@ static int check_cond_jmp_op(struct verifier_env *env,
 	if (err)
 		return err;
 
-	/* detect if R == 0 where R was initialized to zero earlier */
-	if (BPF_SRC(insn->code) == BPF_K &&
-	    (opcode == BPF_JEQ || opcode == BPF_JNE) &&
-	    regs[insn->dst_reg].type == CONST_IMM &&
-	    regs[insn->dst_reg].imm == insn->imm) {
-		if (opcode == BPF_JEQ) {
-			/* if (imm == imm) goto pc+off;
-			 * only follow the goto, ignore fall-through
-			 */
-			*insn_idx += insn->off;
-			return 0;
-		} else {
-			/* if (imm != imm) goto pc+off;
-			 * only follow fall-through branch, since
-			 * that's where the program will go
-			 */
-			return 0;
+	/* if both operands are known constants, the branch direction is
+	 * known as well: follow only the taken side.  Besides avoiding
+	 * useless exploration, this is what lets a bounded loop whose
+	 * induction variable is tracked as CONST_IMM terminate during
+	 * simulation once its exit test resolves.
+	 * CONST_IMM always equals the run-time register value:
+	 * check_alu_op refuses to track 32-bit movs of negative
+	 * immediates, which the interpreter zero-extends, so
+	 * sign-extending the tracked s32 here (like the interpreter
+	 * sign-extends the s32 imm of the jump itself) is exact.
+	 */
+	if (regs[insn->dst_reg].type == CONST_IMM &&
+	    (BPF_SRC(insn->code) == BPF_K ||
+	     regs[insn->src_reg].type == CONST_IMM)) {
+		s64 sdst = regs[insn->dst_reg].imm;
+		s64 ssrc = (BPF_SRC(insn->code) == BPF_K) ? insn->imm :
+			   regs[insn->src_reg].imm;
+		bool taken;
+
+		switch (opcode) {
+		case BPF_JEQ:
+			taken = sdst == ssrc;
+			break;
+		case BPF_JNE:
+			taken = sdst != ssrc;
+			break;
+		case BPF_JGT:
+			taken = (u64)sdst > (u64)ssrc;
+			break;
+		case BPF_JGE:
+			taken = (u64)sdst >= (u64)ssrc;
+			break;
+		case BPF_JSGT:
+			taken = sdst > ssrc;
+			break;
+		case BPF_JSGE:
+			taken = sdst >= ssrc;
+			break;
+		case BPF_JSET:
+			taken = (u64)sdst & (u64)ssrc;
+			break;
+		default:
+			goto push_both;
 		}
+		if (taken)
+			*insn_idx += insn->off;
+		return 0;
 	}
 
+push_both:
 	other_branch = push_stack(env, *insn_idx + insn->off + 1, *insn_idx);
 	if (!other_branch)
 		return -EFAULT;
@@ -1487,8 +1592,13 @@ static int push_insn(int t, int w, int e, struct verifier_env *env)
 		insn_stack[cur_stack++] = w;
 		return 1;
 	} else if ((insn_state[w] & 0xF0) == DISCOVERED) {
-		verbose("back-edge from insn %d to %d\n", t, w);
-		return -EINVAL;
+		/* back-edge: accept the loop for now, but force state
+		 * tracking at its header so do_check() promptly tells a
+		 * bounded loop (constants make progress until the exit
+		 * test resolves) from an unbounded one
+		 */
+		env->explored_states[w] = STATE_LIST_MARK;
+		insn_state[t] = DISCOVERED | e;
 	} else if (insn_state[w] == EXPLORED) {
 		/* forward- or cross-edge */
 		insn_state[t] = DISCOVERED | e;
@@ -1499,8 +1609,9 @@ static int push_insn(int t, int w, int e, struct verifier_env *env)
 	return 0;
 }
 
-/* non-recursive depth-first-search to detect loops in BPF program
- * loop == back-edge in directed graph
+/* non-recursive depth-first-search over the BPF program: checks
+ * reachability and jump validity and records loop headers (back-edge
+ * targets) for the bounded-loop analysis in do_check()
  */
 static int check_cfg(struct verifier_env *env)
 {
@@ -1692,28 +1803,50 @@ static int is_state_visited(struct verifier_env *env, int insn_idx)
 		return 0;
 
 	while (sl != STATE_LIST_MARK) {
-		if (states_equal(&sl->state, &env->cur_state))
+		if (states_equal(&sl->state, &env->cur_state)) {
+			/* coming back to an equivalent state that is an
+			 * ancestor of the path still being explored means no
+			 * forward progress was made: simulating on from here
+			 * would only repeat itself, so the iteration count
+			 * cannot be proven bounded.  This must not be pruned
+			 * as safe - the matched state was never proven to
+			 * reach bpf_exit
+			 */
+			if (sl->in_path) {
+				verbose("infinite loop detected at insn %d\n",
+					insn_idx);
+				return -EINVAL;
+			}
 			/* reached equivalent register/stack state,
 			 * prune the search
 			 */
 			return 1;
+		}
 		sl = sl->next;
 	}
 
 	/* there were no equivalent states, remember current one.
 	 * technically the current state is not proven to be safe yet,
 	 * but it will either reach bpf_exit (which means it's safe) or
-	 * it will be rejected. Since there are no loops, we won't be
-	 * seeing this 'insn_idx' instruction again on the way to bpf_exit
+	 * it will be rejected. Every iteration of a bounded loop differs
+	 * in at least one tracked constant, so the states stored at its
+	 * header keep the simulation making progress until the exit test
+	 * resolves (or the insn_processed limit fires)
 	 */
 	new_sl = kmalloc(sizeof(struct verifier_state_list), GFP_USER);
 	if (!new_sl)
 		return -ENOMEM;
 
-	/* add new state to the head of linked list */
+	/* add new state to the head of linked list and to the current path;
+	 * pop_stack() takes it off the path once all its continuations have
+	 * been explored
+	 */
 	memcpy(&new_sl->state, &env->cur_state, sizeof(env->cur_state));
 	new_sl->next = env->explored_states[insn_idx];
 	env->explored_states[insn_idx] = new_sl;
+	new_sl->in_path = true;
+	new_sl->path_next = env->path_head;
+	env->path_head = new_sl;
 	return 0;
 }
 
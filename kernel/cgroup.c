@@ -2805,6 +2805,51 @@ static int cgroup_procs_write_permission(struct task_struct *task,
 	return ret;
 }
 
+/*
+ * Orchestrators tend to migrate many tasks in quick succession and every
+ * migration writes cgroup_threadgroup_rwsem.  Hold the rwsem's batch
+ * mode for a while after each migration so that a burst of them pays for
+ * a single RCU grace period instead of one per write section.  The cost
+ * is that fork/exit use the reader slow path until the batch times out.
+ */
+#define CGROUP_MIGRATE_BATCH_TIMEOUT	(HZ / 10)
+
+static void cgroup_migrate_batch_fn(struct work_struct *work);
+
+static DEFINE_MUTEX(cgroup_migrate_batch_mutex);
+static DECLARE_DELAYED_WORK(cgroup_migrate_batch_work, cgroup_migrate_batch_fn);
+static unsigned long cgroup_migrate_batch_until;
+static bool cgroup_migrate_batch_held;
+
+static void cgroup_migrate_batch_hold(void)
+{
+	mutex_lock(&cgroup_migrate_batch_mutex);
+	if (!cgroup_migrate_batch_held) {
+		percpu_rwsem_batch_begin(&cgroup_threadgroup_rwsem);
+		cgroup_migrate_batch_held = true;
+	}
+	cgroup_migrate_batch_until = jiffies + CGROUP_MIGRATE_BATCH_TIMEOUT;
+	mod_delayed_work(system_wq, &cgroup_migrate_batch_work,
+			 CGROUP_MIGRATE_BATCH_TIMEOUT);
+	mutex_unlock(&cgroup_migrate_batch_mutex);
+}
+
+static void cgroup_migrate_batch_fn(struct work_struct *work)
+{
+	mutex_lock(&cgroup_migrate_batch_mutex);
+	if (cgroup_migrate_batch_held) {
+		if (time_before(jiffies, cgroup_migrate_batch_until)) {
+			/* extended by a later migration, re-arm */
+			mod_delayed_work(system_wq, &cgroup_migrate_batch_work,
+					 cgroup_migrate_batch_until - jiffies);
+		} else {
+			percpu_rwsem_batch_end(&cgroup_threadgroup_rwsem);
+			cgroup_migrate_batch_held = false;
+		}
+	}
+	mutex_unlock(&cgroup_migrate_batch_mutex);
+}
+
 /*
  * Find the task_struct of the task to attach by vpid and pass it along to the
  * function to attach either it or all tasks in its threadgroup. Will lock
@@ -2825,6 +2870,7 @@ static ssize_t __cgroup_procs_write(struct kernfs_open_file *of, char *buf,
 	if (!cgrp)
 		return -ENODEV;
 
+	cgroup_migrate_batch_hold();
 	percpu_down_write(&cgroup_threadgroup_rwsem);
 	rcu_read_lock();
 	if (pid) {
@@ -170,10 +170,18 @@ typedef enum {
 	CS_MEM_HARDWALL,
 	CS_MEMORY_MIGRATE,
 	CS_SCHED_LOAD_BALANCE,
+	CS_SCHED_PARTITION,
 	CS_SPREAD_PAGE,
 	CS_SPREAD_SLAB,
 } cpuset_flagbits_t;
 
+/*
+ * Number of cpusets with 'sched_partition' set.  While this is zero the
+ * sched domain code below can take its historical shortcuts.  Protected
+ * by cpuset_mutex.
+ */
+static int nr_sched_partitions;
+
 /* convenient tests for these bits */
 static inline bool is_cpuset_online(const struct cpuset *cs)
 {
@@ -200,6 +208,11 @@ static inline int is_sched_load_balance(const struct cpuset *cs)
 	return test_bit(CS_SCHED_LOAD_BALANCE, &cs->flags);
 }
 
+static inline int is_sched_partition(const struct cpuset *cs)
+{
+	return test_bit(CS_SCHED_PARTITION, &cs->flags);
+}
+
 static inline int is_memory_migrate(const struct cpuset *cs)
 {
 	return test_bit(CS_MEMORY_MIGRATE, &cs->flags);
@@ -520,6 +533,21 @@ static int validate_change(struct cpuset *cur, struct cpuset *trial)
 				       trial->cpus_allowed))
 		goto out;
 
+	/*
+	 * A scheduling partition owns its CPUs outright, so it must be
+	 * cpu_exclusive with a non-empty cpus_allowed, and partitions
+	 * must not nest.
+	 */
+	ret = -EINVAL;
+	if (is_sched_partition(trial)) {
+		if (!is_cpu_exclusive(trial) ||
+		    cpumask_empty(trial->cpus_allowed))
+			goto out;
+		for (c = par; c != &top_cpuset; c = parent_cs(c))
+			if (is_sched_partition(c))
+				goto out;
+	}
+
 	ret = 0;
 out:
 	rcu_read_unlock();
@@ -564,6 +592,24 @@ static void update_domain_attr_tree(struct sched_domain_attr *dattr,
 	rcu_read_unlock();
 }
 
+/*
+ * Is there a load balancing cpuset between @cs and the root?  Such an
+ * ancestor is already a domain root of its own, so @cs must not become
+ * one too.
+ */
+static bool below_balanced_root(struct cpuset *cs)
+{
+	struct cpuset *p;
+
+	for (p = parent_cs(cs); p; p = parent_cs(p)) {
+		if (is_sched_load_balance(p))
+			return true;
+		if (p == &top_cpuset)
+			break;
+	}
+	return false;
+}
+
 /*
  * generate_sched_domains()
  *
@@ -641,7 +687,7 @@ static int generate_sched_domains(cpumask_var_t **domains,
 	cpumask_andnot(non_isolated_cpus, cpu_possible_mask, cpu_isolated_map);
 
 	/* Special case for the 99% of systems with one, full, sched domain */
-	if (is_sched_load_balance(&top_cpuset)) {
+	if (is_sched_load_balance(&top_cpuset) && !nr_sched_partitions) {
 		ndoms = 1;
 		doms = alloc_sched_domains(ndoms);
 		if (!doms)
@@ -667,6 +713,21 @@ static int generate_sched_domains(cpumask_var_t **domains,
 	cpuset_for_each_descendant_pre(cp, pos_css, &top_cpuset) {
 		if (cp == &top_cpuset)
 			continue;
+
+		/*
+		 * A partition is a domain root of its own regardless of
+		 * what its ancestors do; its CPUs are carved out of the
+		 * surrounding domain when the masks are populated below.
+		 */
+		if (is_sched_partition(cp)) {
+			if (cpumask_intersects(cp->cpus_allowed,
+					       non_isolated_cpus))
+				csa[csn++] = cp;
+			/* skip @cp's subtree */
+			pos_css = css_rightmost_descendant(pos_css);
+			continue;
+		}
+
 		/*
 		 * Continue traversing beyond @cp iff @cp has some CPUs and
 		 * isn't load balancing.  The former is obvious.  The
@@ -680,14 +741,28 @@ static int generate_sched_domains(cpumask_var_t **domains,
 		      cpumask_intersects(cp->cpus_allowed, non_isolated_cpus)))
 			continue;
 
-		if (is_sched_load_balance(cp))
+		if (is_sched_load_balance(cp) && !below_balanced_root(cp))
 			csa[csn++] = cp;
 
-		/* skip @cp's subtree */
-		pos_css = css_rightmost_descendant(pos_css);
+		/*
+		 * Normally a balancing cpuset absorbs its whole subtree
+		 * into one domain, so the subtree can be skipped.  With
+		 * partitions around we must keep walking, as a partition
+		 * below a balanced root still gets its own entry.
+		 */
+		if (!nr_sched_partitions)
+			pos_css = css_rightmost_descendant(pos_css);
 	}
 	rcu_read_unlock();
 
+	/*
+	 * When the root cpuset balances, everything not claimed by a
+	 * partition forms one domain rooted at top_cpuset (the fast path
+	 * above handles the partition-free case).
+	 */
+	if (is_sched_load_balance(&top_cpuset))
+		csa[csn++] = &top_cpuset;
+
 	for (i = 0; i < csn; i++)
 		csa[i]->pn = i;
 	ndoms = csn;
@@ -702,7 +777,13 @@ restart:
 			struct cpuset *b = csa[j];
 			int bpn = b->pn;
 
-			if (apn != bpn && cpusets_overlap(a, b)) {
+			/*
+			 * Partitions stay standalone: an overlap can only
+			 * come from an ancestor's domain, which gets the
+			 * partition's CPUs subtracted below.
+			 */
+			if (apn != bpn && !is_sched_partition(a) &&
+			    !is_sched_partition(b) && cpusets_overlap(a, b)) {
 				for (k = 0; k < csn; k++) {
 					struct cpuset *c = csa[k];
 
@@ -767,6 +848,20 @@ restart:
 				b->pn = -1;
 			}
 		}
+
+		/*
+		 * Every sched_partition owns its CPUs; carve them out of
+		 * any enclosing domain.
+		 */
+		if (!is_sched_partition(a)) {
+			for (j = 0; j < csn; j++) {
+				struct cpuset *b = csa[j];
+
+				if (is_sched_partition(b))
+					cpumask_andnot(dp, dp,
+						       b->effective_cpus);
+			}
+		}
 		nslot++;
 	}
 	BUG_ON(nslot != ndoms);
@@ -1316,6 +1411,7 @@ static int update_flag(cpuset_flagbits_t bit, struct cpuset *cs,
 {
 	struct cpuset *trialcs;
 	int balance_flag_changed;
+	int partition_flag_changed;
 	int spread_flag_changed;
 	int err;
 
@@ -1335,6 +1431,9 @@ static int update_flag(cpuset_flagbits_t bit, struct cpuset *cs,
 	balance_flag_changed = (is_sched_load_balance(cs) !=
 				is_sched_load_balance(trialcs));
 
+	partition_flag_changed = (is_sched_partition(cs) !=
+				  is_sched_partition(trialcs));
+
 	spread_flag_changed = ((is_spread_slab(cs) != is_spread_slab(trialcs))
 			|| (is_spread_page(cs) != is_spread_page(trialcs)));
 
@@ -1342,7 +1441,11 @@ static int update_flag(cpuset_flagbits_t bit, struct cpuset *cs,
 	cs->flags = trialcs->flags;
 	spin_unlock_irq(&callback_lock);
 
-	if (!cpumask_empty(trialcs->cpus_allowed) && balance_flag_changed)
+	if (partition_flag_changed)
+		nr_sched_partitions += turning_on ? 1 : -1;
+
+	if (!cpumask_empty(trialcs->cpus_allowed) &&
+	    (balance_flag_changed || partition_flag_changed))
 		rebuild_sched_domains_locked();
 
 	if (spread_flag_changed)
@@ -1597,6 +1700,7 @@ typedef enum {
 	FILE_MEM_EXCLUSIVE,
 	FILE_MEM_HARDWALL,
 	FILE_SCHED_LOAD_BALANCE,
+	FILE_SCHED_PARTITION,
 	FILE_SCHED_RELAX_DOMAIN_LEVEL,
 	FILE_MEMORY_PRESSURE_ENABLED,
 	FILE_MEMORY_PRESSURE,
@@ -1630,6 +1734,9 @@ static int cpuset_write_u64(struct cgroup_subsys_state *css, struct cftype *cft,
 	case FILE_SCHED_LOAD_BALANCE:
 		retval = update_flag(CS_SCHED_LOAD_BALANCE, cs, val);
 		break;
+	case FILE_SCHED_PARTITION:
+		retval = update_flag(CS_SCHED_PARTITION, cs, val);
+		break;
 	case FILE_MEMORY_MIGRATE:
 		retval = update_flag(CS_MEMORY_MIGRATE, cs, val);
 		break;
@@ -1791,6 +1898,8 @@ static u64 cpuset_read_u64(struct cgroup_subsys_state *css, struct cftype *cft)
 		return is_mem_hardwall(cs);
 	case FILE_SCHED_LOAD_BALANCE:
 		return is_sched_load_balance(cs);
+	case FILE_SCHED_PARTITION:
+		return is_sched_partition(cs);
 	case FILE_MEMORY_MIGRATE:
 		return is_memory_migrate(cs);
 	case FILE_MEMORY_PRESSURE_ENABLED:
@@ -1886,6 +1995,13 @@ static struct cftype files[] = {
 		.private = FILE_SCHED_LOAD_BALANCE,
 	},
 
+	{
+		.name = "sched_partition",
+		.read_u64 = cpuset_read_u64,
+		.write_u64 = cpuset_write_u64,
+		.private = FILE_SCHED_PARTITION,
+	},
+
 	{
 		.name = "sched_relax_domain_level",
 		.read_s64 = cpuset_read_s64,
@@ -2043,6 +2159,9 @@ static void cpuset_css_offline(struct cgroup_subsys_state *css)
 
 	mutex_lock(&cpuset_mutex);
 
+	if (is_sched_partition(cs))
+		update_flag(CS_SCHED_PARTITION, cs, 0);
+
 	if (is_sched_load_balance(cs))
 		update_flag(CS_SCHED_LOAD_BALANCE, cs, 0);
 
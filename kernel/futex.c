@@ -65,6 +65,7 @@
 #include <linux/freezer.h>
 #include <linux/bootmem.h>
 #include <linux/fault-inject.h>
+#include <linux/vmalloc.h>
 
 #include <asm/futex.h>
 
@@ -373,6 +374,22 @@ static inline int hb_waiters_pending(struct futex_hash_bucket *hb)
 #endif
 }
 
+/*
+ * Opt-in hash table for the mm-keyed futexes of one process, so its hash
+ * collisions and bucket cacheline traffic cannot leak into (or come from)
+ * unrelated processes, and so the buckets can sit on the process's own
+ * NUMA node.  It is allocated once via prctl(PR_SET_FUTEX_HASH_SLOTS)
+ * while the mm still has a single user and is immutable from then on,
+ * which keeps hash_futex() a plain load: a waiter queued in one table can
+ * never be missed by a waker looking at the other.
+ */
+struct futex_private_hash {
+	unsigned int			mask;
+	struct futex_hash_bucket	queues[];
+};
+
+#define FUTEX_PRIVATE_HASH_SLOTS_MAX	65536
+
 /*
  * We hash on the keys returned from get_futex_key (see below).
  */
@@ -381,6 +398,20 @@ static struct futex_hash_bucket *hash_futex(union futex_key *key)
 	u32 hash = jhash2((u32*)&key->both.word,
 			  (sizeof(key->both.word)+sizeof(key->both.ptr))/4,
 			  key->both.offset);
+
+	/*
+	 * Private and MMSHARED keys are only ever matched by tasks sharing
+	 * the mm they carry, so routing them through that mm's table keeps
+	 * the keyspace intact.  Inode keys are system wide and must stay
+	 * in the global table.
+	 */
+	if (!(key->both.offset & FUT_OFF_INODE) && key->private.mm) {
+		struct futex_private_hash *fph;
+
+		fph = smp_load_acquire(&key->private.mm->futex_phash);
+		if (fph)
+			return &fph->queues[hash & fph->mask];
+	}
 	return &futex_queues[hash & (futex_hashsize - 1)];
 }
 
@@ -3218,6 +3249,83 @@ SYSCALL_DEFINE6(futex, u32 __user *, uaddr, int, op, u32, val,
 	return do_futex(uaddr, op, val, tp, uaddr2, val2, val3);
 }
 
+/*
+ * Give the calling process its own hash table for mm-keyed futexes.
+ *
+ * @slots: number of buckets, rounded up to a power of two; 0 selects a
+ *	   default scaled to the number of online CPUs.
+ *
+ * The table is installed only while the mm has a single user and the
+ * caller has no other threads.  That guarantees nothing can be queued in
+ * the global table under this mm's keys at the moment we switch, so
+ * hash_futex() needs no locking or reference counting to pick a table.
+ * Runtimes are expected to call this once during early startup; the
+ * table lives until the mm is torn down.
+ */
+long futex_hash_allocate(unsigned long slots)
+{
+	struct mm_struct *mm = current->mm;
+	struct futex_private_hash *fph;
+	size_t size;
+	unsigned long i;
+
+	if (!mm)
+		return -EINVAL;
+	if (slots > FUTEX_PRIVATE_HASH_SLOTS_MAX)
+		return -EINVAL;
+
+	if (!slots)
+		slots = 4 * num_online_cpus();
+	slots = roundup_pow_of_two(slots);
+	if (slots < 2)
+		slots = 2;
+
+	/*
+	 * A waiter queued in the old table would never be found by a waker
+	 * hashing into the new one, so refuse the switch once the mm is
+	 * shared or the caller is multithreaded.
+	 */
+	if (atomic_read(&mm->mm_users) > 1 || !thread_group_empty(current))
+		return -EBUSY;
+	if (mm->futex_phash)
+		return -EBUSY;
+
+	size = sizeof(*fph) + slots * sizeof(fph->queues[0]);
+	if (size <= PAGE_SIZE)
+		fph = kzalloc_node(size, GFP_KERNEL, numa_node_id());
+	else
+		fph = vzalloc_node(size, numa_node_id());
+	if (!fph)
+		return -ENOMEM;
+
+	fph->mask = slots - 1;
+	for (i = 0; i < slots; i++) {
+		atomic_set(&fph->queues[i].waiters, 0);
+		plist_head_init(&fph->queues[i].chain);
+		spin_lock_init(&fph->queues[i].lock);
+	}
+
+	/* Pairs with the acquire load in hash_futex(). */
+	smp_store_release(&mm->futex_phash, fph);
+	return 0;
+}
+
+long futex_hash_get_slots(void)
+{
+	struct futex_private_hash *fph;
+
+	fph = smp_load_acquire(&current->mm->futex_phash);
+	if (fph)
+		return fph->mask + 1;
+	return 0;
+}
+
+/* Called from __mmdrop(); no user of the mm is left by then. */
+void futex_hash_free(struct mm_struct *mm)
+{
+	kvfree(mm->futex_phash);
+}
+
 static void __init futex_detect_cmpxchg(void)
 {
 #ifndef CONFIG_HAVE_FUTEX_CMPXCHG
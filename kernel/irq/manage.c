@@ -12,6 +12,7 @@
 #include <linux/irq.h>
 #include <linux/kthread.h>
 #include <linux/module.h>
+#include <linux/cpu.h>
 #include <linux/random.h>
 #include <linux/interrupt.h>
 #include <linux/slab.h>
@@ -324,6 +325,168 @@ irq_set_affinity_notifier(unsigned int irq, struct irq_affinity_notify *notify)
 }
 EXPORT_SYMBOL_GPL(irq_set_affinity_notifier);
 
+/*
+ * Managed multi-queue interrupt spreading.
+ *
+ * A driver hands the core its vector set once; the core computes a
+ * NUMA-aware spread over the online CPUs, marks the vectors
+ * IRQ_NO_BALANCING so userspace cannot disturb the layout, and
+ * recomputes the spread whenever CPUs come or go.
+ */
+struct irq_affinity_spread {
+	struct list_head	list;
+	unsigned int		nr_irqs;
+	unsigned int		irqs[];
+};
+
+static LIST_HEAD(irq_spread_list);
+static DEFINE_MUTEX(irq_spread_lock);
+
+/*
+ * Compute the affinity mask of vector @idx out of @nvec.  Online CPUs
+ * are walked node by node and divided into @nvec consecutive chunks, so
+ * each vector serves CPUs which are NUMA-adjacent wherever the vector
+ * count allows, much like blk-mq maps queues to CPUs.
+ */
+static void irq_spread_calc_mask(unsigned int idx, unsigned int nvec,
+				 struct cpumask *mask)
+{
+	unsigned int ncpus = num_online_cpus();
+	unsigned int first, last, cpu, node, i = 0;
+
+	cpumask_clear(mask);
+	if (!ncpus)
+		return;
+
+	if (nvec > ncpus) {
+		/* More vectors than CPUs: single CPU each, wrapping. */
+		first = idx % ncpus;
+		last = first + 1;
+	} else {
+		first = idx * ncpus / nvec;
+		last = (idx + 1) * ncpus / nvec;
+	}
+
+	for_each_online_node(node) {
+		for_each_cpu_and(cpu, cpumask_of_node(node), cpu_online_mask) {
+			if (i >= last)
+				return;
+			if (i >= first)
+				cpumask_set_cpu(cpu, mask);
+			i++;
+		}
+	}
+}
+
+static void irq_spread_apply(struct irq_affinity_spread *spread)
+{
+	cpumask_var_t mask;
+	unsigned int i;
+
+	if (!alloc_cpumask_var(&mask, GFP_KERNEL))
+		return;
+
+	for (i = 0; i < spread->nr_irqs; i++) {
+		irq_spread_calc_mask(i, spread->nr_irqs, mask);
+		if (!cpumask_empty(mask))
+			__irq_set_affinity(spread->irqs[i], mask, false);
+	}
+	free_cpumask_var(mask);
+}
+
+/**
+ *	irq_alloc_managed_spread - spread a vector set over the online CPUs
+ *	@irqs:		array of interrupt numbers, one per vector
+ *	@nr_irqs:	number of vectors in @irqs
+ *
+ *	Spreads the vectors NUMA-aware over the online CPUs, marks them
+ *	as unbalanceable and keeps the spread current across CPU hotplug
+ *	until irq_free_managed_spread() is called.  The interrupts must
+ *	stay allocated for the lifetime of the returned descriptor.
+ *
+ *	Returns the spread descriptor or an ERR_PTR() on failure.
+ */
+struct irq_affinity_spread *
+irq_alloc_managed_spread(const unsigned int *irqs, unsigned int nr_irqs)
+{
+	struct irq_affinity_spread *spread;
+	unsigned int i;
+
+	if (!nr_irqs)
+		return ERR_PTR(-EINVAL);
+
+	spread = kzalloc(sizeof(*spread) + nr_irqs * sizeof(*irqs),
+			 GFP_KERNEL);
+	if (!spread)
+		return ERR_PTR(-ENOMEM);
+
+	spread->nr_irqs = nr_irqs;
+	memcpy(spread->irqs, irqs, nr_irqs * sizeof(*irqs));
+
+	for (i = 0; i < nr_irqs; i++)
+		irq_set_status_flags(irqs[i], IRQ_NO_BALANCING);
+
+	mutex_lock(&irq_spread_lock);
+	list_add(&spread->list, &irq_spread_list);
+	irq_spread_apply(spread);
+	mutex_unlock(&irq_spread_lock);
+
+	return spread;
+}
+EXPORT_SYMBOL_GPL(irq_alloc_managed_spread);
+
+/**
+ *	irq_free_managed_spread - stop managing a spread vector set
+ *	@spread:	descriptor returned by irq_alloc_managed_spread()
+ *
+ *	Makes the vectors balanceable again and frees the descriptor.
+ *	Must be called before the interrupts are freed.
+ */
+void irq_free_managed_spread(struct irq_affinity_spread *spread)
+{
+	unsigned int i;
+
+	if (!spread)
+		return;
+
+	mutex_lock(&irq_spread_lock);
+	list_del(&spread->list);
+	mutex_unlock(&irq_spread_lock);
+
+	for (i = 0; i < spread->nr_irqs; i++)
+		irq_clear_status_flags(spread->irqs[i], IRQ_NO_BALANCING);
+	kfree(spread);
+}
+EXPORT_SYMBOL_GPL(irq_free_managed_spread);
+
+static int irq_spread_cpu_notify(struct notifier_block *nb,
+				 unsigned long action, void *hcpu)
+{
+	struct irq_affinity_spread *spread;
+
+	switch (action & ~CPU_TASKS_FROZEN) {
+	case CPU_ONLINE:
+	case CPU_DEAD:
+		mutex_lock(&irq_spread_lock);
+		list_for_each_entry(spread, &irq_spread_list, list)
+			irq_spread_apply(spread);
+		mutex_unlock(&irq_spread_lock);
+		break;
+	}
+	return NOTIFY_OK;
+}
+
+static struct notifier_block irq_spread_cpu_notifier = {
+	.notifier_call	= irq_spread_cpu_notify,
+};
+
+static int __init irq_spread_init(void)
+{
+	register_cpu_notifier(&irq_spread_cpu_notifier);
+	return 0;
+}
+core_initcall(irq_spread_init);
+
 #ifndef CONFIG_AUTO_IRQ_AFFINITY
 /*
  * Generic version of the affinity autoselector.
@@ -0,0 +1,68 @@
+/*
+ * Task isolation for NO_HZ_FULL cpus.
+ *
+ * A task that has its cpus_allowed mask within tick_nohz_full_mask can
+ * opt in to isolation via prctl(PR_SET_TASK_ISOLATION).  Entering
+ * isolation quiesces the sources of deferred per-cpu work that would
+ * otherwise fire on the isolated cpu later, and the task may ask to be
+ * signalled whenever the kernel does interrupt it anyway, so that
+ * residual interruptions can be attributed instead of silently eating
+ * into its latency budget.
+ */
+#include <linux/isolation.h>
+#include <linux/mm.h>
+#include <linux/swap.h>
+#include <linux/vmstat.h>
+#include <linux/tick.h>
+#include <linux/signal.h>
+
+/*
+ * Quiesce the deferred per-cpu work that is liable to interrupt this
+ * cpu once the task stops entering the kernel: drain the local
+ * pagevecs and fold the vmstat differentials so that their deferrable
+ * timers have nothing left to do.
+ */
+static void task_isolation_quiesce(void)
+{
+	lru_add_drain();
+	quiet_vmstat();
+}
+
+int task_isolation_set(unsigned int flags)
+{
+	int sig = PR_TASK_ISOLATION_GET_SIG(flags);
+
+	if (flags & ~(PR_TASK_ISOLATION_ENABLE | PR_TASK_ISOLATION_USERSIG |
+		      PR_TASK_ISOLATION_SET_SIG(0x7f)))
+		return -EINVAL;
+	if (sig && !valid_signal(sig))
+		return -EINVAL;
+
+	if (flags & PR_TASK_ISOLATION_ENABLE) {
+		/*
+		 * Isolation is meaningless unless the task is pinned to
+		 * cpus that can actually stop the tick.
+		 */
+		if (!tick_nohz_full_enabled() ||
+		    !cpumask_subset(tsk_cpus_allowed(current),
+				    tick_nohz_full_mask))
+			return -EINVAL;
+
+		task_isolation_quiesce();
+	}
+
+	current->task_isolation_flags = flags;
+	return 0;
+}
+
+void _task_isolation_interrupt(struct task_struct *task, const char *what)
+{
+	int sig = PR_TASK_ISOLATION_GET_SIG(task->task_isolation_flags);
+
+	pr_warn_ratelimited("%s/%d: task isolation interrupted by %s\n",
+			    task->comm, task->pid, what);
+
+	if (!sig)
+		sig = SIGKILL;
+	send_sig(sig, task, 1);
+}
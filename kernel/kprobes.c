@@ -1478,12 +1478,14 @@ out:
 	return ret;
 }
 
-int register_kprobe(struct kprobe *p)
+/*
+ * Adjust and validate the probe address and take a refcount on the
+ * probed module, if any.  Must be called without kprobe_mutex held.
+ */
+static int check_kprobe_prereg(struct kprobe *p, struct module **probed_mod)
 {
-	int ret;
-	struct kprobe *old_p;
-	struct module *probed_mod;
 	kprobe_opcode_t *addr;
+	int ret;
 
 	/* Adjust probe address from symbol */
 	addr = kprobe_addr(p);
@@ -1500,36 +1502,70 @@ int register_kprobe(struct kprobe *p)
 	p->nmissed = 0;
 	INIT_LIST_HEAD(&p->list);
 
-	ret = check_kprobe_address_safe(p, &probed_mod);
-	if (ret)
-		return ret;
+	return check_kprobe_address_safe(p, probed_mod);
+}
 
-	mutex_lock(&kprobe_mutex);
+/*
+ * Insert a validated probe into the hash table without arming it, so
+ * that callers can arm a whole batch under one text_mutex section.
+ * Must be called with kprobe_mutex held.  A probe which hits an
+ * existing probe at the same address joins its aggrprobe and comes
+ * back live; the caller can tell by get_kprobe(p->addr) != p.
+ */
+static int __register_kprobe(struct kprobe *p)
+{
+	struct kprobe *old_p;
+	int ret;
 
 	old_p = get_kprobe(p->addr);
-	if (old_p) {
+	if (old_p)
 		/* Since this may unoptimize old_p, locking text_mutex. */
-		ret = register_aggr_kprobe(old_p, p);
-		goto out;
-	}
+		return register_aggr_kprobe(old_p, p);
 
 	mutex_lock(&text_mutex);	/* Avoiding text modification */
 	ret = prepare_kprobe(p);
 	mutex_unlock(&text_mutex);
 	if (ret)
-		goto out;
+		return ret;
 
 	INIT_HLIST_NODE(&p->hlist);
 	hlist_add_head_rcu(&p->hlist,
 		       &kprobe_table[hash_ptr(p->addr, KPROBE_HASH_BITS)]);
 
-	if (!kprobes_all_disarmed && !kprobe_disabled(p))
-		arm_kprobe(p);
+	/*
+	 * Ftrace-based probes are armed through the ftrace APIs and do
+	 * not touch text_mutex, so there is nothing to batch for them.
+	 */
+	if (kprobe_ftrace(p) && !kprobes_all_disarmed && !kprobe_disabled(p))
+		arm_kprobe_ftrace(p);
 
-	/* Try to optimize kprobe */
-	try_to_optimize_kprobe(p);
+	return 0;
+}
+
+int register_kprobe(struct kprobe *p)
+{
+	int ret;
+	struct module *probed_mod;
+
+	ret = check_kprobe_prereg(p, &probed_mod);
+	if (ret)
+		return ret;
+
+	mutex_lock(&kprobe_mutex);
+
+	ret = __register_kprobe(p);
+	if (!ret && get_kprobe(p->addr) == p) {
+		if (!kprobes_all_disarmed && !kprobe_disabled(p) &&
+		    !kprobe_ftrace(p)) {
+			mutex_lock(&text_mutex);
+			__arm_kprobe(p);
+			mutex_unlock(&text_mutex);
+		}
+
+		/* Try to optimize kprobe */
+		try_to_optimize_kprobe(p);
+	}
 
-out:
 	mutex_unlock(&kprobe_mutex);
 
 	if (probed_mod)
@@ -1662,20 +1698,81 @@ static void __unregister_kprobe_bottom(struct kprobe *p)
 	/* Otherwise, do nothing. */
 }
 
+/*
+ * Register a batch of kprobes with the expensive work shared across
+ * the whole batch: every address is validated before any text is
+ * touched, all new probes are armed under a single text_mutex section
+ * and the jump optimizer rewrites them in one delayed pass.
+ */
 int register_kprobes(struct kprobe **kps, int num)
 {
-	int i, ret = 0;
+	struct module **probed_mods;
+	struct kprobe *p;
+	int i, n, ret = 0;
 
 	if (num <= 0)
 		return -EINVAL;
+
+	probed_mods = kcalloc(num, sizeof(*probed_mods), GFP_KERNEL);
+	if (!probed_mods)
+		return -ENOMEM;
+
+	/*
+	 * Validate the whole batch up front so that a bad probe in the
+	 * middle does not cost arming and disarming its predecessors.
+	 */
+	for (n = 0; n < num; n++) {
+		ret = check_kprobe_prereg(kps[n], &probed_mods[n]);
+		if (ret)
+			goto put_mods;
+	}
+
+	mutex_lock(&kprobe_mutex);
+
 	for (i = 0; i < num; i++) {
-		ret = register_kprobe(kps[i]);
-		if (ret < 0) {
-			if (i > 0)
-				unregister_kprobes(kps, i);
+		ret = __register_kprobe(kps[i]);
+		if (ret < 0)
 			break;
-		}
 	}
+
+	/*
+	 * Put the breakpoints for all new probes in one critical section
+	 * instead of taking text_mutex once per probe.  Probes which
+	 * joined an existing aggrprobe are already live and are skipped,
+	 * as are ftrace-based ones, which were armed at insertion time.
+	 */
+	mutex_lock(&text_mutex);
+	for (n = 0; n < i; n++) {
+		p = kps[n];
+		if (get_kprobe(p->addr) != p)
+			continue;
+		if (!kprobes_all_disarmed && !kprobe_disabled(p) &&
+		    !kprobe_ftrace(p))
+			__arm_kprobe(p);
+	}
+	mutex_unlock(&text_mutex);
+
+	/*
+	 * This only queues the probes on optimizing_list; the optimizer
+	 * patches the whole batch in a single delayed pass.
+	 */
+	for (n = 0; n < i; n++) {
+		p = kps[n];
+		if (get_kprobe(p->addr) == p)
+			try_to_optimize_kprobe(p);
+	}
+
+	mutex_unlock(&kprobe_mutex);
+
+	if (ret < 0 && i > 0)
+		unregister_kprobes(kps, i);
+
+put_mods:
+	for (n = 0; n < num; n++)
+		if (probed_mods[n])
+			module_put(probed_mods[n]);
+	kfree(probed_mods);
+
 	return ret;
 }
 EXPORT_SYMBOL_GPL(register_kprobes);
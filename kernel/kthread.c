@@ -18,6 +18,7 @@
 #include <linux/freezer.h>
 #include <linux/ptrace.h>
 #include <linux/uaccess.h>
+#include <linux/hash.h>
 #include <trace/events/sched.h>
 
 static DEFINE_SPINLOCK(kthread_create_lock);
@@ -709,3 +710,281 @@ void flush_kthread_worker(struct kthread_worker *worker)
 	wait_for_completion(&fwork.done);
 }
 EXPORT_SYMBOL_GPL(flush_kthread_worker);
+
+/*
+ * Bounded-concurrency worker pool.
+ *
+ * Each pool keeps an independent set of workers per NUMA node.  Workers
+ * are created on demand when work is queued and no idle worker is
+ * available, up to @max_workers per node, and exit again after
+ * KTHREAD_POOL_IDLE_TIMEOUT without work.  Works carrying a
+ * serialization key are hashed both to a node and to a bucket on that
+ * node; a bucket runs at most one work at a time, which serializes all
+ * works sharing a key across the whole pool.  Unkeyed works simply run
+ * on the submitting CPU's node.
+ */
+
+#define KTHREAD_POOL_HASH_BITS		6
+#define KTHREAD_POOL_NR_HASH		(1U << KTHREAD_POOL_HASH_BITS)
+#define KTHREAD_POOL_NO_HASH		UINT_MAX
+#define KTHREAD_POOL_IDLE_TIMEOUT	(5 * HZ)
+
+struct kthread_pool_node {
+	spinlock_t		lock;
+	struct list_head	pending;
+	unsigned long		busy[BITS_TO_LONGS(KTHREAD_POOL_NR_HASH)];
+	unsigned int		nr_workers;
+	unsigned int		nr_idle;
+	wait_queue_head_t	wait;
+	struct kthread_pool	*pool;
+	int			nid;
+};
+
+struct kthread_pool {
+	unsigned int		max_workers;	/* per node */
+	bool			dying;
+	wait_queue_head_t	drain_wait;
+	char			name[TASK_COMM_LEN];
+	struct kthread_pool_node nodes[];
+};
+
+/*
+ * Pick the first pending work whose serialization bucket is free and
+ * claim the bucket.  Called with @pn->lock held.
+ */
+static struct kthread_pool_work *
+kthread_pool_find_work(struct kthread_pool_node *pn)
+{
+	struct kthread_pool_work *work;
+
+	list_for_each_entry(work, &pn->pending, node) {
+		if (work->hash != KTHREAD_POOL_NO_HASH) {
+			if (test_bit(work->hash, pn->busy))
+				continue;
+			__set_bit(work->hash, pn->busy);
+		}
+		list_del_init(&work->node);
+		return work;
+	}
+	return NULL;
+}
+
+static int kthread_pool_worker(void *data)
+{
+	struct kthread_pool_node *pn = data;
+	struct kthread_pool *pool = pn->pool;
+
+	current->flags |= PF_NO_SETAFFINITY;
+	if (cpumask_intersects(cpumask_of_node(pn->nid), cpu_online_mask))
+		set_cpus_allowed_ptr(current, cpumask_of_node(pn->nid));
+
+	spin_lock_irq(&pn->lock);
+	for (;;) {
+		struct kthread_pool_work *work;
+		DEFINE_WAIT(wait);
+		long timeout;
+
+		work = kthread_pool_find_work(pn);
+		if (work) {
+			unsigned int hash = work->hash;
+
+			spin_unlock_irq(&pn->lock);
+			/* @work is owned by @func and may be freed by it */
+			work->func(work);
+			cond_resched();
+			spin_lock_irq(&pn->lock);
+			if (hash != KTHREAD_POOL_NO_HASH) {
+				__clear_bit(hash, pn->busy);
+				/* the bucket may have blocked another work */
+				if (pn->nr_idle && !list_empty(&pn->pending))
+					wake_up(&pn->wait);
+			}
+			continue;
+		}
+
+		if (pool->dying)
+			break;
+
+		prepare_to_wait_exclusive(&pn->wait, &wait,
+					  TASK_INTERRUPTIBLE);
+		pn->nr_idle++;
+		spin_unlock_irq(&pn->lock);
+		timeout = schedule_timeout(KTHREAD_POOL_IDLE_TIMEOUT);
+		finish_wait(&pn->wait, &wait);
+		spin_lock_irq(&pn->lock);
+		pn->nr_idle--;
+		if (!timeout && list_empty(&pn->pending) && !pool->dying)
+			break;		/* idled out, retire */
+	}
+	pn->nr_workers--;
+	if (!pn->nr_workers && pool->dying)
+		wake_up(&pool->drain_wait);
+	spin_unlock_irq(&pn->lock);
+	return 0;
+}
+
+/* Caller has already accounted the new worker in @pn->nr_workers. */
+static void kthread_pool_spawn(struct kthread_pool_node *pn)
+{
+	struct kthread_pool *pool = pn->pool;
+	struct task_struct *task;
+
+	task = kthread_create_on_node(kthread_pool_worker, pn, pn->nid,
+				      "%s/%d", pool->name, pn->nid);
+	if (IS_ERR(task)) {
+		/* back out; the next queue attempt will retry */
+		spin_lock_irq(&pn->lock);
+		pn->nr_workers--;
+		spin_unlock_irq(&pn->lock);
+		return;
+	}
+	wake_up_process(task);
+}
+
+static void __queue_kthread_pool_work(struct kthread_pool *pool,
+				      struct kthread_pool_work *work,
+				      kthread_pool_work_func_t func,
+				      int nid, unsigned int hash)
+{
+	struct kthread_pool_node *pn = &pool->nodes[nid];
+	bool spawn = false;
+
+	work->func = func;
+	work->hash = hash;
+
+	spin_lock_irq(&pn->lock);
+	WARN_ON_ONCE(pool->dying);
+	list_add_tail(&work->node, &pn->pending);
+	if (pn->nr_idle)
+		wake_up(&pn->wait);
+	else if (pn->nr_workers < pool->max_workers) {
+		pn->nr_workers++;
+		spawn = true;
+	}
+	spin_unlock_irq(&pn->lock);
+
+	if (spawn)
+		kthread_pool_spawn(pn);
+}
+
+/**
+ * queue_kthread_pool_work - queue unordered work on a kthread_pool
+ * @pool: pool to queue @work on
+ * @work: work to queue
+ * @func: function to run; owns @work once it starts executing
+ *
+ * The work runs on the submitting CPU's node with no ordering against
+ * other works.  May sleep if a new worker has to be created.
+ */
+void queue_kthread_pool_work(struct kthread_pool *pool,
+			     struct kthread_pool_work *work,
+			     kthread_pool_work_func_t func)
+{
+	__queue_kthread_pool_work(pool, work, func, numa_node_id(),
+				  KTHREAD_POOL_NO_HASH);
+}
+EXPORT_SYMBOL_GPL(queue_kthread_pool_work);
+
+/**
+ * queue_kthread_pool_work_hashed - queue serialized work on a kthread_pool
+ * @pool: pool to queue @work on
+ * @work: work to queue
+ * @func: function to run; owns @work once it starts executing
+ * @key: serialization key
+ *
+ * Works queued with the same @key execute one at a time, in queueing
+ * order.  The key also selects the node the work runs on, so the
+ * guarantee holds pool-wide.  May sleep if a new worker has to be
+ * created.
+ */
+void queue_kthread_pool_work_hashed(struct kthread_pool *pool,
+				    struct kthread_pool_work *work,
+				    kthread_pool_work_func_t func,
+				    const void *key)
+{
+	u32 hash = hash_ptr(key, 2 * KTHREAD_POOL_HASH_BITS);
+
+	__queue_kthread_pool_work(pool, work, func,
+				  (hash >> KTHREAD_POOL_HASH_BITS) %
+					nr_node_ids,
+				  hash & (KTHREAD_POOL_NR_HASH - 1));
+}
+EXPORT_SYMBOL_GPL(queue_kthread_pool_work_hashed);
+
+/**
+ * kthread_pool_create - create a bounded worker pool
+ * @name: base name for worker threads ("%s/%d", @name, node)
+ * @max_workers: maximum concurrent workers per NUMA node
+ *
+ * Returns the new pool or NULL on allocation failure.  No workers are
+ * created until work is queued.
+ */
+struct kthread_pool *kthread_pool_create(const char *name,
+					 unsigned int max_workers)
+{
+	struct kthread_pool *pool;
+	int nid;
+
+	pool = kzalloc(sizeof(*pool) +
+		       nr_node_ids * sizeof(struct kthread_pool_node),
+		       GFP_KERNEL);
+	if (!pool)
+		return NULL;
+
+	pool->max_workers = max_workers ?: 1;
+	init_waitqueue_head(&pool->drain_wait);
+	strlcpy(pool->name, name, sizeof(pool->name));
+	for (nid = 0; nid < nr_node_ids; nid++) {
+		struct kthread_pool_node *pn = &pool->nodes[nid];
+
+		spin_lock_init(&pn->lock);
+		INIT_LIST_HEAD(&pn->pending);
+		init_waitqueue_head(&pn->wait);
+		pn->pool = pool;
+		pn->nid = nid;
+	}
+	return pool;
+}
+EXPORT_SYMBOL_GPL(kthread_pool_create);
+
+static bool kthread_pool_drained(struct kthread_pool *pool)
+{
+	int nid;
+
+	for (nid = 0; nid < nr_node_ids; nid++) {
+		struct kthread_pool_node *pn = &pool->nodes[nid];
+		bool busy;
+
+		spin_lock_irq(&pn->lock);
+		busy = pn->nr_workers || !list_empty(&pn->pending);
+		spin_unlock_irq(&pn->lock);
+		if (busy)
+			return false;
+	}
+	return true;
+}
+
+/**
+ * kthread_pool_destroy - drain and free a kthread_pool
+ * @pool: pool to destroy
+ *
+ * Waits for all pending and executing works to finish and for all
+ * workers to exit.  The caller must not queue further work.
+ */
+void kthread_pool_destroy(struct kthread_pool *pool)
+{
+	int nid;
+
+	pool->dying = true;
+	for (nid = 0; nid < nr_node_ids; nid++) {
+		struct kthread_pool_node *pn = &pool->nodes[nid];
+
+		/* order against workers checking ->dying under the lock */
+		spin_lock_irq(&pn->lock);
+		wake_up_all(&pn->wait);
+		spin_unlock_irq(&pn->lock);
+	}
+	wait_event(pool->drain_wait, kthread_pool_drained(pool));
+	kfree(pool);
+}
+EXPORT_SYMBOL_GPL(kthread_pool_destroy);
@@ -50,7 +50,7 @@
 
 #include "lockdep_internals.h"
 
-#define CREATE_TRACE_POINTS
+/* The lock events themselves are created in mutex.c */
 #include <trace/events/lock.h>
 
 #ifdef CONFIG_PROVE_LOCKING
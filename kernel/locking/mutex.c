@@ -27,6 +27,9 @@
 #include <linux/debug_locks.h>
 #include <linux/osq_lock.h>
 
+#define CREATE_TRACE_POINTS
+#include <trace/events/lock.h>
+
 /*
  * In the DEBUG case we are using the "NULL fastpath" for mutexes,
  * which forces all calls into the slowpath:
@@ -512,6 +515,7 @@ __mutex_lock_common(struct mutex *lock, long state, unsigned int subclass,
 	struct task_struct *task = current;
 	struct mutex_waiter waiter;
 	unsigned long flags;
+	u64 contention_start = 0;
 	int ret;
 
 	preempt_disable();
@@ -541,6 +545,8 @@ __mutex_lock_common(struct mutex *lock, long state, unsigned int subclass,
 	waiter.task = task;
 
 	lock_contended(&lock->dep_map, ip);
+	if (trace_lock_contention_enabled())
+		contention_start = local_clock();
 
 	for (;;) {
 		/*
@@ -590,6 +596,10 @@ __mutex_lock_common(struct mutex *lock, long state, unsigned int subclass,
 skip_wait:
 	/* got the lock - cleanup and rejoice! */
 	lock_acquired(&lock->dep_map, ip);
+	if (contention_start)
+		trace_lock_contention(lock, ip,
+				      local_clock() - contention_start,
+				      LCB_F_MUTEX);
 	mutex_set_owner(lock);
 
 	if (use_ww_ctx) {
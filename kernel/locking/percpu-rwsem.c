@@ -156,3 +156,35 @@ void percpu_up_write(struct percpu_rw_semaphore *brw)
 	rcu_sync_exit(&brw->rss);
 }
 EXPORT_SYMBOL_GPL(percpu_up_write);
+
+/**
+ * percpu_rwsem_batch_begin - amortize grace periods over many write sections
+ * @brw: the percpu rw_semaphore
+ *
+ * Forces the readers onto the slow path and keeps them there until the
+ * matching percpu_rwsem_batch_end(), paying for a single grace period
+ * up front.  Every percpu_down_write() in between then only has to take
+ * ->rw_sem and wait out the active readers; the grace-period waits which
+ * normally dominate back-to-back write sections are elided.
+ *
+ * Does not exclude readers or writers by itself - it is merely a hold
+ * on the rcu_sync state machine.  Nestable; may block.
+ */
+void percpu_rwsem_batch_begin(struct percpu_rw_semaphore *brw)
+{
+	rcu_sync_enter(&brw->rss);
+}
+EXPORT_SYMBOL_GPL(percpu_rwsem_batch_begin);
+
+/**
+ * percpu_rwsem_batch_end - end a percpu_rwsem_batch_begin() section
+ * @brw: the percpu rw_semaphore
+ *
+ * Lets the readers back onto their fast path after a grace period has
+ * elapsed, unless other batch sections or writers are still in flight.
+ */
+void percpu_rwsem_batch_end(struct percpu_rw_semaphore *brw)
+{
+	rcu_sync_exit(&brw->rss);
+}
+EXPORT_SYMBOL_GPL(percpu_rwsem_batch_end);
@@ -28,6 +28,9 @@
 #include <linux/percpu.h>
 #include <linux/hardirq.h>
 #include <linux/mutex.h>
+#include <linux/sched.h>
+
+#include <trace/events/lock.h>
 #include <asm/byteorder.h>
 #include <asm/qspinlock.h>
 
@@ -294,6 +297,7 @@ void queued_spin_lock_slowpath(struct qspinlock *lock, u32 val)
 {
 	struct mcs_spinlock *prev, *next, *node;
 	u32 new, old, tail;
+	u64 contention_start = 0;
 	int idx;
 
 	BUILD_BUG_ON(CONFIG_NR_CPUS >= (1U << _Q_TAIL_CPU_BITS));
@@ -373,6 +377,9 @@ void queued_spin_lock_slowpath(struct qspinlock *lock, u32 val)
 	 * queuing.
 	 */
 queue:
+	if (trace_lock_contention_enabled())
+		contention_start = local_clock();
+
 	node = this_cpu_ptr(&mcs_nodes[0]);
 	idx = node->count++;
 	tail = encode_tail(smp_processor_id(), idx);
@@ -492,6 +499,11 @@ release:
 	 * release the node
 	 */
 	this_cpu_dec(mcs_nodes[0].count);
+
+	if (contention_start)
+		trace_lock_contention(lock, _RET_IP_,
+				      local_clock() - contention_start,
+				      LCB_F_SPIN);
 }
 EXPORT_SYMBOL(queued_spin_lock_slowpath);
 
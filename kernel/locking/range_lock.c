@@ -0,0 +1,79 @@
+/*
+ * Range locking
+ *
+ * Waiting lockers are tracked in an interval tree keyed on the locked
+ * span.  When locking, a task counts the already inserted ranges that
+ * overlap its own; it may proceed once all of them have unlocked.
+ * Because every locker counts only ranges inserted before it, waiters
+ * for the same span are granted the lock in FIFO order and cannot
+ * starve each other.
+ *
+ * The cost of lock and unlock is O(log n + m) where n is the total
+ * number of ranges in the tree and m the number of overlapping ranges.
+ */
+#include <linux/range_lock.h>
+#include <linux/interval_tree_generic.h>
+#include <linux/sched.h>
+#include <linux/export.h>
+
+#define START(node) ((node)->start)
+#define LAST(node)  ((node)->last)
+
+INTERVAL_TREE_DEFINE(struct range_lock, node, unsigned long, __subtree_last,
+		     START, LAST, static inline, range_it)
+
+/**
+ * range_lock - lock a range of a range tree
+ * @tree: range tree to lock in
+ * @lock: initialized (see range_lock_init()) range to lock
+ *
+ * Sleeps until every earlier locker of an overlapping range has
+ * released it.  May not be called from interrupt context.
+ */
+void range_lock(struct range_lock_tree *tree, struct range_lock *lock)
+{
+	struct range_lock *blocker;
+
+	spin_lock(&tree->lock);
+	lock->task = current;
+	lock->blocking_ranges = 0;
+	for (blocker = range_it_iter_first(&tree->root, lock->start, lock->last);
+	     blocker;
+	     blocker = range_it_iter_next(blocker, lock->start, lock->last))
+		lock->blocking_ranges++;
+	range_it_insert(lock, &tree->root);
+	spin_unlock(&tree->lock);
+
+	while (true) {
+		set_current_state(TASK_UNINTERRUPTIBLE);
+		/* ->blocking_ranges is decremented under tree->lock */
+		if (!READ_ONCE(lock->blocking_ranges))
+			break;
+		schedule();
+	}
+	__set_current_state(TASK_RUNNING);
+}
+EXPORT_SYMBOL_GPL(range_lock);
+
+/**
+ * range_unlock - unlock a range of a range tree
+ * @tree: range tree to unlock in
+ * @lock: range to unlock
+ *
+ * Wakes any locker that was waiting solely on this range.
+ */
+void range_unlock(struct range_lock_tree *tree, struct range_lock *lock)
+{
+	struct range_lock *waiter;
+
+	spin_lock(&tree->lock);
+	range_it_remove(lock, &tree->root);
+	for (waiter = range_it_iter_first(&tree->root, lock->start, lock->last);
+	     waiter;
+	     waiter = range_it_iter_next(waiter, lock->start, lock->last)) {
+		if (!--waiter->blocking_ranges)
+			wake_up_process(waiter->task);
+	}
+	spin_unlock(&tree->lock);
+}
+EXPORT_SYMBOL_GPL(range_unlock);
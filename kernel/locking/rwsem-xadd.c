@@ -18,6 +18,8 @@
 
 #include "rwsem.h"
 
+#include <trace/events/lock.h>
+
 /*
  * Guide to the rw_semaphore's count field for common values.
  * (32-bit case illustrated, similar for 64-bit)
@@ -100,14 +102,46 @@ struct rwsem_waiter {
 	struct list_head list;
 	struct task_struct *task;
 	enum rwsem_waiter_type type;
+	/* writers only: wakeups lost to lock stealers, and direct grant */
+	unsigned int wakeups;
+	bool granted;
 };
 
+/*
+ * Number of fruitless wakeups a queued writer may suffer before the
+ * waker stops letting optimistic spinners steal the lock and hands it
+ * over directly.  Stealing is usually a throughput win, but under a
+ * steady stream of spinners the writer at the head of the queue can
+ * otherwise lose every race indefinitely.
+ */
+#define RWSEM_WRITER_WAKE_HANDOFF	2
+
 enum rwsem_wake_type {
 	RWSEM_WAKE_ANY,		/* Wake whatever's at head of wait list */
 	RWSEM_WAKE_READERS,	/* Wake readers only */
 	RWSEM_WAKE_READ_OWNED	/* Waker thread holds the read lock */
 };
 
+/*
+ * Hand the lock over to the writer at the head of the queue on its
+ * behalf.  Called with the wait_lock held, so @waiter cannot go away
+ * under us and ->granted is stable for anybody else holding the lock.
+ */
+static bool rwsem_try_write_lock_handoff(struct rw_semaphore *sem,
+					 struct rwsem_waiter *waiter)
+{
+	if (cmpxchg_acquire(&sem->count, RWSEM_WAITING_BIAS,
+			    RWSEM_ACTIVE_WRITE_BIAS) != RWSEM_WAITING_BIAS)
+		return false;
+
+	if (!list_is_singular(&sem->wait_list))
+		rwsem_atomic_update(RWSEM_WAITING_BIAS, sem);
+
+	rwsem_set_owner_task(sem, waiter->task);
+	WRITE_ONCE(waiter->granted, true);
+	return true;
+}
+
 /*
  * handle the lock release when processes blocked on it that can now run
  * - if we come here from up_xxxx(), then:
@@ -128,13 +162,19 @@ __rwsem_do_wake(struct rw_semaphore *sem, enum rwsem_wake_type wake_type)
 
 	waiter = list_entry(sem->wait_list.next, struct rwsem_waiter, list);
 	if (waiter->type == RWSEM_WAITING_FOR_WRITE) {
-		if (wake_type == RWSEM_WAKE_ANY)
+		if (wake_type == RWSEM_WAKE_ANY) {
 			/* Wake writer at the front of the queue, but do not
 			 * grant it the lock yet as we want other writers
 			 * to be able to steal it.  Readers, on the other hand,
 			 * will block as they will notice the queued writer.
+			 * Once the writer has lost enough wakeups to lock
+			 * stealers, though, hand the lock straight over so
+			 * it cannot be starved forever.
 			 */
+			if (waiter->wakeups++ >= RWSEM_WRITER_WAKE_HANDOFF)
+				rwsem_try_write_lock_handoff(sem, waiter);
 			wake_up_process(waiter->task);
+		}
 		goto out;
 	}
 
@@ -207,54 +247,6 @@ __rwsem_do_wake(struct rw_semaphore *sem, enum rwsem_wake_type wake_type)
 	return sem;
 }
 
-/*
- * Wait for the read lock to be granted
- */
-__visible
-struct rw_semaphore __sched *rwsem_down_read_failed(struct rw_semaphore *sem)
-{
-	long count, adjustment = -RWSEM_ACTIVE_READ_BIAS;
-	struct rwsem_waiter waiter;
-	struct task_struct *tsk = current;
-
-	/* set up my own style of waitqueue */
-	waiter.task = tsk;
-	waiter.type = RWSEM_WAITING_FOR_READ;
-	get_task_struct(tsk);
-
-	raw_spin_lock_irq(&sem->wait_lock);
-	if (list_empty(&sem->wait_list))
-		adjustment += RWSEM_WAITING_BIAS;
-	list_add_tail(&waiter.list, &sem->wait_list);
-
-	/* we're now waiting on the lock, but no longer actively locking */
-	count = rwsem_atomic_update(adjustment, sem);
-
-	/* If there are no active locks, wake the front queued process(es).
-	 *
-	 * If there are no writers and we are first in the queue,
-	 * wake our own waiter to join the existing active readers !
-	 */
-	if (count == RWSEM_WAITING_BIAS ||
-	    (count > RWSEM_WAITING_BIAS &&
-	     adjustment != -RWSEM_ACTIVE_READ_BIAS))
-		sem = __rwsem_do_wake(sem, RWSEM_WAKE_ANY);
-
-	raw_spin_unlock_irq(&sem->wait_lock);
-
-	/* wait to be given the lock */
-	while (true) {
-		set_task_state(tsk, TASK_UNINTERRUPTIBLE);
-		if (!waiter.task)
-			break;
-		schedule();
-	}
-
-	__set_task_state(tsk, TASK_RUNNING);
-	return sem;
-}
-EXPORT_SYMBOL(rwsem_down_read_failed);
-
 static inline bool rwsem_try_write_lock(long count, struct rw_semaphore *sem)
 {
 	/*
@@ -410,6 +402,65 @@ done:
 	return taken;
 }
 
+/*
+ * Spin for the read lock while a writer owns the sem and is running.
+ *
+ * We get here from the down_read() fastpath, so our ACTIVE_READ_BIAS is
+ * still in the count.  That means we do not have to acquire anything:
+ * the moment the writer drops the lock with nobody queued, the count
+ * turns positive and the read lock is already ours.  Because of the
+ * bias, all readers spinning here are granted the lock together by a
+ * single writer release.
+ */
+static bool rwsem_reader_optimistic_spin(struct rw_semaphore *sem)
+{
+	struct task_struct *owner;
+	bool taken = false;
+
+	preempt_disable();
+
+	if (READ_ONCE(sem->count) > 0) {
+		taken = true;
+		goto done;
+	}
+
+	if (!rwsem_can_spin_on_owner(sem))
+		goto done;
+
+	if (!osq_lock(&sem->osq))
+		goto done;
+
+	while (true) {
+		if (READ_ONCE(sem->count) > 0) {
+			taken = true;
+			break;
+		}
+
+		owner = READ_ONCE(sem->owner);
+		if (!owner) {
+			/*
+			 * Reader owned, or free with waiters queued ahead
+			 * of us; spinning cannot make the count positive,
+			 * so take our place in the wait list instead.
+			 */
+			break;
+		}
+
+		if (!rwsem_spin_on_owner(sem, owner)) {
+			/*
+			 * The writer may have released right before going
+			 * off CPU, in which case the lock fell to our bias.
+			 */
+			taken = READ_ONCE(sem->count) > 0;
+			break;
+		}
+	}
+	osq_unlock(&sem->osq);
+done:
+	preempt_enable();
+	return taken;
+}
+
 /*
  * Return true if the rwsem has active spinner
  */
@@ -424,6 +475,11 @@ static bool rwsem_optimistic_spin(struct rw_semaphore *sem)
 	return false;
 }
 
+static bool rwsem_reader_optimistic_spin(struct rw_semaphore *sem)
+{
+	return false;
+}
+
 static inline bool rwsem_has_spinner(struct rw_semaphore *sem)
 {
 	return false;
@@ -431,21 +487,91 @@ static inline bool rwsem_has_spinner(struct rw_semaphore *sem)
 #endif
 
 /*
- * Wait until we successfully acquire the write lock
+ * Wait for the read lock to be granted
  */
 __visible
-struct rw_semaphore __sched *rwsem_down_write_failed(struct rw_semaphore *sem)
+struct rw_semaphore __sched *rwsem_down_read_failed(struct rw_semaphore *sem)
+{
+	long count, adjustment = -RWSEM_ACTIVE_READ_BIAS;
+	struct rwsem_waiter waiter;
+	struct task_struct *tsk = current;
+	u64 contention_start = 0;
+
+	if (trace_lock_contention_enabled())
+		contention_start = local_clock();
+
+	/*
+	 * A writer critical section is typically much shorter than a
+	 * schedule round trip, so spin while one is on CPU before paying
+	 * for a sleep/wakeup cycle.
+	 */
+	if (rwsem_reader_optimistic_spin(sem))
+		goto out;
+
+	/* set up my own style of waitqueue */
+	waiter.task = tsk;
+	waiter.type = RWSEM_WAITING_FOR_READ;
+	get_task_struct(tsk);
+
+	raw_spin_lock_irq(&sem->wait_lock);
+	if (list_empty(&sem->wait_list))
+		adjustment += RWSEM_WAITING_BIAS;
+	list_add_tail(&waiter.list, &sem->wait_list);
+
+	/* we're now waiting on the lock, but no longer actively locking */
+	count = rwsem_atomic_update(adjustment, sem);
+
+	/* If there are no active locks, wake the front queued process(es).
+	 *
+	 * If there are no writers and we are first in the queue,
+	 * wake our own waiter to join the existing active readers !
+	 */
+	if (count == RWSEM_WAITING_BIAS ||
+	    (count > RWSEM_WAITING_BIAS &&
+	     adjustment != -RWSEM_ACTIVE_READ_BIAS))
+		sem = __rwsem_do_wake(sem, RWSEM_WAKE_ANY);
+
+	raw_spin_unlock_irq(&sem->wait_lock);
+
+	/* wait to be given the lock */
+	while (true) {
+		set_task_state(tsk, TASK_UNINTERRUPTIBLE);
+		if (!waiter.task)
+			break;
+		schedule();
+	}
+
+	__set_task_state(tsk, TASK_RUNNING);
+out:
+	if (contention_start)
+		trace_lock_contention(sem, _RET_IP_,
+				      local_clock() - contention_start,
+				      LCB_F_READ);
+	return sem;
+}
+EXPORT_SYMBOL(rwsem_down_read_failed);
+
+/*
+ * Wait until we successfully acquire the write lock
+ */
+static inline struct rw_semaphore *
+__rwsem_down_write_failed_common(struct rw_semaphore *sem, int state)
 {
 	long count;
 	bool waiting = true; /* any queued threads before us */
 	struct rwsem_waiter waiter;
+	struct rw_semaphore *ret = sem;
+	u64 contention_start = 0;
+
+	if (trace_lock_contention_enabled())
+		contention_start = local_clock();
 
 	/* undo write bias from down_write operation, stop active locking */
 	count = rwsem_atomic_update(-RWSEM_ACTIVE_WRITE_BIAS, sem);
 
 	/* do optimistic spinning and steal lock if possible */
 	if (rwsem_optimistic_spin(sem))
-		return sem;
+		goto out;
 
 	/*
 	 * Optimistic spinning failed, proceed to the slowpath
@@ -453,6 +579,8 @@ struct rw_semaphore __sched *rwsem_down_write_failed(struct rw_semaphore *sem)
 	 */
 	waiter.task = current;
 	waiter.type = RWSEM_WAITING_FOR_WRITE;
+	waiter.wakeups = 0;
+	waiter.granted = false;
 
 	raw_spin_lock_irq(&sem->wait_lock);
 
@@ -478,16 +606,23 @@ struct rw_semaphore __sched *rwsem_down_write_failed(struct rw_semaphore *sem)
 		count = rwsem_atomic_update(RWSEM_WAITING_BIAS, sem);
 
 	/* wait until we successfully acquire the lock */
-	set_current_state(TASK_UNINTERRUPTIBLE);
+	set_current_state(state);
 	while (true) {
-		if (rwsem_try_write_lock(count, sem))
+		if (waiter.granted || rwsem_try_write_lock(count, sem))
 			break;
 		raw_spin_unlock_irq(&sem->wait_lock);
 
 		/* Block until there are no active lockers. */
 		do {
+			/* the waker may have handed us the lock directly */
+			if (READ_ONCE(waiter.granted))
+				break;
+
+			if (signal_pending_state(state, current))
+				goto out_nolock;
+
 			schedule();
-			set_current_state(TASK_UNINTERRUPTIBLE);
+			set_current_state(state);
 		} while ((count = sem->count) & RWSEM_ACTIVE_MASK);
 
 		raw_spin_lock_irq(&sem->wait_lock);
@@ -497,10 +632,50 @@ struct rw_semaphore __sched *rwsem_down_write_failed(struct rw_semaphore *sem)
 	list_del(&waiter.list);
 	raw_spin_unlock_irq(&sem->wait_lock);
 
-	return sem;
+out:
+	if (contention_start)
+		trace_lock_contention(sem, _RET_IP_,
+				      local_clock() - contention_start,
+				      LCB_F_WRITE);
+	return ret;
+
+out_nolock:
+	__set_current_state(TASK_RUNNING);
+	raw_spin_lock_irq(&sem->wait_lock);
+	/*
+	 * A handoff may have raced with the signal; ->granted is stable
+	 * under the wait_lock, and if it is set we own the lock and must
+	 * report success.  The signal stays pending.
+	 */
+	if (waiter.granted) {
+		list_del(&waiter.list);
+		raw_spin_unlock_irq(&sem->wait_lock);
+		goto out;
+	}
+	list_del(&waiter.list);
+	if (list_empty(&sem->wait_list))
+		rwsem_atomic_update(-RWSEM_WAITING_BIAS, sem);
+	else
+		__rwsem_do_wake(sem, RWSEM_WAKE_ANY);
+	raw_spin_unlock_irq(&sem->wait_lock);
+
+	return ERR_PTR(-EINTR);
+}
+
+__visible struct rw_semaphore * __sched
+rwsem_down_write_failed(struct rw_semaphore *sem)
+{
+	return __rwsem_down_write_failed_common(sem, TASK_UNINTERRUPTIBLE);
 }
 EXPORT_SYMBOL(rwsem_down_write_failed);
 
+__visible struct rw_semaphore * __sched
+rwsem_down_write_failed_killable(struct rw_semaphore *sem)
+{
+	return __rwsem_down_write_failed_common(sem, TASK_KILLABLE);
+}
+EXPORT_SYMBOL(rwsem_down_write_failed_killable);
+
 /*
  * handle waking up a waiter on the semaphore
  * - up_read/up_write has decremented the active part of count if we come here
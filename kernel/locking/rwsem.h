@@ -9,6 +9,13 @@ static inline void rwsem_clear_owner(struct rw_semaphore *sem)
 	sem->owner = NULL;
 }
 
+/* For handing the lock over to a waiter from the waking context. */
+static inline void rwsem_set_owner_task(struct rw_semaphore *sem,
+					struct task_struct *task)
+{
+	sem->owner = task;
+}
+
 #else
 static inline void rwsem_set_owner(struct rw_semaphore *sem)
 {
@@ -17,4 +24,9 @@ static inline void rwsem_set_owner(struct rw_semaphore *sem)
 static inline void rwsem_clear_owner(struct rw_semaphore *sem)
 {
 }
+
+static inline void rwsem_set_owner_task(struct rw_semaphore *sem,
+					struct task_struct *task)
+{
+}
 #endif
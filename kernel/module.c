@@ -1374,34 +1374,49 @@ static const struct kernel_symbol *resolve_symbol(struct module *mod,
 	int err;
 
 	/*
-	 * The module_mutex should not be a heavily contended lock;
-	 * if we get the occasional sleep here, we'll go an extra iteration
-	 * in the wait_event_interruptible(), which is harmless.
+	 * The symbol search and the version check only read the modules
+	 * list and the owner's symbol tables, all of which are RCU
+	 * protected. Doing this part under module_mutex serialized
+	 * concurrent modprobes per symbol; with ~180 modules at boot that
+	 * adds up, so search locklessly and pin the owner with a temporary
+	 * reference before leaving the RCU section.
 	 */
-	sched_annotate_sleep();
-	mutex_lock(&module_mutex);
+	preempt_disable();
 	sym = find_symbol(name, &owner, &crc,
 			  !(mod->taints & (1 << TAINT_PROPRIETARY_MODULE)), true);
-	if (!sym)
-		goto unlock;
+	if (!sym) {
+		preempt_enable();
+		return NULL;
+	}
 
 	if (!check_version(info->sechdrs, info->index.vers, name, mod, crc,
 			   owner)) {
-		sym = ERR_PTR(-EINVAL);
-		goto getname;
+		preempt_enable();
+		return ERR_PTR(-EINVAL);
 	}
 
-	err = ref_module(mod, owner);
-	if (err) {
-		sym = ERR_PTR(err);
-		goto getname;
+	strncpy(ownername, module_name(owner), MODULE_NAME_LEN);
+	err = strong_try_module_get(owner);
+	preempt_enable();
+	if (err)
+		return ERR_PTR(err);
+
+	/*
+	 * Symbols exported by vmlinux need no usage tracking; everything
+	 * else still takes module_mutex for the use-list insertion, but
+	 * that window is short and the occasional sleep is expected by
+	 * the wait_event_interruptible() in resolve_symbol_wait().
+	 */
+	if (owner) {
+		sched_annotate_sleep();
+		mutex_lock(&module_mutex);
+		err = ref_module(mod, owner);
+		mutex_unlock(&module_mutex);
+		module_put(owner);
+		if (err)
+			return ERR_PTR(err);
 	}
 
-getname:
-	/* We must make copy under the lock if we failed to get ref. */
-	strncpy(ownername, module_name(owner), MODULE_NAME_LEN);
-unlock:
-	mutex_unlock(&module_mutex);
 	return sym;
 }
 
@@ -39,6 +39,7 @@
 #include <linux/kmsg_dump.h>
 #include <linux/syslog.h>
 #include <linux/cpu.h>
+#include <linux/kthread.h>
 #include <linux/notifier.h>
 #include <linux/rculist.h>
 #include <linux/poll.h>
@@ -1606,6 +1607,66 @@ static size_t cont_print_text(char *text, size_t size)
 	return textlen;
 }
 
+/*
+ * Flushing the log buffer to slow consoles (a 115200 baud serial line
+ * manages about 11 characters per millisecond) used to happen
+ * synchronously from whatever context called printk(), which can stall
+ * interrupt and softirq processing for seconds during a message storm.
+ * Offload console writing to a dedicated kthread instead; printk()
+ * itself only stores the message and wakes the thread.
+ *
+ * Synchronous flushing is kept for an oops in progress (the thread may
+ * never run again), for early boot before the thread exists, and when
+ * explicitly requested with printk.synchronous=1 for debugging.
+ * NMI context already stores into the lockless per-CPU buffers in
+ * nmi.c and never flushes consoles directly. A panic still flushes
+ * everything via console_flush_on_panic().
+ */
+static bool printk_sync;
+module_param_named(synchronous, printk_sync, bool, S_IRUGO);
+MODULE_PARM_DESC(synchronous, "make printk() flush consoles synchronously");
+
+static struct task_struct *printk_kthread;
+static bool printk_kthread_need_flush;
+
+static int printk_kthread_func(void *data)
+{
+	while (1) {
+		set_current_state(TASK_INTERRUPTIBLE);
+		if (!READ_ONCE(printk_kthread_need_flush))
+			schedule();
+		__set_current_state(TASK_RUNNING);
+		/*
+		 * Clear before flushing: messages stored after this point
+		 * will wake us again once we are back in the loop.
+		 */
+		WRITE_ONCE(printk_kthread_need_flush, false);
+		console_lock();
+		console_unlock();
+	}
+
+	return 0;
+}
+
+static int __init init_printk_kthread(void)
+{
+	struct task_struct *thread;
+
+	if (printk_sync)
+		return 0;
+
+	thread = kthread_run(printk_kthread_func, NULL, "printk");
+	if (IS_ERR(thread)) {
+		pr_err("printk: unable to create printing thread\n");
+		return PTR_ERR(thread);
+	}
+
+	/* order against the reader in vprintk_emit() */
+	smp_store_release(&printk_kthread, thread);
+	return 0;
+}
+late_initcall(init_printk_kthread);
+
 asmlinkage int vprintk_emit(int facility, int level,
 			    const char *dict, size_t dictlen,
 			    const char *fmt, va_list args)
@@ -1767,15 +1828,26 @@ asmlinkage int vprintk_emit(int facility, int level,
 
 	/* If called from the scheduler, we can not call up(). */
 	if (!in_sched) {
-		lockdep_off();
-		/*
-		 * Try to acquire and then immediately release the console
-		 * semaphore.  The release will print out buffers and wake up
-		 * /dev/kmsg and syslog() users.
-		 */
-		if (console_trylock())
-			console_unlock();
-		lockdep_on();
+		struct task_struct *thread = smp_load_acquire(&printk_kthread);
+
+		if (thread && !oops_in_progress) {
+			/*
+			 * Hand console writing off so this context never
+			 * waits on slow console hardware.
+			 */
+			WRITE_ONCE(printk_kthread_need_flush, true);
+			wake_up_process(thread);
+		} else {
+			lockdep_off();
+			/*
+			 * Try to acquire and then immediately release the
+			 * console semaphore.  The release will print out
+			 * buffers and wake up /dev/kmsg and syslog() users.
+			 */
+			if (console_trylock())
+				console_unlock();
+			lockdep_on();
+		}
 	}
 
 	return printed_len;
@@ -2498,6 +2498,88 @@ static bool init_nocb_callback_list(struct rcu_data *rdp)
 	return true;
 }
 
+/* Serializes runtime additions to rcu_nocb_mask. */
+static DEFINE_MUTEX(rcu_nocb_offload_mutex);
+
+/*
+ * Mark the specified CPU as a no-CBs CPU at runtime.  The CPU must be
+ * offline: an online CPU's callback list cannot be switched over without
+ * racing against callback execution, but an offline CPU is guaranteed to
+ * have an empty list, so the actual switch and the rcuo kthread spawning
+ * can simply be left to the next CPU_UP_PREPARE notification.  To offload
+ * a running CPU, take it down, write its number here, and bring it back.
+ *
+ * There is intentionally no de-offload operation; that would require
+ * draining the no-CBs queues and unwinding the leader-follower links.
+ */
+static int rcu_nocb_cpu_offload(int cpu)
+{
+	struct rcu_state *rsp;
+	int ret = 0;
+
+	if (cpu < 0 || cpu >= nr_cpu_ids || !cpu_possible(cpu))
+		return -EINVAL;
+
+	get_online_cpus();
+	mutex_lock(&rcu_nocb_offload_mutex);
+	if (cpu_online(cpu)) {
+		ret = -EBUSY;
+		goto unlock;
+	}
+	if (rcu_is_nocb_cpu(cpu))
+		goto unlock;
+	if (!have_rcu_nocb_mask) {
+		if (!zalloc_cpumask_var(&rcu_nocb_mask, GFP_KERNEL)) {
+			ret = -ENOMEM;
+			goto unlock;
+		}
+		/* Readers dereference the mask only if they see the flag. */
+		smp_wmb();
+		have_rcu_nocb_mask = true;
+	}
+
+	/*
+	 * Boot-time leader-follower organization did not cover this CPU,
+	 * so let it lead itself rather than growing an existing group.
+	 */
+	for_each_rcu_flavor(rsp) {
+		struct rcu_data *rdp = per_cpu_ptr(rsp->rda, cpu);
+
+		if (!rdp->nocb_leader)
+			rdp->nocb_leader = rdp;
+	}
+	cpumask_set_cpu(cpu, rcu_nocb_mask);
+unlock:
+	mutex_unlock(&rcu_nocb_offload_mutex);
+	put_online_cpus();
+	return ret;
+}
+
+static int param_set_nocb_offload(const char *val, const struct kernel_param *kp)
+{
+	int cpu;
+	int ret;
+
+	ret = kstrtoint(val, 0, &cpu);
+	if (ret)
+		return ret;
+	return rcu_nocb_cpu_offload(cpu);
+}
+
+static int param_get_nocb_offload(char *buffer, const struct kernel_param *kp)
+{
+	if (!have_rcu_nocb_mask)
+		return scnprintf(buffer, PAGE_SIZE, "\n");
+	return scnprintf(buffer, PAGE_SIZE, "%*pbl\n",
+			 cpumask_pr_args(rcu_nocb_mask));
+}
+
+static const struct kernel_param_ops rcu_nocb_offload_ops = {
+	.set = param_set_nocb_offload,
+	.get = param_get_nocb_offload,
+};
+module_param_cb(rcu_nocb_offload, &rcu_nocb_offload_ops, NULL, 0644);
+
 #else /* #ifdef CONFIG_RCU_NOCB_CPU */
 
 static bool rcu_nocb_cpu_needs_barrier(struct rcu_state *rsp, int cpu)
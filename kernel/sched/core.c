@@ -2102,6 +2102,7 @@ static void __sched_fork(unsigned long clone_flags, struct task_struct *p)
 	p->node_stamp = 0ULL;
 	p->numa_scan_seq = p->mm ? p->mm->numa_scan_seq : 0;
 	p->numa_scan_period = sysctl_numa_balancing_scan_delay;
+	p->numa_scan_settled = 0;
 	p->numa_work.next = &p->numa_work;
 	p->numa_faults = NULL;
 	p->last_task_numa_placement = 0;
@@ -2294,7 +2295,7 @@ int sched_fork(unsigned long clone_flags, struct task_struct *p)
 unsigned long to_ratio(u64 period, u64 runtime)
 {
 	if (runtime == RUNTIME_INF)
-		return 1ULL << 20;
+		return BW_UNIT;
 
 	/*
 	 * Doing this here saves a lot of checks in all
@@ -2304,7 +2305,7 @@ unsigned long to_ratio(u64 period, u64 runtime)
 	if (period == 0)
 		return 0;
 
-	return div64_u64(runtime << 20, period);
+	return div64_u64(runtime << BW_SHIFT, period);
 }
 
 #ifdef CONFIG_SMP
@@ -3697,6 +3698,9 @@ static void __setscheduler_params(struct task_struct *p,
 	p->rt_priority = attr->sched_priority;
 	p->normal_prio = normal_prio(p);
 	set_load_weight(p);
+
+	if (attr->sched_flags & SCHED_FLAG_LATENCY_NICE)
+		p->latency_nice = attr->sched_latency_nice;
 }
 
 /* Actually do priority change: must hold pi & rq lock. */
@@ -3833,7 +3837,13 @@ recheck:
 			return -EINVAL;
 	}
 
-	if (attr->sched_flags & ~(SCHED_FLAG_RESET_ON_FORK))
+	if (attr->sched_flags &
+			~(SCHED_FLAG_RESET_ON_FORK | SCHED_FLAG_LATENCY_NICE |
+			  SCHED_FLAG_RECLAIM))
+		return -EINVAL;
+
+	/* Bandwidth reclaiming only makes sense for deadline reservations */
+	if ((attr->sched_flags & SCHED_FLAG_RECLAIM) && !dl_policy(policy))
 		return -EINVAL;
 
 	/*
@@ -3858,6 +3868,11 @@ recheck:
 				return -EPERM;
 		}
 
+		/* like nice, tightening latency requires privilege */
+		if ((attr->sched_flags & SCHED_FLAG_LATENCY_NICE) &&
+		    attr->sched_latency_nice < p->latency_nice)
+			return -EPERM;
+
 		if (rt_policy(policy)) {
 			unsigned long rlim_rtprio =
 					task_rlimit(p, RLIMIT_RTPRIO);
@@ -4189,6 +4204,8 @@ static int sched_copy_attr(struct sched_attr __user *uattr,
 	 * to be strict and return an error on out-of-bounds values?
 	 */
 	attr->sched_nice = clamp(attr->sched_nice, MIN_NICE, MAX_NICE);
+	attr->sched_latency_nice = clamp(attr->sched_latency_nice,
+					 MIN_NICE, MAX_NICE);
 
 	return 0;
 
@@ -4407,6 +4424,8 @@ SYSCALL_DEFINE4(sched_getattr, pid_t, pid, struct sched_attr __user *, uattr,
 	else
 		attr.sched_nice = task_nice(p);
 
+	attr.sched_latency_nice = p->latency_nice;
+
 	rcu_read_unlock();
 
 	retval = sched_read_attr(uattr, &attr, size);
@@ -50,6 +50,28 @@ static inline int is_leftmost(struct task_struct *p, struct dl_rq *dl_rq)
 	return dl_rq->rb_leftmost == &dl_se->rb_node;
 }
 
+static inline
+void add_running_bw(u64 dl_bw, struct dl_rq *dl_rq)
+{
+	u64 old = dl_rq->running_bw;
+
+	lockdep_assert_held(&(rq_of_dl_rq(dl_rq))->lock);
+	dl_rq->running_bw += dl_bw;
+	WARN_ON_ONCE(dl_rq->running_bw < old); /* overflow */
+}
+
+static inline
+void sub_running_bw(u64 dl_bw, struct dl_rq *dl_rq)
+{
+	u64 old = dl_rq->running_bw;
+
+	lockdep_assert_held(&(rq_of_dl_rq(dl_rq))->lock);
+	dl_rq->running_bw -= dl_bw;
+	WARN_ON_ONCE(dl_rq->running_bw > old); /* underflow */
+	if (dl_rq->running_bw > old)
+		dl_rq->running_bw = 0;
+}
+
 void init_dl_bandwidth(struct dl_bandwidth *dl_b, u64 period, u64 runtime)
 {
 	raw_spin_lock_init(&dl_b->dl_runtime_lock);
@@ -83,6 +105,8 @@ void init_dl_rq(struct dl_rq *dl_rq)
 #else
 	init_dl_bw(&dl_rq->dl_bw);
 #endif
+
+	dl_rq->running_bw = 0;
 }
 
 #ifdef CONFIG_SMP
@@ -704,6 +728,25 @@ int dl_runtime_exceeded(struct sched_dl_entity *dl_se)
 
 extern bool sched_rt_bandwidth_account(struct rt_rq *rt_rq);
 
+/*
+ * This implements the GRUB accounting rule: according to GRUB, the
+ * runtime of a reclaiming task is not depleted by the wall-clock time it
+ * runs, but by that time scaled by the active utilization of the rq
+ * (dq = -Uact * dt).  When little deadline bandwidth is in use, runtime
+ * drains slowly and the task gets to consume the bandwidth that inactive
+ * reservations leave idle; when the rq is fully booked the scaling
+ * factor is one and behaviour reverts to the plain CBS.
+ */
+static u64 grub_reclaim(u64 delta, struct rq *rq)
+{
+	u64 u_act = rq->dl.running_bw;
+
+	if (u_act > BW_UNIT)
+		u_act = BW_UNIT;
+
+	return (delta * u_act) >> BW_SHIFT;
+}
+
 /*
  * Update the current task's runtime statistics (provided it is still
  * a -deadline task and has not been removed from the dl_rq).
@@ -747,7 +790,10 @@ static void update_curr_dl(struct rq *rq)
 
 	sched_rt_avg_update(rq, delta_exec);
 
-	dl_se->runtime -= delta_exec;
+	if (unlikely(dl_se->flags & SCHED_FLAG_RECLAIM))
+		dl_se->runtime -= grub_reclaim(delta_exec, rq);
+	else
+		dl_se->runtime -= delta_exec;
 
 throttle:
 	if (dl_runtime_exceeded(dl_se) || dl_se->dl_yielded) {
@@ -955,6 +1001,13 @@ static void enqueue_task_dl(struct rq *rq, struct task_struct *p, int flags)
 		return;
 	}
 
+	/*
+	 * Replenishment enqueues pair with the internal dequeue done on
+	 * throttling, so the task's bandwidth is already accounted for.
+	 */
+	if (!(flags & ENQUEUE_REPLENISH))
+		add_running_bw(p->dl.dl_bw, &rq->dl);
+
 	/*
 	 * If p is throttled, we do nothing. In fact, if it exhausted
 	 * its budget it needs a replenishment and, since it now is on
@@ -980,6 +1033,7 @@ static void dequeue_task_dl(struct rq *rq, struct task_struct *p, int flags)
 {
 	update_curr_dl(rq);
 	__dequeue_task_dl(rq, p, flags);
+	sub_running_bw(p->dl.dl_bw, &rq->dl);
 }
 
 /*
@@ -954,6 +954,7 @@ void proc_sched_show_task(struct task_struct *p, struct seq_file *m)
 #endif
 	P(policy);
 	P(prio);
+	P(latency_nice);
 #undef PN
 #undef __PN
 #undef P
@@ -684,6 +684,8 @@ void init_entity_runnable_average(struct sched_entity *se)
 	sa->load_sum = sa->load_avg * LOAD_AVG_MAX;
 	sa->util_avg = scale_load_down(SCHED_LOAD_SCALE);
 	sa->util_sum = sa->util_avg * LOAD_AVG_MAX;
+	/* New entities start with no utilization history to estimate from */
+	memset(&sa->util_est, 0, sizeof(sa->util_est));
 	/* when this task enqueue'ed, it will contribute to its cfs_rq's load_avg */
 }
 
@@ -1625,6 +1627,7 @@ static int task_numa_migrate(struct task_struct *p)
 	 * alternative node to recheck if the tasks is now properly placed.
 	 */
 	p->numa_scan_period = task_scan_min(p);
+	p->numa_scan_settled = 0;
 
 	if (env.best_task == NULL) {
 		ret = migrate_task_to(p, env.best_cpu);
@@ -1698,6 +1701,19 @@ static void numa_group_count_active_nodes(struct numa_group *numa_group)
 #define NUMA_PERIOD_SLOTS 10
 #define NUMA_PERIOD_THRESHOLD 7
 
+/*
+ * Placement is considered converged after NUMA_SETTLED_STREAK consecutive
+ * scan windows with at least NUMA_SETTLED_THRESHOLD (out of
+ * NUMA_PERIOD_SLOTS) local faults and no page migrations. A converged
+ * task has its scan period doubled past the regular ceiling, up to
+ * NUMA_SETTLED_SHIFT extra doublings, so that it stops paying for
+ * hinting faults and PTE update TLB flushes it no longer learns from.
+ * The streak is reset the moment pages or the task itself migrate.
+ */
+#define NUMA_SETTLED_THRESHOLD 9
+#define NUMA_SETTLED_STREAK 4
+#define NUMA_SETTLED_SHIFT 3
+
 /*
  * Increase the scan period (slow down scanning) if the majority of
  * our memory is already on our local node, or if the majority of
@@ -1722,6 +1738,8 @@ static void update_task_scan_period(struct task_struct *p,
 	 * node is overloaded. In either case, scan slower
 	 */
 	if (local + shared == 0 || p->numa_faults_locality[2]) {
+		if (p->numa_faults_locality[2])
+			p->numa_scan_settled = 0;
 		p->numa_scan_period = min(p->numa_scan_period_max,
 			p->numa_scan_period << 1);
 
@@ -1739,6 +1757,31 @@ static void update_task_scan_period(struct task_struct *p,
 	 */
 	period_slot = DIV_ROUND_UP(p->numa_scan_period, NUMA_PERIOD_SLOTS);
 	ratio = (local * NUMA_PERIOD_SLOTS) / (local + remote);
+
+	/*
+	 * Once the fault statistics show a stable, overwhelmingly local
+	 * placement, back scanning off exponentially beyond the regular
+	 * ceiling. task_numa_fault() and task_numa_migrate() reset the
+	 * streak when anything moves again, which restores the normal
+	 * clamped scan rate below within one window.
+	 */
+	if (ratio >= NUMA_SETTLED_THRESHOLD)
+		p->numa_scan_settled++;
+	else
+		p->numa_scan_settled = 0;
+
+	if (p->numa_scan_settled >= NUMA_SETTLED_STREAK) {
+		unsigned int shift = min_t(unsigned int,
+				p->numa_scan_settled - NUMA_SETTLED_STREAK,
+				NUMA_SETTLED_SHIFT);
+
+		p->numa_scan_period = min(p->numa_scan_period << 1,
+				task_scan_max(p) << shift);
+		memset(p->numa_faults_locality, 0,
+				sizeof(p->numa_faults_locality));
+		return;
+	}
+
 	if (ratio >= NUMA_PERIOD_THRESHOLD) {
 		int slot = ratio - NUMA_PERIOD_THRESHOLD;
 		if (!slot)
@@ -1983,8 +2026,10 @@ static void task_numa_placement(struct task_struct *p)
 
 	if (max_faults) {
 		/* Set the new preferred node */
-		if (max_nid != p->numa_preferred_nid)
+		if (max_nid != p->numa_preferred_nid) {
 			sched_setnuma(p, max_nid);
+			p->numa_scan_settled = 0;
+		}
 
 		if (task_node(p) != p->numa_preferred_nid)
 			numa_migrate_preferred(p);
@@ -2197,8 +2242,11 @@ void task_numa_fault(int last_cpupid, int mem_node, int pages, int flags)
 	if (time_after(jiffies, p->numa_migrate_retry))
 		numa_migrate_preferred(p);
 
-	if (migrated)
+	if (migrated) {
 		p->numa_pages_migrated += pages;
+		/* Pages are still moving; placement has not converged. */
+		p->numa_scan_settled = 0;
+	}
 	if (flags & TNF_MIGRATE_FAIL)
 		p->numa_faults_locality[2] += pages;
 
@@ -2872,6 +2920,7 @@ static inline void update_load_avg(struct sched_entity *se, int update_tg)
 
 	if (cpu == smp_processor_id() && &rq->cfs == cfs_rq) {
 		unsigned long max = rq->cpu_capacity_orig;
+		unsigned long util = cfs_rq->avg.util_avg;
 
 		/*
 		 * There are a few boundary cases this might miss but it should
@@ -2889,8 +2938,11 @@ static inline void update_load_avg(struct sched_entity *se, int update_tg)
 		 *
 		 * See cpu_util().
 		 */
-		cpufreq_update_util(rq_clock(rq),
-				    min(cfs_rq->avg.util_avg, max), max);
+		if (sched_feat(UTIL_EST))
+			util = max_t(unsigned long, util,
+				READ_ONCE(cfs_rq->avg.util_est.enqueued));
+
+		cpufreq_update_util(rq_clock(rq), min(util, max), max);
 	}
 }
 
@@ -3070,6 +3122,7 @@ static void enqueue_sleeper(struct cfs_rq *cfs_rq, struct sched_entity *se)
 		se->statistics.sum_sleep_runtime += delta;
 
 		if (tsk) {
+			sched_latency_hist_record(SCHEDLAT_SLEEP, delta);
 			account_scheduler_latency(tsk, delta >> 10, 1);
 			trace_sched_stat_sleep(tsk, delta);
 		}
@@ -3087,6 +3140,8 @@ static void enqueue_sleeper(struct cfs_rq *cfs_rq, struct sched_entity *se)
 		se->statistics.sum_sleep_runtime += delta;
 
 		if (tsk) {
+			sched_latency_hist_record(SCHEDLAT_BLOCK, delta);
+
 			if (tsk->in_iowait) {
 				se->statistics.iowait_sum += delta;
 				se->statistics.iowait_count++;
@@ -4307,6 +4362,87 @@ static inline void hrtick_update(struct rq *rq)
 }
 #endif
 
+#ifdef CONFIG_SMP
+
+static inline unsigned long task_util(struct task_struct *p)
+{
+	return p->se.avg.util_avg;
+}
+
+static inline unsigned long _task_util_est(struct task_struct *p)
+{
+	struct util_est ue = READ_ONCE(p->se.avg.util_est);
+
+	return max(ue.ewma, ue.enqueued);
+}
+
+static inline void util_est_enqueue(struct cfs_rq *cfs_rq,
+				    struct task_struct *p)
+{
+	unsigned int enqueued;
+
+	if (!sched_feat(UTIL_EST))
+		return;
+
+	/* Update root cfs_rq's estimated utilization */
+	enqueued  = cfs_rq->avg.util_est.enqueued;
+	enqueued += _task_util_est(p);
+	WRITE_ONCE(cfs_rq->avg.util_est.enqueued, enqueued);
+}
+
+/*
+ * Update the estimated utilization of a task at dequeue time and fold it
+ * out of the root cfs_rq's estimate.  When the task is going to sleep,
+ * its current util_avg - the largest value it reached during this
+ * activation, since PELT only decays while sleeping - is sampled into an
+ * EWMA, so the next enqueue immediately restores the demand the task had
+ * before the sleep instead of the decayed value.
+ */
+static inline void util_est_dequeue(struct cfs_rq *cfs_rq,
+				    struct task_struct *p, bool task_sleep)
+{
+	long last_ewma_diff;
+	struct util_est ue;
+
+	if (!sched_feat(UTIL_EST))
+		return;
+
+	ue.enqueued  = cfs_rq->avg.util_est.enqueued;
+	ue.enqueued -= min_t(unsigned int, ue.enqueued, _task_util_est(p));
+	WRITE_ONCE(cfs_rq->avg.util_est.enqueued, ue.enqueued);
+
+	/*
+	 * Skip update of task's estimated utilization if the task has
+	 * not denied the CPU yet, i.e. it is still runnable.
+	 */
+	if (!task_sleep)
+		return;
+
+	ue = p->se.avg.util_est;
+	ue.enqueued = task_util(p);
+
+	/*
+	 *          ewma(t) = w * task_util(p) + (1-w) * ewma(t-1)
+	 * with w = 1 / 2^UTIL_EST_WEIGHT_SHIFT, using shifts only.
+	 */
+	last_ewma_diff = ue.enqueued - ue.ewma;
+	ue.ewma <<= UTIL_EST_WEIGHT_SHIFT;
+	ue.ewma  += last_ewma_diff;
+	ue.ewma >>= UTIL_EST_WEIGHT_SHIFT;
+
+	WRITE_ONCE(p->se.avg.util_est, ue);
+}
+
+#else /* !CONFIG_SMP */
+
+static inline void
+util_est_enqueue(struct cfs_rq *cfs_rq, struct task_struct *p) {}
+static inline void
+util_est_dequeue(struct cfs_rq *cfs_rq, struct task_struct *p,
+		 bool task_sleep) {}
+
+#endif /* CONFIG_SMP */
+
 /*
  * The enqueue_task method is called before nr_running is
  * increased. Here we update the fair scheduling stats and
@@ -4318,6 +4454,8 @@ enqueue_task_fair(struct rq *rq, struct task_struct *p, int flags)
 	struct cfs_rq *cfs_rq;
 	struct sched_entity *se = &p->se;
 
+	util_est_enqueue(&rq->cfs, p);
+
 	for_each_sched_entity(se) {
 		if (se->on_rq)
 			break;
@@ -4411,6 +4549,7 @@ static void dequeue_task_fair(struct rq *rq, struct task_struct *p, int flags)
 	if (!se)
 		sub_nr_running(rq, 1);
 
+	util_est_dequeue(&rq->cfs, p, task_sleep);
 	hrtick_update(rq);
 }
 
@@ -5052,6 +5191,60 @@ find_idlest_cpu(struct sched_group *group, struct task_struct *p, int this_cpu)
 	return shallowest_idle_cpu != -1 ? shallowest_idle_cpu : least_loaded_cpu;
 }
 
+#ifdef CONFIG_SCHED_SMT
+/*
+ * Per-LLC hint that at least one core in the LLC is fully idle, indexed
+ * by sd_llc_id (the first cpu of the domain).  The hint errs on the
+ * side of true: it is set whenever a cpu finds its whole core idle on
+ * idle entry and cleared when a full select_idle_sibling() scan comes
+ * up empty, so the O(cores) scan is skipped while the LLC is
+ * saturated.
+ */
+static DEFINE_PER_CPU(int, llc_has_idle_cores);
+
+static inline bool test_idle_cores(int cpu)
+{
+	return READ_ONCE(per_cpu(llc_has_idle_cores,
+				 per_cpu(sd_llc_id, cpu)));
+}
+
+static inline void set_idle_cores(int cpu, int val)
+{
+	WRITE_ONCE(per_cpu(llc_has_idle_cores, per_cpu(sd_llc_id, cpu)),
+		   val);
+}
+
+void __update_idle_core(struct rq *rq)
+{
+	int core = cpu_of(rq);
+	int cpu;
+
+	rcu_read_lock();
+	if (test_idle_cores(core))
+		goto unlock;
+
+	for_each_cpu(cpu, topology_sibling_cpumask(core)) {
+		if (cpu == core)
+			continue;
+		if (!idle_cpu(cpu))
+			goto unlock;
+	}
+
+	set_idle_cores(core, 1);
+unlock:
+	rcu_read_unlock();
+}
+#else
+static inline bool test_idle_cores(int cpu)
+{
+	return true;
+}
+
+static inline void set_idle_cores(int cpu, int val)
+{
+}
+#endif /* CONFIG_SCHED_SMT */
+
 /*
  * Try and locate an idle CPU in the sched_domain.
  */
@@ -5070,6 +5263,24 @@ static int select_idle_sibling(struct task_struct *p, int target)
 	if (i != target && cpus_share_cache(i, target) && idle_cpu(i))
 		return i;
 
+	/*
+	 * When the LLC is known to have no idle core, don't burn cycles
+	 * walking every group; a quick look at the target's own core is
+	 * all that can plausibly pay off.
+	 */
+	if (!test_idle_cores(target)) {
+#ifdef CONFIG_SCHED_SMT
+		for_each_cpu(i, topology_sibling_cpumask(target)) {
+			if (i == target)
+				continue;
+			if (cpumask_test_cpu(i, tsk_cpus_allowed(p)) &&
+			    idle_cpu(i))
+				return i;
+		}
+#endif
+		return target;
+	}
+
 	/*
 	 * Otherwise, iterate the domains and find an elegible idle cpu.
 	 */
@@ -5093,6 +5304,7 @@ next:
 			sg = sg->next;
 		} while (sg != sd->groups);
 	}
+	set_idle_cores(target, 0);
 done:
 	return target;
 }
@@ -5125,9 +5337,19 @@ done:
  */
 static int cpu_util(int cpu)
 {
-	unsigned long util = cpu_rq(cpu)->cfs.avg.util_avg;
+	struct cfs_rq *cfs_rq = &cpu_rq(cpu)->cfs;
+	unsigned long util = cfs_rq->avg.util_avg;
 	unsigned long capacity = capacity_orig_of(cpu);
 
+	/*
+	 * The estimated utilization does not decay while tasks sleep, so
+	 * periodic tasks that just woke up still count with the demand of
+	 * their previous activation.
+	 */
+	if (sched_feat(UTIL_EST))
+		util = max_t(unsigned long, util,
+			     READ_ONCE(cfs_rq->avg.util_est.enqueued));
+
 	return (util >= capacity) ? capacity : util;
 }
 
@@ -5272,6 +5494,22 @@ wakeup_gran(struct sched_entity *curr, struct sched_entity *se)
 	 * This is especially important for buddies when the leftmost
 	 * task is higher priority than the buddy.
 	 */
+
+	/*
+	 * Scale the granularity by the waking task's latency nice using
+	 * the regular nice weights: a latency-sensitive task (negative
+	 * value) sees a smaller granularity and preempts sooner, a
+	 * latency-tolerant one coasts longer before taking the CPU.
+	 */
+	if (entity_is_task(se)) {
+		int latency_nice = task_of(se)->latency_nice;
+
+		if (unlikely(latency_nice))
+			gran = div_u64((u64)gran * NICE_0_LOAD,
+				scale_load(sched_prio_to_weight[latency_nice +
+								20]));
+	}
+
 	return calc_delta_fair(gran, se);
 }
 
@@ -7460,6 +7698,108 @@ update_next_balance(struct sched_domain *sd, int cpu_busy, unsigned long *next_b
 		*next_balance = next;
 }
 
+/* Minimum delay between cross-node steal attempts, to preserve locality. */
+#define STEAL_REMOTE_INTERVAL_MS	10
+
+/*
+ * Try to steal one runnable task from @src_rq.  Called with this_rq
+ * unlocked; uses the regular detach/attach machinery so all the usual
+ * migration constraints (affinity, throttling, cache hotness) apply.
+ */
+static int steal_from(struct rq *this_rq, struct rq *src_rq,
+		      struct sched_domain *sd)
+{
+	struct task_struct *p = NULL;
+	struct lb_env env = {
+		.sd		= sd,
+		.src_cpu	= cpu_of(src_rq),
+		.src_rq		= src_rq,
+		.dst_cpu	= this_rq->cpu,
+		.dst_rq		= this_rq,
+		.idle		= CPU_NEWLY_IDLE,
+	};
+
+	raw_spin_lock(&src_rq->lock);
+	if (src_rq->cfs.h_nr_running >= 2) {
+		update_rq_clock(src_rq);
+		p = detach_one_task(&env);
+	}
+	raw_spin_unlock(&src_rq->lock);
+
+	if (!p)
+		return 0;
+
+	attach_one_task(this_rq, p);
+	return 1;
+}
+
+/*
+ * Work-stealing pass for an idling cpu: probe the rqs sharing our LLC,
+ * then the rest of our node, for one with more than one runnable CFS
+ * task, and pull a single task directly.  Unlike find_busiest_group()
+ * this only reads one word per candidate rq, and it prefers the
+ * closest source so storage shards keep their cache footprint.
+ * Cross-node steals are rate-limited per rq.
+ */
+static int try_steal(struct rq *this_rq)
+{
+	int this_cpu = this_rq->cpu, cpu;
+	const struct cpumask *llc_mask, *node_mask;
+	struct sched_domain *sd, *numa_sd = NULL, *tmp;
+	int pulled_task = 0;
+
+	rcu_read_lock();
+	sd = rcu_dereference(per_cpu(sd_llc, this_cpu));
+	if (!sd)
+		goto unlock;
+	llc_mask = sched_domain_span(sd);
+
+	/* First preference: an rq sharing our last level cache. */
+	for_each_cpu(cpu, llc_mask) {
+		if (cpu == this_cpu || cpu_rq(cpu)->cfs.h_nr_running < 2)
+			continue;
+		pulled_task = steal_from(this_rq, cpu_rq(cpu), sd);
+		if (pulled_task)
+			goto unlock;
+	}
+
+	/* Then the rest of our node. */
+	node_mask = cpumask_of_node(cpu_to_node(this_cpu));
+	for_each_cpu_and(cpu, node_mask, cpu_active_mask) {
+		if (cpumask_test_cpu(cpu, llc_mask) ||
+		    cpu_rq(cpu)->cfs.h_nr_running < 2)
+			continue;
+		pulled_task = steal_from(this_rq, cpu_rq(cpu), sd);
+		if (pulled_task)
+			goto unlock;
+	}
+
+	/* Finally other nodes, but not more often than the rate limit. */
+	if (!time_after(jiffies, this_rq->next_remote_steal))
+		goto unlock;
+
+	for_each_domain(this_cpu, tmp) {
+		if (tmp->flags & SD_NUMA)
+			numa_sd = tmp;
+	}
+	if (!numa_sd)
+		goto unlock;
+
+	for_each_cpu_and(cpu, sched_domain_span(numa_sd), cpu_active_mask) {
+		if (cpumask_test_cpu(cpu, node_mask) ||
+		    cpu_rq(cpu)->cfs.h_nr_running < 2)
+			continue;
+		pulled_task = steal_from(this_rq, cpu_rq(cpu), numa_sd);
+		if (pulled_task)
+			break;
+	}
+	this_rq->next_remote_steal = jiffies +
+			msecs_to_jiffies(STEAL_REMOTE_INTERVAL_MS);
+unlock:
+	rcu_read_unlock();
+	return pulled_task;
+}
+
 /*
  * idle_balance is called by schedule() if this_cpu is about to become
  * idle. Attempts to pull tasks from other CPUs.
@@ -7491,6 +7831,20 @@ static int idle_balance(struct rq *this_rq)
 
 	raw_spin_unlock(&this_rq->lock);
 
+	/*
+	 * In work-stealing mode, probe nearby rqs directly instead of
+	 * paying for a full find_busiest_group() statistics pass on
+	 * every idle entry.  If nothing could be stolen, leave whatever
+	 * imbalance remains to the periodic balancer.
+	 */
+	if (sched_feat(STEAL)) {
+		pulled_task = try_steal(this_rq);
+		raw_spin_lock(&this_rq->lock);
+		if (this_rq->cfs.h_nr_running && !pulled_task)
+			pulled_task = 1;
+		goto out;
+	}
+
 	update_blocked_averages(this_cpu);
 	rcu_read_lock();
 	for_each_domain(this_cpu, sd) {
@@ -67,5 +67,17 @@ SCHED_FEAT(RT_PUSH_IPI, true)
 SCHED_FEAT(FORCE_SD_OVERLAP, false)
 SCHED_FEAT(RT_RUNTIME_SHARE, true)
 SCHED_FEAT(LB_MIN, false)
+
+/*
+ * Steal a task from a nearby overloaded rq on idle entry instead of
+ * running the full newidle load_balance() statistics pass.
+ */
+SCHED_FEAT(STEAL, true)
 SCHED_FEAT(ATTACH_AGE_LOAD, true)
 
+/*
+ * UtilEstimation. Use estimated CPU utilization - which does not decay
+ * across sleeps - for task placement and frequency selection.
+ */
+SCHED_FEAT(UTIL_EST, true)
+
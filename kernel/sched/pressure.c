@@ -0,0 +1,221 @@
+/*
+ * Pressure stall tracking for CPU, memory and I/O.
+ *
+ * The load average folds runnable tasks, reclaim stalls and I/O waits
+ * into a single number that says nothing about which resource is short
+ * or how badly. This file tracks, per resource, the share of wall time
+ * in which at least one task was stalled on that resource ("some") and
+ * in which no CPU was doing productive work at all ("full"), and
+ * exports running 10s/60s/300s averages plus absolute stall time under
+ * /proc/pressure/.
+ *
+ * The accounting is sample based: a worker wakes ten times a second,
+ * inspects the runqueues, the nr_iowait counters and the direct reclaim
+ * stall counter maintained by pressure_memstall_enter()/leave(), and
+ * charges the elapsed period to whatever states were active. That makes
+ * the scheduler hot paths free of new bookkeeping at the cost of 100ms
+ * sampling granularity, which is plenty for userspace that polls these
+ * numbers every few seconds.
+ */
+
+#include <linux/proc_fs.h>
+#include <linux/seq_file.h>
+#include <linux/math64.h>
+#include "sched.h"
+
+enum pressure_res {
+	PRES_CPU,
+	PRES_MEM,
+	PRES_IO,
+	NR_PRES_RES,
+};
+
+enum pressure_state {
+	PRES_SOME,
+	PRES_FULL,
+	NR_PRES_STATES,
+};
+
+/* Sample stall state at 10Hz, fold into the averages every two seconds */
+#define PRESSURE_SAMPLE		(HZ / 10)
+#define PRESSURE_EPOCH_NS	(2 * NSEC_PER_SEC)
+
+/*
+ * Fixed point averaging, in the style of calc_load(): the constants are
+ * exp(-2s/10s), exp(-2s/60s) and exp(-2s/300s) scaled by 2048.
+ */
+#define PRESSURE_FSHIFT		11
+#define PRESSURE_FIXED		(1UL << PRESSURE_FSHIFT)
+static const unsigned long pressure_exp[3] = { 1677, 1981, 2034 };
+
+struct pressure_record {
+	u64 time;		/* total stall time, ns */
+	u64 epoch_time;		/* ->time at the last averaging epoch */
+	unsigned long avg[3];	/* 10s/60s/300s percentages, fixed point */
+};
+
+static struct pressure_record pressure[NR_PRES_RES][NR_PRES_STATES];
+static u64 pressure_last_sample;
+static u64 pressure_last_epoch;
+
+/* Tasks currently stalled in direct reclaim */
+static atomic_t nr_memstall;
+
+void pressure_memstall_enter(void)
+{
+	if (current->in_memstall)
+		return;
+	current->in_memstall = 1;
+	atomic_inc(&nr_memstall);
+}
+
+void pressure_memstall_leave(void)
+{
+	if (!current->in_memstall)
+		return;
+	current->in_memstall = 0;
+	atomic_dec(&nr_memstall);
+}
+
+static void pressure_fold_avgs(u64 epoch)
+{
+	int res, state, i;
+
+	for (res = 0; res < NR_PRES_RES; res++) {
+		for (state = 0; state < NR_PRES_STATES; state++) {
+			struct pressure_record *rec = &pressure[res][state];
+			unsigned long pct;
+			u64 delta;
+
+			delta = rec->time - rec->epoch_time;
+			rec->epoch_time = rec->time;
+
+			pct = min_t(u64, div64_u64((delta * 100) <<
+					PRESSURE_FSHIFT, epoch),
+					100UL << PRESSURE_FSHIFT);
+
+			for (i = 0; i < 3; i++)
+				rec->avg[i] = (rec->avg[i] * pressure_exp[i] +
+					pct * (PRESSURE_FIXED -
+					       pressure_exp[i])) >>
+					PRESSURE_FSHIFT;
+		}
+	}
+}
+
+static void pressure_sample_fn(struct work_struct *work);
+static DECLARE_DELAYED_WORK(pressure_work, pressure_sample_fn);
+
+static void pressure_sample_fn(struct work_struct *work)
+{
+	bool cpu_some = false, all_idle = true, all_idle_or_memstall = true;
+	int memstall = atomic_read(&nr_memstall);
+	unsigned long iostall = nr_iowait();
+	u64 now, period;
+	int cpu;
+
+	rcu_read_lock();
+	for_each_online_cpu(cpu) {
+		struct rq *rq = cpu_rq(cpu);
+		struct task_struct *curr = READ_ONCE(rq->curr);
+
+		if (rq->nr_running > 1)
+			cpu_some = true;
+		if (curr != rq->idle) {
+			all_idle = false;
+			if (!curr->in_memstall)
+				all_idle_or_memstall = false;
+		}
+	}
+	rcu_read_unlock();
+
+	now = ktime_get_ns();
+	period = now - pressure_last_sample;
+	pressure_last_sample = now;
+
+	if (cpu_some)
+		pressure[PRES_CPU][PRES_SOME].time += period;
+	if (memstall) {
+		pressure[PRES_MEM][PRES_SOME].time += period;
+		if (all_idle_or_memstall)
+			pressure[PRES_MEM][PRES_FULL].time += period;
+	}
+	if (iostall) {
+		pressure[PRES_IO][PRES_SOME].time += period;
+		if (all_idle)
+			pressure[PRES_IO][PRES_FULL].time += period;
+	}
+
+	if (now - pressure_last_epoch >= PRESSURE_EPOCH_NS) {
+		pressure_fold_avgs(now - pressure_last_epoch);
+		pressure_last_epoch = now;
+	}
+
+	schedule_delayed_work(&pressure_work, PRESSURE_SAMPLE);
+}
+
+static void pressure_show_record(struct seq_file *m,
+				 struct pressure_record *rec,
+				 const char *label)
+{
+	unsigned long avg[3];
+	int i;
+
+	for (i = 0; i < 3; i++)
+		avg[i] = rec->avg[i];
+
+	seq_printf(m, "%s avg10=%lu.%02lu avg60=%lu.%02lu avg300=%lu.%02lu total=%llu\n",
+		   label,
+		   avg[0] >> PRESSURE_FSHIFT,
+		   ((avg[0] & (PRESSURE_FIXED - 1)) * 100) >> PRESSURE_FSHIFT,
+		   avg[1] >> PRESSURE_FSHIFT,
+		   ((avg[1] & (PRESSURE_FIXED - 1)) * 100) >> PRESSURE_FSHIFT,
+		   avg[2] >> PRESSURE_FSHIFT,
+		   ((avg[2] & (PRESSURE_FIXED - 1)) * 100) >> PRESSURE_FSHIFT,
+		   div_u64(rec->time, NSEC_PER_USEC));
+}
+
+static int pressure_show(struct seq_file *m, void *v)
+{
+	enum pressure_res res = (unsigned long)m->private;
+
+	pressure_show_record(m, &pressure[res][PRES_SOME], "some");
+	/* All CPUs idle while a task is runnable cannot happen */
+	if (res != PRES_CPU)
+		pressure_show_record(m, &pressure[res][PRES_FULL], "full");
+	return 0;
+}
+
+static int pressure_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, pressure_show, PDE_DATA(inode));
+}
+
+static const struct file_operations pressure_fops = {
+	.open		= pressure_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static int __init pressure_init(void)
+{
+	struct proc_dir_entry *dir;
+
+	dir = proc_mkdir("pressure", NULL);
+	if (!dir)
+		return -ENOMEM;
+
+	proc_create_data("cpu", 0444, dir, &pressure_fops,
+			 (void *)(unsigned long)PRES_CPU);
+	proc_create_data("memory", 0444, dir, &pressure_fops,
+			 (void *)(unsigned long)PRES_MEM);
+	proc_create_data("io", 0444, dir, &pressure_fops,
+			 (void *)(unsigned long)PRES_IO);
+
+	pressure_last_sample = ktime_get_ns();
+	pressure_last_epoch = pressure_last_sample;
+	schedule_delayed_work(&pressure_work, PRESSURE_SAMPLE);
+	return 0;
+}
+late_initcall(pressure_init);
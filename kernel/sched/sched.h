@@ -520,8 +520,18 @@ struct dl_rq {
 #else
 	struct dl_bw dl_bw;
 #endif
+	/*
+	 * "Active utilization" of this runqueue: the sum of the bandwidth
+	 * (dl_bw, in BW_SHIFT fixed point) of the -deadline tasks queued
+	 * here, including throttled ones.  Used by the GRUB reclaiming
+	 * algorithm to scale runtime depletion in update_curr_dl().
+	 */
+	u64 running_bw;
 };
 
+#define BW_SHIFT	20
+#define BW_UNIT		(1 << BW_SHIFT)
+
 #ifdef CONFIG_SMP
 
 /*
@@ -639,6 +649,8 @@ struct rq {
 	int active_balance;
 	int push_cpu;
 	struct cpu_stop_work active_balance_work;
+	/* Next time this rq may attempt a cross-node steal */
+	unsigned long next_remote_steal;
 	/* cpu of this runqueue: */
 	int cpu;
 	int online;
@@ -928,6 +940,17 @@ static inline void sched_ttwu_pending(void) { }
 
 #endif /* CONFIG_SMP */
 
+#ifdef CONFIG_SCHED_SMT
+extern void __update_idle_core(struct rq *rq);
+
+static inline void update_idle_core(struct rq *rq)
+{
+	__update_idle_core(rq);
+}
+#else
+static inline void update_idle_core(struct rq *rq) { }
+#endif
+
 #include "stats.h"
 #include "auto_group.h"
 
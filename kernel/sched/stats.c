@@ -130,9 +130,54 @@ static const struct file_operations proc_schedstat_operations = {
 	.release = seq_release,
 };
 
+/*
+ * Log2 scheduling latency histograms, fed from the sched_info hooks and
+ * enqueue_sleeper().  Counters are plain per-cpu increments; readers sum
+ * over cpus, so a snapshot is cheap and the update path stays lock-free.
+ */
+DEFINE_PER_CPU(u64 [SCHEDLAT_NR][SCHEDLAT_NR_BUCKETS], sched_latency_hist);
+
+static const char * const schedlat_names[SCHEDLAT_NR] = {
+	"wait", "sleep", "block",
+};
+
+static int show_sched_latency_hist(struct seq_file *seq, void *v)
+{
+	int type, bucket, cpu;
+
+	seq_puts(seq, "# log2 latency histograms, bucket n counts samples in [2^(n-1), 2^n) ns\n");
+	for (type = 0; type < SCHEDLAT_NR; type++) {
+		seq_printf(seq, "%s:", schedlat_names[type]);
+		for (bucket = 0; bucket < SCHEDLAT_NR_BUCKETS; bucket++) {
+			u64 count = 0;
+
+			for_each_possible_cpu(cpu)
+				count += per_cpu(sched_latency_hist,
+						 cpu)[type][bucket];
+			seq_printf(seq, " %llu", count);
+		}
+		seq_putc(seq, '\n');
+	}
+	return 0;
+}
+
+static int sched_latency_hist_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, show_sched_latency_hist, NULL);
+}
+
+static const struct file_operations proc_sched_latency_hist_operations = {
+	.open    = sched_latency_hist_open,
+	.read    = seq_read,
+	.llseek  = seq_lseek,
+	.release = single_release,
+};
+
 static int __init proc_schedstat_init(void)
 {
 	proc_create("schedstat", 0, NULL, &proc_schedstat_operations);
+	proc_create("sched_latency_hist", 0, NULL,
+		    &proc_sched_latency_hist_operations);
 	return 0;
 }
 subsys_initcall(proc_schedstat_init);
@@ -33,6 +33,34 @@ rq_sched_info_dequeued(struct rq *rq, unsigned long long delta)
 # define schedstat_inc(rq, field)	do { if (schedstat_enabled()) { (rq)->field++; } } while (0)
 # define schedstat_add(rq, field, amt)	do { if (schedstat_enabled()) { (rq)->field += (amt); } } while (0)
 # define schedstat_set(var, val)	do { if (schedstat_enabled()) { var = (val); } } while (0)
+
+/*
+ * Log2 histograms of scheduling latencies, one per latency class.
+ * Exported via /proc/sched_latency_hist; see kernel/sched/stats.c.
+ */
+enum schedlat_type {
+	SCHEDLAT_WAIT,		/* queued (or woken) to running */
+	SCHEDLAT_SLEEP,		/* voluntary sleep (S state) */
+	SCHEDLAT_BLOCK,		/* uninterruptible block (D state) */
+	SCHEDLAT_NR,
+};
+
+#define SCHEDLAT_NR_BUCKETS	32
+
+DECLARE_PER_CPU(u64 [SCHEDLAT_NR][SCHEDLAT_NR_BUCKETS], sched_latency_hist);
+
+/*
+ * Bucket n counts samples with latency in [2^(n-1), 2^n) ns.  A plain
+ * per-cpu increment, so this is cheap enough for the context switch
+ * path where the tracepoints are not.
+ */
+static inline void sched_latency_hist_record(enum schedlat_type type,
+					     u64 delta)
+{
+	int bucket = min_t(int, fls64(delta), SCHEDLAT_NR_BUCKETS - 1);
+
+	__this_cpu_inc(sched_latency_hist[type][bucket]);
+}
 #else /* !CONFIG_SCHEDSTATS */
 static inline void
 rq_sched_info_arrive(struct rq *rq, unsigned long long delta)
@@ -47,6 +75,7 @@ rq_sched_info_depart(struct rq *rq, unsigned long long delta)
 # define schedstat_inc(rq, field)	do { } while (0)
 # define schedstat_add(rq, field, amt)	do { } while (0)
 # define schedstat_set(var, val)	do { } while (0)
+# define sched_latency_hist_record(type, delta)	do { } while (0)
 #endif
 
 #ifdef CONFIG_SCHED_INFO
@@ -83,8 +112,10 @@ static void sched_info_arrive(struct rq *rq, struct task_struct *t)
 {
 	unsigned long long now = rq_clock(rq), delta = 0;
 
-	if (t->sched_info.last_queued)
+	if (t->sched_info.last_queued) {
 		delta = now - t->sched_info.last_queued;
+		sched_latency_hist_record(SCHEDLAT_WAIT, delta);
+	}
 	sched_info_reset_dequeued(t);
 	t->sched_info.run_delay += delta;
 	t->sched_info.last_arrival = now;
@@ -53,6 +53,12 @@ void remove_wait_queue(wait_queue_head_t *q, wait_queue_t *wait)
 EXPORT_SYMBOL(remove_wait_queue);
 
 
+/*
+ * Maximum number of waiters woken under a single hold of the waitqueue
+ * lock before the walk is interrupted via a bookmark entry.
+ */
+#define WAITQUEUE_WALK_BREAK_CNT 64
+
 /*
  * The core wakeup function. Non-exclusive wakeups (nr_exclusive == 0) just
  * wake everything up. If it's an exclusive wakeup (nr_exclusive == small +ve
@@ -61,19 +67,80 @@ EXPORT_SYMBOL(remove_wait_queue);
  * There are circumstances in which we can try to wake a task which has already
  * started to run but is not in state TASK_RUNNING. try_to_wake_up() returns
  * zero in this (rare) case, and we handle it by continuing to scan the queue.
+ *
+ * If @bookmark is non-NULL, the walk stops after WAITQUEUE_WALK_BREAK_CNT
+ * entries and the bookmark is inserted at the break position, so the
+ * caller can drop the lock and resume from it later; the bookmark's
+ * WQ_FLAG_BOOKMARK flag tells whether the walk is complete.  If @wake_q
+ * is non-NULL, waiters using the default wakeup functions are collected
+ * on it instead of being woken under the lock.
  */
-static void __wake_up_common(wait_queue_head_t *q, unsigned int mode,
-			int nr_exclusive, int wake_flags, void *key)
+static int __wake_up_common(wait_queue_head_t *q, unsigned int mode,
+			int nr_exclusive, int wake_flags, void *key,
+			struct wake_q_head *wake_q, wait_queue_t *bookmark)
 {
 	wait_queue_t *curr, *next;
+	int cnt = 0;
+
+	if (bookmark && (bookmark->flags & WQ_FLAG_BOOKMARK)) {
+		curr = list_next_entry(bookmark, task_list);
 
-	list_for_each_entry_safe(curr, next, &q->task_list, task_list) {
+		list_del(&bookmark->task_list);
+		bookmark->flags = 0;
+	} else {
+		curr = list_first_entry(&q->task_list, wait_queue_t,
+					task_list);
+	}
+
+	if (&curr->task_list == &q->task_list)
+		return nr_exclusive;
+
+	list_for_each_entry_safe_from(curr, next, &q->task_list, task_list) {
 		unsigned flags = curr->flags;
+		int ret;
+
+		if (flags & WQ_FLAG_BOOKMARK)
+			continue;
 
-		if (curr->func(curr, mode, wake_flags, key) &&
-				(flags & WQ_FLAG_EXCLUSIVE) && !--nr_exclusive)
+		if (wake_q && (curr->func == default_wake_function ||
+			       curr->func == autoremove_wake_function)) {
+			struct task_struct *p = curr->private;
+
+			/*
+			 * Serialized against prepare_to_wait() by q->lock,
+			 * so a task seen running here has either consumed
+			 * its wakeup already or will re-check its wait
+			 * condition before sleeping again - the same races
+			 * try_to_wake_up() tolerates.
+			 */
+			if (!(p->state & mode))
+				continue;
+			if (curr->func == autoremove_wake_function)
+				list_del_init(&curr->task_list);
+			wake_q_add(wake_q, p);
+			ret = 1;
+		} else {
+			ret = curr->func(curr, mode, wake_flags, key);
+		}
+		if (ret && (flags & WQ_FLAG_EXCLUSIVE) && !--nr_exclusive)
 			break;
+
+		if (bookmark && (++cnt > WAITQUEUE_WALK_BREAK_CNT) &&
+				(&next->task_list != &q->task_list)) {
+			bookmark->flags = WQ_FLAG_BOOKMARK;
+			list_add_tail(&bookmark->task_list, &next->task_list);
+			break;
+		}
 	}
+	return nr_exclusive;
+}
+
+static void init_bookmark(wait_queue_t *bookmark)
+{
+	bookmark->flags = 0;
+	bookmark->private = NULL;
+	bookmark->func = NULL;
+	INIT_LIST_HEAD(&bookmark->task_list);
 }
 
 /**
@@ -90,25 +157,70 @@ void __wake_up(wait_queue_head_t *q, unsigned int mode,
 			int nr_exclusive, void *key)
 {
 	unsigned long flags;
+	wait_queue_t bookmark;
 
-	spin_lock_irqsave(&q->lock, flags);
-	__wake_up_common(q, mode, nr_exclusive, 0, key);
-	spin_unlock_irqrestore(&q->lock, flags);
+	init_bookmark(&bookmark);
+
+	/*
+	 * Long queues are walked in chunks, so that the lock hold time
+	 * (and irq-off time) stays bounded no matter how many waiters
+	 * have piled up.
+	 */
+	do {
+		spin_lock_irqsave(&q->lock, flags);
+		nr_exclusive = __wake_up_common(q, mode, nr_exclusive, 0,
+						key, NULL, &bookmark);
+		spin_unlock_irqrestore(&q->lock, flags);
+	} while (bookmark.flags & WQ_FLAG_BOOKMARK);
 }
 EXPORT_SYMBOL(__wake_up);
 
+/**
+ * __wake_up_batch - wake up threads blocked on a waitqueue, in batches.
+ * @q: the waitqueue
+ * @mode: which threads
+ * @nr_exclusive: how many wake-one or wake-many threads to wake up
+ * @key: is directly passed to the wakeup function
+ *
+ * Like __wake_up(), but waiters using the default wakeup functions are
+ * only collected under the waitqueue lock; the try_to_wake_up() calls
+ * happen after it is released, from preemptible context.  This keeps the
+ * lock hold time short for thundering-herd queues with hundreds of
+ * waiters.  Must be called from process context.
+ */
+void __wake_up_batch(wait_queue_head_t *q, unsigned int mode,
+			int nr_exclusive, void *key)
+{
+	unsigned long flags;
+	wait_queue_t bookmark;
+
+	init_bookmark(&bookmark);
+
+	do {
+		WAKE_Q(wake_q);
+
+		spin_lock_irqsave(&q->lock, flags);
+		nr_exclusive = __wake_up_common(q, mode, nr_exclusive, 0,
+						key, &wake_q, &bookmark);
+		spin_unlock_irqrestore(&q->lock, flags);
+
+		wake_up_q(&wake_q);
+	} while (bookmark.flags & WQ_FLAG_BOOKMARK);
+}
+EXPORT_SYMBOL_GPL(__wake_up_batch);
+
 /*
  * Same as __wake_up but called with the spinlock in wait_queue_head_t held.
  */
 void __wake_up_locked(wait_queue_head_t *q, unsigned int mode, int nr)
 {
-	__wake_up_common(q, mode, nr, 0, NULL);
+	__wake_up_common(q, mode, nr, 0, NULL, NULL, NULL);
 }
 EXPORT_SYMBOL_GPL(__wake_up_locked);
 
 void __wake_up_locked_key(wait_queue_head_t *q, unsigned int mode, void *key)
 {
-	__wake_up_common(q, mode, 1, 0, key);
+	__wake_up_common(q, mode, 1, 0, key, NULL, NULL);
 }
 EXPORT_SYMBOL_GPL(__wake_up_locked_key);
 
@@ -142,7 +254,7 @@ void __wake_up_sync_key(wait_queue_head_t *q, unsigned int mode,
 		wake_flags = 0;
 
 	spin_lock_irqsave(&q->lock, flags);
-	__wake_up_common(q, mode, nr_exclusive, wake_flags, key);
+	__wake_up_common(q, mode, nr_exclusive, wake_flags, key, NULL, NULL);
 	spin_unlock_irqrestore(&q->lock, flags);
 }
 EXPORT_SYMBOL_GPL(__wake_up_sync_key);
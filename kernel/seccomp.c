@@ -33,6 +33,15 @@
 #include <linux/tracehook.h>
 #include <linux/uaccess.h>
 
+/*
+ * The constant-action cache needs to know how many syscall numbers to
+ * cover.  Architectures that don't expose NR_syscalls as a macro here
+ * simply don't get the cache; every syscall runs the filters as before.
+ */
+#ifdef NR_syscalls
+#define SECCOMP_SYSCALL_CACHE
+#endif
+
 /**
  * struct seccomp_filter - container for seccomp BPF programs
  *
@@ -43,6 +52,9 @@
  * @prev: points to a previously installed, or inherited, filter
  * @len: the number of instructions in the program
  * @insnsi: the BPF program instructions to evaluate
+ * @cache_arch: audit arch value the allow cache was computed for
+ * @cache_allow: syscalls this filter and all its ancestors always allow
+ *               regardless of the syscall arguments
  *
  * seccomp_filter objects are organized in a tree linked via the @prev
  * pointer.  For any task, it appears to be a singly-linked list starting
@@ -58,6 +70,10 @@ struct seccomp_filter {
 	atomic_t usage;
 	struct seccomp_filter *prev;
 	struct bpf_prog *prog;
+#ifdef SECCOMP_SYSCALL_CACHE
+	u32 cache_arch;
+	DECLARE_BITMAP(cache_allow, NR_syscalls);
+#endif
 };
 
 /* Limit any path through the tree to 256KB worth of instructions. */
@@ -167,6 +183,128 @@ static int seccomp_check_filter(struct sock_filter *filter, unsigned int flen)
 	return 0;
 }
 
+#ifdef SECCOMP_SYSCALL_CACHE
+/**
+ * seccomp_is_const_allow - check if a filter always allows @sd
+ * @fprog: the original (pre-rewrite) BPF program to evaluate
+ * @sd: the seccomp data to check against; only the syscall number and
+ *      the arch are treated as known constants
+ *
+ * Walks the filter treating the syscall number and arch as the only
+ * known values.  Any instruction that depends on anything else - the
+ * arguments, the instruction pointer, scratch memory - makes the
+ * verdict non-constant and the walk bails out.
+ *
+ * Returns true if the filter provably returns ALLOW for @sd no matter
+ * what the remaining seccomp_data contains.
+ */
+static bool seccomp_is_const_allow(struct sock_fprog_kern *fprog,
+				   struct seccomp_data *sd)
+{
+	unsigned int reg_value = 0;
+	unsigned int pc;
+	bool op_res;
+
+	if (WARN_ON_ONCE(!fprog))
+		return false;
+
+	for (pc = 0; pc < fprog->len; pc++) {
+		struct sock_filter *insn = &fprog->filter[pc];
+		u16 code = insn->code;
+		u32 k = insn->k;
+
+		switch (code) {
+		case BPF_LD | BPF_W | BPF_ABS:
+			switch (k) {
+			case offsetof(struct seccomp_data, nr):
+				reg_value = sd->nr;
+				break;
+			case offsetof(struct seccomp_data, arch):
+				reg_value = sd->arch;
+				break;
+			default:
+				/* can't optimize (non-constant value load) */
+				return false;
+			}
+			break;
+		case BPF_RET | BPF_K:
+			/* reached return with constant values only, check allow */
+			return k == SECCOMP_RET_ALLOW;
+		case BPF_JMP | BPF_JA:
+			pc += insn->k;
+			break;
+		case BPF_JMP | BPF_JEQ | BPF_K:
+		case BPF_JMP | BPF_JGE | BPF_K:
+		case BPF_JMP | BPF_JGT | BPF_K:
+		case BPF_JMP | BPF_JSET | BPF_K:
+			switch (BPF_OP(code)) {
+			case BPF_JEQ:
+				op_res = reg_value == k;
+				break;
+			case BPF_JGE:
+				op_res = reg_value >= k;
+				break;
+			case BPF_JGT:
+				op_res = reg_value > k;
+				break;
+			case BPF_JSET:
+				op_res = !!(reg_value & k);
+				break;
+			default:
+				return false;
+			}
+
+			pc += op_res ? insn->jt : insn->jf;
+			break;
+		default:
+			/* can't optimize (unknown instruction) */
+			return false;
+		}
+	}
+
+	/* ran off the end of the filter?! */
+	WARN_ON(1);
+	return false;
+}
+
+/**
+ * seccomp_cache_prepare - fill in a new filter's constant-allow bitmap
+ * @sfilter: the filter being attached; @prev must already be set
+ *
+ * A bit is set only if this filter and every ancestor allow the syscall
+ * unconditionally, so seccomp_run_filters() need only consult the head
+ * of the list.  The cache is computed for the audit arch the attaching
+ * task is currently using; syscalls made under a different arch (e.g.
+ * compat) fall back to running the filters.
+ *
+ * Called with current->sighand->siglock held.
+ */
+static void seccomp_cache_prepare(struct seccomp_filter *sfilter)
+{
+	struct sock_fprog_kern *fprog = sfilter->prog->orig_prog;
+	struct seccomp_filter *prev = sfilter->prev;
+	struct seccomp_data sd;
+	int nr;
+
+	sfilter->cache_arch = syscall_get_arch();
+	if (prev && prev->cache_arch != sfilter->cache_arch)
+		return;
+
+	sd.arch = sfilter->cache_arch;
+	for (nr = 0; nr < NR_syscalls; nr++) {
+		if (prev && !test_bit(nr, prev->cache_allow))
+			continue;
+		sd.nr = nr;
+		if (seccomp_is_const_allow(fprog, &sd))
+			set_bit(nr, sfilter->cache_allow);
+	}
+}
+#else
+static void seccomp_cache_prepare(struct seccomp_filter *sfilter)
+{
+}
+#endif /* SECCOMP_SYSCALL_CACHE */
+
 /**
  * seccomp_run_filters - evaluates all seccomp filters against @syscall
  * @syscall: number of the current system call
@@ -190,6 +328,17 @@ static u32 seccomp_run_filters(struct seccomp_data *sd)
 		sd = &sd_local;
 	}
 
+#ifdef SECCOMP_SYSCALL_CACHE
+	/*
+	 * The head filter's bitmap already accounts for every filter in
+	 * the list, so an argument-independent allow needs no BPF at all.
+	 */
+	if (likely(sd->nr >= 0 && sd->nr < NR_syscalls &&
+		   sd->arch == f->cache_arch &&
+		   test_bit(sd->nr, f->cache_allow)))
+		return SECCOMP_RET_ALLOW;
+#endif
+
 	/*
 	 * All filters in the list are evaluated and the lowest BPF return
 	 * value always takes priority (ignoring the DATA).
@@ -347,7 +496,12 @@ static struct seccomp_filter *seccomp_prepare_filter(struct sock_fprog *fprog)
 {
 	struct seccomp_filter *sfilter;
 	int ret;
+#ifdef SECCOMP_SYSCALL_CACHE
+	/* seccomp_cache_prepare() emulates the original instructions. */
+	const bool save_orig = true;
+#else
 	const bool save_orig = config_enabled(CONFIG_CHECKPOINT_RESTORE);
+#endif
 
 	if (fprog->len == 0 || fprog->len > BPF_MAXINSNS)
 		return ERR_PTR(-EINVAL);
@@ -448,6 +602,7 @@ static long seccomp_attach_filter(unsigned int flags,
 	 * task reference.
 	 */
 	filter->prev = current->seccomp.filter;
+	seccomp_cache_prepare(filter);
 	current->seccomp.filter = filter;
 
 	/* Now that the new filter is in place, synchronize to all threads. */
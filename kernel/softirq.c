@@ -26,6 +26,8 @@
 #include <linux/smpboot.h>
 #include <linux/tick.h>
 #include <linux/irq.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
 
 #define CREATE_TRACE_POINTS
 #include <trace/events/irq.h>
@@ -62,6 +64,119 @@ const char * const softirq_to_name[NR_SOFTIRQS] = {
 	"TASKLET", "SCHED", "HRTIMER", "RCU"
 };
 
+#ifdef CONFIG_SOFTIRQ_STATS
+/*
+ * Per-vector log2(ns) latency histograms, cheap enough to stay enabled
+ * in production: one clock read when a vector is first raised and two
+ * around each handler invocation.  "wait" is raise-to-handler-start,
+ * "exec" is handler runtime; both are summed over CPUs in the debugfs
+ * file softirq_lat/hist.  A handler running longer than
+ * softirq_lat/budget_ns additionally fires trace_softirq_long_exec.
+ */
+#define SOFTIRQ_LAT_BUCKETS	32
+
+struct softirq_lat {
+	u64 raise_ts[NR_SOFTIRQS];
+	u64 wait_hist[NR_SOFTIRQS][SOFTIRQ_LAT_BUCKETS];
+	u64 exec_hist[NR_SOFTIRQS][SOFTIRQ_LAT_BUCKETS];
+};
+static DEFINE_PER_CPU(struct softirq_lat, softirq_lat);
+
+static u64 softirq_lat_budget_ns __read_mostly;	/* 0 = no threshold event */
+
+static void softirq_lat_bucket(u64 *hist, u64 ns)
+{
+	int b = ns ? min(fls64(ns) - 1, SOFTIRQ_LAT_BUCKETS - 1) : 0;
+
+	hist[b]++;
+}
+
+/* Called with interrupts disabled, before the pending bit is set. */
+static void softirq_lat_raise(unsigned int nr)
+{
+	if (!(local_softirq_pending() & (1UL << nr)))
+		__this_cpu_write(softirq_lat.raise_ts[nr], local_clock());
+}
+
+static u64 softirq_lat_service(unsigned int nr)
+{
+	struct softirq_lat *sl = this_cpu_ptr(&softirq_lat);
+	u64 now = local_clock();
+
+	if (sl->raise_ts[nr] && now > sl->raise_ts[nr])
+		softirq_lat_bucket(sl->wait_hist[nr], now - sl->raise_ts[nr]);
+	sl->raise_ts[nr] = 0;
+	return now;
+}
+
+static void softirq_lat_done(unsigned int nr, u64 exec_start)
+{
+	u64 delta = local_clock() - exec_start;
+
+	softirq_lat_bucket(this_cpu_ptr(&softirq_lat)->exec_hist[nr], delta);
+	if (softirq_lat_budget_ns && delta > softirq_lat_budget_ns)
+		trace_softirq_long_exec(nr, delta);
+}
+
+static int softirq_lat_show(struct seq_file *m, void *v)
+{
+	int vec, b, cpu;
+
+	seq_puts(m, "# log2(ns) histograms summed over cpus; bucket i counts [2^i, 2^(i+1)) ns\n");
+	for (vec = 0; vec < NR_SOFTIRQS; vec++) {
+		u64 wait[SOFTIRQ_LAT_BUCKETS] = { 0 };
+		u64 exec[SOFTIRQ_LAT_BUCKETS] = { 0 };
+
+		for_each_possible_cpu(cpu) {
+			struct softirq_lat *sl = &per_cpu(softirq_lat, cpu);
+
+			for (b = 0; b < SOFTIRQ_LAT_BUCKETS; b++) {
+				wait[b] += sl->wait_hist[vec][b];
+				exec[b] += sl->exec_hist[vec][b];
+			}
+		}
+
+		seq_printf(m, "%-12s wait:", softirq_to_name[vec]);
+		for (b = 0; b < SOFTIRQ_LAT_BUCKETS; b++)
+			seq_printf(m, " %llu", wait[b]);
+		seq_putc(m, '\n');
+		seq_printf(m, "%-12s exec:", softirq_to_name[vec]);
+		for (b = 0; b < SOFTIRQ_LAT_BUCKETS; b++)
+			seq_printf(m, " %llu", exec[b]);
+		seq_putc(m, '\n');
+	}
+	return 0;
+}
+
+static int softirq_lat_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, softirq_lat_show, NULL);
+}
+
+static const struct file_operations softirq_lat_fops = {
+	.open		= softirq_lat_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static int __init softirq_lat_debugfs_init(void)
+{
+	struct dentry *dir = debugfs_create_dir("softirq_lat", NULL);
+
+	if (!dir)
+		return -ENOMEM;
+	debugfs_create_file("hist", 0444, dir, NULL, &softirq_lat_fops);
+	debugfs_create_u64("budget_ns", 0644, dir, &softirq_lat_budget_ns);
+	return 0;
+}
+late_initcall(softirq_lat_debugfs_init);
+#else
+static inline void softirq_lat_raise(unsigned int nr) { }
+static inline u64 softirq_lat_service(unsigned int nr) { return 0; }
+static inline void softirq_lat_done(unsigned int nr, u64 exec_start) { }
+#endif /* CONFIG_SOFTIRQ_STATS */
+
 /*
  * we cannot loop indefinitely here to avoid userspace starvation,
  * but we also don't want to introduce a worst case 1/HZ latency
@@ -261,6 +376,7 @@ restart:
 	while ((softirq_bit = ffs(pending))) {
 		unsigned int vec_nr;
 		int prev_count;
+		u64 exec_start;
 
 		h += softirq_bit - 1;
 
@@ -270,7 +386,9 @@ restart:
 		kstat_incr_softirqs_this_cpu(vec_nr);
 
 		trace_softirq_entry(vec_nr);
+		exec_start = softirq_lat_service(vec_nr);
 		h->action(h);
+		softirq_lat_done(vec_nr, exec_start);
 		trace_softirq_exit(vec_nr);
 		if (unlikely(prev_count != preempt_count())) {
 			pr_err("huh, entered softirq %u %s %p with preempt_count %08x, exited with %08x?\n",
@@ -427,6 +545,7 @@ void raise_softirq(unsigned int nr)
 void __raise_softirq_irqoff(unsigned int nr)
 {
 	trace_softirq_raise(nr);
+	softirq_lat_raise(nr);
 	or_softirq_pending(1UL << nr);
 }
 
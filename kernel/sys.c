@@ -10,6 +10,7 @@
 #include <linux/mman.h>
 #include <linux/reboot.h>
 #include <linux/prctl.h>
+#include <linux/futex.h>
 #include <linux/highuid.h>
 #include <linux/fs.h>
 #include <linux/kmod.h>
@@ -47,6 +48,7 @@
 #include <linux/kprobes.h>
 #include <linux/user_namespace.h>
 #include <linux/binfmts.h>
+#include <linux/isolation.h>
 
 #include <linux/sched.h>
 #include <linux/rcupdate.h>
@@ -2269,6 +2271,26 @@ SYSCALL_DEFINE5(prctl, int, option, unsigned long, arg2, unsigned long, arg3,
 	case PR_GET_FP_MODE:
 		error = GET_FP_MODE(me);
 		break;
+	case PR_SET_TASK_ISOLATION:
+		if (arg3 || arg4 || arg5)
+			return -EINVAL;
+		error = task_isolation_set(arg2);
+		break;
+	case PR_GET_TASK_ISOLATION:
+		if (arg2 || arg3 || arg4 || arg5)
+			return -EINVAL;
+		error = task_isolation_get();
+		break;
+	case PR_SET_FUTEX_HASH_SLOTS:
+		if (arg3 || arg4 || arg5)
+			return -EINVAL;
+		error = futex_hash_allocate(arg2);
+		break;
+	case PR_GET_FUTEX_HASH_SLOTS:
+		if (arg2 || arg3 || arg4 || arg5)
+			return -EINVAL;
+		error = futex_hash_get_slots();
+		break;
 	default:
 		error = -EINVAL;
 		break;
@@ -23,6 +23,7 @@
 #include <linux/irq_work.h>
 #include <linux/posix-timers.h>
 #include <linux/context_tracking.h>
+#include <linux/isolation.h>
 
 #include <asm/irq_regs.h>
 
@@ -146,6 +147,13 @@ static void tick_sched_handle(struct tick_sched *ts, struct pt_regs *regs)
 		touch_softlockup_watchdog_sched();
 		if (is_idle_task(current))
 			ts->idle_jiffies++;
+		else
+			/*
+			 * A tick on a tick-stopped cpu is exactly the kind
+			 * of interruption an isolated task asked to hear
+			 * about.
+			 */
+			task_isolation_interrupt(current, "tick");
 	}
 #endif
 	update_process_times(user_mode(regs));
@@ -300,6 +300,7 @@ struct buffer_page {
 	unsigned	 read;		/* index for next read */
 	local_t		 entries;	/* entries on this page */
 	unsigned long	 real_end;	/* real end of data */
+	u32		 id;		/* slot in a user mapping */
 	struct buffer_data_page *page;	/* Actual data page */
 };
 
@@ -457,6 +458,11 @@ struct ring_buffer_per_cpu {
 	unsigned long			read_bytes;
 	u64				write_stamp;
 	u64				read_stamp;
+	/* user space mapping of the data pages, see ring_buffer_map() */
+	int				mapped;
+	unsigned int			mapped_read;
+	struct buffer_page		**page_slots; /* id -> page */
+	struct trace_buffer_meta	*meta_page;
 	/* ring buffer pages to update, > 0 to add, < 0 to remove */
 	int				nr_pages_to_update;
 	struct list_head		new_pages; /* new pages to add */
@@ -1676,6 +1682,15 @@ int ring_buffer_resize(struct ring_buffer *buffer, unsigned long size,
 	/* prevent another thread from changing buffer sizes */
 	mutex_lock(&buffer->mutex);
 
+	/* a user space mapping pins the pages of the buffers it maps */
+	for_each_buffer_cpu(buffer, cpu) {
+		if ((cpu_id == RING_BUFFER_ALL_CPUS || cpu_id == cpu) &&
+		    buffer->buffers[cpu]->mapped) {
+			err = -EBUSY;
+			goto out_err;
+		}
+	}
+
 	if (cpu_id == RING_BUFFER_ALL_CPUS) {
 		/* calculate the pages to update */
 		for_each_buffer_cpu(buffer, cpu) {
@@ -4343,6 +4358,11 @@ int ring_buffer_swap_cpu(struct ring_buffer *buffer_a,
 	if (cpu_buffer_a->nr_pages != cpu_buffer_b->nr_pages)
 		goto out;
 
+	/* user space mappings would be left pointing into the wrong buffer */
+	ret = -EBUSY;
+	if (cpu_buffer_a->mapped || cpu_buffer_b->mapped)
+		goto out;
+
 	ret = -EAGAIN;
 
 	if (atomic_read(&buffer_a->record_disabled))
@@ -4519,12 +4539,15 @@ int ring_buffer_read_page(struct ring_buffer *buffer,
 	/*
 	 * If this page has been partially read or
 	 * if len is not big enough to read the rest of the page or
-	 * a writer is still on the page, then
+	 * a writer is still on the page or
+	 * the page is mapped to user space (swapping the data page
+	 * out would yank it from under the mapping), then
 	 * we must copy the data from the page to the buffer.
 	 * Otherwise, we can simply swap the page with the one passed in.
 	 */
 	if (read || (len < (commit - read)) ||
-	    cpu_buffer->reader_page == cpu_buffer->commit_page) {
+	    cpu_buffer->reader_page == cpu_buffer->commit_page ||
+	    cpu_buffer->mapped) {
 		struct buffer_data_page *rpage = cpu_buffer->reader_page->page;
 		unsigned int rpos = read;
 		unsigned int pos = 0;
@@ -4633,6 +4656,226 @@ int ring_buffer_read_page(struct ring_buffer *buffer,
 }
 EXPORT_SYMBOL_GPL(ring_buffer_read_page);
 
+static void rb_update_meta_page(struct ring_buffer_per_cpu *cpu_buffer)
+{
+	struct trace_buffer_meta *meta = cpu_buffer->meta_page;
+	struct buffer_page *reader = cpu_buffer->reader_page;
+
+	meta->reader_id = reader->id;
+	meta->reader_read = reader->read;
+	meta->reader_commit = cpu_buffer->mapped_read;
+	meta->entries = local_read(&cpu_buffer->entries);
+	meta->overrun = local_read(&cpu_buffer->overrun);
+}
+
+/**
+ * ring_buffer_map - prepare a per cpu buffer for user space mapping
+ * @buffer: the buffer to map
+ * @cpu: the cpu buffer to map
+ *
+ * Assigns every page of the cpu buffer a stable mapping slot, recorded
+ * in the page itself, and allocates the meta page that publishes the
+ * current reader page to user space. The slots survive reader page
+ * swaps because those only exchange the roles of the pages, never the
+ * pages themselves; ring_buffer_read_page() stops swapping data pages
+ * out of a mapped buffer for the same reason.
+ *
+ * While mapped the buffer can not be resized or swapped out from under
+ * the mapping by ring_buffer_swap_cpu().
+ */
+int ring_buffer_map(struct ring_buffer *buffer, int cpu)
+{
+	struct ring_buffer_per_cpu *cpu_buffer;
+	struct trace_buffer_meta *meta;
+	struct buffer_page **slots;
+	struct buffer_page *bpage;
+	unsigned long flags;
+	unsigned int id;
+	int ret = 0;
+
+	if (!cpumask_test_cpu(cpu, buffer->cpumask))
+		return -EINVAL;
+
+	cpu_buffer = buffer->buffers[cpu];
+
+	/* the mutex also keeps resizers away while slots are assigned */
+	mutex_lock(&buffer->mutex);
+
+	if (cpu_buffer->mapped) {
+		cpu_buffer->mapped++;
+		goto out;
+	}
+
+	meta = (void *)get_zeroed_page(GFP_KERNEL);
+	if (!meta) {
+		ret = -ENOMEM;
+		goto out;
+	}
+
+	slots = kcalloc(cpu_buffer->nr_pages + 1, sizeof(*slots), GFP_KERNEL);
+	if (!slots) {
+		free_page((unsigned long)meta);
+		ret = -ENOMEM;
+		goto out;
+	}
+
+	raw_spin_lock_irqsave(&cpu_buffer->reader_lock, flags);
+
+	id = 0;
+	cpu_buffer->reader_page->id = id;
+	slots[id++] = cpu_buffer->reader_page;
+
+	bpage = list_entry(rb_list_head(cpu_buffer->pages),
+			   struct buffer_page, list);
+	while (id <= cpu_buffer->nr_pages) {
+		bpage->id = id;
+		slots[id++] = bpage;
+		bpage = list_entry(rb_list_head(bpage->list.next),
+				   struct buffer_page, list);
+	}
+
+	meta->meta_page_size = PAGE_SIZE;
+	meta->nr_data_pages = cpu_buffer->nr_pages + 1;
+
+	cpu_buffer->page_slots = slots;
+	cpu_buffer->meta_page = meta;
+	/* nothing is published until the first GET_READER */
+	cpu_buffer->mapped_read = cpu_buffer->reader_page->read;
+	rb_update_meta_page(cpu_buffer);
+	cpu_buffer->mapped = 1;
+
+	raw_spin_unlock_irqrestore(&cpu_buffer->reader_lock, flags);
+ out:
+	mutex_unlock(&buffer->mutex);
+	return ret;
+}
+EXPORT_SYMBOL_GPL(ring_buffer_map);
+
+/**
+ * ring_buffer_unmap - drop a user space mapping of a per cpu buffer
+ * @buffer: the buffer to unmap
+ * @cpu: the cpu buffer to unmap
+ *
+ * Drops the reference taken by ring_buffer_map() and releases the meta
+ * page and slot table once the last mapping is gone.
+ */
+void ring_buffer_unmap(struct ring_buffer *buffer, int cpu)
+{
+	struct ring_buffer_per_cpu *cpu_buffer;
+	struct trace_buffer_meta *meta;
+	struct buffer_page **slots;
+	unsigned long flags;
+
+	if (!cpumask_test_cpu(cpu, buffer->cpumask))
+		return;
+
+	cpu_buffer = buffer->buffers[cpu];
+
+	mutex_lock(&buffer->mutex);
+
+	if (WARN_ON_ONCE(!cpu_buffer->mapped) || --cpu_buffer->mapped) {
+		mutex_unlock(&buffer->mutex);
+		return;
+	}
+
+	raw_spin_lock_irqsave(&cpu_buffer->reader_lock, flags);
+	meta = cpu_buffer->meta_page;
+	slots = cpu_buffer->page_slots;
+	cpu_buffer->meta_page = NULL;
+	cpu_buffer->page_slots = NULL;
+	raw_spin_unlock_irqrestore(&cpu_buffer->reader_lock, flags);
+
+	free_page((unsigned long)meta);
+	kfree(slots);
+
+	mutex_unlock(&buffer->mutex);
+}
+EXPORT_SYMBOL_GPL(ring_buffer_unmap);
+
+/**
+ * ring_buffer_map_fault - page of a mapped cpu buffer at a given offset
+ * @buffer: the mapped buffer
+ * @cpu: the mapped cpu buffer
+ * @pgoff: page offset into the mapping
+ *
+ * Offset 0 is the meta page, the data page slots follow.
+ *
+ * Returns the page to install in the mapping, or NULL if @pgoff is
+ * outside the mapping or the buffer is not mapped.
+ */
+struct page *ring_buffer_map_fault(struct ring_buffer *buffer, int cpu,
+				   unsigned long pgoff)
+{
+	struct ring_buffer_per_cpu *cpu_buffer;
+	struct page *page = NULL;
+	unsigned long flags;
+
+	if (!cpumask_test_cpu(cpu, buffer->cpumask))
+		return NULL;
+
+	cpu_buffer = buffer->buffers[cpu];
+
+	raw_spin_lock_irqsave(&cpu_buffer->reader_lock, flags);
+
+	if (!cpu_buffer->mapped || pgoff > cpu_buffer->nr_pages + 1)
+		goto out;
+
+	if (!pgoff)
+		page = virt_to_page(cpu_buffer->meta_page);
+	else
+		page = virt_to_page(cpu_buffer->page_slots[pgoff - 1]->page);
+ out:
+	raw_spin_unlock_irqrestore(&cpu_buffer->reader_lock, flags);
+
+	return page;
+}
+EXPORT_SYMBOL_GPL(ring_buffer_map_fault);
+
+/**
+ * ring_buffer_map_get_reader - publish the next window of trace data
+ * @buffer: the mapped buffer
+ * @cpu: the mapped cpu buffer
+ *
+ * Consumes the window published by the previous call, advancing the
+ * reader one event at a time so the read counters stay exact, swaps the
+ * next ring page in as the reader page once the current one is
+ * exhausted, and publishes the new reader window in the meta page.
+ */
+int ring_buffer_map_get_reader(struct ring_buffer *buffer, int cpu)
+{
+	struct ring_buffer_per_cpu *cpu_buffer;
+	struct buffer_page *reader;
+	unsigned long flags;
+
+	if (!cpumask_test_cpu(cpu, buffer->cpumask))
+		return -EINVAL;
+
+	cpu_buffer = buffer->buffers[cpu];
+
+	raw_spin_lock_irqsave(&cpu_buffer->reader_lock, flags);
+
+	if (!cpu_buffer->mapped) {
+		raw_spin_unlock_irqrestore(&cpu_buffer->reader_lock, flags);
+		return -ENODEV;
+	}
+
+	reader = cpu_buffer->reader_page;
+	while (cpu_buffer->reader_page == reader &&
+	       reader->read < cpu_buffer->mapped_read)
+		rb_advance_reader(cpu_buffer);
+
+	/* pull in the next page if the last one is exhausted */
+	rb_get_reader_page(cpu_buffer);
+
+	cpu_buffer->mapped_read = rb_page_size(cpu_buffer->reader_page);
+	rb_update_meta_page(cpu_buffer);
+
+	raw_spin_unlock_irqrestore(&cpu_buffer->reader_lock, flags);
+
+	return 0;
+}
+EXPORT_SYMBOL_GPL(ring_buffer_map_get_reader);
+
 #ifdef CONFIG_HOTPLUG_CPU
 static int rb_cpu_notify(struct notifier_block *self,
 			 unsigned long action, void *hcpu)
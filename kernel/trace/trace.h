@@ -1182,6 +1182,9 @@ extern int event_trigger_init(struct event_trigger_ops *ops,
 extern int trace_event_trigger_enable_disable(struct trace_event_file *file,
 					      int trigger_enable);
 extern void update_cond_flag(struct trace_event_file *file);
+extern int register_trigger(char *glob, struct event_trigger_ops *ops,
+			    struct event_trigger_data *data,
+			    struct trace_event_file *file);
 extern void unregister_trigger(char *glob, struct event_trigger_ops *ops,
 			       struct event_trigger_data *test,
 			       struct trace_event_file *file);
@@ -1190,6 +1193,13 @@ extern int set_trigger_filter(char *filter_str,
 			      struct trace_event_file *file);
 extern int register_event_command(struct event_command *cmd);
 
+#ifdef CONFIG_HIST_TRIGGERS
+extern const struct file_operations event_hist_fops;
+extern int register_trigger_hist_cmd(void);
+#else
+static inline int register_trigger_hist_cmd(void) { return 0; }
+#endif
+
 /**
  * struct event_trigger_ops - callbacks for trace event triggers
  *
@@ -297,6 +297,35 @@ void *perf_trace_buf_prepare(int size, unsigned short type,
 EXPORT_SYMBOL_GPL(perf_trace_buf_prepare);
 NOKPROBE_SYMBOL(perf_trace_buf_prepare);
 
+void perf_trace_run_bpf_submit(void *raw_data, int size, int rctx,
+			       struct trace_event_call *call, u64 addr,
+			       u64 count, struct pt_regs *regs, void *head,
+			       struct task_struct *task)
+{
+	if (call->prog) {
+		/*
+		 * The first eight bytes of the record (the common type,
+		 * flags, preempt count and pid) double as the pt_regs
+		 * pointer for bpf_perf_event_output() and friends while
+		 * the program runs; stash them and put the header back
+		 * before the record is delivered.
+		 */
+		u64 entry_head = *(u64 *)raw_data;
+
+		BUILD_BUG_ON(sizeof(struct trace_entry) != sizeof(u64));
+
+		*(struct pt_regs **)raw_data = regs;
+		if (!trace_call_bpf(call->prog, raw_data)) {
+			perf_swevent_put_recursion_context(rctx);
+			return;
+		}
+		*(u64 *)raw_data = entry_head;
+	}
+	perf_trace_buf_submit(raw_data, size, rctx, addr, count, regs, head,
+			      task);
+}
+EXPORT_SYMBOL_GPL(perf_trace_run_bpf_submit);
+
 #ifdef CONFIG_FUNCTION_TRACER
 static void
 perf_ftrace_function_call(unsigned long ip, unsigned long parent_ip,
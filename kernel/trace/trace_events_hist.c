@@ -0,0 +1,674 @@
+/*
+ * trace_events_hist - trace event hist triggers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * A hist trigger aggregates events into an in-kernel hash table
+ * instead of (or in addition to) logging each one to the trace
+ * buffer.  The table is keyed on one or more event fields and each
+ * entry accumulates a hit count plus optional sums of numeric value
+ * fields.  The result is readable as text from the 'hist' file in
+ * the event directory, so a latency or size distribution can be kept
+ * always-on without streaming individual events to userspace.
+ */
+
+#include <linux/module.h>
+#include <linux/mutex.h>
+#include <linux/slab.h>
+#include <linux/vmalloc.h>
+#include <linux/jhash.h>
+#include <linux/sort.h>
+
+#include "trace.h"
+
+/*
+ * Compound keys are assembled into a fixed-size buffer; numeric key
+ * fields take eight bytes each and string key fields are padded to a
+ * multiple of eight so that following numeric fields stay aligned.
+ */
+#define HIST_KEY_SIZE_MAX	64
+#define HIST_KEY_STRING_MAX	32
+#define HIST_KEY_FIELDS_MAX	3
+#define HIST_VAL_FIELDS_MAX	2
+
+#define HIST_MAP_SIZE_DEFAULT	2048
+#define HIST_MAP_SIZE_MIN	128
+#define HIST_MAP_SIZE_MAX	131072
+
+enum hist_ent_state {
+	HIST_ENT_FREE	= 0,	/* slot unclaimed */
+	HIST_ENT_BUSY,		/* key being installed by another CPU */
+	HIST_ENT_READY,		/* key valid, counters live */
+};
+
+struct hist_ent {
+	atomic64_t		hitcount;
+	atomic64_t		sums[HIST_VAL_FIELDS_MAX];
+	atomic_t		state;
+	char			key[HIST_KEY_SIZE_MAX];
+};
+
+struct hist_field;
+
+typedef u64 (*hist_field_fn_t)(struct hist_field *field, void *event);
+
+struct hist_field {
+	struct ftrace_event_field	*field;
+	hist_field_fn_t			fn;
+	unsigned int			size;	/* bytes in the compound key */
+	unsigned int			offset;	/* offset in the compound key */
+	bool				is_string;
+};
+
+struct hist_trigger_data {
+	struct hist_field	*key_fields[HIST_KEY_FIELDS_MAX];
+	unsigned int		n_keys;
+	struct hist_field	*val_fields[HIST_VAL_FIELDS_MAX];
+	unsigned int		n_vals;
+	unsigned int		key_size;
+	unsigned int		map_size;	/* power of two */
+	struct hist_ent		*map;
+	atomic64_t		drops;
+	char			*cmd_str;	/* for trigger/hist file output */
+};
+
+#define DEFINE_HIST_FIELD_FN(type)					\
+static u64 hist_field_##type(struct hist_field *hist_field, void *event)\
+{									\
+	type *addr = (type *)(event + hist_field->field->offset);	\
+									\
+	return (u64)*addr;						\
+}
+
+DEFINE_HIST_FIELD_FN(s64);
+DEFINE_HIST_FIELD_FN(u64);
+DEFINE_HIST_FIELD_FN(s32);
+DEFINE_HIST_FIELD_FN(u32);
+DEFINE_HIST_FIELD_FN(s16);
+DEFINE_HIST_FIELD_FN(u16);
+DEFINE_HIST_FIELD_FN(s8);
+DEFINE_HIST_FIELD_FN(u8);
+
+static hist_field_fn_t select_value_fn(int field_size, int field_is_signed)
+{
+	hist_field_fn_t fn = NULL;
+
+	switch (field_size) {
+	case 8:
+		fn = field_is_signed ? hist_field_s64 : hist_field_u64;
+		break;
+	case 4:
+		fn = field_is_signed ? hist_field_s32 : hist_field_u32;
+		break;
+	case 2:
+		fn = field_is_signed ? hist_field_s16 : hist_field_u16;
+		break;
+	case 1:
+		fn = field_is_signed ? hist_field_s8 : hist_field_u8;
+		break;
+	}
+
+	return fn;
+}
+
+static struct hist_field *create_hist_field(struct ftrace_event_field *field)
+{
+	struct hist_field *hist_field;
+
+	hist_field = kzalloc(sizeof(*hist_field), GFP_KERNEL);
+	if (!hist_field)
+		return NULL;
+
+	hist_field->field = field;
+
+	if (is_string_field(field)) {
+		hist_field->is_string = true;
+		hist_field->size = min_t(unsigned int, field->size,
+					 HIST_KEY_STRING_MAX);
+		hist_field->size = round_up(hist_field->size, sizeof(u64));
+	} else {
+		hist_field->size = sizeof(u64);
+		hist_field->fn = select_value_fn(field->size,
+						 field->is_signed);
+		if (!hist_field->fn) {
+			kfree(hist_field);
+			return NULL;
+		}
+	}
+
+	return hist_field;
+}
+
+static void destroy_hist_data(struct hist_trigger_data *hist_data)
+{
+	unsigned int i;
+
+	for (i = 0; i < hist_data->n_keys; i++)
+		kfree(hist_data->key_fields[i]);
+	for (i = 0; i < hist_data->n_vals; i++)
+		kfree(hist_data->val_fields[i]);
+
+	vfree(hist_data->map);
+	kfree(hist_data->cmd_str);
+	kfree(hist_data);
+}
+
+static int parse_hist_keys(struct hist_trigger_data *hist_data,
+			   struct trace_event_call *call, char *key_str)
+{
+	struct ftrace_event_field *field;
+	struct hist_field *hist_field;
+	unsigned int key_offset = 0;
+	char *field_name;
+
+	while ((field_name = strsep(&key_str, ",")) != NULL) {
+		if (!strlen(field_name))
+			return -EINVAL;
+
+		if (hist_data->n_keys == HIST_KEY_FIELDS_MAX)
+			return -EINVAL;
+
+		field = trace_find_event_field(call, field_name);
+		if (!field || is_function_field(field))
+			return -EINVAL;
+
+		/*
+		 * A pointer-string key would mean dereferencing an
+		 * arbitrary address at event time; don't allow it.
+		 */
+		if (field->filter_type == FILTER_PTR_STRING)
+			return -EINVAL;
+
+		hist_field = create_hist_field(field);
+		if (!hist_field)
+			return -EINVAL;
+
+		hist_field->offset = key_offset;
+		key_offset += hist_field->size;
+		if (key_offset > HIST_KEY_SIZE_MAX) {
+			kfree(hist_field);
+			return -EINVAL;
+		}
+
+		hist_data->key_fields[hist_data->n_keys++] = hist_field;
+	}
+
+	if (!hist_data->n_keys)
+		return -EINVAL;
+
+	hist_data->key_size = key_offset;
+
+	return 0;
+}
+
+static int parse_hist_vals(struct hist_trigger_data *hist_data,
+			   struct trace_event_call *call, char *val_str)
+{
+	struct ftrace_event_field *field;
+	struct hist_field *hist_field;
+	char *field_name;
+
+	while ((field_name = strsep(&val_str, ",")) != NULL) {
+		if (!strlen(field_name))
+			return -EINVAL;
+
+		/* The hit count is always accumulated */
+		if (strcmp(field_name, "hitcount") == 0)
+			continue;
+
+		if (hist_data->n_vals == HIST_VAL_FIELDS_MAX)
+			return -EINVAL;
+
+		field = trace_find_event_field(call, field_name);
+		if (!field || is_function_field(field) ||
+		    is_string_field(field))
+			return -EINVAL;
+
+		hist_field = create_hist_field(field);
+		if (!hist_field)
+			return -EINVAL;
+
+		hist_data->val_fields[hist_data->n_vals++] = hist_field;
+	}
+
+	return 0;
+}
+
+static struct hist_trigger_data *
+create_hist_data(struct trace_event_file *file, char *attrs)
+{
+	struct trace_event_call *call = file->event_call;
+	struct hist_trigger_data *hist_data;
+	unsigned long map_size = HIST_MAP_SIZE_DEFAULT;
+	char *attr;
+	int ret = -EINVAL;
+
+	hist_data = kzalloc(sizeof(*hist_data), GFP_KERNEL);
+	if (!hist_data)
+		return ERR_PTR(-ENOMEM);
+
+	hist_data->cmd_str = kstrdup(attrs, GFP_KERNEL);
+	if (!hist_data->cmd_str) {
+		ret = -ENOMEM;
+		goto free;
+	}
+
+	while ((attr = strsep(&attrs, ":")) != NULL) {
+		if (strncmp(attr, "keys=", 5) == 0)
+			ret = parse_hist_keys(hist_data, call, attr + 5);
+		else if (strncmp(attr, "vals=", 5) == 0)
+			ret = parse_hist_vals(hist_data, call, attr + 5);
+		else if (strncmp(attr, "size=", 5) == 0)
+			ret = kstrtoul(attr + 5, 0, &map_size);
+		else
+			ret = -EINVAL;
+		if (ret)
+			goto free;
+	}
+
+	if (!hist_data->n_keys) {
+		ret = -EINVAL;
+		goto free;
+	}
+
+	if (map_size < HIST_MAP_SIZE_MIN || map_size > HIST_MAP_SIZE_MAX) {
+		ret = -EINVAL;
+		goto free;
+	}
+	hist_data->map_size = roundup_pow_of_two(map_size);
+
+	hist_data->map = vzalloc(hist_data->map_size *
+				 sizeof(struct hist_ent));
+	if (!hist_data->map) {
+		ret = -ENOMEM;
+		goto free;
+	}
+
+	return hist_data;
+ free:
+	destroy_hist_data(hist_data);
+	return ERR_PTR(ret);
+}
+
+/*
+ * Find or create the entry for @key and fold the current event into
+ * it.  Insertion is lock-free: a slot is claimed with a cmpxchg on
+ * its state, the key is copied in, and the slot is then marked ready.
+ * A prober that finds a slot mid-installation waits briefly for it to
+ * become ready; the wait is bounded because the installer may have
+ * been interrupted on this very CPU by the event we're handling now.
+ */
+static void hist_trigger_update(struct hist_trigger_data *hist_data,
+				void *key, void *rec)
+{
+	unsigned int mask = hist_data->map_size - 1;
+	unsigned int idx, probes, spins;
+	struct hist_ent *ent;
+	unsigned int i;
+	int state;
+
+	idx = jhash(key, hist_data->key_size, 0) & mask;
+
+	for (probes = 0; probes < hist_data->map_size; probes++) {
+		ent = &hist_data->map[idx];
+		idx = (idx + 1) & mask;
+
+		state = atomic_read(&ent->state);
+		if (state == HIST_ENT_FREE) {
+			if (atomic_cmpxchg(&ent->state, HIST_ENT_FREE,
+					   HIST_ENT_BUSY) == HIST_ENT_FREE) {
+				memcpy(ent->key, key, hist_data->key_size);
+				/* order the key against the ready state */
+				smp_wmb();
+				atomic_set(&ent->state, HIST_ENT_READY);
+				goto update;
+			}
+			state = atomic_read(&ent->state);
+		}
+
+		if (state == HIST_ENT_BUSY) {
+			spins = 1000;
+			while (atomic_read(&ent->state) == HIST_ENT_BUSY &&
+			       --spins)
+				cpu_relax();
+			if (atomic_read(&ent->state) != HIST_ENT_READY)
+				break;
+		}
+
+		/* pairs with the smp_wmb() above */
+		smp_rmb();
+		if (memcmp(ent->key, key, hist_data->key_size) == 0)
+			goto update;
+	}
+
+	atomic64_inc(&hist_data->drops);
+	return;
+
+ update:
+	atomic64_inc(&ent->hitcount);
+	for (i = 0; i < hist_data->n_vals; i++) {
+		struct hist_field *hist_field = hist_data->val_fields[i];
+
+		atomic64_add(hist_field->fn(hist_field, rec), &ent->sums[i]);
+	}
+}
+
+static void event_hist_trigger(struct event_trigger_data *data, void *rec)
+{
+	struct hist_trigger_data *hist_data = data->private_data;
+	char compound_key[HIST_KEY_SIZE_MAX];
+	unsigned int i;
+
+	if (!rec)
+		return;
+
+	memset(compound_key, 0, hist_data->key_size);
+
+	for (i = 0; i < hist_data->n_keys; i++) {
+		struct hist_field *key_field = hist_data->key_fields[i];
+		char *key = compound_key + key_field->offset;
+
+		if (key_field->is_string) {
+			struct ftrace_event_field *field = key_field->field;
+			char *str = rec + field->offset;
+
+			if (field->filter_type == FILTER_DYN_STRING) {
+				u32 str_item = *(u32 *)str;
+
+				str = rec + (str_item & 0xffff);
+			}
+			strncpy(key, str, key_field->size - 1);
+		} else
+			*(u64 *)key = key_field->fn(key_field, rec);
+	}
+
+	hist_trigger_update(hist_data, compound_key, rec);
+}
+
+static int hist_ent_cmp_hits(const void *a, const void *b)
+{
+	struct hist_ent *ent_a = *(struct hist_ent **)a;
+	struct hist_ent *ent_b = *(struct hist_ent **)b;
+	u64 hits_a = atomic64_read(&ent_a->hitcount);
+	u64 hits_b = atomic64_read(&ent_b->hitcount);
+
+	if (hits_b > hits_a)
+		return 1;
+	if (hits_b < hits_a)
+		return -1;
+
+	return 0;
+}
+
+static void hist_ent_print(struct seq_file *m,
+			   struct hist_trigger_data *hist_data,
+			   struct hist_ent *ent)
+{
+	unsigned int i;
+
+	seq_puts(m, "{ ");
+
+	for (i = 0; i < hist_data->n_keys; i++) {
+		struct hist_field *key_field = hist_data->key_fields[i];
+
+		if (i > 0)
+			seq_puts(m, ", ");
+
+		if (key_field->is_string)
+			seq_printf(m, "%s: %-32s", key_field->field->name,
+				   ent->key + key_field->offset);
+		else if (key_field->field->is_signed)
+			seq_printf(m, "%s: %10lld", key_field->field->name,
+				   (s64)*(u64 *)(ent->key + key_field->offset));
+		else
+			seq_printf(m, "%s: %10llu", key_field->field->name,
+				   *(u64 *)(ent->key + key_field->offset));
+	}
+
+	seq_printf(m, " } hitcount: %10llu",
+		   (u64)atomic64_read(&ent->hitcount));
+
+	for (i = 0; i < hist_data->n_vals; i++)
+		seq_printf(m, "  %s: %10llu",
+			   hist_data->val_fields[i]->field->name,
+			   (u64)atomic64_read(&ent->sums[i]));
+
+	seq_putc(m, '\n');
+}
+
+static int hist_trigger_show(struct seq_file *m,
+			     struct event_trigger_data *data)
+{
+	struct hist_trigger_data *hist_data = data->private_data;
+	struct hist_ent **entries;
+	u64 total_hits = 0;
+	unsigned int n_entries = 0;
+	unsigned int i;
+
+	seq_puts(m, "# event histogram\n#\n# trigger info: ");
+	data->ops->print(m, data->ops, data);
+	seq_puts(m, "#\n");
+
+	entries = vmalloc(hist_data->map_size * sizeof(*entries));
+	if (!entries)
+		return -ENOMEM;
+
+	for (i = 0; i < hist_data->map_size; i++) {
+		struct hist_ent *ent = &hist_data->map[i];
+
+		if (atomic_read(&ent->state) == HIST_ENT_READY)
+			entries[n_entries++] = ent;
+	}
+
+	sort(entries, n_entries, sizeof(struct hist_ent *),
+	     hist_ent_cmp_hits, NULL);
+
+	for (i = 0; i < n_entries; i++) {
+		hist_ent_print(m, hist_data, entries[i]);
+		total_hits += atomic64_read(&entries[i]->hitcount);
+	}
+
+	vfree(entries);
+
+	seq_printf(m, "\nTotals:\n    Hits: %llu\n    Entries: %u\n"
+		   "    Dropped: %llu\n", total_hits, n_entries,
+		   (u64)atomic64_read(&hist_data->drops));
+
+	return 0;
+}
+
+static int hist_show(struct seq_file *m, void *v)
+{
+	struct event_trigger_data *data;
+	struct trace_event_file *event_file;
+	int ret = 0;
+
+	mutex_lock(&event_mutex);
+
+	event_file = event_file_data(m->private);
+	if (unlikely(!event_file)) {
+		ret = -ENODEV;
+		goto out_unlock;
+	}
+
+	list_for_each_entry_rcu(data, &event_file->triggers, list) {
+		if (data->cmd_ops->trigger_type == ETT_EVENT_HIST) {
+			ret = hist_trigger_show(m, data);
+			break;
+		}
+	}
+
+ out_unlock:
+	mutex_unlock(&event_mutex);
+
+	return ret;
+}
+
+static int event_hist_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, hist_show, file);
+}
+
+const struct file_operations event_hist_fops = {
+	.open = event_hist_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+static int event_hist_trigger_print(struct seq_file *m,
+				    struct event_trigger_ops *ops,
+				    struct event_trigger_data *data)
+{
+	struct hist_trigger_data *hist_data = data->private_data;
+
+	seq_printf(m, "hist:%s", hist_data->cmd_str);
+
+	if (data->filter_str)
+		seq_printf(m, " if %s\n", data->filter_str);
+	else
+		seq_putc(m, '\n');
+
+	return 0;
+}
+
+static void event_hist_trigger_free(struct event_trigger_ops *ops,
+				    struct event_trigger_data *data)
+{
+	struct hist_trigger_data *hist_data = data->private_data;
+
+	if (WARN_ON_ONCE(data->ref <= 0))
+		return;
+
+	data->ref--;
+	if (!data->ref) {
+		/* trigger_data_free() waits for running triggers */
+		trigger_data_free(data);
+		destroy_hist_data(hist_data);
+	}
+}
+
+static struct event_trigger_ops event_hist_trigger_ops = {
+	.func			= event_hist_trigger,
+	.print			= event_hist_trigger_print,
+	.init			= event_trigger_init,
+	.free			= event_hist_trigger_free,
+};
+
+static struct event_trigger_ops *
+event_hist_get_trigger_ops(char *cmd, char *param)
+{
+	return &event_hist_trigger_ops;
+}
+
+static int
+event_hist_trigger_func(struct event_command *cmd_ops,
+			struct trace_event_file *file,
+			char *glob, char *cmd, char *param)
+{
+	struct hist_trigger_data *hist_data = NULL;
+	struct event_trigger_data *trigger_data;
+	struct event_trigger_ops *trigger_ops;
+	char *trigger;
+	int ret;
+
+	if (!param)
+		return -EINVAL;
+
+	/* separate the trigger from the filter (k=v:k=v [if filter]) */
+	trigger = strsep(&param, " \t");
+	if (!trigger)
+		return -EINVAL;
+
+	trigger_ops = cmd_ops->get_trigger_ops(cmd, trigger);
+
+	ret = -ENOMEM;
+	trigger_data = kzalloc(sizeof(*trigger_data), GFP_KERNEL);
+	if (!trigger_data)
+		goto out;
+
+	trigger_data->count = -1;
+	trigger_data->ops = trigger_ops;
+	trigger_data->cmd_ops = cmd_ops;
+	INIT_LIST_HEAD(&trigger_data->list);
+	RCU_INIT_POINTER(trigger_data->filter, NULL);
+
+	if (glob[0] == '!') {
+		cmd_ops->unreg(glob+1, trigger_ops, trigger_data, file);
+		kfree(trigger_data);
+		ret = 0;
+		goto out;
+	}
+
+	hist_data = create_hist_data(file, trigger);
+	if (IS_ERR(hist_data)) {
+		ret = PTR_ERR(hist_data);
+		hist_data = NULL;
+		goto out_free;
+	}
+
+	trigger_data->private_data = hist_data;
+
+	if (!param) /* if param is non-empty, it's supposed to be a filter */
+		goto out_reg;
+
+	if (!cmd_ops->set_filter)
+		goto out_reg;
+
+	ret = cmd_ops->set_filter(param, trigger_data, file);
+	if (ret < 0)
+		goto out_free;
+
+ out_reg:
+	ret = cmd_ops->reg(glob, trigger_ops, trigger_data, file);
+	/*
+	 * The above returns on success the # of triggers registered,
+	 * but if it didn't register any it returns zero.  Consider no
+	 * triggers registered a failure too.
+	 */
+	if (!ret) {
+		ret = -ENOENT;
+		goto out_free;
+	} else if (ret < 0)
+		goto out_free;
+	ret = 0;
+ out:
+	return ret;
+
+ out_free:
+	if (cmd_ops->set_filter)
+		cmd_ops->set_filter(NULL, trigger_data, NULL);
+	kfree(trigger_data);
+	if (hist_data)
+		destroy_hist_data(hist_data);
+	goto out;
+}
+
+static struct event_command trigger_hist_cmd = {
+	.name			= "hist",
+	.trigger_type		= ETT_EVENT_HIST,
+	.flags			= EVENT_CMD_FL_NEEDS_REC,
+	.func			= event_hist_trigger_func,
+	.reg			= register_trigger,
+	.unreg			= unregister_trigger,
+	.get_trigger_ops	= event_hist_get_trigger_ops,
+	.set_filter		= set_trigger_filter,
+};
+
+__init int register_trigger_hist_cmd(void)
+{
+	int ret;
+
+	ret = register_event_command(&trigger_hist_cmd);
+	WARN_ON(ret < 0);
+
+	return ret;
+}
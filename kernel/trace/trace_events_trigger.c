@@ -533,9 +533,9 @@ void update_cond_flag(struct trace_event_file *file)
  *
  * Return: 0 on success, errno otherwise
  */
-static int register_trigger(char *glob, struct event_trigger_ops *ops,
-			    struct event_trigger_data *data,
-			    struct trace_event_file *file)
+int register_trigger(char *glob, struct event_trigger_ops *ops,
+		     struct event_trigger_data *data,
+		     struct trace_event_file *file)
 {
 	struct event_trigger_data *test;
 	int ret = 0;
@@ -1447,6 +1447,7 @@ __init int register_trigger_cmds(void)
 	register_trigger_snapshot_cmd();
 	register_trigger_stacktrace_cmd();
 	register_trigger_enable_disable_cmds();
+	register_trigger_hist_cmd();
 
 	return 0;
 }
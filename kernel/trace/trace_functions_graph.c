@@ -450,10 +450,20 @@ static void trace_graph_thresh_return(struct ftrace_graph_ret *trace)
 		trace_graph_return(trace);
 }
 
+/*
+ * The graph entry/return callbacks are global, and the entries are
+ * routed to a single trace_array via graph_array. Only one instance
+ * (or the top level buffer) may run the graph tracer at a time.
+ */
+static struct trace_array *graph_trace_array;
+
 static int graph_trace_init(struct trace_array *tr)
 {
 	int ret;
 
+	if (graph_trace_array && graph_trace_array != tr)
+		return -EBUSY;
+
 	set_graph_array(tr);
 	if (tracing_thresh)
 		ret = register_ftrace_graph(&trace_graph_thresh_return,
@@ -463,6 +473,7 @@ static int graph_trace_init(struct trace_array *tr)
 					    &trace_graph_entry);
 	if (ret)
 		return ret;
+	graph_trace_array = tr;
 	tracing_start_cmdline_record();
 
 	return 0;
@@ -472,6 +483,7 @@ static void graph_trace_reset(struct trace_array *tr)
 {
 	tracing_stop_cmdline_record();
 	unregister_ftrace_graph();
+	graph_trace_array = NULL;
 }
 
 static int graph_trace_update_thresh(struct trace_array *tr)
@@ -1409,6 +1421,7 @@ static struct tracer graph_trace __tracer_data = {
 #ifdef CONFIG_FTRACE_SELFTEST
 	.selftest	= trace_selftest_startup_function_graph,
 #endif
+	.allow_instances = true,
 };
 
 
@@ -46,8 +46,12 @@
 #include <linux/hashtable.h>
 #include <linux/rculist.h>
 #include <linux/nodemask.h>
+#include <linux/topology.h>
 #include <linux/moduleparam.h>
 #include <linux/uaccess.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+#include <linux/math64.h>
 
 #include "workqueue_internal.h"
 
@@ -236,6 +240,19 @@ struct wq_device;
  * The externally visible workqueue.  It relays the issued work items to
  * the appropriate worker_pool through its pool_workqueues.
  */
+#ifdef CONFIG_WQ_STATS
+/*
+ * Always-on execution accounting, one instance per workqueue per CPU.
+ * Updated locklessly by the executing worker; a reader summing the
+ * counters can see a torn update but never a wrong long-term trend.
+ */
+struct wq_stats_pcpu {
+	u64			nexec;		/* work items executed */
+	u64			runtime;	/* ns spent in work functions */
+	u64			max_queue_lat;	/* worst queue->start delay, ns */
+};
+#endif
+
 struct workqueue_struct {
 	struct list_head	pwqs;		/* WR: all pwqs of this wq */
 	struct list_head	list;		/* PR: list of all workqueues */
@@ -260,6 +277,9 @@ struct workqueue_struct {
 #ifdef CONFIG_SYSFS
 	struct wq_device	*wq_dev;	/* I: for sysfs interface */
 #endif
+#ifdef CONFIG_WQ_STATS
+	struct wq_stats_pcpu __percpu *stats; /* I: execution accounting */
+#endif
 #ifdef CONFIG_LOCKDEP
 	struct lockdep_map	lockdep_map;
 #endif
@@ -275,11 +295,39 @@ struct workqueue_struct {
 	/* hot fields used during command issue, aligned to cacheline */
 	unsigned int		flags ____cacheline_aligned; /* WQ: WQ_* flags */
 	struct pool_workqueue __percpu *cpu_pwqs; /* I: per-cpu pwqs */
-	struct pool_workqueue __rcu *numa_pwq_tbl[]; /* PWR: unbound pwqs indexed by node */
+	struct pool_workqueue __rcu *pod_pwq_tbl[]; /* PWR: unbound pwqs indexed by pod */
 };
 
 static struct kmem_cache *pwq_cache;
 
+/*
+ * Unbound workqueues confine their workers to "pods" of CPUs so that work
+ * items execute close to where they were issued.  A pod can be a single
+ * CPU, an SMT core, a last-level-cache domain or a NUMA node, selectable
+ * at runtime through /sys/devices/virtual/workqueue/affinity_scope.
+ */
+enum wq_affn_scope {
+	WQ_AFFN_CPU,			/* one pod per CPU */
+	WQ_AFFN_SMT,			/* one pod per SMT core */
+	WQ_AFFN_CACHE,			/* one pod per LLC domain */
+	WQ_AFFN_NUMA,			/* one pod per NUMA node */
+	WQ_AFFN_NR_TYPES,
+};
+
+static const char * const wq_affn_names[WQ_AFFN_NR_TYPES] = {
+	[WQ_AFFN_CPU]		= "cpu",
+	[WQ_AFFN_SMT]		= "smt",
+	[WQ_AFFN_CACHE]		= "cache",
+	[WQ_AFFN_NUMA]		= "numa",
+};
+
+static enum wq_affn_scope wq_affn_scope = WQ_AFFN_NUMA;	/* PL: current scope */
+
+static int wq_pod_max;			/* upper bound on #pods, fixed at init */
+static int wq_pod_count;		/* PL: #pods in the current scope */
+static int *wq_cpu_pod;			/* PL(write): possible CPU -> pod */
+static cpumask_var_t *wq_pod_cpumask;	/* PL(write): possible CPUs of each pod */
+
 static cpumask_var_t *wq_numa_possible_cpumask;
 					/* possible CPUs of each node */
 
@@ -290,10 +338,10 @@ module_param_named(disable_numa, wq_disable_numa, bool, 0444);
 static bool wq_power_efficient = IS_ENABLED(CONFIG_WQ_POWER_EFFICIENT_DEFAULT);
 module_param_named(power_efficient, wq_power_efficient, bool, 0444);
 
-static bool wq_numa_enabled;		/* unbound NUMA affinity enabled */
+static bool wq_pods_enabled;		/* unbound pod affinity enabled */
 
-/* buf for wq_update_unbound_numa_attrs(), protected by CPU hotplug exclusion */
-static struct workqueue_attrs *wq_update_unbound_numa_attrs_buf;
+/* buf for wq_update_unbound_pod(), protected by CPU hotplug exclusion */
+static struct workqueue_attrs *wq_update_pod_attrs_buf;
 
 static DEFINE_MUTEX(wq_pool_mutex);	/* protects pools and workqueues list */
 static DEFINE_SPINLOCK(wq_mayday_lock);	/* protects wq->maydays list */
@@ -333,6 +381,192 @@ static struct workqueue_attrs *unbound_std_wq_attrs[NR_STD_WORKER_POOLS];
 /* I: attributes used when instantiating ordered pools on demand */
 static struct workqueue_attrs *ordered_wq_attrs[NR_STD_WORKER_POOLS];
 
+#ifdef CONFIG_WQ_STATS
+/*
+ * Per-work-function totals, aggregated across all workqueues and CPUs.
+ * The set of work functions in a running kernel is small and static, so
+ * entries are allocated on first execution and never reclaimed.
+ */
+struct wq_func_stats {
+	struct hlist_node	hentry;
+	work_func_t		func;
+	atomic64_t		nexec;
+	atomic64_t		runtime;
+	atomic64_t		max_queue_lat;
+};
+
+#define WQ_FUNC_HASH_BITS	8
+
+static DEFINE_HASHTABLE(wq_func_hash, WQ_FUNC_HASH_BITS);
+static DEFINE_SPINLOCK(wq_func_lock);	/* protects insertions */
+
+static int wq_stats_init(struct workqueue_struct *wq)
+{
+	wq->stats = alloc_percpu(struct wq_stats_pcpu);
+	return wq->stats ? 0 : -ENOMEM;
+}
+
+static void wq_stats_free(struct workqueue_struct *wq)
+{
+	free_percpu(wq->stats);
+}
+
+static inline void wq_stats_stamp(struct work_struct *work)
+{
+	work->queue_stamp = local_clock();
+}
+
+static inline u64 wq_stats_clock(void)
+{
+	return local_clock();
+}
+
+static inline u64 wq_stats_queue_lat(const struct work_struct *work)
+{
+	return local_clock() - work->queue_stamp;
+}
+
+static struct wq_func_stats *wq_func_stats_get(work_func_t func)
+{
+	struct wq_func_stats *fs, *new;
+
+	hash_for_each_possible_rcu(wq_func_hash, fs, hentry,
+				   (unsigned long)func)
+		if (fs->func == func)
+			return fs;
+
+	new = kzalloc(sizeof(*new), GFP_ATOMIC | __GFP_NOWARN);
+	if (!new)
+		return NULL;
+	new->func = func;
+
+	spin_lock(&wq_func_lock);
+	/* recheck under the lock, we may have raced with another CPU */
+	hash_for_each_possible_rcu(wq_func_hash, fs, hentry,
+				   (unsigned long)func) {
+		if (fs->func == func) {
+			spin_unlock(&wq_func_lock);
+			kfree(new);
+			return fs;
+		}
+	}
+	hash_add_rcu(wq_func_hash, &new->hentry, (unsigned long)func);
+	spin_unlock(&wq_func_lock);
+	return new;
+}
+
+static void wq_stats_update_max(atomic64_t *max, u64 val)
+{
+	u64 old = atomic64_read(max);
+
+	while (val > old) {
+		u64 prev = atomic64_cmpxchg(max, old, val);
+
+		if (prev == old)
+			break;
+		old = prev;
+	}
+}
+
+static void wq_stats_account(struct workqueue_struct *wq, work_func_t func,
+			     u64 runtime, u64 queue_lat)
+{
+	struct wq_stats_pcpu *pcpu;
+	struct wq_func_stats *fs;
+
+	preempt_disable();
+	pcpu = this_cpu_ptr(wq->stats);
+	pcpu->nexec++;
+	pcpu->runtime += runtime;
+	if (queue_lat > pcpu->max_queue_lat)
+		pcpu->max_queue_lat = queue_lat;
+	preempt_enable();
+
+	rcu_read_lock();
+	fs = wq_func_stats_get(func);
+	if (likely(fs)) {
+		atomic64_inc(&fs->nexec);
+		atomic64_add(runtime, &fs->runtime);
+		wq_stats_update_max(&fs->max_queue_lat, queue_lat);
+	}
+	rcu_read_unlock();
+}
+
+static int wq_stats_show(struct seq_file *m, void *v)
+{
+	struct workqueue_struct *wq;
+	struct wq_func_stats *fs;
+	int cpu, bkt;
+
+	seq_printf(m, "%-32s %12s %14s %14s\n",
+		   "# workqueue", "exec", "runtime_us", "max_qlat_us");
+
+	mutex_lock(&wq_pool_mutex);
+	list_for_each_entry(wq, &workqueues, list) {
+		u64 nexec = 0, runtime = 0, max_lat = 0;
+
+		for_each_possible_cpu(cpu) {
+			struct wq_stats_pcpu *pcpu =
+				per_cpu_ptr(wq->stats, cpu);
+
+			nexec += pcpu->nexec;
+			runtime += pcpu->runtime;
+			max_lat = max(max_lat, pcpu->max_queue_lat);
+		}
+		seq_printf(m, "%-32s %12llu %14llu %14llu\n", wq->name,
+			   nexec, div_u64(runtime, NSEC_PER_USEC),
+			   div_u64(max_lat, NSEC_PER_USEC));
+	}
+	mutex_unlock(&wq_pool_mutex);
+
+	seq_printf(m, "\n%-32s %12s %14s %14s\n",
+		   "# function", "exec", "runtime_us", "max_qlat_us");
+
+	rcu_read_lock();
+	hash_for_each_rcu(wq_func_hash, bkt, fs, hentry)
+		seq_printf(m, "%-32pf %12llu %14llu %14llu\n", fs->func,
+			   (u64)atomic64_read(&fs->nexec),
+			   div_u64(atomic64_read(&fs->runtime), NSEC_PER_USEC),
+			   div_u64(atomic64_read(&fs->max_queue_lat),
+				   NSEC_PER_USEC));
+	rcu_read_unlock();
+
+	return 0;
+}
+
+static int wq_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, wq_stats_show, NULL);
+}
+
+static const struct file_operations wq_stats_fops = {
+	.open		= wq_stats_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static int __init wq_stats_debugfs_init(void)
+{
+	debugfs_create_file("workqueue_stats", 0444, NULL, NULL,
+			    &wq_stats_fops);
+	return 0;
+}
+late_initcall(wq_stats_debugfs_init);
+#else	/* CONFIG_WQ_STATS */
+static inline int wq_stats_init(struct workqueue_struct *wq) { return 0; }
+static inline void wq_stats_free(struct workqueue_struct *wq) { }
+static inline void wq_stats_stamp(struct work_struct *work) { }
+static inline u64 wq_stats_clock(void) { return 0; }
+static inline u64 wq_stats_queue_lat(const struct work_struct *work)
+{
+	return 0;
+}
+static inline void wq_stats_account(struct workqueue_struct *wq,
+				    work_func_t func, u64 runtime,
+				    u64 queue_lat) { }
+#endif	/* CONFIG_WQ_STATS */
+
 struct workqueue_struct *system_wq __read_mostly;
 EXPORT_SYMBOL(system_wq);
 struct workqueue_struct *system_highpri_wq __read_mostly;
@@ -569,33 +803,38 @@ static int worker_pool_assign_id(struct worker_pool *pool)
 	return ret;
 }
 
+/*
+ * Map a CPU to its pod under the current affinity scope.  The map may be
+ * rewritten when the scope changes, but every slot of every unbound
+ * workqueue's pod_pwq_tbl[] always points to a valid pwq, so a stale pod
+ * ID at worst queues to a neighbouring pod's pwq for the transition.
+ */
+static int wq_pod_of_cpu(int cpu)
+{
+	return READ_ONCE(wq_cpu_pod[cpu]);
+}
+
 /**
- * unbound_pwq_by_node - return the unbound pool_workqueue for the given node
+ * unbound_pwq_by_pod - return the unbound pool_workqueue for the given pod
  * @wq: the target workqueue
- * @node: the node ID
+ * @pod: the pod ID
  *
  * This must be called with any of wq_pool_mutex, wq->mutex or sched RCU
  * read locked.
  * If the pwq needs to be used beyond the locking in effect, the caller is
  * responsible for guaranteeing that the pwq stays online.
  *
- * Return: The unbound pool_workqueue for @node.
+ * Return: The unbound pool_workqueue for @pod.
  */
-static struct pool_workqueue *unbound_pwq_by_node(struct workqueue_struct *wq,
-						  int node)
+static struct pool_workqueue *unbound_pwq_by_pod(struct workqueue_struct *wq,
+						 int pod)
 {
 	assert_rcu_or_wq_mutex_or_pool_mutex(wq);
 
-	/*
-	 * XXX: @node can be NUMA_NO_NODE if CPU goes offline while a
-	 * delayed item is pending.  The plan is to keep CPU -> NODE
-	 * mapping valid and stable across CPU on/offlines.  Once that
-	 * happens, this workaround can be removed.
-	 */
-	if (unlikely(node == NUMA_NO_NODE))
+	if (unlikely(pod < 0))
 		return wq->dfl_pwq;
 
-	return rcu_dereference_raw(wq->numa_pwq_tbl[node]);
+	return rcu_dereference_raw(wq->pod_pwq_tbl[pod]);
 }
 
 static unsigned int work_color_to_flags(int color)
@@ -1292,6 +1531,7 @@ static void insert_work(struct pool_workqueue *pwq, struct work_struct *work,
 
 	/* we own @work, set data and link */
 	set_work_pwq(work, pwq, extra_flags);
+	wq_stats_stamp(work);
 	list_add_tail(&work->entry, head);
 	get_pwq(pwq);
 
@@ -1386,7 +1626,7 @@ retry:
 	if (!(wq->flags & WQ_UNBOUND))
 		pwq = per_cpu_ptr(wq->cpu_pwqs, cpu);
 	else
-		pwq = unbound_pwq_by_node(wq, cpu_to_node(cpu));
+		pwq = unbound_pwq_by_pod(wq, wq_pod_of_cpu(cpu));
 
 	/*
 	 * If @work was previously on a different pool, it might still be
@@ -1416,7 +1656,7 @@ retry:
 	 * pwq is determined and locked.  For unbound pools, we could have
 	 * raced with pwq release and it could already be dead.  If its
 	 * refcnt is zero, repeat pwq selection.  Note that pwqs never die
-	 * without another pwq replacing it in the numa_pwq_tbl or while
+	 * without another pwq replacing it in the pod_pwq_tbl or while
 	 * work items are executing on it, so the retrying is guaranteed to
 	 * make forward-progress.
 	 */
@@ -2020,6 +2260,7 @@ __acquires(&pool->lock)
 	bool cpu_intensive = pwq->wq->flags & WQ_CPU_INTENSIVE;
 	int work_color;
 	struct worker *collision;
+	u64 queue_lat, exec_start;
 #ifdef CONFIG_LOCKDEP
 	/*
 	 * It is permissible to free the struct work_struct from
@@ -2054,6 +2295,10 @@ __acquires(&pool->lock)
 	worker->current_work = work;
 	worker->current_func = work->func;
 	worker->current_pwq = pwq;
+	queue_lat = wq_stats_queue_lat(work);
+	/* default description; work functions may override via set_worker_desc() */
+	strlcpy(worker->desc, pwq->wq->name, WORKER_DESC_LEN);
+	worker->desc_valid = true;
 	work_color = get_work_color(work);
 
 	list_del_init(&work->entry);
@@ -2090,12 +2335,15 @@ __acquires(&pool->lock)
 	lock_map_acquire_read(&pwq->wq->lockdep_map);
 	lock_map_acquire(&lockdep_map);
 	trace_workqueue_execute_start(work);
+	exec_start = wq_stats_clock();
 	worker->current_func(work);
 	/*
 	 * While we must be careful to not use "work" after this, the trace
 	 * point will only record its address.
 	 */
 	trace_workqueue_execute_end(work);
+	wq_stats_account(pwq->wq, worker->current_func,
+			 wq_stats_clock() - exec_start, queue_lat);
 	lock_map_release(&lockdep_map);
 	lock_map_release(&pwq->wq->lockdep_map);
 
@@ -3213,6 +3461,7 @@ static void rcu_free_wq(struct rcu_head *rcu)
 	else
 		free_workqueue_attrs(wq->unbound_attrs);
 
+	wq_stats_free(wq);
 	kfree(wq->rescuer);
 	kfree(wq);
 }
@@ -3320,7 +3569,7 @@ static struct worker_pool *get_unbound_pool(const struct workqueue_attrs *attrs)
 	}
 
 	/* if cpumask is contained inside a NUMA node, we belong to that node */
-	if (wq_numa_enabled) {
+	if (wq_numa_possible_cpumask) {
 		for_each_node(node) {
 			if (cpumask_subset(attrs->cpumask,
 					   wq_numa_possible_cpumask[node])) {
@@ -3511,43 +3760,44 @@ static struct pool_workqueue *alloc_unbound_pwq(struct workqueue_struct *wq,
 }
 
 /**
- * wq_calc_node_cpumask - calculate a wq_attrs' cpumask for the specified node
+ * wq_calc_pod_cpumask - calculate a wq_attrs' cpumask for the specified pod
  * @attrs: the wq_attrs of the default pwq of the target workqueue
- * @node: the target NUMA node
+ * @pod: the target pod
  * @cpu_going_down: if >= 0, the CPU to consider as offline
  * @cpumask: outarg, the resulting cpumask
  *
- * Calculate the cpumask a workqueue with @attrs should use on @node.  If
+ * Calculate the cpumask a workqueue with @attrs should use on @pod.  If
  * @cpu_going_down is >= 0, that cpu is considered offline during
  * calculation.  The result is stored in @cpumask.
  *
- * If NUMA affinity is not enabled, @attrs->cpumask is always used.  If
- * enabled and @node has online CPUs requested by @attrs, the returned
- * cpumask is the intersection of the possible CPUs of @node and
+ * If pod affinity is not enabled, @attrs->cpumask is always used.  If
+ * enabled and @pod has online CPUs requested by @attrs, the returned
+ * cpumask is the intersection of the possible CPUs of @pod and
  * @attrs->cpumask.
  *
- * The caller is responsible for ensuring that the cpumask of @node stays
+ * The caller is responsible for ensuring that the cpumask of @pod stays
  * stable.
  *
  * Return: %true if the resulting @cpumask is different from @attrs->cpumask,
  * %false if equal.
  */
-static bool wq_calc_node_cpumask(const struct workqueue_attrs *attrs, int node,
-				 int cpu_going_down, cpumask_t *cpumask)
+static bool wq_calc_pod_cpumask(const struct workqueue_attrs *attrs, int pod,
+				int cpu_going_down, cpumask_t *cpumask)
 {
-	if (!wq_numa_enabled || attrs->no_numa)
+	if (!wq_pods_enabled || attrs->no_numa || pod >= wq_pod_count)
 		goto use_dfl;
 
-	/* does @node have any online CPUs @attrs wants? */
-	cpumask_and(cpumask, cpumask_of_node(node), attrs->cpumask);
+	/* does @pod have any online CPUs @attrs wants? */
+	cpumask_and(cpumask, wq_pod_cpumask[pod], attrs->cpumask);
+	cpumask_and(cpumask, cpumask, cpu_online_mask);
 	if (cpu_going_down >= 0)
 		cpumask_clear_cpu(cpu_going_down, cpumask);
 
 	if (cpumask_empty(cpumask))
 		goto use_dfl;
 
-	/* yeap, return possible CPUs in @node that @attrs wants */
-	cpumask_and(cpumask, attrs->cpumask, wq_numa_possible_cpumask[node]);
+	/* yeap, return possible CPUs in @pod that @attrs wants */
+	cpumask_and(cpumask, attrs->cpumask, wq_pod_cpumask[pod]);
 	return !cpumask_equal(cpumask, attrs->cpumask);
 
 use_dfl:
@@ -3555,9 +3805,9 @@ use_dfl:
 	return false;
 }
 
-/* install @pwq into @wq's numa_pwq_tbl[] for @node and return the old pwq */
-static struct pool_workqueue *numa_pwq_tbl_install(struct workqueue_struct *wq,
-						   int node,
+/* install @pwq into @wq's pod_pwq_tbl[] for @pod and return the old pwq */
+static struct pool_workqueue *pod_pwq_tbl_install(struct workqueue_struct *wq,
+						   int pod,
 						   struct pool_workqueue *pwq)
 {
 	struct pool_workqueue *old_pwq;
@@ -3568,8 +3818,8 @@ static struct pool_workqueue *numa_pwq_tbl_install(struct workqueue_struct *wq,
 	/* link_pwq() can handle duplicate calls */
 	link_pwq(pwq);
 
-	old_pwq = rcu_access_pointer(wq->numa_pwq_tbl[node]);
-	rcu_assign_pointer(wq->numa_pwq_tbl[node], pwq);
+	old_pwq = rcu_access_pointer(wq->pod_pwq_tbl[pod]);
+	rcu_assign_pointer(wq->pod_pwq_tbl[pod], pwq);
 	return old_pwq;
 }
 
@@ -3586,10 +3836,10 @@ struct apply_wqattrs_ctx {
 static void apply_wqattrs_cleanup(struct apply_wqattrs_ctx *ctx)
 {
 	if (ctx) {
-		int node;
+		int pod;
 
-		for_each_node(node)
-			put_pwq_unlocked(ctx->pwq_tbl[node]);
+		for (pod = 0; pod < wq_pod_max; pod++)
+			put_pwq_unlocked(ctx->pwq_tbl[pod]);
 		put_pwq_unlocked(ctx->dfl_pwq);
 
 		free_workqueue_attrs(ctx->attrs);
@@ -3605,11 +3855,11 @@ apply_wqattrs_prepare(struct workqueue_struct *wq,
 {
 	struct apply_wqattrs_ctx *ctx;
 	struct workqueue_attrs *new_attrs, *tmp_attrs;
-	int node;
+	int pod;
 
 	lockdep_assert_held(&wq_pool_mutex);
 
-	ctx = kzalloc(sizeof(*ctx) + nr_node_ids * sizeof(ctx->pwq_tbl[0]),
+	ctx = kzalloc(sizeof(*ctx) + wq_pod_max * sizeof(ctx->pwq_tbl[0]),
 		      GFP_KERNEL);
 
 	new_attrs = alloc_workqueue_attrs(GFP_KERNEL);
@@ -3643,14 +3893,14 @@ apply_wqattrs_prepare(struct workqueue_struct *wq,
 	if (!ctx->dfl_pwq)
 		goto out_free;
 
-	for_each_node(node) {
-		if (wq_calc_node_cpumask(new_attrs, node, -1, tmp_attrs->cpumask)) {
-			ctx->pwq_tbl[node] = alloc_unbound_pwq(wq, tmp_attrs);
-			if (!ctx->pwq_tbl[node])
+	for (pod = 0; pod < wq_pod_max; pod++) {
+		if (wq_calc_pod_cpumask(new_attrs, pod, -1, tmp_attrs->cpumask)) {
+			ctx->pwq_tbl[pod] = alloc_unbound_pwq(wq, tmp_attrs);
+			if (!ctx->pwq_tbl[pod])
 				goto out_free;
 		} else {
 			ctx->dfl_pwq->refcnt++;
-			ctx->pwq_tbl[node] = ctx->dfl_pwq;
+			ctx->pwq_tbl[pod] = ctx->dfl_pwq;
 		}
 	}
 
@@ -3673,7 +3923,7 @@ out_free:
 /* set attrs and install prepared pwqs, @ctx points to old pwqs on return */
 static void apply_wqattrs_commit(struct apply_wqattrs_ctx *ctx)
 {
-	int node;
+	int pod;
 
 	/* all pwqs have been created successfully, let's install'em */
 	mutex_lock(&ctx->wq->mutex);
@@ -3681,9 +3931,9 @@ static void apply_wqattrs_commit(struct apply_wqattrs_ctx *ctx)
 	copy_workqueue_attrs(ctx->wq->unbound_attrs, ctx->attrs);
 
 	/* save the previous pwq and install the new one */
-	for_each_node(node)
-		ctx->pwq_tbl[node] = numa_pwq_tbl_install(ctx->wq, node,
-							  ctx->pwq_tbl[node]);
+	for (pod = 0; pod < wq_pod_max; pod++)
+		ctx->pwq_tbl[pod] = pod_pwq_tbl_install(ctx->wq, pod,
+							ctx->pwq_tbl[pod]);
 
 	/* @dfl_pwq might not have been used, ensure it's linked */
 	link_pwq(ctx->dfl_pwq);
@@ -3758,31 +4008,31 @@ int apply_workqueue_attrs(struct workqueue_struct *wq,
 }
 
 /**
- * wq_update_unbound_numa - update NUMA affinity of a wq for CPU hot[un]plug
+ * wq_update_unbound_pod - update pod affinity of a wq for CPU hot[un]plug
  * @wq: the target workqueue
  * @cpu: the CPU coming up or going down
  * @online: whether @cpu is coming up or going down
  *
  * This function is to be called from %CPU_DOWN_PREPARE, %CPU_ONLINE and
- * %CPU_DOWN_FAILED.  @cpu is being hot[un]plugged, update NUMA affinity of
+ * %CPU_DOWN_FAILED.  @cpu is being hot[un]plugged, update pod affinity of
  * @wq accordingly.
  *
- * If NUMA affinity can't be adjusted due to memory allocation failure, it
+ * If pod affinity can't be adjusted due to memory allocation failure, it
  * falls back to @wq->dfl_pwq which may not be optimal but is always
  * correct.
  *
- * Note that when the last allowed CPU of a NUMA node goes offline for a
- * workqueue with a cpumask spanning multiple nodes, the workers which were
+ * Note that when the last allowed CPU of a pod goes offline for a
+ * workqueue with a cpumask spanning multiple pods, the workers which were
  * already executing the work items for the workqueue will lose their CPU
  * affinity and may execute on any CPU.  This is similar to how per-cpu
  * workqueues behave on CPU_DOWN.  If a workqueue user wants strict
  * affinity, it's the user's responsibility to flush the work item from
  * CPU_DOWN_PREPARE.
  */
-static void wq_update_unbound_numa(struct workqueue_struct *wq, int cpu,
-				   bool online)
+static void wq_update_unbound_pod(struct workqueue_struct *wq, int cpu,
+				  bool online)
 {
-	int node = cpu_to_node(cpu);
+	int pod = wq_pod_of_cpu(cpu);
 	int cpu_off = online ? -1 : cpu;
 	struct pool_workqueue *old_pwq = NULL, *pwq;
 	struct workqueue_attrs *target_attrs;
@@ -3790,7 +4040,7 @@ static void wq_update_unbound_numa(struct workqueue_struct *wq, int cpu,
 
 	lockdep_assert_held(&wq_pool_mutex);
 
-	if (!wq_numa_enabled || !(wq->flags & WQ_UNBOUND) ||
+	if (!wq_pods_enabled || !(wq->flags & WQ_UNBOUND) ||
 	    wq->unbound_attrs->no_numa)
 		return;
 
@@ -3799,11 +4049,11 @@ static void wq_update_unbound_numa(struct workqueue_struct *wq, int cpu,
 	 * Let's use a preallocated one.  The following buf is protected by
 	 * CPU hotplug exclusion.
 	 */
-	target_attrs = wq_update_unbound_numa_attrs_buf;
+	target_attrs = wq_update_pod_attrs_buf;
 	cpumask = target_attrs->cpumask;
 
 	copy_workqueue_attrs(target_attrs, wq->unbound_attrs);
-	pwq = unbound_pwq_by_node(wq, node);
+	pwq = unbound_pwq_by_pod(wq, pod);
 
 	/*
 	 * Let's determine what needs to be done.  If the target cpumask is
@@ -3811,7 +4061,7 @@ static void wq_update_unbound_numa(struct workqueue_struct *wq, int cpu,
 	 * and create a new one if they don't match.  If the target cpumask
 	 * equals the default pwq's, the default pwq should be used.
 	 */
-	if (wq_calc_node_cpumask(wq->dfl_pwq->pool->attrs, node, cpu_off, cpumask)) {
+	if (wq_calc_pod_cpumask(wq->dfl_pwq->pool->attrs, pod, cpu_off, cpumask)) {
 		if (cpumask_equal(cpumask, pwq->pool->attrs->cpumask))
 			return;
 	} else {
@@ -3821,14 +4071,14 @@ static void wq_update_unbound_numa(struct workqueue_struct *wq, int cpu,
 	/* create a new pwq */
 	pwq = alloc_unbound_pwq(wq, target_attrs);
 	if (!pwq) {
-		pr_warn("workqueue: allocation failed while updating NUMA affinity of \"%s\"\n",
+		pr_warn("workqueue: allocation failed while updating pod affinity of \"%s\"\n",
 			wq->name);
 		goto use_dfl_pwq;
 	}
 
 	/* Install the new pwq. */
 	mutex_lock(&wq->mutex);
-	old_pwq = numa_pwq_tbl_install(wq, node, pwq);
+	old_pwq = pod_pwq_tbl_install(wq, pod, pwq);
 	goto out_unlock;
 
 use_dfl_pwq:
@@ -3836,7 +4086,7 @@ use_dfl_pwq:
 	spin_lock_irq(&wq->dfl_pwq->pool->lock);
 	get_pwq(wq->dfl_pwq);
 	spin_unlock_irq(&wq->dfl_pwq->pool->lock);
-	old_pwq = numa_pwq_tbl_install(wq, node, wq->dfl_pwq);
+	old_pwq = pod_pwq_tbl_install(wq, pod, wq->dfl_pwq);
 out_unlock:
 	mutex_unlock(&wq->mutex);
 	put_pwq_unlocked(old_pwq);
@@ -3906,7 +4156,7 @@ struct workqueue_struct *__alloc_workqueue_key(const char *fmt,
 
 	/* allocate wq and format name */
 	if (flags & WQ_UNBOUND)
-		tbl_size = nr_node_ids * sizeof(wq->numa_pwq_tbl[0]);
+		tbl_size = wq_pod_max * sizeof(wq->pod_pwq_tbl[0]);
 
 	wq = kzalloc(sizeof(*wq) + tbl_size, GFP_KERNEL);
 	if (!wq)
@@ -3938,6 +4188,9 @@ struct workqueue_struct *__alloc_workqueue_key(const char *fmt,
 	lockdep_init_map(&wq->lockdep_map, lock_name, key, 0);
 	INIT_LIST_HEAD(&wq->list);
 
+	if (wq_stats_init(wq) < 0)
+		goto err_free_wq;
+
 	if (alloc_and_link_pwqs(wq) < 0)
 		goto err_free_wq;
 
@@ -3988,6 +4241,7 @@ struct workqueue_struct *__alloc_workqueue_key(const char *fmt,
 
 err_free_wq:
 	free_workqueue_attrs(wq->unbound_attrs);
+	wq_stats_free(wq);
 	kfree(wq);
 	return NULL;
 err_destroy:
@@ -4005,7 +4259,7 @@ EXPORT_SYMBOL_GPL(__alloc_workqueue_key);
 void destroy_workqueue(struct workqueue_struct *wq)
 {
 	struct pool_workqueue *pwq;
-	int node;
+	int pod;
 
 	/* drain it before proceeding with destruction */
 	drain_workqueue(wq);
@@ -4053,12 +4307,12 @@ void destroy_workqueue(struct workqueue_struct *wq)
 	} else {
 		/*
 		 * We're the sole accessor of @wq at this point.  Directly
-		 * access numa_pwq_tbl[] and dfl_pwq to put the base refs.
+		 * access pod_pwq_tbl[] and dfl_pwq to put the base refs.
 		 * @wq will be freed when the last pwq is released.
 		 */
-		for_each_node(node) {
-			pwq = rcu_access_pointer(wq->numa_pwq_tbl[node]);
-			RCU_INIT_POINTER(wq->numa_pwq_tbl[node], NULL);
+		for (pod = 0; pod < wq_pod_max; pod++) {
+			pwq = rcu_access_pointer(wq->pod_pwq_tbl[pod]);
+			RCU_INIT_POINTER(wq->pod_pwq_tbl[pod], NULL);
 			put_pwq_unlocked(pwq);
 		}
 
@@ -4150,7 +4404,7 @@ bool workqueue_congested(int cpu, struct workqueue_struct *wq)
 	if (!(wq->flags & WQ_UNBOUND))
 		pwq = per_cpu_ptr(wq->cpu_pwqs, cpu);
 	else
-		pwq = unbound_pwq_by_node(wq, cpu_to_node(cpu));
+		pwq = unbound_pwq_by_pod(wq, wq_pod_of_cpu(cpu));
 
 	ret = !list_empty(&pwq->delayed_works);
 	rcu_read_unlock_sched();
@@ -4216,6 +4470,49 @@ void set_worker_desc(const char *fmt, ...)
 	}
 }
 
+/**
+ * wq_worker_comm - fill in a kworker's reported name
+ * @buf: buffer to fill
+ * @size: size of @buf
+ * @task: target task, expected but not required to be a kworker
+ *
+ * Appends the worker's description (the servicing workqueue's name by
+ * default) to its comm, separated by '+' while a work item is executing
+ * and '-' while idle, so that per-task CPU time in /proc can be
+ * attributed to workqueues without tracing.  Safe against the worker
+ * changing state concurrently; at worst a stale description is shown.
+ */
+void wq_worker_comm(char *buf, size_t size, struct task_struct *task)
+{
+	int off;
+
+	off = strscpy(buf, task->comm, size);
+	if (off < 0)
+		return;
+
+	if (task->flags & PF_WQ_WORKER) {
+		struct worker *worker = kthread_data(task);
+		struct worker_pool *pool;
+
+		/* pools are sched-RCU protected, see put_unbound_pool() */
+		rcu_read_lock_sched();
+		pool = worker->pool;
+		if (pool) {
+			spin_lock_irq(&pool->lock);
+			if (worker->desc[0] != '\0') {
+				if (worker->current_work)
+					scnprintf(buf + off, size - off,
+						  "+%s", worker->desc);
+				else
+					scnprintf(buf + off, size - off,
+						  "-%s", worker->desc);
+			}
+			spin_unlock_irq(&pool->lock);
+		}
+		rcu_read_unlock_sched();
+	}
+}
+
 /**
  * print_worker_info - print out worker information and description
  * @log_lvl: the log level to use when printing
@@ -4637,7 +4934,7 @@ static int workqueue_cpu_up_callback(struct notifier_block *nfb,
 
 		/* update NUMA affinity of unbound workqueues */
 		list_for_each_entry(wq, &workqueues, list)
-			wq_update_unbound_numa(wq, cpu, true);
+			wq_update_unbound_pod(wq, cpu, true);
 
 		mutex_unlock(&wq_pool_mutex);
 		break;
@@ -4666,7 +4963,7 @@ static int workqueue_cpu_down_callback(struct notifier_block *nfb,
 		/* update NUMA affinity of unbound workqueues */
 		mutex_lock(&wq_pool_mutex);
 		list_for_each_entry(wq, &workqueues, list)
-			wq_update_unbound_numa(wq, cpu, false);
+			wq_update_unbound_pod(wq, cpu, false);
 		mutex_unlock(&wq_pool_mutex);
 
 		/* wait for per-cpu unbinding to finish */
@@ -4905,6 +5202,33 @@ int workqueue_set_unbound_cpumask(cpumask_var_t cpumask)
 	return ret;
 }
 
+/**
+ * workqueue_set_affinity_scope - switch the unbound worker pod granularity
+ * @scope: the new affinity scope
+ *
+ * Rebuild the CPU->pod mapping for @scope and refit every unbound
+ * workqueue to the new pods.  Workqueues whose pwqs fail to be rebuilt
+ * keep their old ones, which remain correct for any pod ID.
+ *
+ * Return: 0 on success, -ENOMEM on pwq allocation failure.
+ */
+static int workqueue_set_affinity_scope(enum wq_affn_scope scope)
+{
+	int ret = 0;
+
+	apply_wqattrs_lock();
+
+	if (scope != wq_affn_scope) {
+		wq_build_pods(scope);
+		wq_affn_scope = scope;
+		wq_pods_enabled = !wq_disable_numa && wq_pod_count > 1;
+		ret = workqueue_apply_unbound_cpumask();
+	}
+
+	apply_wqattrs_unlock();
+	return ret;
+}
+
 #ifdef CONFIG_SYSFS
 /*
  * Workqueues with WQ_SYSFS flag set is visible to userland via
@@ -4976,13 +5300,13 @@ static ssize_t wq_pool_ids_show(struct device *dev,
 {
 	struct workqueue_struct *wq = dev_to_wq(dev);
 	const char *delim = "";
-	int node, written = 0;
+	int pod, written = 0;
 
 	rcu_read_lock_sched();
-	for_each_node(node) {
+	for (pod = 0; pod < wq_pod_count; pod++) {
 		written += scnprintf(buf + written, PAGE_SIZE - written,
-				     "%s%d:%d", delim, node,
-				     unbound_pwq_by_node(wq, node)->pool->id);
+				     "%s%d:%d", delim, pod,
+				     unbound_pwq_by_pod(wq, pod)->pool->id);
 		delim = " ";
 	}
 	written += scnprintf(buf + written, PAGE_SIZE - written, "\n");
@@ -5167,6 +5491,43 @@ static struct device_attribute wq_sysfs_cpumask_attr =
 	__ATTR(cpumask, 0644, wq_unbound_cpumask_show,
 	       wq_unbound_cpumask_store);
 
+static ssize_t wq_affn_scope_show(struct device *dev,
+				  struct device_attribute *attr, char *buf)
+{
+	int written = 0;
+	int i;
+
+	mutex_lock(&wq_pool_mutex);
+	for (i = 0; i < WQ_AFFN_NR_TYPES; i++)
+		written += scnprintf(buf + written, PAGE_SIZE - written,
+				     i == wq_affn_scope ? "[%s] " : "%s ",
+				     wq_affn_names[i]);
+	mutex_unlock(&wq_pool_mutex);
+
+	/* replace the trailing space */
+	buf[written - 1] = '\n';
+	return written;
+}
+
+static ssize_t wq_affn_scope_store(struct device *dev,
+				   struct device_attribute *attr,
+				   const char *buf, size_t count)
+{
+	int ret;
+	int i;
+
+	for (i = 0; i < WQ_AFFN_NR_TYPES; i++) {
+		if (sysfs_streq(buf, wq_affn_names[i])) {
+			ret = workqueue_set_affinity_scope(i);
+			return ret ? ret : count;
+		}
+	}
+	return -EINVAL;
+}
+
+static struct device_attribute wq_sysfs_affn_scope_attr =
+	__ATTR(affinity_scope, 0644, wq_affn_scope_show, wq_affn_scope_store);
+
 static int __init wq_sysfs_init(void)
 {
 	int err;
@@ -5175,7 +5536,12 @@ static int __init wq_sysfs_init(void)
 	if (err)
 		return err;
 
-	return device_create_file(wq_subsys.dev_root, &wq_sysfs_cpumask_attr);
+	err = device_create_file(wq_subsys.dev_root, &wq_sysfs_cpumask_attr);
+	if (err)
+		return err;
+
+	return device_create_file(wq_subsys.dev_root,
+				  &wq_sysfs_affn_scope_attr);
 }
 core_initcall(wq_sysfs_init);
 
@@ -5422,46 +5788,106 @@ static inline void wq_watchdog_init(void) { }
 
 #endif	/* CONFIG_WQ_WATCHDOG */
 
-static void __init wq_numa_init(void)
+/* do @cpu0 and @cpu1 belong to the same pod under @scope? */
+static bool wq_cpus_share_pod(enum wq_affn_scope scope, int cpu0, int cpu1)
 {
-	cpumask_var_t *tbl;
-	int node, cpu;
+	switch (scope) {
+	case WQ_AFFN_CPU:
+		return false;
+	case WQ_AFFN_SMT:
+		return cpumask_test_cpu(cpu1, topology_sibling_cpumask(cpu0));
+	case WQ_AFFN_CACHE:
+		return cpus_share_cache(cpu0, cpu1);
+	case WQ_AFFN_NUMA:
+	default:
+		return cpu_to_node(cpu0) == cpu_to_node(cpu1);
+	}
+}
 
-	if (num_possible_nodes() <= 1)
-		return;
+/*
+ * Rebuild wq_cpu_pod[] and wq_pod_cpumask[] for @scope.  Called with
+ * wq_pool_mutex held and CPU hotplug excluded.  Possible CPUs whose
+ * topology isn't known yet (e.g. never onlined) end up in pods of their
+ * own, which errs on the side of tighter affinity.
+ */
+static void wq_build_pods(enum wq_affn_scope scope)
+{
+	int cpu, prev, pod;
+	int count = 0;
 
-	if (wq_disable_numa) {
-		pr_info("workqueue: NUMA affinity support disabled\n");
-		return;
+	for (pod = 0; pod < wq_pod_max; pod++)
+		cpumask_clear(wq_pod_cpumask[pod]);
+
+	for_each_possible_cpu(cpu) {
+		pod = -1;
+		for_each_possible_cpu(prev) {
+			if (prev == cpu)
+				break;
+			if (wq_cpus_share_pod(scope, cpu, prev)) {
+				pod = wq_cpu_pod[prev];
+				break;
+			}
+		}
+		if (pod < 0)
+			pod = count++;
+		/* the queueing fast path reads this locklessly */
+		WRITE_ONCE(wq_cpu_pod[cpu], pod);
+		cpumask_set_cpu(cpu, wq_pod_cpumask[pod]);
 	}
+	wq_pod_count = count;
+}
+
+static void __init wq_pod_init(void)
+{
+	cpumask_var_t *tbl;
+	int node, cpu, pod;
 
-	wq_update_unbound_numa_attrs_buf = alloc_workqueue_attrs(GFP_KERNEL);
-	BUG_ON(!wq_update_unbound_numa_attrs_buf);
+	wq_update_pod_attrs_buf = alloc_workqueue_attrs(GFP_KERNEL);
+	BUG_ON(!wq_update_pod_attrs_buf);
+
+	/* every scope partitions the possible CPUs, so this bounds them all */
+	wq_pod_max = nr_cpu_ids;
+
+	wq_cpu_pod = kzalloc(nr_cpu_ids * sizeof(wq_cpu_pod[0]), GFP_KERNEL);
+	wq_pod_cpumask = kzalloc(wq_pod_max * sizeof(wq_pod_cpumask[0]),
+				 GFP_KERNEL);
+	BUG_ON(!wq_cpu_pod || !wq_pod_cpumask);
+	for (pod = 0; pod < wq_pod_max; pod++)
+		BUG_ON(!zalloc_cpumask_var(&wq_pod_cpumask[pod], GFP_KERNEL));
+
+	wq_build_pods(wq_affn_scope);
 
 	/*
-	 * We want masks of possible CPUs of each node which isn't readily
-	 * available.  Build one from cpu_to_node() which should have been
-	 * fully initialized by now.
+	 * Also keep masks of possible CPUs of each node, which aren't
+	 * readily available, for worker_pool NUMA placement.  Build them
+	 * from cpu_to_node() which should be fully initialized by now.
 	 */
-	tbl = kzalloc(nr_node_ids * sizeof(tbl[0]), GFP_KERNEL);
-	BUG_ON(!tbl);
+	if (num_possible_nodes() > 1) {
+		tbl = kzalloc(nr_node_ids * sizeof(tbl[0]), GFP_KERNEL);
+		BUG_ON(!tbl);
 
-	for_each_node(node)
-		BUG_ON(!zalloc_cpumask_var_node(&tbl[node], GFP_KERNEL,
-				node_online(node) ? node : NUMA_NO_NODE));
+		for_each_node(node)
+			BUG_ON(!zalloc_cpumask_var_node(&tbl[node], GFP_KERNEL,
+					node_online(node) ? node : NUMA_NO_NODE));
 
-	for_each_possible_cpu(cpu) {
-		node = cpu_to_node(cpu);
-		if (WARN_ON(node == NUMA_NO_NODE)) {
-			pr_warn("workqueue: NUMA node mapping not available for cpu%d, disabling NUMA support\n", cpu);
-			/* happens iff arch is bonkers, let's just proceed */
-			return;
+		for_each_possible_cpu(cpu) {
+			node = cpu_to_node(cpu);
+			if (WARN_ON(node == NUMA_NO_NODE)) {
+				pr_warn("workqueue: NUMA node mapping not available for cpu%d\n", cpu);
+				/* happens iff arch is bonkers, let's just proceed */
+				tbl = NULL;
+				break;
+			}
+			cpumask_set_cpu(cpu, tbl[node]);
 		}
-		cpumask_set_cpu(cpu, tbl[node]);
+
+		wq_numa_possible_cpumask = tbl;
 	}
 
-	wq_numa_possible_cpumask = tbl;
-	wq_numa_enabled = true;
+	if (wq_disable_numa)
+		pr_info("workqueue: pod affinity support disabled\n");
+	else
+		wq_pods_enabled = wq_pod_count > 1;
 }
 
 static int __init init_workqueues(void)
@@ -5479,7 +5905,7 @@ static int __init init_workqueues(void)
 	cpu_notifier(workqueue_cpu_up_callback, CPU_PRI_WORKQUEUE_UP);
 	hotcpu_notifier(workqueue_cpu_down_callback, CPU_PRI_WORKQUEUE_DOWN);
 
-	wq_numa_init();
+	wq_pod_init();
 
 	/* initialize CPU pools */
 	for_each_possible_cpu(cpu) {
@@ -27,7 +27,9 @@
 /* see: Documentation/crc32.txt for a description of algorithms */
 
 #include <linux/crc32.h>
+#include <linux/jump_label.h>
 #include <linux/module.h>
+#include <linux/rcupdate.h>
 #include <linux/types.h>
 #include <linux/sched.h>
 #include "crc32defs.h"
@@ -186,7 +188,7 @@ u32 __pure crc32_le(u32 crc, unsigned char const *p, size_t len)
 {
 	return crc32_le_generic(crc, p, len, NULL, CRCPOLY_LE);
 }
-u32 __pure __crc32c_le(u32 crc, unsigned char const *p, size_t len)
+static u32 __pure crc32c_le_base(u32 crc, unsigned char const *p, size_t len)
 {
 	return crc32_le_generic(crc, p, len, NULL, CRC32C_POLY_LE);
 }
@@ -196,13 +198,73 @@ u32 __pure crc32_le(u32 crc, unsigned char const *p, size_t len)
 	return crc32_le_generic(crc, p, len,
 			(const u32 (*)[256])crc32table_le, CRCPOLY_LE);
 }
-u32 __pure __crc32c_le(u32 crc, unsigned char const *p, size_t len)
+static u32 __pure crc32c_le_base(u32 crc, unsigned char const *p, size_t len)
 {
 	return crc32_le_generic(crc, p, len,
 			(const u32 (*)[256])crc32ctable_le, CRC32C_POLY_LE);
 }
 #endif
 EXPORT_SYMBOL(crc32_le);
+
+/*
+ * Architectures with a CRC32C instruction that is usable in any context
+ * (no FPU state required) can install an accelerated implementation
+ * here. The static key keeps the no-accelerator case down to a single
+ * patched branch in front of the table-driven code.
+ */
+static DEFINE_STATIC_KEY_FALSE(crc32c_hw_key);
+static crc32c_hw_fn_t crc32c_hw_fn;
+
+/**
+ * crc32c_register_hw - install an accelerated __crc32c_le() implementation
+ * @fn: replacement for the table-driven CRC32C
+ *
+ * @fn must be callable from any context; implementations that need to
+ * save FPU or vector state belong in the crypto API instead. Only one
+ * accelerated implementation can be registered at a time.
+ */
+int crc32c_register_hw(crc32c_hw_fn_t fn)
+{
+	if (cmpxchg(&crc32c_hw_fn, NULL, fn))
+		return -EBUSY;
+	static_branch_enable(&crc32c_hw_key);
+	return 0;
+}
+EXPORT_SYMBOL(crc32c_register_hw);
+
+/**
+ * crc32c_unregister_hw - remove an accelerated __crc32c_le() implementation
+ * @fn: the implementation passed to crc32c_register_hw()
+ *
+ * Waits for in-flight users of @fn to finish, so it is safe to unload
+ * the code @fn lives in once this returns.
+ */
+void crc32c_unregister_hw(crc32c_hw_fn_t fn)
+{
+	if (WARN_ON(cmpxchg(&crc32c_hw_fn, fn, NULL) != fn))
+		return;
+	static_branch_disable(&crc32c_hw_key);
+	synchronize_rcu();
+}
+EXPORT_SYMBOL(crc32c_unregister_hw);
+
+u32 __pure __crc32c_le(u32 crc, unsigned char const *p, size_t len)
+{
+	if (static_branch_unlikely(&crc32c_hw_key)) {
+		crc32c_hw_fn_t fn;
+
+		rcu_read_lock();
+		fn = READ_ONCE(crc32c_hw_fn);
+		if (likely(fn))
+			crc = fn(crc, p, len);
+		else
+			crc = crc32c_le_base(crc, p, len);
+		rcu_read_unlock();
+		return crc;
+	}
+
+	return crc32c_le_base(crc, p, len);
+}
 EXPORT_SYMBOL(__crc32c_le);
 
 /*
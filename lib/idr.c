@@ -43,7 +43,6 @@
 static struct kmem_cache *idr_layer_cache;
 static DEFINE_PER_CPU(struct idr_layer *, idr_preload_head);
 static DEFINE_PER_CPU(int, idr_preload_cnt);
-static DEFINE_SPINLOCK(simple_ida_lock);
 
 /* the maximum ID which can be allocated given idr->layers */
 static int idr_max(int layers)
@@ -1096,7 +1095,7 @@ again:
 	if (!ida_pre_get(ida, gfp_mask))
 		return -ENOMEM;
 
-	spin_lock_irqsave(&simple_ida_lock, flags);
+	spin_lock_irqsave(&ida->simple_lock, flags);
 	ret = ida_get_new_above(ida, start, &id);
 	if (!ret) {
 		if (id > max) {
@@ -1106,7 +1105,7 @@ again:
 			ret = id;
 		}
 	}
-	spin_unlock_irqrestore(&simple_ida_lock, flags);
+	spin_unlock_irqrestore(&ida->simple_lock, flags);
 
 	if (unlikely(ret == -EAGAIN))
 		goto again;
@@ -1125,9 +1124,9 @@ void ida_simple_remove(struct ida *ida, unsigned int id)
 	unsigned long flags;
 
 	BUG_ON((int)id < 0);
-	spin_lock_irqsave(&simple_ida_lock, flags);
+	spin_lock_irqsave(&ida->simple_lock, flags);
 	ida_remove(ida, id);
-	spin_unlock_irqrestore(&simple_ida_lock, flags);
+	spin_unlock_irqrestore(&ida->simple_lock, flags);
 }
 EXPORT_SYMBOL(ida_simple_remove);
 
@@ -1142,6 +1141,6 @@ void ida_init(struct ida *ida)
 {
 	memset(ida, 0, sizeof(struct ida));
 	idr_init(&ida->idr);
-
+	spin_lock_init(&ida->simple_lock);
 }
 EXPORT_SYMBOL(ida_init);
@@ -1,5 +1,6 @@
 #include <linux/export.h>
 #include <linux/uio.h>
+#include <linux/uaccess.h>
 #include <linux/pagemap.h>
 #include <linux/slab.h>
 #include <linux/vmalloc.h>
@@ -446,6 +447,34 @@ size_t copy_from_iter_nocache(void *addr, size_t bytes, struct iov_iter *i)
 }
 EXPORT_SYMBOL(copy_from_iter_nocache);
 
+/*
+ * Like copy_to_iter(), but uses non-temporal stores for the userspace
+ * destination where the architecture has them, so that data the
+ * application will read only once is not pulled through the CPU caches
+ * on its way out.  Kernel-space destinations are copied normally.
+ */
+size_t copy_to_iter_nocache(const void *addr, size_t bytes, struct iov_iter *i)
+{
+	const char *from = addr;
+	if (unlikely(bytes > i->count))
+		bytes = i->count;
+
+	if (unlikely(!bytes))
+		return 0;
+
+	iterate_and_advance(i, bytes, v,
+		__copy_to_user_nocache(v.iov_base,
+				       (from += v.iov_len) - v.iov_len,
+				       v.iov_len),
+		memcpy_to_page(v.bv_page, v.bv_offset,
+			       (from += v.bv_len) - v.bv_len, v.bv_len),
+		memcpy(v.iov_base, (from += v.iov_len) - v.iov_len, v.iov_len)
+	)
+
+	return bytes;
+}
+EXPORT_SYMBOL(copy_to_iter_nocache);
+
 size_t copy_page_to_iter(struct page *page, size_t offset, size_t bytes,
 			 struct iov_iter *i)
 {
@@ -459,6 +488,28 @@ size_t copy_page_to_iter(struct page *page, size_t offset, size_t bytes,
 }
 EXPORT_SYMBOL(copy_page_to_iter);
 
+/*
+ * The nocache copy takes the plain kmap() route instead of the careful
+ * atomic dance in copy_page_to_iter_iovec(); callers streaming page
+ * cache data to userspace are in sleepable context anyway, and on
+ * !HIGHMEM kmap() is free.
+ */
+size_t copy_page_to_iter_nocache(struct page *page, size_t offset,
+				 size_t bytes, struct iov_iter *i)
+{
+	size_t wanted;
+	void *kaddr;
+
+	if (i->type & (ITER_BVEC|ITER_KVEC))
+		return copy_page_to_iter(page, offset, bytes, i);
+
+	kaddr = kmap(page);
+	wanted = copy_to_iter_nocache(kaddr + offset, bytes, i);
+	kunmap(page);
+	return wanted;
+}
+EXPORT_SYMBOL(copy_page_to_iter_nocache);
+
 size_t copy_page_from_iter(struct page *page, size_t offset, size_t bytes,
 			 struct iov_iter *i)
 {
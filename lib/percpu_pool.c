@@ -0,0 +1,180 @@
+/*
+ * Lock-free bounded object pool with per-CPU freelists.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ */
+
+#include <linux/export.h>
+#include <linux/irqflags.h>
+#include <linux/kernel.h>
+#include <linux/llist.h>
+#include <linux/percpu.h>
+#include <linux/percpu_pool.h>
+#include <linux/slab.h>
+#include <linux/topology.h>
+
+/*
+ * Each CPU's freelist is only ever pushed to and popped from by code
+ * running on that CPU.  llist_del_first() requires consumers to be
+ * serialized, and an interrupt taken mid-pop is effectively a second
+ * consumer, so the local list is manipulated under local_irq_save()
+ * rather than mere preemption protection.  The shared spill list is
+ * accessed only with llist_add() and llist_del_all(), which tolerate
+ * any concurrency.
+ */
+
+/**
+ * percpu_pool_init - set up an object pool in front of a kmem_cache
+ * @pool: pool to initialize
+ * @cache: backing slab cache; objects must hold at least one pointer
+ * @cpu_max: maximum number of free objects cached per CPU
+ * @spill_max: maximum number of free objects on the shared overflow list
+ */
+int percpu_pool_init(struct percpu_pool *pool, struct kmem_cache *cache,
+		     unsigned int cpu_max, unsigned int spill_max)
+{
+	int cpu;
+
+	if (kmem_cache_size(cache) < sizeof(struct llist_node))
+		return -EINVAL;
+
+	pool->cpu = alloc_percpu(struct percpu_pool_cpu);
+	if (!pool->cpu)
+		return -ENOMEM;
+
+	for_each_possible_cpu(cpu)
+		init_llist_head(&per_cpu_ptr(pool->cpu, cpu)->list);
+
+	pool->cache = cache;
+	pool->cpu_max = cpu_max;
+	pool->spill_max = spill_max;
+	init_llist_head(&pool->spill);
+	atomic_set(&pool->spill_nr, 0);
+	return 0;
+}
+EXPORT_SYMBOL(percpu_pool_init);
+
+/**
+ * percpu_pool_destroy - return all pooled objects to the slab
+ * @pool: pool to tear down
+ *
+ * The caller must guarantee that the pool is no longer in use; the
+ * backing cache itself is left alone.
+ */
+void percpu_pool_destroy(struct percpu_pool *pool)
+{
+	struct llist_node *node, *next;
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		struct percpu_pool_cpu *c = per_cpu_ptr(pool->cpu, cpu);
+
+		llist_for_each_safe(node, next, llist_del_all(&c->list))
+			kmem_cache_free(pool->cache, node);
+	}
+	llist_for_each_safe(node, next, llist_del_all(&pool->spill))
+		kmem_cache_free(pool->cache, node);
+
+	free_percpu(pool->cpu);
+	pool->cpu = NULL;
+}
+EXPORT_SYMBOL(percpu_pool_destroy);
+
+/*
+ * Grab the whole spill list and make it this CPU's freelist, returning
+ * one object from it.  Migrating free objects a batch at a time keeps
+ * the shared cacheline out of the per-object paths.
+ */
+static struct llist_node *percpu_pool_refill(struct percpu_pool *pool,
+					     struct percpu_pool_cpu *c)
+{
+	struct llist_node *node, *tail;
+	unsigned int nr = 1;
+
+	node = llist_del_all(&pool->spill);
+	if (!node)
+		return NULL;
+
+	for (tail = node; tail->next; tail = tail->next)
+		nr++;
+	atomic_sub(nr, &pool->spill_nr);
+
+	if (node->next) {
+		llist_add_batch(node->next, tail, &c->list);
+		c->nr += nr - 1;
+	}
+	return node;
+}
+
+/**
+ * percpu_pool_alloc - allocate an object
+ * @pool: pool to allocate from
+ * @gfp: allocation flags for the slab fallback
+ *
+ * Never sleeps unless @gfp allows it and both the pool and the slab
+ * fast paths come up empty.
+ */
+void *percpu_pool_alloc(struct percpu_pool *pool, gfp_t gfp)
+{
+	struct percpu_pool_cpu *c;
+	struct llist_node *node;
+	unsigned long flags;
+
+	local_irq_save(flags);
+	c = this_cpu_ptr(pool->cpu);
+	node = llist_del_first(&c->list);
+	if (node)
+		c->nr--;
+	else
+		node = percpu_pool_refill(pool, c);
+	local_irq_restore(flags);
+
+	if (node)
+		return node;
+
+	return kmem_cache_alloc_node(pool->cache, gfp, numa_node_id());
+}
+EXPORT_SYMBOL(percpu_pool_alloc);
+
+/**
+ * percpu_pool_free - return an object to the pool
+ * @pool: pool the object was allocated from
+ * @obj: object to free
+ *
+ * Objects beyond the local bound overflow to the shared spill list,
+ * from where other CPUs refill in bulk; beyond both bounds they go
+ * straight back to the slab.
+ */
+void percpu_pool_free(struct percpu_pool *pool, void *obj)
+{
+	struct llist_node *node = obj;
+	struct percpu_pool_cpu *c;
+	unsigned long flags;
+
+	local_irq_save(flags);
+	c = this_cpu_ptr(pool->cpu);
+	if (c->nr < pool->cpu_max) {
+		llist_add(node, &c->list);
+		c->nr++;
+		local_irq_restore(flags);
+		return;
+	}
+	local_irq_restore(flags);
+
+	if (atomic_read(&pool->spill_nr) < pool->spill_max) {
+		atomic_inc(&pool->spill_nr);
+		llist_add(node, &pool->spill);
+		return;
+	}
+
+	kmem_cache_free(pool->cache, obj);
+}
+EXPORT_SYMBOL(percpu_pool_free);
@@ -80,6 +80,24 @@ static inline void *indirect_to_ptr(void *ptr)
 	return (void *)((unsigned long)ptr & ~RADIX_TREE_INDIRECT_PTR);
 }
 
+/*
+ * The sibling slots of a multi-order entry contain an indirect pointer
+ * back to the canonical slot in the same node (see __radix_tree_create).
+ */
+static inline bool is_sibling_entry(struct radix_tree_node *parent, void *node)
+{
+	void **ptr = (void **)indirect_to_ptr(node);
+
+	return (parent->slots <= ptr) &&
+		(ptr < parent->slots + RADIX_TREE_MAP_SIZE);
+}
+
+static inline unsigned get_slot_offset(struct radix_tree_node *parent,
+				       void **slot)
+{
+	return slot - parent->slots;
+}
+
 static inline gfp_t root_gfp_mask(struct radix_tree_root *root)
 {
 	return root->gfp_mask & __GFP_BITS_MASK;
@@ -596,6 +614,15 @@ void *__radix_tree_lookup(struct radix_tree_root *root, unsigned long index,
 			return NULL;
 		if (!radix_tree_is_indirect_ptr(node))
 			break;
+		if (is_sibling_entry(parent, node)) {
+			/* Follow to the canonical slot of this entry */
+			slot = (void **)indirect_to_ptr(node);
+			node = rcu_dereference_raw(*slot);
+			if (node == NULL)
+				return NULL;
+			if (!radix_tree_is_indirect_ptr(node))
+				break;
+		}
 		node = indirect_to_ptr(node);
 
 		shift -= RADIX_TREE_MAP_SHIFT;
@@ -676,13 +703,24 @@ void *radix_tree_tag_set(struct radix_tree_root *root,
 	shift = (height - 1) * RADIX_TREE_MAP_SHIFT;
 
 	while (height > 0) {
+		struct radix_tree_node *node = slot;
+		void *entry;
 		int offset;
 
 		offset = (index >> shift) & RADIX_TREE_MAP_MASK;
-		if (!tag_get(slot, tag, offset))
-			tag_set(slot, tag, offset);
-		slot = slot->slots[offset];
-		BUG_ON(slot == NULL);
+		entry = node->slots[offset];
+		BUG_ON(entry == NULL);
+		if (radix_tree_is_indirect_ptr(entry) &&
+		    is_sibling_entry(node, entry)) {
+			/* tags live on the canonical slot of the entry */
+			void **sibslot = (void **)indirect_to_ptr(entry);
+
+			offset = get_slot_offset(node, sibslot);
+			entry = *sibslot;
+		}
+		if (!tag_get(node, tag, offset))
+			tag_set(node, tag, offset);
+		slot = entry;
 		if (!radix_tree_is_indirect_ptr(slot))
 			break;
 		slot = indirect_to_ptr(slot);
@@ -738,6 +776,14 @@ void *radix_tree_tag_clear(struct radix_tree_root *root,
 		offset = (index >> shift) & RADIX_TREE_MAP_MASK;
 		node = slot;
 		slot = slot->slots[offset];
+		if (radix_tree_is_indirect_ptr(slot) &&
+		    is_sibling_entry(node, slot)) {
+			/* the tag to clear sits on the canonical slot */
+			void **sibslot = (void **)indirect_to_ptr(slot);
+
+			offset = get_slot_offset(node, sibslot);
+			slot = *sibslot;
+		}
 	}
 
 	if (slot == NULL)
@@ -804,6 +850,7 @@ int radix_tree_tag_get(struct radix_tree_root *root,
 	shift = (height - 1) * RADIX_TREE_MAP_SHIFT;
 
 	for ( ; ; ) {
+		void *entry;
 		int offset;
 
 		if (node == NULL)
@@ -811,11 +858,20 @@ int radix_tree_tag_get(struct radix_tree_root *root,
 		node = indirect_to_ptr(node);
 
 		offset = (index >> shift) & RADIX_TREE_MAP_MASK;
+		entry = rcu_dereference_raw(node->slots[offset]);
+		if (radix_tree_is_indirect_ptr(entry) &&
+		    is_sibling_entry(node, entry)) {
+			/* multi-order entries are tagged on the canonical slot */
+			void **sibslot = (void **)indirect_to_ptr(entry);
+
+			offset = get_slot_offset(node, sibslot);
+			entry = rcu_dereference_raw(*sibslot);
+		}
 		if (!tag_get(node, tag, offset))
 			return 0;
 		if (height == 1)
 			return 1;
-		node = rcu_dereference_raw(node->slots[offset]);
+		node = entry;
 		if (!radix_tree_is_indirect_ptr(node))
 			return 1;
 		shift -= RADIX_TREE_MAP_SHIFT;
@@ -1502,7 +1558,13 @@ void *radix_tree_delete_item(struct radix_tree_root *root,
 		return entry;
 	}
 
-	offset = index & RADIX_TREE_MAP_MASK;
+	/*
+	 * Use the slot returned by the lookup rather than deriving the
+	 * offset from @index: for a multi-order entry @index may name any
+	 * of the sibling slots, while the tags, the sibling back-pointers
+	 * and the item itself all hang off the canonical one.
+	 */
+	offset = get_slot_offset(node, slot);
 
 	/*
 	 * Clear all tags associated with the item to be deleted.
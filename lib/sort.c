@@ -102,6 +102,71 @@ void sort(void *base, size_t num, size_t size,
 
 EXPORT_SYMBOL(sort);
 
+/*
+ * Type-specialized heapsort for plain numeric keys.  Same algorithm as
+ * sort(), but with the comparison and the swap inlined; for the common
+ * 4- and 8-byte key case this avoids two indirect calls per element
+ * visited, which is most of the cost of sorting small records.
+ */
+#define HEAPSORT_BODY(base, num, type)					\
+do {									\
+	long i = (num) / 2 - 1, n = (num), c, r;			\
+	type t;								\
+									\
+	/* heapify */							\
+	for (; i >= 0; i--) {						\
+		for (r = i; r * 2 + 1 < n; r = c) {			\
+			c = r * 2 + 1;					\
+			if (c < n - 1 && (base)[c] < (base)[c + 1])	\
+				c++;					\
+			if ((base)[r] >= (base)[c])			\
+				break;					\
+			t = (base)[r];					\
+			(base)[r] = (base)[c];				\
+			(base)[c] = t;					\
+		}							\
+	}								\
+									\
+	/* sort */							\
+	for (i = n - 1; i > 0; i--) {					\
+		t = (base)[0];						\
+		(base)[0] = (base)[i];					\
+		(base)[i] = t;						\
+		for (r = 0; r * 2 + 1 < i; r = c) {			\
+			c = r * 2 + 1;					\
+			if (c < i - 1 && (base)[c] < (base)[c + 1])	\
+				c++;					\
+			if ((base)[r] >= (base)[c])			\
+				break;					\
+			t = (base)[r];					\
+			(base)[r] = (base)[c];				\
+			(base)[c] = t;					\
+		}							\
+	}								\
+} while (0)
+
+/**
+ * sort_u32s - sort an array of u32 keys in ascending order
+ * @base: pointer to data to sort
+ * @num: number of elements
+ */
+void sort_u32s(u32 *base, size_t num)
+{
+	HEAPSORT_BODY(base, num, u32);
+}
+EXPORT_SYMBOL(sort_u32s);
+
+/**
+ * sort_u64s - sort an array of u64 keys in ascending order
+ * @base: pointer to data to sort
+ * @num: number of elements
+ */
+void sort_u64s(u64 *base, size_t num)
+{
+	HEAPSORT_BODY(base, num, u64);
+}
+EXPORT_SYMBOL(sort_u64s);
+
 #if 0
 #include <linux/slab.h>
 /* a simple boot-time regression test */
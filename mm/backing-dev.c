@@ -209,6 +209,25 @@ static ssize_t max_ratio_store(struct device *dev,
 }
 BDI_SHOW(max_ratio, bdi->max_ratio)
 
+static ssize_t nr_flushers_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t count)
+{
+	struct backing_dev_info *bdi = dev_get_drvdata(dev);
+	unsigned int nr_flushers;
+	ssize_t ret;
+
+	ret = kstrtouint(buf, 10, &nr_flushers);
+	if (ret < 0)
+		return ret;
+
+	ret = bdi_set_nr_flushers(bdi, nr_flushers);
+	if (!ret)
+		ret = count;
+
+	return ret;
+}
+BDI_SHOW(nr_flushers, bdi->nr_flushers)
+
 static ssize_t stable_pages_required_show(struct device *dev,
 					  struct device_attribute *attr,
 					  char *page)
@@ -224,6 +243,7 @@ static struct attribute *bdi_dev_attrs[] = {
 	&dev_attr_read_ahead_kb.attr,
 	&dev_attr_min_ratio.attr,
 	&dev_attr_max_ratio.attr,
+	&dev_attr_nr_flushers.attr,
 	&dev_attr_stable_pages_required.attr,
 	NULL,
 };
@@ -778,6 +798,8 @@ int bdi_init(struct backing_dev_info *bdi)
 	bdi->min_ratio = 0;
 	bdi->max_ratio = 100;
 	bdi->max_prop_frac = FPROP_FRAC_BASE;
+	bdi->nr_flushers = 1;
+	bdi->flushers = NULL;
 	INIT_LIST_HEAD(&bdi->bdi_list);
 	INIT_LIST_HEAD(&bdi->wb_list);
 	init_waitqueue_head(&bdi->wb_waitq);
@@ -841,6 +863,7 @@ void bdi_unregister(struct backing_dev_info *bdi)
 {
 	/* make sure nobody finds us on the bdi_list anymore */
 	bdi_remove_from_list(bdi);
+	bdi_set_nr_flushers(bdi, 1);
 	wb_shutdown(&bdi->wb);
 	cgwb_bdi_destroy(bdi);
 
@@ -1067,6 +1067,14 @@ typedef enum {
  */
 int sysctl_compact_unevictable_allowed __read_mostly = 1;
 
+/*
+ * Tunable for proactive compaction, 0-100.  0 disables it entirely.
+ * Higher values make kcompactd work harder in the background to keep
+ * high-order blocks available, trading migration activity for cheaper
+ * huge page allocations.
+ */
+int sysctl_compaction_proactiveness __read_mostly = 20;
+
 /*
  * Isolate all pages that can be migrated from the first suitable block,
  * starting at the block pointed to by the migrate scanner pfn within
@@ -1744,6 +1752,97 @@ static inline bool kcompactd_work_requested(pg_data_t *pgdat)
 	return pgdat->kcompactd_max_order > 0;
 }
 
+/*
+ * Proactive compaction works against fragmentation at the order huge
+ * page allocations care about, since those are what direct compaction
+ * stalls are usually taken for.
+ */
+#if defined(CONFIG_TRANSPARENT_HUGEPAGE)
+#define COMPACTION_HPAGE_ORDER	HPAGE_PMD_ORDER
+#elif defined(CONFIG_HUGETLBFS)
+#define COMPACTION_HPAGE_ORDER	HUGETLB_PAGE_ORDER
+#else
+#define COMPACTION_HPAGE_ORDER	(PMD_SHIFT - PAGE_SHIFT)
+#endif
+
+/* How often kcompactd checks node fragmentation when otherwise idle */
+#define KCOMPACTD_FRAG_CHECK_INTERVAL_MSEC	(500)
+
+/* Idle periods to skip after a proactive run that made no progress */
+#define KCOMPACTD_PROACTIVE_DEFER_MAX		(64)
+
+/*
+ * A 0-100 fragmentation score for the zone, derived from
+ * fragmentation_index() at COMPACTION_HPAGE_ORDER.  0 means a request
+ * at that order would be satisfied (or is failing for lack of memory,
+ * which compaction cannot help); 100 means maximally fragmented.
+ */
+static unsigned int fragmentation_score_zone(struct zone *zone)
+{
+	int index = fragmentation_index(zone, COMPACTION_HPAGE_ORDER);
+
+	return index < 0 ? 0 : index / 10;
+}
+
+/* The node scores as its most fragmented populated zone */
+static unsigned int fragmentation_score_node(pg_data_t *pgdat)
+{
+	unsigned int score = 0;
+	int zoneid;
+
+	for (zoneid = 0; zoneid < MAX_NR_ZONES; zoneid++) {
+		struct zone *zone = &pgdat->node_zones[zoneid];
+
+		if (!populated_zone(zone))
+			continue;
+		score = max(score, fragmentation_score_zone(zone));
+	}
+
+	return score;
+}
+
+static bool should_proactive_compact_node(pg_data_t *pgdat)
+{
+	if (!sysctl_compaction_proactiveness)
+		return false;
+
+	return fragmentation_score_node(pgdat) >
+			100 - sysctl_compaction_proactiveness;
+}
+
+static void kcompactd_proactive_do_work(pg_data_t *pgdat)
+{
+	int zoneid;
+	struct zone *zone;
+	struct compact_control cc = {
+		.order = COMPACTION_HPAGE_ORDER,
+		.classzone_idx = pgdat->nr_zones - 1,
+		.mode = MIGRATE_SYNC_LIGHT,
+		.ignore_skip_hint = true,
+	};
+
+	for (zoneid = 0; zoneid < MAX_NR_ZONES; zoneid++) {
+		zone = &pgdat->node_zones[zoneid];
+		if (!populated_zone(zone))
+			continue;
+
+		if (fragmentation_score_zone(zone) <=
+				100 - sysctl_compaction_proactiveness)
+			continue;
+
+		cc.nr_freepages = 0;
+		cc.nr_migratepages = 0;
+		cc.zone = zone;
+		INIT_LIST_HEAD(&cc.freepages);
+		INIT_LIST_HEAD(&cc.migratepages);
+
+		compact_zone(zone, &cc);
+
+		VM_BUG_ON(!list_empty(&cc.freepages));
+		VM_BUG_ON(!list_empty(&cc.migratepages));
+	}
+}
+
 static bool kcompactd_node_suitable(pg_data_t *pgdat)
 {
 	int zoneid;
@@ -1864,6 +1963,7 @@ static int kcompactd(void *p)
 {
 	pg_data_t *pgdat = (pg_data_t*)p;
 	struct task_struct *tsk = current;
+	unsigned int proactive_defer = 0;
 
 	const struct cpumask *cpumask = cpumask_of_node(pgdat->node_id);
 
@@ -1876,11 +1976,41 @@ static int kcompactd(void *p)
 	pgdat->kcompactd_classzone_idx = pgdat->nr_zones - 1;
 
 	while (!kthread_should_stop()) {
+		unsigned long timeout =
+			msecs_to_jiffies(KCOMPACTD_FRAG_CHECK_INTERVAL_MSEC);
+
 		trace_mm_compaction_kcompactd_sleep(pgdat->node_id);
-		wait_event_freezable(pgdat->kcompactd_wait,
-				kcompactd_work_requested(pgdat));
+		if (wait_event_freezable_timeout(pgdat->kcompactd_wait,
+				kcompactd_work_requested(pgdat), timeout)) {
+			kcompactd_do_work(pgdat);
+			continue;
+		}
+
+		/*
+		 * The wait timed out with nothing requested: see whether
+		 * the node has quietly fragmented and compact it in the
+		 * background before huge page allocations start stalling
+		 * in direct compaction.
+		 */
+		if (should_proactive_compact_node(pgdat)) {
+			unsigned int score;
+
+			if (proactive_defer) {
+				proactive_defer--;
+				continue;
+			}
 
-		kcompactd_do_work(pgdat);
+			score = fragmentation_score_node(pgdat);
+			kcompactd_proactive_do_work(pgdat);
+
+			/*
+			 * Back off when no progress is being made, e.g.
+			 * because memory is pinned or kcompactd keeps
+			 * racing with a heavy allocator.
+			 */
+			if (fragmentation_score_node(pgdat) >= score)
+				proactive_defer = KCOMPACTD_PROACTIVE_DEFER_MAX;
+		}
 	}
 
 	return 0;
@@ -1584,6 +1584,69 @@ static void shrink_readahead_size_eio(struct file *filp,
 	ra->ra_pages /= 4;
 }
 
+/**
+ * read_batch_release - drop the unconsumed tail of a read batch
+ * @pvec: batch of pages obtained by read_batch_next()
+ * @pvec_idx: position of the first unconsumed page
+ *
+ * Every page in the batch carries a reference from the lookup; release
+ * the ones that were never handed out.
+ */
+static void read_batch_release(struct pagevec *pvec, unsigned int *pvec_idx)
+{
+	while (*pvec_idx < pvec->nr)
+		page_cache_release(pvec->pages[(*pvec_idx)++]);
+	pagevec_reinit(pvec);
+	*pvec_idx = 0;
+}
+
+/**
+ * read_batch_next - get the page at @index from a batch of lookups
+ * @pvec: batch storage, caller initialized
+ * @pvec_idx: position of the next unconsumed page in @pvec
+ * @mapping: the address_space to search
+ * @index: the page cache index wanted
+ * @last_index: first index beyond the read, bounds the batch refill
+ *
+ * A sequential read pays one radix tree descent per page when it uses
+ * find_get_page(). Amortize the descents by looking up a pagevec's worth
+ * of contiguous pages at once and handing them out one at a time.
+ *
+ * The reference on the returned page is transferred to the caller, who
+ * disposes of it exactly as if it came from find_get_page(). If a retry
+ * or truncation moved @index off the front of the batch, the stale batch
+ * is dropped and refilled.
+ *
+ * Returns NULL if there is no page at @index (the batch refill stops at
+ * holes and exceptional entries, like find_get_pages_contig()).
+ */
+static struct page *read_batch_next(struct pagevec *pvec,
+				    unsigned int *pvec_idx,
+				    struct address_space *mapping,
+				    pgoff_t index, pgoff_t last_index)
+{
+	struct page *page;
+
+	if (*pvec_idx < pvec->nr) {
+		page = pvec->pages[*pvec_idx];
+		if (page->index == index) {
+			(*pvec_idx)++;
+			return page;
+		}
+		read_batch_release(pvec, pvec_idx);
+	}
+
+	pvec->nr = find_get_pages_contig(mapping, index,
+			min_t(unsigned long, last_index - index, PAGEVEC_SIZE),
+			pvec->pages);
+	*pvec_idx = 0;
+	if (!pvec->nr)
+		return NULL;
+
+	(*pvec_idx)++;
+	return pvec->pages[0];
+}
+
 /**
  * do_generic_file_read - generic file read routine
  * @filp:	the file to read
@@ -1603,6 +1666,8 @@ static ssize_t do_generic_file_read(struct file *filp, loff_t *ppos,
 	struct address_space *mapping = filp->f_mapping;
 	struct inode *inode = mapping->host;
 	struct file_ra_state *ra = &filp->f_ra;
+	struct pagevec pvec;
+	unsigned int pvec_idx = 0;
 	pgoff_t index;
 	pgoff_t last_index;
 	pgoff_t prev_index;
@@ -1610,6 +1675,7 @@ static ssize_t do_generic_file_read(struct file *filp, loff_t *ppos,
 	unsigned int prev_offset;
 	int error = 0;
 
+	pagevec_init(&pvec, 0);
 	index = *ppos >> PAGE_CACHE_SHIFT;
 	prev_index = ra->prev_pos >> PAGE_CACHE_SHIFT;
 	prev_offset = ra->prev_pos & (PAGE_CACHE_SIZE-1);
@@ -1624,12 +1690,14 @@ static ssize_t do_generic_file_read(struct file *filp, loff_t *ppos,
 
 		cond_resched();
 find_page:
-		page = find_get_page(mapping, index);
+		page = read_batch_next(&pvec, &pvec_idx, mapping,
+					index, last_index);
 		if (!page) {
 			page_cache_sync_readahead(mapping,
 					ra, filp,
 					index, last_index - index);
-			page = find_get_page(mapping, index);
+			page = read_batch_next(&pvec, &pvec_idx, mapping,
+						index, last_index);
 			if (unlikely(page == NULL))
 				goto no_cached_page;
 		}
@@ -1816,6 +1884,7 @@ no_cached_page:
 	}
 
 out:
+	read_batch_release(&pvec, &pvec_idx);
 	ra->prev_pos = prev_index;
 	ra->prev_pos <<= PAGE_CACHE_SHIFT;
 	ra->prev_pos |= prev_offset;
@@ -23,6 +23,7 @@
 #include <linux/swapops.h>
 #include <linux/page-isolation.h>
 #include <linux/jhash.h>
+#include <linux/workqueue.h>
 
 #include <asm/page.h>
 #include <asm/pgtable.h>
@@ -1129,8 +1130,46 @@ static int alloc_fresh_gigantic_page(struct hstate *h,
 }
 
 static inline bool gigantic_page_supported(void) { return true; }
+
+/*
+ * Last resort for surplus pool growth on a fragmented system: carve a
+ * huge page sized block out of a movable zone with alloc_contig_range(),
+ * which migrates whatever sits in the way, give the block back to the
+ * buddy allocator and immediately re-request it as a regular compound
+ * allocation. The round trip through the buddy keeps the page on the
+ * normal hugetlb free path; the window in which another order-9 request
+ * could steal the block is covered by a few retries.
+ */
+#define HUGETLB_CONTIG_RETRIES	3
+
+static struct page *alloc_buddy_huge_page_contig(struct hstate *h,
+						 gfp_t gfp, int nid)
+{
+	int order = huge_page_order(h);
+	int scan_nid = (nid == NUMA_NO_NODE) ? numa_node_id() : nid;
+	struct page *page;
+	int i;
+
+	for (i = 0; i < HUGETLB_CONTIG_RETRIES; i++) {
+		page = alloc_gigantic_page(scan_nid, order);
+		if (!page)
+			return NULL;
+
+		free_contig_range(page_to_pfn(page), 1 << order);
+		page = alloc_pages_node(nid, gfp & ~__GFP_REPEAT, order);
+		if (page)
+			return page;
+	}
+
+	return NULL;
+}
 #else
 static inline bool gigantic_page_supported(void) { return false; }
+static inline struct page *alloc_buddy_huge_page_contig(struct hstate *h,
+						gfp_t gfp, int nid)
+{
+	return NULL;
+}
 static inline void free_gigantic_page(struct page *page, unsigned int order) { }
 static inline void destroy_compound_gigantic_page(struct page *page,
 						unsigned int order) { }
@@ -1569,6 +1608,16 @@ static struct page *__alloc_buddy_huge_page(struct hstate *h,
 	spin_unlock(&hugetlb_lock);
 
 	page = __hugetlb_alloc_buddy_huge_page(h, vma, addr, nid);
+	/*
+	 * A fragmented buddy allocator often cannot serve huge page
+	 * orders directly anymore. Fall back to migrating a block free
+	 * before giving up; the mempolicy is not honoured on this path,
+	 * a remote huge page beats a failed pod start.
+	 */
+	if (!page)
+		page = alloc_buddy_huge_page_contig(h,
+				htlb_alloc_mask(h)|__GFP_COMP|__GFP_NOWARN,
+				nid);
 
 	spin_lock(&hugetlb_lock);
 	if (page) {
@@ -1615,6 +1664,69 @@ struct page *__alloc_buddy_huge_page_with_mpol(struct hstate *h,
 	return __alloc_buddy_huge_page(h, vma, addr, NUMA_NO_NODE);
 }
 
+/*
+ * Asynchronous pool pre-growth. When pregrow_hugepages is set for an
+ * hstate, the worker below keeps at least that many free pages beyond
+ * the current reservations by allocating surplus pages in the
+ * background, within the usual nr_overcommit limit. That takes the
+ * order-9 allocation (and its possible compaction stall) off the
+ * reservation path of the next starting job. Pre-grown pages are
+ * surplus pages like any other: consumed by reservations first and
+ * returned to the buddy once reservations go away again.
+ */
+static void hugetlb_pregrow_work_fn(struct work_struct *work)
+{
+	struct hstate *h;
+
+	for_each_hstate(h) {
+		if (hstate_is_gigantic(h) || !h->pregrow_huge_pages)
+			continue;
+
+		for (;;) {
+			struct page *page;
+			bool needed;
+
+			spin_lock(&hugetlb_lock);
+			needed = h->free_huge_pages <
+					h->resv_huge_pages +
+					h->pregrow_huge_pages &&
+				 h->surplus_huge_pages <
+					h->nr_overcommit_huge_pages;
+			spin_unlock(&hugetlb_lock);
+			if (!needed)
+				break;
+
+			page = __alloc_buddy_huge_page_no_mpol(h,
+							       NUMA_NO_NODE);
+			if (!page)
+				break;
+
+			spin_lock(&hugetlb_lock);
+			/*
+			 * The page is now managed by the hugetlb allocator
+			 * and has no users -- drop the buddy allocator's
+			 * reference.
+			 */
+			put_page_testzero(page);
+			VM_BUG_ON_PAGE(page_count(page), page);
+			enqueue_huge_page(h, page);
+			spin_unlock(&hugetlb_lock);
+
+			cond_resched();
+		}
+	}
+}
+
+static DECLARE_WORK(hugetlb_pregrow_work, hugetlb_pregrow_work_fn);
+
+/* Called with hugetlb_lock held after free pages have been consumed */
+static void hugetlb_check_pregrow(struct hstate *h)
+{
+	if (h->pregrow_huge_pages &&
+	    h->free_huge_pages < h->resv_huge_pages + h->pregrow_huge_pages)
+		schedule_work(&hugetlb_pregrow_work);
+}
+
 /*
  * This allocation function is useful in the context where vma is irrelevant.
  * E.g. soft-offlining uses this function because it only cares physical
@@ -1905,6 +2017,7 @@ struct page *alloc_huge_page(struct vm_area_struct *vma,
 		/* Fall through */
 	}
 	hugetlb_cgroup_commit_charge(idx, pages_per_huge_page(h), h_cg, page);
+	hugetlb_check_pregrow(h);
 	spin_unlock(&hugetlb_lock);
 
 	set_page_private(page, (unsigned long)spool);
@@ -2380,6 +2493,38 @@ static ssize_t nr_overcommit_hugepages_store(struct kobject *kobj,
 }
 HSTATE_ATTR(nr_overcommit_hugepages);
 
+static ssize_t pregrow_hugepages_show(struct kobject *kobj,
+					struct kobj_attribute *attr, char *buf)
+{
+	struct hstate *h = kobj_to_hstate(kobj, NULL);
+	return sprintf(buf, "%lu\n", h->pregrow_huge_pages);
+}
+
+static ssize_t pregrow_hugepages_store(struct kobject *kobj,
+		struct kobj_attribute *attr, const char *buf, size_t count)
+{
+	int err;
+	unsigned long input;
+	struct hstate *h = kobj_to_hstate(kobj, NULL);
+
+	if (hstate_is_gigantic(h))
+		return -EINVAL;
+
+	err = kstrtoul(buf, 10, &input);
+	if (err)
+		return err;
+
+	spin_lock(&hugetlb_lock);
+	h->pregrow_huge_pages = input;
+	spin_unlock(&hugetlb_lock);
+
+	if (input)
+		schedule_work(&hugetlb_pregrow_work);
+
+	return count;
+}
+HSTATE_ATTR(pregrow_hugepages);
+
 static ssize_t free_hugepages_show(struct kobject *kobj,
 					struct kobj_attribute *attr, char *buf)
 {
@@ -2425,6 +2570,7 @@ HSTATE_ATTR_RO(surplus_hugepages);
 static struct attribute *hstate_attrs[] = {
 	&nr_hugepages_attr.attr,
 	&nr_overcommit_hugepages_attr.attr,
+	&pregrow_hugepages_attr.attr,
 	&free_hugepages_attr.attr,
 	&resv_hugepages_attr.attr,
 	&surplus_hugepages_attr.attr,
@@ -2915,6 +3061,8 @@ static int hugetlb_acct_memory(struct hstate *h, long delta)
 	}
 
 	ret = 0;
+	if (delta > 0)
+		hugetlb_check_pregrow(h);
 	if (delta < 0)
 		return_unused_surplus_pages(h, (unsigned long) -delta);
 
@@ -104,6 +104,10 @@ struct mm_slot {
 	struct list_head mm_list;
 	struct rmap_item *rmap_list;
 	struct mm_struct *mm;
+	/* shared+sharing count when the current pass over this mm began */
+	unsigned long pages_base;
+	/* full passes left to skip because the last one merged nothing */
+	unsigned int skip_count;
 };
 
 /**
@@ -252,6 +256,12 @@ static unsigned int ksm_thread_pages_to_scan = 100;
 /* Milliseconds ksmd should sleep between batches */
 static unsigned int ksm_thread_sleep_millisecs = 20;
 
+/* Skip mms whose last full pass produced no new merges */
+static unsigned int ksm_smart_scan = 1;
+
+/* Full passes to skip for an mm that is not producing merges */
+#define KSM_SMART_SCAN_SKIP	3
+
 #ifdef CONFIG_NUMA
 /* Zeroed when merging across nodes is not allowed */
 static unsigned int ksm_merge_across_nodes = 1;
@@ -2062,6 +2072,26 @@ static struct rmap_item *scan_get_next_rmap_item(struct page **page)
 next_mm:
 		ksm_scan.address = 0;
 		ksm_scan.rmap_list = &slot->rmap_list;
+
+		/*
+		 * Concentrate scan capacity on address spaces that are
+		 * actually producing matches: an mm whose previous full
+		 * pass merged nothing sits out a few rounds.
+		 */
+		if (ksm_smart_scan && slot->skip_count) {
+			slot->skip_count--;
+			spin_lock(&ksm_mmlist_lock);
+			slot = list_entry(slot->mm_list.next,
+					  struct mm_slot, mm_list);
+			ksm_scan.mm_slot = slot;
+			spin_unlock(&ksm_mmlist_lock);
+			if (slot == &ksm_mm_head) {
+				ksm_scan.seqnr++;
+				return NULL;
+			}
+			goto next_mm;
+		}
+		slot->pages_base = ksm_pages_shared + ksm_pages_sharing;
 	}
 
 	mm = slot->mm;
@@ -2140,6 +2170,15 @@ next_mm:
 		up_read(&mm->mmap_sem);
 		mmdrop(mm);
 	} else {
+		/*
+		 * Full pass over this mm completed: decide whether it
+		 * has earned another prompt visit.  Counter noise from
+		 * sharing broken elsewhere only delays a busy mm by one
+		 * round, so keep this simple.
+		 */
+		if (ksm_smart_scan &&
+		    ksm_pages_shared + ksm_pages_sharing <= slot->pages_base)
+			slot->skip_count = KSM_SMART_SCAN_SKIP;
 		spin_unlock(&ksm_mmlist_lock);
 		up_read(&mm->mmap_sem);
 	}
@@ -2633,6 +2672,29 @@ static ssize_t pages_to_scan_store(struct kobject *kobj,
 }
 KSM_ATTR(pages_to_scan);
 
+static ssize_t smart_scan_show(struct kobject *kobj,
+			       struct kobj_attribute *attr, char *buf)
+{
+	return sprintf(buf, "%u\n", ksm_smart_scan);
+}
+
+static ssize_t smart_scan_store(struct kobject *kobj,
+				struct kobj_attribute *attr,
+				const char *buf, size_t count)
+{
+	int err;
+	unsigned long value;
+
+	err = kstrtoul(buf, 10, &value);
+	if (err || value > 1)
+		return -EINVAL;
+
+	ksm_smart_scan = value;
+
+	return count;
+}
+KSM_ATTR(smart_scan);
+
 static ssize_t run_show(struct kobject *kobj, struct kobj_attribute *attr,
 			char *buf)
 {
@@ -2868,6 +2930,7 @@ KSM_ATTR_RO(full_scans);
 static struct attribute *ksm_attrs[] = {
 	&sleep_millisecs_attr.attr,
 	&pages_to_scan_attr.attr,
+	&smart_scan_attr.attr,
 	&run_attr.attr,
 	&pages_shared_attr.attr,
 	&pages_sharing_attr.attr,
@@ -671,6 +671,83 @@ static unsigned long mem_cgroup_nr_lru_pages(struct mem_cgroup *memcg,
 	return nr;
 }
 
+/*
+ * Refreshing the hierarchically pre-aggregated snapshots costs one walk
+ * over the entire memcg tree, so it is done at most once per
+ * MEMCG_SNAP_FLUSH_INTERVAL: periodically from a worker and on demand
+ * from rate-limited readers. In between, reads are served from the last
+ * snapshot in O(1), with an error bounded by one interval's worth of
+ * per-cpu updates.
+ */
+#define MEMCG_SNAP_FLUSH_INTERVAL	(2UL * HZ)
+
+static DEFINE_MUTEX(memcg_snap_mutex);
+static unsigned long memcg_snap_jiffies;
+
+static void memcg_snap_flush(void)
+{
+	struct cgroup_subsys_state *css;
+
+	if (!root_mem_cgroup)
+		return;
+
+	mutex_lock(&memcg_snap_mutex);
+	rcu_read_lock();
+	css_for_each_descendant_post(css, &root_mem_cgroup->css) {
+		struct mem_cgroup *memcg = mem_cgroup_from_css(css);
+		unsigned long stat[MEMCG_NR_STAT];
+		unsigned long events[MEMCG_NR_EVENTS];
+		unsigned long lru[NR_LRU_LISTS];
+		struct cgroup_subsys_state *child;
+		int i;
+
+		for (i = 0; i < MEMCG_NR_STAT; i++)
+			stat[i] = mem_cgroup_read_stat(memcg, i);
+		for (i = 0; i < MEMCG_NR_EVENTS; i++)
+			events[i] = mem_cgroup_read_events(memcg, i);
+		for (i = 0; i < NR_LRU_LISTS; i++)
+			lru[i] = mem_cgroup_nr_lru_pages(memcg, BIT(i));
+
+		/* Post-order walk: the children's snapshots are fresh */
+		css_for_each_child(child, css) {
+			struct mem_cgroup *mi = mem_cgroup_from_css(child);
+
+			for (i = 0; i < MEMCG_NR_STAT; i++)
+				stat[i] += READ_ONCE(mi->snap_stat[i]);
+			for (i = 0; i < MEMCG_NR_EVENTS; i++)
+				events[i] += READ_ONCE(mi->snap_events[i]);
+			for (i = 0; i < NR_LRU_LISTS; i++)
+				lru[i] += READ_ONCE(mi->snap_lru[i]);
+		}
+
+		for (i = 0; i < MEMCG_NR_STAT; i++)
+			WRITE_ONCE(memcg->snap_stat[i], stat[i]);
+		for (i = 0; i < MEMCG_NR_EVENTS; i++)
+			WRITE_ONCE(memcg->snap_events[i], events[i]);
+		for (i = 0; i < NR_LRU_LISTS; i++)
+			WRITE_ONCE(memcg->snap_lru[i], lru[i]);
+	}
+	rcu_read_unlock();
+	memcg_snap_jiffies = jiffies;
+	mutex_unlock(&memcg_snap_mutex);
+}
+
+static void memcg_snap_flush_ratelimited(void)
+{
+	if (time_after(jiffies,
+		       memcg_snap_jiffies + MEMCG_SNAP_FLUSH_INTERVAL))
+		memcg_snap_flush();
+}
+
+static void memcg_snap_work_fn(struct work_struct *work);
+static DECLARE_DELAYED_WORK(memcg_snap_work, memcg_snap_work_fn);
+
+static void memcg_snap_work_fn(struct work_struct *work)
+{
+	memcg_snap_flush();
+	schedule_delayed_work(&memcg_snap_work, MEMCG_SNAP_FLUSH_INTERVAL);
+}
+
 static bool mem_cgroup_event_ratelimit(struct mem_cgroup *memcg,
 				       enum mem_cgroup_events_target target)
 {
@@ -741,6 +818,28 @@ struct mem_cgroup *mem_cgroup_from_task(struct task_struct *p)
 }
 EXPORT_SYMBOL(mem_cgroup_from_task);
 
+/*
+ * Called from the page allocator slowpath when an allocation went into
+ * direct compaction or reclaim.  The stall is charged to the allocating
+ * task's memcg: unlike page counters, latency is suffered by whoever
+ * asked, not by whoever ends up owning the page.
+ */
+void mem_cgroup_account_alloc_stall(u64 delta_ns)
+{
+	struct mem_cgroup *memcg;
+
+	if (mem_cgroup_disabled())
+		return;
+
+	rcu_read_lock();
+	memcg = mem_cgroup_from_task(current);
+	if (likely(memcg)) {
+		atomic64_inc(&memcg->alloc_stall);
+		atomic64_add(delta_ns, &memcg->alloc_stall_ns);
+	}
+	rcu_read_unlock();
+}
+
 static struct mem_cgroup *get_mem_cgroup_from_mm(struct mm_struct *mm)
 {
 	struct mem_cgroup *memcg = NULL;
@@ -2719,28 +2818,22 @@ static int mem_cgroup_hierarchy_write(struct cgroup_subsys_state *css,
 
 static void tree_stat(struct mem_cgroup *memcg, unsigned long *stat)
 {
-	struct mem_cgroup *iter;
 	int i;
 
-	memset(stat, 0, sizeof(*stat) * MEMCG_NR_STAT);
+	memcg_snap_flush_ratelimited();
 
-	for_each_mem_cgroup_tree(iter, memcg) {
-		for (i = 0; i < MEMCG_NR_STAT; i++)
-			stat[i] += mem_cgroup_read_stat(iter, i);
-	}
+	for (i = 0; i < MEMCG_NR_STAT; i++)
+		stat[i] = READ_ONCE(memcg->snap_stat[i]);
 }
 
 static void tree_events(struct mem_cgroup *memcg, unsigned long *events)
 {
-	struct mem_cgroup *iter;
 	int i;
 
-	memset(events, 0, sizeof(*events) * MEMCG_NR_EVENTS);
+	memcg_snap_flush_ratelimited();
 
-	for_each_mem_cgroup_tree(iter, memcg) {
-		for (i = 0; i < MEMCG_NR_EVENTS; i++)
-			events[i] += mem_cgroup_read_events(iter, i);
-	}
+	for (i = 0; i < MEMCG_NR_EVENTS; i++)
+		events[i] = READ_ONCE(memcg->snap_events[i]);
 }
 
 static unsigned long mem_cgroup_usage(struct mem_cgroup *memcg, bool swap)
@@ -2748,17 +2841,15 @@ static unsigned long mem_cgroup_usage(struct mem_cgroup *memcg, bool swap)
 	unsigned long val = 0;
 
 	if (mem_cgroup_is_root(memcg)) {
-		struct mem_cgroup *iter;
-
-		for_each_mem_cgroup_tree(iter, memcg) {
-			val += mem_cgroup_read_stat(iter,
-					MEM_CGROUP_STAT_CACHE);
-			val += mem_cgroup_read_stat(iter,
-					MEM_CGROUP_STAT_RSS);
-			if (swap)
-				val += mem_cgroup_read_stat(iter,
-						MEM_CGROUP_STAT_SWAP);
-		}
+		/*
+		 * Served from the snapshot without a synchronous refresh:
+		 * this can be reached from the threshold notification path,
+		 * which must not block on the flush mutex.
+		 */
+		val += READ_ONCE(memcg->snap_stat[MEM_CGROUP_STAT_CACHE]);
+		val += READ_ONCE(memcg->snap_stat[MEM_CGROUP_STAT_RSS]);
+		if (swap)
+			val += READ_ONCE(memcg->snap_stat[MEM_CGROUP_STAT_SWAP]);
 	} else {
 		if (!swap)
 			val = page_counter_read(&memcg->memory);
@@ -3156,6 +3247,11 @@ static int memcg_stat_show(struct seq_file *m, void *v)
 		seq_printf(m, "%s %lu\n", mem_cgroup_lru_names[i],
 			   mem_cgroup_nr_lru_pages(memcg, BIT(i)) * PAGE_SIZE);
 
+	seq_printf(m, "alloc_stall %llu\n",
+		   (u64)atomic64_read(&memcg->alloc_stall));
+	seq_printf(m, "alloc_stall_ns %llu\n",
+		   (u64)atomic64_read(&memcg->alloc_stall_ns));
+
 	/* Hierarchical information */
 	memory = memsw = PAGE_COUNTER_MAX;
 	for (mi = memcg; mi; mi = parent_mem_cgroup(mi)) {
@@ -3168,31 +3264,32 @@ static int memcg_stat_show(struct seq_file *m, void *v)
 		seq_printf(m, "hierarchical_memsw_limit %llu\n",
 			   (u64)memsw * PAGE_SIZE);
 
-	for (i = 0; i < MEM_CGROUP_STAT_NSTATS; i++) {
-		unsigned long long val = 0;
+	memcg_snap_flush_ratelimited();
 
+	for (i = 0; i < MEM_CGROUP_STAT_NSTATS; i++) {
 		if (i == MEM_CGROUP_STAT_SWAP && !do_memsw_account())
 			continue;
-		for_each_mem_cgroup_tree(mi, memcg)
-			val += mem_cgroup_read_stat(mi, i) * PAGE_SIZE;
-		seq_printf(m, "total_%s %llu\n", mem_cgroup_stat_names[i], val);
+		seq_printf(m, "total_%s %llu\n", mem_cgroup_stat_names[i],
+			   (u64)READ_ONCE(memcg->snap_stat[i]) * PAGE_SIZE);
 	}
 
-	for (i = 0; i < MEM_CGROUP_EVENTS_NSTATS; i++) {
-		unsigned long long val = 0;
+	for (i = 0; i < MEM_CGROUP_EVENTS_NSTATS; i++)
+		seq_printf(m, "total_%s %llu\n", mem_cgroup_events_names[i],
+			   (u64)READ_ONCE(memcg->snap_events[i]));
 
-		for_each_mem_cgroup_tree(mi, memcg)
-			val += mem_cgroup_read_events(mi, i);
-		seq_printf(m, "total_%s %llu\n",
-			   mem_cgroup_events_names[i], val);
-	}
+	for (i = 0; i < NR_LRU_LISTS; i++)
+		seq_printf(m, "total_%s %llu\n", mem_cgroup_lru_names[i],
+			   (u64)READ_ONCE(memcg->snap_lru[i]) * PAGE_SIZE);
 
-	for (i = 0; i < NR_LRU_LISTS; i++) {
-		unsigned long long val = 0;
+	{
+		u64 stalls = 0, stall_ns = 0;
 
-		for_each_mem_cgroup_tree(mi, memcg)
-			val += mem_cgroup_nr_lru_pages(mi, BIT(i)) * PAGE_SIZE;
-		seq_printf(m, "total_%s %llu\n", mem_cgroup_lru_names[i], val);
+		for_each_mem_cgroup_tree(mi, memcg) {
+			stalls += atomic64_read(&mi->alloc_stall);
+			stall_ns += atomic64_read(&mi->alloc_stall_ns);
+		}
+		seq_printf(m, "total_alloc_stall %llu\n", stalls);
+		seq_printf(m, "total_alloc_stall_ns %llu\n", stall_ns);
 	}
 
 #ifdef CONFIG_DEBUG_VM
@@ -3223,6 +3320,55 @@ static int memcg_stat_show(struct seq_file *m, void *v)
 	return 0;
 }
 
+/*
+ * One-read bulk snapshot of the whole hierarchy for monitoring agents:
+ * one line per cgroup, hierarchically aggregated counters, so scraping
+ * thousands of groups costs a single tree walk instead of one stat
+ * file read (and one subtree walk) each.
+ */
+static int memcg_stat_all_show(struct seq_file *m, void *v)
+{
+	struct mem_cgroup *root = mem_cgroup_from_css(seq_css(m));
+	struct cgroup_subsys_state *css;
+	char *path;
+	int i;
+
+	path = kmalloc(PATH_MAX, GFP_KERNEL);
+	if (!path)
+		return -ENOMEM;
+
+	memcg_snap_flush_ratelimited();
+
+	rcu_read_lock();
+	css_for_each_descendant_pre(css, &root->css) {
+		struct mem_cgroup *memcg = mem_cgroup_from_css(css);
+
+		if (!cgroup_path(css->cgroup, path, PATH_MAX))
+			continue;
+
+		seq_printf(m, "%s", path);
+		for (i = 0; i < MEM_CGROUP_STAT_NSTATS; i++) {
+			if (i == MEM_CGROUP_STAT_SWAP && !do_memsw_account())
+				continue;
+			seq_printf(m, " %s=%llu", mem_cgroup_stat_names[i],
+				   (u64)READ_ONCE(memcg->snap_stat[i]) *
+				   PAGE_SIZE);
+		}
+		for (i = 0; i < MEM_CGROUP_EVENTS_NSTATS; i++)
+			seq_printf(m, " %s=%llu", mem_cgroup_events_names[i],
+				   (u64)READ_ONCE(memcg->snap_events[i]));
+		for (i = 0; i < NR_LRU_LISTS; i++)
+			seq_printf(m, " %s=%llu", mem_cgroup_lru_names[i],
+				   (u64)READ_ONCE(memcg->snap_lru[i]) *
+				   PAGE_SIZE);
+		seq_putc(m, '\n');
+	}
+	rcu_read_unlock();
+
+	kfree(path);
+	return 0;
+}
+
 static u64 mem_cgroup_swappiness_read(struct cgroup_subsys_state *css,
 				      struct cftype *cft)
 {
@@ -3941,6 +4087,11 @@ static struct cftype mem_cgroup_legacy_files[] = {
 		.name = "stat",
 		.seq_show = memcg_stat_show,
 	},
+	{
+		.name = "stat_all",
+		.flags = CFTYPE_ONLY_ON_ROOT,
+		.seq_show = memcg_stat_all_show,
+	},
 	{
 		.name = "force_empty",
 		.write = mem_cgroup_force_empty_write,
@@ -5706,6 +5857,8 @@ static int __init mem_cgroup_init(void)
 		soft_limit_tree.rb_tree_per_node[node] = rtpn;
 	}
 
+	schedule_delayed_work(&memcg_snap_work, MEMCG_SNAP_FLUSH_INTERVAL);
+
 	return 0;
 }
 subsys_initcall(mem_cgroup_init);
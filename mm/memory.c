@@ -989,11 +989,132 @@ static inline int copy_pud_range(struct mm_struct *dst_mm, struct mm_struct *src
 	return 0;
 }
 
-int copy_page_range(struct mm_struct *dst_mm, struct mm_struct *src_mm,
-		struct vm_area_struct *vma)
+static int copy_page_range_chunk(struct mm_struct *dst_mm,
+		struct mm_struct *src_mm, struct vm_area_struct *vma,
+		unsigned long addr, unsigned long end)
 {
 	pgd_t *src_pgd, *dst_pgd;
 	unsigned long next;
+
+	dst_pgd = pgd_offset(dst_mm, addr);
+	src_pgd = pgd_offset(src_mm, addr);
+	do {
+		next = pgd_addr_end(addr, end);
+		if (pgd_none_or_clear_bad(src_pgd))
+			continue;
+		if (unlikely(copy_pud_range(dst_mm, src_mm, dst_pgd, src_pgd,
+					    vma, addr, next)))
+			return -ENOMEM;
+	} while (dst_pgd++, src_pgd++, addr = next, addr != end);
+	return 0;
+}
+
+#ifdef CONFIG_SMP
+/*
+ * Fork of a huge process spends seconds in copy_page_range() walking
+ * and write-protecting every pte from one CPU. The walk parallelizes
+ * cleanly in chunks that never share a page table page: the
+ * destination mm is private to the forking task until fork returns,
+ * concurrent pud/pmd/pte allocations for distinct ranges are already
+ * serialized by mm->page_table_lock and the split pte locks, and the
+ * workers only hold spinlocks so they need no mmap_sem of their own.
+ * Chunk boundaries sit on the PUD grid so no two workers ever touch
+ * the same pmd or pte table.
+ */
+#define COPY_RANGE_CHUNK_SIZE	PUD_SIZE
+#define COPY_RANGE_MIN_CHUNKS	4
+
+struct copy_range_work {
+	struct work_struct work;
+	struct mm_struct *dst_mm;
+	struct mm_struct *src_mm;
+	struct vm_area_struct *vma;
+	unsigned long addr;
+	unsigned long end;
+	atomic_t *pending;
+	struct completion *done;
+	int *err;
+};
+
+static void copy_range_worker(struct work_struct *work)
+{
+	struct copy_range_work *crw =
+		container_of(work, struct copy_range_work, work);
+
+	if (copy_page_range_chunk(crw->dst_mm, crw->src_mm, crw->vma,
+				  crw->addr, crw->end))
+		WRITE_ONCE(*crw->err, -ENOMEM);
+	if (atomic_dec_and_test(crw->pending))
+		complete(crw->done);
+}
+
+/*
+ * Returns -EAGAIN if the copy was not attempted and the caller should
+ * fall back to the synchronous walk.
+ */
+static int copy_page_range_parallel(struct mm_struct *dst_mm,
+		struct mm_struct *src_mm, struct vm_area_struct *vma,
+		unsigned long addr, unsigned long end)
+{
+	DECLARE_COMPLETION_ONSTACK(done);
+	struct copy_range_work *works;
+	atomic_t pending;
+	int err = 0;
+	int nr = 0;
+	int i;
+
+	if (end - addr < COPY_RANGE_MIN_CHUNKS * COPY_RANGE_CHUNK_SIZE)
+		return -EAGAIN;
+
+	/*
+	 * One chunk per PUD granule the range touches, not per granule
+	 * of length: an unaligned start adds a short head chunk on top
+	 * of (end - addr) / CHUNK_SIZE full-size ones.
+	 */
+	works = kmalloc_array(((end - 1) >> PUD_SHIFT) -
+			      (addr >> PUD_SHIFT) + 1,
+			      sizeof(*works), GFP_KERNEL);
+	if (!works)
+		return -EAGAIN;
+
+	while (addr < end) {
+		unsigned long chunk_end =
+			min(ALIGN(addr + 1, COPY_RANGE_CHUNK_SIZE), end);
+
+		works[nr].dst_mm = dst_mm;
+		works[nr].src_mm = src_mm;
+		works[nr].vma = vma;
+		works[nr].addr = addr;
+		works[nr].end = chunk_end;
+		works[nr].pending = &pending;
+		works[nr].done = &done;
+		works[nr].err = &err;
+		nr++;
+		addr = chunk_end;
+	}
+
+	atomic_set(&pending, nr);
+	for (i = 0; i < nr; i++) {
+		INIT_WORK(&works[i].work, copy_range_worker);
+		queue_work(system_unbound_wq, &works[i].work);
+	}
+	wait_for_completion(&done);
+
+	kfree(works);
+	return READ_ONCE(err);
+}
+#else
+static int copy_page_range_parallel(struct mm_struct *dst_mm,
+		struct mm_struct *src_mm, struct vm_area_struct *vma,
+		unsigned long addr, unsigned long end)
+{
+	return -EAGAIN;
+}
+#endif /* CONFIG_SMP */
+
+int copy_page_range(struct mm_struct *dst_mm, struct mm_struct *src_mm,
+		struct vm_area_struct *vma)
+{
 	unsigned long addr = vma->vm_start;
 	unsigned long end = vma->vm_end;
 	unsigned long mmun_start;	/* For mmu_notifiers */
@@ -1037,19 +1158,15 @@ int copy_page_range(struct mm_struct *dst_mm, struct mm_struct *src_mm,
 		mmu_notifier_invalidate_range_start(src_mm, mmun_start,
 						    mmun_end);
 
-	ret = 0;
-	dst_pgd = pgd_offset(dst_mm, addr);
-	src_pgd = pgd_offset(src_mm, addr);
-	do {
-		next = pgd_addr_end(addr, end);
-		if (pgd_none_or_clear_bad(src_pgd))
-			continue;
-		if (unlikely(copy_pud_range(dst_mm, src_mm, dst_pgd, src_pgd,
-					    vma, addr, next))) {
-			ret = -ENOMEM;
-			break;
-		}
-	} while (dst_pgd++, src_pgd++, addr = next, addr != end);
+	/*
+	 * Large CoW copies are fanned out over the unbound workqueue;
+	 * mappings with driver-managed ptes stay on the serial path.
+	 */
+	ret = -EAGAIN;
+	if (is_cow && !(vma->vm_flags & (VM_PFNMAP | VM_MIXEDMAP)))
+		ret = copy_page_range_parallel(dst_mm, src_mm, vma, addr, end);
+	if (ret == -EAGAIN)
+		ret = copy_page_range_chunk(dst_mm, src_mm, vma, addr, end);
 
 	if (is_cow)
 		mmu_notifier_invalidate_range_end(src_mm, mmun_start, mmun_end);
@@ -1111,6 +1111,221 @@ out:
 	return rc;
 }
 
+/*
+ * One deferred TLB flush is shared by up to this many unmapped pages.
+ * The batch state lives on the stack, so keep it small.
+ */
+#define NR_MAX_BATCHED_MIGRATION	16
+
+/* Distinct from MIGRATEPAGE_SUCCESS: unmapped, but not yet moved */
+#define MIGRATEPAGE_UNMAP		1
+
+struct migrate_batch_entry {
+	struct page *page;
+	struct page *newpage;
+	struct anon_vma *anon_vma;
+	int *result;
+	bool mapped;
+};
+
+/*
+ * First stage of a batched migration. This is a trimmed down, strictly
+ * non-blocking version of __unmap_and_move(): because the caller keeps
+ * several pages locked at once, every lock is a trylock and writeback is
+ * never waited for, so there is nothing another lock holder could block
+ * on. The TLB flush for the cleared ptes is deferred (TTU_BATCH_FLUSH);
+ * the caller must issue it before the page contents are copied.
+ *
+ * Returns MIGRATEPAGE_UNMAP with both pages locked and migration entries
+ * installed, or -EAGAIN if the page needs the regular per-page path.
+ */
+static int migrate_batch_unmap(struct migrate_batch_entry *ent,
+			       struct page *page, struct page *newpage)
+{
+	struct anon_vma *anon_vma = NULL;
+
+	if (!trylock_page(page))
+		return -EAGAIN;
+
+	if (PageWriteback(page))
+		goto out_unlock;
+
+	/* See the comment about anon_vma in __unmap_and_move() */
+	if (PageAnon(page) && !PageKsm(page))
+		anon_vma = page_get_anon_vma(page);
+
+	if (unlikely(!trylock_page(newpage)))
+		goto out_put_anon;
+
+	/* Leave the corner cases to __unmap_and_move() */
+	if (unlikely(!page->mapping))
+		goto out_unlock_both;
+
+	ent->mapped = false;
+	if (page_mapped(page)) {
+		VM_BUG_ON_PAGE(PageAnon(page) && !PageKsm(page) && !anon_vma,
+				page);
+		try_to_unmap(page, TTU_MIGRATION|TTU_IGNORE_MLOCK|
+				TTU_IGNORE_ACCESS|TTU_BATCH_FLUSH);
+		ent->mapped = true;
+	}
+
+	if (page_mapped(page)) {
+		/* mlocked or otherwise pinned mappings: restore and bail */
+		if (ent->mapped)
+			remove_migration_ptes(page, page, false);
+		goto out_unlock_both;
+	}
+
+	ent->page = page;
+	ent->newpage = newpage;
+	ent->anon_vma = anon_vma;
+	return MIGRATEPAGE_UNMAP;
+
+out_unlock_both:
+	unlock_page(newpage);
+out_put_anon:
+	if (anon_vma)
+		put_anon_vma(anon_vma);
+out_unlock:
+	unlock_page(page);
+	return -EAGAIN;
+}
+
+/*
+ * Second stage of a batched migration: copy the page and drop all the
+ * references taken by migrate_batch_unmap(). The caller must have
+ * flushed the deferred TLB entries first, otherwise another CPU could
+ * still be writing to the old page while we copy it.
+ */
+static int migrate_batch_move(struct migrate_batch_entry *ent,
+			      enum migrate_mode mode)
+{
+	struct page *page = ent->page;
+	struct page *newpage = ent->newpage;
+	int rc;
+
+	rc = move_to_new_page(newpage, page, mode);
+
+	if (ent->mapped)
+		remove_migration_ptes(page,
+			rc == MIGRATEPAGE_SUCCESS ? newpage : page, false);
+
+	unlock_page(newpage);
+	if (ent->anon_vma)
+		put_anon_vma(ent->anon_vma);
+	unlock_page(page);
+	return rc;
+}
+
+/*
+ * Opportunistic batched pass over the migration list: unmap a batch of
+ * pages, issue one combined TLB flush for all of their ptes, then copy
+ * and remap them. Without this, try_to_unmap() flushes per mapping and
+ * moving gigabytes between nodes degenerates into an IPI storm.
+ *
+ * The batch only takes pages it can handle without blocking, and moves
+ * with MIGRATE_ASYNC semantics regardless of @mode so that no page lock
+ * is ever waited for while others are held. Everything else is left on
+ * @from for the regular per-page passes in migrate_pages().
+ *
+ * Returns 0, or -ENOMEM if a target page could not be allocated.
+ */
+static int migrate_pages_batch(struct list_head *from, new_page_t get_new_page,
+			free_page_t put_new_page, unsigned long private,
+			int reason, int *nr_succeeded)
+{
+	struct migrate_batch_entry batch[NR_MAX_BATCHED_MIGRATION];
+	LIST_HEAD(skipped);
+	LIST_HEAD(unmapped);
+	int nr, i, rc, ret = 0;
+
+	while (!list_empty(from) && !ret) {
+		nr = 0;
+
+		while (nr < NR_MAX_BATCHED_MIGRATION && !list_empty(from)) {
+			struct page *page = list_first_entry(from,
+							struct page, lru);
+			struct page *newpage;
+			int *result = NULL;
+
+			cond_resched();
+
+			if (PageHuge(page) || PageTransHuge(page) ||
+			    unlikely(isolated_balloon_page(page)) ||
+			    page_count(page) == 1) {
+				list_move_tail(&page->lru, &skipped);
+				continue;
+			}
+
+			newpage = get_new_page(page, private, &result);
+			if (!newpage) {
+				ret = -ENOMEM;
+				break;
+			}
+
+			rc = migrate_batch_unmap(&batch[nr], page, newpage);
+			if (rc != MIGRATEPAGE_UNMAP) {
+				if (put_new_page)
+					put_new_page(newpage, private);
+				else
+					putback_lru_page(newpage);
+				list_move_tail(&page->lru, &skipped);
+				continue;
+			}
+
+			batch[nr].result = result;
+			list_move_tail(&page->lru, &unmapped);
+			nr++;
+		}
+
+		/* One flush covers every pte cleared above */
+		try_to_unmap_flush();
+
+		for (i = 0; i < nr; i++) {
+			struct page *page = batch[i].page;
+			struct page *newpage = batch[i].newpage;
+
+			rc = migrate_batch_move(&batch[i], MIGRATE_ASYNC);
+			if (rc != MIGRATEPAGE_SUCCESS) {
+				/*
+				 * Fully restored; let the blocking per-page
+				 * path decide whether this failure is final.
+				 */
+				if (put_new_page)
+					put_new_page(newpage, private);
+				else
+					putback_lru_page(newpage);
+				list_move_tail(&page->lru, &skipped);
+				continue;
+			}
+
+			set_page_owner_migrate_reason(newpage, reason);
+
+			list_del(&page->lru);
+			dec_zone_page_state(page, NR_ISOLATED_ANON +
+					page_is_file_cache(page));
+			/* Soft-offlined page shouldn't go through lru cache list */
+			if (reason == MR_MEMORY_FAILURE) {
+				put_page(page);
+				if (!test_set_page_hwpoison(page))
+					num_poisoned_pages_inc();
+			} else
+				putback_lru_page(page);
+
+			/* Drop the reference grabbed during isolation */
+			putback_lru_page(newpage);
+
+			if (batch[i].result)
+				*batch[i].result = page_to_nid(newpage);
+			(*nr_succeeded)++;
+		}
+	}
+
+	list_splice(&skipped, from);
+	return ret;
+}
+
 /*
  * migrate_pages - migrate the pages specified in a list, to the free pages
  *		   supplied as the target for the page migration
@@ -1148,6 +1363,11 @@ int migrate_pages(struct list_head *from, new_page_t get_new_page,
 	if (!swapwrite)
 		current->flags |= PF_SWAPWRITE;
 
+	rc = migrate_pages_batch(from, get_new_page, put_new_page, private,
+				 reason, &nr_succeeded);
+	if (rc == -ENOMEM)
+		goto out;
+
 	for(pass = 0; pass < 10 && retry; pass++) {
 		retry = 0;
 
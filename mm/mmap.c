@@ -43,6 +43,7 @@
 #include <linux/userfaultfd_k.h>
 #include <linux/moduleparam.h>
 #include <linux/pkeys.h>
+#include <linux/prefetch.h>
 
 #include <asm/uaccess.h>
 #include <asm/cacheflush.h>
@@ -1208,9 +1209,25 @@ unsigned long do_mmap(struct file *file, unsigned long addr,
 
 	if (file) {
 		struct inode *inode = file_inode(file);
+		unsigned long flags_mask;
+
+		flags_mask = LEGACY_MAP_MASK | file->f_op->mmap_supported_flags;
 
 		switch (flags & MAP_TYPE) {
 		case MAP_SHARED:
+			/*
+			 * Force use of MAP_SHARED_VALIDATE with non-legacy
+			 * flags. E.g. MAP_SYNC is dangerous to use with
+			 * MAP_SHARED as you don't know which consistency model
+			 * you will get. We silently ignore unsupported flags
+			 * with MAP_SHARED to preserve backward compatibility.
+			 */
+			flags &= LEGACY_MAP_MASK;
+			vm_flags &= ~VM_SYNC;
+			/* fall through */
+		case MAP_SHARED_VALIDATE:
+			if (flags & ~flags_mask)
+				return -EOPNOTSUPP;
 			if ((prot&PROT_WRITE) && !(file->f_mode&FMODE_WRITE))
 				return -EACCES;
 
@@ -1929,6 +1946,13 @@ struct vm_area_struct *find_vma(struct mm_struct *mm, unsigned long addr)
 	if (likely(vma))
 		return vma;
 
+	/*
+	 * Nothing can satisfy addr < vm_end above the highest vma end;
+	 * skip the tree walk entirely for lookups above the mapped area.
+	 */
+	if (addr >= mm->highest_vm_end)
+		return NULL;
+
 	rb_node = mm->mm_rb.rb_node;
 
 	while (rb_node) {
@@ -1936,6 +1960,14 @@ struct vm_area_struct *find_vma(struct mm_struct *mm, unsigned long addr)
 
 		tmp = rb_entry(rb_node, struct vm_area_struct, vm_rb);
 
+		/*
+		 * Start pulling in both children while the comparison
+		 * below resolves; on deep trees the walk is otherwise a
+		 * serial chain of cache misses.
+		 */
+		prefetch(rb_node->rb_left);
+		prefetch(rb_node->rb_right);
+
 		if (tmp->vm_end > addr) {
 			vma = tmp;
 			if (tmp->vm_start <= addr)
@@ -2407,8 +2439,14 @@ int split_vma(struct mm_struct *mm, struct vm_area_struct *vma,
  * what needs doing, and the areas themselves, which do the
  * work.  This now handles partial unmappings.
  * Jeremy Fitzhardinge <jeremy@goop.org>
+ *
+ * If @downgrade is true and the vmas were successfully detached,
+ * mmap_sem is downgraded to read mode before the pages are zapped, so
+ * that faulting threads only contend with the (cheap) detach phase.
+ * Returns 1 in that case and the caller must drop the read lock.
  */
-int do_munmap(struct mm_struct *mm, unsigned long start, size_t len)
+static int __do_munmap(struct mm_struct *mm, unsigned long start, size_t len,
+		       bool downgrade)
 {
 	unsigned long end;
 	struct vm_area_struct *vma, *prev, *last;
@@ -2480,17 +2518,27 @@ int do_munmap(struct mm_struct *mm, unsigned long start, size_t len)
 	}
 
 	/*
-	 * Remove the vma's, and unmap the actual pages
+	 * Remove the vma's, and unmap the actual pages.  arch_unmap()
+	 * may need to modify the address space, so run it before any
+	 * downgrade while the write lock is still held.
 	 */
 	detach_vmas_to_be_unmapped(mm, vma, prev, end);
-	unmap_region(mm, vma, prev, start, end);
-
 	arch_unmap(mm, vma, start, end);
 
+	if (downgrade)
+		downgrade_write(&mm->mmap_sem);
+
+	unmap_region(mm, vma, prev, start, end);
+
 	/* Fix up all other VM information */
 	remove_vma_list(mm, vma);
 
-	return 0;
+	return downgrade ? 1 : 0;
+}
+
+int do_munmap(struct mm_struct *mm, unsigned long start, size_t len)
+{
+	return __do_munmap(mm, start, len, false);
 }
 
 int vm_munmap(unsigned long start, size_t len)
@@ -2499,8 +2547,16 @@ int vm_munmap(unsigned long start, size_t len)
 	struct mm_struct *mm = current->mm;
 
 	down_write(&mm->mmap_sem);
-	ret = do_munmap(mm, start, len);
-	up_write(&mm->mmap_sem);
+	ret = __do_munmap(mm, start, len, true);
+	/*
+	 * __do_munmap() returns 1 after downgrading mmap_sem so the
+	 * bulk of the page zapping only held it for read.
+	 */
+	if (ret == 1) {
+		up_read(&mm->mmap_sem);
+		ret = 0;
+	} else
+		up_write(&mm->mmap_sem);
 	return ret;
 }
 EXPORT_SYMBOL(vm_munmap);
@@ -60,9 +60,20 @@ static pte_t *lock_pte_protection(struct vm_area_struct *vma, pmd_t *pmd,
 	return pte;
 }
 
+/* Extend [*flush_start, *flush_end) to cover a modified mapping */
+static void note_flush_range(unsigned long *flush_start,
+		unsigned long *flush_end, unsigned long addr, unsigned long size)
+{
+	if (addr < *flush_start)
+		*flush_start = addr;
+	if (addr + size > *flush_end)
+		*flush_end = addr + size;
+}
+
 static unsigned long change_pte_range(struct vm_area_struct *vma, pmd_t *pmd,
 		unsigned long addr, unsigned long end, pgprot_t newprot,
-		int dirty_accountable, int prot_numa)
+		int dirty_accountable, int prot_numa,
+		unsigned long *flush_start, unsigned long *flush_end)
 {
 	struct mm_struct *mm = vma->vm_mm;
 	pte_t *pte, oldpte;
@@ -108,6 +119,8 @@ static unsigned long change_pte_range(struct vm_area_struct *vma, pmd_t *pmd,
 				ptent = pte_mkwrite(ptent);
 			}
 			ptep_modify_prot_commit(mm, addr, pte, ptent);
+			note_flush_range(flush_start, flush_end, addr,
+					 PAGE_SIZE);
 			pages++;
 		} else if (IS_ENABLED(CONFIG_MIGRATION)) {
 			swp_entry_t entry = pte_to_swp_entry(oldpte);
@@ -136,7 +149,8 @@ static unsigned long change_pte_range(struct vm_area_struct *vma, pmd_t *pmd,
 
 static inline unsigned long change_pmd_range(struct vm_area_struct *vma,
 		pud_t *pud, unsigned long addr, unsigned long end,
-		pgprot_t newprot, int dirty_accountable, int prot_numa)
+		pgprot_t newprot, int dirty_accountable, int prot_numa,
+		unsigned long *flush_start, unsigned long *flush_end)
 {
 	pmd_t *pmd;
 	struct mm_struct *mm = vma->vm_mm;
@@ -171,6 +185,9 @@ static inline unsigned long change_pmd_range(struct vm_area_struct *vma,
 
 				if (nr_ptes) {
 					if (nr_ptes == HPAGE_PMD_NR) {
+						note_flush_range(flush_start,
+							flush_end, addr,
+							HPAGE_PMD_SIZE);
 						pages += HPAGE_PMD_NR;
 						nr_huge_updates++;
 					}
@@ -182,7 +199,8 @@ static inline unsigned long change_pmd_range(struct vm_area_struct *vma,
 			/* fall through, the trans huge pmd just split */
 		}
 		this_pages = change_pte_range(vma, pmd, addr, next, newprot,
-				 dirty_accountable, prot_numa);
+				 dirty_accountable, prot_numa,
+				 flush_start, flush_end);
 		pages += this_pages;
 	} while (pmd++, addr = next, addr != end);
 
@@ -196,7 +214,8 @@ static inline unsigned long change_pmd_range(struct vm_area_struct *vma,
 
 static inline unsigned long change_pud_range(struct vm_area_struct *vma,
 		pgd_t *pgd, unsigned long addr, unsigned long end,
-		pgprot_t newprot, int dirty_accountable, int prot_numa)
+		pgprot_t newprot, int dirty_accountable, int prot_numa,
+		unsigned long *flush_start, unsigned long *flush_end)
 {
 	pud_t *pud;
 	unsigned long next;
@@ -208,7 +227,8 @@ static inline unsigned long change_pud_range(struct vm_area_struct *vma,
 		if (pud_none_or_clear_bad(pud))
 			continue;
 		pages += change_pmd_range(vma, pud, addr, next, newprot,
-				 dirty_accountable, prot_numa);
+				 dirty_accountable, prot_numa,
+				 flush_start, flush_end);
 	} while (pud++, addr = next, addr != end);
 
 	return pages;
@@ -221,8 +241,9 @@ static unsigned long change_protection_range(struct vm_area_struct *vma,
 	struct mm_struct *mm = vma->vm_mm;
 	pgd_t *pgd;
 	unsigned long next;
-	unsigned long start = addr;
 	unsigned long pages = 0;
+	unsigned long flush_start = end;
+	unsigned long flush_end = addr;
 
 	BUG_ON(addr >= end);
 	pgd = pgd_offset(mm, addr);
@@ -233,12 +254,20 @@ static unsigned long change_protection_range(struct vm_area_struct *vma,
 		if (pgd_none_or_clear_bad(pgd))
 			continue;
 		pages += change_pud_range(vma, pgd, addr, next, newprot,
-				 dirty_accountable, prot_numa);
+				 dirty_accountable, prot_numa,
+				 &flush_start, &flush_end);
 	} while (pgd++, addr = next, addr != end);
 
-	/* Only flush the TLB if we actually modified any entries: */
-	if (pages)
-		flush_tlb_range(vma, start, end);
+	/*
+	 * Only flush the TLB for the span of entries that were actually
+	 * modified. Skipped entries (already protnone during a prot_numa
+	 * scan, empty page tables, migration entries) were never cached
+	 * with the old protections, so they need no invalidation. On a
+	 * mostly converged NUMA scan this shrinks the flush from the
+	 * whole scan window to the few pages that changed.
+	 */
+	if (flush_end > flush_start)
+		flush_tlb_range(vma, flush_start, flush_end);
 	clear_tlb_flush_pending(mm);
 
 	return pages;
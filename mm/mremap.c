@@ -24,6 +24,7 @@
 #include <linux/mm-arch-hooks.h>
 
 #include <asm/cacheflush.h>
+#include <asm/pgalloc.h>
 #include <asm/tlbflush.h>
 
 #include "internal.h"
@@ -157,6 +158,60 @@ static void move_ptes(struct vm_area_struct *vma, pmd_t *old_pmd,
 		i_mmap_unlock_write(mapping);
 }
 
+#ifdef CONFIG_HAVE_MOVE_PMD
+/*
+ * Move an entire page table page to a new pmd slot instead of copying
+ * its 512 ptes one by one. The caller must hold the rmap locks: unlike
+ * move_ptes(), which takes the pte lock that every rmap walker also
+ * takes, relocating the table page itself would let a concurrent rmap
+ * walk lock the old page's pte lock and then miss all of its entries.
+ */
+static bool move_normal_pmd(struct vm_area_struct *vma, unsigned long old_addr,
+		unsigned long new_addr, pmd_t *old_pmd, pmd_t *new_pmd)
+{
+	spinlock_t *old_ptl, *new_ptl;
+	struct mm_struct *mm = vma->vm_mm;
+	pmd_t pmd;
+
+	/*
+	 * The destination pmd must be empty: the new range has never
+	 * been faulted and free_pgtables() tore down anything that was
+	 * mapped there before.
+	 */
+	if (WARN_ON(!pmd_none(*new_pmd)))
+		return false;
+
+	/*
+	 * We don't have to worry about the ordering of src and dst
+	 * ptlocks because exclusive mmap_sem prevents deadlock.
+	 */
+	old_ptl = pmd_lock(mm, old_pmd);
+	new_ptl = pmd_lockptr(mm, new_pmd);
+	if (new_ptl != old_ptl)
+		spin_lock_nested(new_ptl, SINGLE_DEPTH_NESTING);
+
+	pmd = *old_pmd;
+	pmd_clear(old_pmd);
+
+	VM_BUG_ON(!pmd_none(*new_pmd));
+
+	pmd_populate(mm, new_pmd, pmd_pgtable(pmd));
+
+	if (new_ptl != old_ptl)
+		spin_unlock(new_ptl);
+	spin_unlock(old_ptl);
+
+	return true;
+}
+#else
+static inline bool move_normal_pmd(struct vm_area_struct *vma,
+		unsigned long old_addr, unsigned long new_addr,
+		pmd_t *old_pmd, pmd_t *new_pmd)
+{
+	return false;
+}
+#endif
+
 #define LATENCY_LIMIT	(64 * PAGE_SIZE)
 
 unsigned long move_page_tables(struct vm_area_struct *vma,
@@ -212,6 +267,36 @@ unsigned long move_page_tables(struct vm_area_struct *vma,
 			if (pmd_none(*old_pmd))
 				continue;
 			VM_BUG_ON(pmd_trans_huge(*old_pmd));
+		} else if (IS_ENABLED(CONFIG_HAVE_MOVE_PMD) &&
+			   extent == PMD_SIZE && !(new_addr & ~PMD_MASK)) {
+			struct address_space *mapping = NULL;
+			struct anon_vma *anon_vma = NULL;
+			bool moved;
+
+			/*
+			 * The rmap locks are taken unconditionally here,
+			 * independent of need_rmap_locks: relocating the
+			 * page table page must exclude every rmap walk,
+			 * see the comment at move_normal_pmd().
+			 */
+			if (vma->vm_file) {
+				mapping = vma->vm_file->f_mapping;
+				i_mmap_lock_write(mapping);
+			}
+			if (vma->anon_vma) {
+				anon_vma = vma->anon_vma;
+				anon_vma_lock_write(anon_vma);
+			}
+			moved = move_normal_pmd(vma, old_addr, new_addr,
+						old_pmd, new_pmd);
+			if (anon_vma)
+				anon_vma_unlock_write(anon_vma);
+			if (mapping)
+				i_mmap_unlock_write(mapping);
+			if (moved) {
+				need_flush = true;
+				continue;
+			}
 		}
 		if (pte_alloc(new_vma->vm_mm, new_pmd, new_addr))
 			break;
@@ -513,6 +513,18 @@ static void oom_reap_task(struct task_struct *tsk)
 		pr_info("oom_reaper: unable to reap pid:%d (%s)\n",
 				task_pid_nr(tsk), tsk->comm);
 		debug_show_all_locks();
+
+		/*
+		 * The victim is most likely stuck in uninterruptible
+		 * state holding mmap_sem, e.g. waiting on I/O, and may
+		 * not exit for a long time.  Leaving TIF_MEMDIE set
+		 * would livelock every allocator behind it, so give up
+		 * on this victim and let the OOM killer pick another
+		 * one.  Excluding it from future selection also keeps
+		 * us from bouncing on the same unreapable mm.
+		 */
+		tsk->signal->oom_score_adj = OOM_SCORE_ADJ_MIN;
+		exit_oom_victim(tsk);
 	}
 
 	/* Drop a reference taken by wake_oom_reaper */
@@ -363,6 +363,51 @@ static unsigned long global_dirtyable_memory(void)
  * dirty limits will be lifted by 1/4 for PF_LESS_THROTTLE (ie. nfsd) and
  * real-time tasks.
  */
+/*
+ * Cache for the global domain's base thresholds.  domain_dirty_limits()
+ * runs on every throttle breach of every dirtying task, but its inputs
+ * (the dirtyable-memory estimate and the vm.dirty_* knobs) move slowly.
+ * Results are reused while the estimate stays within ~3% of the cached
+ * one and for at most BANDWIDTH_INTERVAL; a knob write bumps the
+ * generation.  Readers are unsynchronized: a torn pair combines two
+ * recent, individually valid values and lasts one refresh at most.
+ */
+static struct {
+	unsigned long	tstamp;
+	unsigned long	avail;
+	unsigned long	thresh;
+	unsigned long	bg_thresh;
+	unsigned int	gen;
+} dirty_limits_cache;
+static unsigned int dirty_limits_gen;
+
+static bool global_limits_cached(unsigned long avail, unsigned long *thresh,
+				 unsigned long *bg_thresh)
+{
+	unsigned long cached_avail = READ_ONCE(dirty_limits_cache.avail);
+
+	if (READ_ONCE(dirty_limits_cache.gen) != READ_ONCE(dirty_limits_gen))
+		return false;
+	if (time_after(jiffies,
+		       READ_ONCE(dirty_limits_cache.tstamp) + BANDWIDTH_INTERVAL))
+		return false;
+	if (abs((long)(avail - cached_avail)) > (long)(avail >> 5))
+		return false;
+	*thresh = READ_ONCE(dirty_limits_cache.thresh);
+	*bg_thresh = READ_ONCE(dirty_limits_cache.bg_thresh);
+	return true;
+}
+
+static void global_limits_cache_store(unsigned long avail, unsigned long thresh,
+				      unsigned long bg_thresh)
+{
+	WRITE_ONCE(dirty_limits_cache.thresh, thresh);
+	WRITE_ONCE(dirty_limits_cache.bg_thresh, bg_thresh);
+	WRITE_ONCE(dirty_limits_cache.avail, avail);
+	WRITE_ONCE(dirty_limits_cache.gen, READ_ONCE(dirty_limits_gen));
+	WRITE_ONCE(dirty_limits_cache.tstamp, jiffies);
+}
+
 static void domain_dirty_limits(struct dirty_throttle_control *dtc)
 {
 	const unsigned long available_memory = dtc->avail;
@@ -393,15 +438,22 @@ static void domain_dirty_limits(struct dirty_throttle_control *dtc)
 		bytes = bg_bytes = 0;
 	}
 
-	if (bytes)
-		thresh = DIV_ROUND_UP(bytes, PAGE_SIZE);
-	else
-		thresh = (ratio * available_memory) / 100;
+	if (gdtc || !global_limits_cached(available_memory, &thresh,
+					  &bg_thresh)) {
+		if (bytes)
+			thresh = DIV_ROUND_UP(bytes, PAGE_SIZE);
+		else
+			thresh = (ratio * available_memory) / 100;
 
-	if (bg_bytes)
-		bg_thresh = DIV_ROUND_UP(bg_bytes, PAGE_SIZE);
-	else
-		bg_thresh = (bg_ratio * available_memory) / 100;
+		if (bg_bytes)
+			bg_thresh = DIV_ROUND_UP(bg_bytes, PAGE_SIZE);
+		else
+			bg_thresh = (bg_ratio * available_memory) / 100;
+
+		if (!gdtc)
+			global_limits_cache_store(available_memory, thresh,
+						  bg_thresh);
+	}
 
 	if (bg_thresh >= thresh)
 		bg_thresh = thresh / 2;
@@ -485,8 +537,10 @@ int dirty_background_ratio_handler(struct ctl_table *table, int write,
 	int ret;
 
 	ret = proc_dointvec_minmax(table, write, buffer, lenp, ppos);
-	if (ret == 0 && write)
+	if (ret == 0 && write) {
 		dirty_background_bytes = 0;
+		dirty_limits_gen++;
+	}
 	return ret;
 }
 
@@ -497,8 +551,10 @@ int dirty_background_bytes_handler(struct ctl_table *table, int write,
 	int ret;
 
 	ret = proc_doulongvec_minmax(table, write, buffer, lenp, ppos);
-	if (ret == 0 && write)
+	if (ret == 0 && write) {
 		dirty_background_ratio = 0;
+		dirty_limits_gen++;
+	}
 	return ret;
 }
 
@@ -513,6 +569,7 @@ int dirty_ratio_handler(struct ctl_table *table, int write,
 	if (ret == 0 && write && vm_dirty_ratio != old_ratio) {
 		writeback_set_ratelimit();
 		vm_dirty_bytes = 0;
+		dirty_limits_gen++;
 	}
 	return ret;
 }
@@ -528,6 +585,7 @@ int dirty_bytes_handler(struct ctl_table *table, int write,
 	if (ret == 0 && write && vm_dirty_bytes != old_bytes) {
 		writeback_set_ratelimit();
 		vm_dirty_ratio = 0;
+		dirty_limits_gen++;
 	}
 	return ret;
 }
@@ -1496,8 +1554,27 @@ static inline void wb_dirty_limits(struct dirty_throttle_control *dtc)
 	 *   wb_thresh. Instead the auxiliary wb control line in
 	 *   wb_position_ratio() will let the dirtier task progress
 	 *   at some rate <= (write_bw / 2) for bringing down wb_dirty.
+	 *
+	 * The fprop fraction behind __wb_calc_thresh() is a percpu sum,
+	 * which gets expensive when hundreds of tasks throttle against
+	 * the same wb.  The result only tracks writeout completions, so
+	 * for the global domain reuse it on the same cadence as the
+	 * bandwidth estimation as long as the domain threshold it was
+	 * derived from still holds.  Memcg domains draw on a different
+	 * fprop instance and bypass the cache.
 	 */
-	dtc->wb_thresh = __wb_calc_thresh(dtc);
+	if (mdtc_gdtc(dtc)) {
+		dtc->wb_thresh = __wb_calc_thresh(dtc);
+	} else if (!time_after(jiffies, READ_ONCE(wb->wb_thresh_stamp) +
+			       BANDWIDTH_INTERVAL) &&
+		   READ_ONCE(wb->wb_thresh_input) == dtc->thresh) {
+		dtc->wb_thresh = READ_ONCE(wb->wb_thresh_cache);
+	} else {
+		dtc->wb_thresh = __wb_calc_thresh(dtc);
+		WRITE_ONCE(wb->wb_thresh_cache, dtc->wb_thresh);
+		WRITE_ONCE(wb->wb_thresh_input, dtc->thresh);
+		WRITE_ONCE(wb->wb_thresh_stamp, jiffies);
+	}
 	dtc->wb_bg_thresh = dtc->thresh ?
 		div_u64((u64)dtc->wb_thresh * dtc->bg_thresh, dtc->thresh) : 0;
 
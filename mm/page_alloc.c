@@ -63,6 +63,7 @@
 #include <linux/sched/rt.h>
 #include <linux/page_owner.h>
 #include <linux/kthread.h>
+#include <linux/memcontrol.h>
 
 #include <asm/sections.h>
 #include <asm/tlbflush.h>
@@ -1238,39 +1239,23 @@ static inline void __init pgdat_init_report_one_done(void)
 }
 
 /* Initialise remaining memory on a node */
-static int __init deferred_init_memmap(void *data)
+/*
+ * Initialise and free the deferred pages of one node intersecting
+ * [init_start_pfn, init_end_pfn).  Sections handed to different threads
+ * are aligned to MAX_ORDER_NR_PAGES, so the page block batching below
+ * never straddles two workers and the only shared state is zone->lock
+ * taken by the buddy free.
+ */
+static unsigned long __init deferred_init_range(struct zone *zone, int zid,
+						int nid,
+						unsigned long init_start_pfn,
+						unsigned long init_end_pfn)
 {
-	pg_data_t *pgdat = data;
-	int nid = pgdat->node_id;
 	struct mminit_pfnnid_cache nid_init_state = { };
-	unsigned long start = jiffies;
+	unsigned long first_init_pfn = init_start_pfn;
 	unsigned long nr_pages = 0;
 	unsigned long walk_start, walk_end;
-	int i, zid;
-	struct zone *zone;
-	unsigned long first_init_pfn = pgdat->first_deferred_pfn;
-	const struct cpumask *cpumask = cpumask_of_node(pgdat->node_id);
-
-	if (first_init_pfn == ULONG_MAX) {
-		pgdat_init_report_one_done();
-		return 0;
-	}
-
-	/* Bind memory initialisation thread to a local node if possible */
-	if (!cpumask_empty(cpumask))
-		set_cpus_allowed_ptr(current, cpumask);
-
-	/* Sanity check boundaries */
-	BUG_ON(pgdat->first_deferred_pfn < pgdat->node_start_pfn);
-	BUG_ON(pgdat->first_deferred_pfn > pgdat_end_pfn(pgdat));
-	pgdat->first_deferred_pfn = ULONG_MAX;
-
-	/* Only the highest zone is deferred so find it */
-	for (zid = 0; zid < MAX_NR_ZONES; zid++) {
-		zone = pgdat->node_zones + zid;
-		if (first_init_pfn < zone_end_pfn(zone))
-			break;
-	}
+	int i;
 
 	for_each_mem_pfn_range(i, nid, &walk_start, &walk_end, NULL) {
 		unsigned long pfn, end_pfn;
@@ -1280,6 +1265,7 @@ static int __init deferred_init_memmap(void *data)
 		int nr_to_free = 0;
 
 		end_pfn = min(walk_end, zone_end_pfn(zone));
+		end_pfn = min(end_pfn, init_end_pfn);
 		pfn = first_init_pfn;
 		if (pfn < walk_start)
 			pfn = walk_start;
@@ -1347,6 +1333,121 @@ free_range:
 		first_init_pfn = max(end_pfn, first_init_pfn);
 	}
 
+	return nr_pages;
+}
+
+struct deferred_init_work {
+	struct zone *zone;
+	int zid;
+	int nid;
+	unsigned long start_pfn;
+	unsigned long end_pfn;
+	unsigned long nr_pages;
+	struct completion done;
+};
+
+static int __init deferred_init_range_worker(void *data)
+{
+	struct deferred_init_work *w = data;
+	const struct cpumask *cpumask = cpumask_of_node(w->nid);
+
+	if (!cpumask_empty(cpumask))
+		set_cpus_allowed_ptr(current, cpumask);
+
+	w->nr_pages = deferred_init_range(w->zone, w->zid, w->nid,
+					  w->start_pfn, w->end_pfn);
+	complete(&w->done);
+	return 0;
+}
+
+/* Per-thread sections smaller than this are not worth a helper thread */
+#define DEFERRED_INIT_MIN_PAGES		(128UL << (20 - PAGE_SHIFT))
+#define DEFERRED_INIT_MAX_THREADS	4
+
+/* Initialise remaining memory on a node */
+static int __init deferred_init_memmap(void *data)
+{
+	pg_data_t *pgdat = data;
+	int nid = pgdat->node_id;
+	unsigned long start = jiffies;
+	unsigned long nr_pages = 0;
+	int zid, t, nr_threads;
+	struct zone *zone;
+	unsigned long first_init_pfn = pgdat->first_deferred_pfn;
+	unsigned long zone_end, span, chunk;
+	struct deferred_init_work work[DEFERRED_INIT_MAX_THREADS];
+	const struct cpumask *cpumask = cpumask_of_node(pgdat->node_id);
+
+	if (first_init_pfn == ULONG_MAX) {
+		pgdat_init_report_one_done();
+		return 0;
+	}
+
+	/* Bind memory initialisation thread to a local node if possible */
+	if (!cpumask_empty(cpumask))
+		set_cpus_allowed_ptr(current, cpumask);
+
+	/* Sanity check boundaries */
+	BUG_ON(pgdat->first_deferred_pfn < pgdat->node_start_pfn);
+	BUG_ON(pgdat->first_deferred_pfn > pgdat_end_pfn(pgdat));
+	pgdat->first_deferred_pfn = ULONG_MAX;
+
+	/* Only the highest zone is deferred so find it */
+	for (zid = 0; zid < MAX_NR_ZONES; zid++) {
+		zone = pgdat->node_zones + zid;
+		if (first_init_pfn < zone_end_pfn(zone))
+			break;
+	}
+	zone_end = zone_end_pfn(zone);
+
+	/*
+	 * Large nodes are split into MAX_ORDER-aligned sections handled
+	 * by helper threads on the same node; this thread takes the
+	 * first section itself.
+	 */
+	span = zone_end - first_init_pfn;
+	nr_threads = min3((unsigned long)DEFERRED_INIT_MAX_THREADS,
+			  (unsigned long)max(cpumask_weight(cpumask), 1U),
+			  span / DEFERRED_INIT_MIN_PAGES);
+	if (nr_threads < 1)
+		nr_threads = 1;
+	chunk = round_up(DIV_ROUND_UP(span, nr_threads), MAX_ORDER_NR_PAGES);
+
+	for (t = 1; t < nr_threads; t++) {
+		struct deferred_init_work *w = &work[t];
+		struct task_struct *task;
+
+		w->zone = zone;
+		w->zid = zid;
+		w->nid = nid;
+		w->start_pfn = first_init_pfn + t * chunk;
+		w->end_pfn = min(w->start_pfn + chunk, zone_end);
+		w->nr_pages = 0;
+		init_completion(&w->done);
+
+		if (w->start_pfn >= zone_end) {
+			complete(&w->done);
+			continue;
+		}
+
+		task = kthread_run(deferred_init_range_worker, w,
+				   "pgdatinit%d/%d", nid, t);
+		if (IS_ERR(task)) {
+			/* No helper: do this section inline instead */
+			w->nr_pages = deferred_init_range(zone, zid, nid,
+						w->start_pfn, w->end_pfn);
+			complete(&w->done);
+		}
+	}
+
+	nr_pages = deferred_init_range(zone, zid, nid, first_init_pfn,
+				       min(first_init_pfn + chunk, zone_end));
+
+	for (t = 1; t < nr_threads; t++) {
+		wait_for_completion(&work[t].done);
+		nr_pages += work[t].nr_pages;
+	}
+
 	/* Sanity check that the next zone really is unpopulated */
 	WARN_ON(++zid < MAX_NR_ZONES && populated_zone(++zone));
 
@@ -2156,23 +2257,18 @@ void mark_free_pages(struct zone *zone)
 #endif /* CONFIG_PM */
 
 /*
- * Free a 0-order page
- * cold == true ? free a cold page : free a hot page
+ * Free a 0-order page to the pcp lists.  Caller must have irqs disabled
+ * and have run free_pages_prepare() on the page.
  */
-void free_hot_cold_page(struct page *page, bool cold)
+static void __free_hot_cold_page(struct page *page, bool cold)
 {
 	struct zone *zone = page_zone(page);
 	struct per_cpu_pages *pcp;
-	unsigned long flags;
 	unsigned long pfn = page_to_pfn(page);
 	int migratetype;
 
-	if (!free_pages_prepare(page, 0))
-		return;
-
 	migratetype = get_pfnblock_migratetype(page, pfn);
 	set_pcppage_migratetype(page, migratetype);
-	local_irq_save(flags);
 	__count_vm_event(PGFREE);
 
 	/*
@@ -2185,7 +2281,7 @@ void free_hot_cold_page(struct page *page, bool cold)
 	if (migratetype >= MIGRATE_PCPTYPES) {
 		if (unlikely(is_migrate_isolate(migratetype))) {
 			free_one_page(zone, page, pfn, 0, migratetype);
-			goto out;
+			return;
 		}
 		migratetype = MIGRATE_MOVABLE;
 	}
@@ -2201,22 +2297,42 @@ void free_hot_cold_page(struct page *page, bool cold)
 		free_pcppages_bulk(zone, batch, pcp);
 		pcp->count -= batch;
 	}
+}
 
-out:
+/*
+ * Free a 0-order page
+ * cold == true ? free a cold page : free a hot page
+ */
+void free_hot_cold_page(struct page *page, bool cold)
+{
+	unsigned long flags;
+
+	if (!free_pages_prepare(page, 0))
+		return;
+
+	local_irq_save(flags);
+	__free_hot_cold_page(page, cold);
 	local_irq_restore(flags);
 }
 
 /*
  * Free a list of 0-order pages
+ *
+ * Unlike looping over free_hot_cold_page(), irqs are disabled and
+ * re-enabled once per batch rather than once per page.
  */
 void free_hot_cold_page_list(struct list_head *list, bool cold)
 {
 	struct page *page, *next;
+	unsigned long flags;
 
+	local_irq_save(flags);
 	list_for_each_entry_safe(page, next, list, lru) {
 		trace_mm_page_free_batched(page, cold);
-		free_hot_cold_page(page, cold);
+		if (free_pages_prepare(page, 0))
+			__free_hot_cold_page(page, cold);
 	}
+	local_irq_restore(flags);
 }
 
 /*
@@ -2396,6 +2512,96 @@ failed:
 	return NULL;
 }
 
+/**
+ * alloc_pages_bulk - allocate a number of order-0 pages in one pass
+ * @gfp_mask: flags for the allocation
+ * @nr_pages: number of pages requested
+ * @page_list: list the allocated pages are added to
+ *
+ * Pull up to @nr_pages order-0 pages from the preferred zone's per-cpu
+ * lists with a single irq-disable section and one round of zone
+ * statistics, instead of paying the full allocator entry cost per page.
+ *
+ * Only the fast path is attempted: if the zone is below its low
+ * watermark or the pcp lists cannot be refilled, fewer pages than
+ * requested are returned and the caller is expected to fall back to
+ * alloc_pages() for the remainder.
+ *
+ * Returns the number of pages added to @page_list.
+ */
+unsigned long alloc_pages_bulk(gfp_t gfp_mask, unsigned long nr_pages,
+			       struct list_head *page_list)
+{
+	struct zonelist *zonelist = node_zonelist(numa_mem_id(), gfp_mask);
+	int migratetype = gfpflags_to_migratetype(gfp_mask);
+	bool cold = ((gfp_mask & __GFP_COLD) != 0);
+	unsigned long allocated = 0;
+	struct per_cpu_pages *pcp;
+	struct list_head *list;
+	unsigned long flags;
+	struct zone *zone;
+
+	if (WARN_ON_ONCE(gfp_mask & __GFP_COMP))
+		return 0;
+
+	first_zones_zonelist(zonelist, gfp_zone(gfp_mask), NULL, &zone);
+	if (!zone)
+		return 0;
+
+	/*
+	 * Stay well clear of the watermarks so the batch cannot push the
+	 * zone into reclaim behind the back of the slow path.
+	 */
+	if (!zone_watermark_ok(zone, 0,
+			       low_wmark_pages(zone) + nr_pages,
+			       zone_idx(zone), 0))
+		return 0;
+
+	local_irq_save(flags);
+	pcp = &this_cpu_ptr(zone->pageset)->pcp;
+	list = &pcp->lists[migratetype];
+
+	while (allocated < nr_pages) {
+		struct page *page;
+
+		if (list_empty(list)) {
+			pcp->count += rmqueue_bulk(zone, 0,
+					max_t(unsigned long, pcp->batch,
+					      nr_pages - allocated),
+					list, migratetype, cold);
+			if (unlikely(list_empty(list)))
+				break;
+		}
+
+		if (cold)
+			page = list_last_entry(list, struct page, lru);
+		else
+			page = list_first_entry(list, struct page, lru);
+
+		list_del(&page->lru);
+		pcp->count--;
+
+		if (unlikely(prep_new_page(page, 0, gfp_mask, 0)))
+			continue;
+
+		list_add_tail(&page->lru, page_list);
+		allocated++;
+	}
+
+	if (allocated) {
+		__mod_zone_page_state(zone, NR_ALLOC_BATCH, -(long)allocated);
+		if (atomic_long_read(&zone->vm_stat[NR_ALLOC_BATCH]) <= 0 &&
+		    !test_bit(ZONE_FAIR_DEPLETED, &zone->flags))
+			set_bit(ZONE_FAIR_DEPLETED, &zone->flags);
+		__count_zone_vm_events(PGALLOC, zone, allocated);
+		zone_statistics(zone, zone, gfp_mask);
+	}
+	local_irq_restore(flags);
+
+	return allocated;
+}
+EXPORT_SYMBOL_GPL(alloc_pages_bulk);
+
 #ifdef CONFIG_FAIL_PAGE_ALLOC
 
 static struct {
@@ -3199,6 +3405,9 @@ __alloc_pages_slowpath(gfp_t gfp_mask, unsigned int order,
 	bool deferred_compaction = false;
 	int contended_compaction = COMPACT_CONTENDED_NONE;
 	int no_progress_loops = 0;
+	u64 stall_start = local_clock();
+	u64 stage_start;
+	bool stalled = false;
 
 	/*
 	 * In the slowpath, we sanity check order to avoid ever trying to
@@ -3294,10 +3503,14 @@ retry:
 	 * Try direct compaction. The first pass is asynchronous. Subsequent
 	 * attempts after direct reclaim are synchronous
 	 */
+	stalled = true;
+	stage_start = local_clock();
 	page = __alloc_pages_direct_compact(gfp_mask, order, alloc_flags, ac,
 					migration_mode,
 					&contended_compaction,
 					&deferred_compaction);
+	trace_mm_page_alloc_stall_compact(order, gfp_mask,
+					  local_clock() - stage_start);
 	if (page)
 		goto got_pg;
 
@@ -3341,8 +3554,11 @@ retry:
 		migration_mode = MIGRATE_SYNC_LIGHT;
 
 	/* Try direct reclaim and then allocating */
+	stage_start = local_clock();
 	page = __alloc_pages_direct_reclaim(gfp_mask, order, alloc_flags, ac,
 							&did_some_progress);
+	trace_mm_page_alloc_stall_reclaim(order, gfp_mask,
+					  local_clock() - stage_start);
 	if (page)
 		goto got_pg;
 
@@ -3381,15 +3597,30 @@ noretry:
 	 * direct reclaim and reclaim/compaction depends on compaction
 	 * being called after reclaim so call directly if necessary
 	 */
+	stage_start = local_clock();
 	page = __alloc_pages_direct_compact(gfp_mask, order, alloc_flags,
 					    ac, migration_mode,
 					    &contended_compaction,
 					    &deferred_compaction);
+	trace_mm_page_alloc_stall_compact(order, gfp_mask,
+					  local_clock() - stage_start);
 	if (page)
 		goto got_pg;
 nopage:
 	warn_alloc_failed(gfp_mask, order, NULL);
 got_pg:
+	/*
+	 * Only allocations that went at least as far as direct compaction
+	 * count as stalls; a plain watermark miss resolved from the
+	 * freelists is not worth an event or a counter bump.
+	 */
+	if (stalled) {
+		u64 stall_ns = local_clock() - stall_start;
+
+		trace_mm_page_alloc_stall(order, gfp_mask, stall_ns,
+					  no_progress_loops);
+		mem_cgroup_account_alloc_stall(stall_ns);
+	}
 	return page;
 }
 
@@ -3452,6 +3683,8 @@ retry_cpuset:
 	alloc_mask = gfp_mask|__GFP_HARDWALL;
 	page = get_page_from_freelist(alloc_mask, order, alloc_flags, &ac);
 	if (unlikely(!page)) {
+		u64 stall_start = page_owner_stall_start();
+
 		/*
 		 * Runtime PM, block IO and its error handling path
 		 * can deadlock because I/O on the device might not
@@ -3461,6 +3694,8 @@ retry_cpuset:
 		ac.spread_dirty_pages = false;
 
 		page = __alloc_pages_slowpath(alloc_mask, order, &ac);
+
+		set_page_owner_stall(page, stall_start);
 	}
 
 	if (kmemcheck_enabled && page)
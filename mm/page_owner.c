@@ -1,5 +1,7 @@
 #include <linux/debugfs.h>
 #include <linux/mm.h>
+#include <linux/sched.h>
+#include <linux/seq_file.h>
 #include <linux/slab.h>
 #include <linux/uaccess.h>
 #include <linux/bootmem.h>
@@ -9,6 +11,29 @@
 #include <linux/migrate.h>
 #include "internal.h"
 
+/*
+ * Allocation stalls and page lifetimes are aggregated into log2(ns)
+ * buckets, per order and migratetype, so the distributions can be
+ * read from debugfs without walking every page.  The top bucket is
+ * open-ended (everything above ~33 seconds).
+ */
+#define PAGE_OWNER_BUCKETS	26
+
+static atomic64_t stall_hist[MIGRATE_TYPES][MAX_ORDER][PAGE_OWNER_BUCKETS];
+static atomic64_t lifetime_hist[MIGRATE_TYPES][MAX_ORDER][PAGE_OWNER_BUCKETS];
+
+static void hist_account(atomic64_t (*hist)[MAX_ORDER][PAGE_OWNER_BUCKETS],
+			 int mt, unsigned int order, u64 ns)
+{
+	unsigned int bucket = min_t(unsigned int, ilog2(ns | 1),
+				    PAGE_OWNER_BUCKETS - 1);
+
+	if (mt < 0 || mt >= MIGRATE_TYPES || order >= MAX_ORDER)
+		return;
+
+	atomic64_inc(&hist[mt][order][bucket]);
+}
+
 static bool page_owner_disabled = true;
 DEFINE_STATIC_KEY_FALSE(page_owner_inited);
 
@@ -53,6 +78,12 @@ void __reset_page_owner(struct page *page, unsigned int order)
 	int i;
 	struct page_ext *page_ext;
 
+	page_ext = lookup_page_ext(page);
+	if (test_bit(PAGE_EXT_OWNER, &page_ext->flags) && page_ext->ts_nsec)
+		hist_account(lifetime_hist,
+			     gfpflags_to_migratetype(page_ext->gfp_mask),
+			     order, local_clock() - page_ext->ts_nsec);
+
 	for (i = 0; i < (1 << order); i++) {
 		page_ext = lookup_page_ext(page + i);
 		__clear_bit(PAGE_EXT_OWNER, &page_ext->flags);
@@ -75,6 +106,8 @@ void __set_page_owner(struct page *page, unsigned int order, gfp_t gfp_mask)
 	page_ext->gfp_mask = gfp_mask;
 	page_ext->nr_entries = trace.nr_entries;
 	page_ext->last_migrate_reason = -1;
+	page_ext->ts_nsec = local_clock();
+	page_ext->stall_ns = 0;
 
 	__set_bit(PAGE_EXT_OWNER, &page_ext->flags);
 }
@@ -93,6 +126,21 @@ gfp_t __get_page_owner_gfp(struct page *page)
 	return page_ext->gfp_mask;
 }
 
+u64 __page_owner_stall_start(void)
+{
+	return local_clock();
+}
+
+void __set_page_owner_stall(struct page *page, u64 stall_start)
+{
+	struct page_ext *page_ext = lookup_page_ext(page);
+	u64 stall = local_clock() - stall_start;
+
+	page_ext->stall_ns = stall;
+	hist_account(stall_hist, gfpflags_to_migratetype(page_ext->gfp_mask),
+		     page_ext->order, stall);
+}
+
 void __copy_page_owner(struct page *oldpage, struct page *newpage)
 {
 	struct page_ext *old_ext = lookup_page_ext(oldpage);
@@ -102,6 +150,8 @@ void __copy_page_owner(struct page *oldpage, struct page *newpage)
 	new_ext->order = old_ext->order;
 	new_ext->gfp_mask = old_ext->gfp_mask;
 	new_ext->nr_entries = old_ext->nr_entries;
+	new_ext->ts_nsec = old_ext->ts_nsec;
+	new_ext->stall_ns = old_ext->stall_ns;
 
 	for (i = 0; i < ARRAY_SIZE(new_ext->trace_entries); i++)
 		new_ext->trace_entries[i] = old_ext->trace_entries[i];
@@ -135,9 +185,10 @@ print_page_owner(char __user *buf, size_t count, unsigned long pfn,
 		return -ENOMEM;
 
 	ret = snprintf(kbuf, count,
-			"Page allocated via order %u, mask %#x(%pGg)\n",
+			"Page allocated via order %u, mask %#x(%pGg), ts %llu ns, stall %llu ns\n",
 			page_ext->order, page_ext->gfp_mask,
-			&page_ext->gfp_mask);
+			&page_ext->gfp_mask, page_ext->ts_nsec,
+			page_ext->stall_ns);
 
 	if (ret >= count)
 		goto err;
@@ -358,6 +409,55 @@ static const struct file_operations proc_page_owner_operations = {
 	.read		= read_page_owner,
 };
 
+static void hist_show_one(struct seq_file *m, const char *what,
+			  atomic64_t (*hist)[MAX_ORDER][PAGE_OWNER_BUCKETS])
+{
+	unsigned int order, bucket;
+	int mt;
+
+	for (mt = 0; mt < MIGRATE_TYPES; mt++) {
+		for (order = 0; order < MAX_ORDER; order++) {
+			u64 count, total = 0;
+
+			for (bucket = 0; bucket < PAGE_OWNER_BUCKETS; bucket++)
+				total += atomic64_read(&hist[mt][order][bucket]);
+			if (!total)
+				continue;
+
+			seq_printf(m, "%-8s order %2u %-11s total %10llu :",
+				   what, order, migratetype_names[mt], total);
+			for (bucket = 0; bucket < PAGE_OWNER_BUCKETS; bucket++) {
+				count = atomic64_read(&hist[mt][order][bucket]);
+				if (!count)
+					continue;
+				seq_printf(m, " <%lluns:%llu",
+					   1ULL << (bucket + 1), count);
+			}
+			seq_putc(m, '\n');
+		}
+	}
+}
+
+static int page_owner_stats_show(struct seq_file *m, void *v)
+{
+	hist_show_one(m, "stall", stall_hist);
+	hist_show_one(m, "lifetime", lifetime_hist);
+
+	return 0;
+}
+
+static int page_owner_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, page_owner_stats_show, NULL);
+}
+
+static const struct file_operations page_owner_stats_operations = {
+	.open		= page_owner_stats_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
 static int __init pageowner_init(void)
 {
 	struct dentry *dentry;
@@ -372,6 +472,11 @@ static int __init pageowner_init(void)
 	if (IS_ERR(dentry))
 		return PTR_ERR(dentry);
 
+	dentry = debugfs_create_file("page_owner_stats", S_IRUSR, NULL,
+			NULL, &page_owner_stats_operations);
+	if (IS_ERR(dentry))
+		return PTR_ERR(dentry);
+
 	return 0;
 }
 late_initcall(pageowner_init)
@@ -30,6 +30,8 @@ file_ra_state_init(struct file_ra_state *ra, struct address_space *mapping)
 {
 	ra->ra_pages = inode_to_bdi(mapping->host)->ra_pages;
 	ra->prev_pos = -1;
+	ra->stride = 0;
+	ra->stride_count = 0;
 }
 EXPORT_SYMBOL_GPL(file_ra_state_init);
 
@@ -434,6 +436,38 @@ ondemand_readahead(struct address_space *mapping,
 	if (offset - prev_offset <= 1UL)
 		goto initial_readahead;
 
+	/*
+	 * Strided access: fixed-length runs separated by a constant
+	 * forward jump, as produced by scans over column-oriented files.
+	 * Every run restarts readahead from scratch, leaving the device
+	 * idle between runs. Once the same jump has repeated, read the
+	 * current run at full size and kick off the next run's I/O early
+	 * so the queue never drains.
+	 */
+	if (offset > prev_offset) {
+		pgoff_t stride = offset - prev_offset;
+
+		if (stride == ra->stride) {
+			if (ra->stride_count < 3)
+				ra->stride_count++;
+		} else {
+			ra->stride = stride;
+			ra->stride_count = 0;
+		}
+
+		if (ra->stride_count >= 2) {
+			ra->start = offset;
+			ra->size = get_init_ra_size(req_size, max);
+			ra->async_size = ra->size > req_size ?
+					 ra->size - req_size : ra->size;
+			if (stride > ra->size)
+				__do_page_cache_readahead(mapping, filp,
+					offset + stride,
+					min(req_size, max), 0, 0);
+			goto readit;
+		}
+	}
+
 	/*
 	 * Query the page cache and look for the traces(cached history pages)
 	 * that a sequential stream would leave behind.
@@ -136,7 +136,8 @@ static inline unsigned long kmem_cache_flags(unsigned long object_size,
 			  SLAB_NOTRACK | SLAB_ACCOUNT)
 #elif defined(CONFIG_SLUB)
 #define SLAB_CACHE_FLAGS (SLAB_NOLEAKTRACE | SLAB_RECLAIM_ACCOUNT | \
-			  SLAB_TEMPORARY | SLAB_NOTRACK | SLAB_ACCOUNT)
+			  SLAB_TEMPORARY | SLAB_NOTRACK | SLAB_ACCOUNT | \
+			  SLAB_MAGAZINE)
 #else
 #define SLAB_CACHE_FLAGS (0)
 #endif
@@ -38,7 +38,7 @@ struct kmem_cache *kmem_cache;
 		SLAB_FAILSLAB | SLAB_KASAN)
 
 #define SLAB_MERGE_SAME (SLAB_RECLAIM_ACCOUNT | SLAB_CACHE_DMA | \
-			 SLAB_NOTRACK | SLAB_ACCOUNT)
+			 SLAB_NOTRACK | SLAB_ACCOUNT | SLAB_MAGAZINE)
 
 /*
  * Merge control. If this is set then no merging of slab caches will occur.
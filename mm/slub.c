@@ -1659,6 +1659,7 @@ static inline void *acquire_slab(struct kmem_cache *s,
 }
 
 static void put_cpu_partial(struct kmem_cache *s, struct page *page, int drain);
+static void magazine_flush(struct kmem_cache *s, struct kmem_cache_magazine *m);
 static inline bool pfmemalloc_match(struct page *page, gfp_t gfpflags);
 
 /*
@@ -2161,6 +2162,9 @@ static inline void __flush_cpu_slab(struct kmem_cache *s, int cpu)
 
 		unfreeze_partials(s, c);
 	}
+
+	if (s->magazine)
+		magazine_flush(s, per_cpu_ptr(s->magazine, cpu));
 }
 
 static void flush_cpu_slab(void *d)
@@ -2175,6 +2179,9 @@ static bool has_cpu_slab(int cpu, void *info)
 	struct kmem_cache *s = info;
 	struct kmem_cache_cpu *c = per_cpu_ptr(s->cpu_slab, cpu);
 
+	if (s->magazine && per_cpu_ptr(s->magazine, cpu)->count)
+		return true;
+
 	return c->page || c->partial;
 }
 
@@ -2487,6 +2494,26 @@ static void *__slab_alloc(struct kmem_cache *s, gfp_t gfpflags, int node,
  *
  * Otherwise we can simply pick the next object from the lockless free list.
  */
+/*
+ * Pop an object from this cpu's magazine.  Objects in the magazine went
+ * through the free hooks when they were pushed, so the caller must run
+ * the normal post-alloc processing on anything returned here.
+ */
+static __always_inline void *magazine_alloc(struct kmem_cache *s)
+{
+	struct kmem_cache_magazine *m;
+	unsigned long flags;
+	void *object = NULL;
+
+	local_irq_save(flags);
+	m = this_cpu_ptr(s->magazine);
+	if (m->count)
+		object = m->objs[--m->count];
+	local_irq_restore(flags);
+
+	return object;
+}
+
 static __always_inline void *slab_alloc_node(struct kmem_cache *s,
 		gfp_t gfpflags, int node, unsigned long addr)
 {
@@ -2498,6 +2525,18 @@ static __always_inline void *slab_alloc_node(struct kmem_cache *s,
 	s = slab_pre_alloc_hook(s, gfpflags);
 	if (!s)
 		return NULL;
+
+	/*
+	 * The magazine cannot honour a specific node; that case takes
+	 * the regular path, which can pick a matching slab.
+	 */
+	if (unlikely(s->magazine != NULL) && node == NUMA_NO_NODE) {
+		object = magazine_alloc(s);
+		if (object) {
+			stat(s, ALLOC_FASTPATH);
+			goto out;
+		}
+	}
 redo:
 	/*
 	 * Must read kmem_cache cpu data via this cpu ptr. Preemption is
@@ -2566,6 +2605,7 @@ redo:
 		stat(s, ALLOC_FASTPATH);
 	}
 
+out:
 	if (unlikely(gfpflags & __GFP_ZERO) && object)
 		memset(object, 0, s->object_size);
 
@@ -2753,6 +2793,43 @@ slab_empty:
 	discard_slab(s, page);
 }
 
+/*
+ * Return objects from this cpu's magazine to their slabs until only
+ * @keep remain.  The free hooks already ran when the objects were
+ * pushed, so the objects go straight to __slab_free().
+ */
+static void magazine_drain_local(struct kmem_cache *s, unsigned int keep)
+{
+	void *batch[SLUB_MAGAZINE_SIZE];
+	struct kmem_cache_magazine *m;
+	unsigned int n = 0, i;
+	unsigned long flags;
+
+	local_irq_save(flags);
+	m = this_cpu_ptr(s->magazine);
+	while (m->count > keep)
+		batch[n++] = m->objs[--m->count];
+	local_irq_restore(flags);
+
+	for (i = 0; i < n; i++)
+		__slab_free(s, virt_to_head_page(batch[i]), batch[i],
+			    batch[i], 1, _RET_IP_);
+}
+
+/*
+ * Empty a magazine the caller has exclusive access to, either because
+ * it belongs to this cpu with irqs disabled or because its cpu is dead.
+ */
+static void magazine_flush(struct kmem_cache *s, struct kmem_cache_magazine *m)
+{
+	while (m->count) {
+		void *object = m->objs[--m->count];
+
+		__slab_free(s, virt_to_head_page(object), object, object, 1,
+			    _RET_IP_);
+	}
+}
+
 /*
  * Fastpath with forced inlining to produce a kfree and kmem_cache_free that
  * can perform fastpath freeing without additional function calls.
@@ -2778,6 +2855,27 @@ static __always_inline void slab_free(struct kmem_cache *s, struct page *page,
 
 	slab_free_freelist_hook(s, head, tail);
 
+	if (unlikely(s->magazine != NULL) && !tail) {
+		struct kmem_cache_magazine *m;
+		unsigned long flags;
+
+		local_irq_save(flags);
+		m = this_cpu_ptr(s->magazine);
+		if (likely(m->count < SLUB_MAGAZINE_SIZE)) {
+			m->objs[m->count++] = head;
+			local_irq_restore(flags);
+			stat(s, FREE_FASTPATH);
+			return;
+		}
+		local_irq_restore(flags);
+
+		/*
+		 * Magazine full: spill half back to the slabs, then let
+		 * this object take the regular path.
+		 */
+		magazine_drain_local(s, SLUB_MAGAZINE_SIZE / 2);
+	}
+
 redo:
 	/*
 	 * Determine the currently cpus per cpu slab.
@@ -3207,6 +3305,7 @@ static void free_kmem_cache_nodes(struct kmem_cache *s)
 
 void __kmem_cache_release(struct kmem_cache *s)
 {
+	free_percpu(s->magazine);
 	free_percpu(s->cpu_slab);
 	free_kmem_cache_nodes(s);
 }
@@ -3434,8 +3533,17 @@ static int kmem_cache_open(struct kmem_cache *s, unsigned long flags)
 	if (!init_kmem_cache_nodes(s))
 		goto error;
 
-	if (alloc_kmem_cache_cpus(s))
+	if (alloc_kmem_cache_cpus(s)) {
+		/*
+		 * The magazine is a best-effort accelerator: it is
+		 * skipped for debug caches, and failing to allocate it
+		 * just leaves the cache on the regular paths.
+		 */
+		if ((s->flags & SLAB_MAGAZINE) && !kmem_cache_debug(s))
+			s->magazine =
+				alloc_percpu(struct kmem_cache_magazine);
 		return 0;
+	}
 
 	free_kmem_cache_nodes(s);
 error:
@@ -4756,6 +4864,39 @@ static ssize_t objects_partial_show(struct kmem_cache *s, char *buf)
 }
 SLAB_ATTR_RO(objects_partial);
 
+static ssize_t fragmentation_show(struct kmem_cache *s, char *buf)
+{
+	unsigned long nr_partial = 0;
+	unsigned long nr_inuse = 0;
+	unsigned long nr_free = 0;
+	struct kmem_cache_node *n;
+	int node;
+
+	for_each_kmem_cache_node(s, node, n) {
+		unsigned long flags;
+		struct page *page;
+
+		spin_lock_irqsave(&n->list_lock, flags);
+		list_for_each_entry(page, &n->partial, lru) {
+			nr_partial++;
+			nr_inuse += page->inuse;
+			nr_free += page->objects - page->inuse;
+		}
+		spin_unlock_irqrestore(&n->list_lock, flags);
+	}
+
+	/*
+	 * The reclaimable figure is an upper bound: it is the memory held
+	 * by free object slots on partial slabs, i.e. what perfect object
+	 * packing (or a shrink that empties sparse slabs) could give back.
+	 */
+	return sprintf(buf, "partial_slabs %lu\navg_objs_per_partial %lu\nreclaimable_kb %lu\n",
+		       nr_partial,
+		       nr_partial ? nr_inuse / nr_partial : 0,
+		       (nr_free * s->size) >> 10);
+}
+SLAB_ATTR_RO(fragmentation);
+
 static ssize_t slabs_cpu_partial_show(struct kmem_cache *s, char *buf)
 {
 	int objects = 0;
@@ -5131,6 +5272,7 @@ static struct attribute *slab_attrs[] = {
 	&objects_attr.attr,
 	&objects_partial_attr.attr,
 	&partial_attr.attr,
+	&fragmentation_attr.attr,
 	&cpu_slabs_attr.attr,
 	&ctor_attr.attr,
 	&aliases_attr.attr,
@@ -639,11 +639,80 @@ no_page:
 	return 0;
 }
 
+/*
+ * Per-cpu caches of allocated swap slots, refilled in batches so that a
+ * reclaim burst does not serialize on swap_avail_lock and si->lock for
+ * every single page.  The spinlock is uncontended in the fast path; it
+ * only sees cross-cpu traffic when swapoff drains the caches.
+ */
+#define SWAP_SLOT_CACHE_SIZE	16
+
+struct swap_slot_cache {
+	spinlock_t	lock;
+	unsigned int	n;
+	swp_entry_t	slots[SWAP_SLOT_CACHE_SIZE];
+};
+
+static DEFINE_PER_CPU(struct swap_slot_cache, swp_slot_cache) = {
+	.lock = __SPIN_LOCK_UNLOCKED(swp_slot_cache.lock),
+};
+static bool swap_slot_cache_enabled __read_mostly;
+
+static swp_entry_t swap_slot_cache_get(void)
+{
+	struct swap_slot_cache *cache = raw_cpu_ptr(&swp_slot_cache);
+	swp_entry_t entry = (swp_entry_t) {0};
+
+	spin_lock(&cache->lock);
+	if (cache->n)
+		entry = cache->slots[--cache->n];
+	spin_unlock(&cache->lock);
+
+	return entry;
+}
+
+static void swap_slot_cache_put(swp_entry_t *slots, unsigned int n)
+{
+	struct swap_slot_cache *cache = raw_cpu_ptr(&swp_slot_cache);
+	unsigned int i = 0;
+
+	spin_lock(&cache->lock);
+	while (i < n && cache->n < SWAP_SLOT_CACHE_SIZE)
+		cache->slots[cache->n++] = slots[i++];
+	spin_unlock(&cache->lock);
+
+	/* whatever did not fit goes straight back */
+	while (i < n)
+		swapcache_free(slots[i++]);
+}
+
+static void drain_swap_slot_caches(void)
+{
+	int cpu;
+
+	swap_slot_cache_enabled = false;
+	for_each_possible_cpu(cpu) {
+		struct swap_slot_cache *cache = &per_cpu(swp_slot_cache, cpu);
+
+		spin_lock(&cache->lock);
+		while (cache->n)
+			swapcache_free(cache->slots[--cache->n]);
+		spin_unlock(&cache->lock);
+	}
+}
+
 swp_entry_t get_swap_page(void)
 {
 	struct swap_info_struct *si, *next;
 	pgoff_t offset;
 
+	if (swap_slot_cache_enabled) {
+		swp_entry_t entry = swap_slot_cache_get();
+
+		if (entry.val)
+			return entry;
+	}
+
 	if (atomic_long_read(&nr_swap_pages) <= 0)
 		goto noswap;
 	atomic_long_dec(&nr_swap_pages);
@@ -675,6 +744,34 @@ start_over:
 
 		/* This is called for allocating swap entry for cache */
 		offset = scan_swap_map(si, SWAP_HAS_CACHE);
+		if (offset && swap_slot_cache_enabled) {
+			swp_entry_t batch[SWAP_SLOT_CACHE_SIZE];
+			unsigned int n = 0;
+
+			/*
+			 * Refill this cpu's slot cache while we hold
+			 * si->lock anyway; every slot taken here is one
+			 * fewer trip through the locks during the next
+			 * reclaim burst.
+			 */
+			while (n < SWAP_SLOT_CACHE_SIZE) {
+				pgoff_t extra;
+
+				if (atomic_long_read(&nr_swap_pages) <= 0)
+					break;
+				atomic_long_dec(&nr_swap_pages);
+				extra = scan_swap_map(si, SWAP_HAS_CACHE);
+				if (!extra) {
+					atomic_long_inc(&nr_swap_pages);
+					break;
+				}
+				batch[n++] = swp_entry(si->type, extra);
+			}
+			spin_unlock(&si->lock);
+			if (n)
+				swap_slot_cache_put(batch, n);
+			return swp_entry(si->type, offset);
+		}
 		spin_unlock(&si->lock);
 		if (offset)
 			return swp_entry(si->type, offset);
@@ -1809,6 +1906,7 @@ static void _enable_swap_info(struct swap_info_struct *p, int prio,
 	spin_lock(&swap_avail_lock);
 	plist_add(&p->avail_list, &swap_avail_head);
 	spin_unlock(&swap_avail_lock);
+	swap_slot_cache_enabled = true;
 }
 
 static void enable_swap_info(struct swap_info_struct *p, int prio,
@@ -1903,6 +2001,12 @@ SYSCALL_DEFINE1(swapoff, const char __user *, specialfile)
 	spin_unlock(&p->lock);
 	spin_unlock(&swap_lock);
 
+	/*
+	 * Cached slots would keep their swap_map entries pinned and
+	 * stall try_to_unuse() forever; give them all back first.
+	 */
+	drain_swap_slot_caches();
+
 	set_current_oom_origin();
 	err = try_to_unuse(p->type, false, 0); /* force unuse all pages */
 	clear_current_oom_origin();
@@ -1913,6 +2017,10 @@ SYSCALL_DEFINE1(swapoff, const char __user *, specialfile)
 		goto out_dput;
 	}
 
+	/* other devices may still be swapping */
+	if (total_swap_pages)
+		swap_slot_cache_enabled = true;
+
 	flush_work(&p->discard_work);
 
 	destroy_swap_extents(p);
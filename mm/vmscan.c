@@ -135,6 +135,29 @@ struct scan_control {
 #define prefetchw_prev_lru_page(_page, _base, _field) do { } while (0)
 #endif
 
+/*
+ * Generational aging mode.  When enabled, reclaim under sustained
+ * pressure treats each full pass over the inactive list as a
+ * "generation" and stops paying the per-page rmap walk for pages that
+ * reach the tail without the software referenced bit set: such pages
+ * have already survived one generation unreferenced and are reclaimed
+ * directly.  This trades a little aging accuracy for a large cut in
+ * page_referenced() CPU time on machines with many mapped file pages.
+ *
+ * Enabled with lru_gen_aging=1 on the kernel command line.
+ */
+static int lru_gen_aging __read_mostly;
+
+static int __init set_lru_gen_aging(char *str)
+{
+	int rc = kstrtoint(str, 0, &lru_gen_aging);
+
+	if (rc)
+		return rc;
+	return 1;
+}
+__setup("lru_gen_aging=", set_lru_gen_aging);
+
 /*
  * From 0 .. 100.  Higher means more swappy.
  */
@@ -795,6 +818,17 @@ static enum page_references page_check_references(struct page *page,
 	int referenced_ptes, referenced_page;
 	unsigned long vm_flags;
 
+	/*
+	 * In generational aging mode, a page that comes off the tail of
+	 * the inactive list under real pressure without the referenced
+	 * bit has gone a whole generation unused; skip the expensive
+	 * rmap walk and reclaim it.  try_to_unmap() still honours young
+	 * pte bits, so a page that is genuinely in use bounces back.
+	 */
+	if (lru_gen_aging && sc->priority < DEF_PRIORITY - 2 &&
+	    !PageReferenced(page) && !PageSwapBacked(page))
+		return PAGEREF_RECLAIM;
+
 	referenced_ptes = page_referenced(page, 1, sc->target_mem_cgroup,
 					  &vm_flags);
 	referenced_page = TestClearPageReferenced(page);
@@ -2840,13 +2874,17 @@ unsigned long try_to_free_pages(struct zonelist *zonelist, int order,
 		.may_swap = 1,
 	};
 
+	pressure_memstall_enter();
+
 	/*
 	 * Do not enter reclaim if fatal signal was delivered while throttled.
 	 * 1 is returned so that the page allocator does not OOM kill at this
 	 * point.
 	 */
-	if (throttle_direct_reclaim(gfp_mask, zonelist, nodemask))
+	if (throttle_direct_reclaim(gfp_mask, zonelist, nodemask)) {
+		pressure_memstall_leave();
 		return 1;
+	}
 
 	trace_mm_vmscan_direct_reclaim_begin(order,
 				sc.may_writepage,
@@ -2856,6 +2894,8 @@ unsigned long try_to_free_pages(struct zonelist *zonelist, int order,
 
 	trace_mm_vmscan_direct_reclaim_end(nr_reclaimed);
 
+	pressure_memstall_leave();
+
 	return nr_reclaimed;
 }
 
@@ -2929,8 +2969,12 @@ unsigned long try_to_free_mem_cgroup_pages(struct mem_cgroup *memcg,
 					    sc.may_writepage,
 					    sc.gfp_mask);
 
+	pressure_memstall_enter();
+
 	nr_reclaimed = do_try_to_free_pages(zonelist, &sc);
 
+	pressure_memstall_leave();
+
 	trace_mm_vmscan_memcg_reclaim_end(nr_reclaimed);
 
 	return nr_reclaimed;
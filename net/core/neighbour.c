@@ -51,6 +51,12 @@ do {						\
 
 #define PNEIGH_HASHMASK		0xF
 
+/* Buckets aged per neigh_periodic_work() invocation; on large tables
+ * the walk is spread over several invocations so the write lock is
+ * never held across the whole table.
+ */
+#define NEIGH_GC_BUCKETS	32
+
 static void neigh_timer_handler(unsigned long arg);
 static void __neigh_notify(struct neighbour *n, int type, int flags);
 static void neigh_update_notify(struct neighbour *neigh);
@@ -742,7 +748,8 @@ static void neigh_periodic_work(struct work_struct *work)
 	struct neigh_table *tbl = container_of(work, struct neigh_table, gc_work.work);
 	struct neighbour *n;
 	struct neighbour __rcu **np;
-	unsigned int i;
+	unsigned int i, budget;
+	unsigned long delay;
 	struct neigh_hash_table *nht;
 
 	NEIGH_CACHE_STAT_INC(tbl, periodic_gc_runs);
@@ -763,10 +770,18 @@ static void neigh_periodic_work(struct work_struct *work)
 				neigh_rand_reach_time(NEIGH_VAR(p, BASE_REACHABLE_TIME));
 	}
 
+	delay = NEIGH_VAR(&tbl->parms, BASE_REACHABLE_TIME) >> 1;
+
 	if (atomic_read(&tbl->entries) < tbl->gc_thresh1)
 		goto out;
 
-	for (i = 0 ; i < (1 << nht->hash_shift); i++) {
+	/* Age a bounded chunk of buckets per invocation, resuming where
+	 * the previous one stopped, so the write lock is only ever held
+	 * for a handful of chains at a time.
+	 */
+	for (budget = min_t(unsigned int, 1 << nht->hash_shift,
+			    NEIGH_GC_BUCKETS); budget; budget--) {
+		i = tbl->gc_index++ & ((1 << nht->hash_shift) - 1);
 		np = &nht->hash_buckets[i];
 
 		while ((n = rcu_dereference_protected(*np,
@@ -808,13 +823,19 @@ next_elt:
 		nht = rcu_dereference_protected(tbl->nht,
 						lockdep_is_held(&tbl->lock));
 	}
-out:
+
 	/* Cycle through all hash buckets every BASE_REACHABLE_TIME/2 ticks.
 	 * ARP entry timeouts range from 1/2 BASE_REACHABLE_TIME to 3/2
-	 * BASE_REACHABLE_TIME.
+	 * BASE_REACHABLE_TIME.  When the table is larger than one chunk,
+	 * run proportionally more often so a full pass still completes
+	 * in that interval.
 	 */
-	queue_delayed_work(system_power_efficient_wq, &tbl->gc_work,
-			      NEIGH_VAR(&tbl->parms, BASE_REACHABLE_TIME) >> 1);
+	if ((1 << nht->hash_shift) > NEIGH_GC_BUCKETS)
+		delay = max_t(unsigned long,
+			      delay / DIV_ROUND_UP(1 << nht->hash_shift,
+						   NEIGH_GC_BUCKETS), 1);
+out:
+	queue_delayed_work(system_power_efficient_wq, &tbl->gc_work, delay);
 	write_unlock_bh(&tbl->lock);
 }
 
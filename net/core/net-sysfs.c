@@ -686,34 +686,18 @@ static ssize_t show_rps_map(struct netdev_rx_queue *queue,
 	return len < PAGE_SIZE ? len : -EINVAL;
 }
 
-static ssize_t store_rps_map(struct netdev_rx_queue *queue,
-		      struct rx_queue_attribute *attribute,
-		      const char *buf, size_t len)
+static int netdev_rx_queue_set_rps_mask(struct netdev_rx_queue *queue,
+					const struct cpumask *mask)
 {
-	struct rps_map *old_map, *map;
-	cpumask_var_t mask;
-	int err, cpu, i;
 	static DEFINE_MUTEX(rps_map_mutex);
-
-	if (!capable(CAP_NET_ADMIN))
-		return -EPERM;
-
-	if (!alloc_cpumask_var(&mask, GFP_KERNEL))
-		return -ENOMEM;
-
-	err = bitmap_parse(buf, len, cpumask_bits(mask), nr_cpumask_bits);
-	if (err) {
-		free_cpumask_var(mask);
-		return err;
-	}
+	struct rps_map *old_map, *map;
+	int cpu, i;
 
 	map = kzalloc(max_t(unsigned int,
 	    RPS_MAP_SIZE(cpumask_weight(mask)), L1_CACHE_BYTES),
 	    GFP_KERNEL);
-	if (!map) {
-		free_cpumask_var(mask);
+	if (!map)
 		return -ENOMEM;
-	}
 
 	i = 0;
 	for_each_cpu_and(cpu, mask, cpu_online_mask)
@@ -740,9 +724,28 @@ static ssize_t store_rps_map(struct netdev_rx_queue *queue,
 
 	if (old_map)
 		kfree_rcu(old_map, rcu);
+	return 0;
+}
+
+static ssize_t store_rps_map(struct netdev_rx_queue *queue,
+		      struct rx_queue_attribute *attribute,
+		      const char *buf, size_t len)
+{
+	cpumask_var_t mask;
+	int err;
+
+	if (!capable(CAP_NET_ADMIN))
+		return -EPERM;
+
+	if (!alloc_cpumask_var(&mask, GFP_KERNEL))
+		return -ENOMEM;
+
+	err = bitmap_parse(buf, len, cpumask_bits(mask), nr_cpumask_bits);
+	if (!err)
+		err = netdev_rx_queue_set_rps_mask(queue, mask);
 
 	free_cpumask_var(mask);
-	return len;
+	return err ? : len;
 }
 
 static ssize_t show_rps_dev_flow_table_cnt(struct netdev_rx_queue *queue,
@@ -768,21 +771,12 @@ static void rps_dev_flow_table_release(struct rcu_head *rcu)
 	vfree(table);
 }
 
-static ssize_t store_rps_dev_flow_table_cnt(struct netdev_rx_queue *queue,
-				     struct rx_queue_attribute *attr,
-				     const char *buf, size_t len)
+static int netdev_rx_queue_set_rps_flow_cnt(struct netdev_rx_queue *queue,
+					    unsigned long count)
 {
-	unsigned long mask, count;
+	unsigned long mask;
 	struct rps_dev_flow_table *table, *old_table;
 	static DEFINE_SPINLOCK(rps_dev_flow_lock);
-	int rc;
-
-	if (!capable(CAP_NET_ADMIN))
-		return -EPERM;
-
-	rc = kstrtoul(buf, 0, &count);
-	if (rc < 0)
-		return rc;
 
 	if (count) {
 		mask = count - 1;
@@ -824,7 +818,25 @@ static ssize_t store_rps_dev_flow_table_cnt(struct netdev_rx_queue *queue,
 	if (old_table)
 		call_rcu(&old_table->rcu, rps_dev_flow_table_release);
 
-	return len;
+	return 0;
+}
+
+static ssize_t store_rps_dev_flow_table_cnt(struct netdev_rx_queue *queue,
+				     struct rx_queue_attribute *attr,
+				     const char *buf, size_t len)
+{
+	unsigned long count;
+	int rc;
+
+	if (!capable(CAP_NET_ADMIN))
+		return -EPERM;
+
+	rc = kstrtoul(buf, 0, &count);
+	if (rc < 0)
+		return rc;
+
+	rc = netdev_rx_queue_set_rps_flow_cnt(queue, count);
+	return rc ? : len;
 }
 
 static struct rx_queue_attribute rps_cpus_attribute =
@@ -906,6 +918,23 @@ static int rx_queue_add_kobject(struct net_device *dev, int index)
 			goto exit;
 	}
 
+#ifdef CONFIG_RPS
+	/* Seed the queue with the global defaults, if any; both remain
+	 * overridable per queue through the attributes above.
+	 */
+	if (!cpumask_empty(&rps_default_mask)) {
+		error = netdev_rx_queue_set_rps_mask(queue, &rps_default_mask);
+		if (error)
+			goto exit;
+	}
+	if (rps_default_flow_cnt) {
+		error = netdev_rx_queue_set_rps_flow_cnt(queue,
+							 rps_default_flow_cnt);
+		if (error)
+			goto exit;
+	}
+#endif
+
 	kobject_uevent(kobj, KOBJ_ADD);
 	dev_hold(queue->dev);
 
@@ -0,0 +1,274 @@
+/*
+ * page_pool.c
+ *	Recycling page allocator for driver RX rings.
+ *
+ * See include/net/page_pool.h for the API description.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version
+ * 2 of the License, or (at your option) any later version.
+ */
+#include <linux/types.h>
+#include <linux/kernel.h>
+#include <linux/slab.h>
+#include <linux/module.h>
+#include <linux/mm.h>
+#include <linux/page_ref.h>
+#include <linux/poison.h>
+#include <linux/dma-mapping.h>
+
+#include <net/page_pool.h>
+
+struct page_pool *page_pool_create(const struct page_pool_params *params)
+{
+	struct page_pool *pool;
+
+	if (params->flags & ~PP_FLAG_ALL)
+		return ERR_PTR(-EINVAL);
+
+	if (params->flags & PP_FLAG_DMA_MAP) {
+		if (!params->dev)
+			return ERR_PTR(-EINVAL);
+		if (params->dma_dir != DMA_FROM_DEVICE &&
+		    params->dma_dir != DMA_BIDIRECTIONAL)
+			return ERR_PTR(-EINVAL);
+		/* The mapping is parked in page->private while the page
+		 * is outside the pool.
+		 */
+		if (sizeof(dma_addr_t) > sizeof(unsigned long))
+			return ERR_PTR(-EOPNOTSUPP);
+	}
+
+	pool = kzalloc_node(sizeof(*pool), GFP_KERNEL, params->nid);
+	if (!pool)
+		return ERR_PTR(-ENOMEM);
+
+	pool->p = *params;
+	spin_lock_init(&pool->ring_lock);
+	INIT_LIST_HEAD(&pool->ring);
+	atomic_set(&pool->ref, 1);
+
+	return pool;
+}
+EXPORT_SYMBOL(page_pool_create);
+
+static void page_pool_ref_put(struct page_pool *pool)
+{
+	if (atomic_dec_and_test(&pool->ref))
+		kfree(pool);
+}
+
+/* Unmap and free a page the pool holds itself (caches, destroy); such
+ * pages carry no reference on the pool.
+ */
+static void page_pool_free_cached(struct page_pool *pool, struct page *page)
+{
+	if (pool->p.flags & PP_FLAG_DMA_MAP) {
+		dma_unmap_page(pool->p.dev, page_pool_get_dma_addr(page),
+			       PAGE_SIZE << pool->p.order, pool->p.dma_dir);
+		set_page_private(page, 0);
+	}
+	put_page(page);
+}
+
+/* Hand a page that was given out back to the page allocator.  A shared
+ * page can arrive here from several owners at once; the one that clears
+ * the ownership stamp unmaps the page and drops the pool reference, the
+ * others only drop their page reference.
+ */
+static void page_pool_release_page(struct page_pool *pool, struct page *page)
+{
+	unsigned long *pp_word = (unsigned long *)&page->lru.next;
+
+	if (cmpxchg(pp_word, (unsigned long)PP_SIGNATURE, 0UL) ==
+	    (unsigned long)PP_SIGNATURE) {
+		page_pool_free_cached(pool, page);
+		page_pool_ref_put(pool);
+		return;
+	}
+	put_page(page);
+}
+
+static struct page *__page_pool_get_cached(struct page_pool *pool)
+{
+	struct page *page;
+
+	if (likely(pool->alloc_count))
+		return pool->alloc_cache[--pool->alloc_count];
+
+	spin_lock_bh(&pool->ring_lock);
+	while (pool->ring_count && pool->alloc_count < PP_ALLOC_CACHE_REFILL) {
+		page = list_first_entry(&pool->ring, struct page, lru);
+		list_del(&page->lru);
+		pool->ring_count--;
+		pool->alloc_cache[pool->alloc_count++] = page;
+	}
+	spin_unlock_bh(&pool->ring_lock);
+
+	return pool->alloc_count ?
+	       pool->alloc_cache[--pool->alloc_count] : NULL;
+}
+
+static struct page *__page_pool_alloc_pages_slow(struct page_pool *pool,
+						 gfp_t gfp)
+{
+	struct page *page;
+
+	if (pool->p.order)
+		gfp |= __GFP_COMP;
+
+	page = alloc_pages_node(pool->p.nid, gfp, pool->p.order);
+	if (!page)
+		return NULL;
+
+	if (pool->p.flags & PP_FLAG_DMA_MAP) {
+		dma_addr_t dma;
+
+		dma = dma_map_page(pool->p.dev, page, 0,
+				   PAGE_SIZE << pool->p.order,
+				   pool->p.dma_dir);
+		if (dma_mapping_error(pool->p.dev, dma)) {
+			put_page(page);
+			return NULL;
+		}
+		set_page_private(page, dma);
+	}
+
+	return page;
+}
+
+/**
+ * page_pool_alloc_pages - get a page from the pool or the page allocator
+ * @pool: pool to draw from
+ * @gfp: gfp flags for the slow path
+ *
+ * Must be called from the RX/NAPI context of the queue owning @pool.
+ * A recycled page keeps the DMA mapping it was given out with, so the
+ * dma_map_page() cost is only paid on the allocator slow path.
+ */
+struct page *page_pool_alloc_pages(struct page_pool *pool, gfp_t gfp)
+{
+	struct page *page;
+
+	page = __page_pool_get_cached(pool);
+	if (!page) {
+		page = __page_pool_alloc_pages_slow(pool, gfp);
+		if (unlikely(!page))
+			return NULL;
+	}
+
+	/* Stamp ownership so the skb free path can route the page back.
+	 * The lru words are unused while the page belongs to a driver or
+	 * an skb.
+	 */
+	page->lru.next = (struct list_head *)PP_SIGNATURE;
+	page->lru.prev = (struct list_head *)pool;
+	atomic_inc(&pool->ref);
+
+	return page;
+}
+EXPORT_SYMBOL(page_pool_alloc_pages);
+
+/**
+ * page_pool_put_page - return a page to the pool
+ * @pool: pool the page came from
+ * @page: page to return
+ * @allow_direct: true only when called from the pool's own NAPI context
+ *
+ * Recycles the page if the caller holds the last reference to it;
+ * otherwise the page goes back to the page allocator and a remaining
+ * owner frees it normally.
+ */
+void page_pool_put_page(struct page_pool *pool, struct page *page,
+			bool allow_direct)
+{
+	/* With a single reference left nobody else can see the page, so
+	 * it can go on the free-running caches.  Emergency pfmemalloc
+	 * pages and pages from a foreign node are not worth keeping.
+	 */
+	if (likely(page_ref_count(page) == 1) &&
+	    !page_is_pfmemalloc(page) &&
+	    (pool->p.nid == NUMA_NO_NODE ||
+	     page_to_nid(page) == pool->p.nid)) {
+		if (allow_direct && !pool->destroyed &&
+		    pool->alloc_count < PP_ALLOC_CACHE_SIZE) {
+			pool->alloc_cache[pool->alloc_count++] = page;
+			atomic_dec(&pool->ref);
+			return;
+		}
+
+		spin_lock_bh(&pool->ring_lock);
+		if (!pool->destroyed && pool->ring_count < pool->p.pool_size) {
+			list_add(&page->lru, &pool->ring);
+			pool->ring_count++;
+			/* Drop the outstanding-page reference before
+			 * releasing the lock; page_pool_destroy() may
+			 * free the page the moment we unlock.
+			 */
+			atomic_dec(&pool->ref);
+			spin_unlock_bh(&pool->ring_lock);
+			return;
+		}
+		spin_unlock_bh(&pool->ring_lock);
+	}
+
+	page_pool_release_page(pool, page);
+}
+EXPORT_SYMBOL(page_pool_put_page);
+
+/**
+ * page_pool_return_skb_page - give a page freed from an skb back to its pool
+ * @page: page (or tail page) being freed
+ *
+ * Called from the skb free path for skbs marked with
+ * skb_mark_for_recycle().  Returns false if the page does not belong to
+ * a pool and should be freed normally.
+ */
+bool page_pool_return_skb_page(struct page *page)
+{
+	struct page_pool *pool;
+
+	page = compound_head(page);
+
+	/* A stamped page holds a reference on its pool, so the pool
+	 * cannot go away under us here.
+	 */
+	if (READ_ONCE(page->lru.next) != (struct list_head *)PP_SIGNATURE)
+		return false;
+
+	pool = (struct page_pool *)READ_ONCE(page->lru.prev);
+	page_pool_put_page(pool, page, false);
+	return true;
+}
+EXPORT_SYMBOL(page_pool_return_skb_page);
+
+/**
+ * page_pool_destroy - release a pool's cached pages and drop its reference
+ * @pool: pool to destroy
+ *
+ * The caller must have quiesced the RX path first; the alloc cache is
+ * not locked.  Pages still held by in-flight skbs keep the pool (and
+ * their DMA mapping) alive until they come back; the last one frees it.
+ */
+void page_pool_destroy(struct page_pool *pool)
+{
+	struct page *page;
+
+	while (pool->alloc_count)
+		page_pool_free_cached(pool,
+				      pool->alloc_cache[--pool->alloc_count]);
+
+	spin_lock_bh(&pool->ring_lock);
+	pool->destroyed = true;
+	while (!list_empty(&pool->ring)) {
+		page = list_first_entry(&pool->ring, struct page, lru);
+		list_del(&page->lru);
+		pool->ring_count--;
+		page_pool_free_cached(pool, page);
+	}
+	spin_unlock_bh(&pool->ring_lock);
+
+	page_pool_ref_put(pool);
+}
+EXPORT_SYMBOL(page_pool_destroy);
@@ -203,6 +203,11 @@
 #define F_NODE          (1<<15)	/* Node memory alloc*/
 #define F_UDPCSUM       (1<<16)	/* Include UDP checksum */
 #define F_NO_TIMESTAMP  (1<<17)	/* Don't timestamp packets (default TS) */
+#define F_RECEIVE       (1<<18)	/* Measure pktgen traffic arriving on
+				 * the bound device instead of sending */
+
+/* log2(ns) latency histogram buckets, i.e. 1ns .. ~2s */
+#define PKTGEN_RTT_BUCKETS	31
 
 /* Thread control flag bits */
 #define T_STOP        (1<<0)	/* Stop run */
@@ -394,6 +399,21 @@ struct pktgen_dev {
 	unsigned int burst;	/* number of duplicated packets to burst */
 	int node;               /* Memory node */
 
+	/* receive-side measurement (flag RECEIVE) */
+	struct packet_type rx_pt;
+	bool rx_active;
+	spinlock_t rx_lock;
+	u64 rx_pkts;
+	u64 rx_bytes;
+	u64 rx_lost;		/* estimated from sequence gaps */
+	u64 rx_reorder;		/* late or duplicated sequence numbers */
+	u32 rx_last_seq;
+	u64 rtt_min;		/* all in nano-seconds */
+	u64 rtt_max;
+	u64 rtt_sum;
+	u64 rtt_samples;
+	u64 rtt_hist[PKTGEN_RTT_BUCKETS];
+
 #ifdef CONFIG_XFRM
 	__u8	ipsmode;		/* IPSEC mode (config) */
 	__u8	ipsproto;		/* IPSEC type (config) */
@@ -530,6 +550,118 @@ static const struct file_operations pktgen_fops = {
 	.release = single_release,
 };
 
+/*
+ * Receive-side measurement.  A pktgen device with the RECEIVE flag does
+ * not transmit; instead it hooks the bound interface with a packet_type
+ * handler and accounts every IPv4/UDP packet carrying the pktgen magic.
+ * Bind it to the peer of a veth pair (or the receiving NIC) while a
+ * normal pktgen device transmits from the other side and the delivery
+ * path, including GRO and RPS, is exercised and measured in-tree.
+ *
+ * One-way delay comes from the timestamp the transmitter embeds; with
+ * both ends on the same host (the veth self-test) the clocks are one
+ * and the numbers are exact.  Hardware receive timestamps are used
+ * when the driver provides them.
+ */
+static int pktgen_rcv(struct sk_buff *skb, struct net_device *dev,
+		      struct packet_type *pt, struct net_device *orig_dev)
+{
+	struct pktgen_dev *pkt_dev = pt->af_packet_priv;
+	const struct pktgen_hdr *pgh;
+	struct pktgen_hdr pghbuf;
+	const struct iphdr *iph;
+	struct iphdr iphbuf;
+	unsigned int offset;
+	u32 seq;
+
+	iph = skb_header_pointer(skb, 0, sizeof(iphbuf), &iphbuf);
+	if (!iph || iph->protocol != IPPROTO_UDP)
+		goto out;
+
+	offset = iph->ihl * 4 + sizeof(struct udphdr);
+	pgh = skb_header_pointer(skb, offset, sizeof(pghbuf), &pghbuf);
+	if (!pgh || pgh->pgh_magic != htonl(PKTGEN_MAGIC))
+		goto out;
+
+	seq = ntohl(pgh->seq_num);
+
+	spin_lock(&pkt_dev->rx_lock);
+	pkt_dev->rx_pkts++;
+	pkt_dev->rx_bytes += skb->len;
+
+	if (seq == pkt_dev->rx_last_seq + 1) {
+		pkt_dev->rx_last_seq = seq;
+	} else if (seq > pkt_dev->rx_last_seq + 1) {
+		pkt_dev->rx_lost += seq - pkt_dev->rx_last_seq - 1;
+		pkt_dev->rx_last_seq = seq;
+	} else {
+		/* late arrival or duplicate; a presumed loss wasn't one */
+		pkt_dev->rx_reorder++;
+		if (pkt_dev->rx_lost)
+			pkt_dev->rx_lost--;
+	}
+
+	if (pgh->tv_sec || pgh->tv_usec) {
+		ktime_t now = skb_hwtstamps(skb)->hwtstamp;
+		u64 send_ns, delay;
+
+		if (!ktime_to_ns(now))
+			now = ktime_get_real();
+		send_ns = (u64)ntohl(pgh->tv_sec) * NSEC_PER_SEC +
+			  (u64)ntohl(pgh->tv_usec) * NSEC_PER_USEC;
+		if (ktime_to_ns(now) > send_ns) {
+			delay = ktime_to_ns(now) - send_ns;
+			pkt_dev->rtt_sum += delay;
+			pkt_dev->rtt_samples++;
+			if (!pkt_dev->rtt_min || delay < pkt_dev->rtt_min)
+				pkt_dev->rtt_min = delay;
+			if (delay > pkt_dev->rtt_max)
+				pkt_dev->rtt_max = delay;
+			pkt_dev->rtt_hist[min_t(int, ilog2(delay),
+						PKTGEN_RTT_BUCKETS - 1)]++;
+		}
+	}
+	spin_unlock(&pkt_dev->rx_lock);
+out:
+	consume_skb(skb);
+	return NET_RX_SUCCESS;
+}
+
+static void pktgen_rx_start(struct pktgen_dev *pkt_dev)
+{
+	if (pkt_dev->rx_active || !pkt_dev->odev)
+		return;
+
+	spin_lock_bh(&pkt_dev->rx_lock);
+	pkt_dev->rx_pkts = 0;
+	pkt_dev->rx_bytes = 0;
+	pkt_dev->rx_lost = 0;
+	pkt_dev->rx_reorder = 0;
+	pkt_dev->rx_last_seq = 0;
+	pkt_dev->rtt_min = 0;
+	pkt_dev->rtt_max = 0;
+	pkt_dev->rtt_sum = 0;
+	pkt_dev->rtt_samples = 0;
+	memset(pkt_dev->rtt_hist, 0, sizeof(pkt_dev->rtt_hist));
+	spin_unlock_bh(&pkt_dev->rx_lock);
+
+	pkt_dev->rx_pt.type = htons(ETH_P_IP);
+	pkt_dev->rx_pt.dev = pkt_dev->odev;
+	pkt_dev->rx_pt.func = pktgen_rcv;
+	pkt_dev->rx_pt.af_packet_priv = pkt_dev;
+	dev_add_pack(&pkt_dev->rx_pt);
+	pkt_dev->rx_active = true;
+}
+
+static void pktgen_rx_stop(struct pktgen_dev *pkt_dev)
+{
+	if (!pkt_dev->rx_active)
+		return;
+
+	dev_remove_pack(&pkt_dev->rx_pt);
+	pkt_dev->rx_active = false;
+}
+
 static int pktgen_if_show(struct seq_file *seq, void *v)
 {
 	const struct pktgen_dev *pkt_dev = seq->private;
@@ -692,6 +824,9 @@ static int pktgen_if_show(struct seq_file *seq, void *v)
 	if (pkt_dev->flags & F_NODE)
 		seq_puts(seq, "NODE_ALLOC  ");
 
+	if (pkt_dev->flags & F_RECEIVE)
+		seq_puts(seq, "RECEIVE  ");
+
 	seq_puts(seq, "\n");
 
 	/* not really stopped, more like last-running-at */
@@ -730,6 +865,31 @@ static int pktgen_if_show(struct seq_file *seq, void *v)
 
 	seq_printf(seq, "     flows: %u\n", pkt_dev->nflows);
 
+	if (pkt_dev->rx_active) {
+		int i;
+
+		seq_printf(seq,
+			   "Receive:\n     pkts: %llu  bytes: %llu  lost: %llu  reorder: %llu\n",
+			   (unsigned long long)pkt_dev->rx_pkts,
+			   (unsigned long long)pkt_dev->rx_bytes,
+			   (unsigned long long)pkt_dev->rx_lost,
+			   (unsigned long long)pkt_dev->rx_reorder);
+		if (pkt_dev->rtt_samples) {
+			seq_printf(seq,
+				   "     delay-ns: min %llu  avg %llu  max %llu  samples %llu\n",
+				   (unsigned long long)pkt_dev->rtt_min,
+				   (unsigned long long)div64_u64(pkt_dev->rtt_sum,
+								 pkt_dev->rtt_samples),
+				   (unsigned long long)pkt_dev->rtt_max,
+				   (unsigned long long)pkt_dev->rtt_samples);
+			seq_puts(seq, "     delay-hist-log2ns:");
+			for (i = 0; i < PKTGEN_RTT_BUCKETS; i++)
+				seq_printf(seq, " %llu",
+					   (unsigned long long)pkt_dev->rtt_hist[i]);
+			seq_puts(seq, "\n");
+		}
+	}
+
 	if (pkt_dev->result[0])
 		seq_printf(seq, "Result: %s\n", pkt_dev->result);
 	else
@@ -1317,6 +1477,16 @@ static ssize_t pktgen_if_write(struct file *file,
 		else if (strcmp(f, "!NO_TIMESTAMP") == 0)
 			pkt_dev->flags &= ~F_NO_TIMESTAMP;
 
+		else if (strcmp(f, "RECEIVE") == 0) {
+			pkt_dev->flags |= F_RECEIVE;
+			pktgen_rx_start(pkt_dev);
+		}
+
+		else if (strcmp(f, "!RECEIVE") == 0) {
+			pkt_dev->flags &= ~F_RECEIVE;
+			pktgen_rx_stop(pkt_dev);
+		}
+
 		else {
 			sprintf(pg_result,
 				"Flag -:%s:- unknown\nAvailable flags, (prepend ! to un-set flag):\n%s",
@@ -1325,7 +1495,7 @@ static ssize_t pktgen_if_write(struct file *file,
 				"MACSRC_RND, MACDST_RND, TXSIZE_RND, IPV6, "
 				"MPLS_RND, VID_RND, SVID_RND, FLOW_SEQ, "
 				"QUEUE_MAP_RND, QUEUE_MAP_CPU, UDPCSUM, "
-				"NO_TIMESTAMP, "
+				"NO_TIMESTAMP, RECEIVE, "
 #ifdef CONFIG_XFRM
 				"IPSEC, "
 #endif
@@ -3082,6 +3252,10 @@ static void pktgen_run(struct pktgen_thread *t)
 	rcu_read_lock();
 	list_for_each_entry_rcu(pkt_dev, &t->if_list, list) {
 
+		/* receive-side devices only count, they never transmit */
+		if (pkt_dev->flags & F_RECEIVE)
+			continue;
+
 		/*
 		 * setup odev and create initial packet.
 		 */
@@ -3656,6 +3830,7 @@ static int pktgen_add_device(struct pktgen_thread *t, const char *ifname)
 
 	pkt_dev->removal_mark = 0;
 	pkt_dev->nfrags = 0;
+	spin_lock_init(&pkt_dev->rx_lock);
 	pkt_dev->delay = pg_delay_d;
 	pkt_dev->count = pg_count_d;
 	pkt_dev->sofar = 0;
@@ -3795,6 +3970,8 @@ static int pktgen_remove_device(struct pktgen_thread *t,
 		pktgen_stop_device(pkt_dev);
 	}
 
+	pktgen_rx_stop(pkt_dev);
+
 	/* Dis-associate from the interface */
 
 	if (pkt_dev->odev) {
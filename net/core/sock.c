@@ -94,6 +94,9 @@
 #include <linux/capability.h>
 #include <linux/errno.h>
 #include <linux/errqueue.h>
+#include <linux/file.h>
+#include <linux/fs.h>
+#include <linux/splice.h>
 #include <linux/types.h>
 #include <linux/socket.h>
 #include <linux/in.h>
@@ -638,6 +641,215 @@ bool sk_mc_loop(struct sock *sk)
 }
 EXPORT_SYMBOL(sk_mc_loop);
 
+/* In-kernel socket splicing (SO_SPLICE).
+ *
+ * Once two connected stream sockets are paired, received data is moved
+ * from one to the other through the regular splice machinery by a
+ * workqueue, without any further syscalls or copies to userspace.  The
+ * engine keeps its own references on both socket files, so a proxy can
+ * close its descriptors and let the pair run until the connection ends.
+ * Flow control is the sockets' own: the transfer stops on an empty
+ * receive queue or a full send buffer and is kicked again by the
+ * data ready/write space callbacks.
+ */
+struct sock_splice {
+	struct work_struct	work;
+	struct work_struct	destroy_work;
+	struct socket		*in_sock;
+	struct socket		*out_sock;
+	void			(*save_data_ready)(struct sock *sk);
+	void			(*save_write_space)(struct sock *sk);
+	unsigned long		stopped;
+	u64			bytes;
+};
+
+/* splice at most this much per work invocation before rescheduling,
+ * so one busy pair cannot monopolize a worker
+ */
+#define SOCK_SPLICE_QUANTUM	(1 << 20)
+
+static void sock_splice_stop(struct sock_splice *sp);
+
+static void sock_splice_work(struct work_struct *work)
+{
+	struct sock_splice *sp = container_of(work, struct sock_splice, work);
+	size_t total = 0;
+	loff_t ipos, opos;
+	long n;
+
+	while (total < SOCK_SPLICE_QUANTUM) {
+		ipos = 0;
+		opos = 0;
+		n = do_splice_direct(sp->in_sock->file, &ipos,
+				     sp->out_sock->file, &opos,
+				     SOCK_SPLICE_QUANTUM - total,
+				     SPLICE_F_NONBLOCK | SPLICE_F_MOVE);
+		if (n <= 0)
+			break;
+		sp->bytes += n;
+		total += n;
+	}
+
+	if (n > 0 || n == -EAGAIN) {
+		/* out of budget, or waiting for data/space: the callbacks
+		 * (or, if we stopped early, this reschedule) continue it
+		 */
+		if (n > 0)
+			queue_work(system_unbound_wq, &sp->work);
+		return;
+	}
+
+	/* EOF or hard error: propagate the close and unwind */
+	if (n == 0)
+		kernel_sock_shutdown(sp->out_sock, SHUT_WR);
+	sock_splice_stop(sp);
+}
+
+static void sock_splice_destroy_work(struct work_struct *work)
+{
+	struct sock_splice *sp = container_of(work, struct sock_splice,
+					      destroy_work);
+
+	cancel_work_sync(&sp->work);
+	fput(sp->in_sock->file);
+	fput(sp->out_sock->file);
+	kfree(sp);
+}
+
+static void sock_splice_data_ready(struct sock *sk)
+{
+	struct sock_splice *sp;
+
+	read_lock_bh(&sk->sk_callback_lock);
+	sp = sk->sk_user_data;
+	if (sp) {
+		queue_work(system_unbound_wq, &sp->work);
+		sp->save_data_ready(sk);
+	}
+	read_unlock_bh(&sk->sk_callback_lock);
+}
+
+static void sock_splice_write_space(struct sock *sk)
+{
+	struct sock_splice *sp;
+
+	read_lock_bh(&sk->sk_callback_lock);
+	sp = sk->sk_user_data;
+	if (sp) {
+		queue_work(system_unbound_wq, &sp->work);
+		sp->save_write_space(sk);
+	}
+	read_unlock_bh(&sk->sk_callback_lock);
+}
+
+/* Unhook both sockets and hand the context to the destroy work, which
+ * waits out a possible concurrent transfer before dropping the file
+ * references.  Safe to call from the transfer work and from setsockopt;
+ * only the first caller wins.
+ */
+static void sock_splice_stop(struct sock_splice *sp)
+{
+	struct sock *isk = sp->in_sock->sk;
+	struct sock *osk = sp->out_sock->sk;
+
+	if (test_and_set_bit(0, &sp->stopped))
+		return;
+
+	write_lock_bh(&isk->sk_callback_lock);
+	isk->sk_data_ready = sp->save_data_ready;
+	isk->sk_user_data = NULL;
+	write_unlock_bh(&isk->sk_callback_lock);
+
+	write_lock_bh(&osk->sk_callback_lock);
+	osk->sk_write_space = sp->save_write_space;
+	osk->sk_user_data = NULL;
+	write_unlock_bh(&osk->sk_callback_lock);
+
+	queue_work(system_unbound_wq, &sp->destroy_work);
+}
+
+/* Called with the socket locked. */
+static int sock_splice_attach(struct sock *sk, int fd)
+{
+	struct socket *in_sock = sk->sk_socket;
+	struct sock_splice *sp;
+	struct socket *out_sock;
+	struct sock *osk;
+	int err;
+
+	if (!in_sock || !in_sock->file)
+		return -EBADF;
+	if (sk->sk_type != SOCK_STREAM || !in_sock->ops->splice_read)
+		return -EOPNOTSUPP;
+	if (sk->sk_user_data)
+		return -EBUSY;
+
+	out_sock = sockfd_lookup(fd, &err);
+	if (!out_sock)
+		return err;
+
+	osk = out_sock->sk;
+	err = -EOPNOTSUPP;
+	if (osk->sk_type != SOCK_STREAM)
+		goto out_put;
+	err = -EINVAL;
+	if (osk == sk || out_sock->state != SS_CONNECTED ||
+	    in_sock->state != SS_CONNECTED)
+		goto out_put;
+	err = -EBUSY;
+	if (osk->sk_user_data)
+		goto out_put;
+
+	err = -ENOMEM;
+	sp = kzalloc(sizeof(*sp), GFP_KERNEL);
+	if (!sp)
+		goto out_put;
+
+	INIT_WORK(&sp->work, sock_splice_work);
+	INIT_WORK(&sp->destroy_work, sock_splice_destroy_work);
+	sp->in_sock = in_sock;
+	sp->out_sock = out_sock;
+	get_file(in_sock->file);
+	/* sockfd_lookup() took the reference on out_sock->file */
+
+	write_lock_bh(&sk->sk_callback_lock);
+	sp->save_data_ready = sk->sk_data_ready;
+	sk->sk_user_data = sp;
+	sk->sk_data_ready = sock_splice_data_ready;
+	write_unlock_bh(&sk->sk_callback_lock);
+
+	write_lock_bh(&osk->sk_callback_lock);
+	sp->save_write_space = osk->sk_write_space;
+	osk->sk_user_data = sp;
+	osk->sk_write_space = sock_splice_write_space;
+	write_unlock_bh(&osk->sk_callback_lock);
+
+	/* drain whatever was queued before the hooks went in */
+	queue_work(system_unbound_wq, &sp->work);
+	return 0;
+
+out_put:
+	fput(out_sock->file);
+	return err;
+}
+
+/* Called with the socket locked. */
+static int sock_splice_detach(struct sock *sk)
+{
+	struct sock_splice *sp = NULL;
+
+	read_lock_bh(&sk->sk_callback_lock);
+	if (sk->sk_data_ready == sock_splice_data_ready)
+		sp = sk->sk_user_data;
+	read_unlock_bh(&sk->sk_callback_lock);
+
+	if (!sp)
+		return -ENOENT;
+
+	sock_splice_stop(sp);
+	return 0;
+}
+
 /*
  *	This is meant for all protocols to use and covers goings on
  *	at the socket level. Everything here is generic.
@@ -991,6 +1203,27 @@ set_rcvbuf:
 		if (val == 1)
 			dst_negative_advice(sk);
 		break;
+
+	case SO_ZEROCOPY:
+		if (sk->sk_family != PF_INET && sk->sk_family != PF_INET6)
+			ret = -ENOTSUPP;
+		else if (sk->sk_protocol != IPPROTO_TCP)
+			ret = -ENOTSUPP;
+		else if (sk->sk_state != TCP_CLOSE)
+			ret = -EBUSY;
+		else if (val < 0 || val > 1)
+			ret = -EINVAL;
+		else
+			sock_valbool_flag(sk, SOCK_ZEROCOPY, valbool);
+		break;
+
+	case SO_SPLICE:
+		if (val >= 0)
+			ret = sock_splice_attach(sk, val);
+		else
+			ret = sock_splice_detach(sk);
+		break;
+
 	default:
 		ret = -ENOPROTOOPT;
 		break;
@@ -1021,6 +1254,7 @@ int sock_getsockopt(struct socket *sock, int level, int optname,
 
 	union {
 		int val;
+		u64 val64;
 		struct linger ling;
 		struct timeval tm;
 	} v;
@@ -1251,6 +1485,23 @@ int sock_getsockopt(struct socket *sock, int level, int optname,
 		v.val = sk->sk_incoming_cpu;
 		break;
 
+	case SO_ZEROCOPY:
+		v.val = sock_flag(sk, SOCK_ZEROCOPY);
+		break;
+
+	case SO_SPLICE:
+		lv = sizeof(u64);
+		v.val64 = 0;
+		read_lock_bh(&sk->sk_callback_lock);
+		if (sk->sk_data_ready == sock_splice_data_ready) {
+			struct sock_splice *sp = sk->sk_user_data;
+
+			if (sp)
+				v.val64 = sp->bytes;
+		}
+		read_unlock_bh(&sk->sk_callback_lock);
+		break;
+
 	default:
 		/* We implement the SO_SNDLOWAT etc to not be settable
 		 * (1003.1g 7).
@@ -1734,6 +1985,34 @@ struct sk_buff *sock_wmalloc(struct sock *sk, unsigned long size, int force,
 }
 EXPORT_SYMBOL(sock_wmalloc);
 
+static void sock_ofree(struct sk_buff *skb)
+{
+	struct sock *sk = skb->sk;
+
+	atomic_sub(skb->truesize, &sk->sk_omem_alloc);
+}
+
+struct sk_buff *sock_omalloc(struct sock *sk, unsigned long size,
+			     gfp_t priority)
+{
+	struct sk_buff *skb;
+
+	/* small safe race: SKB_TRUESIZE may differ from final skb->truesize */
+	if (atomic_read(&sk->sk_omem_alloc) + SKB_TRUESIZE(size) >
+	    sysctl_optmem_max)
+		return NULL;
+
+	skb = alloc_skb(size, priority);
+	if (!skb)
+		return NULL;
+
+	atomic_add(skb->truesize, &sk->sk_omem_alloc);
+	skb->sk = sk;
+	skb->destructor = sock_ofree;
+	return skb;
+}
+EXPORT_SYMBOL(sock_omalloc);
+
 /*
  * Allocate a memory block from the socket's option memory buffer.
  */
@@ -2392,6 +2671,7 @@ void sock_init_data(struct socket *sock, struct sock *sk)
 	sk->sk_sndtimeo		=	MAX_SCHEDULE_TIMEOUT;
 
 	sk->sk_stamp = ktime_set(-1L, 0);
+	atomic_set(&sk->sk_zckey, 0);
 
 #ifdef CONFIG_NET_RX_BUSY_POLL
 	sk->sk_napi_id		=	0;
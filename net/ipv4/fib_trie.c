@@ -141,8 +141,31 @@ struct trie_stat {
 	unsigned int nodesizes[MAX_STAT_DEPTH];
 };
 
+/* fib_flat: optional flat index in front of the trie, enabled through the
+ * fib_flat_index sysctl.  It maps the top 24 bits of the destination to
+ * the leaf an LPM walk would settle on, so the common lookup is two
+ * dependent loads plus the usual semantic check instead of a trie walk.
+ *
+ * A /24 granule is only cacheable while no prefix longer than /24
+ * intersects it; such granules carry a bit in @deep and always take the
+ * trie walk.  Slots are filled lazily from lookups and invalidated on
+ * route changes; @gen is made odd for the duration of a change so that
+ * walks racing with it never install a stale leaf.
+ */
+struct fib_flat_l2 {
+	DECLARE_BITMAP(deep, 256);
+	struct key_vector __rcu *slots[256];
+};
+
+struct fib_flat {
+	spinlock_t lock;	/* serializes fills against invalidation */
+	unsigned int gen;	/* odd while the trie is being changed */
+	struct fib_flat_l2 __rcu *l2[1 << 16];
+};
+
 struct trie {
 	struct key_vector kv[1];
+	struct fib_flat __rcu *flat;
 #ifdef CONFIG_IP_FIB_TRIE_STATS
 	struct trie_use_stats __percpu *stats;
 #endif
@@ -1109,6 +1132,8 @@ int fib_table_insert(struct fib_table *tb, struct fib_config *cfg)
 	fa = l ? fib_find_alias(&l->leaf, slen, tos, fi->fib_priority,
 				tb->tb_id) : NULL;
 
+	fib_flat_inval_begin(t);
+
 	/* Now fa, if non-NULL, points to the first fib alias
 	 * with the same keys [prefix,tos,priority], if such key already
 	 * exists or to the node before which we will insert new one.
@@ -1244,6 +1269,7 @@ int fib_table_insert(struct fib_table *tb, struct fib_config *cfg)
 	rtmsg_fib(RTM_NEWROUTE, htonl(key), new_fa, plen, new_fa->tb_id,
 		  &cfg->fc_nlinfo, nlflags);
 succeeded:
+	fib_flat_inval_end(t, key, plen);
 	return 0;
 
 out_sw_fib_del:
@@ -1251,6 +1277,7 @@ out_sw_fib_del:
 out_free_new_fa:
 	kmem_cache_free(fn_alias_kmem, new_fa);
 out:
+	fib_flat_inval_end(t, key, plen);
 	fib_release_info(fi);
 err:
 	return err;
@@ -1263,6 +1290,249 @@ static inline t_key prefix_mismatch(t_key key, struct key_vector *n)
 	return (key ^ prefix) & (prefix | -prefix);
 }
 
+/* Process the aliases of leaf @n against @key/@flp.  Returns the route
+ * error (>= 0 on success) if an alias matched, -EAGAIN if the caller
+ * has to keep looking at shorter prefixes.
+ */
+static int fib_leaf_match(struct trie *t, struct fib_table *tb,
+			  struct key_vector *n, t_key key,
+			  const struct flowi4 *flp, struct fib_result *res,
+			  int fib_flags)
+{
+#ifdef CONFIG_IP_FIB_TRIE_STATS
+	struct trie_use_stats __percpu *stats = t->stats;
+#endif
+	/* this carries forward the xor from the walk */
+	unsigned long index = key ^ n->key;
+	struct fib_alias *fa;
+
+	hlist_for_each_entry_rcu(fa, &n->leaf, fa_list) {
+		struct fib_info *fi = fa->fa_info;
+		int nhsel, err;
+
+		if ((BITS_PER_LONG > KEYLENGTH) || (fa->fa_slen < KEYLENGTH)) {
+			if (index >= (1ul << fa->fa_slen))
+				continue;
+		}
+		if (fa->fa_tos && fa->fa_tos != flp->flowi4_tos)
+			continue;
+		if (fi->fib_dead)
+			continue;
+		if (fa->fa_info->fib_scope < flp->flowi4_scope)
+			continue;
+		fib_alias_accessed(fa);
+		err = fib_props[fa->fa_type].error;
+		if (unlikely(err < 0)) {
+#ifdef CONFIG_IP_FIB_TRIE_STATS
+			this_cpu_inc(stats->semantic_match_passed);
+#endif
+			return err;
+		}
+		if (fi->fib_flags & RTNH_F_DEAD)
+			continue;
+		for (nhsel = 0; nhsel < fi->fib_nhs; nhsel++) {
+			const struct fib_nh *nh = &fi->fib_nh[nhsel];
+			struct in_device *in_dev = __in_dev_get_rcu(nh->nh_dev);
+
+			if (nh->nh_flags & RTNH_F_DEAD)
+				continue;
+			if (in_dev &&
+			    IN_DEV_IGNORE_ROUTES_WITH_LINKDOWN(in_dev) &&
+			    nh->nh_flags & RTNH_F_LINKDOWN &&
+			    !(fib_flags & FIB_LOOKUP_IGNORE_LINKSTATE))
+				continue;
+			if (!(flp->flowi4_flags & FLOWI_FLAG_SKIP_NH_OIF)) {
+				if (flp->flowi4_oif &&
+				    flp->flowi4_oif != nh->nh_oif)
+					continue;
+			}
+
+			if (!(fib_flags & FIB_LOOKUP_NOREF))
+				atomic_inc(&fi->fib_clntref);
+
+			res->prefixlen = KEYLENGTH - fa->fa_slen;
+			res->nh_sel = nhsel;
+			res->type = fa->fa_type;
+			res->scope = fi->fib_scope;
+			res->fi = fi;
+			res->table = tb;
+			res->fa_head = &n->leaf;
+#ifdef CONFIG_IP_FIB_TRIE_STATS
+			this_cpu_inc(stats->semantic_match_passed);
+#endif
+			trace_fib_table_lookup_nh(nh);
+
+			return err;
+		}
+	}
+#ifdef CONFIG_IP_FIB_TRIE_STATS
+	this_cpu_inc(stats->semantic_match_miss);
+#endif
+	return -EAGAIN;
+}
+
+/* Flat index fast path.  Returns -EAGAIN when the caller must fall back
+ * to the trie walk; *fill tells it whether the walk should seed the slot
+ * it resolves.
+ */
+static int fib_flat_lookup(struct trie *t, struct fib_table *tb,
+			   struct fib_flat *flat, t_key key,
+			   const struct flowi4 *flp, struct fib_result *res,
+			   int fib_flags, unsigned int *gen, bool *fill)
+{
+	struct fib_flat_l2 *l2;
+	struct key_vector *l;
+
+	/* Pairs with the release in fib_flat_inval_end(); a walk that
+	 * sees the post-change generation also sees the changed trie.
+	 */
+	*gen = smp_load_acquire(&flat->gen);
+
+	l2 = rcu_dereference(flat->l2[key >> 16]);
+	if (l2) {
+		if (test_bit((key >> 8) & 0xff, l2->deep))
+			return -EAGAIN;
+		l = rcu_dereference(l2->slots[(key >> 8) & 0xff]);
+		if (l)
+			return fib_leaf_match(t, tb, l, key, flp, res,
+					      fib_flags);
+	}
+	*fill = !(*gen & 1);
+	return -EAGAIN;
+}
+
+/* Remember leaf @l as the LPM leaf for @key's /24.  Nothing is installed
+ * if a route change began or completed since @gen was sampled, or if the
+ * granule went deep in the meantime.
+ */
+static void fib_flat_fill(struct fib_flat *flat, t_key key,
+			  struct key_vector *l, unsigned int gen)
+{
+	struct fib_flat_l2 *l2, *new_l2 = NULL;
+	unsigned long s1 = key >> 16;
+	unsigned int s2 = (key >> 8) & 0xff;
+
+	if (!rcu_access_pointer(flat->l2[s1])) {
+		new_l2 = kzalloc(sizeof(*new_l2), GFP_ATOMIC);
+		if (!new_l2)
+			return;
+	}
+
+	spin_lock_bh(&flat->lock);
+	if (flat->gen != gen)
+		goto out;
+	l2 = rcu_dereference_protected(flat->l2[s1],
+				       lockdep_is_held(&flat->lock));
+	if (!l2) {
+		if (!new_l2)
+			goto out;
+		rcu_assign_pointer(flat->l2[s1], new_l2);
+		l2 = new_l2;
+		new_l2 = NULL;
+	}
+	if (!test_bit(s2, l2->deep))
+		rcu_assign_pointer(l2->slots[s2], l);
+out:
+	spin_unlock_bh(&flat->lock);
+	kfree(new_l2);
+}
+
+/* Detach and free the index.  Caller holds RTNL; the generation must
+ * already be odd (or the index unreachable) so no fill can install a
+ * slot while we wait out the readers.
+ */
+static void fib_flat_free(struct trie *t, struct fib_flat *flat)
+{
+	unsigned long i;
+
+	RCU_INIT_POINTER(t->flat, NULL);
+	synchronize_rcu();
+
+	for (i = 0; i < ARRAY_SIZE(flat->l2); i++)
+		kfree(rcu_dereference_protected(flat->l2[i], 1));
+	vfree(flat);
+}
+
+/* Route change protocol: _begin makes the generation odd before the trie
+ * is touched, which stops lazy fills; _end drops every slot the changed
+ * prefix covers and makes the generation even again.  Both run under
+ * RTNL, nested between them is the actual trie update.
+ */
+static void fib_flat_inval_begin(struct trie *t)
+{
+	struct fib_flat *flat = rtnl_dereference(t->flat);
+
+	if (!flat)
+		return;
+
+	spin_lock_bh(&flat->lock);
+	flat->gen++;
+	spin_unlock_bh(&flat->lock);
+}
+
+static void fib_flat_inval_end(struct trie *t, t_key key, u8 plen)
+{
+	struct fib_flat *flat = rtnl_dereference(t->flat);
+	struct fib_flat_l2 *l2, *new_l2 = NULL;
+	unsigned long s1, last;
+	unsigned int s2;
+
+	if (!flat)
+		return;
+
+	if (plen > 24 && !rtnl_dereference(flat->l2[key >> 16]))
+		new_l2 = kzalloc(sizeof(*new_l2), GFP_KERNEL);
+
+	spin_lock_bh(&flat->lock);
+
+	if (plen > 24) {
+		/* The granule is no longer uniform; pin it to the walk. */
+		s1 = key >> 16;
+		l2 = rcu_dereference_protected(flat->l2[s1],
+					       lockdep_is_held(&flat->lock));
+		if (!l2 && new_l2) {
+			rcu_assign_pointer(flat->l2[s1], new_l2);
+			l2 = new_l2;
+			new_l2 = NULL;
+		}
+		if (!l2) {
+			/* Cannot record the deep granule; drop the whole
+			 * index rather than risk serving it stale.  The
+			 * generation is still odd, so no fill can sneak
+			 * in before the readers are flushed.
+			 */
+			spin_unlock_bh(&flat->lock);
+			fib_flat_free(t, flat);
+			return;
+		}
+		set_bit((key >> 8) & 0xff, l2->deep);
+		RCU_INIT_POINTER(l2->slots[(key >> 8) & 0xff], NULL);
+	} else if (plen > 16) {
+		l2 = rcu_dereference_protected(flat->l2[key >> 16],
+					       lockdep_is_held(&flat->lock));
+		if (l2) {
+			s2 = (key >> 8) & 0xff;
+			last = s2 + (1ul << (24 - plen));
+			for (; s2 < last; s2++)
+				RCU_INIT_POINTER(l2->slots[s2], NULL);
+		}
+	} else {
+		last = (key >> 16) + (1ul << (16 - plen));
+		for (s1 = key >> 16; s1 < last; s1++) {
+			l2 = rcu_dereference_protected(flat->l2[s1],
+					lockdep_is_held(&flat->lock));
+			if (!l2)
+				continue;
+			for (s2 = 0; s2 < 256; s2++)
+				RCU_INIT_POINTER(l2->slots[s2], NULL);
+		}
+	}
+
+	smp_store_release(&flat->gen, flat->gen + 1);
+	spin_unlock_bh(&flat->lock);
+	kfree(new_l2);
+}
+
 /* should be called with rcu_read_lock */
 int fib_table_lookup(struct fib_table *tb, const struct flowi4 *flp,
 		     struct fib_result *res, int fib_flags)
@@ -1273,12 +1543,23 @@ int fib_table_lookup(struct fib_table *tb, const struct flowi4 *flp,
 #endif
 	const t_key key = ntohl(flp->daddr);
 	struct key_vector *n, *pn;
-	struct fib_alias *fa;
+	unsigned int flat_gen = 0;
+	bool flat_fill = false;
+	struct fib_flat *flat;
 	unsigned long index;
 	t_key cindex;
+	int err;
 
 	trace_fib_table_lookup(tb->tb_id, flp);
 
+	flat = rcu_dereference(t->flat);
+	if (flat) {
+		err = fib_flat_lookup(t, tb, flat, key, flp, res, fib_flags,
+				      &flat_gen, &flat_fill);
+		if (err != -EAGAIN)
+			return err;
+	}
+
 	pn = t->kv;
 	cindex = 0;
 
@@ -1386,72 +1667,20 @@ backtrace:
 	}
 
 found:
-	/* this line carries forward the xor from earlier in the function */
-	index = key ^ n->key;
+	/* The first leaf the walk settles on is the LPM leaf for every
+	 * address in this /24 (granules with deeper prefixes never get
+	 * here with flat_fill set), so it can seed the flat index even
+	 * if this particular lookup fails the semantic check.
+	 */
+	if (unlikely(flat_fill)) {
+		fib_flat_fill(flat, key, n, flat_gen);
+		flat_fill = false;
+	}
 
 	/* Step 3: Process the leaf, if that fails fall back to backtracing */
-	hlist_for_each_entry_rcu(fa, &n->leaf, fa_list) {
-		struct fib_info *fi = fa->fa_info;
-		int nhsel, err;
-
-		if ((BITS_PER_LONG > KEYLENGTH) || (fa->fa_slen < KEYLENGTH)) {
-			if (index >= (1ul << fa->fa_slen))
-				continue;
-		}
-		if (fa->fa_tos && fa->fa_tos != flp->flowi4_tos)
-			continue;
-		if (fi->fib_dead)
-			continue;
-		if (fa->fa_info->fib_scope < flp->flowi4_scope)
-			continue;
-		fib_alias_accessed(fa);
-		err = fib_props[fa->fa_type].error;
-		if (unlikely(err < 0)) {
-#ifdef CONFIG_IP_FIB_TRIE_STATS
-			this_cpu_inc(stats->semantic_match_passed);
-#endif
-			return err;
-		}
-		if (fi->fib_flags & RTNH_F_DEAD)
-			continue;
-		for (nhsel = 0; nhsel < fi->fib_nhs; nhsel++) {
-			const struct fib_nh *nh = &fi->fib_nh[nhsel];
-			struct in_device *in_dev = __in_dev_get_rcu(nh->nh_dev);
-
-			if (nh->nh_flags & RTNH_F_DEAD)
-				continue;
-			if (in_dev &&
-			    IN_DEV_IGNORE_ROUTES_WITH_LINKDOWN(in_dev) &&
-			    nh->nh_flags & RTNH_F_LINKDOWN &&
-			    !(fib_flags & FIB_LOOKUP_IGNORE_LINKSTATE))
-				continue;
-			if (!(flp->flowi4_flags & FLOWI_FLAG_SKIP_NH_OIF)) {
-				if (flp->flowi4_oif &&
-				    flp->flowi4_oif != nh->nh_oif)
-					continue;
-			}
-
-			if (!(fib_flags & FIB_LOOKUP_NOREF))
-				atomic_inc(&fi->fib_clntref);
-
-			res->prefixlen = KEYLENGTH - fa->fa_slen;
-			res->nh_sel = nhsel;
-			res->type = fa->fa_type;
-			res->scope = fi->fib_scope;
-			res->fi = fi;
-			res->table = tb;
-			res->fa_head = &n->leaf;
-#ifdef CONFIG_IP_FIB_TRIE_STATS
-			this_cpu_inc(stats->semantic_match_passed);
-#endif
-			trace_fib_table_lookup_nh(nh);
-
-			return err;
-		}
-	}
-#ifdef CONFIG_IP_FIB_TRIE_STATS
-	this_cpu_inc(stats->semantic_match_miss);
-#endif
+	err = fib_leaf_match(t, tb, n, key, flp, res, fib_flags);
+	if (err != -EAGAIN)
+		return err;
 	goto backtrace;
 }
 EXPORT_SYMBOL_GPL(fib_table_lookup);
@@ -1548,7 +1777,9 @@ int fib_table_delete(struct fib_table *tb, struct fib_config *cfg)
 	if (!plen)
 		tb->tb_num_default--;
 
+	fib_flat_inval_begin(t);
 	fib_remove_alias(t, tp, l, fa_to_delete);
+	fib_flat_inval_end(t, key, plen);
 
 	if (fa_to_delete->fa_state & FA_S_ACCESSED)
 		rt_cache_flush(cfg->fc_nlinfo.nl_net);
@@ -1739,6 +1970,8 @@ void fib_table_flush_external(struct fib_table *tb)
 	struct hlist_node *tmp;
 	struct fib_alias *fa;
 
+	fib_flat_inval_begin(t);
+
 	/* walk trie in reverse order */
 	for (;;) {
 		unsigned char slen = 0;
@@ -1802,6 +2035,8 @@ void fib_table_flush_external(struct fib_table *tb)
 			node_free(n);
 		}
 	}
+
+	fib_flat_inval_end(t, 0, 0);
 }
 
 /* Caller must hold RTNL. */
@@ -1814,6 +2049,8 @@ int fib_table_flush(struct fib_table *tb)
 	struct fib_alias *fa;
 	int found = 0;
 
+	fib_flat_inval_begin(t);
+
 	/* walk trie in reverse order */
 	for (;;) {
 		unsigned char slen = 0;
@@ -1872,10 +2109,90 @@ int fib_table_flush(struct fib_table *tb)
 		}
 	}
 
+	fib_flat_inval_end(t, 0, 0);
+
 	pr_debug("trie_flush found=%d\n", found);
 	return found;
 }
 
+/* Build a flat index for @tb and put it in front of the trie.
+ * Caller must hold RTNL.
+ */
+int fib_table_flat_enable(struct fib_table *tb)
+{
+	struct trie *t = (struct trie *)tb->tb_data;
+	struct key_vector *l, *tp;
+	struct fib_flat *flat;
+	t_key key = 0;
+
+	if (rtnl_dereference(t->flat))
+		return 0;
+
+	flat = vzalloc(sizeof(*flat));
+	if (!flat)
+		return -ENOMEM;
+	spin_lock_init(&flat->lock);
+
+	/* Record every /24 granule that contains a longer prefix before
+	 * the index goes live; those must always take the trie walk.
+	 * Leaf aliases are sorted longest prefix first, so only the head
+	 * of each list needs looking at.
+	 */
+	tp = t->kv;
+	while ((l = leaf_walk_rcu(&tp, key)) != NULL) {
+		struct fib_alias *fa;
+
+		hlist_for_each_entry(fa, &l->leaf, fa_list) {
+			struct fib_flat_l2 *l2;
+			unsigned long s1;
+
+			if (fa->fa_slen >= KEYLENGTH - 24)
+				break;
+
+			s1 = l->key >> 16;
+			l2 = rtnl_dereference(flat->l2[s1]);
+			if (!l2) {
+				l2 = kzalloc(sizeof(*l2), GFP_KERNEL);
+				if (!l2)
+					goto fail;
+				rcu_assign_pointer(flat->l2[s1], l2);
+			}
+			set_bit((l->key >> 8) & 0xff, l2->deep);
+			break;
+		}
+
+		/* stop loop if key wrapped back to 0 */
+		key = l->key + 1;
+		if (key < l->key)
+			break;
+	}
+
+	rcu_assign_pointer(t->flat, flat);
+	return 0;
+
+fail:
+	for (key = 0; key < ARRAY_SIZE(flat->l2); key++)
+		kfree(rtnl_dereference(flat->l2[key]));
+	vfree(flat);
+	return -ENOMEM;
+}
+
+/* Caller must hold RTNL. */
+void fib_table_flat_disable(struct fib_table *tb)
+{
+	struct trie *t = (struct trie *)tb->tb_data;
+	struct fib_flat *flat = rtnl_dereference(t->flat);
+
+	if (!flat)
+		return;
+
+	spin_lock_bh(&flat->lock);
+	flat->gen++;		/* odd: no further fills */
+	spin_unlock_bh(&flat->lock);
+
+	fib_flat_free(t, flat);
+}
+
 static void __trie_free_rcu(struct rcu_head *head)
 {
 	struct fib_table *tb = container_of(head, struct fib_table, rcu);
@@ -1890,6 +2207,12 @@ static void __trie_free_rcu(struct rcu_head *head)
 
 void fib_free_table(struct fib_table *tb)
 {
+	struct trie *t = (struct trie *)tb->tb_data;
+	struct fib_flat *flat = rcu_dereference_protected(t->flat, 1);
+
+	if (tb->tb_data == tb->__data && flat)
+		fib_flat_free(t, flat);
+
 	call_rcu(&tb->rcu, __trie_free_rcu);
 }
 
@@ -812,8 +812,16 @@ struct sock *inet_csk_complete_hashdance(struct sock *sk, struct sock *child,
 					 struct request_sock *req, bool own_req)
 {
 	if (own_req) {
-		inet_csk_reqsk_queue_drop(sk, req);
-		reqsk_queue_removed(&inet_csk(sk)->icsk_accept_queue, req);
+		/* The request may have been migrated off a closing listener,
+		 * in which case @sk differs from req->rsk_listener.  Queue
+		 * accounting always goes to the original listener, while the
+		 * child is delivered to the listener that completed the
+		 * handshake.  The request keeps its reference on the original
+		 * listener until it is freed.
+		 */
+		inet_csk_reqsk_queue_drop(req->rsk_listener, req);
+		reqsk_queue_removed(&inet_csk(req->rsk_listener)->icsk_accept_queue,
+				    req);
 		if (inet_csk_reqsk_queue_add(sk, req, child))
 			return child;
 	}
@@ -86,6 +86,11 @@ int ip_forward(struct sk_buff *skb)
 	if (skb->pkt_type != PACKET_HOST)
 		goto drop;
 
+	/* A stale RX timestamp must not be mistaken for a departure time
+	 * by an EDT aware qdisc (eg sch_fq) on the output path.
+	 */
+	skb->tstamp.tv64 = 0;
+
 	if (unlikely(skb->sk))
 		goto drop;
 
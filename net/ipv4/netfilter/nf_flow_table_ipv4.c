@@ -0,0 +1,390 @@
+/* IPv4 datapath for the flow offload table.
+ *
+ * Loading this module short-circuits established, policy-resolved
+ * connections: a forward hook running after all other verdicts offloads
+ * eligible conntracks into the per-namespace flow table, and an early
+ * prerouting hook forwards packets of offloaded flows directly to the
+ * cached output route with the recorded NAT applied, never entering the
+ * remaining hook chains.
+ */
+#include <linux/kernel.h>
+#include <linux/init.h>
+#include <linux/module.h>
+#include <linux/netfilter.h>
+#include <linux/netfilter_ipv4.h>
+#include <linux/netdevice.h>
+#include <linux/ip.h>
+#include <linux/tcp.h>
+#include <linux/udp.h>
+#include <net/ip.h>
+#include <net/checksum.h>
+#include <net/route.h>
+#include <net/neighbour.h>
+#include <net/netns/generic.h>
+#include <net/netfilter/nf_flow_table.h>
+#include <net/netfilter/nf_conntrack.h>
+#include <net/netfilter/nf_conntrack_core.h>
+#include <net/netfilter/nf_conntrack_helper.h>
+#include <net/netfilter/nf_conntrack_zones.h>
+
+static int nf_flow_table_net_id __read_mostly;
+
+struct nf_flow_table_net {
+	struct nf_flowtable	flowtable;
+};
+
+/* Rewrite one address/port pair in place, fixing up the IPv4 and
+ * transport checksums incrementally.
+ */
+static void nf_flow_nat_ip_part(struct sk_buff *skb, struct iphdr *iph,
+				unsigned int thoff,
+				__be32 *addr, __be32 new_addr,
+				__be16 *port, __be16 new_port)
+{
+	__be32 old_addr = *addr;
+	__be16 old_port = *port;
+
+	csum_replace4(&iph->check, old_addr, new_addr);
+
+	switch (iph->protocol) {
+	case IPPROTO_TCP: {
+		struct tcphdr *tcph;
+
+		tcph = (void *)(skb_network_header(skb) + thoff);
+		inet_proto_csum_replace4(&tcph->check, skb, old_addr,
+					 new_addr, true);
+		if (old_port != new_port)
+			inet_proto_csum_replace2(&tcph->check, skb, old_port,
+						 new_port, false);
+		break;
+	}
+	case IPPROTO_UDP: {
+		struct udphdr *udph;
+
+		udph = (void *)(skb_network_header(skb) + thoff);
+		if (udph->check || skb->ip_summed == CHECKSUM_PARTIAL) {
+			inet_proto_csum_replace4(&udph->check, skb, old_addr,
+						 new_addr, true);
+			if (old_port != new_port)
+				inet_proto_csum_replace2(&udph->check, skb,
+							 old_port, new_port,
+							 false);
+			if (!udph->check)
+				udph->check = CSUM_MANGLED_0;
+		}
+		break;
+	}
+	}
+
+	*addr = new_addr;
+	*port = new_port;
+}
+
+static void nf_flow_nat_ip(const struct flow_offload *flow,
+			   struct sk_buff *skb,
+			   enum flow_offload_tuple_dir dir)
+{
+	const struct flow_offload_tuple *orig, *reply;
+	struct iphdr *iph = ip_hdr(skb);
+	unsigned int thoff = iph->ihl * 4;
+	__be16 *ports = (__be16 *)(skb_network_header(skb) + thoff);
+
+	orig = &flow->tuplehash[FLOW_OFFLOAD_DIR_ORIGINAL].tuple;
+	reply = &flow->tuplehash[FLOW_OFFLOAD_DIR_REPLY].tuple;
+
+	if (flow->flags & FLOW_OFFLOAD_SNAT) {
+		if (dir == FLOW_OFFLOAD_DIR_ORIGINAL)
+			nf_flow_nat_ip_part(skb, iph, thoff,
+					    &iph->saddr, reply->dst_addr,
+					    &ports[0], reply->dst_port);
+		else
+			nf_flow_nat_ip_part(skb, iph, thoff,
+					    &iph->daddr, orig->src_addr,
+					    &ports[1], orig->src_port);
+	}
+	if (flow->flags & FLOW_OFFLOAD_DNAT) {
+		if (dir == FLOW_OFFLOAD_DIR_ORIGINAL)
+			nf_flow_nat_ip_part(skb, iph, thoff,
+					    &iph->daddr, reply->src_addr,
+					    &ports[1], reply->src_port);
+		else
+			nf_flow_nat_ip_part(skb, iph, thoff,
+					    &iph->saddr, orig->dst_addr,
+					    &ports[0], orig->dst_port);
+	}
+}
+
+static unsigned int
+nf_flow_offload_ip_hook(void *priv, struct sk_buff *skb,
+			const struct nf_hook_state *state)
+{
+	struct nf_flow_table_net *fn;
+	struct flow_offload_tuple_rhash *tuplehash;
+	struct flow_offload_tuple tuple = {};
+	enum flow_offload_tuple_dir dir;
+	struct flow_offload *flow;
+	const struct iphdr *iph;
+	const __be16 *ports;
+	unsigned int thoff;
+	struct rtable *rt;
+	__be32 nexthop;
+
+	if (skb->protocol != htons(ETH_P_IP))
+		return NF_ACCEPT;
+
+	if (!pskb_may_pull(skb, sizeof(*iph)))
+		return NF_ACCEPT;
+
+	iph = ip_hdr(skb);
+	/* Options and fragments want the full slow path. */
+	if (iph->ihl > 5 || ip_is_fragment(iph))
+		return NF_ACCEPT;
+
+	thoff = iph->ihl * 4;
+	switch (iph->protocol) {
+	case IPPROTO_TCP:
+		if (!pskb_may_pull(skb, thoff + sizeof(struct tcphdr)))
+			return NF_ACCEPT;
+		break;
+	case IPPROTO_UDP:
+		if (!pskb_may_pull(skb, thoff + sizeof(struct udphdr)))
+			return NF_ACCEPT;
+		break;
+	default:
+		return NF_ACCEPT;
+	}
+
+	iph = ip_hdr(skb);
+	ports = (const __be16 *)(skb_network_header(skb) + thoff);
+	tuple.src_addr = iph->saddr;
+	tuple.dst_addr = iph->daddr;
+	tuple.src_port = ports[0];
+	tuple.dst_port = ports[1];
+	tuple.l4proto = iph->protocol;
+
+	fn = net_generic(state->net, nf_flow_table_net_id);
+	tuplehash = flow_offload_lookup(&fn->flowtable, &tuple);
+	if (!tuplehash)
+		return NF_ACCEPT;
+
+	dir = tuplehash->tuple.dir;
+	flow = container_of(tuplehash, struct flow_offload, tuplehash[dir]);
+
+	if ((flow->flags & FLOW_OFFLOAD_TEARDOWN) ||
+	    nf_ct_is_dying(flow->ct))
+		return NF_ACCEPT;
+
+	/* Leave oversized packets and expiring TTLs to the stack so the
+	 * proper ICMP errors are generated.
+	 */
+	if (unlikely(skb->len > tuplehash->tuple.mtu) || iph->ttl <= 1)
+		return NF_ACCEPT;
+
+	rt = (struct rtable *)tuplehash->tuple.dst_cache;
+	if (!dst_check(&rt->dst, 0)) {
+		flow_offload_teardown(flow);
+		return NF_ACCEPT;
+	}
+
+	if (iph->protocol == IPPROTO_TCP) {
+		const struct tcphdr *tcph;
+
+		tcph = (void *)(skb_network_header(skb) + thoff);
+		/* Hand connection teardown back to conntrack. */
+		if (unlikely(tcph->fin || tcph->rst)) {
+			flow_offload_teardown(flow);
+			return NF_ACCEPT;
+		}
+	}
+
+	if (!skb_make_writable(skb, thoff + (iph->protocol == IPPROTO_TCP ?
+					     sizeof(struct tcphdr) :
+					     sizeof(struct udphdr))))
+		return NF_DROP;
+
+	if (flow->flags & (FLOW_OFFLOAD_SNAT | FLOW_OFFLOAD_DNAT))
+		nf_flow_nat_ip(flow, skb, dir);
+
+	flow->timeout = jiffies + NF_FLOW_TIMEOUT;
+	ip_decrease_ttl(ip_hdr(skb));
+
+	skb->dev = rt->dst.dev;
+	skb_dst_set_noref(skb, &rt->dst);
+	nexthop = rt_nexthop(rt, flow->tuplehash[!dir].tuple.src_addr);
+	neigh_xmit(NEIGH_ARP_TABLE, rt->dst.dev, &nexthop, skb);
+
+	return NF_STOLEN;
+}
+
+/* Route for the direction opposite to @dir: those packets head towards
+ * the pre-translation source of @dir, typically back out of the device
+ * this packet arrived on.
+ */
+static int nf_flow_offload_route(struct net *net, const struct sk_buff *skb,
+				 struct nf_conn *ct,
+				 enum ip_conntrack_dir dir,
+				 const struct nf_hook_state *state,
+				 struct nf_flow_route *route)
+{
+	struct flowi4 fl4 = {};
+	struct rtable *rt;
+
+	/* This packet's own direction already carries a resolved route. */
+	route->tuple[dir].dst = skb_dst(skb);
+	dst_hold(route->tuple[dir].dst);
+
+	fl4.daddr = ct->tuplehash[dir].tuple.src.u3.ip;
+	fl4.flowi4_oif = state->in->ifindex;
+	rt = ip_route_output_key(net, &fl4);
+	if (IS_ERR(rt)) {
+		dst_release(route->tuple[dir].dst);
+		return -EHOSTUNREACH;
+	}
+	route->tuple[!dir].dst = &rt->dst;
+
+	return 0;
+}
+
+static unsigned int
+nf_flow_offload_forward_hook(void *priv, struct sk_buff *skb,
+			     const struct nf_hook_state *state)
+{
+	struct nf_flow_table_net *fn;
+	enum ip_conntrack_info ctinfo;
+	struct nf_flow_route route;
+	struct flow_offload *flow;
+	enum ip_conntrack_dir dir;
+	struct nf_conn *ct;
+
+	ct = nf_ct_get(skb, &ctinfo);
+	if (!ct || nf_ct_is_untracked(ct))
+		return NF_ACCEPT;
+
+	switch (nf_ct_protonum(ct)) {
+	case IPPROTO_TCP:
+		if (ct->proto.tcp.state != TCP_CONNTRACK_ESTABLISHED)
+			return NF_ACCEPT;
+		break;
+	case IPPROTO_UDP:
+		break;
+	default:
+		return NF_ACCEPT;
+	}
+
+	/* Only bidirectionally confirmed flows with nothing left to look
+	 * at each packet: helpers and sequence adjustment need to keep
+	 * seeing the stream, and zones are not encoded in the flow key.
+	 */
+	if (!nf_ct_is_confirmed(ct) ||
+	    !test_bit(IPS_ASSURED_BIT, &ct->status) ||
+	    test_bit(IPS_SEQ_ADJUST_BIT, &ct->status) ||
+	    nfct_help(ct) ||
+	    nf_ct_zone_id(nf_ct_zone(ct), IP_CT_DIR_ORIGINAL) !=
+						NF_CT_DEFAULT_ZONE_ID)
+		return NF_ACCEPT;
+
+	if (test_and_set_bit(IPS_OFFLOAD_BIT, &ct->status))
+		return NF_ACCEPT;
+
+	dir = CTINFO2DIR(ctinfo);
+	if (nf_flow_offload_route(state->net, skb, ct, dir, state,
+				  &route) < 0)
+		goto err_flag;
+
+	flow = flow_offload_alloc(ct, &route);
+	if (!flow)
+		goto err_route;
+
+	if (nf_ct_protonum(ct) == IPPROTO_TCP) {
+		/* Window tracking goes stale once packets stop passing
+		 * through conntrack.
+		 */
+		ct->proto.tcp.seen[0].flags |= IP_CT_TCP_FLAG_BE_LIBERAL;
+		ct->proto.tcp.seen[1].flags |= IP_CT_TCP_FLAG_BE_LIBERAL;
+	}
+
+	fn = net_generic(state->net, nf_flow_table_net_id);
+	if (flow_offload_add(&fn->flowtable, flow) < 0) {
+		/* Drops the conntrack and route references and clears
+		 * IPS_OFFLOAD for us.
+		 */
+		flow_offload_free(flow);
+		return NF_ACCEPT;
+	}
+
+	return NF_ACCEPT;
+
+err_route:
+	dst_release(route.tuple[IP_CT_DIR_ORIGINAL].dst);
+	dst_release(route.tuple[IP_CT_DIR_REPLY].dst);
+err_flag:
+	clear_bit(IPS_OFFLOAD_BIT, &ct->status);
+	return NF_ACCEPT;
+}
+
+static struct nf_hook_ops nf_flow_table_ops[] __read_mostly = {
+	{
+		/* After defrag, before conntrack: hits skip everything. */
+		.hook		= nf_flow_offload_ip_hook,
+		.pf		= NFPROTO_IPV4,
+		.hooknum	= NF_INET_PRE_ROUTING,
+		.priority	= NF_IP_PRI_CONNTRACK - 1,
+	},
+	{
+		/* Last word in the forward chain: whatever reaches us
+		 * passed every other hook's verdict.
+		 */
+		.hook		= nf_flow_offload_forward_hook,
+		.pf		= NFPROTO_IPV4,
+		.hooknum	= NF_INET_FORWARD,
+		.priority	= NF_IP_PRI_LAST,
+	},
+};
+
+static int __net_init nf_flow_table_ipv4_net_init(struct net *net)
+{
+	struct nf_flow_table_net *fn = net_generic(net, nf_flow_table_net_id);
+
+	return nf_flow_table_init(net, &fn->flowtable);
+}
+
+static void __net_exit nf_flow_table_ipv4_net_exit(struct net *net)
+{
+	struct nf_flow_table_net *fn = net_generic(net, nf_flow_table_net_id);
+
+	nf_flow_table_free(&fn->flowtable);
+}
+
+static struct pernet_operations nf_flow_table_ipv4_net_ops = {
+	.init = nf_flow_table_ipv4_net_init,
+	.exit = nf_flow_table_ipv4_net_exit,
+	.id   = &nf_flow_table_net_id,
+	.size = sizeof(struct nf_flow_table_net),
+};
+
+static int __init nf_flow_table_ipv4_init(void)
+{
+	int ret;
+
+	ret = register_pernet_subsys(&nf_flow_table_ipv4_net_ops);
+	if (ret < 0)
+		return ret;
+
+	ret = nf_register_hooks(nf_flow_table_ops,
+				ARRAY_SIZE(nf_flow_table_ops));
+	if (ret < 0)
+		unregister_pernet_subsys(&nf_flow_table_ipv4_net_ops);
+
+	return ret;
+}
+
+static void __exit nf_flow_table_ipv4_exit(void)
+{
+	nf_unregister_hooks(nf_flow_table_ops, ARRAY_SIZE(nf_flow_table_ops));
+	unregister_pernet_subsys(&nf_flow_table_ipv4_net_ops);
+}
+
+module_init(nf_flow_table_ipv4_init);
+module_exit(nf_flow_table_ipv4_exit);
+
+MODULE_LICENSE("GPL");
@@ -14,6 +14,7 @@
 #include <linux/init.h>
 #include <linux/slab.h>
 #include <linux/nsproxy.h>
+#include <linux/rtnetlink.h>
 #include <linux/swap.h>
 #include <net/snmp.h>
 #include <net/icmp.h>
@@ -151,6 +152,37 @@ static int ipv4_ping_group_range(struct ctl_table *table, int write,
 	return ret;
 }
 
+/* Attach or detach the flat lookup index on the netns main table */
+static int proc_fib_flat_index(struct ctl_table *table, int write,
+			       void __user *buffer,
+			       size_t *lenp, loff_t *ppos)
+{
+	struct net *net = container_of(table->data, struct net,
+				       ipv4.sysctl_fib_flat_index);
+	struct fib_table *tb;
+	int ret;
+
+	ret = proc_dointvec_minmax(table, write, buffer, lenp, ppos);
+	if (!write || ret)
+		return ret;
+
+	rtnl_lock();
+	tb = fib_get_table(net, RT_TABLE_MAIN);
+	if (!tb) {
+		net->ipv4.sysctl_fib_flat_index = 0;
+		ret = -ENOENT;
+	} else if (net->ipv4.sysctl_fib_flat_index) {
+		ret = fib_table_flat_enable(tb);
+		if (ret)
+			net->ipv4.sysctl_fib_flat_index = 0;
+	} else {
+		fib_table_flat_disable(tb);
+	}
+	rtnl_unlock();
+
+	return ret;
+}
+
 static int proc_tcp_congestion_control(struct ctl_table *ctl, int write,
 				       void __user *buffer, size_t *lenp, loff_t *ppos)
 {
@@ -323,6 +355,13 @@ static struct ctl_table ipv4_table[] = {
 		.mode		= 0644,
 		.proc_handler	= proc_dointvec
 	},
+	{
+		.procname	= "tcp_migrate_req",
+		.data		= &sysctl_tcp_migrate_req,
+		.maxlen		= sizeof(int),
+		.mode		= 0644,
+		.proc_handler	= proc_dointvec
+	},
 	{
 		.procname	= "tcp_stdurg",
 		.data		= &sysctl_tcp_stdurg,
@@ -787,6 +826,15 @@ static struct ctl_table ipv4_net_table[] = {
 		.mode		= 0644,
 		.proc_handler	= proc_dointvec
 	},
+	{
+		.procname	= "fib_flat_index",
+		.data		= &init_net.ipv4.sysctl_fib_flat_index,
+		.maxlen		= sizeof(int),
+		.mode		= 0644,
+		.proc_handler	= proc_fib_flat_index,
+		.extra1		= &zero,
+		.extra2		= &one,
+	},
 	{
 		.procname	= "fwmark_reflect",
 		.data		= &init_net.ipv4.sysctl_fwmark_reflect,
@@ -1534,6 +1534,44 @@ bool tcp_prequeue(struct sock *sk, struct sk_buff *skb)
 }
 EXPORT_SYMBOL(tcp_prequeue);
 
+/* Find a live listener to take over a TCP_NEW_SYN_RECV request whose
+ * original listener has left TCP_LISTEN (e.g. a process being rolled out
+ * of a SO_REUSEPORT group).  The lookup goes through reuseport_select_sock(),
+ * so an attached BPF program steers the migration target just like fresh
+ * SYNs.  Returns a referenced listener, or NULL if the request should be
+ * dropped as before.
+ */
+static struct sock *tcp_v4_migrate_req(struct sk_buff *skb,
+				       struct request_sock *req)
+{
+	const struct iphdr *iph = ip_hdr(skb);
+	const struct tcphdr *th = tcp_hdr(skb);
+	struct net *net = dev_net(skb->dev);
+	struct sock *nsk;
+
+	if (!sysctl_tcp_migrate_req)
+		return NULL;
+
+	nsk = __inet_lookup_listener(net, &tcp_hashinfo, skb, __tcp_hdrlen(th),
+				     iph->saddr, th->source,
+				     iph->daddr, ntohs(th->dest),
+				     inet_iif(skb));
+	/* Only migrate between members of a reuseport group, and never back
+	 * to the listener that is going away.
+	 */
+	if (nsk && (nsk == req->rsk_listener || nsk->sk_state != TCP_LISTEN ||
+		    !rcu_access_pointer(nsk->sk_reuseport_cb))) {
+		sock_put(nsk);
+		nsk = NULL;
+	}
+	if (!nsk) {
+		NET_INC_STATS_BH(net, LINUX_MIB_TCPMIGRATEREQFAILURE);
+		return NULL;
+	}
+	NET_INC_STATS_BH(net, LINUX_MIB_TCPMIGRATEREQSUCCESS);
+	return nsk;
+}
+
 /*
  *	From tcp_input.c
  */
@@ -1608,10 +1646,16 @@ process:
 			goto discard_it;
 		}
 		if (unlikely(sk->sk_state != TCP_LISTEN)) {
-			inet_csk_reqsk_queue_drop_and_put(sk, req);
-			goto lookup;
+			nsk = tcp_v4_migrate_req(skb, req);
+			if (!nsk) {
+				inet_csk_reqsk_queue_drop_and_put(sk, req);
+				goto lookup;
+			}
+			/* tcp_v4_migrate_req() took a reference for us */
+			sk = nsk;
+		} else {
+			sock_hold(sk);
 		}
-		sock_hold(sk);
 		nsk = tcp_check_req(sk, skb, req, false);
 		if (!nsk) {
 			reqsk_put(req);
@@ -1802,6 +1846,8 @@ void tcp_v4_destroy_sock(struct sock *sk)
 
 	tcp_cleanup_congestion_control(sk);
 
+	tcp_cleanup_ulp(sk);
+
 	/* Cleanup up the write buffer. */
 	tcp_write_queue_purge(sk);
 
@@ -29,6 +29,9 @@
 
 int sysctl_tcp_abort_on_overflow __read_mostly;
 
+int sysctl_tcp_migrate_req __read_mostly;
+EXPORT_SYMBOL(sysctl_tcp_migrate_req);
+
 struct inet_timewait_death_row tcp_death_row = {
 	.sysctl_max_tw_buckets = NR_FILE * 2,
 	.hashinfo	= &tcp_hashinfo,
@@ -477,6 +480,7 @@ struct sock *tcp_create_openreq_child(const struct sock *sk,
 		newtp->lsndtime = treq->snt_synack.stamp_jiffies;
 		newsk->sk_txhash = treq->txhash;
 		newtp->last_oow_ack_time = 0;
+		newtp->app_limited = ~0U;
 		newtp->total_retrans = req->num_retrans;
 
 		/* So many TCP implementations out there (incorrectly) count the
@@ -787,7 +791,10 @@ embryonic_reset:
 		tcp_reset(sk);
 	}
 	if (!fastopen) {
-		inet_csk_reqsk_queue_drop(sk, req);
+		/* Drop against the listener the request was charged to; it
+		 * may no longer be @sk if the request has been migrated.
+		 */
+		inet_csk_reqsk_queue_drop(req->rsk_listener, req);
 		NET_INC_STATS_BH(sock_net(sk), LINUX_MIB_EMBRYONICRSTS);
 	}
 	return NULL;
@@ -388,6 +388,11 @@ int ip6_forward(struct sk_buff *skb)
 	if (skb->pkt_type != PACKET_HOST)
 		goto drop;
 
+	/* An RX timestamp left in the skb would be taken for a departure
+	 * time by an EDT aware qdisc (eg sch_fq) on the output path.
+	 */
+	skb->tstamp.tv64 = 0;
+
 	if (unlikely(skb->sk))
 		goto drop;
 
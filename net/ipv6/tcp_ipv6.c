@@ -1347,6 +1347,39 @@ static void tcp_v6_restore_cb(struct sk_buff *skb)
 		sizeof(struct inet6_skb_parm));
 }
 
+/* IPv6 counterpart of tcp_v4_migrate_req(): hand a TCP_NEW_SYN_RECV request
+ * whose listener has closed over to another member of the reuseport group,
+ * picked by the regular listener lookup (including any attached BPF
+ * program).  Returns a referenced listener or NULL.
+ */
+static struct sock *tcp_v6_migrate_req(struct sk_buff *skb,
+				       struct request_sock *req)
+{
+	const struct ipv6hdr *hdr = ipv6_hdr(skb);
+	const struct tcphdr *th = tcp_hdr(skb);
+	struct net *net = dev_net(skb->dev);
+	struct sock *nsk;
+
+	if (!sysctl_tcp_migrate_req)
+		return NULL;
+
+	nsk = inet6_lookup_listener(net, &tcp_hashinfo, skb, __tcp_hdrlen(th),
+				    &hdr->saddr, th->source,
+				    &hdr->daddr, ntohs(th->dest),
+				    inet6_iif(skb));
+	if (nsk && (nsk == req->rsk_listener || nsk->sk_state != TCP_LISTEN ||
+		    !rcu_access_pointer(nsk->sk_reuseport_cb))) {
+		sock_put(nsk);
+		nsk = NULL;
+	}
+	if (!nsk) {
+		NET_INC_STATS_BH(net, LINUX_MIB_TCPMIGRATEREQFAILURE);
+		return NULL;
+	}
+	NET_INC_STATS_BH(net, LINUX_MIB_TCPMIGRATEREQSUCCESS);
+	return nsk;
+}
+
 static int tcp_v6_rcv(struct sk_buff *skb)
 {
 	const struct tcphdr *th;
@@ -1400,10 +1433,16 @@ process:
 			goto discard_it;
 		}
 		if (unlikely(sk->sk_state != TCP_LISTEN)) {
-			inet_csk_reqsk_queue_drop_and_put(sk, req);
-			goto lookup;
+			nsk = tcp_v6_migrate_req(skb, req);
+			if (!nsk) {
+				inet_csk_reqsk_queue_drop_and_put(sk, req);
+				goto lookup;
+			}
+			/* tcp_v6_migrate_req() took a reference for us */
+			sk = nsk;
+		} else {
+			sock_hold(sk);
 		}
-		sock_hold(sk);
 		nsk = tcp_check_req(sk, skb, req, false);
 		if (!nsk) {
 			reqsk_put(req);
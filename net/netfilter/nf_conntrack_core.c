@@ -409,10 +409,23 @@ static void nf_ct_delete_from_lists(struct nf_conn *ct)
 	local_bh_enable();
 }
 
+void (*nf_flow_table_ct_teardown)(struct nf_conn *ct) __rcu __read_mostly;
+EXPORT_SYMBOL_GPL(nf_flow_table_ct_teardown);
+
 bool nf_ct_delete(struct nf_conn *ct, u32 portid, int report)
 {
 	struct nf_conn_tstamp *tstamp;
 
+	if (unlikely(test_bit(IPS_OFFLOAD_BIT, &ct->status))) {
+		void (*teardown)(struct nf_conn *ct);
+
+		rcu_read_lock();
+		teardown = rcu_dereference(nf_flow_table_ct_teardown);
+		if (teardown)
+			teardown(ct);
+		rcu_read_unlock();
+	}
+
 	tstamp = nf_conn_tstamp_find(ct);
 	if (tstamp && tstamp->stop == 0)
 		tstamp->stop = ktime_get_real_ns();
@@ -0,0 +1,359 @@
+/* Flow offload table: bypass the netfilter hook chains for established
+ * connections.
+ *
+ * Packet handling for a connection makes no new decision once conntrack
+ * has taken it to the established state and the hooks have settled on a
+ * verdict and a NAT binding.  This module keeps a per-namespace
+ * rhashtable keyed on the 5-tuple of each direction of such connections;
+ * an L3 datapath (see net/ipv4/netfilter/nf_flow_table_ipv4.c) consults
+ * it on ingress and short-circuits matching packets straight to the
+ * cached output route, skipping hook traversal and the conntrack lookup.
+ *
+ * Offloaded connections are pinned: the flow entry holds a conntrack
+ * reference and the periodic gc extends the conntrack timer while the
+ * flow is live, since the packets that would normally refresh it no
+ * longer reach nf_conntrack_in().  Teardown from nf_ct_delete() reaches
+ * us through the nf_flow_table_ct_teardown hook so that entries are
+ * invalidated as soon as their conntrack goes away.
+ */
+#include <linux/kernel.h>
+#include <linux/init.h>
+#include <linux/module.h>
+#include <linux/jhash.h>
+#include <linux/netfilter.h>
+#include <linux/rhashtable.h>
+#include <linux/workqueue.h>
+#include <net/netfilter/nf_flow_table.h>
+#include <net/netfilter/nf_conntrack.h>
+#include <net/netfilter/nf_conntrack_core.h>
+
+static DEFINE_SPINLOCK(flowtables_lock);
+static LIST_HEAD(flowtables);
+
+static void flow_offload_fill_dir(struct flow_offload *flow,
+				  struct nf_conn *ct,
+				  struct nf_flow_route *route,
+				  enum flow_offload_tuple_dir dir)
+{
+	struct flow_offload_tuple *ft = &flow->tuplehash[dir].tuple;
+	struct nf_conntrack_tuple *ctt = &ct->tuplehash[dir].tuple;
+
+	ft->src_addr = ctt->src.u3.ip;
+	ft->dst_addr = ctt->dst.u3.ip;
+	ft->src_port = ctt->src.u.tcp.port;
+	ft->dst_port = ctt->dst.u.tcp.port;
+	ft->l4proto = ctt->dst.protonum;
+	ft->dir = dir;
+	ft->mtu = dst_mtu(route->tuple[dir].dst);
+	ft->dst_cache = route->tuple[dir].dst;
+}
+
+/* On success the flow takes over the route references in @route; the
+ * caller keeps them on failure.
+ */
+struct flow_offload *flow_offload_alloc(struct nf_conn *ct,
+					struct nf_flow_route *route)
+{
+	struct flow_offload *flow;
+
+	if (unlikely(nf_ct_is_dying(ct)) ||
+	    !atomic_inc_not_zero(&ct->ct_general.use))
+		return NULL;
+
+	flow = kzalloc(sizeof(*flow), GFP_ATOMIC);
+	if (!flow) {
+		nf_ct_put(ct);
+		return NULL;
+	}
+
+	flow->ct = ct;
+
+	flow_offload_fill_dir(flow, ct, route, FLOW_OFFLOAD_DIR_ORIGINAL);
+	flow_offload_fill_dir(flow, ct, route, FLOW_OFFLOAD_DIR_REPLY);
+
+	if (ct->status & IPS_SRC_NAT)
+		flow->flags |= FLOW_OFFLOAD_SNAT;
+	if (ct->status & IPS_DST_NAT)
+		flow->flags |= FLOW_OFFLOAD_DNAT;
+
+	return flow;
+}
+EXPORT_SYMBOL_GPL(flow_offload_alloc);
+
+void flow_offload_free(struct flow_offload *flow)
+{
+	dst_release(flow->tuplehash[FLOW_OFFLOAD_DIR_ORIGINAL].tuple.dst_cache);
+	dst_release(flow->tuplehash[FLOW_OFFLOAD_DIR_REPLY].tuple.dst_cache);
+	clear_bit(IPS_OFFLOAD_BIT, &flow->ct->status);
+	nf_ct_put(flow->ct);
+	kfree(flow);
+}
+EXPORT_SYMBOL_GPL(flow_offload_free);
+
+static u32 flow_offload_hash(const void *data, u32 len, u32 seed)
+{
+	const struct flow_offload_tuple *tuple = data;
+
+	return jhash(tuple, offsetof(struct flow_offload_tuple, dir), seed);
+}
+
+static u32 flow_offload_hash_obj(const void *data, u32 len, u32 seed)
+{
+	const struct flow_offload_tuple_rhash *tuplehash = data;
+
+	return jhash(&tuplehash->tuple,
+		     offsetof(struct flow_offload_tuple, dir), seed);
+}
+
+static int flow_offload_hash_cmp(struct rhashtable_compare_arg *arg,
+				 const void *ptr)
+{
+	const struct flow_offload_tuple *tuple = arg->key;
+	const struct flow_offload_tuple_rhash *x = ptr;
+
+	if (memcmp(&x->tuple, tuple,
+		   offsetof(struct flow_offload_tuple, dir)))
+		return 1;
+
+	return 0;
+}
+
+static const struct rhashtable_params nf_flow_offload_rhash_params = {
+	.head_offset		= offsetof(struct flow_offload_tuple_rhash, node),
+	.hashfn			= flow_offload_hash,
+	.obj_hashfn		= flow_offload_hash_obj,
+	.obj_cmpfn		= flow_offload_hash_cmp,
+	.automatic_shrinking	= true,
+};
+
+int flow_offload_add(struct nf_flowtable *flow_table,
+		     struct flow_offload *flow)
+{
+	int err;
+
+	flow->timeout = jiffies + NF_FLOW_TIMEOUT;
+
+	err = rhashtable_insert_fast(&flow_table->rhashtable,
+				     &flow->tuplehash[FLOW_OFFLOAD_DIR_ORIGINAL].node,
+				     nf_flow_offload_rhash_params);
+	if (err < 0)
+		return err;
+
+	err = rhashtable_insert_fast(&flow_table->rhashtable,
+				     &flow->tuplehash[FLOW_OFFLOAD_DIR_REPLY].node,
+				     nf_flow_offload_rhash_params);
+	if (err < 0) {
+		rhashtable_remove_fast(&flow_table->rhashtable,
+				       &flow->tuplehash[FLOW_OFFLOAD_DIR_ORIGINAL].node,
+				       nf_flow_offload_rhash_params);
+		return err;
+	}
+
+	return 0;
+}
+EXPORT_SYMBOL_GPL(flow_offload_add);
+
+static void flow_offload_free_rcu(struct rcu_head *head)
+{
+	flow_offload_free(container_of(head, struct flow_offload, rcu_head));
+}
+
+static void flow_offload_del(struct nf_flowtable *flow_table,
+			     struct flow_offload *flow)
+{
+	rhashtable_remove_fast(&flow_table->rhashtable,
+			       &flow->tuplehash[FLOW_OFFLOAD_DIR_ORIGINAL].node,
+			       nf_flow_offload_rhash_params);
+	rhashtable_remove_fast(&flow_table->rhashtable,
+			       &flow->tuplehash[FLOW_OFFLOAD_DIR_REPLY].node,
+			       nf_flow_offload_rhash_params);
+
+	/* The packet path may still hold a reference it found under
+	 * rcu_read_lock.
+	 */
+	call_rcu(&flow->rcu_head, flow_offload_free_rcu);
+}
+
+struct flow_offload_tuple_rhash *
+flow_offload_lookup(struct nf_flowtable *flow_table,
+		    const struct flow_offload_tuple *tuple)
+{
+	return rhashtable_lookup_fast(&flow_table->rhashtable, tuple,
+				      nf_flow_offload_rhash_params);
+}
+EXPORT_SYMBOL_GPL(flow_offload_lookup);
+
+/* Offloaded packets no longer pass nf_conntrack_in(), so nothing
+ * refreshes the conntrack timer; push it out while the flow is live,
+ * never shortening whatever the protocol tracker last set.
+ */
+static void nf_flow_offload_ct_refresh(struct nf_conn *ct)
+{
+	unsigned long newtime = jiffies + 2 * NF_FLOW_TIMEOUT;
+
+	if (timer_pending(&ct->timeout) &&
+	    time_after(newtime, ct->timeout.expires))
+		mod_timer_pending(&ct->timeout, newtime);
+}
+
+static void nf_flow_offload_gc_step(struct nf_flowtable *flow_table)
+{
+	struct flow_offload_tuple_rhash *tuplehash;
+	struct rhashtable_iter hti;
+	struct flow_offload *flow;
+	int err;
+
+	err = rhashtable_walk_init(&flow_table->rhashtable, &hti, GFP_KERNEL);
+	if (err)
+		return;
+
+	err = rhashtable_walk_start(&hti);
+	if (err && err != -EAGAIN)
+		goto out;
+
+	while ((tuplehash = rhashtable_walk_next(&hti))) {
+		if (IS_ERR(tuplehash)) {
+			if (PTR_ERR(tuplehash) == -EAGAIN)
+				continue;
+			break;
+		}
+		if (tuplehash->tuple.dir != FLOW_OFFLOAD_DIR_ORIGINAL)
+			continue;
+
+		flow = container_of(tuplehash, struct flow_offload,
+				    tuplehash[FLOW_OFFLOAD_DIR_ORIGINAL]);
+
+		if (nf_ct_is_dying(flow->ct) ||
+		    (flow->flags & FLOW_OFFLOAD_TEARDOWN) ||
+		    time_after(jiffies, flow->timeout))
+			flow_offload_del(flow_table, flow);
+		else
+			nf_flow_offload_ct_refresh(flow->ct);
+	}
+
+	rhashtable_walk_stop(&hti);
+out:
+	rhashtable_walk_exit(&hti);
+}
+
+static void nf_flow_offload_work_gc(struct work_struct *work)
+{
+	struct nf_flowtable *flow_table;
+
+	flow_table = container_of(work, struct nf_flowtable, gc_work.work);
+	nf_flow_offload_gc_step(flow_table);
+	queue_delayed_work(system_power_efficient_wq, &flow_table->gc_work,
+			   HZ);
+}
+
+/* Called from nf_ct_delete() so that a dying conntrack takes its flow
+ * entries with it; may run in softirq context, hence only marks the
+ * flow for teardown and leaves the freeing to the gc worker.
+ */
+static void nf_flow_table_teardown_ct(struct nf_conn *ct)
+{
+	struct flow_offload_tuple_rhash *tuplehash;
+	const struct nf_conntrack_tuple *ctt;
+	struct flow_offload_tuple tuple = {};
+	struct nf_flowtable *flow_table;
+	struct flow_offload *flow;
+
+	if (nf_ct_l3num(ct) != NFPROTO_IPV4)
+		return;
+
+	ctt = &ct->tuplehash[IP_CT_DIR_ORIGINAL].tuple;
+	tuple.src_addr = ctt->src.u3.ip;
+	tuple.dst_addr = ctt->dst.u3.ip;
+	tuple.src_port = ctt->src.u.tcp.port;
+	tuple.dst_port = ctt->dst.u.tcp.port;
+	tuple.l4proto = ctt->dst.protonum;
+
+	rcu_read_lock();
+	list_for_each_entry_rcu(flow_table, &flowtables, list) {
+		if (!net_eq(flow_table->net, nf_ct_net(ct)))
+			continue;
+
+		tuplehash = flow_offload_lookup(flow_table, &tuple);
+		if (!tuplehash)
+			continue;
+
+		flow = container_of(tuplehash, struct flow_offload,
+				    tuplehash[tuplehash->tuple.dir]);
+		if (flow->ct == ct)
+			flow_offload_teardown(flow);
+	}
+	rcu_read_unlock();
+}
+
+int nf_flow_table_init(struct net *net, struct nf_flowtable *flow_table)
+{
+	int err;
+
+	err = rhashtable_init(&flow_table->rhashtable,
+			      &nf_flow_offload_rhash_params);
+	if (err < 0)
+		return err;
+
+	flow_table->net = net;
+	INIT_DEFERRABLE_WORK(&flow_table->gc_work, nf_flow_offload_work_gc);
+
+	spin_lock(&flowtables_lock);
+	list_add_tail_rcu(&flow_table->list, &flowtables);
+	spin_unlock(&flowtables_lock);
+
+	queue_delayed_work(system_power_efficient_wq, &flow_table->gc_work,
+			   HZ);
+	return 0;
+}
+EXPORT_SYMBOL_GPL(nf_flow_table_init);
+
+static void nf_flow_table_free_entry(void *ptr, void *arg)
+{
+	struct flow_offload_tuple_rhash *tuplehash = ptr;
+	struct flow_offload *flow;
+
+	/* Each flow sits in the table twice, once per direction. */
+	if (tuplehash->tuple.dir != FLOW_OFFLOAD_DIR_ORIGINAL)
+		return;
+
+	flow = container_of(tuplehash, struct flow_offload,
+			    tuplehash[FLOW_OFFLOAD_DIR_ORIGINAL]);
+	flow_offload_free(flow);
+}
+
+/* The caller must have unregistered its datapath hooks (and waited for
+ * packets in flight) before tearing the table down.
+ */
+void nf_flow_table_free(struct nf_flowtable *flow_table)
+{
+	spin_lock(&flowtables_lock);
+	list_del_rcu(&flow_table->list);
+	spin_unlock(&flowtables_lock);
+	synchronize_rcu();
+
+	cancel_delayed_work_sync(&flow_table->gc_work);
+	rhashtable_free_and_destroy(&flow_table->rhashtable,
+				    nf_flow_table_free_entry, NULL);
+}
+EXPORT_SYMBOL_GPL(nf_flow_table_free);
+
+static int __init nf_flow_table_module_init(void)
+{
+	RCU_INIT_POINTER(nf_flow_table_ct_teardown, nf_flow_table_teardown_ct);
+	return 0;
+}
+
+static void __exit nf_flow_table_module_exit(void)
+{
+	RCU_INIT_POINTER(nf_flow_table_ct_teardown, NULL);
+	synchronize_rcu();
+	/* Datapath modules hold a reference on us; by the time we can be
+	 * unloaded every flowtable has been freed.
+	 */
+	WARN_ON(!list_empty(&flowtables));
+}
+
+module_init(nf_flow_table_module_init);
+module_exit(nf_flow_table_module_exit);
+
+MODULE_LICENSE("GPL");
@@ -22,6 +22,11 @@
  *  bunch of packets, and this packet scheduler adds delay between
  *  packets to respect rate limitation.
  *
+ *  Alternatively the sender can stamp each skb with an earliest
+ *  departure time in skb->tstamp; we then simply sort on it and
+ *  release packets when their time has come, instead of deriving
+ *  release times from sk_pacing_rate ourselves.
+ *
  *  enqueue() :
  *   - lookup one RB tree (out of 1024 or more) to find the flow.
  *     If non existent flow, create it, add it to the tree.
@@ -54,6 +59,16 @@
 #include <net/tcp_states.h>
 #include <net/tcp.h>
 
+struct fq_skb_cb {
+	u64	time_to_send;
+};
+
+static inline struct fq_skb_cb *fq_skb_cb(struct sk_buff *skb)
+{
+	qdisc_cb_private_validate(skb, sizeof(struct fq_skb_cb));
+	return (struct fq_skb_cb *)qdisc_skb_cb(skb)->data;
+}
+
 /*
  * Per flow structure, dynamically allocated
  */
@@ -93,7 +108,9 @@ struct fq_sched_data {
 	u32		flow_refill_delay;
 	u32		flow_max_rate;	/* optional max rate per flow */
 	u32		flow_plimit;	/* max packets per flow */
+	u32		low_rate_threshold;
 	u32		orphan_mask;	/* mask for orphaned skb */
+	u64		horizon;	/* max departure time offset (ns) */
 	struct rb_root	*fq_root;
 	u8		rate_enable;
 	u8		fq_trees_log;
@@ -310,60 +327,40 @@ static struct sk_buff *fq_dequeue_head(struct Qdisc *sch, struct fq_flow *flow)
 	return skb;
 }
 
-/* We might add in the future detection of retransmits
- * For the time being, just return false
- */
-static bool skb_is_retransmit(struct sk_buff *skb)
-{
-	return false;
-}
-
 /* add skb to flow queue
- * flow queue is a linked list, kind of FIFO, except for TCP retransmits
- * We special case tcp retransmits to be transmitted before other packets.
- * We rely on fact that TCP retransmits are unlikely, so we do not waste
- * a separate queue or a pointer.
- * head->  [retrans pkt 1]
- *         [retrans pkt 2]
- *         [ normal pkt 1]
- *         [ normal pkt 2]
- *         [ normal pkt 3]
- * tail->  [ normal pkt 4]
+ * flow queue is a linked list, kept sorted by departure time so that
+ * dequeue() only ever has to look at the head.  Senders that do not
+ * stamp departure times get the enqueue time, ie plain FIFO order.
  */
 static void flow_queue_add(struct fq_flow *flow, struct sk_buff *skb)
 {
 	struct sk_buff *prev, *head = flow->head;
 
 	skb->next = NULL;
-	if (!head) {
-		flow->head = skb;
-		flow->tail = skb;
-		return;
-	}
-	if (likely(!skb_is_retransmit(skb))) {
-		flow->tail->next = skb;
+	if (!head ||
+	    fq_skb_cb(skb)->time_to_send >= fq_skb_cb(flow->tail)->time_to_send) {
+		if (!head)
+			flow->head = skb;
+		else
+			flow->tail->next = skb;
 		flow->tail = skb;
 		return;
 	}
 
-	/* This skb is a tcp retransmit,
-	 * find the last retrans packet in the queue
+	/* A departure time before the current tail is rare : the sender
+	 * rewrote its schedule, or stamped a retransmit ahead of queued
+	 * data.  Walk from the head to find the slot.
 	 */
 	prev = NULL;
-	while (skb_is_retransmit(head)) {
+	while (fq_skb_cb(skb)->time_to_send >= fq_skb_cb(head)->time_to_send) {
 		prev = head;
 		head = head->next;
-		if (!head)
-			break;
 	}
-	if (!prev) { /* no rtx packet in queue, become the new head */
+	if (!prev) {
 		skb->next = flow->head;
 		flow->head = skb;
 	} else {
-		if (prev == flow->tail)
-			flow->tail = skb;
-		else
-			skb->next = prev->next;
+		skb->next = prev->next;
 		prev->next = skb;
 	}
 }
@@ -382,9 +379,21 @@ static int fq_enqueue(struct sk_buff *skb, struct Qdisc *sch)
 		return qdisc_drop(skb, sch);
 	}
 
+	/* Earliest departure time model : stamped skbs carry their own
+	 * release time, others are sent in arrival order.  Cap stamps
+	 * beyond the horizon so a confused sender cannot park packets
+	 * here forever.
+	 */
+	if (!skb->tstamp.tv64) {
+		fq_skb_cb(skb)->time_to_send = ktime_get_ns();
+	} else {
+		u64 horizon = ktime_get_ns() + q->horizon;
+
+		fq_skb_cb(skb)->time_to_send =
+			min_t(u64, ktime_to_ns(skb->tstamp), horizon);
+	}
+
 	f->qlen++;
-	if (skb_is_retransmit(skb))
-		q->stat_tcp_retrans++;
 	qdisc_qstats_backlog_inc(sch, skb);
 	if (fq_flow_is_detached(f)) {
 		fq_flow_add_tail(&q->new_flows, f);
@@ -432,7 +441,7 @@ static struct sk_buff *fq_dequeue(struct Qdisc *sch)
 	struct fq_flow_head *head;
 	struct sk_buff *skb;
 	struct fq_flow *f;
-	u32 rate;
+	u32 rate, plen;
 
 	skb = fq_dequeue_head(sch, &q->internal);
 	if (skb)
@@ -460,11 +469,16 @@ begin:
 	}
 
 	skb = f->head;
-	if (unlikely(skb && now < f->time_next_packet &&
-		     !skb_is_tcp_pure_ack(skb))) {
-		head->first = f->next;
-		fq_flow_set_throttled(q, f);
-		goto begin;
+	if (skb && !skb_is_tcp_pure_ack(skb)) {
+		u64 time_next_packet = max_t(u64, fq_skb_cb(skb)->time_to_send,
+					     f->time_next_packet);
+
+		if (now < time_next_packet) {
+			head->first = f->next;
+			f->time_next_packet = time_next_packet;
+			fq_flow_set_throttled(q, f);
+			goto begin;
+		}
 	}
 
 	skb = fq_dequeue_head(sch, f);
@@ -482,7 +496,7 @@ begin:
 	prefetch(&skb->end);
 	f->credit -= qdisc_pkt_len(skb);
 
-	if (f->credit > 0 || !q->rate_enable)
+	if (!q->rate_enable)
 		goto out;
 
 	/* Do not pace locally generated ack packets */
@@ -490,11 +504,26 @@ begin:
 		goto out;
 
 	rate = q->flow_max_rate;
-	if (skb->sk)
+
+	/* An EDT sender spaced its packets itself; only the optional
+	 * qdisc-level max rate still applies on top of its schedule.
+	 */
+	if (skb->tstamp.tv64) {
+		if (rate == ~0U)
+			goto out;
+	} else if (skb->sk) {
 		rate = min(skb->sk->sk_pacing_rate, rate);
+	}
 
+	if (rate <= q->low_rate_threshold) {
+		f->credit = 0;
+		plen = qdisc_pkt_len(skb);
+	} else {
+		plen = max(qdisc_pkt_len(skb), q->quantum);
+		if (f->credit > 0)
+			goto out;
+	}
 	if (rate != ~0U) {
-		u32 plen = max(qdisc_pkt_len(skb), q->quantum);
 		u64 len = (u64)plen * NSEC_PER_SEC;
 
 		if (likely(rate))
@@ -655,6 +684,7 @@ static const struct nla_policy fq_policy[TCA_FQ_MAX + 1] = {
 	[TCA_FQ_FLOW_MAX_RATE]		= { .type = NLA_U32 },
 	[TCA_FQ_BUCKETS_LOG]		= { .type = NLA_U32 },
 	[TCA_FQ_FLOW_REFILL_DELAY]	= { .type = NLA_U32 },
+	[TCA_FQ_LOW_RATE_THRESHOLD]	= { .type = NLA_U32 },
 };
 
 static int fq_change(struct Qdisc *sch, struct nlattr *opt)
@@ -709,6 +739,10 @@ static int fq_change(struct Qdisc *sch, struct nlattr *opt)
 	if (tb[TCA_FQ_FLOW_MAX_RATE])
 		q->flow_max_rate = nla_get_u32(tb[TCA_FQ_FLOW_MAX_RATE]);
 
+	if (tb[TCA_FQ_LOW_RATE_THRESHOLD])
+		q->low_rate_threshold =
+			nla_get_u32(tb[TCA_FQ_LOW_RATE_THRESHOLD]);
+
 	if (tb[TCA_FQ_RATE_ENABLE]) {
 		u32 enable = nla_get_u32(tb[TCA_FQ_RATE_ENABLE]);
 
@@ -768,12 +802,14 @@ static int fq_init(struct Qdisc *sch, struct nlattr *opt)
 	q->flow_refill_delay	= msecs_to_jiffies(40);
 	q->flow_max_rate	= ~0U;
 	q->rate_enable		= 1;
+	q->low_rate_threshold	= 550000 / 8;
 	q->new_flows.first	= NULL;
 	q->old_flows.first	= NULL;
 	q->delayed		= RB_ROOT;
 	q->fq_root		= NULL;
 	q->fq_trees_log		= ilog2(1024);
 	q->orphan_mask		= 1024 - 1;
+	q->horizon		= 10ULL * NSEC_PER_SEC;
 	qdisc_watchdog_init(&q->watchdog, sch);
 
 	if (opt)
@@ -804,6 +840,8 @@ static int fq_dump(struct Qdisc *sch, struct sk_buff *skb)
 	    nla_put_u32(skb, TCA_FQ_FLOW_REFILL_DELAY,
 			jiffies_to_usecs(q->flow_refill_delay)) ||
 	    nla_put_u32(skb, TCA_FQ_ORPHAN_MASK, q->orphan_mask) ||
+	    nla_put_u32(skb, TCA_FQ_LOW_RATE_THRESHOLD,
+			q->low_rate_threshold) ||
 	    nla_put_u32(skb, TCA_FQ_BUCKETS_LOG, q->fq_trees_log))
 		goto nla_put_failure;
 
@@ -1845,6 +1845,49 @@ out:
  */
 #define UNIX_SKB_FRAGS_SZ (PAGE_SIZE << get_order(32768))
 
+/* Small stream sends are first tried against the tailroom of the last
+ * skb in the receiver's queue; slab rounding in __alloc_skb() usually
+ * leaves spare bytes there, so bursts of tiny messages end up in one
+ * skb instead of one skb (alloc, queue work, wakeup) per send.
+ */
+#define UNIX_SKB_COALESCE_MAX	256
+
+static bool unix_stream_coalesce_sendmsg(struct sock *sk, struct sock *other,
+					 const u8 *buf, size_t len,
+					 struct scm_cookie *scm)
+{
+	struct sk_buff *skb;
+	bool done = false;
+
+	/* appending needs the reader side mutex, see unix_stream_sendpage();
+	 * a contended mutex means the reader is active, so just take the
+	 * regular path instead of blocking a small send behind it
+	 */
+	if (!mutex_trylock(&unix_sk(other)->readlock))
+		return false;
+
+	unix_state_lock(other);
+	if (!sock_flag(other, SOCK_DEAD) &&
+	    !(other->sk_shutdown & RCV_SHUTDOWN) &&
+	    !(sk->sk_shutdown & SEND_SHUTDOWN)) {
+		skb = skb_peek_tail(&other->sk_receive_queue);
+		/* skb_tailroom() is 0 for nonlinear skbs, so this never
+		 * touches an skb that carries page frags
+		 */
+		if (skb && !UNIXCB(skb).fp && unix_skb_scm_eq(skb, scm) &&
+		    skb_tailroom(skb) >= len) {
+			memcpy(skb_put(skb, len), buf, len);
+			done = true;
+		}
+	}
+	unix_state_unlock(other);
+	mutex_unlock(&unix_sk(other)->readlock);
+
+	if (done)
+		other->sk_data_ready(other);
+	return done;
+}
+
 static int unix_stream_sendmsg(struct socket *sock, struct msghdr *msg,
 			       size_t len)
 {
@@ -1855,6 +1898,7 @@ static int unix_stream_sendmsg(struct socket *sock, struct msghdr *msg,
 	int sent = 0;
 	struct scm_cookie scm;
 	bool fds_sent = false;
+	bool wake;
 	int max_level;
 	int data_len;
 
@@ -1880,6 +1924,26 @@ static int unix_stream_sendmsg(struct socket *sock, struct msghdr *msg,
 	if (sk->sk_shutdown & SEND_SHUTDOWN)
 		goto pipe_err;
 
+	if (len > 0 && len <= UNIX_SKB_COALESCE_MAX && !scm.fp) {
+		struct iov_iter iter_save = msg->msg_iter;
+		u8 buf[UNIX_SKB_COALESCE_MAX];
+
+		/* bounce the data up front, user memory cannot be touched
+		 * once the queue locks are held
+		 */
+		err = -EFAULT;
+		if (copy_from_iter(buf, len, &msg->msg_iter) != len)
+			goto out_err;
+
+		if (unix_stream_coalesce_sendmsg(sk, other, buf, len, &scm)) {
+			scm_destroy(&scm);
+			return len;
+		}
+
+		/* no tail skb to extend, take the regular path */
+		msg->msg_iter = iter_save;
+	}
+
 	while (sent < len) {
 		size = len - sent;
 
@@ -1924,12 +1988,18 @@ static int unix_stream_sendmsg(struct socket *sock, struct msghdr *msg,
 			goto pipe_err_free;
 
 		maybe_add_creds(skb, sock, other);
+		wake = skb_queue_empty(&other->sk_receive_queue);
 		skb_queue_tail(&other->sk_receive_queue, skb);
 		if (max_level > unix_sk(other)->recursion_level)
 			unix_sk(other)->recursion_level = max_level;
 		unix_state_unlock(other);
-		other->sk_data_ready(other);
 		sent += size;
+		/* Readers block only on an empty queue, so it is enough to
+		 * wake on the empty->nonempty transition plus once when the
+		 * whole send is queued, instead of once per skb.
+		 */
+		if (wake || sent >= len)
+			other->sk_data_ready(other);
 	}
 
 	scm_destroy(&scm);
@@ -212,6 +212,16 @@ static unsigned long hash_key_type_and_desc(const struct keyring_index_key *inde
 	return hash;
 }
 
+/*
+ * Finalise an index key by adding in the hash of the type and description.
+ * This is done once up front so that a search doesn't rehash the description
+ * at every level of the tree and in every object comparison.
+ */
+void key_set_index_key(struct keyring_index_key *index_key)
+{
+	index_key->hash = hash_key_type_and_desc(index_key);
+}
+
 /*
  * Build the next index key chunk.
  *
@@ -237,7 +247,7 @@ static unsigned long keyring_get_key_chunk(const void *data, int level)
 	level /= ASSOC_ARRAY_KEY_CHUNK_SIZE;
 	switch (level) {
 	case 0:
-		return hash_key_type_and_desc(index_key);
+		return index_key->hash;
 	case 1:
 		return ((unsigned long)index_key->type << 8) | desc_len;
 	case 2:
@@ -280,7 +290,8 @@ static bool keyring_compare_object(const void *object, const void *data)
 	const struct keyring_index_key *index_key = data;
 	const struct key *key = keyring_ptr_to_key(object);
 
-	return key->index_key.type == index_key->type &&
+	return key->index_key.hash == index_key->hash &&
+		key->index_key.type == index_key->type &&
 		key->index_key.desc_len == index_key->desc_len &&
 		memcmp(key->index_key.description, index_key->description,
 		       index_key->desc_len) == 0;
@@ -299,8 +310,8 @@ static int keyring_diff_objects(const void *object, const void *data)
 	int level, i;
 
 	level = 0;
-	seg_a = hash_key_type_and_desc(a);
-	seg_b = hash_key_type_and_desc(b);
+	seg_a = a->hash;
+	seg_b = b->hash;
 	if ((seg_a ^ seg_b) != 0)
 		goto differ;
 
@@ -633,8 +644,10 @@ static bool search_nested_keyrings(struct key *keyring,
 	BUG_ON((ctx->flags & STATE_CHECKS) == 0 ||
 	       (ctx->flags & STATE_CHECKS) == STATE_CHECKS);
 
-	if (ctx->index_key.description)
+	if (ctx->index_key.description) {
 		ctx->index_key.desc_len = strlen(ctx->index_key.description);
+		key_set_index_key(&ctx->index_key);
+	}
 
 	/* Check to see if this top-level keyring is what we are looking for
 	 * and whether it is valid or not.
@@ -25,6 +25,7 @@
 #include <linux/mount.h>
 #include <linux/personality.h>
 #include <linux/backing-dev.h>
+#include <linux/jump_label.h>
 #include <net/flow.h>
 
 #define MAX_LSM_EVM_XATTR	2
@@ -77,6 +78,33 @@ static int __init choose_lsm(char *str)
 }
 __setup("security=", choose_lsm);
 
+/*
+ * The hottest hooks are guarded by static keys so that kernels where no
+ * loaded module supplies them (e.g. capabilities only) pay for a single
+ * patched-out branch instead of walking an empty hook list on every
+ * permission check.
+ */
+static DEFINE_STATIC_KEY_FALSE(file_permission_hooks);
+static DEFINE_STATIC_KEY_FALSE(inode_permission_hooks);
+
+static void __init security_enable_hook_key(struct list_head *head)
+{
+	if (head == &security_hook_heads.file_permission)
+		static_branch_enable(&file_permission_hooks);
+	else if (head == &security_hook_heads.inode_permission)
+		static_branch_enable(&inode_permission_hooks);
+}
+
+void __init security_add_hooks(struct security_hook_list *hooks, int count)
+{
+	int i;
+
+	for (i = 0; i < count; i++) {
+		list_add_tail_rcu(&hooks[i].list, hooks[i].head);
+		security_enable_hook_key(hooks[i].head);
+	}
+}
+
 /**
  * security_module_enable - Load given security module on boot ?
  * @module: the name of the module
@@ -594,6 +622,8 @@ int security_inode_follow_link(struct dentry *dentry, struct inode *inode,
 
 int security_inode_permission(struct inode *inode, int mask)
 {
+	if (!static_branch_unlikely(&inode_permission_hooks))
+		return 0;
 	if (unlikely(IS_PRIVATE(inode)))
 		return 0;
 	return call_int_hook(inode_permission, 0, inode, mask);
@@ -730,9 +760,11 @@ int security_file_permission(struct file *file, int mask)
 {
 	int ret;
 
-	ret = call_int_hook(file_permission, 0, file, mask);
-	if (ret)
-		return ret;
+	if (static_branch_unlikely(&file_permission_hooks)) {
+		ret = call_int_hook(file_permission, 0, file, mask);
+		if (ret)
+			return ret;
+	}
 
 	return fsnotify_perm(file, mask);
 }
@@ -17,6 +17,7 @@
 #include <linux/stddef.h>
 #include <linux/kernel.h>
 #include <linux/slab.h>
+#include <linux/mm.h>
 #include <linux/fs.h>
 #include <linux/dcache.h>
 #include <linux/init.h>
@@ -34,10 +35,14 @@
 #include "avc_ss.h"
 #include "classmap.h"
 
-#define AVC_CACHE_SLOTS			512
+#define AVC_CACHE_SLOTS_MIN		512
+#define AVC_CACHE_SLOTS_MAX		16384
 #define AVC_DEF_CACHE_THRESHOLD		512
 #define AVC_CACHE_RECLAIM		16
 
+/* Per-CPU front-level cache, direct mapped; must be a power of two */
+#define AVC_PCPU_CACHE_SIZE		16
+
 #ifdef CONFIG_SECURITY_SELINUX_AVC_STATS
 #define avc_cache_stats_incr(field)	this_cpu_inc(avc_cache_stats.field)
 #else
@@ -69,13 +74,39 @@ struct avc_xperms_node {
 };
 
 struct avc_cache {
-	struct hlist_head	slots[AVC_CACHE_SLOTS]; /* head for avc_node->list */
-	spinlock_t		slots_lock[AVC_CACHE_SLOTS]; /* lock for writes */
+	struct hlist_head	*slots;		/* heads for avc_node->list */
+	spinlock_t		*slots_lock;	/* locks for writes */
+	u32			nslots;		/* power of two, set at init */
 	atomic_t		lru_hint;	/* LRU hint for reclaim scan */
 	atomic_t		active_nodes;
 	u32			latest_notif;	/* latest revocation notification */
 };
 
+/*
+ * Front-level cache of the hottest decisions, one direct-mapped array per
+ * CPU. Entries hold the av_decision by value so lookups touch no shared
+ * cachelines at all; they are validated against avc_cache_gen, which is
+ * bumped whenever cached decisions may change (flush or node update).
+ * Each CPU only writes its own entries, so the only concurrency is with
+ * interrupts on the same CPU; parking gen on 0 around the field updates
+ * keeps an interrupting lookup from matching a half-written entry.
+ */
+struct avc_pcpu_entry {
+	u32			gen;
+	u32			ssid;
+	u32			tsid;
+	u16			tclass;
+	struct av_decision	avd;
+};
+
+struct avc_pcpu_cache {
+	struct avc_pcpu_entry	entries[AVC_PCPU_CACHE_SIZE];
+};
+
+static DEFINE_PER_CPU(struct avc_pcpu_cache, avc_pcpu_cache);
+/* 0 is never a valid generation, so zeroed entries cannot match */
+static atomic_t avc_cache_gen = ATOMIC_INIT(1);
+
 struct avc_callback_node {
 	int (*callback) (u32 event);
 	u32 events;
@@ -98,7 +129,81 @@ static struct kmem_cache *avc_xperms_cachep;
 
 static inline int avc_hash(u32 ssid, u32 tsid, u16 tclass)
 {
-	return (ssid ^ (tsid<<2) ^ (tclass<<4)) & (AVC_CACHE_SLOTS - 1);
+	return (ssid ^ (tsid<<2) ^ (tclass<<4)) & (avc_cache.nslots - 1);
+}
+
+static inline int avc_pcpu_hash(u32 ssid, u32 tsid, u16 tclass)
+{
+	return (ssid ^ (tsid<<2) ^ (tclass<<4)) & (AVC_PCPU_CACHE_SIZE - 1);
+}
+
+static void avc_invalidate_pcpu_caches(void)
+{
+	/*
+	 * Order the bump after the shared-cache modification it covers;
+	 * pairs with the smp_rmb() in avc_has_perm_noaudit() so a lookup
+	 * that sampled the new generation also sees the new decision.
+	 */
+	smp_mb__before_atomic();
+	atomic_inc(&avc_cache_gen);
+}
+
+static bool avc_pcpu_lookup(u32 ssid, u32 tsid, u16 tclass,
+			    struct av_decision *avd)
+{
+	struct avc_pcpu_cache *cache;
+	struct avc_pcpu_entry *e;
+	u32 gen = (u32)atomic_read(&avc_cache_gen);
+	bool hit = false;
+
+	cache = get_cpu_ptr(&avc_pcpu_cache);
+	e = &cache->entries[avc_pcpu_hash(ssid, tsid, tclass)];
+
+	if (READ_ONCE(e->gen) != gen ||
+	    e->ssid != ssid || e->tsid != tsid || e->tclass != tclass)
+		goto out;
+
+	memcpy(avd, &e->avd, sizeof(*avd));
+
+	/*
+	 * An interrupt may have rewritten the entry while we copied. If
+	 * the generation and keys still match, any interleaved promotion
+	 * was for the same triple under the same generation and thus
+	 * carried an identical decision; otherwise discard the copy.
+	 */
+	barrier();
+	if (READ_ONCE(e->gen) == gen &&
+	    e->ssid == ssid && e->tsid == tsid && e->tclass == tclass)
+		hit = true;
+out:
+	put_cpu_ptr(&avc_pcpu_cache);
+	return hit;
+}
+
+/*
+ * @gen must have been sampled (with a read barrier) before the decision
+ * was copied out of the shared cache: if the shared node was replaced in
+ * the meantime, the generation bump that covered the replacement makes
+ * this entry invalid on arrival instead of caching the stale decision.
+ */
+static void avc_pcpu_promote(u32 ssid, u32 tsid, u16 tclass,
+			     struct av_decision *avd, u32 gen)
+{
+	struct avc_pcpu_cache *cache;
+	struct avc_pcpu_entry *e;
+
+	cache = get_cpu_ptr(&avc_pcpu_cache);
+	e = &cache->entries[avc_pcpu_hash(ssid, tsid, tclass)];
+
+	WRITE_ONCE(e->gen, 0);
+	barrier();
+	e->ssid = ssid;
+	e->tsid = tsid;
+	e->tclass = tclass;
+	memcpy(&e->avd, avd, sizeof(e->avd));
+	barrier();
+	WRITE_ONCE(e->gen, gen);
+	put_cpu_ptr(&avc_pcpu_cache);
 }
 
 /**
@@ -176,9 +281,30 @@ static void avc_dump_query(struct audit_buffer *ab, u32 ssid, u32 tsid, u16 tcla
  */
 void __init avc_init(void)
 {
+	u32 nslots;
 	int i;
 
-	for (i = 0; i < AVC_CACHE_SLOTS; i++) {
+	/*
+	 * Scale the hash table with system memory - roughly one slot per
+	 * 4MB of RAM - so machines running many distinct contexts don't
+	 * thrash a fixed-size cache. The reclaim threshold follows the
+	 * table size; it remains tunable through selinuxfs.
+	 */
+	nslots = clamp_t(u32, roundup_pow_of_two(totalram_pages >>
+						 (22 - PAGE_SHIFT)),
+			 AVC_CACHE_SLOTS_MIN, AVC_CACHE_SLOTS_MAX);
+
+	avc_cache.slots = kmalloc_array(nslots, sizeof(*avc_cache.slots),
+					GFP_KERNEL);
+	avc_cache.slots_lock = kmalloc_array(nslots,
+					sizeof(*avc_cache.slots_lock),
+					GFP_KERNEL);
+	if (!avc_cache.slots || !avc_cache.slots_lock)
+		panic("SELinux: unable to allocate AVC hash table\n");
+	avc_cache.nslots = nslots;
+	avc_cache_threshold = nslots;
+
+	for (i = 0; i < avc_cache.nslots; i++) {
 		INIT_HLIST_HEAD(&avc_cache.slots[i]);
 		spin_lock_init(&avc_cache.slots_lock[i]);
 	}
@@ -211,7 +337,7 @@ int avc_get_hash_stats(char *page)
 
 	slots_used = 0;
 	max_chain_len = 0;
-	for (i = 0; i < AVC_CACHE_SLOTS; i++) {
+	for (i = 0; i < avc_cache.nslots; i++) {
 		head = &avc_cache.slots[i];
 		if (!hlist_empty(head)) {
 			slots_used++;
@@ -228,7 +354,7 @@ int avc_get_hash_stats(char *page)
 	return scnprintf(page, PAGE_SIZE, "entries: %d\nbuckets used: %d/%d\n"
 			 "longest chain: %d\n",
 			 atomic_read(&avc_cache.active_nodes),
-			 slots_used, AVC_CACHE_SLOTS, max_chain_len);
+			 slots_used, avc_cache.nslots, max_chain_len);
 }
 
 /*
@@ -520,8 +646,8 @@ static inline int avc_reclaim_node(void)
 	struct hlist_head *head;
 	spinlock_t *lock;
 
-	for (try = 0, ecx = 0; try < AVC_CACHE_SLOTS; try++) {
-		hvalue = atomic_inc_return(&avc_cache.lru_hint) & (AVC_CACHE_SLOTS - 1);
+	for (try = 0, ecx = 0; try < avc_cache.nslots; try++) {
+		hvalue = atomic_inc_return(&avc_cache.lru_hint) & (avc_cache.nslots - 1);
 		head = &avc_cache.slots[hvalue];
 		lock = &avc_cache.slots_lock[hvalue];
 
@@ -899,6 +1025,8 @@ static int avc_update_node(u32 event, u32 perms, u8 driver, u8 xperm, u32 ssid,
 		break;
 	}
 	avc_node_replace(node, orig);
+	/* per-CPU copies of the old decision are now stale */
+	avc_invalidate_pcpu_caches();
 out_unlock:
 	spin_unlock_irqrestore(lock, flag);
 out:
@@ -916,7 +1044,7 @@ static void avc_flush(void)
 	unsigned long flag;
 	int i;
 
-	for (i = 0; i < AVC_CACHE_SLOTS; i++) {
+	for (i = 0; i < avc_cache.nslots; i++) {
 		head = &avc_cache.slots[i];
 		lock = &avc_cache.slots_lock[i];
 
@@ -931,6 +1059,8 @@ static void avc_flush(void)
 		rcu_read_unlock();
 		spin_unlock_irqrestore(lock, flag);
 	}
+
+	avc_invalidate_pcpu_caches();
 }
 
 /**
@@ -1104,17 +1234,31 @@ inline int avc_has_perm_noaudit(u32 ssid, u32 tsid,
 	struct avc_xperms_node xp_node;
 	int rc = 0;
 	u32 denied;
+	u32 gen;
 
 	BUG_ON(!requested);
 
 	rcu_read_lock();
 
+	if (avc_pcpu_lookup(ssid, tsid, tclass, avd)) {
+		avc_cache_stats_incr(lookups);
+		goto decision;
+	}
+
+	gen = (u32)atomic_read(&avc_cache_gen);
+	/* pairs with the bump ordering in avc_invalidate_pcpu_caches() */
+	smp_rmb();
+
 	node = avc_lookup(ssid, tsid, tclass);
-	if (unlikely(!node))
+	if (unlikely(!node)) {
 		node = avc_compute_av(ssid, tsid, tclass, avd, &xp_node);
-	else
+	} else {
 		memcpy(avd, &node->ae.avd, sizeof(*avd));
+		/* promote shared-cache hits into this CPU's front cache */
+		avc_pcpu_promote(ssid, tsid, tclass, avd, gen);
+	}
 
+decision:
 	denied = requested & ~(avd->allowed);
 	if (unlikely(denied))
 		rc = avc_denied(ssid, tsid, tclass, requested, 0, 0, flags, avd);
@@ -0,0 +1,290 @@
+/*
+ * mm-fault: Stress the page-fault paths.
+ *
+ * Each worker thread repeatedly maps a region, touches every page and
+ * unmaps it again, so the kernel keeps taking fresh faults for the whole
+ * run.  Anonymous and file-backed mappings, shared and private, can be
+ * combined to exercise the different fault paths; file-backed read
+ * faults against an already cached file are what the fault-around code
+ * sees.  With --thp the region is madvised MADV_HUGEPAGE, first touches
+ * happen in huge-page strides and their latency distribution is
+ * reported instead of raw throughput.
+ */
+
+#include "../perf.h"
+#include "../util/util.h"
+#include "../util/stat.h"
+#include <subcmd/parse-options.h>
+#include "../util/header.h"
+#include "bench.h"
+
+#include <err.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <sys/mman.h>
+#include <pthread.h>
+
+#ifndef HPAGE_SIZE
+#define HPAGE_SIZE	(2UL * 1024 * 1024)
+#endif
+
+static unsigned int nthreads = 0;
+static unsigned int nsecs    = 10;
+/* mapped region per thread, in MB */
+static unsigned int region_mb = 64;
+static bool use_file = false, use_shared = false, use_thp = false;
+static bool done = false, silent = false;
+
+static unsigned int page_size;
+
+struct timeval start, end, runtime;
+static pthread_mutex_t thread_lock;
+static unsigned int threads_starting;
+static struct stats throughput_stats;
+static struct stats latency_stats;
+static pthread_cond_t thread_parent, thread_worker;
+
+struct worker {
+	int tid;
+	int fd;
+	pthread_t thread;
+	unsigned long ops;
+	struct stats lat;
+};
+
+static const struct option options[] = {
+	OPT_UINTEGER('t', "threads", &nthreads,  "Specify amount of threads"),
+	OPT_UINTEGER('r', "runtime", &nsecs,     "Specify runtime (in seconds)"),
+	OPT_UINTEGER('m', "size",    &region_mb, "Size of the per-thread region (in MB)"),
+	OPT_BOOLEAN( 'f', "file",    &use_file,  "Fault on a file-backed mapping instead of anonymous memory"),
+	OPT_BOOLEAN( 'S', "shared",  &use_shared, "Use MAP_SHARED instead of MAP_PRIVATE"),
+	OPT_BOOLEAN( 'T', "thp",     &use_thp,   "Madvise huge pages and report fault latencies"),
+	OPT_BOOLEAN( 's', "silent",  &silent,    "Silent mode: do not display data/details"),
+	OPT_END()
+};
+
+static const char * const bench_mm_fault_usage[] = {
+	"perf bench mm fault <options>",
+	NULL
+};
+
+static u64 getns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (u64)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void *workerfn(void *arg)
+{
+	struct worker *w = (struct worker *) arg;
+	size_t size = (size_t)region_mb * 1024 * 1024;
+	int prot = PROT_READ | PROT_WRITE;
+	int flags = use_shared ? MAP_SHARED : MAP_PRIVATE;
+	size_t stride = use_thp ? HPAGE_SIZE : page_size;
+	unsigned long sum = 0;
+
+	if (!use_file)
+		flags |= MAP_ANONYMOUS;
+
+	pthread_mutex_lock(&thread_lock);
+	threads_starting--;
+	if (!threads_starting)
+		pthread_cond_signal(&thread_parent);
+	pthread_cond_wait(&thread_worker, &thread_lock);
+	pthread_mutex_unlock(&thread_lock);
+
+	do {
+		unsigned char *map;
+		size_t off;
+
+		map = mmap(NULL, size, prot, flags, w->fd, 0);
+		if (map == MAP_FAILED)
+			err(EXIT_FAILURE, "mmap");
+		if (use_thp && madvise(map, size, MADV_HUGEPAGE))
+			err(EXIT_FAILURE, "madvise(MADV_HUGEPAGE)");
+
+		for (off = 0; off < size && !done; off += stride) {
+			if (use_thp) {
+				u64 t0 = getns();
+
+				map[off] = 1;
+				update_stats(&w->lat, getns() - t0);
+			} else if (use_file) {
+				/* read fault: exercises the cached path */
+				sum += map[off];
+			} else {
+				/* write fault: actually allocates */
+				map[off] = 1;
+			}
+			w->ops++;
+		}
+
+		if (munmap(map, size))
+			err(EXIT_FAILURE, "munmap");
+	} while (!done);
+
+	/* defeat optimization of the read loop */
+	if (sum == (unsigned long)-1)
+		warnx("unlikely checksum");
+
+	return NULL;
+}
+
+static void toggle_done(int sig __maybe_unused,
+			siginfo_t *info __maybe_unused,
+			void *uc __maybe_unused)
+{
+	/* inform all threads that we're done for the day */
+	done = true;
+	gettimeofday(&end, NULL);
+	timersub(&end, &start, &runtime);
+}
+
+static void print_summary(void)
+{
+	unsigned long avg = avg_stats(&throughput_stats);
+	double stddev = stddev_stats(&throughput_stats);
+
+	if (use_thp) {
+		unsigned long lat = avg_stats(&latency_stats);
+		double lat_stddev = stddev_stats(&latency_stats);
+
+		printf("%sAveraged %lu ns/huge-fault (+- %.2f%%), %ld faults/sec, total secs = %d\n",
+		       !silent ? "\n" : "", lat,
+		       rel_stddev_stats(lat_stddev, lat), avg,
+		       (int) runtime.tv_sec);
+		return;
+	}
+
+	printf("%sAveraged %ld faults/sec (+- %.2f%%), total secs = %d\n",
+	       !silent ? "\n" : "", avg, rel_stddev_stats(stddev, avg),
+	       (int) runtime.tv_sec);
+}
+
+static int worker_file(unsigned int tid)
+{
+	char path[] = "/tmp/perf-bench-mm-fault-XXXXXX";
+	int fd;
+
+	fd = mkstemp(path);
+	if (fd < 0)
+		err(EXIT_FAILURE, "mkstemp (thread %u)", tid);
+	unlink(path);
+	if (ftruncate(fd, (off_t)region_mb * 1024 * 1024))
+		err(EXIT_FAILURE, "ftruncate");
+	return fd;
+}
+
+int bench_mm_fault(int argc, const char **argv,
+		   const char *prefix __maybe_unused)
+{
+	int ret = 0;
+	cpu_set_t cpu;
+	struct sigaction act;
+	unsigned int i, ncpus;
+	pthread_attr_t thread_attr;
+	struct worker *worker = NULL;
+
+	argc = parse_options(argc, argv, options, bench_mm_fault_usage, 0);
+	if (argc) {
+		usage_with_options(bench_mm_fault_usage, options);
+		exit(EXIT_FAILURE);
+	}
+
+	ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+	page_size = sysconf(_SC_PAGE_SIZE);
+
+	sigfillset(&act.sa_mask);
+	act.sa_sigaction = toggle_done;
+	sigaction(SIGINT, &act, NULL);
+
+	if (!nthreads) /* default to the number of CPUs */
+		nthreads = ncpus;
+
+	worker = calloc(nthreads, sizeof(*worker));
+	if (!worker)
+		err(EXIT_FAILURE, "calloc");
+
+	printf("Run summary [PID %d]: %d threads faulting %u MB of %s [%s] memory each for %d secs.\n\n",
+	       getpid(), nthreads, region_mb,
+	       use_file ? "file-backed" : "anonymous",
+	       use_shared ? "shared" : "private", nsecs);
+
+	init_stats(&throughput_stats);
+	init_stats(&latency_stats);
+	pthread_mutex_init(&thread_lock, NULL);
+	pthread_cond_init(&thread_parent, NULL);
+	pthread_cond_init(&thread_worker, NULL);
+
+	threads_starting = nthreads;
+	pthread_attr_init(&thread_attr);
+	gettimeofday(&start, NULL);
+	for (i = 0; i < nthreads; i++) {
+		worker[i].tid = i;
+		worker[i].fd = use_file ? worker_file(i) : -1;
+		init_stats(&worker[i].lat);
+
+		CPU_ZERO(&cpu);
+		CPU_SET(i % ncpus, &cpu);
+
+		ret = pthread_attr_setaffinity_np(&thread_attr, sizeof(cpu_set_t), &cpu);
+		if (ret)
+			err(EXIT_FAILURE, "pthread_attr_setaffinity_np");
+
+		ret = pthread_create(&worker[i].thread, &thread_attr, workerfn,
+				     (void *)(struct worker *) &worker[i]);
+		if (ret)
+			err(EXIT_FAILURE, "pthread_create");
+	}
+	pthread_attr_destroy(&thread_attr);
+
+	pthread_mutex_lock(&thread_lock);
+	while (threads_starting)
+		pthread_cond_wait(&thread_parent, &thread_lock);
+	pthread_cond_broadcast(&thread_worker);
+	pthread_mutex_unlock(&thread_lock);
+
+	sleep(nsecs);
+	toggle_done(0, NULL, NULL);
+
+	for (i = 0; i < nthreads; i++) {
+		ret = pthread_join(worker[i].thread, NULL);
+		if (ret)
+			err(EXIT_FAILURE, "pthread_join");
+	}
+
+	/* cleanup & report results */
+	pthread_cond_destroy(&thread_parent);
+	pthread_cond_destroy(&thread_worker);
+	pthread_mutex_destroy(&thread_lock);
+
+	for (i = 0; i < nthreads; i++) {
+		unsigned long t = worker[i].ops/runtime.tv_sec;
+
+		update_stats(&throughput_stats, t);
+		if (use_thp)
+			update_stats(&latency_stats,
+				     (u64) avg_stats(&worker[i].lat));
+		if (!silent) {
+			if (use_thp)
+				printf("[thread %2d] %ld faults/sec, %lu ns/huge-fault\n",
+				       worker[i].tid, t,
+				       (unsigned long) avg_stats(&worker[i].lat));
+			else
+				printf("[thread %2d] %ld faults/sec\n",
+				       worker[i].tid, t);
+		}
+		if (worker[i].fd >= 0)
+			close(worker[i].fd);
+	}
+
+	print_summary();
+
+	free(worker);
+	return ret;
+}
@@ -13,6 +13,7 @@
  *  mem   ... memory access performance
  *  numa  ... NUMA scheduling and MM performance
  *  futex ... Futex performance
+ *  mm    ... Page fault and mmap scalability
  */
 #include "perf.h"
 #include "util/util.h"
@@ -66,6 +67,13 @@ static struct bench futex_benchmarks[] = {
 	{ NULL,		NULL,						NULL			}
 };
 
+static struct bench mm_benchmarks[] = {
+	{ "fault",	"Benchmark for multi-threaded page-fault throughput",	bench_mm_fault	},
+	{ "mmap",	"Benchmark for mmap/munmap churn",			bench_mm_mmap	},
+	{ "all",	"Run all mm benchmarks",				NULL		},
+	{ NULL,		NULL,							NULL		}
+};
+
 struct collection {
 	const char	*name;
 	const char	*summary;
@@ -79,6 +87,7 @@ static struct collection collections[] = {
 	{ "numa",	"NUMA scheduling and MM benchmarks",		numa_benchmarks		},
 #endif
 	{"futex",       "Futex stressing benchmarks",                   futex_benchmarks        },
+	{ "mm",		"Page fault and mmap scalability benchmarks",	mm_benchmarks		},
 	{ "all",	"All benchmarks",				NULL			},
 	{ NULL,		NULL,						NULL			}
 };
@@ -0,0 +1,384 @@
+/* Measure scheduler wakeup-to-run latency
+ *		Licensed under the GPLv2
+ *
+ * Exercises the three wakeup shapes that scheduler placement changes
+ * keep regressing on:
+ *
+ *   pipe-chain: a chain of threads connected by pipes, each wakeup
+ *               hands a timestamp to the next thread (wake-chains),
+ *   futex:      a futex handoff between a waker and a waiter,
+ *   timer:      absolute clock_nanosleep() expiry.
+ *
+ * Every configuration runs idle and with one spinner per CPU, both
+ * pinned (waker and waiter share CPU 0) and unpinned, and reports one
+ * machine-readable line per run:
+ *
+ *   wakeup-lat: test=pipe-chain load=4 pinned=0 samples=4000 \
+ *       min_ns=... avg_ns=... p99_ns=... max_ns=...
+ *
+ * A run fails when its 99th percentile exceeds the latency budget
+ * (default 40ms, like the timers tests' unreasonable-latency bound;
+ * override with -b <ns> when tightening CI on known-quiet machines).
+ *
+ *  To build:
+ *	$ gcc wakeup-lat.c -o wakeup-lat -lrt -lpthread
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include <sched.h>
+#include <pthread.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#ifdef KTEST
+#include "../kselftest.h"
+#else
+static inline int ksft_exit_pass(void)
+{
+	exit(0);
+}
+static inline int ksft_exit_fail(void)
+{
+	exit(1);
+}
+#endif
+
+#define NSEC_PER_SEC	1000000000ULL
+
+#define CHAIN_LEN	4
+#define ITERATIONS	1000
+#define TIMER_SLEEP_NS	1000000		/* 1ms */
+#define DEFAULT_BUDGET	40000000ULL	/* 40ms on the 99th percentile */
+
+static unsigned long long budget_ns = DEFAULT_BUDGET;
+static int iterations = ITERATIONS;
+static int ncpus;
+
+static volatile int load_running;
+
+static unsigned long long getns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (unsigned long long)ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+static int futex(volatile int *uaddr, int op, int val,
+		 const struct timespec *timeout)
+{
+	return syscall(SYS_futex, uaddr, op, val, timeout, NULL, 0);
+}
+
+static void pin_self(int cpu)
+{
+	cpu_set_t set;
+
+	CPU_ZERO(&set);
+	CPU_SET(cpu, &set);
+	sched_setaffinity(0, sizeof(set), &set);
+}
+
+static int cmp_ull(const void *a, const void *b)
+{
+	unsigned long long x = *(const unsigned long long *)a;
+	unsigned long long y = *(const unsigned long long *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+/* sorts the samples; returns 0 when within budget */
+static int report(const char *test, int load, int pinned,
+		  unsigned long long *samples, int nr)
+{
+	unsigned long long sum = 0, p99;
+	int i;
+
+	qsort(samples, nr, sizeof(*samples), cmp_ull);
+	for (i = 0; i < nr; i++)
+		sum += samples[i];
+	p99 = samples[(nr * 99) / 100];
+
+	printf("wakeup-lat: test=%s load=%d pinned=%d samples=%d min_ns=%llu avg_ns=%llu p99_ns=%llu max_ns=%llu\n",
+	       test, load, pinned, nr, samples[0], sum / nr, p99,
+	       samples[nr - 1]);
+
+	return p99 > budget_ns;
+}
+
+/* background load: plain spinners, placed by the scheduler */
+static void *load_fn(void *arg)
+{
+	while (load_running)
+		;
+	return NULL;
+}
+
+struct chain_stage {
+	pthread_t thread;
+	int rfd;		/* timestamped token arrives here */
+	int wfd;		/* and is passed on here */
+	int pinned;
+	unsigned long long *samples;	/* one per iteration */
+};
+
+static void *chain_fn(void *arg)
+{
+	struct chain_stage *stage = arg;
+	unsigned long long ts;
+	int i;
+
+	if (stage->pinned)
+		pin_self(0);
+
+	for (i = 0; i < iterations; i++) {
+		if (read(stage->rfd, &ts, sizeof(ts)) != sizeof(ts))
+			return (void *)-1L;
+		stage->samples[i] = getns() - ts;
+		ts = getns();
+		if (write(stage->wfd, &ts, sizeof(ts)) != sizeof(ts))
+			return (void *)-1L;
+	}
+	return NULL;
+}
+
+static int pipe_chain_test(int load, int pinned)
+{
+	struct chain_stage stages[CHAIN_LEN];
+	int pipes[CHAIN_LEN + 1][2];
+	unsigned long long *samples, ts;
+	int i, j, nr = 0, ret;
+
+	samples = calloc(CHAIN_LEN * iterations, sizeof(*samples));
+	if (!samples)
+		return -1;
+
+	for (i = 0; i < CHAIN_LEN + 1; i++)
+		if (pipe(pipes[i]))
+			return -1;
+
+	for (i = 0; i < CHAIN_LEN; i++) {
+		stages[i].rfd = pipes[i][0];
+		stages[i].wfd = pipes[i + 1][1];
+		stages[i].pinned = pinned;
+		stages[i].samples = calloc(iterations, sizeof(*samples));
+		if (!stages[i].samples)
+			return -1;
+		if (pthread_create(&stages[i].thread, NULL, chain_fn,
+				   &stages[i]))
+			return -1;
+	}
+
+	if (pinned)
+		pin_self(0);
+
+	for (i = 0; i < iterations; i++) {
+		ts = getns();
+		if (write(pipes[0][1], &ts, sizeof(ts)) != sizeof(ts))
+			return -1;
+		/* wait for the token to clear the chain */
+		if (read(pipes[CHAIN_LEN][0], &ts, sizeof(ts)) != sizeof(ts))
+			return -1;
+	}
+
+	for (i = 0; i < CHAIN_LEN; i++) {
+		void *res;
+
+		pthread_join(stages[i].thread, &res);
+		if (res)
+			return -1;
+		for (j = 0; j < iterations; j++)
+			samples[nr++] = stages[i].samples[j];
+		free(stages[i].samples);
+	}
+	for (i = 0; i < CHAIN_LEN + 1; i++) {
+		close(pipes[i][0]);
+		close(pipes[i][1]);
+	}
+
+	ret = report("pipe-chain", load, pinned, samples, nr);
+	free(samples);
+	return ret;
+}
+
+struct futex_pair {
+	volatile int token;	/* waiter blocks while this is 0 */
+	volatile int ack;	/* waker blocks while this is 0 */
+	volatile unsigned long long ts;
+	int pinned;
+	unsigned long long *samples;
+};
+
+static void *futex_waiter_fn(void *arg)
+{
+	struct futex_pair *pair = arg;
+	int i;
+
+	if (pair->pinned)
+		pin_self(0);
+
+	for (i = 0; i < iterations; i++) {
+		while (futex(&pair->token, FUTEX_WAIT_PRIVATE, 0, NULL) &&
+		       errno == EINTR)
+			;
+		pair->samples[i] = getns() - pair->ts;
+		pair->token = 0;
+		pair->ack = 1;
+		futex(&pair->ack, FUTEX_WAKE_PRIVATE, 1, NULL);
+	}
+	return NULL;
+}
+
+static int futex_test(int load, int pinned)
+{
+	struct futex_pair pair;
+	pthread_t waiter;
+	int i, ret;
+
+	memset(&pair, 0, sizeof(pair));
+	pair.pinned = pinned;
+	pair.samples = calloc(iterations, sizeof(*pair.samples));
+	if (!pair.samples)
+		return -1;
+
+	if (pthread_create(&waiter, NULL, futex_waiter_fn, &pair))
+		return -1;
+
+	if (pinned)
+		pin_self(0);
+
+	for (i = 0; i < iterations; i++) {
+		pair.ts = getns();
+		pair.token = 1;
+		futex(&pair.token, FUTEX_WAKE_PRIVATE, 1, NULL);
+		while (futex(&pair.ack, FUTEX_WAIT_PRIVATE, 0, NULL) &&
+		       errno == EINTR)
+			;
+		pair.ack = 0;
+	}
+	pthread_join(waiter, NULL);
+
+	ret = report("futex", load, pinned, pair.samples, iterations);
+	free(pair.samples);
+	return ret;
+}
+
+static int timer_test(int load, int pinned)
+{
+	unsigned long long *samples;
+	struct timespec target;
+	unsigned long long now;
+	int i, ret;
+
+	samples = calloc(iterations, sizeof(*samples));
+	if (!samples)
+		return -1;
+
+	if (pinned)
+		pin_self(0);
+
+	for (i = 0; i < iterations; i++) {
+		now = getns() + TIMER_SLEEP_NS;
+		target.tv_sec = now / NSEC_PER_SEC;
+		target.tv_nsec = now % NSEC_PER_SEC;
+		while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME,
+				       &target, NULL) == EINTR)
+			;
+		samples[i] = getns() - now;
+	}
+
+	ret = report("timer", load, pinned, samples, iterations);
+	free(samples);
+	return ret;
+}
+
+static int run_config(int load, int pinned)
+{
+	pthread_t *spinners = NULL;
+	cpu_set_t all;
+	int i, failed = 0;
+
+	if (load) {
+		spinners = calloc(load, sizeof(*spinners));
+		if (!spinners)
+			return -1;
+		load_running = 1;
+		for (i = 0; i < load; i++)
+			if (pthread_create(&spinners[i], NULL, load_fn, NULL))
+				return -1;
+	}
+
+	failed |= pipe_chain_test(load, pinned);
+	failed |= futex_test(load, pinned);
+	failed |= timer_test(load, pinned);
+
+	if (load) {
+		load_running = 0;
+		for (i = 0; i < load; i++)
+			pthread_join(spinners[i], NULL);
+		free(spinners);
+	}
+
+	/* undo the pinning for the next configuration */
+	CPU_ZERO(&all);
+	for (i = 0; i < ncpus; i++)
+		CPU_SET(i, &all);
+	sched_setaffinity(0, sizeof(all), &all);
+
+	return failed;
+}
+
+int main(int argc, char **argv)
+{
+	int opt, pinned, failed = 0;
+	int loads[2];
+
+	while ((opt = getopt(argc, argv, "b:i:h")) != -1) {
+		switch (opt) {
+		case 'b':
+			budget_ns = strtoull(optarg, NULL, 0);
+			break;
+		case 'i':
+			iterations = atoi(optarg);
+			break;
+		default:
+			printf("Usage: %s [-b budget_ns] [-i iterations]\n",
+			       argv[0]);
+			return ksft_exit_fail();
+		}
+	}
+
+	ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+	loads[0] = 0;
+	loads[1] = ncpus;
+
+	printf("Scheduler wakeup latency (budget: p99 < %llu ns)\n",
+	       budget_ns);
+
+	for (opt = 0; opt < 2; opt++)
+		for (pinned = 0; pinned < 2; pinned++)
+			if (run_config(loads[opt], pinned))
+				failed = 1;
+
+	if (failed) {
+		printf("[FAILED]\n");
+		return ksft_exit_fail();
+	}
+	printf("[OK]\n");
+	return ksft_exit_pass();
+}